@@ -21,10 +21,16 @@ namespace clio
 		Option<std::pair<uint64_t, uint64_t>> trimRangeNs{ this, "--trim-range-ns", {}, "Range of nanosecond times outside of which to trim", RemoveCommas };
 		Option<std::pair<double, double>> trimRangeMs{ this, "--trim-range-ms", {}, "Range of millisecond times outside of which to trim" };
 
+	private: Group gi_{ this, "Index", "Options for the sidecar index that speeds up repeated trims of the same input" }; public:
+		Flag writeIndex{ this, "--write-index", "Write a sidecar index of buffer offsets, per-provider event counts, and state events while processing the input" };
+		Flag useIndex{ this, "--use-index", "Use the sidecar index to read only the buffers that can contain events in the trim range" };
+		Option<std::string> indexFile{ this, "--index-file", "", "Path of the sidecar index file (defaults to the input file path with .pmidx appended)" };
+
 		static constexpr const char* description = "Postprocessing tool for trimming and pruning ETL files";
 		static constexpr const char* name = "ETLTrimmer.exe";
 	private:
 		Dependency eventDep_{ event, provider };
 		MutualExclusion trimRangeExcl_{ trimRangeQpc, trimRangeNs, trimRangeMs };
+		MutualExclusion indexExcl_{ writeIndex, useIndex };
 	};
 }
\ No newline at end of file
@@ -0,0 +1,397 @@
+#include "EtlIndex.h"
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <unordered_set>
+
+namespace
+{
+    constexpr char Magic[8] = { 'P', 'M', 'E', 'T', 'L', 'I', 'D', 'X' };
+    constexpr uint32_t Version = 1;
+
+    struct IndexFileHeader
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t reserved;
+        uint64_t etlSize;
+        uint64_t etlWriteTime;
+        uint64_t eventCount;
+        uint64_t firstTimestamp;
+        uint64_t lastTimestamp;
+        uint64_t bufferCount;
+        uint64_t providerCount;
+        uint64_t stateEventCount;
+    };
+    struct StateEventHeader
+    {
+        EVENT_HEADER header;
+        uint32_t payloadSize;
+        uint16_t processorIndex;
+        uint16_t reserved;
+    };
+
+    // layout of the raw ETL file (WMI_BUFFER_HEADER and the trace headers that prefix each event);
+    // these are not in the public SDK headers so only the fields we need are decoded here
+    constexpr uint32_t BufferHeaderSize = 72;
+    constexpr uint32_t MaxBufferSize = 64 * 1024 * 1024;
+    constexpr uint32_t BufferSizeOffset = 0x00;
+    constexpr uint32_t BufferSavedOffsetOffset = 0x04;
+    constexpr uint32_t BufferCurrentOffsetOffset = 0x08;
+    constexpr uint8_t TraceHeaderFlag = 0x80;
+
+    enum TraceHeaderType : uint8_t
+    {
+        System32 = 1,
+        System64 = 2,
+        Compact32 = 3,
+        Compact64 = 4,
+        FullHeader32 = 10,
+        Instance32 = 11,
+        PerfInfo32 = 16,
+        PerfInfo64 = 17,
+        EventHeader32 = 18,
+        EventHeader64 = 19,
+        FullHeader64 = 20,
+        Instance64 = 21,
+    };
+
+    template<typename T>
+    T ReadAt(const uint8_t* p, size_t offset)
+    {
+        T value;
+        memcpy(&value, p + offset, sizeof(T));
+        return value;
+    }
+
+    // returns false if the event header at p is not one we know how to size and timestamp
+    bool DecodeEventHeader(const uint8_t* p, size_t available, uint32_t* pSize, uint64_t* pTimestamp)
+    {
+        if (available < 8 || (p[3] & TraceHeaderFlag) == 0) {
+            return false;
+        }
+        uint32_t minSize = 0;
+        uint32_t timestampOffset = 0;
+        switch (p[2]) {
+        case System32:
+        case System64:
+            *pSize = ReadAt<uint16_t>(p, 4);
+            minSize = 32;
+            timestampOffset = 16;
+            break;
+        case Compact32:
+        case Compact64:
+            *pSize = ReadAt<uint16_t>(p, 4);
+            minSize = 24;
+            timestampOffset = 16;
+            break;
+        case PerfInfo32:
+        case PerfInfo64:
+            *pSize = ReadAt<uint16_t>(p, 4);
+            minSize = 16;
+            timestampOffset = 8;
+            break;
+        case FullHeader32:
+        case FullHeader64:
+        case Instance32:
+        case Instance64:
+            *pSize = ReadAt<uint16_t>(p, 0);
+            minSize = sizeof(EVENT_TRACE_HEADER);
+            timestampOffset = 16;
+            break;
+        case EventHeader32:
+        case EventHeader64:
+            *pSize = ReadAt<uint16_t>(p, 0);
+            minSize = sizeof(EVENT_HEADER);
+            timestampOffset = 16;
+            break;
+        default:
+            return false;
+        }
+        if (*pSize < minSize || *pSize > available) {
+            return false;
+        }
+        *pTimestamp = ReadAt<uint64_t>(p, timestampOffset);
+        return true;
+    }
+
+    // decodes the events of one buffer into entry; timestamps matching a state event are flagged
+    void ScanBuffer(const uint8_t* pBuffer, EtlIndex::BufferEntry& entry,
+        const std::unordered_set<uint64_t>& stateTimestamps, std::unordered_set<uint64_t>& foundTimestamps)
+    {
+        const auto savedOffset = ReadAt<uint32_t>(pBuffer, BufferSavedOffsetOffset);
+        const auto currentOffset = ReadAt<uint32_t>(pBuffer, BufferCurrentOffsetOffset);
+        uint32_t end = entry.size;
+        if (savedOffset > BufferHeaderSize && savedOffset <= entry.size) {
+            end = savedOffset;
+        }
+        else if (currentOffset > BufferHeaderSize && currentOffset <= entry.size) {
+            end = currentOffset;
+        }
+
+        entry.minTimestamp = UINT64_MAX;
+        entry.maxTimestamp = 0;
+        for (uint32_t offset = BufferHeaderSize; offset + 4 <= end; ) {
+            const auto marker = ReadAt<uint32_t>(pBuffer, offset);
+            // remainder of the buffer is padding
+            if (marker == 0xFFFF'FFFF || marker == 0) {
+                break;
+            }
+            uint32_t size = 0;
+            uint64_t ts = 0;
+            if (!DecodeEventHeader(pBuffer + offset, end - offset, &size, &ts)) {
+                entry.flags |= EtlIndex::Unparsed;
+                break;
+            }
+            entry.eventCount++;
+            entry.minTimestamp = std::min(entry.minTimestamp, ts);
+            entry.maxTimestamp = std::max(entry.maxTimestamp, ts);
+            if (stateTimestamps.contains(ts)) {
+                entry.flags |= EtlIndex::HasStateEvents;
+                foundTimestamps.insert(ts);
+            }
+            // events are 8-byte aligned within the buffer
+            offset += (size + 7u) & ~7u;
+        }
+        if (entry.eventCount == 0) {
+            entry.minTimestamp = 0;
+        }
+    }
+
+    template<typename T>
+    void Write(std::ofstream& file, const T& value)
+    {
+        file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    template<typename T>
+    bool Read(std::ifstream& file, T& value)
+    {
+        return (bool)file.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+}
+
+void EtlIndex::AddEvent(const EVENT_RECORD& evt, bool isStateEvent)
+{
+    const auto& hdr = evt.EventHeader;
+    const auto ts = (uint64_t)hdr.TimeStamp.QuadPart;
+    if (eventCount_ == 0) {
+        firstTimestamp_ = ts;
+    }
+    lastTimestamp_ = ts;
+    eventCount_++;
+    LookupProviderCount_(hdr.ProviderId).eventCount++;
+    if (isStateEvent) {
+        const auto pData = static_cast<const uint8_t*>(evt.UserData);
+        stateEvents_.push_back(StateEventSnapshot{
+            .header = hdr,
+            .processorIndex = evt.BufferContext.ProcessorIndex,
+            .payload = { pData, pData + evt.UserDataLength },
+        });
+    }
+}
+
+bool EtlIndex::ScanBuffers(const std::filesystem::path& etlPath, std::string& error)
+{
+    std::ifstream file{ etlPath, std::ios::binary };
+    if (!file) {
+        error = std::format("Failed to open {}", etlPath.string());
+        return false;
+    }
+    std::tie(etlSize_, etlWriteTime_) = GetFileStamp_(etlPath);
+
+    // a buffer is flagged as holding state events if it contains an event with the same timestamp
+    // as one of the state events seen by the relogger; a false positive only keeps an extra buffer
+    std::unordered_set<uint64_t> stateTimestamps;
+    for (auto& e : stateEvents_) {
+        stateTimestamps.insert((uint64_t)e.header.TimeStamp.QuadPart);
+    }
+    std::unordered_set<uint64_t> foundTimestamps;
+    // the relogger range is also probed to confirm that the raw buffers use the same clock
+    std::unordered_set<uint64_t> probeTimestamps{ firstTimestamp_, lastTimestamp_ };
+
+    buffers_.clear();
+    std::vector<uint8_t> buffer;
+    bool anyUnparsed = false;
+    for (uint64_t offset = 0; offset + BufferHeaderSize <= etlSize_; ) {
+        uint32_t bufferSize = 0;
+        file.seekg(offset + BufferSizeOffset);
+        if (!Read(file, bufferSize) || bufferSize < BufferHeaderSize || bufferSize > MaxBufferSize ||
+            offset + bufferSize > etlSize_) {
+            error = std::format("Unrecognized buffer header at offset {} of {}", offset, etlPath.string());
+            return false;
+        }
+        buffer.resize(bufferSize);
+        file.seekg(offset);
+        if (!file.read(reinterpret_cast<char*>(buffer.data()), bufferSize)) {
+            error = std::format("Failed to read buffer at offset {} of {}", offset, etlPath.string());
+            return false;
+        }
+        BufferEntry entry{
+            .fileOffset = offset,
+            .size = bufferSize,
+        };
+        ScanBuffer(buffer.data(), entry, stateTimestamps, foundTimestamps);
+        if (entry.flags & Unparsed) {
+            anyUnparsed = true;
+        }
+        else {
+            std::erase_if(probeTimestamps, [&](uint64_t ts) {
+                return ts >= entry.minTimestamp && ts <= entry.maxTimestamp && entry.eventCount > 0;
+            });
+        }
+        buffers_.push_back(entry);
+        offset += bufferSize;
+    }
+
+    // unparsed buffers are always kept when reducing, so anything not found might be in there
+    if (!anyUnparsed && (foundTimestamps.size() != stateTimestamps.size() || !probeTimestamps.empty())) {
+        error = "Raw buffer timestamps do not match the events reported by the relogger";
+        return false;
+    }
+    return true;
+}
+
+bool EtlIndex::Save(const std::filesystem::path& indexPath, std::string& error) const
+{
+    std::ofstream file{ indexPath, std::ios::binary | std::ios::trunc };
+    if (!file) {
+        error = std::format("Failed to create {}", indexPath.string());
+        return false;
+    }
+    IndexFileHeader header{
+        .version = Version,
+        .etlSize = etlSize_,
+        .etlWriteTime = etlWriteTime_,
+        .eventCount = eventCount_,
+        .firstTimestamp = firstTimestamp_,
+        .lastTimestamp = lastTimestamp_,
+        .bufferCount = buffers_.size(),
+        .providerCount = providerCounts_.size(),
+        .stateEventCount = stateEvents_.size(),
+    };
+    memcpy(header.magic, Magic, sizeof(Magic));
+    Write(file, header);
+    file.write(reinterpret_cast<const char*>(buffers_.data()), buffers_.size() * sizeof(BufferEntry));
+    file.write(reinterpret_cast<const char*>(providerCounts_.data()), providerCounts_.size() * sizeof(ProviderCount));
+    for (auto& e : stateEvents_) {
+        Write(file, StateEventHeader{
+            .header = e.header,
+            .payloadSize = (uint32_t)e.payload.size(),
+            .processorIndex = e.processorIndex,
+        });
+        file.write(reinterpret_cast<const char*>(e.payload.data()), e.payload.size());
+    }
+    if (!file) {
+        error = std::format("Failed to write {}", indexPath.string());
+        return false;
+    }
+    return true;
+}
+
+std::optional<EtlIndex> EtlIndex::Load(const std::filesystem::path& indexPath,
+    const std::filesystem::path& etlPath, std::string& error)
+{
+    std::ifstream file{ indexPath, std::ios::binary };
+    if (!file) {
+        error = std::format("Failed to open {}", indexPath.string());
+        return {};
+    }
+    IndexFileHeader header{};
+    if (!Read(file, header) || memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version) {
+        error = std::format("{} is not a supported index file", indexPath.string());
+        return {};
+    }
+    if (std::pair{ header.etlSize, header.etlWriteTime } != GetFileStamp_(etlPath)) {
+        error = std::format("{} is out of date with {}", indexPath.string(), etlPath.string());
+        return {};
+    }
+
+    EtlIndex index;
+    index.etlSize_ = header.etlSize;
+    index.etlWriteTime_ = header.etlWriteTime;
+    index.eventCount_ = header.eventCount;
+    index.firstTimestamp_ = header.firstTimestamp;
+    index.lastTimestamp_ = header.lastTimestamp;
+    index.buffers_.resize(header.bufferCount);
+    index.providerCounts_.resize(header.providerCount);
+    file.read(reinterpret_cast<char*>(index.buffers_.data()), index.buffers_.size() * sizeof(BufferEntry));
+    file.read(reinterpret_cast<char*>(index.providerCounts_.data()), index.providerCounts_.size() * sizeof(ProviderCount));
+    index.stateEvents_.reserve(header.stateEventCount);
+    for (uint64_t i = 0; i < header.stateEventCount && file; i++) {
+        StateEventHeader eventHeader{};
+        if (!Read(file, eventHeader)) {
+            break;
+        }
+        auto& e = index.stateEvents_.emplace_back(StateEventSnapshot{
+            .header = eventHeader.header,
+            .processorIndex = eventHeader.processorIndex,
+        });
+        e.payload.resize(eventHeader.payloadSize);
+        file.read(reinterpret_cast<char*>(e.payload.data()), e.payload.size());
+    }
+    if (!file) {
+        error = std::format("{} is truncated", indexPath.string());
+        return {};
+    }
+    return index;
+}
+
+bool EtlIndex::WriteReducedEtl(const std::filesystem::path& etlPath, const std::filesystem::path& outputPath,
+    std::pair<uint64_t, uint64_t> rangeQpc, bool keepStateBuffers, ReduceStats& stats, std::string& error) const
+{
+    std::ifstream input{ etlPath, std::ios::binary };
+    if (!input) {
+        error = std::format("Failed to open {}", etlPath.string());
+        return false;
+    }
+    std::ofstream output{ outputPath, std::ios::binary | std::ios::trunc };
+    if (!output) {
+        error = std::format("Failed to create {}", outputPath.string());
+        return false;
+    }
+
+    stats = {};
+    std::vector<char> buffer;
+    for (size_t i = 0; i < buffers_.size(); i++) {
+        const auto& b = buffers_[i];
+        // mirrors the decisions made per-event by the trimming callback: tail events are always
+        // discarded, head events only survive if they are state events
+        const bool keep = i == 0 || (b.flags & Unparsed) || (b.eventCount > 0 && b.minTimestamp <= rangeQpc.second &&
+            (b.maxTimestamp >= rangeQpc.first || (keepStateBuffers && (b.flags & HasStateEvents))));
+        if (!keep) {
+            stats.buffersSkipped++;
+            stats.bytesSkipped += b.size;
+            continue;
+        }
+        buffer.resize(b.size);
+        input.seekg(b.fileOffset);
+        if (!input.read(buffer.data(), b.size) || !output.write(buffer.data(), b.size)) {
+            error = std::format("Failed to copy buffer at offset {} of {}", b.fileOffset, etlPath.string());
+            return false;
+        }
+        stats.buffersKept++;
+        stats.bytesKept += b.size;
+    }
+    return true;
+}
+
+std::pair<uint64_t, uint64_t> EtlIndex::GetFileStamp_(const std::filesystem::path& etlPath)
+{
+    std::error_code sizeEc;
+    std::error_code timeEc;
+    const auto size = std::filesystem::file_size(etlPath, sizeEc);
+    const auto writeTime = std::filesystem::last_write_time(etlPath, timeEc);
+    return { sizeEc ? 0 : size, timeEc ? 0 : (uint64_t)writeTime.time_since_epoch().count() };
+}
+
+EtlIndex::ProviderCount& EtlIndex::LookupProviderCount_(const GUID& providerId)
+{
+    // only a handful of providers are present in a PresentMon capture
+    for (auto& p : providerCounts_) {
+        if (p.providerId == providerId) {
+            return p;
+        }
+    }
+    return providerCounts_.emplace_back(ProviderCount{ .providerId = providerId });
+}
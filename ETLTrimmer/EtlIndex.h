@@ -0,0 +1,85 @@
+#pragma once
+#include "../IntelPresentMon/CommonUtilities/win/WinAPI.h"
+#include <evntcons.h>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Sidecar index for an ETL file (written next to the input as <input>.pmidx by default)
+//
+// The index is built in two steps: every event delivered by the relogger during a normal pass is
+// recorded with AddEvent() (per-provider counts, first/last timestamp, and a snapshot of each
+// stateful event), then ScanBuffers() walks the raw buffers of the ETL file and records the file
+// offset and timestamp range of each one.  Later trims use WriteReducedEtl() to copy only the
+// buffers that can contain events that survive the trim into a smaller ETL, which is then relogged
+// exactly as the original would have been.  Buffers that cannot be parsed are always kept.
+class EtlIndex
+{
+public:
+    enum BufferFlags : uint32_t
+    {
+        HasStateEvents = 0x1,
+        Unparsed = 0x2,
+    };
+    struct BufferEntry
+    {
+        uint64_t fileOffset;
+        uint64_t minTimestamp;
+        uint64_t maxTimestamp;
+        uint32_t size;
+        uint32_t eventCount;
+        uint32_t flags;
+        uint32_t reserved;
+    };
+    struct ProviderCount
+    {
+        GUID providerId;
+        uint64_t eventCount;
+    };
+    struct StateEventSnapshot
+    {
+        EVENT_HEADER header;
+        uint16_t processorIndex;
+        std::vector<uint8_t> payload;
+    };
+    struct ReduceStats
+    {
+        size_t buffersKept = 0;
+        size_t buffersSkipped = 0;
+        uint64_t bytesKept = 0;
+        uint64_t bytesSkipped = 0;
+    };
+
+    // building
+    void AddEvent(const EVENT_RECORD& evt, bool isStateEvent);
+    bool ScanBuffers(const std::filesystem::path& etlPath, std::string& error);
+    bool Save(const std::filesystem::path& indexPath, std::string& error) const;
+    // loading; fails if the index was built for a different version of the ETL file
+    static std::optional<EtlIndex> Load(const std::filesystem::path& indexPath,
+        const std::filesystem::path& etlPath, std::string& error);
+    // copy buffer 0 (logfile header) plus every buffer that may hold an event kept when trimming to rangeQpc
+    bool WriteReducedEtl(const std::filesystem::path& etlPath, const std::filesystem::path& outputPath,
+        std::pair<uint64_t, uint64_t> rangeQpc, bool keepStateBuffers, ReduceStats& stats, std::string& error) const;
+
+    uint64_t GetEventCount() const { return eventCount_; }
+    std::pair<uint64_t, uint64_t> GetTimestampRange() const { return { firstTimestamp_, lastTimestamp_ }; }
+    const std::vector<BufferEntry>& GetBuffers() const { return buffers_; }
+    const std::vector<ProviderCount>& GetProviderCounts() const { return providerCounts_; }
+    const std::vector<StateEventSnapshot>& GetStateEvents() const { return stateEvents_; }
+
+private:
+    static std::pair<uint64_t, uint64_t> GetFileStamp_(const std::filesystem::path& etlPath);
+    ProviderCount& LookupProviderCount_(const GUID& providerId);
+
+    uint64_t etlSize_ = 0;
+    uint64_t etlWriteTime_ = 0;
+    uint64_t eventCount_ = 0;
+    uint64_t firstTimestamp_ = 0;
+    uint64_t lastTimestamp_ = 0;
+    std::vector<BufferEntry> buffers_;
+    std::vector<ProviderCount> providerCounts_;
+    std::vector<StateEventSnapshot> stateEvents_;
+};
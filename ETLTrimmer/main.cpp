@@ -9,12 +9,15 @@
 #include <objbase.h>
 #include <relogger.h>
 #include <iostream>
+#include <chrono>
+#include <filesystem>
 #include <optional>
 #include <format>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include "CliOptions.h"
+#include "EtlIndex.h"
 #include "../PresentData/PresentMonTraceSession.hpp"
 #include "../PresentData/PresentMonTraceConsumer.hpp"
 #include "../PresentData/ETW/Microsoft_Windows_EventMetadata.h"
@@ -124,6 +127,8 @@ private:
     Filter stateFilter_; // don't discard these events outside trim range
     bool byId_;
     bool trimState_;
+    // sidecar index being built from this pass (optional)
+    EtlIndex* pIndex_ = nullptr;
     // analysis stats
     int eventCount_ = 0;
     int keepCount_ = 0;
@@ -209,6 +214,9 @@ public:
         }
         lastTimestamp_ = ts;
         eventCount_++;
+        if (pIndex_) {
+            pIndex_->AddEvent(*pEvt, IsStateEvent_(hdr));
+        }
         bool canDiscard = true;
         if (trimRangeQpc_) {
             // tail events always discardable
@@ -216,12 +224,8 @@ public:
                 return S_OK;
             }
             // if we are trimming by time range, we probably want to preserve state events
-            if (!trimState_) {
-                if (auto pProducerFilter = stateFilter_.LookupProvider(hdr.ProviderId)) {
-                    if (pProducerFilter->MatchesId(desc.Id)) {
-                        canDiscard = false;
-                    }
-                }
+            if (!trimState_ && IsStateEvent_(hdr)) {
+                canDiscard = false;
             }
             // trim non-state events in head preceding the trim range
             if (canDiscard && ts < trimRangeQpc_->first) {
@@ -266,15 +270,29 @@ public:
     {
         trimRangeMs_ = range;
     }
+    void SetIndexBuilder(EtlIndex* pIndex)
+    {
+        pIndex_ = pIndex;
+    }
     int GetKeepCount() const
     {
         return keepCount_;
     }
+private:
+    bool IsStateEvent_(const EVENT_HEADER& hdr)
+    {
+        if (auto pProducerFilter = stateFilter_.LookupProvider(hdr.ProviderId)) {
+            return pProducerFilter->MatchesId(hdr.EventDescriptor.Id);
+        }
+        return false;
+    }
 };
 
 class TempFile
 {
 public:
+    TempFile() = default;
+    explicit TempFile(const wchar_t* name) : name_{ name } {}
     operator const CComBSTR& () const
     {
         return name_;
@@ -287,6 +305,23 @@ private:
     CComBSTR name_ = "null-log.etl.tmp";
 };
 
+std::string FormatGuid(const GUID& guid)
+{
+    return std::format("{{{:08X}-{:04X}-{:04X}-{:02X}{:02X}-{:02X}{:02X}{:02X}{:02X}{:02X}{:02X}}}",
+        guid.Data1, guid.Data2, guid.Data3, guid.Data4[0], guid.Data4[1], guid.Data4[2],
+        guid.Data4[3], guid.Data4[4], guid.Data4[5], guid.Data4[6], guid.Data4[7]);
+}
+
+void PrintIndexSummary(const EtlIndex& index)
+{
+    std::cout << std::format("Index: {:L} buffers, {:L} state events\n",
+        index.GetBuffers().size(), index.GetStateEvents().size());
+    for (auto& p : index.GetProviderCounts()) {
+        std::cout << std::format("  {} {:>14L}\n", FormatGuid(p.providerId), p.eventCount);
+    }
+    std::cout << std::endl;
+}
+
 
 int main(int argc, const char** argv)
 {
@@ -315,6 +350,70 @@ int main(int argc, const char** argv)
 
     std::locale::global(std::locale("en_US.UTF-8"));
 
+    const auto startTime = std::chrono::steady_clock::now();
+    const std::filesystem::path indexPath = opt.indexFile ? *opt.indexFile : *opt.inputFile + ".pmidx";
+
+    // ns and ms ranges are relative to the first event in the trace
+    std::optional<std::pair<uint64_t, uint64_t>> trimRangeQpc = opt.trimRangeQpc.AsOptional();
+    std::optional<std::pair<double, double>> trimRangeMs = opt.trimRangeMs.AsOptional();
+    if (opt.trimRangeNs) {
+        auto& r = *opt.trimRangeNs;
+        trimRangeMs = {
+            r.first * 1'000'000.,
+            r.second * 1'000'000.
+        };
+    }
+
+    // with an index, the first timestamp is known up front so the whole range can be resolved to QPC
+    // and only the buffers that overlap it (plus those holding state events) need to be relogged
+    std::optional<EtlIndex> index;
+    if (opt.useIndex) {
+        std::string error;
+        index = EtlIndex::Load(indexPath, *opt.inputFile, error);
+        if (!index) {
+            std::cout << "Not using index: " << error << std::endl;
+        }
+        else if (trimRangeMs) {
+            const auto first = index->GetTimestampRange().first;
+            trimRangeQpc = {
+                first + uint64_t(trimRangeMs->first * 10'000),
+                first + uint64_t(trimRangeMs->second * 10'000),
+            };
+            trimRangeMs.reset();
+        }
+    }
+    CComBSTR inputEtlName = (*opt.inputFile).c_str();
+    std::optional<TempFile> reducedInput;
+    if (index && trimRangeQpc) {
+        constexpr auto reducedInputName = L"reduced-input.etl.tmp";
+        reducedInput.emplace(reducedInputName);
+        EtlIndex::ReduceStats stats;
+        std::string error;
+        if (index->WriteReducedEtl(*opt.inputFile, reducedInputName, *trimRangeQpc, !opt.trimState, stats, error)) {
+            inputEtlName = *reducedInput;
+            std::cout << std::format("Index selected {:L} of {:L} buffers ({:L} bytes skipped)\n",
+                stats.buffersKept, stats.buffersKept + stats.buffersSkipped, stats.bytesSkipped);
+        }
+        else {
+            std::cout << "Not using index: " << error << std::endl;
+            reducedInput.reset();
+        }
+    }
+
+    // analysis without trimming can be answered from the index alone
+    if (index && !trimRangeQpc && !opt.outputFile && !opt.provider) {
+        const auto tsr = index->GetTimestampRange();
+        const auto dur = tsr.second - tsr.first;
+        std::cout << std::format(" ======== Report for [ {} ] (from index) ========\n", *opt.inputFile);
+        std::cout << std::format("Total event count: {:L}\n", index->GetEventCount());
+        std::cout << std::format("Timestamp range {:L} - {:L} (duration: {:L})\n", tsr.first, tsr.second, dur);
+        std::cout << std::format("Duration of trace in milliseconds: {:L}\n\n", double(dur) / 10'000.);
+        PrintIndexSummary(*index);
+        std::cout << std::format("Processing time: {:.3f} s\n",
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+        return 0;
+    }
+
     if (auto hr = CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED); FAILED(hr)) {
         std::cout << "Failed to init COM" << std::endl;
         return -1;
@@ -328,9 +427,8 @@ int main(int argc, const char** argv)
     }
 
     TRACEHANDLE relogTraceHandle;
-    const CComBSTR inputEtlName = (*opt.inputFile).c_str();
     if (auto hr = pRelogger->AddLogfileTraceStream(inputEtlName, nullptr, &relogTraceHandle); FAILED(hr)) {
-        std::cout << "Failed to add logfile: " << *opt.inputFile << std::endl;
+        std::cout << "Failed to add logfile: " << *opt.inputFile << (reducedInput ? " (try again without --use-index)" : "") << std::endl;
     }
 
     // we must output to etl file no matter what
@@ -367,33 +465,35 @@ int main(int argc, const char** argv)
         std::cout << "Failed to register callback" << std::endl;
     }
 
-    if (opt.trimRangeQpc) {
-        pCallbackProcessor->SetTrimRangeQpc(*opt.trimRangeQpc);
+    if (trimRangeQpc) {
+        pCallbackProcessor->SetTrimRangeQpc(*trimRangeQpc);
     }
-    else if (opt.trimRangeMs) {
-        pCallbackProcessor->SetTrimRangeMs(*opt.trimRangeMs);
+    else if (trimRangeMs) {
+        pCallbackProcessor->SetTrimRangeMs(*trimRangeMs);
     }
-    else if (opt.trimRangeNs) {
-        auto& r = *opt.trimRangeNs;
-        pCallbackProcessor->SetTrimRangeMs({
-            r.first * 1'000'000.,
-            r.second * 1'000'000.
-        });
+
+    std::optional<EtlIndex> newIndex;
+    if (opt.writeIndex) {
+        newIndex.emplace();
+        pCallbackProcessor->SetIndexBuilder(&*newIndex);
     }
 
     if (auto hr = pRelogger->ProcessTrace(); FAILED(hr)) {
         std::cout << "Failed to process trace: " << util::win::GetErrorDescription(hr) << std::endl;
     }
 
-    const auto tsr = pCallbackProcessor->GetTimestampRange();
+    // when reading a reduced input the totals for the whole trace come from the index
+    const bool reduced = (bool)reducedInput;
+    const auto tsr = reduced ? index->GetTimestampRange() : pCallbackProcessor->GetTimestampRange();
     const auto dur = tsr.second - tsr.first;
+    const uint64_t eventCount = reduced ? index->GetEventCount() : (uint64_t)pCallbackProcessor->GetEventCount();
     std::cout << std::format(" ======== Report for [ {} ] ========\n", *opt.inputFile);
-    std::cout << std::format("Total event count: {:L}\n", pCallbackProcessor->GetEventCount());
+    std::cout << std::format("Total event count: {:L}\n", eventCount);
     std::cout << std::format("Timestamp range {:L} - {:L} (duration: {:L})\n", tsr.first, tsr.second, dur);
     std::cout << std::format("Duration of trace in milliseconds: {:L}\n\n", double(dur) / 10'000.);
 
     std::cout << std::format("Events trimmed and/or filtered: {:L}\n",
-        pCallbackProcessor->GetEventCount() - pCallbackProcessor->GetKeepCount());
+        eventCount - pCallbackProcessor->GetKeepCount());
     std::cout << std::format("Count of persisted events: {:L}\n", pCallbackProcessor->GetKeepCount());
 
     if (!opt.outputFile) {
@@ -403,6 +503,20 @@ int main(int argc, const char** argv)
         std::cout << "Output written to: " << *opt.outputFile << std::endl;
     }
 
+    if (newIndex) {
+        std::string error;
+        if (newIndex->ScanBuffers(*opt.inputFile, error) && newIndex->Save(indexPath, error)) {
+            std::cout << "Index written to: " << indexPath.string() << std::endl;
+            PrintIndexSummary(*newIndex);
+        }
+        else {
+            std::cout << "Failed to write index: " << error << std::endl;
+        }
+    }
+
+    std::cout << std::format("Processing time: {:.3f} s\n",
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+
     return 0;
 }
 
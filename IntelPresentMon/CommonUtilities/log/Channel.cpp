@@ -9,8 +9,10 @@
 #include "PanicLogger.h"
 #include "StackTrace.h"
 #include "GlobalPolicy.h"
+#include "LinePolicy.h"
 #include "../str/String.h"
 #include "../Exception.h"
+#include "../Hash.h"
 
 namespace pmon::util::log
 {
@@ -113,6 +115,11 @@ namespace pmon::util::log
 						using ElementType = std::decay_t<decltype(el)>;
 						if constexpr (std::is_same_v<ElementType, Entry>) {
 							Entry& entry = el;
+							// a hit drawn by another channel (e.g. an entry copied between channels) does not count
+							// against this channel's rate control, which then draws its own
+							if (hasLinePolicy_ && entry.pHitChannel_ != this) {
+								entry.hitCount_ = -1;
+							}
 							// process all policies, tranforming entry in-place
 							for (auto&& [tag,pPolicy] : policyPtrs_) {
 								try {
@@ -136,9 +143,21 @@ namespace pmon::util::log
 									pmlog_panic_(ReportException());
 								}
 							}
+							const bool hasResolvedTrace = entry.pTrace_ && entry.pTrace_->Resolved();
+							const auto traceKey = hasResolvedTrace ?
+								hash::HashCombine(entry.pTrace_->GetHash(), entry.pid_) : size_t(0);
 							// submit entry to all drivers (by copy)
 							for (auto&& [tag,pDriver] : driverPtrs_) {
-								try { pDriver->Submit(entry); }
+								try {
+									if (!pDriver->Accepts(entry)) {
+										continue;
+									}
+									// collapse traces that this driver has already emitted into references
+									if (hasResolvedTrace) {
+										entry.pTrace_->SetRepeat(!MarkTraceEmitted_(pDriver.get(), traceKey));
+									}
+									pDriver->Submit(entry);
+								}
 								catch (...) {
 									pmlog_panic_(ReportException());
 								}
@@ -190,6 +209,7 @@ namespace pmon::util::log
 			Replace_(driverPtrs_, std::shared_ptr<IDriver>{}, tag);
 			Replace_(policyPtrs_, std::shared_ptr<IPolicy>{}, tag);
 			Replace_(objectPtrs_, std::shared_ptr<IChannelObject>{}, tag);
+			OnComponentsChanged_();
 		}
 		void ChannelInternal_::AttachComponent_(std::shared_ptr<IChannelComponent> pComponent, std::string tag)
 		{
@@ -206,6 +226,31 @@ namespace pmon::util::log
 				std::string type = typeid(*pComponent).name();
 				throw Except<Exception>("bad type for component attachment in channel, type => " + type );
 			}
+			OnComponentsChanged_();
+		}
+		void ChannelInternal_::OnComponentsChanged_()
+		{
+			hasLinePolicy_ = rn::any_of(policyPtrs_, [](auto& p) {
+				return dynamic_cast<const LinePolicy*>(p.second.get()) != nullptr;
+			});
+			// forget trace history of drivers that have been removed or replaced
+			std::erase_if(emittedTraces_, [this](const auto& kv) {
+				return rn::none_of(driverPtrs_, [&](auto& p) { return p.second.get() == kv.first; });
+			});
+		}
+		bool ChannelInternal_::MarkTraceEmitted_(const IDriver* pDriver, size_t traceKey)
+		{
+			auto& traces = emittedTraces_[pDriver];
+			if (!traces.keys.insert(traceKey).second) {
+				return false;
+			}
+			traces.order.push_back(traceKey);
+			// forget the oldest emitted trace so that it will be printed in full again if it recurs
+			if (traces.order.size() > emittedTraceHistorySize_) {
+				traces.keys.erase(traces.order.front());
+				traces.order.pop_front();
+			}
+			return true;
 		}
 		void ChannelInternal_::EnqueueEntry(Entry&& e)
 		{
@@ -215,6 +260,15 @@ namespace pmon::util::log
 		{
 			Queue_(this).enqueue(e);
 		}
+		bool ChannelInternal_::PreFilterEntry(Entry& e)
+		{
+			// rate control is only applied when a line policy is configured, same as on the worker thread
+			if (hasLinePolicy_) {
+				e.pHitChannel_ = this;
+				return LinePolicy::Filter(e);
+			}
+			return true;
+		}
 		template<class P, typename ...Args>
 		void ChannelInternal_::EnqueuePacketWait(Args&& ...args)
 		{
@@ -266,6 +320,16 @@ namespace pmon::util::log
 	{
 		EnqueuePacketWait<FlushPacket_>();
 	}
+	bool Channel::PreFilter(Entry& e) noexcept
+	{
+		try {
+			return PreFilterEntry(e);
+		}
+		catch (...) {
+			pmlog_panic_("Exception thrown in Channel::PreFilter");
+			return true;
+		}
+	}
 	void Channel::AttachComponent(std::shared_ptr<IChannelComponent> pComponent, std::string tag)
 	{
 		if (pComponent) {
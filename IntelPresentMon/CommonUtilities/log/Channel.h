@@ -5,6 +5,9 @@
 #include <memory>
 #include "../mt/Thread.h"
 #include <atomic>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace pmon::util::log
 {
@@ -32,6 +35,7 @@ namespace pmon::util::log
 			void RemoveComponentByTagBlocking(const std::string&);
 			void EnqueueEntry(Entry&&);
 			void EnqueueEntry(const Entry&);
+			bool PreFilterEntry(Entry&);
 			template<class P, typename...Args>
 			void EnqueuePacketWait(Args&&...args);
 			template<class P, typename...Args>
@@ -41,7 +45,19 @@ namespace pmon::util::log
 		private:
 			// functions
 			void AttachComponent_(std::shared_ptr<IChannelComponent>, std::string);
+			// update state derived from the set of attached components
+			void OnComponentsChanged_();
+			// returns true if the trace has not been emitted by the driver yet (within the bounded history window)
+			bool MarkTraceEmitted_(const IDriver* pDriver, size_t traceKey);
+			// types
+			// keys of traces emitted in full by one driver, oldest first in order
+			struct EmittedTraces_
+			{
+				std::unordered_set<size_t> keys;
+				std::deque<size_t> order;
+			};
 			// data
+			static constexpr size_t emittedTraceHistorySize_ = 256;
 			// mutex used for infrequent operations like managing components
 			std::mutex mtx_;
 			bool resolvingTraces_ = true;
@@ -49,6 +65,10 @@ namespace pmon::util::log
 			std::vector<std::pair<std::string, std::shared_ptr<IDriver>>> driverPtrs_;
 			std::vector<std::pair<std::string, std::shared_ptr<IPolicy>>> policyPtrs_;
 			std::vector<std::pair<std::string, std::shared_ptr<IChannelObject>>> objectPtrs_;
+			// set when a LinePolicy is attached, read by submitting threads to filter before trace capture
+			std::atomic<bool> hasLinePolicy_ = false;
+			// traces emitted in full by each driver, used to emit repeated traces as references (worker thread only)
+			std::unordered_map<const IDriver*, EmittedTraces_> emittedTraces_;
 			std::shared_ptr<void> pEntryQueue_;
 			mt::Thread worker_;
 		};
@@ -67,6 +87,7 @@ namespace pmon::util::log
 		void Submit(Entry&&) noexcept override;
 		void Submit(const Entry&) noexcept override;
 		void Flush() override;
+		bool PreFilter(Entry&) noexcept override;
 		void AttachComponent(std::shared_ptr<IChannelComponent>, std::string = {}) override;
 		void FlushEntryPointExit() override;
 	};
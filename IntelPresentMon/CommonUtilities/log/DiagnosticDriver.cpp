@@ -5,6 +5,8 @@
 #include <iostream>
 #include <span>
 #include <algorithm>
+#include <utility>
+#include <variant>
 
 using namespace std::chrono_literals;
 namespace rn = std::ranges;
@@ -16,6 +18,7 @@ namespace pmon::util::log
 		if (pConfig) {
 			config_ = DiagnosticConfig{ *pConfig };
 		}
+		ring_.resize(maxQueuedMessages_, nullptr);
 	}
 	DiagnosticDriver::~DiagnosticDriver()
 	{
@@ -23,46 +26,52 @@ namespace pmon::util::log
 		try { manualUnblockEvent_.Set(); }
 		catch (...) { pmlog_panic_("Failed to set the manual unblock event"); }
 	}
-	void DiagnosticDriver::Submit(const Entry& e)
+	bool DiagnosticDriver::Accepts(const Entry& e) const
 	{
 		// ignore non-diagnostic entries and low-priority levels
 		if ((!e.diagnosticLayer_ && !config_.disableDiagnosticFilter)
 			|| int(e.level_) > int(config_.filterLevel)) {
-			return;
+			return false;
 		}
 		// filtering by subsystem
 		if (!config_.subsystems.empty() && !rn::contains(config_.subsystems,
 			(PM_DIAGNOSTIC_SUBSYSTEM)e.subsystem_)) {
+			return false;
+		}
+		return true;
+	}
+	void DiagnosticDriver::Submit(const Entry& e)
+	{
+		if (!Accepts(e)) {
 			return;
 		}
-		// prepare string payloads
-		std::string timestamp;
+		// take a recycled message from the pool and write payloads directly into its buffers
+		auto pMessage = pPool_->Acquire();
+		pMessage->level = (PM_DIAGNOSTIC_LEVEL)e.level_;
+		pMessage->system = (PM_DIAGNOSTIC_SUBSYSTEM)e.subsystem_;
+		pMessage->pid = e.pid_;
+		pMessage->tid = e.tid_;
+		pMessage->messageBuffer_.Assign(e.note_);
 		if (config_.enableTimestamp) {
 			const auto zt = std::chrono::zoned_time{ std::chrono::current_zone(), e.timestamp_ };
-			timestamp = std::format("{}", zt);
+			pMessage->timestampBuffer_.AppendFormat("{}", zt);
 		}
-		std::string trace;
 		if (config_.enableTrace) {
 			if (e.pTrace_ && e.pTrace_->Resolved()) {
-				trace = e.pTrace_->ToString();
+				pMessage->traceBuffer_.AppendFormat("{}", *e.pTrace_);
 			}
 		}
-		std::string location;
 		if (config_.enableLocation) {
-			location = std::format("{}({})", e.GetSourceFileName(), e.sourceLine_);
+			const auto file = std::visit([](const auto& s) -> std::string_view {
+				if constexpr (std::is_same_v<std::decay_t<decltype(s)>, Entry::StaticSourceStrings>) {
+					return s.file_ ? s.file_ : std::string_view{};
+				}
+				else {
+					return s.file_;
+				}
+			}, e.sourceStrings_);
+			pMessage->locationBuffer_.AppendFormat("{}({})", file, e.sourceLine_);
 		}
-		// create diagnostic message based on logging entry
-		auto pMessage = std::make_unique<DiagnosticMessage>();
-		// set values
-		pMessage->level = (PM_DIAGNOSTIC_LEVEL)e.level_;
-		pMessage->system = (PM_DIAGNOSTIC_SUBSYSTEM)e.subsystem_;
-		pMessage->pid = e.pid_;
-		pMessage->tid = e.tid_;
-		// handle buffers
-		pMessage->messageBuffer_ = e.note_;
-		pMessage->locationBuffer_ = std::move(location);
-		pMessage->timestampBuffer_ = std::move(timestamp);
-		pMessage->traceBuffer_ = std::move(trace);
 		pMessage->SyncBuffers_();
 		// process message
 		ProcessCommon_(std::move(pMessage));
@@ -70,7 +79,7 @@ namespace pmon::util::log
 	void DiagnosticDriver::Flush() {}
 	uint32_t DiagnosticDriver::GetQueuedMessageCount()
 	{
-		return (uint32_t)messageQueue_.size_approx();
+		return queuedCount_;
 	}
 	uint32_t DiagnosticDriver::GetMaxQueuedMessages()
 	{
@@ -78,17 +87,27 @@ namespace pmon::util::log
 	}
 	void DiagnosticDriver::SetMaxQueuedMessages(uint32_t max)
 	{
-		maxQueuedMessages_ = max;
+		std::lock_guard lk{ ringMtx_ };
+		ResizeRing_(max);
 	}
 	uint32_t DiagnosticDriver::GetDiscardedMessageCount()
 	{
 		return discardedCount_;
 	}
-	std::unique_ptr<DiagnosticMessage> DiagnosticDriver::DequeueMessage()
+	DiagnosticMessage* DiagnosticDriver::DequeueMessage()
 	{
 		messageWaitEvent_.Reset();
-		std::unique_ptr<DiagnosticMessage> pMessage;
-		messageQueue_.try_dequeue(pMessage);
+		DiagnosticMessage* pMessage = nullptr;
+		{
+			std::lock_guard lk{ ringMtx_ };
+			if (queuedCount_ == 0) {
+				return nullptr;
+			}
+			pMessage = std::exchange(ring_[ringHead_], nullptr);
+			ringHead_ = (ringHead_ + 1) % ring_.size();
+			queuedCount_--;
+		}
+		pMessage->pLender_ = pPool_;
 		return pMessage;
 	}
 	void DiagnosticDriver::EnqueueMessage(const PM_DIAGNOSTIC_MESSAGE* pMessage)
@@ -96,7 +115,9 @@ namespace pmon::util::log
 		if (!pMessage) {
 			throw Except<Exception>("Diagnostic message injection with null message pointer");
 		}
-		ProcessCommon_(std::make_unique<DiagnosticMessage>(*pMessage));
+		auto pPooled = pPool_->Acquire();
+		pPooled->Assign(*pMessage);
+		ProcessCommon_(std::move(pPooled));
 	}
 	PM_DIAGNOSTIC_WAKE_REASON DiagnosticDriver::WaitForMessage(uint32_t timeoutMs)
 	{
@@ -123,53 +144,81 @@ namespace pmon::util::log
 	{
 		manualUnblockEvent_.Set();
 	}
-	void DiagnosticDriver::Enqueue_(std::unique_ptr<DiagnosticMessage> pMsg)
+	void DiagnosticDriver::Enqueue_(DiagnosticMessagePool::Ptr pMsg)
 	{
-		// ensure that # of queued does not exceed max
-		while (GetQueuedMessageCount() >= GetMaxQueuedMessages()) {
-			std::unique_ptr<DiagnosticMessage> p;
-			if (messageQueue_.try_dequeue(p)) {
+		// a message overwritten in the ring goes back to the pool after the lock is released
+		DiagnosticMessagePool::Ptr pEvicted{ nullptr, { pPool_.get() } };
+		{
+			std::lock_guard lk{ ringMtx_ };
+			if (ring_.empty()) {
+				discardedCount_++;
+				return;
+			}
+			const auto tail = (ringHead_ + queuedCount_) % ring_.size();
+			if (queuedCount_ == ring_.size()) {
+				// full: overwrite the oldest message
+				pEvicted.reset(ring_[tail]);
+				ringHead_ = (ringHead_ + 1) % ring_.size();
 				discardedCount_++;
 			}
+			else {
+				queuedCount_++;
+			}
+			ring_[tail] = pMsg.release();
 		}
-		// enqueue the message
-		messageQueue_.enqueue(std::move(pMsg));
 		// signal message availability
 		messageWaitEvent_.Set();
 	}
-	void DiagnosticDriver::ProcessCommon_(std::unique_ptr<DiagnosticMessage> pMsg)
+	void DiagnosticDriver::ProcessCommon_(DiagnosticMessagePool::Ptr pMsg)
 	{
-		using namespace std::string_literals;
-		// handle direct output
-		std::string formattedMsg;
-		auto format = [&] { if (formattedMsg.empty()) {
-			auto level = GetLevelName((Level)pMsg->level);
-			auto sys = GetSubsystemName((Subsystem)pMsg->system);
+		// output formatted string directly to active media
+		if (config_.outputFlags & (PM_DIAGNOSTIC_OUTPUT_FLAGS_DEBUGGER |
+			PM_DIAGNOSTIC_OUTPUT_FLAGS_STDERR | PM_DIAGNOSTIC_OUTPUT_FLAGS_STDOUT)) {
+			InlineText<1200> formattedMsg;
+			const auto level = GetLevelName((Level)pMsg->level);
+			const auto sys = GetSubsystemName((Subsystem)pMsg->system);
+			const auto text = pMsg->pText ? std::string_view{ pMsg->pText } : std::string_view{};
 			if (pMsg->pTimestamp) {
-				formattedMsg = std::format("[PMON:{} {}] {{{}}} {}\n", sys, level, pMsg->pTimestamp, pMsg->pText);
+				formattedMsg.AppendFormat("[PMON:{} {}] {{{}}} {}\n", sys, level, pMsg->pTimestamp, text);
 			}
 			else {
-				formattedMsg = std::format("[PMON:{} {}] {}\n", sys, level, pMsg->pText);
+				formattedMsg.AppendFormat("[PMON:{} {}] {}\n", sys, level, text);
+			}
+			if (config_.outputFlags & PM_DIAGNOSTIC_OUTPUT_FLAGS_DEBUGGER) {
+				OutputDebugStringA(formattedMsg.CStrOrNull());
+			}
+			if (config_.outputFlags & PM_DIAGNOSTIC_OUTPUT_FLAGS_STDERR) {
+				std::cerr << formattedMsg.CStrOrNull();
+			}
+			if (config_.outputFlags & PM_DIAGNOSTIC_OUTPUT_FLAGS_STDOUT) {
+				std::cout << formattedMsg.CStrOrNull();
 			}
-		} };
-		// output formatted string directly to active media
-		if (config_.outputFlags & PM_DIAGNOSTIC_OUTPUT_FLAGS_DEBUGGER) {
-			format();
-			OutputDebugStringA(formattedMsg.c_str());
-		}
-		if (config_.outputFlags & PM_DIAGNOSTIC_OUTPUT_FLAGS_STDERR) {
-			format();
-			std::cerr << formattedMsg;
-		}
-		if (config_.outputFlags & PM_DIAGNOSTIC_OUTPUT_FLAGS_STDOUT) {
-			format();
-			std::cout << formattedMsg;
 		}
-		// handle queue
+		// handle queue, message returns to the pool when not queued
 		if (config_.outputFlags & PM_DIAGNOSTIC_OUTPUT_FLAGS_QUEUE) {
 			Enqueue_(std::move(pMsg));
 		}
 	}
+	void DiagnosticDriver::ResizeRing_(uint32_t capacity)
+	{
+		// keep the newest messages that fit, discarding the oldest
+		std::vector<DiagnosticMessage*> ring(capacity, nullptr);
+		const auto kept = std::min<uint32_t>(queuedCount_, capacity);
+		for (uint32_t i = 0; i < queuedCount_; i++) {
+			auto pMessage = ring_[(ringHead_ + i) % ring_.size()];
+			if (i < queuedCount_ - kept) {
+				pPool_->Release(pMessage);
+				discardedCount_++;
+			}
+			else {
+				ring[i - (queuedCount_ - kept)] = pMessage;
+			}
+		}
+		ring_ = std::move(ring);
+		ringHead_ = 0;
+		queuedCount_ = kept;
+		maxQueuedMessages_ = capacity;
+	}
 	DiagnosticConfig::DiagnosticConfig(const PM_DIAGNOSTIC_CONFIGURATION& src)
 		:
 		PM_DIAGNOSTIC_CONFIGURATION{ src }
@@ -191,41 +240,73 @@ namespace pmon::util::log
 			.enableLocation{ false }
 		}
 	{}
-	DiagnosticMessage::DiagnosticMessage(const PM_DIAGNOSTIC_MESSAGE& msg)
-		:
-		// copies value-based fields, pointers will be set in subsequent SyncBuffers_() call
-		PM_DIAGNOSTIC_MESSAGE{ msg }
+	DiagnosticMessage::DiagnosticMessage() : PM_DIAGNOSTIC_MESSAGE{}
+	{}
+	void DiagnosticMessage::Assign(const PM_DIAGNOSTIC_MESSAGE& msg)
 	{
 		if (!msg.pText) {
 			throw Except<Exception>("Diagnostic message text pointer not set");
 		}
-		messageBuffer_ = msg.pText;
-		if (msg.pTimestamp) {
-			timestampBuffer_ = msg.pTimestamp;
-		}
-		if (msg.pTrace) {
-			traceBuffer_ = msg.pTrace;
-		}
-		if (msg.pLocation) {
-			locationBuffer_ = msg.pLocation;
-		}
+		// copies value-based fields, pointers will be set in subsequent SyncBuffers_() call
+		static_cast<PM_DIAGNOSTIC_MESSAGE&>(*this) = msg;
+		messageBuffer_.Assign(msg.pText);
+		timestampBuffer_.Assign(msg.pTimestamp ? msg.pTimestamp : "");
+		traceBuffer_.Assign(msg.pTrace ? msg.pTrace : "");
+		locationBuffer_.Assign(msg.pLocation ? msg.pLocation : "");
 		SyncBuffers_();
 	}
-	DiagnosticMessage::DiagnosticMessage() : PM_DIAGNOSTIC_MESSAGE{}
-	{}
+	void DiagnosticMessage::Reset()
+	{
+		static_cast<PM_DIAGNOSTIC_MESSAGE&>(*this) = {};
+		messageBuffer_.Clear();
+		locationBuffer_.Clear();
+		traceBuffer_.Clear();
+		timestampBuffer_.Clear();
+	}
 	void DiagnosticMessage::SyncBuffers_()
 	{
-		if (!messageBuffer_.empty()) {
-			pText = messageBuffer_.c_str();
-		}
-		if (!timestampBuffer_.empty()) {
-			pTimestamp = timestampBuffer_.c_str();
+		pText = messageBuffer_.CStrOrNull();
+		pTimestamp = timestampBuffer_.CStrOrNull();
+		pTrace = traceBuffer_.CStrOrNull();
+		pLocation = locationBuffer_.CStrOrNull();
+	}
+	void DiagnosticMessage::Free(PM_DIAGNOSTIC_MESSAGE* pMessage)
+	{
+		auto pMsg = static_cast<DiagnosticMessage*>(pMessage);
+		if (auto pPool = std::move(pMsg->pLender_)) {
+			pPool->Release(pMsg);
 		}
-		if (!traceBuffer_.empty()) {
-			pTrace = traceBuffer_.c_str();
+		else {
+			throw Except<Exception>("Freeing diagnostic message that was not dequeued");
 		}
-		if (!locationBuffer_.empty()) {
-			pLocation = locationBuffer_.c_str();
+	}
+	void DiagnosticMessagePool::Returner::operator()(DiagnosticMessage* pMessage) const
+	{
+		pPool->Release(pMessage);
+	}
+	DiagnosticMessagePool::Ptr DiagnosticMessagePool::Acquire()
+	{
+		std::lock_guard lk{ mtx_ };
+		if (free_.empty()) {
+			auto& slab = slabs_.emplace_back(std::make_unique<DiagnosticMessage[]>(slabSize));
+			free_.reserve(slabs_.size() * slabSize);
+			for (size_t i = 0; i < slabSize; i++) {
+				free_.push_back(&slab[i]);
+			}
 		}
+		auto pMessage = free_.back();
+		free_.pop_back();
+		return Ptr{ pMessage, { this } };
+	}
+	void DiagnosticMessagePool::Release(DiagnosticMessage* pMessage)
+	{
+		pMessage->Reset();
+		std::lock_guard lk{ mtx_ };
+		free_.push_back(pMessage);
+	}
+	size_t DiagnosticMessagePool::GetCapacity() const
+	{
+		std::lock_guard lk{ mtx_ };
+		return slabs_.size() * slabSize;
 	}
 }
\ No newline at end of file
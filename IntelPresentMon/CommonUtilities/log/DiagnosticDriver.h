@@ -4,22 +4,114 @@
 #include "../../PresentMonAPI2/PresentMonDiagnostics.h"
 #include "../win/Event.h"
 #include <atomic>
-#include <concurrentqueue/concurrentqueue.h>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <format>
+#include <string_view>
 #include "Entry.h"
 
 
 namespace pmon::util::log
 {
-	// TODO: DiagnosticMessage
+	// string storage embedded in a diagnostic message, text that does not fit is truncated
+	// and the truncation marked with a trailing ellipsis
+	template<size_t N>
+	class InlineText
+	{
+	public:
+		void Clear()
+		{
+			length_ = 0;
+			data_[0] = 0;
+		}
+		void Assign(std::string_view text)
+		{
+			Clear();
+			Append(text);
+		}
+		void Append(std::string_view text)
+		{
+			const auto room = N - 1 - length_;
+			const auto count = std::min(text.size(), room);
+			text.copy(data_ + length_, count);
+			length_ += count;
+			data_[length_] = 0;
+			if (count < text.size()) {
+				MarkTruncated_();
+			}
+		}
+		template<class... Args>
+		void AppendFormat(std::format_string<Args...> fmt, Args&&... args)
+		{
+			const auto room = N - 1 - length_;
+			const auto result = std::format_to_n(data_ + length_, room, fmt, std::forward<Args>(args)...);
+			const auto count = std::min(size_t(result.size), room);
+			length_ += count;
+			data_[length_] = 0;
+			if (count < size_t(result.size)) {
+				MarkTruncated_();
+			}
+		}
+		// null when empty, matching the optional string fields of PM_DIAGNOSTIC_MESSAGE
+		const char* CStrOrNull() const
+		{
+			return length_ ? data_ : nullptr;
+		}
+	private:
+		void MarkTruncated_()
+		{
+			for (size_t i = length_ - std::min<size_t>(length_, 3); i < length_; i++) {
+				data_[i] = '.';
+			}
+		}
+		size_t length_ = 0;
+		char data_[N] = {};
+	};
+
+	class DiagnosticMessagePool;
+
+	// diagnostic message with inline string buffers, recycled through a DiagnosticMessagePool
+	// instead of being allocated per message; the string pointers refer into the message itself
 	struct DiagnosticMessage : public PM_DIAGNOSTIC_MESSAGE
 	{
-		DiagnosticMessage(const PM_DIAGNOSTIC_MESSAGE& msg);
 		DiagnosticMessage();
+		DiagnosticMessage(const DiagnosticMessage&) = delete;
+		DiagnosticMessage& operator=(const DiagnosticMessage&) = delete;
+		// copy value fields and strings from a client-supplied message
+		void Assign(const PM_DIAGNOSTIC_MESSAGE& msg);
+		void Reset();
 		void SyncBuffers_();
-		std::string messageBuffer_;
-		std::string locationBuffer_;
-		std::string traceBuffer_;
-		std::string timestampBuffer_;
+		// return a message handed out by DiagnosticDriver::DequeueMessage to its pool
+		static void Free(PM_DIAGNOSTIC_MESSAGE* pMessage);
+		InlineText<1024> messageBuffer_;
+		InlineText<260> locationBuffer_;
+		InlineText<2048> traceBuffer_;
+		InlineText<64> timestampBuffer_;
+		// set while the message is lent to the client, keeps the pool alive even if the
+		// driver that queued the message has been replaced in the meantime
+		std::shared_ptr<DiagnosticMessagePool> pLender_;
+	};
+
+	// grows in slabs of messages and never shrinks, so steady-state traffic allocates nothing
+	class DiagnosticMessagePool
+	{
+	public:
+		struct Returner
+		{
+			void operator()(DiagnosticMessage* pMessage) const;
+			DiagnosticMessagePool* pPool = nullptr;
+		};
+		using Ptr = std::unique_ptr<DiagnosticMessage, Returner>;
+		Ptr Acquire();
+		void Release(DiagnosticMessage* pMessage);
+		size_t GetCapacity() const;
+		static constexpr size_t slabSize = 32;
+	private:
+		mutable std::mutex mtx_;
+		std::vector<std::unique_ptr<DiagnosticMessage[]>> slabs_;
+		std::vector<DiagnosticMessage*> free_;
 	};
 
 	struct DiagnosticConfig : public PM_DIAGNOSTIC_CONFIGURATION
@@ -36,19 +128,22 @@ namespace pmon::util::log
 		~DiagnosticDriver();
 		void Submit(const Entry&) override;
 		void Flush() override;
+		bool Accepts(const Entry&) const override;
 		uint32_t GetQueuedMessageCount();
 		uint32_t GetMaxQueuedMessages();
 		void SetMaxQueuedMessages(uint32_t);
 		uint32_t GetDiscardedMessageCount();
-		std::unique_ptr<DiagnosticMessage> DequeueMessage();
+		// the message is lent to the caller until passed to DiagnosticMessage::Free
+		DiagnosticMessage* DequeueMessage();
 		void EnqueueMessage(const PM_DIAGNOSTIC_MESSAGE* pMessage);
 		PM_DIAGNOSTIC_WAKE_REASON WaitForMessage(uint32_t timeoutMs);
 		void UnblockWaitingThread();
 
 	private:
 		// functions
-		void Enqueue_(std::unique_ptr<DiagnosticMessage> pMsg);
-		void ProcessCommon_(std::unique_ptr<DiagnosticMessage> pMsg);
+		void Enqueue_(DiagnosticMessagePool::Ptr pMsg);
+		void ProcessCommon_(DiagnosticMessagePool::Ptr pMsg);
+		void ResizeRing_(uint32_t capacity);
 		// data
 		DiagnosticConfig config_;
 		std::atomic<uint32_t> maxQueuedMessages_ = 256;
@@ -56,6 +151,11 @@ namespace pmon::util::log
 		win::Event messageWaitEvent_{ false };
 		win::Event manualUnblockEvent_{ false };
 		std::atomic<bool> dying_ = false;
-		moodycamel::ConcurrentQueue<std::unique_ptr<DiagnosticMessage>> messageQueue_;
+		std::shared_ptr<DiagnosticMessagePool> pPool_ = std::make_shared<DiagnosticMessagePool>();
+		// ring of queued messages, the oldest is overwritten when full
+		std::mutex ringMtx_;
+		std::vector<DiagnosticMessage*> ring_;
+		size_t ringHead_ = 0;
+		std::atomic<uint32_t> queuedCount_ = 0;
 	};
 }
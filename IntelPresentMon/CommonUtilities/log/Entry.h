@@ -50,6 +50,8 @@ namespace pmon::util::log
 		uint32_t tid_;
 		RateControl rateControl_;
 		int hitCount_ = -1;
+		// channel whose line filter drew hitCount_ in the submitting thread (nullptr when not pre-filtered)
+		const void* pHitChannel_ = nullptr;
 		bool diagnosticLayer_ = false;
 		// accessors
 		std::string GetSourceFileName() const
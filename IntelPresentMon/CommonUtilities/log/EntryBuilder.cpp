@@ -167,6 +167,11 @@ namespace pmon::util::log
 	{
 		try {
 			if (pDest_) {
+				// apply the channel's line filtering here so that dropped entries never capture a trace or hit the queue
+				if (!pDest_->PreFilter(*this)) {
+					committed_ = true;
+					return;
+				}
 				auto tracing = captureTrace_.value_or((int)level_ <= (int)GlobalPolicy::Get().GetTraceLevel());
 				// do line override check
 				if (LineTable::GetTraceOverride()) {
@@ -14,6 +14,9 @@ namespace pmon::util::log
 		virtual void Submit(Entry&&) noexcept = 0;
 		virtual void Submit(const Entry&) noexcept = 0;
 		virtual void Flush() = 0;
+		// called in the submitting thread before expensive payloads like the stack trace are captured
+		// returns false if the sink's policies would drop the entry
+		virtual bool PreFilter(Entry&) noexcept { return true; }
 	};
 
 	class IChannel : public IEntrySink
@@ -12,6 +12,8 @@ namespace pmon::util::log
 	public:
 		virtual void Submit(const Entry&) = 0;
 		virtual void Flush() = 0;
+		// returns false if the driver would discard the entry without outputting it
+		virtual bool Accepts(const Entry&) const { return true; }
 	};
 
 	class ITextDriver : public IDriver
@@ -6,6 +6,15 @@
 namespace pmon::util::log
 {
 	bool LinePolicy::TransformFilter(Entry& e)
+	{
+		// entries filtered in the submitting thread have already drawn their hit; rate control
+		// is decided again on that hit rather than counting the line a second time
+		if (e.rateControl_.type != Entry::RateControl::Type::None && e.hitCount_ != -1) {
+			return PassesRateControl_(e);
+		}
+		return Filter(e);
+	}
+	bool LinePolicy::Filter(Entry& e)
 	{
 		LineTable::Entry* pEntry = nullptr;
 		const auto listMode = LineTable::GetListMode();
@@ -26,24 +35,34 @@ namespace pmon::util::log
 				}
 			}
 		}
+		// rate control only counts hits of entries that passed listing
 		if (e.rateControl_.type != Entry::RateControl::Type::None) {
-			// lookup the line entry, use previous lookup results if available from list processing
-			auto& te = pEntry ? *pEntry : LineTable::Lookup(e.GetSourceFileName(), e.sourceLine_);
-			e.hitCount_ = te.NextHit();
-			switch (e.rateControl_.type) {
-			case Entry::RateControl::Type::After:
-				if (e.hitCount_ <= e.rateControl_.parameter) return false;
-				break;
-			case Entry::RateControl::Type::Every:
-				if (e.hitCount_ % e.rateControl_.parameter) return false;
-				break;
-			case Entry::RateControl::Type::EveryAndFirst:
-				if ((e.hitCount_ - 1) % e.rateControl_.parameter) return false;
-				break;
-			case Entry::RateControl::Type::First:
-				if (e.hitCount_ > e.rateControl_.parameter) return false;
-				break;
-			}
+			return ApplyRateControl_(e, pEntry);
+		}
+		return true;
+	}
+	bool LinePolicy::ApplyRateControl_(Entry& e, LineTable::Entry* pLineEntry) noexcept
+	{
+		// lookup the line entry, use previous lookup results if available from list processing
+		auto& te = pLineEntry ? *pLineEntry : LineTable::Lookup(e.GetSourceFileName(), e.sourceLine_);
+		e.hitCount_ = te.NextHit();
+		return PassesRateControl_(e);
+	}
+	bool LinePolicy::PassesRateControl_(const Entry& e) noexcept
+	{
+		switch (e.rateControl_.type) {
+		case Entry::RateControl::Type::After:
+			if (e.hitCount_ <= e.rateControl_.parameter) return false;
+			break;
+		case Entry::RateControl::Type::Every:
+			if (e.hitCount_ % e.rateControl_.parameter) return false;
+			break;
+		case Entry::RateControl::Type::EveryAndFirst:
+			if ((e.hitCount_ - 1) % e.rateControl_.parameter) return false;
+			break;
+		case Entry::RateControl::Type::First:
+			if (e.hitCount_ > e.rateControl_.parameter) return false;
+			break;
 		}
 		return true;
 	}
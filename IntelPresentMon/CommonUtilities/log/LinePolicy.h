@@ -1,5 +1,6 @@
 #pragma once
 #include "IPolicy.h"
+#include "LineTable.h"
 
 namespace pmon::util::log
 {
@@ -8,5 +9,14 @@ namespace pmon::util::log
 	{
 	public:
 		bool TransformFilter(Entry& e) override;
+		// apply listing and then rate control, return false if the entry is dropped
+		// called by the channel in the submitting thread before trace capture, and sets hitCount_
+		// for rate controlled entries so that the line's hit is not counted twice
+		static bool Filter(Entry& e);
+	private:
+		// advance hit count for the entry's line and return false if rate control drops it
+		static bool ApplyRateControl_(Entry& e, LineTable::Entry* pLineEntry) noexcept;
+		// rate control decision for the hit already drawn in hitCount_
+		static bool PassesRateControl_(const Entry& e) noexcept;
 	};
 }
@@ -1,14 +1,16 @@
 #include "StackTrace.h"
+#include "StackTraceCache.h"
 #include "../str/String.h"
+#include "../Hash.h"
 #include <ranges>
-#include <sstream>
 #include "PanicLogger.h"
 
 namespace pmon::util::log
 {
 	StackTrace::StackTrace(std::stacktrace trace)
 		:
-		trace_{ std::move(trace) }
+		trace_{ std::move(trace) },
+		hash_{ HashFrames(trace_) }
 	{}
 	void StackTrace::Resolve()
 	{
@@ -16,24 +18,20 @@ namespace pmon::util::log
 			pmlog_panic_("Resolving empty trace");
 			return;
 		}
-		else if (!frames_.empty()) {
+		else if (pFrames_) {
 			pmlog_panic_("Resolving when already resolved");
 			return;
 		}
-		frames_.reserve(trace_.size());
-		for (auto&& [i, f] : std::views::zip(std::views::iota(0), trace_)) {
-			frames_.push_back(FrameInfo{
-				.description = f.description(),
-				.file = f.source_file(),
-				.line = (int)f.source_line(),
-				.index = i,
-			});
-		}
+		// symbolization is expensive; unique traces are resolved once and shared via the cache
+		pFrames_ = StackTraceCache::Get().Resolve(hash_, trace_);
 	}
 	StackTrace::StackTrace(const StackTrace& other)
+		:
+		hash_{ other.hash_ },
+		repeat_{ other.repeat_ }
 	{
 		if (other.Resolved()) {
-			frames_ = other.frames_;
+			pFrames_ = other.pFrames_;
 		}
 		else {
 			trace_ = other.trace_;
@@ -41,37 +39,46 @@ namespace pmon::util::log
 	}
 	std::span<const StackTrace::FrameInfo> StackTrace::GetFrames() const
 	{
-		if (frames_.empty()) {
+		if (!pFrames_) {
 			pmlog_panic_("Getting frames from and unresolved/empty stack trace.");
+			return {};
 		}
-		return frames_;
+		return *pFrames_;
 	}
 	bool StackTrace::Empty() const
 	{
-		return trace_.empty() && frames_.empty();
+		return trace_.empty() && !pFrames_;
 	}
 	bool StackTrace::Resolved() const
 	{
-		return !frames_.empty();
+		return bool(pFrames_);
+	}
+	size_t StackTrace::GetHash() const
+	{
+		return hash_;
+	}
+	void StackTrace::SetRepeat(bool repeat)
+	{
+		repeat_ = repeat;
+	}
+	bool StackTrace::IsRepeat() const
+	{
+		return repeat_;
 	}
 	std::string StackTrace::ToString() const
 	{
-		std::ostringstream oss;
-		if (Resolved()) {
-			for (auto& f : GetFrames()) {
-				oss << "  [" << f.index << "] " << f.description << "\n";
-				if (f.line != 0 || !f.file.empty()) {
-					oss << "    > " << f.file << '(' << f.line << ")\n";
-				}
-			}
-		}
-		else {
-			oss << "\n   !! UNRESOLVED STACK TRACE !!\n\n";
-		}
-		return oss.str();
+		return std::format("{}", *this);
 	}
 	std::unique_ptr<StackTrace> StackTrace::Here(size_t skip)
 	{
 		return std::make_unique<StackTrace>(std::stacktrace::current(skip));
 	}
-}
\ No newline at end of file
+	size_t StackTrace::HashFrames(const std::stacktrace& trace)
+	{
+		size_t hash = trace.size();
+		for (auto& f : trace) {
+			hash = hash::HashCombine(hash, std::hash<uintptr_t>{}((uintptr_t)f.native_handle()));
+		}
+		return hash;
+	}
+}
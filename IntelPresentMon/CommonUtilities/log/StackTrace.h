@@ -4,6 +4,7 @@
 #include <stacktrace>
 #include <span>
 #include <memory>
+#include <format>
 
 namespace pmon::util::log
 {
@@ -31,10 +32,47 @@ namespace pmon::util::log
 		std::span<const FrameInfo> GetFrames() const;
 		bool Empty() const;
 		bool Resolved() const;
+		// hash of the raw frame addresses, identifies the unique call stack without resolving symbols
+		size_t GetHash() const;
+		// marks this trace as a repeat of a trace that has already been emitted in full
+		void SetRepeat(bool repeat);
+		bool IsRepeat() const;
+		// same text as std::format("{}", trace), see the formatter below
 		std::string ToString() const;
 		static std::unique_ptr<StackTrace> Here(size_t skip = 0);
+		// compute the frame address hash of a raw stacktrace
+		static size_t HashFrames(const std::stacktrace& trace);
 	private:
 		std::stacktrace trace_;
-		std::vector<FrameInfo> frames_;
+		// resolved frames are immutable and shared with the StackTraceCache and with copies
+		std::shared_ptr<const std::vector<FrameInfo>> pFrames_;
+		size_t hash_ = 0;
+		bool repeat_ = false;
 	};
-}
\ No newline at end of file
+}
+
+// one frame per line with its source location, so that a trace can be formatted straight into
+// fixed size buffers (e.g. with std::format_to_n) as well as into strings
+template<>
+struct std::formatter<pmon::util::log::StackTrace>
+{
+	constexpr auto parse(std::format_parse_context& ctx)
+	{
+		return ctx.begin();
+	}
+	template<class FormatContext>
+	auto format(const pmon::util::log::StackTrace& trace, FormatContext& ctx) const
+	{
+		auto out = ctx.out();
+		if (!trace.Resolved()) {
+			return std::format_to(out, "\n   !! UNRESOLVED STACK TRACE !!\n\n");
+		}
+		for (auto& f : trace.GetFrames()) {
+			out = std::format_to(out, "  [{}] {}\n", f.index, f.description);
+			if (f.line != 0 || !f.file.empty()) {
+				out = std::format_to(out, "    > {}({})\n", f.file, f.line);
+			}
+		}
+		return out;
+	}
+};
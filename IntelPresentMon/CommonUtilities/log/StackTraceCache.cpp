@@ -0,0 +1,103 @@
+#include "StackTraceCache.h"
+#include <ranges>
+
+namespace pmon::util::log
+{
+	StackTraceCache::StackTraceCache(size_t capacity)
+		:
+		capacity_{ capacity }
+	{}
+	std::shared_ptr<const StackTraceCache::Frames> StackTraceCache::Resolve(size_t hash, const std::stacktrace& trace)
+	{
+		{
+			std::lock_guard lk{ mtx_ };
+			if (auto i = index_.find(hash); i != index_.end()) {
+				if (i->second->trace == trace) {
+					// bump to most recently used
+					lru_.splice(lru_.begin(), lru_, i->second);
+					hits_++;
+					return i->second->pFrames;
+				}
+				collisions_++;
+			}
+		}
+		misses_++;
+		// symbolize outside of the lock; in the rare case of two threads missing on the same
+		// trace simultaneously, both will resolve and the later insert is discarded
+		auto pFrames = Symbolize(trace);
+		std::lock_guard lk{ mtx_ };
+		if (capacity_ == 0) {
+			return pFrames;
+		}
+		if (auto i = index_.find(hash); i != index_.end()) {
+			if (i->second->trace == trace) {
+				return i->second->pFrames;
+			}
+			// colliding trace replaces the cached one
+			lru_.erase(i->second);
+			index_.erase(i);
+		}
+		lru_.push_front(Node_{ hash, trace, pFrames });
+		index_.emplace(hash, lru_.begin());
+		TrimToCapacity_();
+		return pFrames;
+	}
+	void StackTraceCache::SetCapacity(size_t capacity)
+	{
+		std::lock_guard lk{ mtx_ };
+		capacity_ = capacity;
+		TrimToCapacity_();
+	}
+	size_t StackTraceCache::GetCapacity() const
+	{
+		std::lock_guard lk{ mtx_ };
+		return capacity_;
+	}
+	size_t StackTraceCache::GetSize() const
+	{
+		std::lock_guard lk{ mtx_ };
+		return index_.size();
+	}
+	StackTraceCache::Stats StackTraceCache::GetStats() const
+	{
+		return { .hits = hits_, .misses = misses_, .evictions = evictions_, .collisions = collisions_ };
+	}
+	void StackTraceCache::Clear()
+	{
+		std::lock_guard lk{ mtx_ };
+		lru_.clear();
+		index_.clear();
+		hits_ = 0;
+		misses_ = 0;
+		evictions_ = 0;
+		collisions_ = 0;
+	}
+	std::shared_ptr<const StackTraceCache::Frames> StackTraceCache::Symbolize(const std::stacktrace& trace)
+	{
+		auto pFrames = std::make_shared<Frames>();
+		pFrames->reserve(trace.size());
+		for (auto&& [i, f] : std::views::zip(std::views::iota(0), trace)) {
+			pFrames->push_back(StackTrace::FrameInfo{
+				.description = f.description(),
+				.file = f.source_file(),
+				.line = (int)f.source_line(),
+				.index = i,
+			});
+		}
+		return pFrames;
+	}
+	StackTraceCache& StackTraceCache::Get()
+	{
+		// @SINGLETON
+		static StackTraceCache cache;
+		return cache;
+	}
+	void StackTraceCache::TrimToCapacity_()
+	{
+		while (index_.size() > capacity_) {
+			index_.erase(lru_.back().hash);
+			lru_.pop_back();
+			evictions_++;
+		}
+	}
+}
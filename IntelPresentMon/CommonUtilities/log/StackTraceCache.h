@@ -0,0 +1,63 @@
+#pragma once
+#include "StackTrace.h"
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+namespace pmon::util::log
+{
+	// bounded LRU cache of resolved stack traces, keyed on the hash of raw frame addresses
+	// ensures that each unique call stack is symbolized at most once while it remains cached
+	// the raw frames are kept with each entry so that a hash collision is never served the wrong trace
+	class StackTraceCache
+	{
+	public:
+		// types
+		using Frames = std::vector<StackTrace::FrameInfo>;
+		struct Stats
+		{
+			size_t hits;
+			size_t misses;
+			size_t evictions;
+			// misses where the hash was cached for different raw frames
+			size_t collisions;
+		};
+		// functions
+		StackTraceCache(size_t capacity = defaultCapacity_);
+		StackTraceCache(const StackTraceCache&) = delete;
+		StackTraceCache& operator=(const StackTraceCache&) = delete;
+		// return cached frames for hash if they were resolved from the same raw frames,
+		// otherwise symbolize trace and insert it (replacing a colliding entry)
+		std::shared_ptr<const Frames> Resolve(size_t hash, const std::stacktrace& trace);
+		// set to 0 to disable caching (every resolve symbolizes)
+		void SetCapacity(size_t capacity);
+		size_t GetCapacity() const;
+		size_t GetSize() const;
+		Stats GetStats() const;
+		void Clear();
+		static std::shared_ptr<const Frames> Symbolize(const std::stacktrace& trace);
+		static StackTraceCache& Get();
+	private:
+		// types
+		struct Node_
+		{
+			size_t hash;
+			std::stacktrace trace;
+			std::shared_ptr<const Frames> pFrames;
+		};
+		// functions
+		void TrimToCapacity_();
+		// data
+		static constexpr size_t defaultCapacity_ = 256;
+		mutable std::mutex mtx_;
+		size_t capacity_;
+		// most recently used at front
+		std::list<Node_> lru_;
+		std::unordered_map<size_t, std::list<Node_>::iterator> index_;
+		std::atomic<size_t> hits_ = 0;
+		std::atomic<size_t> misses_ = 0;
+		std::atomic<size_t> evictions_ = 0;
+		std::atomic<size_t> collisions_ = 0;
+	};
+}
@@ -16,7 +16,22 @@ namespace pmon::util::log
 		template<class Archive>
 		static void Serialize(Archive& ar, StackTrace& trace)
 		{
-			ar(trace.frames_);
+			if constexpr (Archive::is_saving::value) {
+				if (trace.pFrames_) {
+					ar(*trace.pFrames_);
+				}
+				else {
+					ar(std::vector<StackTrace::FrameInfo>{});
+				}
+			}
+			else {
+				std::vector<StackTrace::FrameInfo> frames;
+				ar(frames);
+				if (!frames.empty()) {
+					trace.pFrames_ = std::make_shared<const std::vector<StackTrace::FrameInfo>>(std::move(frames));
+				}
+			}
+			ar(trace.hash_, trace.repeat_);
 		}
 	};
 
@@ -25,4 +40,4 @@ namespace pmon::util::log
 	{
 		StackTraceCereal::Serialize(ar, trace);
 	}
-}
\ No newline at end of file
+}
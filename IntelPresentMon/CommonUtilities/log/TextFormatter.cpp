@@ -74,9 +74,15 @@ namespace pmon::util::log
 			}
 			if (e.pTrace_) {
 				try {
-					oss << " ====== STACK TRACE (newest on top) ======\n";
-					oss << e.pTrace_->ToString();
-					oss << " =========================================\n";
+					// traces already emitted in full on this channel are printed as a reference by id
+					if (e.pTrace_->IsRepeat()) {
+						oss << std::format(" ====== STACK TRACE [{:016X}] (repeat, see above) ======\n", e.pTrace_->GetHash());
+					}
+					else {
+						oss << std::format(" ====== STACK TRACE [{:016X}] (newest on top) ======\n", e.pTrace_->GetHash());
+						oss << e.pTrace_->ToString();
+						oss << " =========================================\n";
+					}
 				}
 				catch (...) {
 					pmlog_panic_("Failed printing stack trace in TextFormatter::Format");
@@ -0,0 +1,318 @@
+#include "PeriodicScheduler.h"
+#include "../win/WinAPI.h"
+#include "../log/Log.h"
+#include "../Exception.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+
+namespace pmon::util::mt
+{
+	PeriodicScheduler::PeriodicScheduler(std::string threadName, double tickSeconds, double waitBuffer)
+		:
+		tickSeconds_{ tickSeconds },
+		waitBuffer_{ waitBuffer }
+	{
+		waitableTimer_ = win::Handle(CreateWaitableTimerExW(
+			nullptr,
+			nullptr,
+			CREATE_WAITABLE_TIMER_HIGH_RESOLUTION,
+			TIMER_ALL_ACCESS
+		));
+		if (!waitableTimer_) {
+			pmlog_error("Failed creating high resolution timer, falling back to event timeouts").hr();
+		}
+		thread_ = Thread{ std::move(threadName), &PeriodicScheduler::Run_, this };
+	}
+
+	PeriodicScheduler::~PeriodicScheduler()
+	{
+		Stop();
+	}
+
+	PeriodicScheduler::TaskId PeriodicScheduler::AddTask(std::string name, double periodSeconds,
+		std::function<void()> task, bool enabled)
+	{
+		std::lock_guard lk{ mtx_ };
+		const auto id = nextId_++;
+		auto pTask = std::make_shared<Task_>(Task_{
+			.name = std::move(name),
+			.function = std::move(task),
+			.period = periodSeconds,
+		});
+		if (enabled) {
+			pTask->enabled = true;
+			pTask->deadline = timer_.Peek();
+			Schedule_(id, *pTask);
+			wakeEvent_.Set();
+		}
+		tasks_.emplace(id, std::move(pTask));
+		return id;
+	}
+
+	void PeriodicScheduler::RemoveTask(TaskId id)
+	{
+		std::lock_guard lk{ mtx_ };
+		// wheel entries of the removed task are discarded lazily as stale
+		tasks_.erase(id);
+	}
+
+	void PeriodicScheduler::SetPeriod(TaskId id, double periodSeconds)
+	{
+		std::lock_guard lk{ mtx_ };
+		auto& task = GetTask_(id);
+		if (task.period == periodSeconds) {
+			return;
+		}
+		task.period = periodSeconds;
+		if (task.enabled) {
+			// keep the phase of the previous run so that a period change does not cause a burst or a gap
+			if (task.lastDeadline) {
+				task.generation++;
+				task.deadline = std::max(*task.lastDeadline + periodSeconds, timer_.Peek());
+				Schedule_(id, task);
+				wakeEvent_.Set();
+			}
+		}
+	}
+
+	void PeriodicScheduler::SetEnabled(TaskId id, bool enabled)
+	{
+		std::lock_guard lk{ mtx_ };
+		auto& task = GetTask_(id);
+		if (task.enabled == enabled) {
+			return;
+		}
+		task.enabled = enabled;
+		task.generation++;
+		task.lastDeadline.reset();
+		if (enabled) {
+			task.deadline = timer_.Peek();
+			Schedule_(id, task);
+			wakeEvent_.Set();
+		}
+	}
+
+	bool PeriodicScheduler::IsEnabled(TaskId id) const
+	{
+		std::lock_guard lk{ mtx_ };
+		return GetTask_(id).enabled;
+	}
+
+	PeriodicScheduler::TaskStats PeriodicScheduler::GetStats(TaskId id) const
+	{
+		std::lock_guard lk{ mtx_ };
+		return GetTask_(id).stats;
+	}
+
+	void PeriodicScheduler::Stop()
+	{
+		{
+			std::lock_guard lk{ mtx_ };
+			stopping_ = true;
+		}
+		wakeEvent_.Set();
+		if (thread_.joinable()) {
+			thread_.join();
+		}
+	}
+
+	void PeriodicScheduler::Run_()
+	{
+		std::vector<Ready_> ready;
+		std::unique_lock lk{ mtx_ };
+		while (!stopping_) {
+			ready.clear();
+			CollectDue_(timer_.Peek(), ready);
+			if (ready.empty()) {
+				const auto next = NextDeadline_();
+				lk.unlock();
+				Wait_(next);
+				lk.lock();
+				continue;
+			}
+			// tasks that came due together run in deadline order
+			std::ranges::sort(ready, {}, &Ready_::deadline);
+			for (auto& r : ready) {
+				if (stopping_) {
+					break;
+				}
+				// an earlier task in this batch may have disabled or rescheduled this one
+				if (!r.pTask->enabled || r.pTask->generation != r.generation) {
+					continue;
+				}
+				lk.unlock();
+				// task functions are immutable after registration, so they are safe to call unlocked
+				const auto start = timer_.Peek();
+				try {
+					r.pTask->function();
+				}
+				catch (...) {
+					pmlog_error(ReportException()).pmwatch(r.pTask->name);
+				}
+				const auto end = timer_.Peek();
+				lk.lock();
+				auto& task = *r.pTask;
+				auto& stats = task.stats;
+				const auto lateness = std::max(start - r.deadline, 0.);
+				stats.runCount++;
+				stats.totalLateness += lateness;
+				stats.maxLateness = std::max(stats.maxLateness, lateness);
+				stats.totalRunTime += end - start;
+				// task was disabled, removed or rescheduled while it was running
+				if (!task.enabled || task.generation != r.generation) {
+					continue;
+				}
+				// fixed cadence; when a run overshoots an entire period, restart the cadence from now
+				task.deadline = std::max(r.deadline + task.period, end);
+				Schedule_(r.id, task);
+			}
+		}
+	}
+
+	void PeriodicScheduler::Wait_(std::optional<double> deadline)
+	{
+		if (!deadline) {
+			WaitForSingleObject(wakeEvent_, INFINITE);
+			return;
+		}
+		const auto remaining = *deadline - timer_.Peek();
+		if (remaining > waitBuffer_) {
+			// wait slightly (buffer seconds) shorter than required to compensate for overwait error
+			bool timerSet = false;
+			if (waitableTimer_) {
+				const LARGE_INTEGER waitTime100ns{
+					.QuadPart = -LONGLONG((remaining - waitBuffer_) * 10'000'000.)
+				};
+				timerSet = SetWaitableTimerEx(waitableTimer_, &waitTime100ns, 0, nullptr, nullptr, nullptr, 0);
+				if (!timerSet) {
+					pmlog_error("Failed setting high resolution timer").hr().every(100);
+				}
+			}
+			DWORD waitResult;
+			if (timerSet) {
+				const HANDLE handles[]{ wakeEvent_, waitableTimer_ };
+				waitResult = WaitForMultipleObjects((DWORD)std::size(handles), handles, FALSE, INFINITE);
+			}
+			else {
+				waitResult = WaitForSingleObject(wakeEvent_, DWORD((remaining - waitBuffer_) * 1000.));
+			}
+			// woken because the task set changed, the deadline must be recomputed
+			if (waitResult == WAIT_OBJECT_0) {
+				return;
+			}
+		}
+		// spin wait for the remainder buffer time
+		timer_.SpinWaitUntil(*deadline);
+	}
+
+	void PeriodicScheduler::Schedule_(TaskId id, Task_& task)
+	{
+		// deadlines already passed go into the slot under the cursor so that they are collected next pass
+		const auto tick = std::max(TickOf_(task.deadline), cursorTick_);
+		const auto slot = size_t(tick) & slotMask_;
+		slots_[slot].push_back(Entry_{ .id = id, .generation = task.generation, .tick = tick });
+		occupancy_[slot / 64] |= 1ull << (slot % 64);
+	}
+
+	void PeriodicScheduler::CollectDue_(double now, std::vector<Ready_>& ready)
+	{
+		const auto nowTick = TickOf_(now);
+		// visit each slot from the cursor up to now, at most one revolution (which visits every slot)
+		const auto lastTick = std::min(nowTick, cursorTick_ + int64_t(slotCount_) - 1);
+		for (auto tick = cursorTick_; tick <= lastTick; tick++) {
+			const auto slot = size_t(tick) & slotMask_;
+			if (!(occupancy_[slot / 64] & (1ull << (slot % 64)))) {
+				continue;
+			}
+			auto& entries = slots_[slot];
+			std::erase_if(entries, [&](const Entry_& e) {
+				auto i = tasks_.find(e.id);
+				if (i == tasks_.end()) {
+					return true;
+				}
+				auto& task = *i->second;
+				if (!task.enabled || task.generation != e.generation) {
+					return true;
+				}
+				// entry belongs to a later revolution, or is due later within the current tick
+				if (e.tick > nowTick || task.deadline > now) {
+					return false;
+				}
+				task.lastDeadline = task.deadline;
+				ready.push_back(Ready_{ .id = e.id, .pTask = i->second, .generation = e.generation, .deadline = task.deadline });
+				return true;
+			});
+			if (entries.empty()) {
+				occupancy_[slot / 64] &= ~(1ull << (slot % 64));
+			}
+		}
+		cursorTick_ = std::max(cursorTick_, nowTick);
+	}
+
+	std::optional<double> PeriodicScheduler::NextDeadline_() const
+	{
+		// the first occupied slot (from the cursor) holding a live entry due in this revolution has the next deadline
+		const auto endTick = cursorTick_ + int64_t(slotCount_);
+		for (auto tick = cursorTick_; tick < endTick;) {
+			const auto slot = size_t(tick) & slotMask_;
+			const auto bits = occupancy_[slot / 64] >> (slot % 64);
+			if (!bits) {
+				// skip to the start of the next occupancy word
+				tick += int64_t(64 - slot % 64);
+				continue;
+			}
+			tick += std::countr_zero(bits);
+			if (tick >= endTick) {
+				break;
+			}
+			std::optional<double> next;
+			for (auto& e : slots_[size_t(tick) & slotMask_]) {
+				if (e.tick != tick) {
+					continue;
+				}
+				if (auto pTask = GetCurrent_(e)) {
+					next = std::min(next.value_or(pTask->deadline), pTask->deadline);
+				}
+			}
+			if (next) {
+				return next;
+			}
+			tick++;
+		}
+		// nothing due within a revolution (only periods longer than the wheel span), fall back to a full scan
+		std::optional<double> next;
+		for (auto& entries : slots_) {
+			for (auto& e : entries) {
+				if (auto pTask = GetCurrent_(e)) {
+					next = std::min(next.value_or(pTask->deadline), pTask->deadline);
+				}
+			}
+		}
+		return next;
+	}
+
+	const PeriodicScheduler::Task_* PeriodicScheduler::GetCurrent_(const Entry_& entry) const
+	{
+		if (auto i = tasks_.find(entry.id); i != tasks_.end()) {
+			if (i->second->enabled && i->second->generation == entry.generation) {
+				return i->second.get();
+			}
+		}
+		return nullptr;
+	}
+
+	PeriodicScheduler::Task_& PeriodicScheduler::GetTask_(TaskId id) const
+	{
+		if (auto i = tasks_.find(id); i != tasks_.end()) {
+			return *i->second;
+		}
+		throw Except<Exception>("Periodic task id not found");
+	}
+
+	int64_t PeriodicScheduler::TickOf_(double seconds) const
+	{
+		return int64_t(std::floor(seconds / tickSeconds_));
+	}
+}
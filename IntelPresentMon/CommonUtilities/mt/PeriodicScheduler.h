@@ -0,0 +1,106 @@
+#pragma once
+#include "Thread.h"
+#include "../Qpc.h"
+#include "../PrecisionWaiter.h"
+#include "../win/Event.h"
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <array>
+#include <cstdint>
+
+namespace pmon::util::mt
+{
+	// runs periodic tasks on a single thread, each task having its own period and enabled state
+	// pending deadlines are bucketed into a hashed timer wheel, so finding and firing due tasks does not
+	// require scanning every registered task; waits until the next deadline use a high resolution waitable
+	// timer followed by a short spin, and are interrupted whenever tasks are added or changed
+	class PeriodicScheduler
+	{
+	public:
+		// types
+		using TaskId = uint32_t;
+		struct TaskStats
+		{
+			uint64_t runCount = 0;
+			// lateness is the time between the deadline of a run and when it actually started
+			double totalLateness = 0.;
+			double maxLateness = 0.;
+			double totalRunTime = 0.;
+		};
+		// functions
+		PeriodicScheduler(std::string threadName, double tickSeconds = 0.001,
+			double waitBuffer = PrecisionWaiter::standardWaitBuffer);
+		PeriodicScheduler(const PeriodicScheduler&) = delete;
+		PeriodicScheduler& operator=(const PeriodicScheduler&) = delete;
+		PeriodicScheduler(PeriodicScheduler&&) = delete;
+		PeriodicScheduler& operator=(PeriodicScheduler&&) = delete;
+		~PeriodicScheduler();
+		// tasks are run on the scheduler thread and may call back into the scheduler
+		// a task is run immediately when enabled, and then once per period until disabled
+		TaskId AddTask(std::string name, double periodSeconds, std::function<void()> task, bool enabled = false);
+		void RemoveTask(TaskId id);
+		void SetPeriod(TaskId id, double periodSeconds);
+		void SetEnabled(TaskId id, bool enabled);
+		bool IsEnabled(TaskId id) const;
+		TaskStats GetStats(TaskId id) const;
+		// stops and joins the scheduler thread; no task will start after this returns
+		void Stop();
+	private:
+		// types
+		struct Task_
+		{
+			std::string name;
+			std::function<void()> function;
+			double period;
+			bool enabled = false;
+			// bumped whenever the pending deadline is invalidated, wheel entries of old generations are stale
+			uint32_t generation = 0;
+			double deadline = 0.;
+			std::optional<double> lastDeadline;
+			TaskStats stats;
+		};
+		struct Entry_
+		{
+			TaskId id;
+			uint32_t generation;
+			int64_t tick;
+		};
+		struct Ready_
+		{
+			TaskId id;
+			std::shared_ptr<Task_> pTask;
+			uint32_t generation;
+			double deadline;
+		};
+		// functions
+		void Run_();
+		void Wait_(std::optional<double> deadline);
+		void Schedule_(TaskId id, Task_& task);
+		void CollectDue_(double now, std::vector<Ready_>& ready);
+		std::optional<double> NextDeadline_() const;
+		const Task_* GetCurrent_(const Entry_& entry) const;
+		Task_& GetTask_(TaskId id) const;
+		int64_t TickOf_(double seconds) const;
+		// data
+		static constexpr size_t slotCount_ = 1024;
+		static constexpr size_t slotMask_ = slotCount_ - 1;
+		mutable std::mutex mtx_;
+		double tickSeconds_;
+		double waitBuffer_;
+		QpcTimer timer_;
+		std::unordered_map<TaskId, std::shared_ptr<Task_>> tasks_;
+		TaskId nextId_ = 0;
+		std::array<std::vector<Entry_>, slotCount_> slots_;
+		std::array<uint64_t, slotCount_ / 64> occupancy_{};
+		int64_t cursorTick_ = 0;
+		bool stopping_ = false;
+		win::Event wakeEvent_{ false };
+		win::Handle waitableTimer_;
+		Thread thread_;
+	};
+}
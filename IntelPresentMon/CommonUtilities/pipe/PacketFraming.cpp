@@ -0,0 +1,138 @@
+#include "PacketFraming.h"
+#include <algorithm>
+
+namespace pmon::util::pipe
+{
+	PacketBuffer::PacketBuffer(size_t initialCapacity)
+	{
+		storage_.resize(initialCapacity);
+	}
+	void PacketBuffer::Clear() noexcept
+	{
+		readPos_ = 0;
+		writePos_ = 0;
+	}
+	size_t PacketBuffer::Size() const noexcept
+	{
+		return writePos_ - readPos_;
+	}
+	size_t PacketBuffer::Capacity() const noexcept
+	{
+		return storage_.size();
+	}
+	std::span<const std::byte> PacketBuffer::Data() const noexcept
+	{
+		return { storage_.data() + readPos_, Size() };
+	}
+	std::span<std::byte> PacketBuffer::Prepare(size_t n)
+	{
+		Reserve_(n);
+		const std::span<std::byte> region{ storage_.data() + writePos_, n };
+		writePos_ += n;
+		return region;
+	}
+	void PacketBuffer::Consume(size_t n) noexcept
+	{
+		readPos_ += std::min(n, Size());
+		// rewind when drained so that the buffer never creeps forward
+		if (readPos_ == writePos_) {
+			Clear();
+		}
+	}
+	void PacketBuffer::Write(const void* pData, size_t n)
+	{
+		if (n) {
+			std::memcpy(Prepare(n).data(), pData, n);
+		}
+	}
+	size_t PacketBuffer::Read(void* pData, size_t n) noexcept
+	{
+		n = std::min(n, Size());
+		if (n) {
+			std::memcpy(pData, storage_.data() + readPos_, n);
+			Consume(n);
+		}
+		return n;
+	}
+	std::streamsize PacketBuffer::xsputn(const char* s, std::streamsize n)
+	{
+		Write(s, size_t(n));
+		return n;
+	}
+	PacketBuffer::int_type PacketBuffer::overflow(int_type ch)
+	{
+		if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+			const auto c = traits_type::to_char_type(ch);
+			Write(&c, 1);
+		}
+		return traits_type::not_eof(ch);
+	}
+	std::streamsize PacketBuffer::xsgetn(char* s, std::streamsize n)
+	{
+		return std::streamsize(Read(s, size_t(n)));
+	}
+	PacketBuffer::int_type PacketBuffer::underflow()
+	{
+		if (Size() == 0) {
+			return traits_type::eof();
+		}
+		return traits_type::to_int_type((char)storage_[readPos_]);
+	}
+	PacketBuffer::int_type PacketBuffer::uflow()
+	{
+		const auto ch = underflow();
+		if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+			Consume(1);
+		}
+		return ch;
+	}
+	void PacketBuffer::Reserve_(size_t n)
+	{
+		const auto required = writePos_ + n;
+		if (required > storage_.size()) {
+			// compact unconsumed data to the front before growing
+			if (readPos_ > 0) {
+				std::copy(storage_.begin() + readPos_, storage_.begin() + writePos_, storage_.begin());
+				writePos_ -= readPos_;
+				readPos_ = 0;
+				if (writePos_ + n <= storage_.size()) {
+					return;
+				}
+			}
+			storage_.resize(std::max(writePos_ + n, storage_.size() * 2));
+		}
+	}
+
+
+	PacketCodec::PacketCodec()
+		:
+		readStream_{ &readBuf_ },
+		readArchive_{ readStream_ },
+		writeStream_{ &writeBuf_ },
+		writeArchive_{ writeStream_ }
+	{}
+	std::span<const std::byte> PacketCodec::GetEncodedPayload() const noexcept
+	{
+		return writeBuf_.Data();
+	}
+	size_t PacketCodec::GetEncodedSize() const noexcept
+	{
+		return writeBuf_.Size();
+	}
+	void PacketCodec::ClearEncoded() noexcept
+	{
+		writeBuf_.Clear();
+	}
+	std::span<std::byte> PacketCodec::PrepareDecode(size_t payloadSize)
+	{
+		return readBuf_.Prepare(payloadSize);
+	}
+	size_t PacketCodec::GetPendingDecodeSize() const noexcept
+	{
+		return readBuf_.Size();
+	}
+	void PacketCodec::ClearDecode() noexcept
+	{
+		readBuf_.Clear();
+	}
+}
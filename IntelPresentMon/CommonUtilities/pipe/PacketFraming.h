@@ -0,0 +1,160 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <span>
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <streambuf>
+#include <type_traits>
+#include <istream>
+#include <ostream>
+#include <cereal/archives/binary.hpp>
+
+namespace pmon::util::pipe
+{
+	// growable byte buffer that retains its capacity between packets so that steady-state
+	// packet traffic does not allocate; also acts as a streambuf for cereal archives
+	// (cereal binary archives only use sputn / sgetn, which map to xsputn / xsgetn here)
+	class PacketBuffer : public std::streambuf
+	{
+	public:
+		PacketBuffer(size_t initialCapacity = 4096);
+		PacketBuffer(const PacketBuffer&) = delete;
+		PacketBuffer& operator=(const PacketBuffer&) = delete;
+		// discard all content, retaining capacity
+		void Clear() noexcept;
+		// number of bytes written and not yet consumed
+		size_t Size() const noexcept;
+		size_t Capacity() const noexcept;
+		// view of bytes written and not yet consumed
+		std::span<const std::byte> Data() const noexcept;
+		// extend the written region by n bytes and return it for direct filling (e.g. by a transport read)
+		std::span<std::byte> Prepare(size_t n);
+		// mark n bytes from the front of the unconsumed region as consumed
+		void Consume(size_t n) noexcept;
+		void Write(const void* pData, size_t n);
+		size_t Read(void* pData, size_t n) noexcept;
+	protected:
+		std::streamsize xsputn(const char* s, std::streamsize n) override;
+		int_type overflow(int_type ch) override;
+		std::streamsize xsgetn(char* s, std::streamsize n) override;
+		int_type underflow() override;
+		int_type uflow() override;
+	private:
+		// functions
+		void Reserve_(size_t n);
+		// data
+		std::vector<std::byte> storage_;
+		size_t readPos_ = 0;
+		size_t writePos_ = 0;
+	};
+
+	// frames on the wire have the layout [uint32 payload size][raw header bytes][cereal payload bytes]
+	// headers must be trivially copyable so that they can be copied without serialization, and
+	// must not have padding bytes, which would put uninitialized memory on the wire
+	template<class H>
+	concept FrameHeader = std::is_trivially_copyable_v<H> &&
+		(std::is_empty_v<H> || std::has_unique_object_representations_v<H>);
+
+	template<FrameHeader H>
+	inline constexpr size_t HeaderSize = std::is_empty_v<H> ? 0 : sizeof(H);
+
+	// size prefix + header, small enough to live on the stack and be written as the first
+	// buffer of a scatter/gather write (payload is the second buffer)
+	template<FrameHeader H>
+	struct FramePrefix
+	{
+		static constexpr size_t Size = sizeof(uint32_t) + HeaderSize<H>;
+		std::array<std::byte, Size> bytes;
+
+		FramePrefix() = default;
+		FramePrefix(const H& header, uint32_t payloadSize) noexcept
+		{
+			std::memcpy(bytes.data(), &payloadSize, sizeof(payloadSize));
+			if constexpr (HeaderSize<H> > 0) {
+				std::memcpy(bytes.data() + sizeof(payloadSize), &header, HeaderSize<H>);
+			}
+		}
+		uint32_t GetPayloadSize() const noexcept
+		{
+			uint32_t payloadSize;
+			std::memcpy(&payloadSize, bytes.data(), sizeof(payloadSize));
+			return payloadSize;
+		}
+		H GetHeader() const noexcept
+		{
+			H header{};
+			if constexpr (HeaderSize<H> > 0) {
+				std::memcpy(&header, bytes.data() + sizeof(uint32_t), HeaderSize<H>);
+			}
+			return header;
+		}
+	};
+
+	// transport-independent packet encoder/decoder holding pooled buffers and persistent cereal archives
+	// the transport sends FramePrefix followed by the encoded payload, and on receipt reads the prefix
+	// then fills the region returned by PrepareDecode with the payload bytes
+	class PacketCodec
+	{
+	public:
+		// clears the encoded payload when leaving scope, so that a packet whose encoding or write failed
+		// (or was canceled) never leaves bytes behind to be sent ahead of the next packet
+		class EncodeScope
+		{
+		public:
+			EncodeScope(PacketCodec& codec) noexcept : codec_{ codec } {}
+			EncodeScope(const EncodeScope&) = delete;
+			EncodeScope& operator=(const EncodeScope&) = delete;
+			~EncodeScope() { codec_.ClearEncoded(); }
+		private:
+			PacketCodec& codec_;
+		};
+		// clears the decode buffer when leaving scope unless the payload was fully received, so that a
+		// partial payload (timeout, pipe error or cancellation) is never decoded as part of the next packet
+		class DecodeScope
+		{
+		public:
+			DecodeScope(PacketCodec& codec) noexcept : codec_{ codec } {}
+			DecodeScope(const DecodeScope&) = delete;
+			DecodeScope& operator=(const DecodeScope&) = delete;
+			~DecodeScope() { if (!received_) { codec_.ClearDecode(); } }
+			void MarkReceived() noexcept { received_ = true; }
+		private:
+			PacketCodec& codec_;
+			bool received_ = false;
+		};
+		PacketCodec();
+		PacketCodec(const PacketCodec&) = delete;
+		PacketCodec& operator=(const PacketCodec&) = delete;
+		// encoding (send side)
+		template<FrameHeader H, class P>
+		FramePrefix<H> Encode(const H& header, const P& payload)
+		{
+			writeArchive_(payload);
+			return { header, uint32_t(writeBuf_.Size()) };
+		}
+		std::span<const std::byte> GetEncodedPayload() const noexcept;
+		size_t GetEncodedSize() const noexcept;
+		void ClearEncoded() noexcept;
+		// decoding (receive side)
+		std::span<std::byte> PrepareDecode(size_t payloadSize);
+		template<class P>
+		P Decode()
+		{
+			P payload;
+			readArchive_(payload);
+			return payload;
+		}
+		// bytes remaining in the decode buffer (should be zero after payload is decoded)
+		size_t GetPendingDecodeSize() const noexcept;
+		void ClearDecode() noexcept;
+	private:
+		PacketBuffer readBuf_;
+		std::istream readStream_;
+		cereal::BinaryInputArchive readArchive_;
+		PacketBuffer writeBuf_;
+		std::ostream writeStream_;
+		cereal::BinaryOutputArchive writeArchive_;
+	};
+}
@@ -65,13 +65,21 @@ namespace pmon::util::pipe
 	{
 		return std::unique_ptr<DuplexPipe>(new DuplexPipe{ ioctx, Make_(name, security), name, false });
 	}
+	void DuplexPipe::DiscardPacketPayload()
+	{
+		codec_.ClearDecode();
+	}
+	size_t DuplexPipe::GetReadBufferPending() const
+	{
+		return codec_.GetPendingDecodeSize();
+	}
 	size_t DuplexPipe::GetWriteBufferPending() const
 	{
-		return writeBuf_.size();
+		return codec_.GetEncodedSize();
 	}
 	void DuplexPipe::ClearWriteBuffer()
 	{
-		return writeBuf_.consume(GetWriteBufferPending());
+		codec_.ClearEncoded();
 	}
 	bool DuplexPipe::WaitForAvailability(const std::string& name, uint32_t timeoutMs, uint32_t pollPeriodMs)
 	{
@@ -108,11 +116,7 @@ namespace pmon::util::pipe
 		name_{ std::move(name) },
 		rawPipeHandle_{ pipeHandle },
 		asioPipeHandle_{ ioctx },
-		readStream_{ &readBuf_ },
-		readArchive_{ readStream_ },
 		readMtx_{ ioctx },
-		writeStream_{ &writeBuf_ },
-		writeArchive_{ writeStream_ },
 		writeMtx_{ ioctx }
 	{
 		if (asClient) {
@@ -178,10 +182,10 @@ namespace pmon::util::pipe
 		// release the owned handle to be captured by some other owner
 		return handle.Release();
 	}
-	as::awaitable<void> DuplexPipe::Read_(size_t byteCount, std::optional<uint32_t> timeoutMs)
+	as::awaitable<void> DuplexPipe::Read_(as::mutable_buffer buffer, std::optional<uint32_t> timeoutMs)
 	{
 		if (timeoutMs) {
-			const auto result = co_await(as::async_read(asioPipeHandle_, readBuf_, as::transfer_exactly(byteCount),
+			const auto result = co_await(as::async_read(asioPipeHandle_, buffer,
 				as::as_tuple(as::use_awaitable)) || Timeout_(*timeoutMs));
 			// 2nd index active means timed out
 			if (result.index() == 1) {
@@ -192,15 +196,15 @@ namespace pmon::util::pipe
 			TransformError_(ec);
 		}
 		else {
-			const auto [ec, n] = co_await as::async_read(asioPipeHandle_, readBuf_, as::transfer_exactly(byteCount),
+			const auto [ec, n] = co_await as::async_read(asioPipeHandle_, buffer,
 				as::as_tuple(as::use_awaitable));
 			TransformError_(ec);
 		}
 	}
-	as::awaitable<void> DuplexPipe::Write_(std::optional<uint32_t> timeoutMs)
+	as::awaitable<void> DuplexPipe::Write_(std::array<as::const_buffer, 2> buffers, std::optional<uint32_t> timeoutMs)
 	{
 		if (timeoutMs) {
-			const auto result = co_await(as::async_write(asioPipeHandle_, writeBuf_, as::as_tuple(as::use_awaitable))
+			const auto result = co_await(as::async_write(asioPipeHandle_, buffers, as::as_tuple(as::use_awaitable))
 				|| Timeout_(*timeoutMs));
 			// 2nd index active means timed out
 			if (result.index() == 1) {
@@ -211,7 +215,7 @@ namespace pmon::util::pipe
 			TransformError_(ec);
 		}
 		else {
-			const auto [ec, n] = co_await as::async_write(asioPipeHandle_, writeBuf_, as::as_tuple(as::use_awaitable));
+			const auto [ec, n] = co_await as::async_write(asioPipeHandle_, buffers, as::as_tuple(as::use_awaitable));
 			TransformError_(ec);
 		}
 	}
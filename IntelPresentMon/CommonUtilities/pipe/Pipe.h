@@ -12,6 +12,7 @@
 #include "../log/Log.h"
 #include "SecurityMode.h"
 #include "CoroMutex.h"
+#include "PacketFraming.h"
 #include <ranges>
 
 namespace pmon::util::pipe
@@ -40,51 +41,44 @@ namespace pmon::util::pipe
 		static DuplexPipe Make(const std::string& name, as::io_context& ioctx, const std::string& security = {});
 		static std::unique_ptr<DuplexPipe> ConnectAsPtr(const std::string& name, as::io_context& ioctx);
 		static std::unique_ptr<DuplexPipe> MakeAsPtr(const std::string& name, as::io_context& ioctx, const std::string& security = {});
-		template<class H, class P>
+		template<FrameHeader H, class P>
 		as::awaitable<void> WritePacket(const H& header, const P& payload, std::optional<uint32_t> timeoutMs = {})
 		{
 			// lock while this coro is running to prevent other coros from causing an overlapped operation fault
 			auto lk = co_await CoroLock(writeMtx_);
 			// some sanity checks
-			assert(writeBuf_.size() == 0);
+			assert(codec_.GetEncodedSize() == 0);
 			assert(asioPipeHandle_.is_open());
-			// first we directly write bytes for the size of the body as a placeholder until we know how many are serialized
-			const uint32_t placeholderSize = 'TEMP';
-			writeStream_.write(reinterpret_cast<const char*>(&placeholderSize), sizeof(placeholderSize));
-			// record how many bytes used for the serialization of the size
-			const auto sizeSize = writeBuf_.size();
-			// serialize the packet body
-			writeArchive_(header, payload);
-			// calculate size of body
-			const auto payloadSize = uint32_t(writeBuf_.size() - sizeSize);
-			// replace the placeholder with the actual body size
-			auto bufSeq = writeBuf_.data();
-			const auto iSize = const_cast<char*>(as::buffer_cast<const char*>(bufSeq));
-			auto replacement = std::string_view{ reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize) };
-			std::ranges::copy(replacement, iSize);
-			// transmit the packet
-			co_await Write_(timeoutMs);
+			// write buffer is cleared on every exit path: success, encode error, timeout, pipe error or cancellation
+			const PacketCodec::EncodeScope encodeScope{ codec_ };
+			// serialize the payload into the pooled write buffer, size and header go raw into the prefix
+			const auto prefix = codec_.Encode(header, payload);
+			// transmit the packet, gathering prefix and payload into a single write
+			co_await Write_(std::array{
+				as::const_buffer{ prefix.bytes.data(), prefix.bytes.size() },
+				as::const_buffer{ codec_.GetEncodedPayload().data(), codec_.GetEncodedSize() },
+			}, timeoutMs);
 		}
-		template<class H>
+		template<FrameHeader H>
 		as::awaitable<H> ReadPacketConsumeHeader(std::optional<uint32_t> timeoutMs = {})
 		{
 			// lock while this coro is running to prevent other coros from interrupting stream sequence
 			// and/or causing an overlapped operation fault
 			auto lk = co_await CoroLock(readMtx_);
 			// some sanity checks
-			assert(readBuf_.size() == 0);
+			assert(codec_.GetPendingDecodeSize() == 0);
 			assert(asioPipeHandle_.is_open());
 			// read in request
-			// first read the number of bytes in the request payload (always 4-byte read)
-			uint32_t payloadSize;
-			co_await Read_(sizeof(payloadSize), timeoutMs);
-			readStream_.read(reinterpret_cast<char*>(&payloadSize), sizeof(payloadSize));
-			// read the payload
-			co_await Read_(payloadSize, timeoutMs);
-			// deserialize header portion of request payload
-			H header;
-			readArchive_(header);
-			co_return header;
+			// first read the fixed-size prefix with the payload size and the raw header
+			FramePrefix<H> prefix;
+			co_await Read_(as::mutable_buffer{ prefix.bytes.data(), prefix.bytes.size() }, timeoutMs);
+			// read the payload directly into the pooled read buffer
+			// read buffer is cleared unless the payload is complete: timeout, pipe error or cancellation
+			PacketCodec::DecodeScope decodeScope{ codec_ };
+			const auto payload = codec_.PrepareDecode(prefix.GetPayloadSize());
+			co_await Read_(as::mutable_buffer{ payload.data(), payload.size() }, timeoutMs);
+			decodeScope.MarkReceived();
+			co_return prefix.GetHeader();
 		}
 		// NOTE: it might be necessary to pull the read lock up into the transfer layer to make sure nothing
 		// interposes between header and payload consumption
@@ -92,15 +86,17 @@ namespace pmon::util::pipe
 		template<class P>
 		P ConsumePacketPayload()
 		{
-			P payload;
-			readArchive_(payload);
-			if (const auto sz = readBuf_.size()) {
+			auto payload = codec_.Decode<P>();
+			if (const auto sz = codec_.GetPendingDecodeSize()) {
 				assert("unexpected data when reading packet payload from buffer!!" && false);
 				pmlog_warn(std::format("Buffer contained unexpected data of size", sz));
-				readBuf_.consume(sz);
+				codec_.ClearDecode();
 			}
 			return payload;
 		}
+		// drop the payload of the packet whose header was last consumed (e.g. a response nobody is waiting for)
+		void DiscardPacketPayload();
+		size_t GetReadBufferPending() const;
 		size_t GetWriteBufferPending() const;
 		void ClearWriteBuffer();
 		static bool WaitForAvailability(const std::string& name, uint32_t timeoutMs, uint32_t pollPeriodMs = 10);
@@ -113,9 +109,11 @@ namespace pmon::util::pipe
 		static HANDLE Connect_(const std::string& name);
 		static HANDLE Make_(const std::string& name, const std::string& security = {});
 		// wrapper to convert EOF system_error to PipeBroken error, with optional timeout
-		as::awaitable<void> Read_(size_t byteCount, std::optional<uint32_t> timeoutMs = {});
+		// fills the entire buffer
+		as::awaitable<void> Read_(as::mutable_buffer buffer, std::optional<uint32_t> timeoutMs = {});
 		// wrapper to convert EOF system_error to PipeBroken error, with optional timeout
-		as::awaitable<void> Write_(std::optional<uint32_t> timeoutMs = {});
+		// gathers prefix and payload buffers into a single write
+		as::awaitable<void> Write_(std::array<as::const_buffer, 2> buffers, std::optional<uint32_t> timeoutMs = {});
 		as::awaitable<void> Timeout_(uint32_t ms);
 		void TransformError_(const boost::system::error_code& ec);
 		// data
@@ -124,13 +122,9 @@ namespace pmon::util::pipe
 		uint32_t uid_ = nextUid_++;
 		win::Handle rawPipeHandle_;
 		as::windows::stream_handle asioPipeHandle_;
-		as::streambuf readBuf_;
-		std::istream readStream_;
-		cereal::BinaryInputArchive readArchive_;
+		// pooled buffers and archives for packet framing, reused for every packet
+		PacketCodec codec_;
 		CoroMutex readMtx_;
-		as::streambuf writeBuf_;
-		std::ostream writeStream_;
-		cereal::BinaryOutputArchive writeArchive_;
 		CoroMutex writeMtx_;
 	};
 }
\ No newline at end of file
@@ -15,6 +15,7 @@ namespace pwr::cpu {
 
 class CpuTelemetry {
  public:
+  using CpuTelemetryCapBitset = std::bitset<static_cast<size_t>(CpuTelemetryCapBits::cpu_telemetry_count)>;
   virtual ~CpuTelemetry() = default;
   virtual bool Sample() noexcept = 0;
   virtual std::optional<CpuTelemetryInfo> GetClosest(
@@ -23,12 +24,12 @@ class CpuTelemetry {
   {
       cpuTelemetryCapBits_.set(static_cast<size_t>(telemetryCapBit));
   }
-  std::bitset<static_cast<size_t>(CpuTelemetryCapBits::cpu_telemetry_count)> GetCpuTelemetryCapBits()
+  CpuTelemetryCapBitset GetCpuTelemetryCapBits()
   {
       return cpuTelemetryCapBits_;
   }
 
-  std::string GetCpuName();
+  virtual std::string GetCpuName();
   double GetCpuPowerLimit() { return 0.; }
   
   // constants
@@ -38,8 +39,7 @@ class CpuTelemetry {
 
   bool ExecuteWQLProcessorNameQuery(std::wstring& processor_name);
 
-  std::bitset<static_cast<size_t>(CpuTelemetryCapBits::cpu_telemetry_count)>
-      cpuTelemetryCapBits_{};
+  CpuTelemetryCapBitset cpuTelemetryCapBits_{};
   std::string cpu_name_;
 };
 }
\ No newline at end of file
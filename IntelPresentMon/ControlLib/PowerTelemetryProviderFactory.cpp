@@ -4,10 +4,44 @@
 #include "IntelPowerTelemetryProvider.h"
 #include "NvidiaPowerTelemetryProvider.h"
 #include "AmdPowerTelemetryProvider.h"
+#include "WmiCpu.h"
+#include "RecordingTelemetry.h"
+#include "ReplayTelemetry.h"
 
 namespace pwr
 {
-	std::unique_ptr<PowerTelemetryProvider> PowerTelemetryProviderFactory::Make(PM_DEVICE_VENDOR vendor)
+	std::unique_ptr<PowerTelemetryProvider> PowerTelemetryProviderFactory::Make(PM_DEVICE_VENDOR vendor, const Options& options)
+	{
+		if (options.replayDirectory) {
+			return std::make_unique<rec::ReplayPowerTelemetryProvider>(*options.replayDirectory, vendor, options.replaySpeed);
+		}
+		auto pProvider = MakeLive_(vendor);
+		if (pProvider && options.recordDirectory) {
+			return std::make_unique<rec::RecordingPowerTelemetryProvider>(std::move(pProvider), *options.recordDirectory);
+		}
+		return pProvider;
+	}
+
+	std::shared_ptr<cpu::CpuTelemetry> PowerTelemetryProviderFactory::MakeCpu(const Options& options)
+	{
+		if (options.replayDirectory) {
+			const auto paths = rec::FindRecordings(*options.replayDirectory, rec::DeviceKind::Cpu);
+			if (paths.empty()) {
+				throw Except<TelemetrySubsystemAbsent>("No cpu telemetry recording in replay directory");
+			}
+			return std::make_shared<rec::ReplayCpuTelemetry>(
+				rec::LoadRecording<CpuTelemetryInfo>(paths.front()), options.replaySpeed);
+		}
+		std::shared_ptr<cpu::CpuTelemetry> pCpu = std::make_shared<cpu::wmi::WmiCpu>();
+		if (options.recordDirectory) {
+			std::filesystem::create_directories(*options.recordDirectory);
+			pCpu = std::make_shared<rec::RecordingCpuTelemetry>(std::move(pCpu),
+				*options.recordDirectory / rec::MakeRecordingFileName(rec::DeviceKind::Cpu, PM_DEVICE_VENDOR_UNKNOWN, 0));
+		}
+		return pCpu;
+	}
+
+	std::unique_ptr<PowerTelemetryProvider> PowerTelemetryProviderFactory::MakeLive_(PM_DEVICE_VENDOR vendor)
 	{
 		switch (vendor) {
 		case PM_DEVICE_VENDOR_INTEL: return std::make_unique<intel::IntelPowerTelemetryProvider>();
@@ -16,4 +50,4 @@ namespace pwr
 		}
 		return {};
 	}
-}
\ No newline at end of file
+}
@@ -4,12 +4,31 @@
 #include "PowerTelemetryProvider.h"
 #include "../PresentMonAPI2/PresentMonAPI.h"
 #include <memory>
+#include <optional>
+#include <filesystem>
 
 namespace pwr
 {
+	namespace cpu
+	{
+		class CpuTelemetry;
+	}
+
 	class PowerTelemetryProviderFactory
 	{
 	public:
-		static std::unique_ptr<PowerTelemetryProvider> Make(PM_DEVICE_VENDOR vendor);
+		struct Options
+		{
+			// wrap live providers so that their samples are recorded to this directory
+			std::optional<std::filesystem::path> recordDirectory;
+			// play back recordings from this directory instead of using live providers
+			std::optional<std::filesystem::path> replayDirectory;
+			// playback rate relative to the recorded timeline
+			double replaySpeed = 1.;
+		};
+		static std::unique_ptr<PowerTelemetryProvider> Make(PM_DEVICE_VENDOR vendor, const Options& options = {});
+		static std::shared_ptr<cpu::CpuTelemetry> MakeCpu(const Options& options = {});
+	private:
+		static std::unique_ptr<PowerTelemetryProvider> MakeLive_(PM_DEVICE_VENDOR vendor);
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,162 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#define NOMINMAX
+#include <Windows.h>
+#include "RecordingTelemetry.h"
+#include "Logging.h"
+
+namespace pwr::rec
+{
+    using namespace pmon::util;
+
+    namespace
+    {
+        uint64_t GetQpc_() noexcept
+        {
+            LARGE_INTEGER qpc;
+            QueryPerformanceCounter(&qpc);
+            return uint64_t(qpc.QuadPart);
+        }
+
+        DeviceInfo MakeGpuInfo_(const PowerTelemetryAdapter& adapter)
+        {
+            return DeviceInfo{
+                .kind = DeviceKind::Gpu,
+                .vendor = adapter.GetVendor(),
+                .name = adapter.GetName(),
+                .dedicatedVideoMemory = adapter.GetDedicatedVideoMemory(),
+                .videoMemoryMaxBandwidth = adapter.GetVideoMemoryMaxBandwidth(),
+                .sustainedPowerLimit = adapter.GetSustainedPowerLimit(),
+            };
+        }
+    }
+
+    RecordingPowerTelemetryAdapter::RecordingPowerTelemetryAdapter(std::shared_ptr<PowerTelemetryAdapter> pAdapter,
+        const std::filesystem::path& path)
+        :
+        pAdapter_{ std::move(pAdapter) },
+        writer_{ path, MakeGpuInfo_(*pAdapter_), sizeof(PresentMonPowerTelemetryInfo) }
+    {}
+
+    bool RecordingPowerTelemetryAdapter::Sample() noexcept
+    {
+        const auto result = pAdapter_->Sample();
+        try {
+            // cap bits are discovered while sampling, so mirror and record them as they change
+            if (const auto caps = pAdapter_->GetPowerTelemetryCapBits(); caps != recordedCaps_) {
+                for (size_t i = 0; i < caps.size(); i++) {
+                    if (caps.test(i)) {
+                        SetTelemetryCapBit(GpuTelemetryCapBits(i));
+                    }
+                }
+                writer_.WriteCaps(BitsetToWords(caps));
+                recordedCaps_ = caps;
+            }
+            // the sample closest to now is the one just taken; skip when the adapter did not produce a new one
+            if (const auto sample = pAdapter_->GetClosest(GetQpc_());
+                sample && sample->qpc != lastRecordedQpc_.value_or(~0ull)) {
+                writer_.WriteSample(std::as_bytes(std::span{ &*sample, 1 }));
+                lastRecordedQpc_ = sample->qpc;
+            }
+        }
+        catch (...) {
+            pmlog_error(ReportException("Failed recording gpu telemetry sample")).every(100);
+        }
+        return result;
+    }
+
+    std::optional<PresentMonPowerTelemetryInfo> RecordingPowerTelemetryAdapter::GetClosest(uint64_t qpc) const noexcept
+    {
+        return pAdapter_->GetClosest(qpc);
+    }
+
+    PM_DEVICE_VENDOR RecordingPowerTelemetryAdapter::GetVendor() const noexcept
+    {
+        return pAdapter_->GetVendor();
+    }
+
+    std::string RecordingPowerTelemetryAdapter::GetName() const noexcept
+    {
+        return pAdapter_->GetName();
+    }
+
+    uint64_t RecordingPowerTelemetryAdapter::GetDedicatedVideoMemory() const noexcept
+    {
+        return pAdapter_->GetDedicatedVideoMemory();
+    }
+
+    uint64_t RecordingPowerTelemetryAdapter::GetVideoMemoryMaxBandwidth() const noexcept
+    {
+        return pAdapter_->GetVideoMemoryMaxBandwidth();
+    }
+
+    double RecordingPowerTelemetryAdapter::GetSustainedPowerLimit() const noexcept
+    {
+        return pAdapter_->GetSustainedPowerLimit();
+    }
+
+
+    RecordingPowerTelemetryProvider::RecordingPowerTelemetryProvider(std::unique_ptr<PowerTelemetryProvider> pProvider,
+        const std::filesystem::path& directory)
+        :
+        pProvider_{ std::move(pProvider) }
+    {
+        std::filesystem::create_directories(directory);
+        for (auto& pAdapter : pProvider_->GetAdapters()) {
+            const auto fileName = MakeRecordingFileName(DeviceKind::Gpu, pAdapter->GetVendor(), adapterPtrs_.size());
+            adapterPtrs_.push_back(std::make_shared<RecordingPowerTelemetryAdapter>(pAdapter, directory / fileName));
+        }
+    }
+
+    const std::vector<std::shared_ptr<PowerTelemetryAdapter>>& RecordingPowerTelemetryProvider::GetAdapters() noexcept
+    {
+        return adapterPtrs_;
+    }
+
+    uint32_t RecordingPowerTelemetryProvider::GetAdapterCount() const noexcept
+    {
+        return (uint32_t)adapterPtrs_.size();
+    }
+
+
+    RecordingCpuTelemetry::RecordingCpuTelemetry(std::shared_ptr<cpu::CpuTelemetry> pCpu, const std::filesystem::path& path)
+        :
+        pCpu_{ std::move(pCpu) },
+        writer_{ path, DeviceInfo{ .kind = DeviceKind::Cpu, .name = pCpu_->GetCpuName() }, sizeof(CpuTelemetryInfo) }
+    {}
+
+    bool RecordingCpuTelemetry::Sample() noexcept
+    {
+        const auto result = pCpu_->Sample();
+        try {
+            if (const auto caps = pCpu_->GetCpuTelemetryCapBits(); caps != recordedCaps_) {
+                for (size_t i = 0; i < caps.size(); i++) {
+                    if (caps.test(i)) {
+                        SetTelemetryCapBit(CpuTelemetryCapBits(i));
+                    }
+                }
+                writer_.WriteCaps(BitsetToWords(caps));
+                recordedCaps_ = caps;
+            }
+            if (const auto sample = pCpu_->GetClosest(GetQpc_());
+                sample && sample->qpc != lastRecordedQpc_.value_or(~0ull)) {
+                writer_.WriteSample(std::as_bytes(std::span{ &*sample, 1 }));
+                lastRecordedQpc_ = sample->qpc;
+            }
+        }
+        catch (...) {
+            pmlog_error(ReportException("Failed recording cpu telemetry sample")).every(100);
+        }
+        return result;
+    }
+
+    std::optional<CpuTelemetryInfo> RecordingCpuTelemetry::GetClosest(uint64_t qpc) const noexcept
+    {
+        return pCpu_->GetClosest(qpc);
+    }
+
+    std::string RecordingCpuTelemetry::GetCpuName()
+    {
+        return pCpu_->GetCpuName();
+    }
+}
@@ -0,0 +1,57 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include "PowerTelemetryProvider.h"
+#include "CpuTelemetry.h"
+#include "TelemetryRecording.h"
+#include <memory>
+#include <optional>
+#include <filesystem>
+
+namespace pwr::rec
+{
+    // forwards to a live adapter, recording each new sample it produces along with its cap bits
+    class RecordingPowerTelemetryAdapter : public PowerTelemetryAdapter
+    {
+    public:
+        RecordingPowerTelemetryAdapter(std::shared_ptr<PowerTelemetryAdapter> pAdapter, const std::filesystem::path& path);
+        bool Sample() noexcept override;
+        std::optional<PresentMonPowerTelemetryInfo> GetClosest(uint64_t qpc) const noexcept override;
+        PM_DEVICE_VENDOR GetVendor() const noexcept override;
+        std::string GetName() const noexcept override;
+        uint64_t GetDedicatedVideoMemory() const noexcept override;
+        uint64_t GetVideoMemoryMaxBandwidth() const noexcept override;
+        double GetSustainedPowerLimit() const noexcept override;
+    private:
+        std::shared_ptr<PowerTelemetryAdapter> pAdapter_;
+        RecordWriter writer_;
+        SetTelemetryCapBitset recordedCaps_;
+        std::optional<uint64_t> lastRecordedQpc_;
+    };
+
+    // wraps every adapter of a live provider in a recording adapter
+    class RecordingPowerTelemetryProvider : public PowerTelemetryProvider
+    {
+    public:
+        RecordingPowerTelemetryProvider(std::unique_ptr<PowerTelemetryProvider> pProvider, const std::filesystem::path& directory);
+        const std::vector<std::shared_ptr<PowerTelemetryAdapter>>& GetAdapters() noexcept override;
+        uint32_t GetAdapterCount() const noexcept override;
+    private:
+        std::unique_ptr<PowerTelemetryProvider> pProvider_;
+        std::vector<std::shared_ptr<PowerTelemetryAdapter>> adapterPtrs_;
+    };
+
+    class RecordingCpuTelemetry : public cpu::CpuTelemetry
+    {
+    public:
+        RecordingCpuTelemetry(std::shared_ptr<cpu::CpuTelemetry> pCpu, const std::filesystem::path& path);
+        bool Sample() noexcept override;
+        std::optional<CpuTelemetryInfo> GetClosest(uint64_t qpc) const noexcept override;
+        std::string GetCpuName() override;
+    private:
+        std::shared_ptr<cpu::CpuTelemetry> pCpu_;
+        RecordWriter writer_;
+        CpuTelemetryCapBitset recordedCaps_;
+        std::optional<uint64_t> lastRecordedQpc_;
+    };
+}
@@ -0,0 +1,141 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#define NOMINMAX
+#include <Windows.h>
+#include "ReplayTelemetry.h"
+#include "Logging.h"
+#include <format>
+
+namespace pwr::rec
+{
+    using namespace pmon::util;
+
+    namespace
+    {
+        uint64_t GetQpc_() noexcept
+        {
+            LARGE_INTEGER qpc;
+            QueryPerformanceCounter(&qpc);
+            return uint64_t(qpc.QuadPart);
+        }
+
+        uint64_t GetQpcFrequency_() noexcept
+        {
+            LARGE_INTEGER freq;
+            QueryPerformanceFrequency(&freq);
+            return uint64_t(freq.QuadPart);
+        }
+    }
+
+    ReplayPowerTelemetryAdapter::ReplayPowerTelemetryAdapter(Recording<PresentMonPowerTelemetryInfo> recording,
+        double speed)
+        :
+        info_{ std::move(recording.info) },
+        cursor_{ std::move(recording.samples), recording.qpcFrequency, GetQpcFrequency_(), speed }
+    {
+        const auto caps = WordsToBitset<size_t(GpuTelemetryCapBits::gpu_telemetry_count)>(recording.capWords);
+        for (size_t i = 0; i < caps.size(); i++) {
+            if (caps.test(i)) {
+                SetTelemetryCapBit(GpuTelemetryCapBits(i));
+            }
+        }
+        pmlog_info(std::format("Replaying {} recorded telemetry samples for adapter [{}] at {}x",
+            cursor_.GetSampleCount(), info_.name, speed));
+    }
+
+    bool ReplayPowerTelemetryAdapter::Sample() noexcept
+    {
+        std::lock_guard lock{ historyMutex_ };
+        return cursor_.Advance(GetQpc_(), [this](const PresentMonPowerTelemetryInfo& sample) {
+            history_.Push(sample);
+        }) > 0;
+    }
+
+    std::optional<PresentMonPowerTelemetryInfo> ReplayPowerTelemetryAdapter::GetClosest(uint64_t qpc) const noexcept
+    {
+        std::lock_guard lock{ historyMutex_ };
+        return history_.GetNearest(qpc);
+    }
+
+    PM_DEVICE_VENDOR ReplayPowerTelemetryAdapter::GetVendor() const noexcept
+    {
+        return info_.vendor;
+    }
+
+    std::string ReplayPowerTelemetryAdapter::GetName() const noexcept
+    {
+        return info_.name;
+    }
+
+    uint64_t ReplayPowerTelemetryAdapter::GetDedicatedVideoMemory() const noexcept
+    {
+        return info_.dedicatedVideoMemory;
+    }
+
+    uint64_t ReplayPowerTelemetryAdapter::GetVideoMemoryMaxBandwidth() const noexcept
+    {
+        return info_.videoMemoryMaxBandwidth;
+    }
+
+    double ReplayPowerTelemetryAdapter::GetSustainedPowerLimit() const noexcept
+    {
+        return info_.sustainedPowerLimit;
+    }
+
+
+    ReplayPowerTelemetryProvider::ReplayPowerTelemetryProvider(const std::filesystem::path& directory,
+        PM_DEVICE_VENDOR vendor, double speed)
+    {
+        for (auto& path : FindRecordings(directory, DeviceKind::Gpu, vendor)) {
+            adapterPtrs_.push_back(std::make_shared<ReplayPowerTelemetryAdapter>(
+                LoadRecording<PresentMonPowerTelemetryInfo>(path), speed));
+        }
+        if (adapterPtrs_.empty()) {
+            throw Except<TelemetrySubsystemAbsent>("No telemetry recordings for this vendor in replay directory");
+        }
+    }
+
+    const std::vector<std::shared_ptr<PowerTelemetryAdapter>>& ReplayPowerTelemetryProvider::GetAdapters() noexcept
+    {
+        return adapterPtrs_;
+    }
+
+    uint32_t ReplayPowerTelemetryProvider::GetAdapterCount() const noexcept
+    {
+        return (uint32_t)adapterPtrs_.size();
+    }
+
+
+    ReplayCpuTelemetry::ReplayCpuTelemetry(Recording<CpuTelemetryInfo> recording, double speed)
+        :
+        name_{ std::move(recording.info.name) },
+        cursor_{ std::move(recording.samples), recording.qpcFrequency, GetQpcFrequency_(), speed }
+    {
+        const auto caps = WordsToBitset<size_t(CpuTelemetryCapBits::cpu_telemetry_count)>(recording.capWords);
+        for (size_t i = 0; i < caps.size(); i++) {
+            if (caps.test(i)) {
+                SetTelemetryCapBit(CpuTelemetryCapBits(i));
+            }
+        }
+        pmlog_info(std::format("Replaying {} recorded cpu telemetry samples at {}x", cursor_.GetSampleCount(), speed));
+    }
+
+    bool ReplayCpuTelemetry::Sample() noexcept
+    {
+        std::lock_guard lock{ historyMutex_ };
+        return cursor_.Advance(GetQpc_(), [this](const CpuTelemetryInfo& sample) {
+            history_.Push(sample);
+        }) > 0;
+    }
+
+    std::optional<CpuTelemetryInfo> ReplayCpuTelemetry::GetClosest(uint64_t qpc) const noexcept
+    {
+        std::lock_guard lock{ historyMutex_ };
+        return history_.GetNearest(qpc);
+    }
+
+    std::string ReplayCpuTelemetry::GetCpuName()
+    {
+        return name_;
+    }
+}
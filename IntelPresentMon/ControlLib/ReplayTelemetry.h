@@ -0,0 +1,57 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include "PowerTelemetryProvider.h"
+#include "CpuTelemetry.h"
+#include "TelemetryHistory.h"
+#include "TelemetryRecording.h"
+#include <memory>
+#include <mutex>
+#include <filesystem>
+
+namespace pwr::rec
+{
+    // plays back a gpu telemetry recording in place of a live adapter
+    class ReplayPowerTelemetryAdapter : public PowerTelemetryAdapter
+    {
+    public:
+        ReplayPowerTelemetryAdapter(Recording<PresentMonPowerTelemetryInfo> recording, double speed);
+        bool Sample() noexcept override;
+        std::optional<PresentMonPowerTelemetryInfo> GetClosest(uint64_t qpc) const noexcept override;
+        PM_DEVICE_VENDOR GetVendor() const noexcept override;
+        std::string GetName() const noexcept override;
+        uint64_t GetDedicatedVideoMemory() const noexcept override;
+        uint64_t GetVideoMemoryMaxBandwidth() const noexcept override;
+        double GetSustainedPowerLimit() const noexcept override;
+    private:
+        DeviceInfo info_;
+        ReplayCursor<PresentMonPowerTelemetryInfo> cursor_;
+        mutable std::mutex historyMutex_;
+        TelemetryHistory<PresentMonPowerTelemetryInfo> history_{ PowerTelemetryAdapter::defaultHistorySize };
+    };
+
+    // provides replay adapters for all gpu recordings of one vendor found in a directory
+    class ReplayPowerTelemetryProvider : public PowerTelemetryProvider
+    {
+    public:
+        ReplayPowerTelemetryProvider(const std::filesystem::path& directory, PM_DEVICE_VENDOR vendor, double speed);
+        const std::vector<std::shared_ptr<PowerTelemetryAdapter>>& GetAdapters() noexcept override;
+        uint32_t GetAdapterCount() const noexcept override;
+    private:
+        std::vector<std::shared_ptr<PowerTelemetryAdapter>> adapterPtrs_;
+    };
+
+    class ReplayCpuTelemetry : public cpu::CpuTelemetry
+    {
+    public:
+        ReplayCpuTelemetry(Recording<CpuTelemetryInfo> recording, double speed);
+        bool Sample() noexcept override;
+        std::optional<CpuTelemetryInfo> GetClosest(uint64_t qpc) const noexcept override;
+        std::string GetCpuName() override;
+    private:
+        std::string name_;
+        ReplayCursor<CpuTelemetryInfo> cursor_;
+        mutable std::mutex historyMutex_;
+        TelemetryHistory<CpuTelemetryInfo> history_{ CpuTelemetry::defaultHistorySize };
+    };
+}
@@ -0,0 +1,331 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#define NOMINMAX
+#include <Windows.h>
+#include "TelemetryRecording.h"
+#include <algorithm>
+#include <array>
+#include <format>
+
+namespace pwr::rec
+{
+    namespace
+    {
+        constexpr std::array<char, 4> magic_{ 'P', 'M', 'T', 'R' };
+        constexpr uint32_t version_ = 1;
+
+        enum class RecordTag : uint8_t
+        {
+            Caps,
+            Sample,
+        };
+
+        template<class T>
+        void WritePod_(std::ostream& out, const T& val)
+        {
+            out.write(reinterpret_cast<const char*>(&val), sizeof(T));
+        }
+
+        template<class T>
+        bool ReadPod_(std::istream& in, T& val)
+        {
+            return (bool)in.read(reinterpret_cast<char*>(&val), sizeof(T));
+        }
+
+        void PushVarint_(std::vector<std::byte>& out, uint64_t val)
+        {
+            while (val >= 0x80) {
+                out.push_back(std::byte(val | 0x80));
+                val >>= 7;
+            }
+            out.push_back(std::byte(val));
+        }
+
+        void WriteVarint_(std::ostream& out, uint64_t val)
+        {
+            while (val >= 0x80) {
+                WritePod_(out, uint8_t(val | 0x80));
+                val >>= 7;
+            }
+            WritePod_(out, uint8_t(val));
+        }
+
+        bool PopVarint_(std::span<const std::byte>& in, uint64_t& val)
+        {
+            val = 0;
+            for (int shift = 0; shift < 64 && !in.empty(); shift += 7) {
+                const auto b = uint8_t(in.front());
+                in = in.subspan(1);
+                val |= uint64_t(b & 0x7F) << shift;
+                if (!(b & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool ReadVarint_(std::istream& in, uint64_t& val)
+        {
+            val = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                uint8_t b;
+                if (!ReadPod_(in, b)) {
+                    return false;
+                }
+                val |= uint64_t(b & 0x7F) << shift;
+                if (!(b & 0x80)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // encodes (sample xor previous) as pairs of [zero run length][literal length][literal bytes]
+        void EncodeDelta_(std::span<const std::byte> sample, std::span<const std::byte> previous,
+            std::vector<std::byte>& out)
+        {
+            const auto size = sample.size();
+            const auto diff = [&](size_t i) { return sample[i] ^ previous[i]; };
+            size_t i = 0;
+            while (i < size) {
+                const auto zeroStart = i;
+                while (i < size && diff(i) == std::byte{ 0 }) {
+                    i++;
+                }
+                const auto literalStart = i;
+                // literal ends at the next pair of zero bytes (single zeros are cheaper to keep in the literal)
+                while (i < size && !(diff(i) == std::byte{ 0 } && (i + 1 == size || diff(i + 1) == std::byte{ 0 }))) {
+                    i++;
+                }
+                PushVarint_(out, literalStart - zeroStart);
+                PushVarint_(out, i - literalStart);
+                for (auto j = literalStart; j < i; j++) {
+                    out.push_back(diff(j));
+                }
+            }
+        }
+
+        bool DecodeDelta_(std::span<const std::byte> in, std::span<std::byte> sample)
+        {
+            size_t i = 0;
+            while (!in.empty()) {
+                uint64_t zeros, literals;
+                if (!PopVarint_(in, zeros) || !PopVarint_(in, literals) ||
+                    i + zeros + literals > sample.size() || literals > in.size()) {
+                    return false;
+                }
+                i += zeros;
+                for (uint64_t j = 0; j < literals; j++) {
+                    sample[i++] ^= in[j];
+                }
+                in = in.subspan(literals);
+            }
+            return true;
+        }
+
+        std::ifstream OpenAndReadHeader_(const std::filesystem::path& path, RawRecording& rec)
+        {
+            std::ifstream file{ path, std::ios::binary };
+            if (!file) {
+                throw Except<TelementryException>("Failed to open telemetry recording: " + path.string());
+            }
+            std::array<char, 4> magic{};
+            uint32_t version = 0;
+            uint32_t kind = 0;
+            int32_t vendor = 0;
+            uint32_t nameLength = 0;
+            if (!file.read(magic.data(), magic.size()) || magic != magic_ || !ReadPod_(file, version) ||
+                version != version_ || !ReadPod_(file, kind) || !ReadPod_(file, rec.sampleSize) ||
+                !ReadPod_(file, rec.qpcFrequency) || !ReadPod_(file, vendor) || !ReadPod_(file, nameLength)) {
+                throw Except<TelementryException>("Bad telemetry recording header: " + path.string());
+            }
+            rec.info.kind = DeviceKind(kind);
+            rec.info.vendor = PM_DEVICE_VENDOR(vendor);
+            rec.info.name.resize(nameLength);
+            if (!file.read(rec.info.name.data(), nameLength) ||
+                !ReadPod_(file, rec.info.dedicatedVideoMemory) ||
+                !ReadPod_(file, rec.info.videoMemoryMaxBandwidth) ||
+                !ReadPod_(file, rec.info.sustainedPowerLimit)) {
+                throw Except<TelementryException>("Bad telemetry recording device info: " + path.string());
+            }
+            return file;
+        }
+
+        void RotateExisting_(const std::filesystem::path& path)
+        {
+            for (int i = 1;; i++) {
+                auto rotated = path;
+                rotated += std::format(".{}", i);
+                if (!std::filesystem::exists(rotated)) {
+                    std::filesystem::rename(path, rotated);
+                    return;
+                }
+            }
+        }
+    }
+
+    RecordWriter::RecordWriter(const std::filesystem::path& path, const DeviceInfo& info, uint32_t sampleSize)
+        :
+        previous_(sampleSize)
+    {
+        if (std::filesystem::exists(path)) {
+            if (TryResume_(path, info, sampleSize)) {
+                return;
+            }
+            RotateExisting_(path);
+        }
+        file_.open(path, std::ios::binary | std::ios::trunc);
+        if (!file_) {
+            throw Except<TelementryException>("Failed to create telemetry recording: " + path.string());
+        }
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        file_.write(magic_.data(), magic_.size());
+        WritePod_(file_, version_);
+        WritePod_(file_, uint32_t(info.kind));
+        WritePod_(file_, sampleSize);
+        WritePod_(file_, uint64_t(freq.QuadPart));
+        WritePod_(file_, int32_t(info.vendor));
+        WritePod_(file_, uint32_t(info.name.size()));
+        file_.write(info.name.data(), info.name.size());
+        WritePod_(file_, info.dedicatedVideoMemory);
+        WritePod_(file_, info.videoMemoryMaxBandwidth);
+        WritePod_(file_, info.sustainedPowerLimit);
+        file_.flush();
+    }
+
+    bool RecordWriter::TryResume_(const std::filesystem::path& path, const DeviceInfo& info, uint32_t sampleSize)
+    {
+        RawRecording rec;
+        try {
+            rec = ReadRecording(path);
+        }
+        catch (const TelementryException&) {
+            return false;
+        }
+        if (rec.sampleSize != sampleSize || rec.info.kind != info.kind || rec.info.vendor != info.vendor ||
+            rec.info.name != info.name) {
+            return false;
+        }
+        // drop any partial record left by a killed service so that appended records stay aligned
+        std::filesystem::resize_file(path, rec.validSize);
+        file_.open(path, std::ios::binary | std::ios::app);
+        if (!file_) {
+            throw Except<TelementryException>("Failed to open telemetry recording for append: " + path.string());
+        }
+        // deltas continue from the last recorded sample, exactly as the reader will decode them
+        if (rec.sampleCount) {
+            std::ranges::copy(std::span{ rec.samples }.last(sampleSize), previous_.begin());
+        }
+        return true;
+    }
+
+    void RecordWriter::WriteCaps(std::span<const uint64_t> capWords)
+    {
+        WritePod_(file_, RecordTag::Caps);
+        WriteVarint_(file_, capWords.size_bytes());
+        file_.write(reinterpret_cast<const char*>(capWords.data()), capWords.size_bytes());
+        file_.flush();
+    }
+
+    void RecordWriter::WriteSample(std::span<const std::byte> sample)
+    {
+        if (sample.size() != previous_.size()) {
+            throw Except<TelementryException>("Telemetry sample size does not match recording");
+        }
+        encoded_.clear();
+        EncodeDelta_(sample, previous_, encoded_);
+        std::ranges::copy(sample, previous_.begin());
+        WritePod_(file_, RecordTag::Sample);
+        WriteVarint_(file_, encoded_.size());
+        file_.write(reinterpret_cast<const char*>(encoded_.data()), encoded_.size());
+        if (++unflushed_ >= flushInterval_) {
+            Flush();
+        }
+    }
+
+    void RecordWriter::Flush()
+    {
+        file_.flush();
+        unflushed_ = 0;
+    }
+
+    DeviceInfo ReadDeviceInfo(const std::filesystem::path& path)
+    {
+        RawRecording rec;
+        OpenAndReadHeader_(path, rec);
+        return rec.info;
+    }
+
+    RawRecording ReadRecording(const std::filesystem::path& path)
+    {
+        RawRecording rec;
+        auto file = OpenAndReadHeader_(path, rec);
+        std::vector<std::byte> current(rec.sampleSize);
+        std::vector<std::byte> payload;
+        // a recording cut short (e.g. by the service being killed) ends at its last complete record
+        rec.validSize = uint64_t(file.tellg());
+        RecordTag tag;
+        uint64_t length;
+        while (ReadPod_(file, tag) && ReadVarint_(file, length)) {
+            payload.resize(length);
+            if (!file.read(reinterpret_cast<char*>(payload.data()), length)) {
+                break;
+            }
+            if (tag == RecordTag::Caps) {
+                const auto wordCount = length / sizeof(uint64_t);
+                rec.capWords.resize(std::max(rec.capWords.size(), size_t(wordCount)));
+                for (size_t i = 0; i < wordCount; i++) {
+                    uint64_t word;
+                    std::memcpy(&word, payload.data() + i * sizeof(uint64_t), sizeof(word));
+                    rec.capWords[i] |= word;
+                }
+            }
+            else if (tag == RecordTag::Sample) {
+                if (!DecodeDelta_(payload, current)) {
+                    throw Except<TelementryException>("Corrupt sample in telemetry recording: " + path.string());
+                }
+                rec.samples.insert(rec.samples.end(), current.begin(), current.end());
+                rec.sampleCount++;
+            }
+            else {
+                throw Except<TelementryException>("Unknown record in telemetry recording: " + path.string());
+            }
+            rec.validSize = uint64_t(file.tellg());
+        }
+        return rec;
+    }
+
+    std::string MakeRecordingFileName(DeviceKind kind, PM_DEVICE_VENDOR vendor, size_t index)
+    {
+        if (kind == DeviceKind::Cpu) {
+            return std::format("cpu-{}.pmtr", index);
+        }
+        const auto vendorName = [vendor] {
+            switch (vendor) {
+            case PM_DEVICE_VENDOR_INTEL: return "intel";
+            case PM_DEVICE_VENDOR_NVIDIA: return "nvidia";
+            case PM_DEVICE_VENDOR_AMD: return "amd";
+            default: return "unknown";
+            }
+        }();
+        return std::format("gpu-{}-{}.pmtr", vendorName, index);
+    }
+
+    std::vector<std::filesystem::path> FindRecordings(const std::filesystem::path& directory, DeviceKind kind,
+        PM_DEVICE_VENDOR vendor)
+    {
+        std::vector<std::filesystem::path> paths;
+        for (auto& entry : std::filesystem::directory_iterator{ directory }) {
+            if (!entry.is_regular_file() || entry.path().extension() != ".pmtr") {
+                continue;
+            }
+            const auto info = ReadDeviceInfo(entry.path());
+            if (info.kind == kind && (kind == DeviceKind::Cpu || info.vendor == vendor)) {
+                paths.push_back(entry.path());
+            }
+        }
+        std::ranges::sort(paths);
+        return paths;
+    }
+}
@@ -0,0 +1,201 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include "../PresentMonAPI2/PresentMonAPI.h"
+#include "Exceptions.h"
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <span>
+#include <bitset>
+#include <cstring>
+#include <cstdint>
+#include <type_traits>
+#include <optional>
+
+// compact binary recordings of telemetry samples, used to replay telemetry without the hardware
+// file layout: header, device info, then a stream of tagged records (cap bits or samples)
+// each sample is xor'd against the previous one and the zero runs of the result are length encoded,
+// which shrinks the mostly unchanging telemetry structs down to a handful of bytes per sample
+namespace pwr::rec
+{
+    enum class DeviceKind : uint32_t
+    {
+        Gpu,
+        Cpu,
+    };
+
+    struct DeviceInfo
+    {
+        DeviceKind kind = DeviceKind::Gpu;
+        PM_DEVICE_VENDOR vendor = PM_DEVICE_VENDOR_UNKNOWN;
+        std::string name;
+        uint64_t dedicatedVideoMemory = 0;
+        uint64_t videoMemoryMaxBandwidth = 0;
+        double sustainedPowerLimit = 0.;
+    };
+
+    class RecordWriter
+    {
+    public:
+        // an existing recording of the same device at path is continued, so that re-creating the writer
+        // (e.g. when telemetry is repopulated after a device reset) does not wipe it; an existing file for a
+        // different device or sample layout is rotated aside to <path>.<n>
+        RecordWriter(const std::filesystem::path& path, const DeviceInfo& info, uint32_t sampleSize);
+        void WriteCaps(std::span<const uint64_t> capWords);
+        void WriteSample(std::span<const std::byte> sample);
+        void Flush();
+    private:
+        bool TryResume_(const std::filesystem::path& path, const DeviceInfo& info, uint32_t sampleSize);
+        // samples are flushed to disk in batches to keep per-sample cost down
+        static constexpr size_t flushInterval_ = 256;
+        std::ofstream file_;
+        std::vector<std::byte> previous_;
+        std::vector<std::byte> encoded_;
+        size_t unflushed_ = 0;
+    };
+
+    struct RawRecording
+    {
+        DeviceInfo info;
+        uint64_t qpcFrequency = 0;
+        uint32_t sampleSize = 0;
+        size_t sampleCount = 0;
+        // size of the file up to the end of the last complete record
+        uint64_t validSize = 0;
+        // decoded samples, packed at sampleSize stride
+        std::vector<std::byte> samples;
+        // union of all cap bits recorded
+        std::vector<uint64_t> capWords;
+    };
+
+    // reads just the header and device info
+    DeviceInfo ReadDeviceInfo(const std::filesystem::path& path);
+    RawRecording ReadRecording(const std::filesystem::path& path);
+
+    template<class T>
+    struct Recording
+    {
+        DeviceInfo info;
+        uint64_t qpcFrequency = 0;
+        std::vector<T> samples;
+        std::vector<uint64_t> capWords;
+    };
+
+    template<class T>
+    Recording<T> LoadRecording(const std::filesystem::path& path)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto raw = ReadRecording(path);
+        if (raw.sampleSize != sizeof(T)) {
+            throw Except<TelementryException>("Telemetry recording sample layout does not match this build");
+        }
+        Recording<T> rec{ .info = std::move(raw.info), .qpcFrequency = raw.qpcFrequency,
+            .capWords = std::move(raw.capWords) };
+        rec.samples.resize(raw.sampleCount);
+        std::memcpy(rec.samples.data(), raw.samples.data(), raw.samples.size());
+        return rec;
+    }
+
+    // file name used for a device's recording within a record/replay directory
+    std::string MakeRecordingFileName(DeviceKind kind, PM_DEVICE_VENDOR vendor, size_t index);
+    // recordings in a directory for devices of the given kind (and vendor for gpus), ordered by file name
+    std::vector<std::filesystem::path> FindRecordings(const std::filesystem::path& directory, DeviceKind kind,
+        PM_DEVICE_VENDOR vendor = PM_DEVICE_VENDOR_UNKNOWN);
+
+    // plays back recorded samples against the local qpc timeline, optionally accelerated
+    // the recording loops so that replay can run indefinitely; samples are restamped so that their qpc
+    // reflects when they were (virtually) taken on this machine
+    template<class T>
+    class ReplayCursor
+    {
+    public:
+        ReplayCursor(std::vector<T> samples, uint64_t recordedFrequency, uint64_t localFrequency, double speed)
+            :
+            samples_{ std::move(samples) },
+            recordedPeriod_{ 1. / double(recordedFrequency) },
+            localFrequency_{ double(localFrequency) },
+            speed_{ speed }
+        {
+            if (samples_.empty()) {
+                return;
+            }
+            // loop length includes one average sample interval so the seam keeps the recorded cadence
+            const auto span = RecordedTime_(samples_.size() - 1);
+            loopLength_ = samples_.size() > 1 ? span + span / double(samples_.size() - 1) : 1.;
+        }
+        // calls push for every sample due by nowQpc, returns the number of samples pushed
+        // when replay falls more than a loop behind (e.g. sampling was dormant), it skips ahead to the current loop
+        template<class F>
+        size_t Advance(uint64_t nowQpc, F&& push)
+        {
+            if (samples_.empty()) {
+                return 0;
+            }
+            if (!startQpc_) {
+                startQpc_ = nowQpc;
+            }
+            const auto elapsed = double(nowQpc - *startQpc_) / localFrequency_ * speed_;
+            if (const auto currentLoop = uint64_t(elapsed / loopLength_); currentLoop > loop_ + 1) {
+                loop_ = currentLoop;
+                next_ = 0;
+            }
+            size_t pushed = 0;
+            while (true) {
+                const auto t = double(loop_) * loopLength_ + RecordedTime_(next_);
+                if (t > elapsed) {
+                    break;
+                }
+                auto sample = samples_[next_];
+                sample.qpc = *startQpc_ + uint64_t(t / speed_ * localFrequency_);
+                push(sample);
+                pushed++;
+                if (++next_ == samples_.size()) {
+                    next_ = 0;
+                    loop_++;
+                }
+            }
+            return pushed;
+        }
+        size_t GetSampleCount() const
+        {
+            return samples_.size();
+        }
+    private:
+        double RecordedTime_(size_t i) const
+        {
+            return double(samples_[i].qpc - samples_.front().qpc) * recordedPeriod_;
+        }
+        std::vector<T> samples_;
+        double recordedPeriod_;
+        double localFrequency_;
+        double speed_;
+        double loopLength_ = 1.;
+        std::optional<uint64_t> startQpc_;
+        uint64_t loop_ = 0;
+        size_t next_ = 0;
+    };
+
+    template<size_t N>
+    std::vector<uint64_t> BitsetToWords(const std::bitset<N>& bits)
+    {
+        std::vector<uint64_t> words((N + 63) / 64);
+        for (size_t i = 0; i < N; i++) {
+            if (bits.test(i)) {
+                words[i / 64] |= 1ull << (i % 64);
+            }
+        }
+        return words;
+    }
+
+    template<size_t N>
+    std::bitset<N> WordsToBitset(std::span<const uint64_t> words)
+    {
+        std::bitset<N> bits;
+        for (size_t i = 0; i < N && i / 64 < words.size(); i++) {
+            bits.set(i, (words[i / 64] >> (i % 64)) & 1);
+        }
+        return bits;
+    }
+}
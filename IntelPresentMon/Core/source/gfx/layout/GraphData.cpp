@@ -2,9 +2,8 @@
 // SPDX-License-Identifier: MIT
 #include "GraphData.h"
 #include <algorithm>
-#include <ranges>
-
-namespace rn = std::ranges;
+#include <cmath>
+#include <limits>
 
 namespace p2c::gfx::lay
 {
@@ -12,68 +11,66 @@ namespace p2c::gfx::lay
 		:
 		timeWindow{ timeWindow }
 	{}
-	DataPoint& GraphData::operator[](size_t i)
-	{
-		return data[i];
-	}
-	const DataPoint& GraphData::operator[](size_t i) const
-	{
-		return data[i];
-	}
-	DataPoint& GraphData::Front()
+	DataPoint GraphData::operator[](size_t i) const
 	{
-		return data.front();
+		const auto v = values[i];
+		return { std::isnan(v) ? std::nullopt : std::optional{ v }, times[i] };
 	}
-	const DataPoint& GraphData::Front() const
+	DataPoint GraphData::Front() const
 	{
-		return data.front();
+		return (*this)[0];
 	}
-	DataPoint& GraphData::Back()
+	DataPoint GraphData::Back() const
 	{
-		return data.back();
-	}
-	const DataPoint& GraphData::Back() const
-	{
-		return data.back();
+		return (*this)[Size() - 1];
 	}
 	void GraphData::Push(const DataPoint& dp)
 	{
-		data.push_front(dp);
+		times.PushFront(dp.time);
+		values.PushFront(dp.value.value_or(std::numeric_limits<float>::quiet_NaN()));
 		if (dp.value.has_value()) {
 			min.Push(*dp.value);
 			max.Push(*dp.value);
 		}
+		AddToColumns_(dp.time, dp.value.value_or(0.f));
+		std::erase_if(histograms, [](const auto& p) { return p.expired(); });
+		for (auto& p : histograms) {
+			p.lock()->OnPush_(*this);
+		}
 	}
 	size_t GraphData::Size() const
 	{
-		return data.size();
+		return times.Size();
 	}
 	void GraphData::Trim(double now)
 	{
 		const auto cutoff = now - timeWindow;
-		// find iterator pair that marks all data points that are
-		// outside the time window, except the last one, by reverse scan
-		auto ri = data.rbegin();
-		const auto rend = data.rend();
-		while (rend - ri > 2 && std::next(ri)->time < cutoff) {
-			ri++;
-		}
-		// convert iterator pair to normal iterators
-		const auto i = ri.base();
-		const auto end = data.end();
-		// remove all in range from the extreme queue
-		for (const auto& d : rn::subrange{ data.rbegin(), ri }) {
-			if (d.value.has_value()) {
-				min.Pop(*d.value);
-				max.Pop(*d.value);
+		// remove all data points that are outside the time window, except the newest of those
+		while (Size() > 2 && times[Size() - 2] < cutoff) {
+			if (const auto v = values.Back(); !std::isnan(v)) {
+				min.Pop(v);
+				max.Pop(v);
+			}
+			for (auto& p : histograms) {
+				if (auto pHist = p.lock()) {
+					pHist->OnPopBack_(*this);
+				}
+			}
+			times.PopBack();
+			values.PopBack();
+		}
+		// remove columns that no longer hold any remaining data point
+		if (Size()) {
+			const auto oldest = times.Back();
+			while (columns.Size() > 1 && columns.Back().lastTime < oldest) {
+				columns.PopBack();
 			}
 		}
-		// erase all in range from data buffer
-		data.erase(i, end);
 	}
 	void GraphData::Resize(double window)
 	{
 		timeWindow = window;
+		RebuildColumns_();
 	}
 	std::optional<float> GraphData::Min() const
 	{
@@ -87,4 +84,179 @@ namespace p2c::gfx::lay
 	{
 		return timeWindow;
 	}
-}
\ No newline at end of file
+	void GraphData::RequestColumns(size_t columnCount)
+	{
+		if (columnCount > requestedColumns) {
+			requestedColumns = columnCount;
+			RebuildColumns_();
+		}
+	}
+	const DecimatedColumn& GraphData::GetColumn(size_t i) const
+	{
+		return columns[i];
+	}
+	size_t GraphData::GetColumnCount() const
+	{
+		return columns.Size();
+	}
+	void GraphData::MakeDecimatedLine(std::vector<DataPoint>& vertices) const
+	{
+		vertices.clear();
+		const auto dataSize = Size();
+		if (dataSize == 0) {
+			return;
+		}
+		const auto columnCount = GetColumnCount();
+		// not decimated (plot has no width yet), use samples directly
+		if (columnCount == 0) {
+			for (size_t i = 0; i < dataSize; i++) {
+				vertices.push_back((*this)[i]);
+			}
+			return;
+		}
+		// the newest sample anchors the right end of the line even when it is not an extreme of its column
+		const auto newest = Front();
+		vertices.push_back({ newest.value.value_or(0.f), newest.time });
+		// min/max of each pixel column, later extreme first since we go from newest to oldest
+		for (size_t i = 0; i < columnCount; i++) {
+			const auto& col = GetColumn(i);
+			if (const auto second = col.Second(); second.time < newest.time) {
+				vertices.push_back(second);
+			}
+			if (const auto first = col.First(); col.minTime != col.maxTime && first.time < newest.time) {
+				vertices.push_back(first);
+			}
+		}
+	}
+
+	void GraphData::AttachHistogram(std::shared_ptr<HistogramBins> pHistogram)
+	{
+		histograms.push_back(pHistogram);
+	}
+	void GraphData::AddToColumns_(double time, float value)
+	{
+		if (columnWidth <= 0.) {
+			return;
+		}
+		const auto index = (int64_t)std::floor(time / columnWidth);
+		if (!columns.Empty() && columns.Front().index == index) {
+			auto& col = columns.Front();
+			if (value < col.minValue) {
+				col.minValue = value;
+				col.minTime = time;
+			}
+			if (value > col.maxValue) {
+				col.maxValue = value;
+				col.maxTime = time;
+			}
+			col.lastTime = time;
+		}
+		else {
+			columns.PushFront(DecimatedColumn{ index, time, value, time, value, time });
+		}
+	}
+	void GraphData::RebuildColumns_()
+	{
+		columns.Clear();
+		columnWidth = requestedColumns ? timeWindow / double(requestedColumns) : 0.;
+		for (size_t i = Size(); i-- > 0;) {
+			AddToColumns_(times[i], std::isnan(values[i]) ? 0.f : values[i]);
+		}
+	}
+
+	void HistogramBins::Configure(const GraphData& data, float minValue_, float maxValue_, int binCount_, double timeWindow_)
+	{
+		if (minValue == minValue_ && maxValue == maxValue_ && binCount == binCount_ && timeWindow == timeWindow_) {
+			return;
+		}
+		minValue = minValue_;
+		maxValue = maxValue_;
+		binCount = std::max(binCount_, 0);
+		timeWindow = timeWindow_;
+		binSize = (maxValue - minValue) / float(binCount);
+		bins.assign(size_t(binCount), 0);
+		countFrequency.assign(1, binCount);
+		maxCount = 0;
+		windowCount = 0;
+		// rebin the samples in the window, newest to oldest
+		if (data.Size()) {
+			const auto cutoff = data.Front().time - timeWindow;
+			for (; windowCount < data.Size(); windowCount++) {
+				const auto d = data[windowCount];
+				if (d.time <= cutoff) {
+					break;
+				}
+				if (d.value) {
+					Add_(*d.value);
+				}
+			}
+		}
+	}
+	const std::vector<int>& HistogramBins::GetBins() const
+	{
+		return bins;
+	}
+	int HistogramBins::GetMaxCount() const
+	{
+		return maxCount;
+	}
+	int HistogramBins::BinIndex_(float value) const
+	{
+		// also rejects NaN from a degenerate (empty) value range
+		if (const auto pos = (value - minValue) / binSize; pos >= 0.f && pos < float(binCount)) {
+			return int(pos);
+		}
+		return -1;
+	}
+	void HistogramBins::Add_(float value)
+	{
+		if (const auto iBin = BinIndex_(value); iBin >= 0) {
+			const auto count = ++bins[size_t(iBin)];
+			if (size_t(count) == countFrequency.size()) {
+				countFrequency.push_back(0);
+			}
+			countFrequency[count - 1]--;
+			countFrequency[count]++;
+			maxCount = std::max(maxCount, count);
+		}
+	}
+	void HistogramBins::Remove_(float value)
+	{
+		if (const auto iBin = BinIndex_(value); iBin >= 0) {
+			const auto count = --bins[size_t(iBin)];
+			countFrequency[count + 1]--;
+			countFrequency[count]++;
+			if (countFrequency[maxCount] == 0) {
+				maxCount--;
+			}
+		}
+	}
+	void HistogramBins::OnPush_(const GraphData& data)
+	{
+		if (const auto v = data.values.Front(); !std::isnan(v)) {
+			Add_(v);
+		}
+		windowCount++;
+		Expire_(data);
+	}
+	void HistogramBins::OnPopBack_(const GraphData& data)
+	{
+		// oldest sample is about to be removed from data while still in the histogram window
+		if (windowCount == data.Size()) {
+			if (const auto v = data.values.Back(); !std::isnan(v)) {
+				Remove_(v);
+			}
+			windowCount--;
+		}
+	}
+	void HistogramBins::Expire_(const GraphData& data)
+	{
+		const auto cutoff = data.times.Front() - timeWindow;
+		while (windowCount > 0 && data.times[windowCount - 1] <= cutoff) {
+			if (const auto v = data.values[windowCount - 1]; !std::isnan(v)) {
+				Remove_(v);
+			}
+			windowCount--;
+		}
+	}
+}
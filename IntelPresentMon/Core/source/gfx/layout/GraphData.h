@@ -2,6 +2,10 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 #include <deque>
+#include <vector>
+#include <optional>
+#include <cstdint>
+#include <memory>
 #include <functional>
 #include <algorithm>
 #include <Core/source/gfx/base/Geometry.h>
@@ -76,23 +80,138 @@ namespace p2c::gfx::lay
 	using MaxQueue = ExtremeQueue<std::less<float>, std::greater<float>>;
 	using MinQueue = ExtremeQueue<std::greater<float>, std::less<float>>;
 
+	// RingBuffer is a growable circular buffer indexed from newest (0) to oldest (Size() - 1)
+	// capacity is a power of 2 and only grows when pushing into a full buffer, so it settles
+	// at the steady state size of the window and no further allocation happens
+	template<typename T>
+	class RingBuffer
+	{
+	public:
+		void PushFront(const T& el)
+		{
+			if (count == buffer.size()) {
+				Grow_();
+			}
+			buffer[head] = el;
+			head = (head + 1) & (buffer.size() - 1);
+			count++;
+		}
+		void PopBack()
+		{
+			count--;
+		}
+		T& operator[](size_t i)
+		{
+			return buffer[(head - 1 - i) & (buffer.size() - 1)];
+		}
+		const T& operator[](size_t i) const
+		{
+			return buffer[(head - 1 - i) & (buffer.size() - 1)];
+		}
+		T& Front() { return (*this)[0]; }
+		const T& Front() const { return (*this)[0]; }
+		T& Back() { return (*this)[count - 1]; }
+		const T& Back() const { return (*this)[count - 1]; }
+		size_t Size() const { return count; }
+		bool Empty() const { return count == 0; }
+		size_t Capacity() const { return buffer.size(); }
+		void Clear()
+		{
+			count = 0;
+		}
+	private:
+		void Grow_()
+		{
+			std::vector<T> grown(std::max(buffer.size() * 2, size_t(16)));
+			// unwrap oldest to newest
+			for (size_t i = 0; i < count; i++) {
+				grown[i] = (*this)[count - 1 - i];
+			}
+			buffer = std::move(grown);
+			head = count;
+		}
+		std::vector<T> buffer;
+		size_t head = 0;
+		size_t count = 0;
+	};
+
+	// min/max of the samples falling into one pixel column of a plot
+	// columns are aligned to absolute time, so they are stable while the plot scrolls
+	struct DecimatedColumn
+	{
+		// floor(time / column width)
+		int64_t index;
+		double minTime;
+		float minValue;
+		double maxTime;
+		float maxValue;
+		// time of newest sample in the column
+		double lastTime;
+		// extremes in the order that they occurred, for drawing
+		DataPoint First() const
+		{
+			return minTime <= maxTime ? DataPoint{ minValue, minTime } : DataPoint{ maxValue, maxTime };
+		}
+		DataPoint Second() const
+		{
+			return minTime <= maxTime ? DataPoint{ maxValue, maxTime } : DataPoint{ minValue, minTime };
+		}
+	};
+
+	class GraphData;
+
+	// histogram over the newest samples of a GraphData within a time window
+	// kept incrementally: GraphData adds samples to bins on push and removes them as they age out of
+	// the window or are trimmed, so reading it costs O(binCount) regardless of window size
+	// a full rebin only happens when the value range, bin count or window changes
+	class HistogramBins
+	{
+		friend class GraphData;
+	public:
+		// rebins from the samples currently in data if any parameter changed
+		void Configure(const GraphData& data, float minValue, float maxValue, int binCount, double timeWindow);
+		const std::vector<int>& GetBins() const;
+		// count of the fullest bin
+		int GetMaxCount() const;
+	private:
+		// functions
+		int BinIndex_(float value) const;
+		void Add_(float value);
+		void Remove_(float value);
+		void OnPush_(const GraphData& data);
+		void OnPopBack_(const GraphData& data);
+		void Expire_(const GraphData& data);
+		// data
+		float minValue = 0.f;
+		float maxValue = 0.f;
+		float binSize = 0.f;
+		int binCount = 0;
+		double timeWindow = 0.;
+		std::vector<int> bins;
+		// number of bins having each count, lets max count drop without rescanning the bins
+		std::vector<int> countFrequency{ 0 };
+		int maxCount = 0;
+		// number of newest samples of the data that are inside the window (binned or empty)
+		size_t windowCount = 0;
+	};
+
 	// GraphData is a container for data to be displayed in a GraphElement
-	// conceptually it is a circular buffer
+	// it is a circular buffer with time and value stored in separate arrays
+	// alongside the samples, it maintains a min/max per pixel column decimation of the window
+	// that is updated as samples arrive, so that plot draw cost is bounded by pixel width
+	// instead of by poll rate x window length
 	// time of entries must be added in increasing order
 	class GraphData
 	{
+		friend class HistogramBins;
 	public:
 		GraphData(double timeWindow);
-		DataPoint& operator[](size_t i);
-		const DataPoint& operator[](size_t i) const;
+		// sample i (0 => newest), empty values are stored as NaN
+		DataPoint operator[](size_t i) const;
 		// newest sample
-		DataPoint& Front();
-		// newest sample
-		const DataPoint& Front() const;
-		// oldest sample
-		DataPoint& Back();
+		DataPoint Front() const;
 		// oldest sample
-		const DataPoint& Back() const;
+		DataPoint Back() const;
 		void Push(const DataPoint& data);
 		size_t Size() const;
 		void Trim(double now);
@@ -100,12 +219,32 @@ namespace p2c::gfx::lay
 		std::optional<float> Min() const;
 		std::optional<float> Max() const;
 		double GetWindowSize() const;
+		// plots request the number of pixel columns they draw into; data shared between plots
+		// decimates at the finest resolution requested
+		void RequestColumns(size_t columnCount);
+		// decimated view, column i (0 => newest)
+		// empty values count as 0 here, matching how they are drawn
+		const DecimatedColumn& GetColumn(size_t i) const;
+		size_t GetColumnCount() const;
+		// vertices of the line through the decimated view, newest to oldest, at most 2 per column + 1
+		void MakeDecimatedLine(std::vector<DataPoint>& vertices) const;
+		// histogram will be kept up to date with samples as they are pushed and trimmed
+		// held weakly, detaches when the histogram is destroyed
+		void AttachHistogram(std::shared_ptr<HistogramBins> pHistogram);
 	private:
+		// functions
+		void AddToColumns_(double time, float value);
+		void RebuildColumns_();
 		// data
 		double timeWindow;
-		std::deque<DataPoint> data;
+		RingBuffer<double> times;
+		RingBuffer<float> values;
 		MinQueue min;
 		MaxQueue max;
+		size_t requestedColumns = 0;
+		double columnWidth = 0.;
+		RingBuffer<DecimatedColumn> columns;
+		std::vector<std::weak_ptr<HistogramBins>> histograms;
 	}; // TODO: only track min/max when auto range adjustment is active (might be tricky)
 
 	// GraphLinePack combines graph data (which may be shared among widgets)
@@ -18,44 +18,25 @@ namespace p2c::gfx::lay
 	HistogramPlotElement::HistogramPlotElement(std::shared_ptr<GraphLinePack> pPack_, std::vector<std::string> classes_)
 		:
 		PlotElement{ {}, std::move(classes_) },
-		pPack{ pPack_ }
-	{}
+		pPack{ pPack_ },
+		pBins{ std::make_shared<HistogramBins>() }
+	{
+		pPack->data->AttachHistogram(pBins);
+		Rebin_();
+	}
 
 	HistogramPlotElement::~HistogramPlotElement() {}
 
 	void HistogramPlotElement::Draw_(Graphics& gfx) const
 	{
-		const auto& data = *pPack->data;
-
 		const auto port = GetContentRect();
 		const auto dims = port.GetDimensions();
 		const auto yScale = dims.height / float(maxCount - minCount);
 		const auto yBias = minCount;
 		const auto yOffset = port.bottom;
 
-		// initialize histogram bins
-		bins.resize(binCount);
-		std::ranges::fill(bins, 0);
-		const auto binSize = (maxValue - minValue) / float(binCount);
-		autoMaxCount = 0; // for autosizing
-
-		// sort datapoints into bins
-		const auto dataSize = data.Size();
-		const auto cutoff = (dataSize > 0 ? data.Front().time : 0.f) - timeWindow;
-		for (size_t i = 0; i < dataSize; i++)
-		{
-			const auto& d = data[i];
-			// exit early if outside of time window of considering, or not valid data
-			if (d.time <= cutoff || !d.value)
-			{
-				break;
-			}
-			const int iBin = int((*d.value - minValue) / binSize);
-			if (iBin >= 0 && iBin < binCount)
-			{
-				autoMaxCount = std::max(autoMaxCount, bins[size_t(iBin)] += 1);
-			}
-		}
+		// bins are kept up to date as data is pushed and trimmed
+		const auto& bins = pBins->GetBins();
 
 		DrawGrid(gfx, port, hDivs, vDivs, gridColor);
 
@@ -101,17 +82,20 @@ namespace p2c::gfx::lay
 		vDivs = sp.Resolve<sty::at::graphVerticalDivs>();
 		binCount = sp.Resolve<sty::at::graphBinCount>();
 		PlotElement::SetPosition_(pos, dimensions, sp, gfx);
+		Rebin_();
 	}
 
 	void HistogramPlotElement::SetValueRangeLeft(float min, float max)
 	{
 		minValue = min;
 		maxValue = max;
+		Rebin_();
 	}
 
 	void HistogramPlotElement::SetTimeWindow(float dt)
 	{
 		timeWindow = dt;
+		Rebin_();
 	}
 
 	void HistogramPlotElement::SetCountRange(int min, int max)
@@ -122,6 +106,12 @@ namespace p2c::gfx::lay
 
 	int HistogramPlotElement::GetMaxCount() const
 	{
-		return autoMaxCount;
+		return pBins->GetMaxCount();
+	}
+
+	void HistogramPlotElement::Rebin_()
+	{
+		// no-op unless one of the parameters changed
+		pBins->Configure(*pPack->data, minValue, maxValue, binCount, timeWindow);
 	}
 }
\ No newline at end of file
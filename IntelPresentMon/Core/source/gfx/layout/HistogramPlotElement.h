@@ -7,6 +7,7 @@
 namespace p2c::gfx::lay
 {
 	struct GraphLinePack;
+	class HistogramBins;
 
 	class HistogramPlotElement : public PlotElement
 	{
@@ -22,6 +23,8 @@ namespace p2c::gfx::lay
 		void Draw_(Graphics& gfx) const override;
 		void SetPosition_(const Vec2& pos, const Dimensions& dimensions, sty::StyleProcessor& sp, Graphics& gfx) override;
 	private:
+		// functions
+		void Rebin_();
 		// data
 		float minValue = 0;
 		float maxValue = 100;
@@ -32,8 +35,7 @@ namespace p2c::gfx::lay
 		int hDivs = 20;
 		int vDivs = 4;
 		Color gridColor{};
-		mutable std::vector<int> bins;
-		mutable int autoMaxCount = 0;
 		std::shared_ptr<GraphLinePack> pPack;
+		std::shared_ptr<HistogramBins> pBins;
 	};
 }
\ No newline at end of file
@@ -54,14 +54,13 @@ namespace p2c::gfx::lay
 		DrawGrid(gfx, port, hDivs, vDivs, gridColor);
 
 		for (const auto& pack : packs) {
-			const auto& pData = pack->data;
-			const auto dataSize = pData->Size();
-			const auto& data = *pData;
-			if (dataSize >= 2) { // a line needs at least 2 points
-				const auto cutoff = xBias - timeWindow;
+			const auto& data = *pack->data;
+			data.MakeDecimatedLine(vertices);
+			const auto vertexCount = vertices.size();
+			if (vertexCount >= 2) { // a line needs at least 2 points
 				// HACK: if the most recent sample is not t=0 (relative to graph rhs), we add t=0 with the same value
 				// as the most recent sample and adjust looping
-				DataPoint first = data.Front();
+				DataPoint first = vertices.front();
 				size_t iStart = 1;
 				if (!util::EpsilonEqual(first.time, xBias)) {
 					first.time = xBias;
@@ -80,12 +79,12 @@ namespace p2c::gfx::lay
 						const auto p = MakePeak(first);
 						gfx.FastPeakStart(p.first, p.second, pack->fillColor);
 					}
-					for (size_t i = iStart; i < dataSize - 1; i++) {
-						const auto p = MakePeak(data[i]);
+					for (size_t i = iStart; i < vertexCount - 1; i++) {
+						const auto p = MakePeak(vertices[i]);
 						gfx.FastPeakAdd(p.first, p.second);
 					}
 					{
-						const auto p = MakePeak(data.Back());
+						const auto p = MakePeak(vertices.back());
 						gfx.FastPeakEnd(p.first, p.second);
 					}
 					gfx.FastBatchEnd();
@@ -94,10 +93,10 @@ namespace p2c::gfx::lay
 				if (pack->lineColor.a != 0.f) {
 					gfx.FastLineBatchStart(port, aa);
 					gfx.FastLineStart(ComputeScreen(first, pack->axisAffinity), pack->lineColor);
-					for (size_t i = iStart; i < dataSize - 1; i++) {
-						gfx.FastLineAdd(ComputeScreen(data[i], pack->axisAffinity));
+					for (size_t i = iStart; i < vertexCount - 1; i++) {
+						gfx.FastLineAdd(ComputeScreen(vertices[i], pack->axisAffinity));
 					}
-					gfx.FastLineEnd(ComputeScreen(data.Back(), pack->axisAffinity));
+					gfx.FastLineEnd(ComputeScreen(vertices.back(), pack->axisAffinity));
 					gfx.FastBatchEnd();
 				}
 			}
@@ -111,6 +110,10 @@ namespace p2c::gfx::lay
 		vDivs = sp.Resolve<sty::at::graphVerticalDivs>();
 		aa = sp.Resolve<sty::at::graphAntiAlias>();
 		PlotElement::SetPosition_(pos, dimensions, sp, gfx);
+		// decimate graph data down to one min/max pair per pixel column of the plot
+		for (auto& pack : packs) {
+			pack->data->RequestColumns(size_t(std::ceil(dimensions.width)));
+		}
 	}
 
 	void LinePlotElement::SetValueRangeLeft(float min, float max)
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 #include "PlotElement.h"
+#include "GraphData.h"
 
 
 namespace p2c::gfx::lay
@@ -32,5 +33,7 @@ namespace p2c::gfx::lay
 		bool aa = false;
 		bool hasRightAxis = false;
 		std::vector<std::shared_ptr<GraphLinePack>> packs;
+		// scratch buffer for the decimated line, reused between draws
+		mutable std::vector<DataPoint> vertices;
 	};
 }
\ No newline at end of file
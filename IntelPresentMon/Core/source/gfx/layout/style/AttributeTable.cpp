@@ -0,0 +1,20 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include "AttributeTable.h"
+#include <unordered_map>
+
+namespace p2c::gfx::lay::sty::at
+{
+	std::optional<AttributeId> FindAttributeId(std::string_view key)
+	{
+#define DEF_ATT(name, resolved, simp, aut, def) { name::key, AttributeId::name },
+		static const std::unordered_map<std::string_view, AttributeId> ids{
+			XAT_ATTRIBUTE_LIST(DEF_ATT)
+		};
+#undef DEF_ATT
+		if (auto i = ids.find(key); i != ids.end()) {
+			return i->second;
+		}
+		return {};
+	}
+}
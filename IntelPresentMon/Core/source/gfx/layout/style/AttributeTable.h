@@ -0,0 +1,76 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <tuple>
+#include <optional>
+#include <string_view>
+#include "Attributes.h"
+
+namespace p2c::gfx::lay::sty::at
+{
+	// tuple with the resolved type of every attribute, in attribute id order
+#define DEF_ATT(name, resolved, simp, aut, def) name::ResolvedType,
+	using ResolvedAttributeTuple = std::tuple<XAT_ATTRIBUTE_LIST(DEF_ATT) std::monostate>;
+#undef DEF_ATT
+
+	// values of all attributes, indexed by attribute id
+	// used both for the converted contents of a single sheet (monostate where the sheet does not
+	// have the attribute) and for the fully resolved attributes of an element
+	class AttributeTable
+	{
+	public:
+		template<class A>
+		const typename A::ResolvedType& Get() const
+		{
+			return std::get<(size_t)A::id>(values);
+		}
+		template<class A>
+		typename A::ResolvedType& Get()
+		{
+			return std::get<(size_t)A::id>(values);
+		}
+		template<size_t I>
+		const auto& GetAt() const
+		{
+			return std::get<I>(values);
+		}
+		template<size_t I>
+		auto& GetAt()
+		{
+			return std::get<I>(values);
+		}
+	private:
+		ResolvedAttributeTuple values;
+	};
+
+	// maps attribute key string to its id, empty if there is no such attribute
+	std::optional<AttributeId> FindAttributeId(std::string_view key);
+
+	// converts resolved attribute value to the type returned from style resolution
+	template<class A>
+	auto UnwrapResolved(const typename A::ResolvedType& resolved)
+	{
+		// if guaranteed to resolve to a single type, just return that type (and not variant)
+		if constexpr (A::isSimplex && !A::isOptAuto)
+		{
+			return std::get<1>(resolved);
+		}
+		// if guaranteed to resolve to either a single type or @auto, return optional (empty means @auto)
+		else if constexpr (A::isSimplex && A::isOptAuto)
+		{
+			using OptType = std::optional<std::variant_alternative_t<1, typename A::ResolvedType>>;
+			if (std::holds_alternative<at::Special::Auto>(resolved))
+			{
+				return OptType{};
+			}
+			else
+			{
+				return OptType{ std::get<1>(resolved) };
+			}
+		}
+		else
+		{
+			return resolved;
+		}
+	}
+}
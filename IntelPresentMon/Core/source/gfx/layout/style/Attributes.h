@@ -3,6 +3,7 @@
 #pragma once
 #include <variant>
 #include <string>
+#include <cstdint>
 #include <Core/source/gfx/base/Geometry.h>
 #include "SpecialAttributes.h"
 #include "../Enums.h"
@@ -23,9 +24,9 @@ namespace p2c::gfx::lay::sty::at
 
 // defines set of 4 attributes for skirt (border, margin, etc.)
 #define XAT_DEF_SKIRT(tem, name) \
-	tem(name##Left, ResolvedT<float OR_ at::Special::Inherit>, true, false, 0.); \
-	tem(name##Top, ResolvedT<float OR_ at::Special::Inherit>, true, false, 0.); \
-	tem(name##Right, ResolvedT<float OR_ at::Special::Inherit>, true, false, 0.); \
+	tem(name##Left, ResolvedT<float OR_ at::Special::Inherit>, true, false, 0.) \
+	tem(name##Top, ResolvedT<float OR_ at::Special::Inherit>, true, false, 0.) \
+	tem(name##Right, ResolvedT<float OR_ at::Special::Inherit>, true, false, 0.) \
 	tem(name##Bottom, ResolvedT<float OR_ at::Special::Inherit>, true, false, 0.)
 
 #define XAT_ATTRIBUTE_LIST(tem) \
@@ -70,11 +71,23 @@ namespace p2c::gfx::lay::sty::at
 	XAT_DEF_SKIRT(tem, padding) \
 	XAT_DEF_SKIRT(tem, margin)
 
+	// dense ids of the attributes, used to index compiled attribute tables
+#define DEF_ATT(name, resolved, simp, aut, def) name,
+	enum class AttributeId : uint16_t
+	{
+		XAT_ATTRIBUTE_LIST(DEF_ATT)
+		Count_
+	};
+#undef DEF_ATT
+
+	constexpr size_t attributeCount = (size_t)AttributeId::Count_;
+
 #define DEF_ATT(name, resolved, simp, aut, def) \
 struct name : Attribute \
 { \
 	using ResolvedType = resolved; \
 	static constexpr const char* key = #name; \
+	static constexpr AttributeId id = AttributeId::name; \
 	static constexpr bool isSimplex = simp; \
 	static constexpr bool isOptAuto = aut; \
 };
@@ -7,21 +7,22 @@
 
 namespace p2c::gfx::lay::sty::at
 {
-	template<typename Left, typename Top, typename Right, typename Bottom>
-	Skirt ResolveSkirt(const StyleResolver& resolver)
+	// read only attributes are resolved through either StyleResolver or StyleProcessor
+	template<typename Left, typename Top, typename Right, typename Bottom, class R>
+	Skirt ResolveSkirt(const R& resolver)
 	{
 		return {
-			resolver.Resolve<Left>(),
-			resolver.Resolve<Top>(),
-			resolver.Resolve<Right>(),
-			resolver.Resolve<Bottom>(),
+			resolver.template Resolve<Left>(),
+			resolver.template Resolve<Top>(),
+			resolver.template Resolve<Right>(),
+			resolver.template Resolve<Bottom>(),
 		};
 	}
 
 #define X_DEF_SKIRT(name) \
 struct name : ReadOnlyAttribute \
 { \
-	static Skirt Resolve(const StyleResolver& resolver) \
+	static Skirt Resolve(const auto& resolver) \
 	{ \
 		return ResolveSkirt<at::name##Left, at::name##Top, at::name##Right, at::name##Bottom>(resolver); \
 	} \
@@ -35,9 +36,9 @@ struct name : ReadOnlyAttribute \
 
 	struct size : ReadOnlyAttribute
 	{
-		static DimensionsSpec Resolve(const StyleResolver& resolver)
+		static DimensionsSpec Resolve(const auto& resolver)
 		{
-			return { resolver.Resolve<at::width>(), resolver.Resolve<at::height>() };
+			return { resolver.template Resolve<at::width>(), resolver.template Resolve<at::height>() };
 		}
 	};
 }
\ No newline at end of file
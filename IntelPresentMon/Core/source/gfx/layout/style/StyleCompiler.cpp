@@ -2,13 +2,47 @@
 // SPDX-License-Identifier: MIT
 #include "StyleCompiler.h"
 #include <algorithm>
+#include <utility>
 
 
 namespace p2c::gfx::lay::sty
 {
+	namespace
+	{
+		// first matching sheet having the attribute wins (sheets are in precedence order), inherit takes
+		// the parent's resolved value, and if no sheet has the attribute it comes from base
+		// this gives the same results as resolving the merged sheet against the sheet stack in StyleResolver
+		template<size_t I>
+		void ResolveAttribute_(at::AttributeTable& out, const std::vector<const at::AttributeTable*>& applied,
+			const at::AttributeTable& parent, const at::AttributeTable& base)
+		{
+			using ResolvedType = std::tuple_element_t<I, at::ResolvedAttributeTuple>;
+			for (auto pTable : applied)
+			{
+				auto& value = pTable->GetAt<I>();
+				if (std::holds_alternative<std::monostate>(value))
+				{
+					continue;
+				}
+				if constexpr (at::CanInherit<ResolvedType>())
+				{
+					if (std::holds_alternative<at::Special::Inherit>(value))
+					{
+						out.GetAt<I>() = parent.GetAt<I>();
+						return;
+					}
+				}
+				out.GetAt<I>() = value;
+				return;
+			}
+			out.GetAt<I>() = base.GetAt<I>();
+		}
+	}
+
 	StyleCompiler::FlaggedSheet::FlaggedSheet(std::shared_ptr<Stylesheet> pSheet_)
 		:
-		pSheet{ std::move(pSheet_) }
+		pSheet{ std::move(pSheet_) },
+		pTable{ std::make_shared<const at::AttributeTable>(pSheet->Intern()) }
 	{
 		// setting all sheets without parent selector as unconditionally active
 		if (pSheet->GetSelector().ParentMatches({}))
@@ -86,4 +120,25 @@ namespace p2c::gfx::lay::sty
 		}
 		return pCompiled;
 	}
+	void StyleCompiler::SetBaseSheet(const Stylesheet& base)
+	{
+		baseTable = base.Intern();
+	}
+	at::AttributeTable StyleCompiler::CompileResolved(const std::vector<std::string>& elementClasses, const at::AttributeTable* pParent) const
+	{
+		appliedTables.clear();
+		for (auto& s : sheets)
+		{
+			if (s.IsActive() && s.pSheet->GetSelector().TargetMatches(elementClasses))
+			{
+				appliedTables.push_back(s.pTable.get());
+			}
+		}
+		const auto& parent = pParent ? *pParent : baseTable;
+		at::AttributeTable resolved;
+		[&]<size_t...I>(std::index_sequence<I...>) {
+			(ResolveAttribute_<I>(resolved, appliedTables, parent, baseTable), ...);
+		}(std::make_index_sequence<at::attributeCount>{});
+		return resolved;
+	}
 }
\ No newline at end of file
@@ -23,6 +23,8 @@ namespace p2c::gfx::lay::sty
 
 			// data members
 			std::shared_ptr<Stylesheet> pSheet;
+			// sheet attributes converted once and indexed by attribute id
+			std::shared_ptr<const at::AttributeTable> pTable;
 			// index of the earliest element in DOM parent stack that activates this sheet
 			// -2 signals inactive
 			// -1 signals active by default (no parent selector)
@@ -34,9 +36,19 @@ namespace p2c::gfx::lay::sty
 		void PushParent(std::vector<std::string> classes);
 		void PopParent();
 		void SetSheets(std::vector<std::shared_ptr<Stylesheet>> sheets_);
+		// base sheet supplies values of attributes not set by any matching sheet (needed for CompileResolved)
+		void SetBaseSheet(const Stylesheet& base);
+		// merges matching sheets into a single sheet, to be resolved against the stack of parent sheets
 		std::shared_ptr<Stylesheet> Compile(const std::vector<std::string>& elementClasses) const;
+		// resolves every attribute of an element from the matching sheets, the base sheet and the resolved
+		// attributes of its parent (for @Inherit values), so that attribute lookup is a simple index
+		// pParent null means the element is the root, and it inherits from base
+		at::AttributeTable CompileResolved(const std::vector<std::string>& elementClasses, const at::AttributeTable* pParent) const;
 	private:
 		std::vector<FlaggedSheet> sheets;
 		std::vector<std::vector<std::string>> parentStack;
+		at::AttributeTable baseTable;
+		// scratch list of the tables of sheets applying to the element being compiled
+		mutable std::vector<const at::AttributeTable*> appliedTables;
 	};
 }
\ No newline at end of file
@@ -4,10 +4,15 @@
 #include "StyleCompiler.h"
 #include "StyleResolver.h"
 #include "../Element.h"
+#include <unordered_map>
+#include <vector>
 
 namespace p2c::gfx::lay::sty
 {
-	// ties compiler and resolver together
+	// ties compiler and the stack of resolved element attributes together
+	// each element's attributes are compiled into a fully resolved table the first time the element is
+	// pushed, and reused on every later push during layout (an element always has the same parents, and the
+	// sheets do not change for the lifetime of the processor)
 	class StyleProcessor
 	{
 	public:
@@ -38,29 +43,45 @@ namespace p2c::gfx::lay::sty
 		// functions
 		StyleProcessor(std::vector<std::shared_ptr<Stylesheet>> rules, std::shared_ptr<Stylesheet> pBase)
 			:
-			compiler{ std::move(rules) },
-			resolver{ std::move(pBase) }
-		{}
+			compiler{ std::move(rules) }
+		{
+			compiler.SetBaseSheet(*pBase);
+		}
 		StackToken Push(const Element* pElement)
 		{
-			resolver.PushAppliedSheet(compiler.Compile(pElement->GetClasses()));
+			auto&& [i, inserted] = resolvedCache.try_emplace(pElement);
+			if (inserted)
+			{
+				i->second = compiler.CompileResolved(pElement->GetClasses(),
+					resolvedStack.empty() ? nullptr : resolvedStack.back());
+			}
+			resolvedStack.push_back(&i->second);
 			compiler.PushParent(pElement->GetClasses());
 			return { *this };
 		}
 		template<class A>
 		auto Resolve() const
 		{
-			return resolver.Resolve<A>();
+			// if ReadOnly attribute
+			if constexpr (std::is_base_of_v<at::ReadOnlyAttribute, A>)
+			{
+				return A::Resolve(*this);
+			}
+			else
+			{
+				return at::UnwrapResolved<A>(resolvedStack.back()->Get<A>());
+			}
 		}
 	private:
 		// functions
 		void Pop()
 		{
 			compiler.PopParent();
-			resolver.PopAppliedSheet();
+			resolvedStack.pop_back();
 		}
 		// data
 		StyleCompiler compiler;
-		StyleResolver resolver;
+		std::unordered_map<const Element*, at::AttributeTable> resolvedCache;
+		std::vector<const at::AttributeTable*> resolvedStack;
 	};
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <vector>
 #include <memory>
 #include "Stylesheet.h"
+#include "AttributeTable.h"
 
 namespace p2c::gfx::lay::sty
 {
@@ -35,28 +36,9 @@ namespace p2c::gfx::lay::sty
 			{
 				return A::Resolve(*this);
 			}
-			// if guaranteed to resolve to a single type, just return that type (and not variant)
-			else if constexpr (A::isSimplex && !A::isOptAuto)
-			{
-				return std::get<1>(Resolve_<A>());
-			}
-			// if guaranteed to resolve to either a single type or @auto, return optional (empty means @auto)
-			else if constexpr (A::isSimplex && A::isOptAuto)
-			{
-				auto resolved = Resolve_<A>();
-				using OptType = std::optional<std::variant_alternative_t<1, decltype(resolved)>>;
-				if (std::holds_alternative<at::Special::Auto>(resolved))
-				{
-					return OptType{};
-				}
-				else
-				{
-					return OptType{ std::get<1>(resolved) };
-				}
-			}
 			else
 			{
-				return Resolve_<A>();
+				return at::UnwrapResolved<A>(Resolve_<A>());
 			}
 		}
 	private:
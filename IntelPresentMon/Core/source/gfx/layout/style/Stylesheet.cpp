@@ -5,10 +5,37 @@
 
 namespace p2c::gfx::lay::sty
 {
+	namespace
+	{
+		template<class A>
+		void ConvertRaw_(const at::RawAttributeValue& raw, at::AttributeTable& table)
+		{
+			table.Get<A>() = at::ResolveVariantFromRaw<typename A::ResolvedType>(raw);
+		}
+
+		using RawConverter = void(*)(const at::RawAttributeValue&, at::AttributeTable&);
+
+#define DEF_ATT(name, resolved, simp, aut, def) &ConvertRaw_<at::name>,
+		constexpr RawConverter rawConverters[] = { XAT_ATTRIBUTE_LIST(DEF_ATT) };
+#undef DEF_ATT
+	}
+
 	Stylesheet::Stylesheet(Selector sel)
 		:
 		selector{ std::move(sel) }
 	{}
+	at::AttributeTable Stylesheet::Intern() const
+	{
+		at::AttributeTable table;
+		for (auto& [key, raw] : rawAttributes)
+		{
+			if (auto id = at::FindAttributeId(key))
+			{
+				rawConverters[(size_t)*id](raw, table);
+			}
+		}
+		return table;
+	}
 	const Selector& Stylesheet::GetSelector() const
 	{
 		return selector;
@@ -9,6 +9,7 @@
 #include "RawAttributeValue.h"
 #include "Attributes.h"
 #include "AttributeUtils.h"
+#include "AttributeTable.h"
 
 namespace p2c::gfx::lay::sty
 {
@@ -46,6 +47,8 @@ namespace p2c::gfx::lay::sty
 			);
 			InsertRaw(A::key, val);
 		}
+		// converts raw attributes to a table indexed by attribute id, keys that are not attributes are ignored
+		at::AttributeTable Intern() const;
 		const Selector& GetSelector() const;
 		// destination (this) sheet values take precedence
 		void MergeFrom(const Stylesheet& other);
@@ -2,8 +2,12 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 #include <Core/source/pmon/metric/MetricFetcher.h>
+#include <Core/source/pmon/metric/BatchValueReader.h>
 #include <Core/source/gfx/layout/GraphData.h>
 #include <memory>
+#include <vector>
+#include <ranges>
+#include <cmath>
 
 namespace p2c::kern
 {
@@ -26,4 +30,83 @@ namespace p2c::kern
 		std::shared_ptr<gfx::lay::GraphData> graphData;
 		std::shared_ptr<std::wstring> textData;
 	};
-}
\ No newline at end of file
+
+	// populates a set of packs sharing one query blob
+	// numeric values are decoded from the blob in one pass into a contiguous array, then graphs are pushed
+	// in one pass and readout text is only reformatted when its value changes
+	// a NaN value (blob not populated, or NaN in the blob) is pushed to graphs as an empty sample; unlike
+	// DataFetchPack::Populate, which pushes a NaN read from the blob as a value, this keeps NaN out of the
+	// graph's min / max and its columns treat it as they do any other gap
+	// packs whose fetchers cannot be batched (enum / string metrics) are populated individually
+	// holds pointers to the packs, so it must be rebuilt whenever packs are added, removed or have
+	// their data sinks replaced
+	class DataFetchBatch
+	{
+	public:
+		template<std::ranges::range R>
+		void Rebuild(R&& packs)
+		{
+			Clear();
+			for (DataFetchPack& pack : packs) {
+				if (!pack.pFetcher) {
+					continue;
+				}
+				const auto index = pack.pFetcher->AddToBatch(reader_);
+				if (!index) {
+					individualPacks_.push_back(&pack);
+					continue;
+				}
+				if (pack.graphData) {
+					graphs_.push_back({ *index, pack.graphData.get() });
+				}
+				if (pack.textData) {
+					readouts_.push_back({ *index, pack.textData.get() });
+				}
+			}
+		}
+		void Populate(const uint8_t* pBlob, double timestamp)
+		{
+			reader_.Read(pBlob);
+			const auto values = reader_.GetValues();
+			for (auto& g : graphs_) {
+				const auto val = values[g.valueIndex];
+				g.pData->Push({ gfx::lay::DataPoint{
+					.value = std::isnan(val) ? std::nullopt : std::optional{ float(val) },
+					.time = timestamp,
+				} });
+				g.pData->Trim(timestamp);
+			}
+			for (auto& r : readouts_) {
+				r.cache.Update(values[r.valueIndex], *r.pText);
+			}
+			for (auto pPack : individualPacks_) {
+				pPack->Populate(timestamp);
+			}
+		}
+		void Clear()
+		{
+			reader_.Clear();
+			graphs_.clear();
+			readouts_.clear();
+			individualPacks_.clear();
+		}
+	private:
+		// types
+		struct Graph_
+		{
+			size_t valueIndex;
+			gfx::lay::GraphData* pData;
+		};
+		struct Readout_
+		{
+			size_t valueIndex;
+			std::wstring* pText;
+			pmon::met::NumericReadoutCache cache;
+		};
+		// data
+		pmon::met::BatchValueReader reader_;
+		std::vector<Graph_> graphs_;
+		std::vector<Readout_> readouts_;
+		std::vector<DataFetchPack*> individualPacks_;
+	};
+}
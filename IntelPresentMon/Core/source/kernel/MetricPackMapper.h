@@ -39,6 +39,7 @@ namespace p2c::kern
 		{
 			// if there was an empty  widget payload, just clear everyting out and bail
 			if (usageMap_.empty()) {
+				batch_.Clear();
 				metricPackMap_.clear();
 				pQuery_.reset();
 				return;
@@ -76,6 +77,8 @@ namespace p2c::kern
 			}
 			// move query
 			pQuery_ = std::move(buildResult.pQuery);
+			// register values of the new fetchers for batched reading
+			batch_.Rebuild(metricPackMap_ | vi::values);
 		}
 		void AddGraph(const QualifiedMetric& qmet, double timeWindow)
 		{
@@ -104,9 +107,7 @@ namespace p2c::kern
 			// if query is empty, don't do anything (empty loadout)
 			if (pQuery_) {
 				pQuery_->Poll(tracker);
-				for (auto&& [qmet, pPack] : metricPackMap_) {
-					pPack.Populate(timestamp);
-				}
+				batch_.Populate(pQuery_->GetBlobData(), timestamp);
 			}
 		}
 		DataFetchPack& operator[](const QualifiedMetric& qmet)
@@ -124,6 +125,8 @@ namespace p2c::kern
 		std::unordered_map<QualifiedMetric, DataFetchPack> metricPackMap_;
 		// we might need a class that encapsulates all pollable sources, including DynamicQuery
 		std::shared_ptr<pmon::DynamicQuery> pQuery_;
+		// flattened view of the packs in metricPackMap_ for polling, rebuilt on every commit
+		DataFetchBatch batch_;
 		// map used to determine which metrics are no longer needed after a push
 		// i.e. which ones can carry over, differentiates between graph and readout
 		std::unordered_map<QualifiedMetric, MetricUsage_> usageMap_;
@@ -0,0 +1,66 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include "BatchValueReader.h"
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace p2c::pmon::met
+{
+    namespace
+    {
+        template<typename T>
+        float ReadAs_(const uint8_t* pBytes)
+        {
+            T val;
+            std::memcpy(&val, pBytes, sizeof(T));
+            return (float)val;
+        }
+    }
+
+    size_t BatchValueReader::Add(PM_DATA_TYPE type, uint32_t offset, float scale)
+    {
+        elements_.push_back({ .offset = offset, .type = type, .scale = scale });
+        values_.push_back(std::numeric_limits<double>::quiet_NaN());
+        return elements_.size() - 1;
+    }
+
+    void BatchValueReader::Read(const uint8_t* pBlob)
+    {
+        if (!pBlob) {
+            std::ranges::fill(values_, std::numeric_limits<double>::quiet_NaN());
+            return;
+        }
+        // scaling is done in float so that values match those read through TypedDynamicPollingFetcher
+        for (size_t i = 0; i < elements_.size(); i++) {
+            const auto& e = elements_[i];
+            const auto pBytes = pBlob + e.offset;
+            float val;
+            switch (e.type) {
+            case PM_DATA_TYPE_DOUBLE: val = ReadAs_<double>(pBytes); break;
+            case PM_DATA_TYPE_INT32: val = ReadAs_<int32_t>(pBytes); break;
+            case PM_DATA_TYPE_UINT32: val = ReadAs_<uint32_t>(pBytes); break;
+            case PM_DATA_TYPE_UINT64: val = ReadAs_<uint64_t>(pBytes); break;
+            case PM_DATA_TYPE_BOOL: val = ReadAs_<bool>(pBytes); break;
+            default: val = std::numeric_limits<float>::quiet_NaN(); break;
+            }
+            values_[i] = double(e.scale * val);
+        }
+    }
+
+    std::span<const double> BatchValueReader::GetValues() const
+    {
+        return values_;
+    }
+
+    size_t BatchValueReader::GetCount() const
+    {
+        return elements_.size();
+    }
+
+    void BatchValueReader::Clear()
+    {
+        elements_.clear();
+        values_.clear();
+    }
+}
@@ -0,0 +1,36 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <PresentMonAPI2/PresentMonAPI.h>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace p2c::pmon::met
+{
+    // decodes the numeric elements of a query blob into a contiguous array of values in one pass
+    // elements are registered once when the query is built, and then read every poll without
+    // going through the individual fetchers
+    // values of elements that could not be read (no blob populated) are NaN
+    class BatchValueReader
+    {
+    public:
+        // returns the index of the element's value in the array returned by GetValues
+        size_t Add(PM_DATA_TYPE type, uint32_t offset, float scale);
+        void Read(const uint8_t* pBlob);
+        std::span<const double> GetValues() const;
+        size_t GetCount() const;
+        void Clear();
+    private:
+        // types
+        struct Element_
+        {
+            uint32_t offset;
+            PM_DATA_TYPE type;
+            float scale;
+        };
+        // data
+        std::vector<Element_> elements_;
+        std::vector<double> values_;
+    };
+}
@@ -17,13 +17,27 @@ namespace p2c::pmon::met
         // overlay will always indicate preferred unit in the widget labels
         // so we must scale from output unit if necessary to match
         const auto metric = introRoot.FindMetric(qel.metric);
-        const auto type = metric.GetDataTypeInfo().GetPolledType();
+        type_ = metric.GetDataTypeInfo().GetPolledType();
         if (metric.GetUnit() != metric.GetPreferredUnitHint()) {
             scale_ = (float)introRoot.FindUnit(metric.GetUnit())
                 .MakeConversionFactor(metric.GetPreferredUnitHint());
         }
     }
 
+    std::optional<size_t> DynamicPollingFetcher::AddToBatch(BatchValueReader& reader) const
+    {
+        switch (type_) {
+        case PM_DATA_TYPE_DOUBLE:
+        case PM_DATA_TYPE_INT32:
+        case PM_DATA_TYPE_UINT32:
+        case PM_DATA_TYPE_UINT64:
+        case PM_DATA_TYPE_BOOL:
+            return reader.Add(type_, offset_, scale_);
+        default:
+            return {};
+        }
+    }
+
     TypedDynamicPollingFetcher<PM_ENUM>::TypedDynamicPollingFetcher(const PM_QUERY_ELEMENT& qel, const pmapi::intro::Root& introRoot,
         std::shared_ptr<DynamicQuery> pQuery, std::shared_ptr<const pmapi::EnumMap::KeyMap> pKeyMap)
         :
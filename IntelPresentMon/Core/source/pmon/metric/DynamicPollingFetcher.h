@@ -5,6 +5,7 @@
 #include <PresentMonAPIWrapperCommon/EnumMap.h>
 #include <Core/source/kernel/OverlaySpec.h>
 #include "MetricFetcher.h"
+#include "BatchValueReader.h"
 #include "../DynamicQuery.h"
 #include <CommonUtilities//str/String.h>
 #include <concepts>
@@ -15,6 +16,9 @@ namespace p2c::pmon::met
 {
     class DynamicPollingFetcher : public MetricFetcher
     {
+    public:
+        // numeric types are read from the blob in a batch, enum and string types are read individually
+        std::optional<size_t> AddToBatch(BatchValueReader& reader) const override;
     protected:
         // functions
         DynamicPollingFetcher(const PM_QUERY_ELEMENT& qel, const pmapi::intro::Root& introRoot,
@@ -23,6 +27,7 @@ namespace p2c::pmon::met
         std::shared_ptr<DynamicQuery> pQuery_;
         uint32_t offset_ = std::numeric_limits<uint32_t>::max();
         float scale_ = 1.f;
+        PM_DATA_TYPE type_ = PM_DATA_TYPE_VOID;
     };
 
     template<typename T>
@@ -2,17 +2,53 @@
 // SPDX-License-Identifier: MIT
 #include "MetricFetcher.h"
 #include <format>
+#include <bit>
+#include <cmath>
+#include <iterator>
+#include <algorithm>
 
 namespace p2c::pmon::met
 {
     MetricFetcher::~MetricFetcher() = default;
     std::wstring MetricFetcher::ReadStringValue()
     {
-        if (const auto val = ReadValue()) {
-            const auto digitsBeforeDecimal = std::max(int(log10(std::abs(*val))), 0);
+        std::wstring text;
+        FormatNumericValue(ReadValue(), text);
+        return text;
+    }
+    std::optional<size_t> MetricFetcher::AddToBatch(BatchValueReader&) const
+    {
+        return {};
+    }
+
+    void FormatNumericValue(std::optional<float> value, std::wstring& text)
+    {
+        text.clear();
+        if (value && !std::isnan(*value)) {
+            const auto val = *value;
+            const auto digitsBeforeDecimal = std::max(int(log10(std::abs(val))), 0);
             const int maxFractionalDigits = 2;
-            return std::format(L"{:.{}f}", *val, std::max(maxFractionalDigits - digitsBeforeDecimal, 0));
+            std::format_to(std::back_inserter(text), L"{:.{}f}", val,
+                std::max(maxFractionalDigits - digitsBeforeDecimal, 0));
+        }
+        else {
+            text = L"NA";
         }
-        return L"NA";
     }
-}
\ No newline at end of file
+
+    bool NumericReadoutCache::Update(double value, std::wstring& text)
+    {
+        const auto bits = std::bit_cast<uint64_t>(value);
+        if (lastValueBits_ == bits) {
+            return false;
+        }
+        lastValueBits_ = bits;
+        FormatNumericValue(std::isnan(value) ? std::nullopt : std::optional<float>{ float(value) }, text);
+        return true;
+    }
+
+    void NumericReadoutCache::Reset()
+    {
+        lastValueBits_.reset();
+    }
+}
@@ -3,9 +3,12 @@
 #pragma once
 #include <string>
 #include <optional>
+#include <cstdint>
 
 namespace p2c::pmon::met
 {
+    class BatchValueReader;
+
     class MetricFetcher
     {
     public:
@@ -13,10 +16,29 @@ namespace p2c::pmon::met
         virtual ~MetricFetcher();
         virtual std::wstring ReadStringValue();
         virtual std::optional<float> ReadValue() = 0;
+        // registers the numeric value of this fetcher with a batch reader so that it can be read together
+        // with other fetchers of the same query, returns the index of the value in the batch
+        // returns empty if this fetcher must be read individually
+        virtual std::optional<size_t> AddToBatch(BatchValueReader& reader) const;
 
         MetricFetcher(const MetricFetcher&) = delete;
         MetricFetcher & operator=(const MetricFetcher&) = delete;
         MetricFetcher(MetricFetcher&&) = delete;
         MetricFetcher & operator=(MetricFetcher&&) = delete;
     };
-}
\ No newline at end of file
+
+    // writes the readout text for a numeric value (NA for empty or NaN), reusing the capacity of text
+    void FormatNumericValue(std::optional<float> value, std::wstring& text);
+
+    // keeps readout text for a numeric value, only reformatting it when the value changes
+    // (formatting precision depends on the value only)
+    class NumericReadoutCache
+    {
+    public:
+        // returns true if the text was rewritten
+        bool Update(double value, std::wstring& text);
+        void Reset();
+    private:
+        std::optional<uint64_t> lastValueBits_;
+    };
+}
@@ -2,12 +2,17 @@
 #include "IntrospectionTransfer.h"
 #include "IntrospectionPopulators.h"
 #include "SharedMemoryTypes.h"
-#include "IntrospectionCloneAllocators.h"
+#include "IntrospectionImage.h"
 #include <boost/interprocess/sync/interprocess_sharable_mutex.hpp>
 #include <boost/interprocess/sync/interprocess_semaphore.hpp>
 #include <boost/interprocess/sync/sharable_lock.hpp>
 #include <chrono>
+#include <optional>
+#include <atomic>
+#include <cstring>
 #include "../../PresentMonService/GlobalIdentifiers.h"
+#include "../../CommonUtilities/log/Log.h"
+#include <format>
 #include <windows.h>
 #include <sddl.h>
 
@@ -24,6 +29,8 @@ namespace pmon::ipc
 			static constexpr const char* introspectionRootName_ = "in-root";
 			static constexpr const char* introspectionMutexName_ = "in-mtx";
 			static constexpr const char* introspectionSemaphoreName_ = "in-sem";
+			static constexpr const char* introspectionImageName_ = "in-image";
+			static constexpr const char* adapterGenerationName_ = "in-adapter-gen";
 		};
 
 		class ServiceComms_ : public ServiceComms, CommsBase_
@@ -38,18 +45,20 @@ namespace pmon::ipc
 				pIntroSemaphore_{ ShmMakeNamedUnique<bip::interprocess_semaphore>(
 					introspectionSemaphoreName_, shm_.get_segment_manager(), 0) },
 				pRoot_{ ShmMakeNamedUnique<intro::IntrospectionRoot>(introspectionRootName_,
-					shm_.get_segment_manager(), shm_.get_segment_manager()) }
+					shm_.get_segment_manager(), shm_.get_segment_manager()) },
+				pAdapterGeneration_{ ShmMakeNamedUnique<std::atomic<uint32_t>>(
+					adapterGenerationName_, shm_.get_segment_manager(), 0u) }
 			{
 				PreInitializeIntrospection_();
 			}
 			intro::IntrospectionRoot& GetIntrospectionRoot() override
 			{
-				return *pRoot_;
+				return GetTree_();
 			}
 			void RegisterGpuDevice(PM_DEVICE_VENDOR vendor, std::string deviceName, const GpuTelemetryBitset& gpuCaps) override
 			{
 				auto lck = LockIntrospectionMutexExclusive_();
-				intro::PopulateGpuDevice(shm_.get_segment_manager(), *pRoot_, nextDeviceIndex_++, vendor, deviceName, gpuCaps);
+				intro::PopulateGpuDevice(shm_.get_segment_manager(), GetTree_(), nextDeviceIndex_++, vendor, deviceName, gpuCaps);
 			}
 			void FinalizeGpuDevices() override
 			{
@@ -63,13 +72,17 @@ namespace pmon::ipc
 			void RegisterCpuDevice(PM_DEVICE_VENDOR vendor, std::string deviceName, const CpuTelemetryBitset& cpuCaps) override
 			{
 				auto lck = LockIntrospectionMutexExclusive_();
-				intro::PopulateCpu(shm_.get_segment_manager(), *pRoot_, vendor, deviceName, cpuCaps);
+				intro::PopulateCpu(shm_.get_segment_manager(), GetTree_(), vendor, deviceName, cpuCaps);
 				introCpuComplete_ = true;
 				if (introGpuComplete_ && introCpuComplete_) {
 					lck.unlock();
 					FinalizeIntrospection_();
 				}
 			}
+			void AdvanceAdapterGeneration() override
+			{
+				pAdapterGeneration_->fetch_add(1);
+			}
 		private:
 			// types
 			class Permissions_
@@ -106,9 +119,29 @@ namespace pmon::ipc
 			{
 				// sort all ordered introspection entities in their pricipal containers
 				pRoot_->Sort();
+				// flatten the finished tree so that clients can acquire it with a single copy
+				// the image replaces the tree, so that introspection is only held once in the segment
+				PublishIntrospectionImage_();
 				// release semaphore holdoff once construction is complete
 				for (int i = 0; i < 8; i++) { pIntroSemaphore_->post(); }
 			}
+			void PublishIntrospectionImage_()
+			{
+				// stamp is unique per publish so that clients can tell when cached introspection is stale
+				const auto stamp = (uint64_t)std::chrono::system_clock::now().time_since_epoch().count();
+				const auto image = intro::BuildIntrospectionImage(GetTree_(), stamp);
+				auto lck = LockIntrospectionMutexExclusive_();
+				pRoot_.reset();
+				auto pImage = shm_.construct<char>(introspectionImageName_)[image.size()](0);
+				std::memcpy(pImage, image.data(), image.size());
+			}
+			intro::IntrospectionRoot& GetTree_()
+			{
+				if (!pRoot_) {
+					throw std::runtime_error{ "Introspection tree already published and released" };
+				}
+				return *pRoot_;
+			}
 			bip::scoped_lock<bip::interprocess_sharable_mutex> LockIntrospectionMutexExclusive_()
 			{
 				const auto result = shm_.find<bip::interprocess_sharable_mutex>(introspectionMutexName_);
@@ -122,6 +155,7 @@ namespace pmon::ipc
 			ShmUniquePtr<bip::interprocess_sharable_mutex> pIntroMutex_;
 			ShmUniquePtr<bip::interprocess_semaphore> pIntroSemaphore_;
 			ShmUniquePtr<intro::IntrospectionRoot> pRoot_;
+			ShmUniquePtr<std::atomic<uint32_t>> pAdapterGeneration_;
 			uint32_t nextDeviceIndex_ = 1;
 			bool introGpuComplete_ = false;
 			bool introCpuComplete_ = false;
@@ -132,7 +166,8 @@ namespace pmon::ipc
 		public:
 			MiddlewareComms_(std::optional<std::string> sharedMemoryName)
 				:
-				shm_{ bip::open_only, sharedMemoryName.value_or(defaultSegmentName_).c_str() }
+				shm_{ bip::open_only, sharedMemoryName.value_or(defaultSegmentName_).c_str() },
+				pAdapterGeneration_{ shm_.find<std::atomic<uint32_t>>(adapterGenerationName_).first }
 			{}
 			const PM_INTROSPECTION_ROOT* GetIntrospectionRoot(uint32_t timeoutMs) override
 			{
@@ -140,23 +175,41 @@ namespace pmon::ipc
 				WaitOnIntrospectionHoldoff_(timeoutMs);
 				// acquire shared lock on introspection data
 				auto sharedLock = LockIntrospectionMutexForShare_();
-				// find the introspection structure in shared memory
-				const auto result = shm_.find<intro::IntrospectionRoot>(introspectionRootName_);
-				if (!result.first) {
-					throw std::runtime_error{ "Failed to find introspection root in shared memory" };
+				// the flat image is a single copy + relocation pass, no walking of the shared memory tree
+				if (auto pImage = FindIntrospectionImage_()) {
+					return pImage->CloneRelocated();
 				}
-				const auto& root = *result.first;
-				// probe allocator used to determine size of memory block required to hold the CAPI instrospection structure
-				intro::ProbeAllocator<void> probeAllocator;
-				// this call to clone doesn't allocate of initialize any memory, the probe just determines required memory
-				root.ApiClone(probeAllocator);
-				// create actual allocator based on required size
-				ipc::intro::BlockAllocator<void> blockAllocator{ probeAllocator.GetTotalSize() };
-				// create the CAPI introspection struct on the heap, it is now the caller's responsibility to track this resource
-				return root.ApiClone(blockAllocator);
+				throw std::runtime_error{ "Failed to find introspection image in shared memory" };
+			}
+			const intro::IntrospectionImageView& GetIntrospectionImage(uint32_t timeoutMs) override
+			{
+				WaitOnIntrospectionHoldoff_(timeoutMs);
+				auto sharedLock = LockIntrospectionMutexForShare_();
+				if (auto pImage = FindIntrospectionImage_()) {
+					return *pImage;
+				}
+				throw std::runtime_error{ "Failed to find introspection image in shared memory" };
+			}
+			uint32_t GetAdapterGeneration() override
+			{
+				return pAdapterGeneration_ ? pAdapterGeneration_->load() : 0;
 			}
 		private:
 			// functions
+			// image is immutable once published, so the view is created once and reused
+			const intro::IntrospectionImageView* FindIntrospectionImage_()
+			{
+				if (!image_) {
+					const auto result = shm_.find<char>(introspectionImageName_);
+					if (!result.first) {
+						return nullptr;
+					}
+					image_.emplace(std::span{ reinterpret_cast<const std::byte*>(result.first), result.second });
+					pmlog_dbg(std::format("Mapped introspection image version:{:X} size:{}",
+						image_->GetVersionStamp(), image_->GetSize()));
+				}
+				return &*image_;
+			}
 			void WaitOnIntrospectionHoldoff_(uint32_t timeoutMs)
 			{
 				using namespace std::chrono_literals;
@@ -183,6 +236,9 @@ namespace pmon::ipc
 			}
 			// data
 			ShmSegment shm_;
+			std::optional<intro::IntrospectionImageView> image_;
+			// nullptr for services that predate the generation counter
+			const std::atomic<uint32_t>* pAdapterGeneration_;
 		};
 	}
 
@@ -13,6 +13,7 @@ namespace pmon::ipc
 	namespace intro
 	{
 		struct IntrospectionRoot;
+		class IntrospectionImageView;
 	}
 
 	class ServiceComms
@@ -23,6 +24,8 @@ namespace pmon::ipc
 		virtual void RegisterGpuDevice(PM_DEVICE_VENDOR vendor, std::string deviceName, const GpuTelemetryBitset& gpuCaps) = 0;
 		virtual void FinalizeGpuDevices() = 0;
 		virtual void RegisterCpuDevice(PM_DEVICE_VENDOR vendor, std::string deviceName, const CpuTelemetryBitset& cpuCaps) = 0;
+		// called each time adapters are enumerated anew (e.g. on device reset), adapter ids may then refer to different devices
+		virtual void AdvanceAdapterGeneration() = 0;
 	};
 
 	class MiddlewareComms
@@ -30,6 +33,11 @@ namespace pmon::ipc
 	public:
 		virtual ~MiddlewareComms() = default;
 		virtual const PM_INTROSPECTION_ROOT* GetIntrospectionRoot(uint32_t timeoutMs = 2000) = 0;
+		// read-only flat image of introspection mapped from shared memory, valid for the lifetime of this object
+		virtual const intro::IntrospectionImageView& GetIntrospectionImage(uint32_t timeoutMs = 2000) = 0;
+		// changes whenever the service enumerates adapters anew, so anything cached per adapter id must be fetched again
+		// (always 0 when connected to a service that does not publish it)
+		virtual uint32_t GetAdapterGeneration() = 0;
 	};
 
 	std::unique_ptr<ServiceComms> MakeServiceComms(std::optional<std::string> sharedMemoryName = {});
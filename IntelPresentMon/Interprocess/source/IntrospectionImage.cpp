@@ -0,0 +1,241 @@
+#include "IntrospectionImage.h"
+#include "IntrospectionTransfer.h"
+#include "IntrospectionCloneAllocators.h"
+#include "../../CommonUtilities/Memory.h"
+#include <stdexcept>
+#include <cstring>
+#include <utility>
+#include <bit>
+#include <algorithm>
+
+namespace pmon::ipc::intro
+{
+	namespace
+	{
+		std::vector<IntrospectionIndexEntry> BuildIndex_(const std::vector<IntrospectionIndexEntry>& items)
+		{
+			// keep load factor at or below 0.5 so that probe sequences stay short
+			const auto capacity = std::bit_ceil(std::max<size_t>(items.size() * 2, 8));
+			std::vector<IntrospectionIndexEntry> slots(capacity, IntrospectionIndexEntry{ 0, 0 });
+			for (auto& item : items) {
+				auto i = IntrospectionImageView::MixKey(item.key) & (capacity - 1);
+				while (slots[i].target) {
+					i = (i + 1) & (capacity - 1);
+				}
+				slots[i] = item;
+			}
+			return slots;
+		}
+
+		// walks the cloned API tree, recording the location of every pointer slot and of every indexed structure
+		class Flattener_
+		{
+		public:
+			Flattener_(std::byte* pBase) : pBase_{ pBase } {}
+			void Walk(const PM_INTROSPECTION_ROOT& root)
+			{
+				ObjArray_(Slot_(root.pMetrics), [this](const void* p) {
+					Metric_(*static_cast<const PM_INTROSPECTION_METRIC*>(p));
+				});
+				ObjArray_(Slot_(root.pEnums), [this](const void* p) {
+					Enum_(*static_cast<const PM_INTROSPECTION_ENUM*>(p));
+				});
+				ObjArray_(Slot_(root.pDevices), [this](const void* p) {
+					auto& device = *static_cast<const PM_INTROSPECTION_DEVICE*>(p);
+					devices_.push_back({ device.id, OffsetOf_(&device) });
+					String_(Slot_(device.pName));
+				});
+				ObjArray_(Slot_(root.pUnits), [this](const void* p) {
+					auto& unit = *static_cast<const PM_INTROSPECTION_UNIT*>(p);
+					units_.push_back({ uint64_t(unit.id), OffsetOf_(&unit) });
+				});
+			}
+			// convert all pointers to body-relative offsets, must be done after the walk is complete
+			void ConvertToOffsets()
+			{
+				for (auto slot : slots_) {
+					auto& value = *reinterpret_cast<uintptr_t*>(pBase_ + slot);
+					value -= reinterpret_cast<uintptr_t>(pBase_);
+				}
+			}
+			const std::vector<uint64_t>& GetSlots() const { return slots_; }
+			const std::vector<IntrospectionIndexEntry>& GetMetrics() const { return metrics_; }
+			const std::vector<IntrospectionIndexEntry>& GetEnums() const { return enums_; }
+			const std::vector<IntrospectionIndexEntry>& GetEnumKeys() const { return enumKeys_; }
+			const std::vector<IntrospectionIndexEntry>& GetDevices() const { return devices_; }
+			const std::vector<IntrospectionIndexEntry>& GetUnits() const { return units_; }
+		private:
+			uint64_t OffsetOf_(const void* p) const
+			{
+				return uint64_t(static_cast<const std::byte*>(p) - pBase_);
+			}
+			template<typename T>
+			T* Slot_(T* const& field)
+			{
+				if (field) {
+					slots_.push_back(OffsetOf_(&field));
+				}
+				return field;
+			}
+			template<class F>
+			void ObjArray_(const PM_INTROSPECTION_OBJARRAY* pArray, F&& visitElement)
+			{
+				const auto pElements = Slot_(pArray->pData);
+				for (size_t i = 0; i < pArray->size; i++) {
+					visitElement(Slot_(pElements[i]));
+				}
+			}
+			void String_(const PM_INTROSPECTION_STRING* pString)
+			{
+				Slot_(pString->pData);
+			}
+			void Metric_(const PM_INTROSPECTION_METRIC& metric)
+			{
+				metrics_.push_back({ uint64_t(metric.id), OffsetOf_(&metric) });
+				Slot_(metric.pTypeInfo);
+				// stat and device info elements contain no pointers
+				ObjArray_(Slot_(metric.pStatInfo), [](const void*) {});
+				ObjArray_(Slot_(metric.pDeviceMetricInfo), [](const void*) {});
+			}
+			void Enum_(const PM_INTROSPECTION_ENUM& e)
+			{
+				enums_.push_back({ uint64_t(e.id), OffsetOf_(&e) });
+				String_(Slot_(e.pSymbol));
+				String_(Slot_(e.pDescription));
+				ObjArray_(Slot_(e.pKeys), [this](const void* p) {
+					auto& key = *static_cast<const PM_INTROSPECTION_ENUM_KEY*>(p);
+					enumKeys_.push_back({ IntrospectionImageView::MakeEnumKeyIndexKey(key.enumId, key.id), OffsetOf_(&key) });
+					String_(Slot_(key.pSymbol));
+					String_(Slot_(key.pName));
+					String_(Slot_(key.pShortName));
+					String_(Slot_(key.pDescription));
+				});
+			}
+			std::byte* pBase_;
+			std::vector<uint64_t> slots_;
+			std::vector<IntrospectionIndexEntry> metrics_;
+			std::vector<IntrospectionIndexEntry> enums_;
+			std::vector<IntrospectionIndexEntry> enumKeys_;
+			std::vector<IntrospectionIndexEntry> devices_;
+			std::vector<IntrospectionIndexEntry> units_;
+		};
+
+		template<typename T>
+		uint64_t Append_(std::vector<std::byte>& image, const T* pData, size_t count)
+		{
+			const auto offset = image.size() + util::GetPadding(image.size(), 16);
+			image.resize(offset + sizeof(T) * count);
+			if (count) {
+				std::memcpy(image.data() + offset, pData, sizeof(T) * count);
+			}
+			return offset;
+		}
+
+		IntrospectionIndexRef AppendIndex_(std::vector<std::byte>& image, const std::vector<IntrospectionIndexEntry>& items)
+		{
+			const auto slots = BuildIndex_(items);
+			return { Append_(image, slots.data(), slots.size()), slots.size() };
+		}
+	}
+
+	std::vector<std::byte> BuildIntrospectionImage(const IntrospectionRoot& root, uint64_t versionStamp)
+	{
+		// clone to a single block, exactly as for the C API
+		ProbeAllocator<void> probeAllocator;
+		root.ApiClone(probeAllocator);
+		const auto bodySize = probeAllocator.GetTotalSize();
+		BlockAllocator<void> blockAllocator{ bodySize };
+		// root is the first allocation so it is at the start of the block
+		const auto pApiRoot = root.ApiClone(blockAllocator);
+		if (!pApiRoot) {
+			throw std::runtime_error{ "Failed to allocate block for introspection image" };
+		}
+		auto pBlock = reinterpret_cast<std::byte*>(const_cast<PM_INTROSPECTION_ROOT*>(pApiRoot));
+		std::vector<std::byte> image;
+		try {
+			Flattener_ flattener{ pBlock };
+			flattener.Walk(*pApiRoot);
+			flattener.ConvertToOffsets();
+			// header goes first, filled in at the end when all offsets are known
+			IntrospectionImageHeader header{
+				.magic = IntrospectionImageHeader::Magic,
+				.formatVersion = IntrospectionImageHeader::CurrentFormatVersion,
+				.versionStamp = versionStamp,
+				.bodySize = bodySize,
+			};
+			image.resize(sizeof(header));
+			header.bodyOffset = Append_(image, pBlock, bodySize);
+			const auto& slots = flattener.GetSlots();
+			header.relocationOffset = Append_(image, slots.data(), slots.size());
+			header.relocationCount = slots.size();
+			header.metricIndex = AppendIndex_(image, flattener.GetMetrics());
+			header.enumIndex = AppendIndex_(image, flattener.GetEnums());
+			header.enumKeyIndex = AppendIndex_(image, flattener.GetEnumKeys());
+			header.deviceIndex = AppendIndex_(image, flattener.GetDevices());
+			header.unitIndex = AppendIndex_(image, flattener.GetUnits());
+			std::memcpy(image.data(), &header, sizeof(header));
+		}
+		catch (...) {
+			free(pBlock);
+			throw;
+		}
+		free(pBlock);
+		return image;
+	}
+
+	IntrospectionImageView::IntrospectionImageView(std::span<const std::byte> image)
+	{
+		if (image.size() < sizeof(IntrospectionImageHeader)) {
+			throw std::runtime_error{ "Introspection image too small" };
+		}
+		pHeader_ = reinterpret_cast<const IntrospectionImageHeader*>(image.data());
+		if (pHeader_->magic != IntrospectionImageHeader::Magic ||
+			pHeader_->formatVersion != IntrospectionImageHeader::CurrentFormatVersion) {
+			throw std::runtime_error{ "Introspection image format not recognized" };
+		}
+		const auto inBounds = [&](uint64_t offset, uint64_t size) {
+			return offset <= image.size() && size <= image.size() - offset;
+		};
+		if (!inBounds(pHeader_->bodyOffset, pHeader_->bodySize) ||
+			!inBounds(pHeader_->relocationOffset, pHeader_->relocationCount * sizeof(uint64_t))) {
+			throw std::runtime_error{ "Introspection image sections out of bounds" };
+		}
+		for (auto& index : { pHeader_->metricIndex, pHeader_->enumIndex, pHeader_->enumKeyIndex,
+			pHeader_->deviceIndex, pHeader_->unitIndex }) {
+			if (!std::has_single_bit(index.capacity) ||
+				!inBounds(index.offset, index.capacity * sizeof(IntrospectionIndexEntry))) {
+				throw std::runtime_error{ "Introspection image index out of bounds" };
+			}
+		}
+		pBody_ = image.data() + pHeader_->bodyOffset;
+		relocations_ = { reinterpret_cast<const uint64_t*>(image.data() + pHeader_->relocationOffset),
+			size_t(pHeader_->relocationCount) };
+		for (auto slot : relocations_) {
+			if (pHeader_->bodySize < sizeof(uintptr_t) || slot > pHeader_->bodySize - sizeof(uintptr_t)) {
+				throw std::runtime_error{ "Introspection image relocation out of bounds" };
+			}
+		}
+	}
+
+	size_t IntrospectionImageView::GetSize() const
+	{
+		return size_t(pHeader_->bodyOffset + pHeader_->bodySize);
+	}
+
+	const PM_INTROSPECTION_ROOT* IntrospectionImageView::CloneRelocated() const
+	{
+		auto pBlock = static_cast<std::byte*>(malloc(size_t(pHeader_->bodySize)));
+		if (!pBlock) {
+			throw std::bad_alloc{};
+		}
+		std::memcpy(pBlock, pBody_, size_t(pHeader_->bodySize));
+		const auto base = reinterpret_cast<uintptr_t>(pBlock);
+		for (auto slot : relocations_) {
+			uintptr_t value;
+			std::memcpy(&value, pBlock + slot, sizeof(value));
+			value += base;
+			std::memcpy(pBlock + slot, &value, sizeof(value));
+		}
+		return reinterpret_cast<const PM_INTROSPECTION_ROOT*>(pBlock);
+	}
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include "../../PresentMonAPI2/PresentMonAPI.h"
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <vector>
+#include <string_view>
+
+namespace pmon::ipc::intro
+{
+	struct IntrospectionRoot;
+
+	// location of an open-addressed hash index inside of an introspection image
+	struct IntrospectionIndexRef
+	{
+		uint64_t offset;
+		// number of slots, always a power of 2
+		uint64_t capacity;
+	};
+
+	// slot in a hash index, target is the offset of the API structure in the image body (0 => empty slot)
+	struct IntrospectionIndexEntry
+	{
+		uint64_t key;
+		uint64_t target;
+	};
+
+	// flat, read-only image of the introspection tree, published by the service once introspection is finalized
+	// the body holds the PM_INTROSPECTION_* structures (root first) with every pointer stored as an offset from
+	// the start of the body, so the image can be read in place at any mapping address, or copied and relocated
+	// in a single pass to produce the tree handed out through the C API
+	struct IntrospectionImageHeader
+	{
+		static constexpr uint32_t Magic = 0x4F525449; // ITRO
+		static constexpr uint32_t CurrentFormatVersion = 3;
+		uint32_t magic;
+		uint32_t formatVersion;
+		// unique for every published image, used by clients to invalidate anything cached from introspection
+		uint64_t versionStamp;
+		uint64_t bodyOffset;
+		uint64_t bodySize;
+		// offsets (within body) of every pointer slot in the body
+		uint64_t relocationOffset;
+		uint64_t relocationCount;
+		// hash indices from id to API structure
+		IntrospectionIndexRef metricIndex;
+		IntrospectionIndexRef enumIndex;
+		IntrospectionIndexRef enumKeyIndex;
+		IntrospectionIndexRef deviceIndex;
+		IntrospectionIndexRef unitIndex;
+	};
+
+	// flatten the (sorted) shared memory introspection tree into an image
+	std::vector<std::byte> BuildIntrospectionImage(const IntrospectionRoot& root, uint64_t versionStamp);
+
+	// non-owning view of an image, validated on construction
+	// lookups return pointers into the image; pointer fields of the returned structures still hold
+	// offsets and must be passed through Resolve before being dereferenced
+	// lookups are defined inline so that readers of a mapped image need not link this library
+	class IntrospectionImageView
+	{
+	public:
+		IntrospectionImageView(std::span<const std::byte> image);
+		uint64_t GetVersionStamp() const { return pHeader_->versionStamp; }
+		size_t GetSize() const;
+		// root of the tree in the image (body offset 0), its pointer fields hold offsets
+		const PM_INTROSPECTION_ROOT* GetRoot() const { return reinterpret_cast<const PM_INTROSPECTION_ROOT*>(pBody_); }
+		// lookups return nullptr when the id is not present
+		const PM_INTROSPECTION_METRIC* FindMetric(PM_METRIC metricId) const
+		{
+			return static_cast<const PM_INTROSPECTION_METRIC*>(Lookup_(pHeader_->metricIndex, uint64_t(metricId)));
+		}
+		const PM_INTROSPECTION_ENUM* FindEnum(PM_ENUM enumId) const
+		{
+			return static_cast<const PM_INTROSPECTION_ENUM*>(Lookup_(pHeader_->enumIndex, uint64_t(enumId)));
+		}
+		const PM_INTROSPECTION_ENUM_KEY* FindEnumKey(PM_ENUM enumId, int keyValue) const
+		{
+			return static_cast<const PM_INTROSPECTION_ENUM_KEY*>(
+				Lookup_(pHeader_->enumKeyIndex, MakeEnumKeyIndexKey(enumId, keyValue)));
+		}
+		const PM_INTROSPECTION_DEVICE* FindDevice(uint32_t deviceId) const
+		{
+			return static_cast<const PM_INTROSPECTION_DEVICE*>(Lookup_(pHeader_->deviceIndex, deviceId));
+		}
+		const PM_INTROSPECTION_UNIT* FindUnit(PM_UNIT unitId) const
+		{
+			return static_cast<const PM_INTROSPECTION_UNIT*>(Lookup_(pHeader_->unitIndex, uint64_t(unitId)));
+		}
+		template<typename T>
+		const T* Resolve(const T* pField) const
+		{
+			return reinterpret_cast<const T*>(pBody_ + reinterpret_cast<uintptr_t>(pField));
+		}
+		std::string_view ResolveString(const PM_INTROSPECTION_STRING* pString) const
+		{
+			return Resolve(Resolve(pString)->pData);
+		}
+		// copy the body to a single heap block and relocate it; the root is at the start of the block,
+		// so the caller releases the whole tree with free()
+		const PM_INTROSPECTION_ROOT* CloneRelocated() const;
+		static uint64_t MakeEnumKeyIndexKey(PM_ENUM enumId, int keyValue)
+		{
+			// pack 64-bit key as upper and lower 32-bit values
+			return (uint64_t(enumId) << 32) | uint64_t(uint32_t(keyValue));
+		}
+		static uint64_t MixKey(uint64_t key)
+		{
+			// splitmix64 finalizer, fixed so that service and clients always agree on slot placement
+			key ^= key >> 30;
+			key *= 0xBF58476D1CE4E5B9ull;
+			key ^= key >> 27;
+			key *= 0x94D049BB133111EBull;
+			key ^= key >> 31;
+			return key;
+		}
+	private:
+		const void* Lookup_(const IntrospectionIndexRef& index, uint64_t key) const
+		{
+			const auto pSlots = reinterpret_cast<const IntrospectionIndexEntry*>(
+				reinterpret_cast<const std::byte*>(pHeader_) + index.offset);
+			const auto mask = index.capacity - 1;
+			for (auto i = MixKey(key) & mask; pSlots[i].target; i = (i + 1) & mask) {
+				if (pSlots[i].key == key) {
+					return pBody_ + pSlots[i].target;
+				}
+			}
+			return nullptr;
+		}
+		const IntrospectionImageHeader* pHeader_;
+		const std::byte* pBody_;
+		std::span<const uint64_t> relocations_;
+	};
+}
@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <atomic>
+#include <limits>
+#include <format>
+#include "../../../CommonUtilities/log/Log.h"
+#include "../../../CommonUtilities/Exception.h"
+
+namespace pmon::ipc::act
+{
+	// maps action types to the numeric action ids assigned by the remote endpoint
+	// built once from the identifier table received at connection; per-action lookups
+	// are cached in a dense array indexed by a process-local per-type slot, so that
+	// steady-state requests never hash or compare identifier strings
+	// not thread safe: intended to be used only from the connection's io_context
+	class ActionIdMap
+	{
+	public:
+		ActionIdMap() = default;
+		ActionIdMap(const std::vector<std::string>& remoteTable)
+		{
+			for (uint16_t id = 0; id < (uint16_t)remoteTable.size(); id++) {
+				ids_.emplace(remoteTable[id], id);
+			}
+		}
+		template<class A>
+		uint16_t GetId() const
+		{
+			const auto slot = LocalSlot_<A>();
+			if (slot < cache_.size() && cache_[slot] != invalidId_) {
+				return cache_[slot];
+			}
+			return CacheId_(slot, A::Identifier);
+		}
+		bool Contains(const std::string& identifier) const
+		{
+			return ids_.contains(identifier);
+		}
+		size_t GetSize() const
+		{
+			return ids_.size();
+		}
+	private:
+		// functions
+		static size_t NextSlot_()
+		{
+			static std::atomic<size_t> nextSlot = 0;
+			return nextSlot++;
+		}
+		template<class A>
+		static size_t LocalSlot_()
+		{
+			static const size_t slot = NextSlot_();
+			return slot;
+		}
+		uint16_t CacheId_(size_t slot, const char* identifier) const
+		{
+			const auto i = ids_.find(identifier);
+			if (i == ids_.end()) {
+				pmlog_error(std::format("Action [{}] not supported by remote endpoint", identifier))
+					.raise<util::Exception>();
+			}
+			if (slot >= cache_.size()) {
+				cache_.resize(slot + 1, invalidId_);
+			}
+			cache_[slot] = i->second;
+			return i->second;
+		}
+		// data
+		static constexpr uint16_t invalidId_ = std::numeric_limits<uint16_t>::max();
+		std::unordered_map<std::string, uint16_t> ids_;
+		mutable std::vector<uint16_t> cache_;
+	};
+}
@@ -5,6 +5,7 @@
 #include <cereal/archives/binary.hpp>
 #include "Packet.h"
 #include "ActionExecutionError.h"
+#include "BatchEnvelope.h"
 
 namespace pmon::ipc::act
 {
@@ -21,6 +22,9 @@ namespace pmon::ipc::act
 		virtual const char* GetIdentifier() const = 0;
 		virtual pipe::as::awaitable<void> Execute(ExecutionContext& ctx, SessionContext& stx,
 			const PacketHeader& header, pipe::DuplexPipe& pipe) const = 0;
+		// execute with params taken from a batch, the response is serialized back into a blob
+		virtual BatchSubResponse ExecuteSerialized(ExecutionContext& ctx, SessionContext& stx,
+			const BatchSubRequest& request) const = 0;
 	};
 
 	template<class T, class ExecutionContext>
@@ -57,6 +61,27 @@ namespace pmon::ipc::act
 				co_await pipe.WritePacket(resHeader, EmptyPayload{}, ctx.responseWriteTimeoutMs);
 			}
 		}
+		BatchSubResponse ExecuteSerialized(ExecutionContext& ctx, AsyncAction<ExecutionContext>::SessionContext& stx,
+			const BatchSubRequest& request) const final
+		{
+			if (request.actionVersion != T::Version) {
+				pmlog_error(std::format("Version mismatch in batched action [{}]", GetIdentifier()))
+					.pmwatch(request.actionVersion).pmwatch(T::Version);
+				return { TransportStatus::TransportFailure, PM_STATUS_SUCCESS, {} };
+			}
+			try {
+				auto output = T::Execute_(ctx, stx, DeserializeFromBlob<typename T::Params>(request.params));
+				return { TransportStatus::Success, PM_STATUS_SUCCESS, SerializeToBlob(output) };
+			}
+			catch (const ActionExecutionError& e) {
+				pmlog_error(std::format("Error in batched action [{}] execution", GetIdentifier())).code(e.GetCode());
+				return { TransportStatus::ExecutionFailure, e.GetCode(), {} };
+			}
+			catch (...) {
+				pmlog_error(util::ReportException());
+				return { TransportStatus::TransportFailure, PM_STATUS_SUCCESS, {} };
+			}
+		}
 		const char* GetIdentifier() const final
 		{
 			return T::Identifier;
@@ -84,6 +109,28 @@ namespace pmon::ipc::act
 			}
 			co_return;
 		}
+		BatchSubResponse ExecuteSerialized(ExecutionContext& ctx, AsyncAction<ExecutionContext>::SessionContext& stx,
+			const BatchSubRequest& request) const final
+		{
+			// events have no response, but report failure so that the batch result lines up with the requests
+			if (request.actionVersion != T::Version) {
+				pmlog_error(std::format("Version mismatch in batched action [{}]", GetIdentifier()))
+					.pmwatch(request.actionVersion).pmwatch(T::Version);
+				return { TransportStatus::TransportFailure, PM_STATUS_SUCCESS, {} };
+			}
+			try {
+				T::Execute_(ctx, stx, DeserializeFromBlob<typename T::Params>(request.params));
+				return { TransportStatus::Success, PM_STATUS_SUCCESS, {} };
+			}
+			catch (const ActionExecutionError& e) {
+				pmlog_error(std::format("Error in batched action [{}] execution: {}", GetIdentifier(), e.what())).code(e.GetCode());
+				return { TransportStatus::ExecutionFailure, e.GetCode(), {} };
+			}
+			catch (...) {
+				pmlog_error(util::ReportException());
+				return { TransportStatus::TransportFailure, PM_STATUS_SUCCESS, {} };
+			}
+		}
 		const char* GetIdentifier() const final
 		{
 			return T::Identifier;
@@ -1,7 +1,9 @@
 #pragma once
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <memory>
+#include <string_view>
 #include "../../../CommonUtilities/log/Log.h"
 #include "AsyncAction.h"
 
@@ -20,7 +22,22 @@ namespace pmon::ipc::act
 
 		const AsyncAction<ExecutionContext>& Find(const std::string& key) const
 		{
-			return *actions_.at(key);
+			return *actions_.at(ids_.at(key));
+		}
+		// lookup by the numeric id assigned at registration (the index into the identifier table)
+		const AsyncAction<ExecutionContext>& Find(uint16_t id) const
+		{
+			return *actions_.at(id);
+		}
+		// table of action identifiers indexed by action id, sent to the remote endpoint at connection
+		std::vector<std::string> GetIdentifierTable() const
+		{
+			std::vector<std::string> table;
+			table.reserve(actions_.size());
+			for (auto& pAction : actions_) {
+				table.emplace_back(pAction->GetIdentifier());
+			}
+			return table;
 		}
 		// Note: 1 collection allowed per context-process (module)
 		static AsyncActionCollection& Get()
@@ -36,15 +53,44 @@ namespace pmon::ipc::act
 		void AddAction(std::unique_ptr<AsyncAction<ExecutionContext>> pAction)
 		{
 			auto id = pAction->GetIdentifier();
-			if (auto&& [i, inserted] = actions_.insert({ std::string{ id }, std::move(pAction) }); !inserted) {
+			if (auto&& [i, inserted] = ids_.insert({ std::string{ id }, uint16_t(actions_.size()) }); !inserted) {
 				assert(false && "Duplicate key in AsyncActionCollection");
 				pmlog_warn("Duplicate key for AsyncActionCollection").pmwatch(id);
+				return;
 			}
+			actions_.push_back(std::move(pAction));
 		}
 	private:
-		std::unordered_map<std::string, std::unique_ptr<AsyncAction<ExecutionContext>>> actions_;
+		// actions indexed by numeric id
+		std::vector<std::unique_ptr<AsyncAction<ExecutionContext>>> actions_;
+		std::unordered_map<std::string, uint16_t> ids_;
 	};
 
+	// run each sub-request of a batch in order against the actions of this module's collection
+	// a failed sub-request does not stop the batch, its status is reported in the matching response
+	template<class ExecutionContext>
+	BatchEnvelope::Response ExecuteBatch(ExecutionContext& ctx, typename ExecutionContext::SessionContextType& stx,
+		const BatchEnvelope::Params& batch)
+	{
+		auto& collection = AsyncActionCollection<ExecutionContext>::Get();
+		BatchEnvelope::Response res;
+		res.responses.reserve(batch.requests.size());
+		for (auto& req : batch.requests) {
+			try {
+				auto& action = collection.Find(req.actionId);
+				if (std::string_view{ action.GetIdentifier() } == BatchEnvelope::Identifier) {
+					pmlog_error("Nested batch actions are not supported").raise<util::Exception>();
+				}
+				res.responses.push_back(action.ExecuteSerialized(ctx, stx, req));
+			}
+			catch (...) {
+				pmlog_error(util::ReportException());
+				res.responses.push_back({ TransportStatus::TransportFailure, PM_STATUS_SUCCESS, {} });
+			}
+		}
+		return res;
+	}
+
 	template<class A, class E>
 	struct AsyncActionRegistrator
 	{
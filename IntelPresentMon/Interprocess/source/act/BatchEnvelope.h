@@ -0,0 +1,119 @@
+#pragma once
+#include "Packet.h"
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/vector.hpp>
+#include <cereal/types/string.hpp>
+#include <sstream>
+#include <exception>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pmon::ipc::act
+{
+	// serialize an action params/response object into an opaque blob that can be nested in a batch
+	template<class T>
+	std::string SerializeToBlob(const T& obj)
+	{
+		std::ostringstream stream;
+		{
+			cereal::BinaryOutputArchive ar{ stream };
+			ar(obj);
+		}
+		return std::move(stream).str();
+	}
+
+	template<class T>
+	T DeserializeFromBlob(const std::string& blob)
+	{
+		std::istringstream stream{ blob };
+		cereal::BinaryInputArchive ar{ stream };
+		T obj;
+		ar(obj);
+		return obj;
+	}
+
+	// one action request nested inside of a batch, params are serialized as for a standalone packet
+	struct BatchSubRequest
+	{
+		uint16_t actionId;
+		uint16_t actionVersion;
+		std::string params;
+
+		template<class A> void serialize(A& ar) {
+			ar(actionId, actionVersion, params);
+		}
+	};
+
+	// result of one nested action, statuses have the same meaning as in the PacketHeader
+	struct BatchSubResponse
+	{
+		TransportStatus transportStatus;
+		int32_t executionStatus;
+		std::string response;
+
+		template<class A> void serialize(A& ar) {
+			ar(transportStatus, executionStatus, response);
+		}
+	};
+
+	// client-side outcome of one nested action: either its response or the error it failed with
+	// sub-requests of a batch succeed or fail independently, so each one carries its own result
+	template<class Response>
+	class BatchResult
+	{
+	public:
+		BatchResult(Response response) : response_{ std::move(response) } {}
+		BatchResult(std::exception_ptr pError) : pError_{ std::move(pError) } {}
+		bool Succeeded() const
+		{
+			return !pError_;
+		}
+		std::exception_ptr GetError() const
+		{
+			return pError_;
+		}
+		// access the response, rethrowing the error of the sub-request if it failed
+		const Response& Get() const
+		{
+			if (pError_) {
+				std::rethrow_exception(pError_);
+			}
+			return *response_;
+		}
+		Response& Get()
+		{
+			if (pError_) {
+				std::rethrow_exception(pError_);
+			}
+			return *response_;
+		}
+	private:
+		std::optional<Response> response_;
+		std::exception_ptr pError_;
+	};
+
+	// wire description of the batch action, which executes N sub-actions in one round trip
+	// endpoints register a concrete action with this identifier and these Params/Response types
+	struct BatchEnvelope
+	{
+		static constexpr const char* Identifier = "Batch";
+		static constexpr uint16_t Version = 1;
+		struct Params
+		{
+			std::vector<BatchSubRequest> requests;
+
+			template<class A> void serialize(A& ar) {
+				ar(requests);
+			}
+		};
+		struct Response
+		{
+			std::vector<BatchSubResponse> responses;
+
+			template<class A> void serialize(A& ar) {
+				ar(responses);
+			}
+		};
+	};
+}
@@ -4,35 +4,42 @@
 
 namespace pmon::ipc::act
 {
-	enum class TransportStatus
+	enum class TransportStatus : int32_t
 	{
 		Success,
 		ExecutionFailure,
 		TransportFailure,
 	};
 
-	enum class PacketType
+	enum class PacketType : int32_t
 	{
 		ActionRequest,
 		ActionResponse,
 		ActionEvent,
+		// sent once by each endpoint upon connection, payload is the table of action identifiers
+		// indexed by the numeric action id that the endpoint expects in request headers
+		ActionTable,
 	};
 
+	// compact fixed-size header that is copied raw onto the wire (see util::pipe::FramePrefix)
+	// actions are identified by the numeric id negotiated with the remote endpoint at connection
+	// every byte is a named field (no padding) and every field defaults to zero, so that no
+	// uninitialized memory is ever sent
 	struct PacketHeader
 	{
-		std::string identifier;
-		uint32_t commandToken;
-		TransportStatus transportStatus;
-		int executionStatus;
-		PacketType packetType;
-		uint16_t headerVersion;
-		uint16_t actionVersion;
-
-		template<class A> void serialize(A& ar) {
-			ar(identifier, commandToken, transportStatus, executionStatus,
-				packetType, headerVersion, actionVersion);
-		}
+		uint32_t commandToken = 0;
+		TransportStatus transportStatus = TransportStatus::Success;
+		int32_t executionStatus = 0;
+		PacketType packetType = PacketType::ActionRequest;
+		uint16_t actionId = 0;
+		uint16_t headerVersion = 0;
+		uint16_t actionVersion = 0;
+		// fills the tail of the header out to its alignment, always 0
+		uint16_t reserved = 0;
 	};
+	static_assert(sizeof(PacketHeader) == 24);
+
+	inline constexpr uint16_t CurrentHeaderVersion = 2;
 
 	struct EmptyPayload {};
 
@@ -0,0 +1,98 @@
+#pragma once
+#include "../../../CommonUtilities/win/WinAPI.h"
+#include "../../../CommonUtilities/pipe/Pipe.h"
+#include "../../../CommonUtilities/log/Log.h"
+#include "Packet.h"
+#include <functional>
+#include <unordered_map>
+#include <memory>
+#include <exception>
+
+namespace pmon::ipc::act
+{
+	namespace as = boost::asio;
+
+	// routes responses arriving on a pipe to the requests waiting on them, keyed by command token
+	// this lets any number of requests be in flight on a single pipe at the same time
+	// not thread safe: only to be accessed from the strand of the io_context running the connection
+	class ResponseRouter
+	{
+	public:
+		// called with the response header and the pipe holding the response payload, which the
+		// completion must consume; called with an exception instead if the connection fails first
+		using Completion = std::function<void(const PacketHeader*, util::pipe::DuplexPipe*, std::exception_ptr)>;
+	private:
+		using PendingMap_ = std::unordered_map<uint32_t, Completion>;
+	public:
+		// removes the completion from the router when destroyed, so that a request abandoned while in
+		// flight (e.g. its coroutine was destroyed) leaves nothing behind; safe to outlive the router
+		class Registration
+		{
+		public:
+			Registration(std::weak_ptr<PendingMap_> pPending, uint32_t commandToken)
+				:
+				pPending_{ std::move(pPending) },
+				commandToken_{ commandToken }
+			{}
+			Registration(const Registration&) = delete;
+			Registration& operator=(const Registration&) = delete;
+			~Registration()
+			{
+				if (auto pPending = pPending_.lock()) {
+					pPending->erase(commandToken_);
+				}
+			}
+		private:
+			std::weak_ptr<PendingMap_> pPending_;
+			uint32_t commandToken_;
+		};
+		[[nodiscard]] Registration Register(uint32_t commandToken, Completion completion)
+		{
+			if (auto&& [i, inserted] = pPending_->emplace(commandToken, std::move(completion)); !inserted) {
+				pmlog_error("Command token already has a request in flight").pmwatch(commandToken)
+					.raise<util::Exception>();
+			}
+			return { pPending_, commandToken };
+		}
+		size_t GetInFlightCount() const
+		{
+			return pPending_->size();
+		}
+		// read responses from the pipe and complete their requests until the pipe fails, at which
+		// point all requests still in flight are failed with the pipe error
+		as::awaitable<void> Run(util::pipe::DuplexPipe& pipe)
+		{
+			try {
+				while (true) {
+					const auto header = co_await pipe.ReadPacketConsumeHeader<PacketHeader>();
+					auto i = pPending_->find(header.commandToken);
+					if (i == pPending_->end()) {
+						pmlog_warn("Response received with no request in flight").pmwatch(header.commandToken);
+						pipe.DiscardPacketPayload();
+						continue;
+					}
+					// remove before completing so that the completion is free to register new requests
+					auto completion = std::move(i->second);
+					pPending_->erase(i);
+					completion(&header, &pipe, {});
+				}
+			}
+			catch (...) {
+				FailAll_(std::current_exception());
+				throw;
+			}
+		}
+	private:
+		// functions
+		void FailAll_(std::exception_ptr pException)
+		{
+			auto pending = std::move(*pPending_);
+			pPending_->clear();
+			for (auto& [token, completion] : pending) {
+				completion(nullptr, nullptr, pException);
+			}
+		}
+		// data
+		std::shared_ptr<PendingMap_> pPending_ = std::make_shared<PendingMap_>();
+	};
+}
@@ -8,6 +8,8 @@
 #include "AsyncActionCollection.h"
 #include "ActionContext.h"
 #include <thread>
+#include <future>
+#include <vector>
 #include <boost/asio/experimental/awaitable_operators.hpp>
 
 
@@ -31,9 +33,19 @@ namespace pmon::ipc::act
             ctx_{ std::move(context) }
         {
             stx_.pConn = SymmetricActionConnector<ExecCtx>::ConnectToServer(basePipeName_, ioctx_);
+            // action id negotiation must complete before any actions can be dispatched
+            auto handshake = handshakePromise_.get_future();
             as::co_spawn(ioctx_, SessionStrand_(), as::detached);
             runner_ = mt::Thread{ std::format("symact-{}-cli", MakeWorkerName_(basePipeName_)),
                 &SymmetricActionClient::Run_, this };
+            try {
+                handshake.get();
+            }
+            catch (...) {
+                // stop the runner so that it can be joined during unwinding
+                ioctx_.stop();
+                throw;
+            }
         }
 
         SymmetricActionClient(const SymmetricActionClient&) = delete;
@@ -50,6 +62,24 @@ namespace pmon::ipc::act
         {
             return stx_.pConn->DispatchSync(std::forward<Params>(params), ioctx_, stx_);
         }
+        // returns immediately, many requests can be in flight at once and complete in any order
+        template<class Params>
+        auto DispatchAsync(Params&& params)
+        {
+            return stx_.pConn->DispatchAsync(std::forward<Params>(params), ioctx_, stx_);
+        }
+        // executes all actions on the server in a single round trip
+        template<class Params>
+        auto DispatchBatch(std::vector<Params> paramsList)
+        {
+            return stx_.pConn->DispatchBatch<Params>(std::move(paramsList), ioctx_, stx_);
+        }
+        // executes actions of different types on the server in a single round trip
+        template<class...Params>
+        auto DispatchMixedBatch(Params...params)
+        {
+            return stx_.pConn->DispatchMixedBatch(ioctx_, stx_, std::move(params)...);
+        }
         template<class Params>
         auto DispatchDetached(Params&& params)
         {
@@ -100,17 +130,25 @@ namespace pmon::ipc::act
         as::awaitable<void> SessionStrand_()
         {
             // TODO: work on propagation of server disconnection event errors
+            bool handshakeDone = false;
             try {
-                bool alive = true;
-                while (true) {
-                    co_await stx_.pConn->SyncHandleRequest(ctx_, stx_);
-                }
+                co_await stx_.pConn->ExchangeActionTables();
+                handshakeDone = true;
+                handshakePromise_.set_value();
+                // handle requests from the server and route responses to our own requests
+                co_await stx_.pConn->Run(ctx_, stx_);
             }
             catch (const pipe::BenignPipeError&) {
                 pmlog_dbg(util::ReportException());
+                if (!handshakeDone) {
+                    handshakePromise_.set_exception(std::current_exception());
+                }
             }
             catch (...) {
                 pmlog_error(util::ReportException());
+                if (!handshakeDone) {
+                    handshakePromise_.set_exception(std::current_exception());
+                }
             }
             pmlog_info("Exiting action server session strand");
         }
@@ -119,6 +157,7 @@ namespace pmon::ipc::act
         pipe::as::io_context ioctx_;
         SessionContextType stx_;
         ExecCtx ctx_;
+        std::promise<void> handshakePromise_;
         mt::Thread runner_;
     };
 }
\ No newline at end of file
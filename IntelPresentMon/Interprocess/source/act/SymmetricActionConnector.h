@@ -5,6 +5,13 @@
 #include "../../../CommonUtilities/str/String.h"
 #include "Transfer.h"
 #include "AsyncActionCollection.h"
+#include "ActionIdMap.h"
+#include "ResponseRouter.h"
+#include "BatchEnvelope.h"
+#include <future>
+#include <tuple>
+#include <utility>
+#include <vector>
 #include <boost/asio/experimental/awaitable_operators.hpp>
 
 
@@ -24,18 +31,18 @@ namespace pmon::ipc::act
                 // read packet from the pipe into buffer, partially deserialize (header only)
                 header = co_await pInPipe_->ReadPacketConsumeHeader<PacketHeader>();
                 // -- do per-action processing based on received header --
+                // lookup the command by the numeric id we assigned it in the action table
+                auto& action = AsyncActionCollection<ExecCtx>::Get().Find(header.actionId);
                 // any action other than OpenSession without having clientPid is an anomaly
                 // TODO: make this processing a customization point in ExecutionContext and move it out of here
-                if (header.identifier != "OpenSession") {
-                    assert(bool(stx.remotePid));
-                    if (!stx.remotePid) {
-                        pmlog_warn("Received action without a valid session opened");
-                    }
+                if (!stx.remotePid && action.GetIdentifier() != "OpenSession"sv) {
+                    assert(false && "Received action without a valid session opened");
+                    pmlog_warn("Received action without a valid session opened");
                 }
-                // lookup the command by identifier and execute it with remaining buffer contents
+                // execute the command with remaining buffer contents
                 // response is then transmitted over the pipe to remote
                 // TODO: make this return result code (increment error count based on this)
-                co_await AsyncActionCollection<ExecCtx>::Get().Find(header.identifier).Execute(ctx, stx, header, *pInPipe_);
+                co_await action.Execute(ctx, stx, header, *pInPipe_);
                 co_return;
             }
             catch (const pipe::PipeError&) {
@@ -52,17 +59,112 @@ namespace pmon::ipc::act
             auto resHeader = MakeResponseHeader(header, TransportStatus::TransportFailure, PM_STATUS_SUCCESS);
             co_await pInPipe_->WritePacket(std::move(resHeader), EmptyPayload{}, ctx.responseWriteTimeoutMs);
         }
+        // handle incoming requests and route incoming responses until the connection is terminated
+        as::awaitable<void> Run(ExecCtx& ctx, SessionContextType& stx)
+        {
+            using namespace as::experimental::awaitable_operators;
+            const auto handleRequests = [](SymmetricActionConnector& conn, ExecCtx& ctx,
+                SessionContextType& stx) -> as::awaitable<void> {
+                while (true) {
+                    co_await conn.SyncHandleRequest(ctx, stx);
+                }
+            };
+            // when either loop fails the other is cancelled, so both are done with the session on return
+            co_await(handleRequests(*this, ctx, stx) || responseRouter_.Run(*pOutPipe_));
+        }
         template<class Params>
         auto DispatchSync(Params&& params, as::io_context& ioctx, SessionContextType& stx)
+        {
+            return DispatchAsync(std::forward<Params>(params), ioctx, stx).get();
+        }
+        // issue the request without waiting for the response, so that many requests can be in flight
+        // at the same time; responses are matched to requests by command token
+        template<class Params>
+        auto DispatchAsync(Params&& params, as::io_context& ioctx, SessionContextType& stx)
+            -> std::future<ResponseFromParams<Params>>
         {
             LogDispatch_<Params>(stx);
             // wrap the SyncRequest in a coro so we can assure non-concurrent increment of the token
-            // CAUTION: this coro has captures that will blow up if we try and exit this function before completion
-            // currently OK because we block on future, but any future refactor needs to take this into consideration
-            const auto coro = [](auto&& params, SessionContextType& stx, util::pipe::DuplexPipe& pipe) -> AwaitableFromParams<Params> {
-                co_return co_await SyncRequest<ActionFromParams<Params>>(std::forward<Params>(params), stx.nextCommandToken++, pipe);
+            // params are taken by value because the coro can outlive this call
+            const auto coro = [](std::decay_t<Params> params, SessionContextType& stx, util::pipe::DuplexPipe& pipe,
+                const ActionIdMap& remoteActions, ResponseRouter& router) -> AwaitableFromParams<Params> {
+                using Action = ActionFromParams<Params>;
+                co_return co_await SyncRequest<Action>(params, stx.nextCommandToken++,
+                    remoteActions.GetId<Action>(), pipe, router);
             };
-            return as::co_spawn(ioctx, coro(std::forward<Params>(params), stx, *pOutPipe_), as::use_future).get();
+            return as::co_spawn(ioctx, coro(std::forward<Params>(params), stx, *pOutPipe_, remoteActions_,
+                responseRouter_), as::use_future);
+        }
+        // execute many actions of the same type on the remote in a single round trip
+        // all sub-requests are executed even if some fail, and each one reports its own response or error
+        // only a failure of the batch as a whole (e.g. transport) is thrown from here
+        template<class Params>
+        auto DispatchBatch(std::vector<std::decay_t<Params>> paramsList, as::io_context& ioctx, SessionContextType& stx)
+            -> std::vector<BatchResult<ResponseFromParams<Params>>>
+        {
+            using Action = ActionFromParams<Params>;
+            using Response = ResponseFromParams<Params>;
+            pmlog_dbg("Action Batch Dispatch").pmwatch(Action::Identifier).pmwatch(paramsList.size()).pmwatch(stx.remotePid);
+            // the batch is packed inside the coro so that action ids are read on the io thread
+            const auto coro = [](std::vector<std::decay_t<Params>> paramsList, SessionContextType& stx,
+                util::pipe::DuplexPipe& pipe, const ActionIdMap& remoteActions,
+                ResponseRouter& router) -> as::awaitable<std::vector<BatchResult<Response>>> {
+                BatchEnvelope::Params batch;
+                batch.requests.reserve(paramsList.size());
+                const auto actionId = remoteActions.GetId<Action>();
+                for (auto& params : paramsList) {
+                    batch.requests.push_back({ actionId, Action::Version, SerializeToBlob(params) });
+                }
+                const auto batchRes = co_await PipelinedRequest<BatchEnvelope::Response>(batch,
+                    MakeRequestHeader(PacketType::ActionRequest, stx.nextCommandToken++,
+                        remoteActions.GetId<BatchEnvelope>(), BatchEnvelope::Version), pipe, router);
+                if (batchRes.responses.size() != paramsList.size()) {
+                    pmlog_error("Batch response count does not match request count")
+                        .pmwatch(batchRes.responses.size()).pmwatch(paramsList.size()).raise<util::Exception>();
+                }
+                std::vector<BatchResult<Response>> responses;
+                responses.reserve(batchRes.responses.size());
+                for (auto& sub : batchRes.responses) {
+                    responses.push_back(DecodeBatchSubResponse_<Response>(sub));
+                }
+                co_return responses;
+            };
+            return as::co_spawn(ioctx, coro(std::move(paramsList), stx, *pOutPipe_, remoteActions_, responseRouter_),
+                as::use_future).get();
+        }
+        // execute actions of different types on the remote in a single round trip
+        // results are returned in a tuple in the order of the params, with the same per-item semantics as DispatchBatch
+        template<class...Params>
+        auto DispatchMixedBatch(as::io_context& ioctx, SessionContextType& stx, Params...params)
+            -> std::tuple<BatchResult<ResponseFromParams<Params>>...>
+        {
+            pmlog_dbg("Action Mixed Batch Dispatch").pmwatch(sizeof...(Params)).pmwatch(stx.remotePid);
+            // the coro returns the raw envelope because its result must be default constructible
+            const auto coro = [](std::tuple<Params...> paramsTuple, SessionContextType& stx,
+                util::pipe::DuplexPipe& pipe, const ActionIdMap& remoteActions,
+                ResponseRouter& router) -> as::awaitable<BatchEnvelope::Response> {
+                BatchEnvelope::Params batch;
+                std::apply([&](const auto&...params) {
+                    (batch.requests.push_back({
+                        remoteActions.GetId<ActionFromParams<std::decay_t<decltype(params)>>>(),
+                        ActionFromParams<std::decay_t<decltype(params)>>::Version,
+                        SerializeToBlob(params) }), ...);
+                }, paramsTuple);
+                auto batchRes = co_await PipelinedRequest<BatchEnvelope::Response>(batch,
+                    MakeRequestHeader(PacketType::ActionRequest, stx.nextCommandToken++,
+                        remoteActions.GetId<BatchEnvelope>(), BatchEnvelope::Version), pipe, router);
+                if (batchRes.responses.size() != sizeof...(Params)) {
+                    pmlog_error("Batch response count does not match request count")
+                        .pmwatch(batchRes.responses.size()).pmwatch(sizeof...(Params)).raise<util::Exception>();
+                }
+                co_return batchRes;
+            };
+            const auto batchRes = as::co_spawn(ioctx, coro(std::tuple<Params...>{ std::move(params)... }, stx,
+                *pOutPipe_, remoteActions_, responseRouter_), as::use_future).get();
+            return [&]<size_t...I>(std::index_sequence<I...>) {
+                return std::tuple<BatchResult<ResponseFromParams<Params>>...>{
+                    DecodeBatchSubResponse_<ResponseFromParams<Params>>(batchRes.responses[I])... };
+            }(std::index_sequence_for<Params...>{});
         }
         // TODO: this should support both retained requests and unretained events
         // need to figure out fully async request flow and how to implement the continuation API(s)
@@ -71,15 +173,18 @@ namespace pmon::ipc::act
         {
             LogDispatch_<Params>(stx);
             // wrap the AsyncEmit in a coro so we can assure non-concurrent increment of the token
-            const auto coro = [](auto&& params, SessionContextType& stx, util::pipe::DuplexPipe& pipe) -> as::awaitable<void> {
+            const auto coro = [](auto&& params, SessionContextType& stx, util::pipe::DuplexPipe& pipe,
+                const ActionIdMap& remoteActions) -> as::awaitable<void> {
                 try {
-                    co_await AsyncEmit<ActionFromParams<Params>>(std::forward<Params>(params), stx.nextCommandToken++, pipe);
+                    using Action = ActionFromParams<Params>;
+                    co_await AsyncEmit<Action>(std::forward<Params>(params), stx.nextCommandToken++,
+                        remoteActions.GetId<Action>(), pipe);
                 }
                 catch (...) {
                     pmlog_error(ReportException());
                 }
             };
-            as::co_spawn(ioctx, coro(std::forward<Params>(params), stx, *pOutPipe_), as::detached);
+            as::co_spawn(ioctx, coro(std::forward<Params>(params), stx, *pOutPipe_, remoteActions_), as::detached);
         }
         template<class Params>
         void DispatchWithContinuation(Params&& params, as::io_context& ioctx, SessionContextType& stx,
@@ -87,11 +192,13 @@ namespace pmon::ipc::act
         {
             LogDispatch_<Params>(stx);
             // wrap the AsyncEmit in a coro so we can assure non-concurrent increment of the token
-            const auto coro = [](auto params, SessionContextType& stx, util::pipe::DuplexPipe& pipe, auto conti)
-                -> as::awaitable<void> {
+            const auto coro = [](auto params, SessionContextType& stx, util::pipe::DuplexPipe& pipe,
+                const ActionIdMap& remoteActions, ResponseRouter& router, auto conti) -> as::awaitable<void> {
                 try {
                     try {
-                        auto res = co_await SyncRequest<ActionFromParams<Params>>(std::forward<Params>(params), stx.nextCommandToken++, pipe);
+                        using Action = ActionFromParams<Params>;
+                        auto res = co_await SyncRequest<Action>(std::forward<Params>(params), stx.nextCommandToken++,
+                            remoteActions.GetId<Action>(), pipe, router);
                         conti(std::move(res), {});
                     }
                     catch (...) {
@@ -103,12 +210,20 @@ namespace pmon::ipc::act
                     pmlog_error(ReportException("Final failure in calling continuation"));
                 }
             };
-            as::co_spawn(ioctx, coro(std::forward<Params>(params), stx, *pOutPipe_, std::move(conti)), as::detached);
+            as::co_spawn(ioctx, coro(std::forward<Params>(params), stx, *pOutPipe_, remoteActions_,
+                responseRouter_, std::move(conti)), as::detached);
         }
         uint32_t GetId() const
         {
             return pInPipe_->GetId();
         }
+        // negotiate numeric action ids with the remote endpoint, must complete before dispatching any actions
+        as::awaitable<void> ExchangeActionTables()
+        {
+            remoteActions_ = ActionIdMap{ co_await act::ExchangeActionTables(
+                AsyncActionCollection<ExecCtx>::Get().GetIdentifierTable(), *pInPipe_, *pOutPipe_) };
+            pmlog_dbg(std::format("Action tables exchanged, remote endpoint supports {} actions", remoteActions_.GetSize()));
+        }
         static as::awaitable<std::unique_ptr<SymmetricActionConnector>> AcceptClientConnection(
             const std::string& basePipeName, as::io_context& ioctx, const std::string& security)
         {
@@ -139,9 +254,34 @@ namespace pmon::ipc::act
         {
             using Action = ActionFromParams<Params>;
             pmlog_dbg("Action Dispatch").pmwatch(Action::Identifier).pmwatch(stx.remotePid);
+        }
+        // convert the result of one sub-request of a batch into its response or the error it failed with
+        template<class Response>
+        static BatchResult<Response> DecodeBatchSubResponse_(const BatchSubResponse& sub)
+        {
+            if (sub.transportStatus == TransportStatus::Success) {
+                try {
+                    return DeserializeFromBlob<Response>(sub.response);
+                }
+                catch (...) {
+                    pmlog_error(util::ReportException("Bad response blob in batch"));
+                    return std::current_exception();
+                }
+            }
+            else if (sub.executionStatus) {
+                const auto code = (PM_STATUS)sub.executionStatus;
+                pmlog_error("Execution error response to batched request").code(code);
+                return std::make_exception_ptr(util::Except<ActionExecutionError>(code));
+            }
+            pmlog_error("Transport error response to batched request");
+            return std::make_exception_ptr(util::Except<util::Exception>("Transport error response to batched request"));
         }
 		// data
 		std::unique_ptr<pipe::DuplexPipe> pOutPipe_;
 		std::unique_ptr<pipe::DuplexPipe> pInPipe_;
+		// numeric ids of the actions supported by the remote endpoint
+		ActionIdMap remoteActions_;
+		// matches responses read from the out pipe to requests in flight
+		ResponseRouter responseRouter_;
 	};
 }
\ No newline at end of file
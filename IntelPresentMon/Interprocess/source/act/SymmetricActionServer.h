@@ -105,10 +105,10 @@ namespace pmon::ipc::act
                 auto& stx = i->second;
                 // fork this acceptor coroutine
                 as::co_spawn(ioctx_, SessionStrand_(), as::detached);
-                // run the action handler until client session is terminated
-                while (true) {
-                    co_await stx.pConn->SyncHandleRequest(ctx_, stx);
-                }
+                // negotiate numeric action ids before handling any requests
+                co_await stx.pConn->ExchangeActionTables();
+                // run the action handler and response router until client session is terminated
+                co_await stx.pConn->Run(ctx_, stx);
             }
             catch (const pipe::BenignPipeError&) {
                 pmlog_dbg(util::ReportException());
@@ -4,51 +4,143 @@
 #include "Packet.h"
 #include "ActionExecutionError.h"
 #include "AsyncAction.h"
+#include "ResponseRouter.h"
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/experimental/awaitable_operators.hpp>
+#include <vector>
+#include <string>
+#include <optional>
+#include <chrono>
+#include <memory>
 
 namespace pmon::ipc::act
 {
 	namespace as = boost::asio;
 	using namespace util::pipe;
 
-	template<Request C>
-	auto SyncRequest(const typename C::Params& params, uint32_t commandToken, DuplexPipe& pipe, std::optional<uint32_t> timeoutMs = {})
-		-> as::awaitable<typename C::Response>
+	// check the status of a response and consume its payload from the pipe
+	template<class Response>
+	Response DecodeResponse(const PacketHeader& resHeader, DuplexPipe& pipe)
 	{
-		const PacketHeader reqHeader{
-			.identifier = C::Identifier,
-			.commandToken = commandToken,
-			.packetType = PacketType::ActionRequest,
-			.headerVersion = 1,
-			.actionVersion = C::Version,
-		};
-		co_await pipe.WritePacket(reqHeader, params, timeoutMs);
-		const auto resHeader = co_await pipe.ReadPacketConsumeHeader<PacketHeader>(timeoutMs);
 		if (resHeader.transportStatus != TransportStatus::Success) {
 			// consume the empty payload to leave the pipe stream in a clean state
 			pipe.ConsumePacketPayload<EmptyPayload>();
 			if (resHeader.executionStatus) {
 				const auto code = (PM_STATUS)resHeader.executionStatus;
 				pmlog_error("Execution error response to SyncRequest").code(code);
-				throw util::Except<ActionExecutionError>((PM_STATUS)resHeader.executionStatus);
+				throw util::Except<ActionExecutionError>(code);
 			}
 			else {
 				pmlog_error("Execution error response to SyncRequest").raise<util::Exception>();
 			}
 		}
-		co_return pipe.ConsumePacketPayload<typename C::Response>();
+		return pipe.ConsumePacketPayload<Response>();
+	}
+
+	// write a request and suspend until the router delivers the response with a matching command token
+	// other requests can be written and complete while this one is in flight
+	template<class Response, class Params>
+	auto PipelinedRequest(const Params& params, const PacketHeader& reqHeader, DuplexPipe& pipe,
+		ResponseRouter& router, std::optional<uint32_t> timeoutMs = {})
+		-> as::awaitable<Response>
+	{
+		// completion state is shared with the routed closure so that it stays valid even if this
+		// coroutine is destroyed (e.g. its io_context is stopped) while the request is in flight
+		struct State_
+		{
+			State_(const as::any_io_executor& exec)
+				:
+				completionSignal{ exec, as::steady_timer::duration::max() }
+			{}
+			std::optional<Response> response;
+			std::exception_ptr pException;
+			bool completed = false;
+			as::steady_timer completionSignal;
+		};
+		const auto pState = std::make_shared<State_>(co_await as::this_coro::executor);
+		if (timeoutMs) {
+			pState->completionSignal.expires_after(std::chrono::milliseconds{ *timeoutMs });
+		}
+		// the registration is dropped when the coroutine frame goes away on any path, so the router never
+		// holds a completion for a request that nobody is waiting on anymore
+		const auto registration = router.Register(reqHeader.commandToken,
+			[pState](const PacketHeader* pHeader, DuplexPipe* pPipe, std::exception_ptr pEx) {
+			try {
+				if (pEx) {
+					std::rethrow_exception(pEx);
+				}
+				pState->response = DecodeResponse<Response>(*pHeader, *pPipe);
+			}
+			catch (...) {
+				pState->pException = std::current_exception();
+			}
+			pState->completed = true;
+			pState->completionSignal.cancel();
+		});
+		co_await pipe.WritePacket(reqHeader, params, timeoutMs);
+		// response might have been routed already while we were suspended in the write
+		if (!pState->completed) {
+			auto ec = boost::system::error_code{};
+			co_await pState->completionSignal.async_wait(as::redirect_error(as::use_awaitable, ec));
+		}
+		if (!pState->completed) {
+			throw util::Except<PipeError>("Timeout waiting for response");
+		}
+		if (pState->pException) {
+			std::rethrow_exception(pState->pException);
+		}
+		co_return std::move(*pState->response);
+	}
+
+	inline PacketHeader MakeRequestHeader(PacketType type, uint32_t commandToken, uint16_t actionId, uint16_t actionVersion)
+	{
+		return PacketHeader{
+			.commandToken = commandToken,
+			.packetType = type,
+			.actionId = actionId,
+			.headerVersion = CurrentHeaderVersion,
+			.actionVersion = actionVersion,
+		};
+	}
+
+	template<Request C>
+	auto SyncRequest(const typename C::Params& params, uint32_t commandToken, uint16_t actionId,
+		DuplexPipe& pipe, ResponseRouter& router, std::optional<uint32_t> timeoutMs = {})
+		-> as::awaitable<typename C::Response>
+	{
+		co_return co_await PipelinedRequest<typename C::Response>(params,
+			MakeRequestHeader(PacketType::ActionRequest, commandToken, actionId, C::Version), pipe, router, timeoutMs);
 	}
 
 	template<Event C>
-	auto AsyncEmit(const typename C::Params& params, uint32_t commandToken, DuplexPipe& pipe, std::optional<uint32_t> timeoutMs = {})
+	auto AsyncEmit(const typename C::Params& params, uint32_t commandToken, uint16_t actionId,
+		DuplexPipe& pipe, std::optional<uint32_t> timeoutMs = {})
 		-> as::awaitable<void>
 	{
-		const PacketHeader reqHeader{
-			.identifier = C::Identifier,
-			.commandToken = commandToken,
-			.packetType = PacketType::ActionEvent,
-			.headerVersion = 1,
-			.actionVersion = C::Version,
+		co_await pipe.WritePacket(MakeRequestHeader(PacketType::ActionEvent, commandToken, actionId, C::Version),
+			params, timeoutMs);
+	}
+
+	// send the local table of action identifiers (indexed by action id) to the remote endpoint
+	// and receive the remote table in return; done once per connection before any requests
+	inline auto ExchangeActionTables(const std::vector<std::string>& localTable, DuplexPipe& responsePipe,
+		DuplexPipe& requestPipe, std::optional<uint32_t> timeoutMs = {})
+		-> as::awaitable<std::vector<std::string>>
+	{
+		using namespace as::experimental::awaitable_operators;
+		const PacketHeader tableHeader{
+			.packetType = PacketType::ActionTable,
+			.headerVersion = CurrentHeaderVersion,
 		};
-		co_await pipe.WritePacket(reqHeader, params, timeoutMs);
+		// local table goes out on the pipe that the remote reads responses from, and the remote
+		// table comes in on the pipe that we read responses from; both run concurrently
+		const auto remoteHeader = co_await(responsePipe.WritePacket(tableHeader, localTable, timeoutMs) &&
+			requestPipe.ReadPacketConsumeHeader<PacketHeader>(timeoutMs));
+		auto remoteTable = requestPipe.ConsumePacketPayload<std::vector<std::string>>();
+		if (remoteHeader.packetType != PacketType::ActionTable || remoteHeader.headerVersion != CurrentHeaderVersion) {
+			pmlog_error("Bad action table packet from remote endpoint")
+				.pmwatch((int)remoteHeader.packetType).pmwatch(remoteHeader.headerVersion).raise<util::Exception>();
+		}
+		co_return remoteTable;
 	}
 }
\ No newline at end of file
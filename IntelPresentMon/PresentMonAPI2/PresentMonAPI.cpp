@@ -339,6 +339,31 @@ PRESENTMON_API2_EXPORT PM_STATUS pmPollStaticQuery(PM_SESSION_HANDLE sessionHand
 	}
 }
 
+PRESENTMON_API2_EXPORT PM_STATUS pmPollStaticQueryBatch(PM_SESSION_HANDLE sessionHandle, PM_QUERY_ELEMENT* pElements, uint64_t numElements, uint32_t processId, uint8_t* pBlob, uint32_t* pBlobSize)
+{
+	try {
+		if (!pElements) {
+			pmlog_error("null ptr to query elements").diag();
+			return PM_STATUS_BAD_ARGUMENT;
+		}
+		if (!numElements) {
+			pmlog_error("zero query elements").diag();
+			return PM_STATUS_BAD_ARGUMENT;
+		}
+		if (!pBlobSize) {
+			pmlog_error("null ptr to blob size").diag();
+			return PM_STATUS_BAD_ARGUMENT;
+		}
+		LookupMiddleware_(sessionHandle).PollStaticQueryBatch({ pElements, size_t(numElements) }, processId, pBlob, *pBlobSize);
+		return PM_STATUS_SUCCESS;
+	}
+	catch (...) {
+		const auto code = util::GeneratePmStatus();
+		pmlog_error(util::ReportException()).code(code);
+		return code;
+	}
+}
+
 PRESENTMON_API2_EXPORT PM_STATUS pmRegisterFrameQuery(PM_SESSION_HANDLE sessionHandle, PM_FRAME_QUERY_HANDLE* pQueryHandle, PM_QUERY_ELEMENT* pElements, uint64_t numElements, uint32_t* pBlobSize)
 {
 	try {
@@ -394,6 +394,11 @@ extern "C" {
 	PRESENTMON_API2_EXPORT PM_STATUS pmPollDynamicQuery(PM_DYNAMIC_QUERY_HANDLE handle, uint32_t processId, uint8_t* pBlob, uint32_t* numSwapChains);
 	// query a static metric immediately, writing the result into the specified memory blob (byte buffer)
 	PRESENTMON_API2_EXPORT PM_STATUS pmPollStaticQuery(PM_SESSION_HANDLE sessionHandle, const PM_QUERY_ELEMENT* pElement, uint32_t processId, uint8_t* pBlob);
+	// query multiple static metrics immediately, writing each element's dataOffset/dataSize and its result into the blob
+	// pBlobSize holds the size of pBlob on input and receives the required size; PM_STATUS_INSUFFICIENT_BUFFER is
+	// returned (and nothing is polled) if pBlob is null or too small
+	// added in API 3.1; through the loader, a 3.0 middleware returns PM_STATUS_MIDDLEWARE_MISSING_ENDPOINT
+	PRESENTMON_API2_EXPORT PM_STATUS pmPollStaticQueryBatch(PM_SESSION_HANDLE sessionHandle, PM_QUERY_ELEMENT* pElements, uint64_t numElements, uint32_t processId, uint8_t* pBlob, uint32_t* pBlobSize);
 	// register a frame query used for consuming desired metrics from a queue of frame events
 	PRESENTMON_API2_EXPORT PM_STATUS pmRegisterFrameQuery(PM_SESSION_HANDLE sessionHandle, PM_FRAME_QUERY_HANDLE* pHandle, PM_QUERY_ELEMENT* pElements, uint64_t numElements, uint32_t* pBlobSize);
 	// consume frame event metric data based on the filter registered with pmRegisterFrameQuery
@@ -69,12 +69,7 @@ PRESENTMON_API2_EXPORT PM_STATUS pmDiagnosticDequeueMessage(PM_DIAGNOSTIC_MESSAG
 	try {
 		if (ppMessage) {
 			if (auto pDiag = log::GetDiagnostics()) {
-				if (auto pMessage = pDiag->DequeueMessage()) {
-					*ppMessage = pMessage.release();
-				}
-				else {
-					*ppMessage = nullptr;
-				}
+				*ppMessage = pDiag->DequeueMessage();
 				return PM_STATUS_SUCCESS;
 			}
 		}
@@ -99,7 +94,8 @@ PRESENTMON_API2_EXPORT PM_STATUS pmDiagnosticFreeMessage(PM_DIAGNOSTIC_MESSAGE*
 {
 	try {
 		if (pMessage) {
-			delete pMessage;
+			// returns the message to the pool of the driver that queued it
+			log::DiagnosticMessage::Free(pMessage);
 			return PM_STATUS_SUCCESS;
 		}
 	} pmcatch_report;
@@ -106,6 +106,7 @@ extern "C" {
 	PRESENTMON_API2_EXPORT uint32_t pmDiagnosticGetDiscardedMessageCount();
 	// retrieve a message from the queue; sets pointer to NULL when no message available
 	// use pmDiagnosticFreeMessage to delete the message after processed to avoid memory leaks
+	// message strings are truncated to bounded lengths (text 1023 chars, trace 2047, location 259)
 	PRESENTMON_API2_EXPORT PM_STATUS pmDiagnosticDequeueMessage(PM_DIAGNOSTIC_MESSAGE** ppMessage);
 	// inject a message into the queue; messages must use a user-range subsystem id
 	PRESENTMON_API2_EXPORT PM_STATUS pmDiagnosticEnqueueMessage(const PM_DIAGNOSTIC_MESSAGE* pMessage);
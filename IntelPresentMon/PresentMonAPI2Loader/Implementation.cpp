@@ -36,6 +36,7 @@ PM_STATUS(*pFunc_pmRegisterDynamicQuery_)(PM_SESSION_HANDLE, PM_DYNAMIC_QUERY_HA
 PM_STATUS(*pFunc_pmFreeDynamicQuery_)(PM_DYNAMIC_QUERY_HANDLE) = nullptr;
 PM_STATUS(*pFunc_pmPollDynamicQuery_)(PM_DYNAMIC_QUERY_HANDLE, uint32_t, uint8_t*, uint32_t*) = nullptr;
 PM_STATUS(*pFunc_pmPollStaticQuery_)(PM_SESSION_HANDLE, const PM_QUERY_ELEMENT*, uint32_t, uint8_t*) = nullptr;
+PM_STATUS(*pFunc_pmPollStaticQueryBatch_)(PM_SESSION_HANDLE, PM_QUERY_ELEMENT*, uint64_t, uint32_t, uint8_t*, uint32_t*) = nullptr;
 PM_STATUS(*pFunc_pmRegisterFrameQuery_)(PM_SESSION_HANDLE, PM_FRAME_QUERY_HANDLE*, PM_QUERY_ELEMENT*, uint64_t, uint32_t*) = nullptr;
 PM_STATUS(*pFunc_pmConsumeFrames_)(PM_FRAME_QUERY_HANDLE, uint32_t, uint8_t*, uint32_t*) = nullptr;
 PM_STATUS(*pFunc_pmFreeFrameQuery_)(PM_FRAME_QUERY_HANDLE) = nullptr;
@@ -126,6 +127,8 @@ PRESENTMON_API2_EXPORT PM_STATUS LoadLibrary_()
 
 #define RESOLVE(f) pFunc_##f##_ = reinterpret_cast<decltype(pFunc_##f##_)>(GetProcAddress_(hMod, #f))
 #define RESOLVE_CPP(f) pFunc_##f##_ = GetCppProcAddress_<decltype(pFunc_##f##_)>(hMod, #f)
+// endpoints added in a minor version may be missing from an older middleware, they stay null and fail when called
+#define RESOLVE_OPTIONAL(f) pFunc_##f##_ = reinterpret_cast<decltype(pFunc_##f##_)>(GetProcAddress(hMod, #f))
 			// first check version before attempting to resolve all endpoints
 			RESOLVE(pmGetApiVersion);
 			{
@@ -155,6 +158,7 @@ PRESENTMON_API2_EXPORT PM_STATUS LoadLibrary_()
 			RESOLVE(pmFreeDynamicQuery);
 			RESOLVE(pmPollDynamicQuery);
 			RESOLVE(pmPollStaticQuery);
+			RESOLVE_OPTIONAL(pmPollStaticQueryBatch); // 3.1
 			RESOLVE(pmRegisterFrameQuery);
 			RESOLVE(pmConsumeFrames);
 			RESOLVE(pmFreeFrameQuery);
@@ -261,6 +265,14 @@ PRESENTMON_API2_EXPORT PM_STATUS pmPollStaticQuery(PM_SESSION_HANDLE sessionHand
 	LoadEndpointsIfEmpty_();
 	return pFunc_pmPollStaticQuery_(sessionHandle, pElement, processId, pBlob);
 }
+PRESENTMON_API2_EXPORT PM_STATUS pmPollStaticQueryBatch(PM_SESSION_HANDLE sessionHandle, PM_QUERY_ELEMENT* pElements, uint64_t numElements, uint32_t processId, uint8_t* pBlob, uint32_t* pBlobSize)
+{
+	LoadEndpointsIfEmpty_();
+	if (!pFunc_pmPollStaticQueryBatch_) {
+		return PM_STATUS_MIDDLEWARE_MISSING_ENDPOINT;
+	}
+	return pFunc_pmPollStaticQueryBatch_(sessionHandle, pElements, numElements, processId, pBlob, pBlobSize);
+}
 PRESENTMON_API2_EXPORT PM_STATUS pmRegisterFrameQuery(PM_SESSION_HANDLE sessionHandle, PM_FRAME_QUERY_HANDLE* pHandle, PM_QUERY_ELEMENT* pElements, uint64_t numElements, uint32_t* pBlobSize)
 {
 	LoadEndpointsIfEmpty_();
@@ -6,9 +6,11 @@
 #include "../PresentMonAPI2/Internal.h"
 #include "../PresentMonAPIWrapper/PresentMonAPIWrapper.h"
 #include "../CommonUtilities/str/String.h"
+#include "../../Tests/CsvReader.h"
 #include <Windows.h>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <stdexcept>
 #include <map>
 #include <optional>
@@ -166,57 +168,18 @@ std::wstring CreateErrorString(Header columnId, size_t line)
 template <typename T>
 class CharConvert {
 public:
-    void Convert(const std::string data, T& convertedData, Header columnId, size_t line);
+    void Convert(std::string_view data, T& convertedData, Header columnId, size_t line);
 };
 
 template <typename T>
-void CharConvert<T>::Convert(const std::string data, T& convertedData, Header columnId, size_t line) {
-    if constexpr (std::is_same<T, double>::value) {
-        try
-        {
-            convertedData = std::stod(data);
-        }
-        catch (...) {
-            Assert::Fail(CreateErrorString(columnId, line).c_str());
-        }
-    }
-    else if constexpr (std::is_same<T, uint32_t>::value) {
-        try
-        {
-            convertedData = std::stoul(data);
-        }
-        catch (...) {
-            Assert::Fail(CreateErrorString(columnId, line).c_str());
-        }
-    }
-    else if constexpr (std::is_same<T, int32_t>::value) {
-        try
-        {
-            convertedData = std::stoi(data);
-        }
-        catch (...) {
-            Assert::Fail(CreateErrorString(columnId, line).c_str());
-        }
-    }
-    else if constexpr (std::is_same<T, uint64_t>::value) {
-        try
-        {
-            char* endptr;
-            unsigned long long result1;
-
-            if (data.size() > 2 && data[0] == '0' && (data[1] == 'x' || data[1] == 'X')) {
-                // Convert hexadecimal
-                result1 = std::strtoull(data.c_str(), &endptr, 16);
-            }
-            else {
-                // Convert decimal
-                result1 = std::strtoull(data.c_str(), &endptr, 10);
-            }
-            convertedData = static_cast<uint64_t>(result1);
-        }
-        catch (...) {
+void CharConvert<T>::Convert(std::string_view data, T& convertedData, Header columnId, size_t line) {
+    if constexpr (std::is_same<T, double>::value ||
+                  std::is_same<T, uint32_t>::value ||
+                  std::is_same<T, int32_t>::value ||
+                  std::is_same<T, uint64_t>::value) {
+        // uint64_t values (e.g., SwapChainAddress) may be hexadecimal
+        if (!ParseCsvNumber(data, &convertedData)) {
             Assert::Fail(CreateErrorString(columnId, line).c_str());
-
         }
     }
     else if constexpr (std::is_same<T, PM_GRAPHICS_RUNTIME>::value) {
@@ -339,18 +302,17 @@ private:
     bool ReadRow(bool gatherMetrics = false);
     size_t GetColumnIndex(char const* header);
 
-    Header FindHeader(char const* header);
+    Header FindHeader(std::string_view header);
     void CheckAll(size_t const* columnIndex, bool* ok, std::initializer_list<Header> const& headers);
 
-    void ConvertToMetricDataType(const char* data, Header columnId);
+    void ConvertToMetricDataType(std::string_view data, Header columnId);
 
-    FILE* fp_ = nullptr;
+    CsvReader reader_;
 
     size_t headerColumnIndex_[KnownHeaderCount];
 
-    char row_[1024];
     size_t line_ = 0;
-    std::vector<char const*> cols_;
+    std::vector<std::string_view> cols_;
     v2Metrics v2MetricRow_;
     uint32_t processId_ = 0;
     std::map<size_t, Header> activeColHeadersMap_;
@@ -589,11 +551,9 @@ bool CsvParser::FindFirstRowWithPid(const unsigned int& searchProcessId)
         }
         if (headerColumnIndex_[Header_ProcessID] != SIZE_MAX) {
             auto processColIdx = headerColumnIndex_[Header_ProcessID];
-            char const* processIdString = nullptr;
             if (processColIdx < cols_.size()) {
-                processIdString = cols_[Header_ProcessID];
                 unsigned int currentProcessId = 0;
-                int succeededCount = sscanf_s(processIdString, "%ud", &currentProcessId);
+                ParseCsvNumber(cols_[Header_ProcessID], &currentProcessId);
                 if (searchProcessId == currentProcessId) {
                     return true;
                 }
@@ -606,9 +566,9 @@ bool CsvParser::FindFirstRowWithPid(const unsigned int& searchProcessId)
 
 bool CsvParser::ResetCsv()
 {
-    // Rewind the file pointer and then read the header to get
+    // Rewind the reader and then read the header to get
     // to the data
-    rewind(fp_);
+    reader_.Rewind();
     ReadRow();
 
     return true;
@@ -620,18 +580,10 @@ bool CsvParser::Open(std::wstring const& path, uint32_t processId) {
     }
     cols_.clear();
 
-    if (_wfopen_s(&fp_, path.c_str(), L"r")) {
+    if (!reader_.Open(path.c_str())) {
         return false;
     }
 
-    // Remove UTF-8 marker if there is one.
-    if (fread(row_, 3, 1, fp_) != 1 ||
-        row_[0] != -17 || // 0xef
-        row_[1] != -69 || // 0xbb
-        row_[2] != -65) { // 0xbf
-        fseek(fp_, 0, SEEK_SET);
-    }
-
     // Read the header and ensure required columns are present
     ReadRow();
 
@@ -645,7 +597,7 @@ bool CsvParser::Open(std::wstring const& path, uint32_t processId) {
             if ((size_t)h < KnownHeaderCount) {
                 if (headerColumnIndex_[(size_t)h] != SIZE_MAX) {
                     std::wstring errorMessage = L"Duplicate column: ";
-                    errorMessage += pmon::util::str::ToWide(cols_[i]);
+                    errorMessage += pmon::util::str::ToWide(std::string(cols_[i]));
                     Assert::Fail(errorMessage.c_str());
                 }
                 else {
@@ -717,11 +669,11 @@ void CsvParser::CheckAll(size_t const* columnIndex, bool* ok, std::initializer_l
 
 void CsvParser::Close()
 {
-    fclose(fp_);
-    fp_ = nullptr;
+    reader_.Close();
+    cols_.clear();
 }
 
-void CsvParser::ConvertToMetricDataType(const char* data, Header columnId)
+void CsvParser::ConvertToMetricDataType(std::string_view data, Header columnId)
 {
     switch (columnId)
     {
@@ -834,7 +786,7 @@ void CsvParser::ConvertToMetricDataType(const char* data, Header columnId)
     break;
     case Header_DisplayLatency:
     {
-        if (strncmp(data, "NA", 2) != 0) {
+        if (data.compare(0, 2, "NA") != 0) {
             double convertedData = 0.;
             CharConvert<double> converter;
             converter.Convert(data, convertedData, columnId, line_);
@@ -848,7 +800,7 @@ void CsvParser::ConvertToMetricDataType(const char* data, Header columnId)
     break;
     case Header_DisplayedTime:
     {
-        if (strncmp(data, "NA", 2) != 0) {
+        if (data.compare(0, 2, "NA") != 0) {
             double convertedData = 0.;
             CharConvert<double> converter;
             converter.Convert(data, convertedData, columnId, line_);
@@ -861,7 +813,7 @@ void CsvParser::ConvertToMetricDataType(const char* data, Header columnId)
     break;
     case Header_AnimationError:
     {
-        if (strncmp(data, "NA", 2) != 0) {
+        if (data.compare(0, 2, "NA") != 0) {
             double convertedData = 0.;
             CharConvert<double> converter;
             converter.Convert(data, convertedData, columnId, line_);
@@ -874,7 +826,7 @@ void CsvParser::ConvertToMetricDataType(const char* data, Header columnId)
     break;
     case Header_AnimationTime:
     {
-        if (strncmp(data, "NA", 2) != 0) {
+        if (data.compare(0, 2, "NA") != 0) {
             double convertedData = 0.;
             CharConvert<double> converter;
             converter.Convert(data, convertedData, columnId, line_);
@@ -887,7 +839,7 @@ void CsvParser::ConvertToMetricDataType(const char* data, Header columnId)
     break;
     case Header_ClickToPhotonLatency:
     {
-        if (strncmp(data, "NA", 2) != 0) {
+        if (data.compare(0, 2, "NA") != 0) {
             double convertedData = 0.;
             CharConvert<double> converter;
             converter.Convert(data, convertedData, columnId, line_);
@@ -900,7 +852,7 @@ void CsvParser::ConvertToMetricDataType(const char* data, Header columnId)
     break;
     case Header_AllInputToPhotonLatency:
     {
-        if (strncmp(data, "NA", 2) != 0) {
+        if (data.compare(0, 2, "NA") != 0) {
             double convertedData = 0.;
             CharConvert<double> converter;
             converter.Convert(data, convertedData, columnId, line_);
@@ -913,7 +865,7 @@ void CsvParser::ConvertToMetricDataType(const char* data, Header columnId)
     break;
     case Header_InstrumentedLatency:
     {
-        if (strncmp(data, "NA", 2) != 0) {
+        if (data.compare(0, 2, "NA") != 0) {
             double convertedData = 0.;
             CharConvert<double> converter;
             converter.Convert(data, convertedData, columnId, line_);
@@ -935,36 +887,17 @@ void CsvParser::ConvertToMetricDataType(const char* data, Header columnId)
 
 bool CsvParser::ReadRow(bool gatherMetrics)
 {
-    row_[0] = '\0';
-    cols_.clear();
-
-    // Read a line
-    if (fgets(row_, _countof(row_), fp_) == nullptr) {
-        if (ferror(fp_) != 0) {
-            std::wstring errorMessage = L"File read error at line: ";
-            errorMessage += std::to_wstring(line_);
-            Assert::Fail(errorMessage.c_str());
-        }
+    // Read a line, split into columns with leading/trailing whitespace
+    // removed
+    if (!reader_.ReadRow(&cols_)) {
         return false;
     }
 
-    line_ += 1;
+    line_ = reader_.GetLine();
 
-    // Split line into columns, skipping leading/trailing whitespace
-    auto p0 = row_;
-    for (; *p0 == ' ' || *p0 == '\t'; ++p0) *p0 = '\0';
-    uint32_t columnId = 0;
-    for (auto p = p0; ; ++p) {
-        auto ch = *p;
-        if (ch == ',' || ch == '\0') {
-            *p = '\0';
-            cols_.push_back(p0);
-            if (gatherMetrics) {
-                ConvertToMetricDataType(p0, activeColHeadersMap_[columnId++]);
-            }
-            for (p0 = p + 1; *p0 == ' ' || *p0 == '\t'; ++p0) *p0 = '\0';
-            for (auto q = p - 1; *q == ' ' || *q == '\t' || *q == '\n' || *q == '\r'; --q) *q = '\0';
-            if (ch == '\0') break;
+    if (gatherMetrics) {
+        for (uint32_t columnId = 0, n = (uint32_t) cols_.size(); columnId < n; ++columnId) {
+            ConvertToMetricDataType(cols_[columnId], activeColHeadersMap_[columnId]);
         }
     }
 
@@ -977,11 +910,11 @@ size_t CsvParser::GetColumnIndex(char const* header)
     return h < KnownHeaderCount ? headerColumnIndex_[h] : SIZE_MAX;
 }
 
-Header CsvParser::FindHeader(char const* header)
+Header CsvParser::FindHeader(std::string_view header)
 {
     for (uint32_t i = 0; i < KnownHeaderCount; ++i) {
         auto h = (Header)i;
-        if (strcmp(header, GetHeaderString(h)) == 0) {
+        if (header == GetHeaderString(h)) {
             return h;
         }
     }
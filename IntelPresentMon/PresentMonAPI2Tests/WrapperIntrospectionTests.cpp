@@ -221,7 +221,7 @@ namespace EndToEndTests
 			PM_VERSION ver;
 			Assert::AreEqual(PM_STATUS_SUCCESS, pmGetApiVersion(&ver));
 			Assert::AreEqual(3, (int)ver.major);
-			Assert::AreEqual(0, (int)ver.minor);
+			Assert::AreEqual(1, (int)ver.minor);
 			Assert::AreEqual(0, (int)ver.patch);
 			Assert::AreEqual("beta", ver.tag);
 			Assert::AreEqual(pmon::bid::BuildIdShortHash(), ver.hash);
@@ -1,6 +1,7 @@
 #pragma once
 #include "StaticQuery.h"
 #include "../PresentMonAPIWrapperCommon/Exception.h"
+#include <cstring>
 
 namespace pmapi
 {
@@ -23,4 +24,35 @@ namespace pmapi
         }
         return result;
     }
+
+    std::vector<StaticQueryResult> PollStatic(const Session& session, const ProcessTracker& process,
+        std::span<PM_QUERY_ELEMENT> elements)
+    {
+        // no element is larger than a result blob, so this is always enough
+        std::vector<uint8_t> blob(elements.size() * StaticQueryResult::blobSize_);
+        auto blobSize = uint32_t(blob.size());
+        if (const auto err = pmPollStaticQueryBatch(session.GetHandle(), elements.data(), elements.size(),
+            process.GetPid(), blob.data(), &blobSize); err == PM_STATUS_MIDDLEWARE_MISSING_ENDPOINT) {
+            // middleware older than API 3.1 has no batch endpoint, poll the elements one at a time
+            std::vector<StaticQueryResult> results;
+            results.reserve(elements.size());
+            for (auto& e : elements) {
+                results.push_back(PollStatic(session, process, e.metric, e.deviceId, e.arrayIndex));
+            }
+            return results;
+        }
+        else if (err != PM_STATUS_SUCCESS) {
+            throw ApiErrorException{ err, "Error polling static query batch" };
+        }
+
+        const auto pIntro = session.GetIntrospectionRoot();
+        std::vector<StaticQueryResult> results;
+        results.reserve(elements.size());
+        for (auto& e : elements) {
+            const auto dti = pIntro->FindMetric(e.metric).GetDataTypeInfo();
+            auto& result = results.emplace_back(StaticQueryResult{ dti.GetFrameType(), dti.GetEnumId() });
+            std::memcpy(result.blob_.data(), &blob[e.dataOffset], e.dataSize);
+        }
+        return results;
+    }
 }
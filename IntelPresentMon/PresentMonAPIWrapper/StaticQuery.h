@@ -11,6 +11,8 @@
 #include <memory>
 #include <cassert>
 #include <array>
+#include <span>
+#include <vector>
 
 namespace pmapi
 {
@@ -98,7 +100,11 @@ namespace pmapi
     {
         friend StaticQueryResult PollStatic(const Session& session, const ProcessTracker& process,
             PM_METRIC metric, uint32_t deviceId, uint32_t arrayIndex);
+        friend std::vector<StaticQueryResult> PollStatic(const Session& session, const ProcessTracker& process,
+            std::span<PM_QUERY_ELEMENT> elements);
     public:
+        // copyable so that results of a batch poll can be returned in a vector
+        StaticQueryResult(const StaticQueryResult&) = default;
         // access this result as a specific static data type
         // this will perform the conversion based on the runtime information about the metric's type
         // enum types will use the introspection system to generate human-readable strings
@@ -124,9 +130,6 @@ namespace pmapi
     private:
         // functions
         StaticQueryResult(PM_DATA_TYPE dataType, PM_ENUM enumId) : dataType_{ dataType }, enumId_{ enumId } {}
-        // although NRVO should prevent this from being called, it's not standard guarantee
-        // so we still need the copy ctor
-        StaticQueryResult(const StaticQueryResult&) = default;
         // data
         // 260 bytes is the maximum possible size for query element data
         static constexpr size_t blobSize_ = 260;
@@ -141,4 +144,12 @@ namespace pmapi
     // query result data blobs and convert to the desired type when conversion is possible
     StaticQueryResult PollStatic(const Session& session, const ProcessTracker& process,
         PM_METRIC metric, uint32_t deviceId = 0, uint32_t arrayIndex = 0);
+
+    // poll several static metrics with a single call, which fetches any data they need from the
+    // service in at most one round trip
+    // metric, deviceId and arrayIndex of each element are used; dataOffset and dataSize are written
+    // (a middleware older than API 3.1 is polled one element at a time and leaves them untouched)
+    // function returns one StaticQueryResult per element, in the same order
+    std::vector<StaticQueryResult> PollStatic(const Session& session, const ProcessTracker& process,
+        std::span<PM_QUERY_ELEMENT> elements);
 }
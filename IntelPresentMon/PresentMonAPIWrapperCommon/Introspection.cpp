@@ -1,12 +1,33 @@
 #include "Introspection.h"
+#include "IntrospectionIndex.h"
+#include "../Interprocess/source/IntrospectionImage.h"
 #include <format>
 #include <cassert>
+#include <cmath>
+#include <limits>
 #include "Exception.h"
 #include "../CommonUtilities/log/Log.h"
 
 
 namespace pmapi::intro
 {
+    namespace
+    {
+        std::string ResolveString_(const Root* pRoot, const PM_INTROSPECTION_STRING* pString)
+        {
+            return detail::Resolve(pRoot, detail::Resolve(pRoot, pString)->pData);
+        }
+    }
+
+    const void* detail::ResolveField(const Root* pRoot, const void* pField) noexcept
+    {
+        // offset 0 is the root itself, which no field points to, so null fields stay null in the image
+        if (pRoot->pImage && pField) {
+            return pRoot->pImage->Resolve(pField);
+        }
+        return pField;
+    }
+
     bool MetricTypeIsDynamic(PM_METRIC_TYPE type)
     {
         return type == PM_METRIC_TYPE_DYNAMIC || type == PM_METRIC_TYPE_DYNAMIC_FRAME;
@@ -26,22 +47,22 @@ namespace pmapi::intro
 
     std::string EnumKeyView::GetSymbol() const
     {
-        return pBase->pSymbol->pData;
+        return ResolveString_(pRoot, pBase->pSymbol);
     }
 
     std::string EnumKeyView::GetName() const
     {
-        return pBase->pName->pData;
+        return ResolveString_(pRoot, pBase->pName);
     }
 
     std::string EnumKeyView::GetShortName() const
     {
-        return pBase->pShortName->pData;
+        return ResolveString_(pRoot, pBase->pShortName);
     }
 
     std::string EnumKeyView::GetDescription() const
     {
-        return pBase->pDescription->pData;
+        return ResolveString_(pRoot, pBase->pDescription);
     }
 
     const EnumKeyView::SelfType* EnumKeyView::operator->() const
@@ -69,12 +90,12 @@ namespace pmapi::intro
 
     std::string EnumView::GetSymbol() const
     {
-        return pBase->pSymbol->pData;
+        return ResolveString_(pRoot, pBase->pSymbol);
     }
 
     std::string EnumView::GetDescription() const
     {
-        return pBase->pDescription->pData;
+        return ResolveString_(pRoot, pBase->pDescription);
     }
 
     ViewRange<EnumKeyView> EnumView::GetKeys() const
@@ -107,7 +128,7 @@ namespace pmapi::intro
 
     ViewIterator<EnumKeyView> EnumView::GetKeysEnd_() const
     {
-        return { pRoot, pBase->pKeys, (int64_t)pBase->pKeys->size };
+        return { pRoot, pBase->pKeys, (int64_t)detail::Resolve(pRoot, pBase->pKeys)->size };
     }
 
 
@@ -139,7 +160,7 @@ namespace pmapi::intro
 
     std::string DeviceView::GetName() const
     {
-        return pBase->pName->pData;
+        return ResolveString_(pRoot, pBase->pName);
     }
 
     const DeviceView::SelfType* DeviceView::operator->() const
@@ -308,6 +329,12 @@ namespace pmapi::intro
 
     double UnitView::MakeConversionFactor(PM_UNIT destinationUnitId) const
     {
+        if (const auto factor = pRoot->FindConversionFactor_(GetId(), destinationUnitId)) {
+            if (std::isnan(*factor)) {
+                throw std::runtime_error{ "cannot convert incompatible units" };
+            }
+            return *factor;
+        }
         auto destUnit = pRoot->FindUnit(destinationUnitId);
         if (destUnit.GetBaseUnit() != GetBaseUnit()) {
             throw std::runtime_error{ "cannot convert incompatible units" };
@@ -375,7 +402,7 @@ namespace pmapi::intro
 
     DataTypeInfoView MetricView::GetDataTypeInfo() const
     {
-        return { pRoot, pBase->pTypeInfo };
+        return { pRoot, detail::Resolve(pRoot, pBase->pTypeInfo) };
     }
 
     ViewRange<StatInfoView> MetricView::GetStatInfo() const
@@ -407,7 +434,7 @@ namespace pmapi::intro
 
     ViewIterator<StatInfoView> MetricView::GetStatInfoEnd_() const
     {
-        return { pRoot, pBase->pStatInfo, (int64_t)pBase->pStatInfo->size };
+        return { pRoot, pBase->pStatInfo, (int64_t)detail::Resolve(pRoot, pBase->pStatInfo)->size };
     }
 
     ViewIterator<DeviceMetricInfoView> MetricView::GetDeviceMetricInfoBegin_() const
@@ -417,7 +444,7 @@ namespace pmapi::intro
 
     ViewIterator<DeviceMetricInfoView> MetricView::GetDeviceMetricInfoEnd_() const
     {
-        return { pRoot, pBase->pDeviceMetricInfo, (int64_t)pBase->pDeviceMetricInfo->size };
+        return { pRoot, pBase->pDeviceMetricInfo, (int64_t)detail::Resolve(pRoot, pBase->pDeviceMetricInfo)->size };
     }
 
     MetricView::MetricView(const class Root* pRoot_, const BaseType* pBase_)
@@ -435,12 +462,26 @@ namespace pmapi::intro
     {
         assert(pRoot);
         assert(deleter);
+        enumKeyTable.resize(index::enumKeySlotCount);
+        enumTable.resize(index::enumCount);
+        metricTable.resize(index::metricCount);
+        unitTable.resize(index::unitCount);
         // building lookup tables for enum/key
         for (auto e : GetEnums()) {
             for (auto k : e.GetKeys()) {
-                enumKeyMap[MakeEnumKeyMapKey_(e.GetId(), k.GetId())] = k.GetBasePtr();
+                if (const auto slot = index::FindEnumKeySlot(e.GetId(), k.GetId()); slot >= 0) {
+                    enumKeyTable[slot] = k.GetBasePtr();
+                }
+                else {
+                    enumKeyMap[MakeEnumKeyMapKey_(e.GetId(), k.GetId())] = k.GetBasePtr();
+                }
+            }
+            if (const auto slot = index::enumSlots.Find(e.GetId()); slot >= 0) {
+                enumTable[slot] = e.GetBasePtr();
+            }
+            else {
+                enumMap[e.GetId()] = e.GetBasePtr();
             }
-            enumMap[e.GetId()] = e.GetBasePtr();
         }
         // building lookup table for devices
         for (auto d : GetDevices()) {
@@ -448,17 +489,45 @@ namespace pmapi::intro
         }
         // building lookup table for metrics
         for (auto m : GetMetrics()) {
-            metricMap[m.GetId()] = m.GetBasePtr();
+            if (const auto slot = index::metricSlots.Find(m.GetId()); slot >= 0) {
+                metricTable[slot] = m.GetBasePtr();
+            }
+            else {
+                metricMap[m.GetId()] = m.GetBasePtr();
+            }
         }
         // building lookup table for units
         for (auto u : GetUnits()) {
-            unitMap[u.GetId()] = u.GetBasePtr();
+            if (const auto slot = index::unitSlots.Find(u.GetId()); slot >= 0) {
+                unitTable[slot] = u.GetBasePtr();
+            }
+            else {
+                unitMap[u.GetId()] = u.GetBasePtr();
+            }
+        }
+        // precompute conversion factors between every pair of units, scales come from the introspected
+        // units so the service stays authoritative even if its unit list differs from this build
+        unitConversionMatrix.resize(index::unitCount * index::unitCount, std::numeric_limits<double>::quiet_NaN());
+        for (size_t src = 0; src < index::unitCount; src++) {
+            for (size_t dst = 0; dst < index::unitCount; dst++) {
+                const auto pSrc = unitTable[src];
+                const auto pDst = unitTable[dst];
+                if (pSrc && pDst && pSrc->baseUnitId == pDst->baseUnitId) {
+                    unitConversionMatrix[src * index::unitCount + dst] = pSrc->scale / pDst->scale;
+                }
+            }
         }
     }
 
+    Root::Root(const pmon::ipc::intro::IntrospectionImageView& image)
+        :
+        pRoot{ image.GetRoot() },
+        pImage{ &image }
+    {}
+
     Root::~Root()
     {
-        if (pRoot) {
+        if (pRoot && deleter) {
             deleter(pRoot);
         }
     }
@@ -493,6 +562,14 @@ namespace pmapi::intro
 
     EnumKeyView Root::FindEnumKey(PM_ENUM enumId, int keyValue) const
     {
+        if (pImage) {
+            if (const auto pKey = pImage->FindEnumKey(enumId, keyValue)) {
+                return { this, pKey };
+            }
+        }
+        else if (const auto slot = index::FindEnumKeySlot(enumId, keyValue); slot >= 0 && enumKeyTable[slot]) {
+            return { this, enumKeyTable[slot] };
+        }
         if (auto i = enumKeyMap.find(MakeEnumKeyMapKey_(enumId, keyValue)); i == enumKeyMap.end()) {
             throw LookupException{ std::format("unable to find key value={} for enum ID={}", keyValue, (int)enumId) };
         }
@@ -503,6 +580,14 @@ namespace pmapi::intro
 
     EnumView Root::FindEnum(PM_ENUM enumId) const
     {
+        if (pImage) {
+            if (const auto pEnum = pImage->FindEnum(enumId)) {
+                return { this, pEnum };
+            }
+        }
+        else if (const auto slot = index::enumSlots.Find(enumId); slot >= 0 && enumTable[slot]) {
+            return { this, enumTable[slot] };
+        }
         if (auto i = enumMap.find(enumId); i == enumMap.end()) {
             throw LookupException{ std::format("unable to find enum ID={}", (int)enumId) };
         }
@@ -513,6 +598,11 @@ namespace pmapi::intro
 
     DeviceView Root::FindDevice(uint32_t deviceId) const
     {
+        if (pImage) {
+            if (const auto pDevice = pImage->FindDevice(deviceId)) {
+                return { this, pDevice };
+            }
+        }
         if (auto i = deviceMap.find(deviceId); i == deviceMap.end()) {
             throw LookupException{ std::format("unable to find device ID={}", deviceId) };
         }
@@ -523,6 +613,14 @@ namespace pmapi::intro
 
     MetricView Root::FindMetric(PM_METRIC metricId) const
     {
+        if (pImage) {
+            if (const auto pMetric = pImage->FindMetric(metricId)) {
+                return { this, pMetric };
+            }
+        }
+        else if (const auto slot = index::metricSlots.Find(metricId); slot >= 0 && metricTable[slot]) {
+            return { this, metricTable[slot] };
+        }
         if (auto i = metricMap.find(metricId); i == metricMap.end()) {
             pmlog_error(std::format("Cannot find metric id={} in introspection database", (int)metricId)).diag();
             throw LookupException{ std::format("unable to find metric ID={}", (int)metricId) };
@@ -534,6 +632,14 @@ namespace pmapi::intro
 
     UnitView Root::FindUnit(PM_UNIT unitId) const
     {
+        if (pImage) {
+            if (const auto pUnit = pImage->FindUnit(unitId)) {
+                return { this, pUnit };
+            }
+        }
+        else if (const auto slot = index::unitSlots.Find(unitId); slot >= 0 && unitTable[slot]) {
+            return { this, unitTable[slot] };
+        }
         if (auto i = unitMap.find(unitId); i == unitMap.end()) {
             throw LookupException{ std::format("unable to find unit ID={}", (int)unitId) };
         }
@@ -548,6 +654,20 @@ namespace pmapi::intro
         return (uint64_t(enumId) << 32) | uint64_t(keyValue);
     }
 
+    std::optional<double> Root::FindConversionFactor_(PM_UNIT sourceUnitId, PM_UNIT destinationUnitId) const
+    {
+        // no precomputed matrix when reading an image in place, units are converted through their scales
+        if (unitConversionMatrix.empty()) {
+            return {};
+        }
+        const auto src = index::unitSlots.Find(sourceUnitId);
+        const auto dst = index::unitSlots.Find(destinationUnitId);
+        if (src < 0 || dst < 0 || !unitTable[src] || !unitTable[dst]) {
+            return {};
+        }
+        return unitConversionMatrix[src * index::unitCount + dst];
+    }
+
     ViewIterator<EnumView> Root::GetEnumsBegin_() const
     {
         return ViewIterator<EnumView>{ this, pRoot->pEnums };
@@ -555,7 +675,7 @@ namespace pmapi::intro
 
     ViewIterator<EnumView> Root::GetEnumsEnd_() const
     {
-        return ViewIterator<EnumView>{ this, pRoot->pEnums, (int64_t)pRoot->pEnums->size };
+        return ViewIterator<EnumView>{ this, pRoot->pEnums, (int64_t)detail::Resolve(this, pRoot->pEnums)->size };
     }
 
     ViewIterator<MetricView> Root::GetMetricsBegin_() const
@@ -565,7 +685,7 @@ namespace pmapi::intro
 
     ViewIterator<MetricView> Root::GetMetricsEnd_() const
     {
-        return ViewIterator<MetricView>{ this, pRoot->pMetrics, (int64_t)pRoot->pMetrics->size };
+        return ViewIterator<MetricView>{ this, pRoot->pMetrics, (int64_t)detail::Resolve(this, pRoot->pMetrics)->size };
     }
 
     ViewIterator<DeviceView> Root::GetDevicesBegin_() const
@@ -575,7 +695,7 @@ namespace pmapi::intro
 
     ViewIterator<DeviceView> Root::GetDevicesEnd_() const
     {
-        return ViewIterator<DeviceView>{ this, pRoot->pDevices, (int64_t)pRoot->pDevices->size };
+        return ViewIterator<DeviceView>{ this, pRoot->pDevices, (int64_t)detail::Resolve(this, pRoot->pDevices)->size };
     }
 
     ViewIterator<UnitView> Root::GetUnitsBegin_() const
@@ -585,6 +705,6 @@ namespace pmapi::intro
 
     ViewIterator<UnitView> Root::GetUnitsEnd_() const
     {
-        return ViewIterator<UnitView>{ this, pRoot->pUnits, (int64_t)pRoot->pUnits->size };
+        return ViewIterator<UnitView>{ this, pRoot->pUnits, (int64_t)detail::Resolve(this, pRoot->pUnits)->size };
     }
 }
\ No newline at end of file
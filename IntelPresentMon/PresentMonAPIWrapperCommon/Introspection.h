@@ -6,16 +6,37 @@
 #include <memory>
 #include <functional>
 #include <unordered_map>
+#include <vector>
+#include <optional>
+
+namespace pmon::ipc::intro
+{
+    class IntrospectionImageView;
+}
 
 namespace pmapi
 {
     namespace intro
     {
+        class Root;
+
         // check if a metric type can be used with dynamic queries
         bool MetricTypeIsDynamic(PM_METRIC_TYPE type);
         // check if a metric type can be used with frame queries
         bool MetricTypeIsFrameEvent(PM_METRIC_TYPE type);
 
+        namespace detail
+        {
+            // pointer fields of introspection structures are offsets from the image body when the root reads
+            // a mapped introspection image in place, and plain pointers otherwise
+            const void* ResolveField(const Root* pRoot, const void* pField) noexcept;
+            template<typename T>
+            const T* Resolve(const Root* pRoot, const T* pField) noexcept
+            {
+                return static_cast<const T*>(ResolveField(pRoot, pField));
+            }
+        }
+
         template<class T>
         class ViewIterator
         {
@@ -31,7 +52,7 @@ namespace pmapi
             ViewIterator(const class Root* pRoot_, const PM_INTROSPECTION_OBJARRAY* pObjArray, difference_type offset = 0u) noexcept
                 :
                 pRoot{ pRoot_ },
-                pArray{ (const base_type* const*)pObjArray->pData + offset }
+                pArray{ (const base_type* const*)detail::Resolve(pRoot_, detail::Resolve(pRoot_, pObjArray)->pData) + offset }
             {}
             ViewIterator(const ViewIterator& rhs) noexcept : pRoot{ rhs.pRoot }, pArray{ rhs.pArray } {}
             ViewIterator& operator=(const ViewIterator& rhs) noexcept
@@ -55,7 +76,7 @@ namespace pmapi
             }
             value_type operator*() const noexcept
             {
-                return value_type{ pRoot, *pArray };
+                return value_type{ pRoot, detail::Resolve(pRoot, *pArray) };
             }
             value_type operator->() const noexcept
             {
@@ -63,7 +84,7 @@ namespace pmapi
             }
             value_type operator[](size_t idx) const noexcept
             {
-                return value_type{ pRoot, pArray[idx] };
+                return value_type{ pRoot, detail::Resolve(pRoot, pArray[idx]) };
             }
 
             ViewIterator& operator++() noexcept
@@ -317,8 +338,14 @@ namespace pmapi
         // can iterate or perform lookup via id
         class Root
         {
+            friend class UnitView;
+            friend const void* detail::ResolveField(const Root* pRoot, const void* pField) noexcept;
         public:
             Root(const PM_INTROSPECTION_ROOT* pRoot_, std::function<void(const PM_INTROSPECTION_ROOT*)> deleter_);
+            // read a mapped introspection image in place, looking up ids through the hash indices stored in the
+            // image instead of building tables; pointer fields of the structures returned by GetBasePtr() hold
+            // offsets into the image, and the image must outlive the root
+            Root(const pmon::ipc::intro::IntrospectionImageView& image);
             ~Root();
             Root(Root&& rhs) = delete;
             Root& operator=(Root&& rhs) = delete;
@@ -334,6 +361,8 @@ namespace pmapi
         private:
             // functions
             static uint64_t MakeEnumKeyMapKey_(PM_ENUM enumId, int keyValue);
+            // empty when either unit is outside of the precomputed conversion matrix
+            std::optional<double> FindConversionFactor_(PM_UNIT sourceUnitId, PM_UNIT destinationUnitId) const;
             ViewIterator<EnumView> GetEnumsBegin_() const;
             ViewIterator<EnumView> GetEnumsEnd_() const;
             ViewIterator<MetricView> GetMetricsBegin_() const;
@@ -345,11 +374,22 @@ namespace pmapi
             // data
             const PM_INTROSPECTION_ROOT* pRoot = nullptr;
             std::function<void(const PM_INTROSPECTION_ROOT*)> deleter;
+            // set when reading an image in place, lookups then go through its indices and the tables stay empty
+            const pmon::ipc::intro::IntrospectionImageView* pImage = nullptr;
+            // lookup tables indexed by the compile-time slots in IntrospectionIndex.h
+            std::vector<const PM_INTROSPECTION_ENUM_KEY*> enumKeyTable;
+            std::vector<const PM_INTROSPECTION_ENUM*> enumTable;
+            std::vector<const PM_INTROSPECTION_METRIC*> metricTable;
+            std::vector<const PM_INTROSPECTION_UNIT*> unitTable;
+            // unit slot x unit slot conversion factors, NaN where units are incompatible
+            std::vector<double> unitConversionMatrix;
+            // ids not covered by the static index (service newer than this client) fall back to hashing
             std::unordered_map<uint64_t, const PM_INTROSPECTION_ENUM_KEY*> enumKeyMap;
             std::unordered_map<PM_ENUM, const PM_INTROSPECTION_ENUM*> enumMap;
-            std::unordered_map<uint32_t, const PM_INTROSPECTION_DEVICE*> deviceMap;
             std::unordered_map<PM_METRIC, const PM_INTROSPECTION_METRIC*> metricMap;
             std::unordered_map<PM_UNIT, const PM_INTROSPECTION_UNIT*> unitMap;
+            // device ids are assigned by the service at runtime
+            std::unordered_map<uint32_t, const PM_INTROSPECTION_DEVICE*> deviceMap;
         };
     }
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+#include "../PresentMonAPI2/PresentMonAPI.h"
+#include "../Interprocess/source/metadata/MasterEnumList.h"
+#include "../Interprocess/source/metadata/EnumDataType.h"
+#include "../Interprocess/source/metadata/EnumDeviceType.h"
+#include "../Interprocess/source/metadata/EnumDeviceVendor.h"
+#include "../Interprocess/source/metadata/EnumFrameType.h"
+#include "../Interprocess/source/metadata/EnumGraphicsRuntime.h"
+#include "../Interprocess/source/metadata/EnumMetricAvailability.h"
+#include "../Interprocess/source/metadata/EnumMetricType.h"
+#include "../Interprocess/source/metadata/EnumNullEnum.h"
+#include "../Interprocess/source/metadata/EnumPresentMode.h"
+#include "../Interprocess/source/metadata/EnumStat.h"
+#include "../Interprocess/source/metadata/EnumStatus.h"
+#include "../Interprocess/source/metadata/EnumUnit.h"
+#include "../Interprocess/source/metadata/MetricList.h"
+#include "../Interprocess/source/metadata/UnitList.h"
+#include <array>
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <stdexcept>
+#include <cstdint>
+
+// the metric enum key list is generated at build time and is not visible to this project
+// its keys are exactly the ids in METRIC_LIST, so the metric enum extent is patched in from there
+#ifndef ENUM_KEY_LIST_METRIC
+#define ENUM_KEY_LIST_METRIC(X_)
+#define PM_INTRO_INDEX_METRIC_KEY_SHIM_
+#endif
+
+// compile-time lookup indices for introspection ids, generated from the same metadata lists the service
+// uses to populate introspection; Root fills flat tables indexed by these slots so that lookup is a couple
+// of array reads instead of a hash probe
+namespace pmapi::intro::index
+{
+    // maps an id to its slot (-1 => not present)
+    // ids are small dense enum values, so indexing directly by id is a collision-free (perfect) hash
+    template<size_t N>
+    struct SlotTable
+    {
+        std::array<int16_t, N> slots;
+        constexpr int Find(int64_t id) const noexcept
+        {
+            return (id >= 0 && id < (int64_t)N) ? slots[(size_t)id] : -1;
+        }
+    };
+
+    template<size_t N>
+    constexpr int MaxId_(const std::array<int, N>& ids)
+    {
+        int maxId = -1;
+        for (auto id : ids) {
+            maxId = std::max(maxId, id);
+        }
+        return maxId;
+    }
+
+    template<size_t Span, size_t N>
+    constexpr SlotTable<Span> MakeSlotTable_(const std::array<int, N>& ids)
+    {
+        SlotTable<Span> table{};
+        table.slots.fill(-1);
+        for (size_t i = 0; i < N; i++) {
+            // reaching the throw during constant evaluation fails the build
+            if (ids[i] < 0 || table.slots[ids[i]] != -1) {
+                throw std::logic_error{ "negative or duplicate id in introspection metadata list" };
+            }
+            table.slots[ids[i]] = int16_t(i);
+        }
+        return table;
+    }
+
+    // range of key values of one enum, mapped to [offset, offset + span) in the flat key table
+    struct KeyExtent
+    {
+        int minKey = 0;
+        int span = 0;
+        int offset = 0;
+    };
+
+    template<class R>
+    constexpr KeyExtent MakeKeyExtent_(const R& keys)
+    {
+        if (std::empty(keys)) {
+            return {};
+        }
+        const auto [minKey, maxKey] = std::minmax_element(std::begin(keys), std::end(keys));
+        return { *minKey, *maxKey - *minKey + 1 };
+    }
+
+#define X_ID_(id, ...) (int)id,
+#define X_ENUM_ID_(master_frag, enum_frag, ...) (int)PM_##master_frag##_##enum_frag,
+#define X_KEY_ID_(enum_frag, key_frag, ...) (int)PM_##enum_frag##_##key_frag,
+#define X_KEY_EXTENT_(master_frag, enum_frag, ...) MakeKeyExtent_(std::initializer_list<int>{ ENUM_KEY_LIST_##enum_frag(X_KEY_ID_) }),
+
+    inline constexpr auto metricIds_ = std::to_array<int>({ METRIC_LIST(X_ID_) });
+    inline constexpr size_t metricCount = metricIds_.size();
+    inline constexpr auto metricSlots = MakeSlotTable_<MaxId_(metricIds_) + 1>(metricIds_);
+
+    inline constexpr auto unitIds_ = std::to_array<int>({ UNIT_LIST(X_ID_) });
+    inline constexpr size_t unitCount = unitIds_.size();
+    inline constexpr auto unitSlots = MakeSlotTable_<MaxId_(unitIds_) + 1>(unitIds_);
+
+    inline constexpr auto enumIds_ = std::to_array<int>({ ENUM_KEY_LIST_ENUM(X_ENUM_ID_) });
+    inline constexpr size_t enumCount = enumIds_.size();
+    inline constexpr auto enumSlots = MakeSlotTable_<MaxId_(enumIds_) + 1>(enumIds_);
+
+    // indexed by enum slot
+    inline constexpr auto enumKeyExtents = [] {
+        std::array<KeyExtent, enumCount> extents{ ENUM_KEY_LIST_ENUM(X_KEY_EXTENT_) };
+        extents[enumSlots.Find(PM_ENUM_METRIC)] = MakeKeyExtent_(metricIds_);
+        int offset = 0;
+        for (auto& e : extents) {
+            e.offset = offset;
+            offset += e.span;
+        }
+        return extents;
+    }();
+    inline constexpr size_t enumKeySlotCount = enumKeyExtents.back().offset + enumKeyExtents.back().span;
+
+#undef X_ID_
+#undef X_ENUM_ID_
+#undef X_KEY_ID_
+#undef X_KEY_EXTENT_
+
+    // slot of an enum key in the flat key table (-1 => enum or key value outside of the static index)
+    // slots inside an extent that fall in gaps between key values are valid but will never be populated
+    constexpr int FindEnumKeySlot(PM_ENUM enumId, int keyValue) noexcept
+    {
+        const auto enumSlot = enumSlots.Find(enumId);
+        if (enumSlot < 0) {
+            return -1;
+        }
+        const auto& extent = enumKeyExtents[enumSlot];
+        const auto rel = int64_t(keyValue) - extent.minKey;
+        if (rel < 0 || rel >= extent.span) {
+            return -1;
+        }
+        return extent.offset + int(rel);
+    }
+
+    static_assert(metricSlots.Find(metricIds_.back()) == int(metricCount - 1));
+    static_assert(unitSlots.Find(PM_UNIT_QPC) >= 0);
+    static_assert(FindEnumKeySlot(PM_ENUM_STATUS, PM_STATUS_SUCCESS) >= 0);
+    static_assert(FindEnumKeySlot(PM_ENUM_METRIC, metricIds_.front()) >= 0);
+    static_assert(FindEnumKeySlot(PM_ENUM_NULL_ENUM, 0) == -1);
+}
+
+#ifdef PM_INTRO_INDEX_METRIC_KEY_SHIM_
+#undef ENUM_KEY_LIST_METRIC
+#undef PM_INTRO_INDEX_METRIC_KEY_SHIM_
+#endif
@@ -19,6 +19,7 @@
 #include "../Interprocess/source/IntrospectionHelpers.h"
 #include "../Interprocess/source/IntrospectionCloneAllocators.h"
 #include "../Interprocess/source/PmStatusError.h"
+#include "../Interprocess/source/IntrospectionImage.h"
 //#include "MockCommon.h"
 #include "DynamicQuery.h"
 #include "../ControlLib/PresentMonPowerTelemetry.h"
@@ -86,9 +87,11 @@ namespace pmon::mid
             throw;
         }
 
-        // Update the static GPU metric data from the service
-        GetStaticGpuMetrics();
-        GetStaticCpuMetrics();
+        // Update the static GPU and CPU metric data from the service
+        StaticMetricSourceSet allSources;
+        allSources.fill(true);
+        staticMetricCache.SyncAdapterGeneration(pComms->GetAdapterGeneration());
+        FetchStaticMetricSources(allSources);
 	}
     
     ConcreteMiddleware::~ConcreteMiddleware() = default;
@@ -133,6 +136,7 @@ namespace pmon::mid
             if (iter != presentMonStreamClients.end()) {
                 presentMonStreamClients.erase(std::move(iter));
             }
+            frameDecodeStates.erase(targetPid);
         }
         catch (...) {
             const auto code = util::GeneratePmStatus();
@@ -144,33 +148,51 @@ namespace pmon::mid
         return PM_STATUS_SUCCESS;
     }
 
-    void ConcreteMiddleware::GetStaticCpuMetrics()
+    // set the static metrics of each cached gpu from the matching enumerated adapter
+    // returns false if any cached gpu had no match
+    static bool StoreAdapterMetrics(std::vector<DeviceInfo>& gpuInfos, const EnumerateAdapters::Response& res)
     {
-        try {
-            auto metrics = pActionClient->DispatchSync(GetStaticCpuMetrics::Params{});
+        // check that adapter count matches introspection
+        if (res.adapters.size() != gpuInfos.size()) {
+            pmlog_warn(std::format("Queried adapter count {} did not match count from introspection {}",
+                res.adapters.size(), gpuInfos.size())).diag();
+        }
 
-            const auto cpuNameLower = str::ToLower(metrics.cpuName);
-            PM_DEVICE_VENDOR deviceVendor;
-            if (cpuNameLower.contains("intel")) {
-                deviceVendor = PM_DEVICE_VENDOR_INTEL;
-            }
-            else if (cpuNameLower.contains("amd")) {
-                deviceVendor = PM_DEVICE_VENDOR_AMD;
-            }
-            else {
-                deviceVendor = PM_DEVICE_VENDOR_UNKNOWN;
+        bool allFound = true;
+        for (auto& gpuInfo : gpuInfos) {
+            auto i = rn::find_if(res.adapters, [&](const auto& adapter) { return gpuInfo.adapterId == adapter.id; });
+            if (i == res.adapters.end()) {
+                allFound = false;
+                continue;
             }
+            gpuInfo.gpuSustainedPowerLimit = i->gpuSustainedPowerLimit;
+            gpuInfo.gpuMemorySize = i->gpuMemorySize;
+            gpuInfo.gpuMemoryMaxBandwidth = i->gpuMemoryMaxBandwidth;
+        }
+        return allFound;
+    }
 
-            cachedCpuInfo.push_back({
-                .deviceVendor = deviceVendor,
-                .deviceName = std::move(metrics.cpuName),
-                .cpuPowerLimit = metrics.cpuPowerLimit
-            });
+    void ConcreteMiddleware::StoreStaticCpuMetrics(std::string cpuName, double cpuPowerLimit)
+    {
+        const auto cpuNameLower = str::ToLower(cpuName);
+        PM_DEVICE_VENDOR deviceVendor;
+        if (cpuNameLower.contains("intel")) {
+            deviceVendor = PM_DEVICE_VENDOR_INTEL;
         }
-        catch (...) {
-            const auto code = util::GeneratePmStatus();
-            pmlog_error(util::ReportException()).code(code).diag();
+        else if (cpuNameLower.contains("amd")) {
+            deviceVendor = PM_DEVICE_VENDOR_AMD;
         }
+        else {
+            deviceVendor = PM_DEVICE_VENDOR_UNKNOWN;
+        }
+
+        cachedCpuInfo.clear();
+        cachedCpuInfo.push_back({
+            .deviceVendor = deviceVendor,
+            .deviceName = std::move(cpuName),
+            .cpuPowerLimit = cpuPowerLimit
+        });
+        staticMetricCache.MarkLoaded(StaticMetricSource::Cpu);
     }
 
     std::string ConcreteMiddleware::GetProcessName(uint32_t processId)
@@ -193,7 +215,8 @@ namespace pmon::mid
     {
         if (!pIntroRoot) {
             pmlog_info("Creating and cacheing introspection root object").diag();
-            pIntroRoot = std::make_unique<pmapi::intro::Root>(GetIntrospectionData(), [this](auto p){FreeIntrospectionData(p);});
+            // read the image mapped by the comms in place, the comms outlive the root
+            pIntroRoot = std::make_unique<pmapi::intro::Root>(pComms->GetIntrospectionImage());
         }
         return *pIntroRoot;
     }
@@ -940,23 +963,26 @@ static void ReportMetrics(
 
     void ConcreteMiddleware::CopyStaticMetricData(PM_METRIC metric, uint32_t deviceId, uint8_t* pBlob, uint64_t blobOffset, size_t sizeInBytes)
     {
+        // cpu info is missing if the service request for it failed
+        static const DeviceInfo unknownCpuInfo{ .deviceVendor = PM_DEVICE_VENDOR_UNKNOWN };
+        const auto& cpuInfo = cachedCpuInfo.empty() ? unknownCpuInfo : cachedCpuInfo[0];
         switch (metric)
         {
         case PM_METRIC_CPU_NAME:
         {
-            strncpy_s(reinterpret_cast<char*>(&pBlob[blobOffset]), sizeInBytes, cachedCpuInfo[0].deviceName.c_str(), _TRUNCATE);
+            strncpy_s(reinterpret_cast<char*>(&pBlob[blobOffset]), sizeInBytes, cpuInfo.deviceName.c_str(), _TRUNCATE);
         }
             break;
         case PM_METRIC_CPU_VENDOR:
         {
             auto& output = reinterpret_cast<PM_DEVICE_VENDOR&>(pBlob[blobOffset]);
-            output = cachedCpuInfo[0].deviceVendor;
+            output = cpuInfo.deviceVendor;
         }
             break;
         case PM_METRIC_CPU_POWER_LIMIT:
         {
             auto& output = reinterpret_cast<double&>(pBlob[blobOffset]);
-            output = cachedCpuInfo[0].cpuPowerLimit.has_value() ? cachedCpuInfo[0].cpuPowerLimit.value() : 0.;
+            output = cpuInfo.cpuPowerLimit.has_value() ? cpuInfo.cpuPowerLimit.value() : 0.;
         }
             break;
         case PM_METRIC_GPU_NAME:
@@ -1026,31 +1052,75 @@ static void ReportMetrics(
         return;
     }
 
-    void ConcreteMiddleware::PollStaticQuery(const PM_QUERY_ELEMENT& element, uint32_t processId, uint8_t* pBlob)
+    uint64_t ConcreteMiddleware::GetStaticMetricSize(PM_METRIC metric)
     {
+        if (auto i = staticMetricSizes.find(metric); i != staticMetricSizes.end()) {
+            return i->second;
+        }
+
         auto& ispec = GetIntrospectionRoot();
-        auto metricView = ispec.FindMetric(element.metric);
+        auto metricView = ispec.FindMetric(metric);
         if (metricView.GetType() != int(PM_METRIC_TYPE_STATIC)) {
             pmlog_error(std::format("dynamic metric [{}] in static query poll", metricView.Introspect().GetSymbol())).diag();
             throw Except<util::Exception>("dynamic metric in static query poll");
         }
 
-        auto elementSize = GetDataTypeSize(metricView.GetDataTypeInfo().GetPolledType());
+        const uint64_t size = GetDataTypeSize(metricView.GetDataTypeInfo().GetPolledType());
+        staticMetricSizes.emplace(metric, size);
+        return size;
+    }
 
+    void ConcreteMiddleware::PollStaticQuery(const PM_QUERY_ELEMENT& element, uint32_t processId, uint8_t* pBlob)
+    {
+        auto elementSize = GetStaticMetricSize(element.metric);
+
+        staticMetricCache.Require(std::span{ &element, 1 }, pComms->GetAdapterGeneration(), [this](const StaticMetricSourceSet& missing) {
+            FetchStaticMetricSources(missing);
+        });
         CopyStaticMetricData(element.metric, element.deviceId, pBlob, 0, elementSize);
 
         return;
     }
 
+    void ConcreteMiddleware::PollStaticQueryBatch(std::span<PM_QUERY_ELEMENT> elements, uint32_t processId, uint8_t* pBlob, uint32_t& blobSize)
+    {
+        // resolve every element's size first so that a dynamic metric fails the batch before anything is written
+        const auto requiredSize = LayoutQueryElements(elements, [this](PM_METRIC metric) {
+            return GetStaticMetricSize(metric);
+        });
+        const auto capacity = blobSize;
+        blobSize = uint32_t(requiredSize);
+        if (pBlob == nullptr || capacity < requiredSize) {
+            throw Except<ipc::PmStatusError>(PM_STATUS_INSUFFICIENT_BUFFER, "blob too small for static query batch");
+        }
+
+        // at most one service round trip for the whole batch
+        staticMetricCache.Require(elements, pComms->GetAdapterGeneration(), [this](const StaticMetricSourceSet& missing) {
+            FetchStaticMetricSources(missing);
+        });
+        for (auto& e : elements) {
+            CopyStaticMetricData(e.metric, e.deviceId, pBlob, e.dataOffset, e.dataSize);
+        }
+    }
+
     PM_FRAME_QUERY* mid::ConcreteMiddleware::RegisterFrameEventQuery(std::span<PM_QUERY_ELEMENT> queryElements, uint32_t& blobSize)
     {
         const auto pQuery = new PM_FRAME_QUERY{ queryElements };
         blobSize = (uint32_t)pQuery->GetBlobSize();
+        frameQueries.insert(pQuery);
+        // frames already decoded for tracked processes predate the query, so it doesn't see them
+        for (auto& [pid, pState] : frameDecodeStates) {
+            pState->frames.AddCursor(pQuery);
+        }
         return pQuery;
     }
 
     void mid::ConcreteMiddleware::FreeFrameEventQuery(const PM_FRAME_QUERY* pQuery)
     {
+        for (auto& [pid, pState] : frameDecodeStates) {
+            pState->frames.RemoveCursor(pQuery);
+        }
+        frameQueries.erase(pQuery);
         delete const_cast<PM_FRAME_QUERY*>(pQuery);
     }
 
@@ -1087,6 +1157,12 @@ static void ReportMetrics(
             throw Except<util::Exception>("Process died cannot consume frame events");
         }
 
+        // nothing can be copied into an empty blob; return before decoding so that no frames
+        // are consumed on behalf of this query
+        if (frames_to_copy == 0) {
+            return;
+        }
+
         const auto last_frame_idx = pShmClient->GetLatestFrameIndex();
         if (last_frame_idx == UINT_MAX) {
             // There are no frames available, no error frames copied = 0
@@ -1098,23 +1174,145 @@ static void ReportMetrics(
             SetActiveGraphicsAdapter(*devId);
         }
 
-        uint64_t simStartTime = 0;
-        auto iter = appSimStartTime.find(processId);
-        if (iter != appSimStartTime.end()) {
-            simStartTime = iter->second;
+        // frames are decoded once per process and shared by every frame query consuming it,
+        // each query reading them from its own cursor
+        auto iState = frameDecodeStates.find(processId);
+        if (iState == frameDecodeStates.end()) {
+            iState = frameDecodeStates.emplace(processId, std::make_unique<FrameDecodeState>(
+                size_t(nsm_hdr->max_entries), nsm_hdr->start_qpc, pShmClient->GetQpcFrequency().QuadPart)).first;
+            // every registered query consumes the frames, so none of them is the only consumer
+            // just because it is the first to consume
+            for (auto pRegistered : frameQueries) {
+                iState->second->frames.AddCursor(pRegistered);
+            }
         }
+        auto& state = *iState->second;
+        state.GatherWhileDecoding(*pQuery, pBlob, frames_to_copy);
+        DecodeNewFrames(*pShmClient, state);
 
-        // context transmits various data that applies to each gather command in the query
-        PM_FRAME_QUERY::Context ctx{ nsm_hdr->start_qpc, pShmClient->GetQpcFrequency().QuadPart, simStartTime };
+        frames_copied = state.Gather(*pQuery, pBlob, frames_to_copy);
+        // Set to the actual number of frames copied
+        numFrames = frames_copied;
+    }
 
-        while (frames_copied < frames_to_copy) {
+    enum class BlobFit { Fits, Full, Never };
+
+    // whether a source frame producing frameCount frames fits in a blob of maxFrames frames that
+    // already holds gathered frames; one that even an empty blob could never hold is to be
+    // skipped so it doesn't stall the query forever
+    static BlobFit CheckBlobFit(uint32_t frameCount, uint32_t gathered, uint32_t maxFrames)
+    {
+        if (gathered + frameCount <= maxFrames) {
+            return BlobFit::Fits;
+        }
+        if (gathered == 0 && maxFrames > 0 && frameCount > maxFrames) {
+            pmlog_warn(std::format("Skipping source frame that produces {} frames but blob holds {}",
+                frameCount, maxFrames)).diag();
+            return BlobFit::Never;
+        }
+        return BlobFit::Full;
+    }
+
+    static uint32_t GetProducedFrameCount(const PM_FRAME_QUERY::Context& ctx)
+    {
+        return ctx.dropped ? 1 : ctx.pSourceFrameData->present_event.DisplayedCount;
+    }
+
+    // gathers every frame the source frame of the context produces, returns the blob position
+    // following them
+    static uint8_t* GatherSourceFrame(const PM_FRAME_QUERY& query, PM_FRAME_QUERY::Context& ctx, uint8_t* pBlob)
+    {
+        if (ctx.dropped) {
+            query.GatherToBlob(ctx, pBlob);
+            return pBlob + query.GetBlobSize();
+        }
+        for (; ctx.sourceFrameDisplayIndex < ctx.pSourceFrameData->present_event.DisplayedCount; ctx.sourceFrameDisplayIndex++) {
+            query.GatherToBlob(ctx, pBlob);
+            pBlob += query.GetBlobSize();
+        }
+        return pBlob;
+    }
+
+    void FrameDecodeState::Decode(const PmNsmFrameData* pCurrent, const PmNsmFrameData* pNextDisplayed,
+        const PmNsmFrameData* pLastPresented, const PmNsmFrameData* pLastDisplayed,
+        const PmNsmFrameData* pPreviousOfLastDisplayed)
+    {
+        ctx.UpdateSourceData(pCurrent, pNextDisplayed, pLastPresented, pLastDisplayed, pPreviousOfLastDisplayed);
+        const auto frameCount = GetProducedFrameCount(ctx);
+        auto fit = BlobFit::Full;
+        if (direct_ && !direct_->full) {
+            fit = CheckBlobFit(frameCount, direct_->gathered, direct_->maxFrames);
+        }
+        if (fit == BlobFit::Fits) {
+            // the frame is still in shared memory, so it is gathered from there without a copy
+            direct_->pBlob = GatherSourceFrame(*direct_->pQuery, ctx, direct_->pBlob);
+            direct_->gathered += frameCount;
+        }
+        else if (fit == BlobFit::Full) {
+            if (direct_) {
+                direct_->full = true;
+            }
+            // copy the frame out of shared memory, where the service will eventually overwrite it
+            auto& decoded = frames.Push();
+            decoded.frame = *pCurrent;
+            decoded.ctx.emplace(ctx);
+            decoded.ctx->pSourceFrameData = &decoded.frame;
+        }
+        // input latched from dropped frames is attributed to the next displayed frame only;
+        // gathering resets it in the frame's own context, which is a copy of this one
+        if (!ctx.dropped) {
+            ctx.lastReceivedNotDisplayedClickQpc = 0;
+            ctx.lastReceivedNotDisplayedAllInputTime = 0;
+        }
+    }
+
+    void FrameDecodeState::GatherWhileDecoding(const PM_FRAME_QUERY& query, uint8_t* pBlob, uint32_t maxFrames)
+    {
+        direct_.reset();
+        // reading the cursor registers the query, so count consumers after it
+        if (frames.GetCursor(&query) == frames.GetEnd() && frames.GetConsumerCount() == 1) {
+            direct_ = DirectGather_{ &query, pBlob, maxFrames };
+        }
+    }
+
+    uint32_t FrameDecodeState::Gather(const PM_FRAME_QUERY& query, uint8_t* pBlob, uint32_t maxFrames)
+    {
+        uint32_t gathered = 0;
+        if (direct_ && direct_->pQuery == &query) {
+            gathered = direct_->gathered;
+            pBlob = direct_->pBlob;
+        }
+        direct_.reset();
+        auto sequence = frames.GetCursor(&query);
+        for (; sequence < frames.GetEnd(); sequence++) {
+            // gather from a copy of the context since gathering advances the display index
+            auto frameCtx = *frames.At(sequence).ctx;
+            const auto frameCount = GetProducedFrameCount(frameCtx);
+            // stop before a source frame that produces more frames than we can store in the blob
+            const auto fit = CheckBlobFit(frameCount, gathered, maxFrames);
+            if (fit == BlobFit::Never) {
+                continue;
+            }
+            if (fit == BlobFit::Full) {
+                break;
+            }
+            pBlob = GatherSourceFrame(query, frameCtx, pBlob);
+            gathered += frameCount;
+        }
+        frames.SetCursor(&query, sequence);
+        return gathered;
+    }
+
+    void ConcreteMiddleware::DecodeNewFrames(StreamClient& client, FrameDecodeState& state)
+    {
+        while (true) {
             const PmNsmFrameData* pCurrentFrameData = nullptr;
             const PmNsmFrameData* pNextFrameData = nullptr;
             const PmNsmFrameData* pFrameDataOfLastPresented = nullptr;
             const PmNsmFrameData* pFrameDataOfNextDisplayed = nullptr;
             const PmNsmFrameData* pFrameDataOfLastDisplayed = nullptr;
             const PmNsmFrameData* pPreviousFrameDataOfLastDisplayed = nullptr;
-            const auto status = pShmClient->ConsumePtrToNextNsmFrameData(&pCurrentFrameData, &pNextFrameData,
+            const auto status = client.ConsumePtrToNextNsmFrameData(&pCurrentFrameData, &pNextFrameData,
                 &pFrameDataOfNextDisplayed, &pFrameDataOfLastPresented, &pFrameDataOfLastDisplayed, &pPreviousFrameDataOfLastDisplayed);
             if (status != PM_STATUS::PM_STATUS_SUCCESS) {
                 pmlog_error("Error while trying to get frame data from shared memory").diag();
@@ -1124,40 +1322,13 @@ static void ReportMetrics(
                 break;
             }
             if (pFrameDataOfLastPresented && pFrameDataOfNextDisplayed) {
-                ctx.UpdateSourceData(pCurrentFrameData,
+                state.Decode(pCurrentFrameData,
                     pFrameDataOfNextDisplayed,
                     pFrameDataOfLastPresented,
                     pFrameDataOfLastDisplayed,
                     pPreviousFrameDataOfLastDisplayed);
-
-                if (simStartTime == 0 && ctx.firstAppSimStartTime != 0) {
-                    simStartTime = ctx.firstAppSimStartTime;
-                }
-
-                if (ctx.dropped) {
-                    pQuery->GatherToBlob(ctx, pBlob);
-                    pBlob += pQuery->GetBlobSize();
-                    frames_copied++;
-                } else {
-                    while (ctx.sourceFrameDisplayIndex < ctx.pSourceFrameData->present_event.DisplayedCount) {
-                        pQuery->GatherToBlob(ctx, pBlob);
-                        pBlob += pQuery->GetBlobSize();
-                        frames_copied++;
-                        ctx.sourceFrameDisplayIndex++;
-                    }
-                }
-            }
-            // Check to see if the next frame produces more frames than we can store in the
-            // the blob.
-            if (frames_copied + pNextFrameData->present_event.DisplayedCount >= frames_to_copy) {
-                break;
             }
         }
-        // Set to the actual number of frames copied
-        numFrames = frames_copied;
-        if (simStartTime != 0) {
-            appSimStartTime[processId] = simStartTime;
-        }
     }
 
     void ConcreteMiddleware::CalculateFpsMetric(fpsSwapChainData& swapChain, const PM_QUERY_ELEMENT& element, uint8_t* pBlob, LARGE_INTEGER qpcFrequency)
@@ -1950,29 +2121,44 @@ static void ReportMetrics(
         return PM_STATUS_SUCCESS;
     }
 
-    void ConcreteMiddleware::GetStaticGpuMetrics()
+    void ConcreteMiddleware::OnAdaptersEnumerated(bool allAdaptersFound)
     {
-        try {
-            const auto res = pActionClient->DispatchSync(EnumerateAdapters::Params{});
-
-            // check that adapter count matches introspection
-            if (res.adapters.size() != cachedGpuInfo.size()) {
-                pmlog_warn(std::format("Queried adapter count {} did not match count from introspection {}",
-                    res.adapters.size(), cachedGpuInfo.size())).diag();
-            }
+        // an adapter the service did not enumerate (yet) keeps the values it has, and the adapters are
+        // enumerated again by the next poll that needs them
+        if (allAdaptersFound) {
+            staticMetricCache.MarkLoaded(StaticMetricSource::Adapters);
+        }
+        else {
+            pmlog_warn("Adapter missing from service enumeration, will enumerate again").diag();
+            staticMetricCache.Invalidate(StaticMetricSource::Adapters);
+        }
+    }
 
-            // For each cached gpu search through the returned adapter information and set the returned
-            // static gpu metrics where a match is found
-            for (auto& gpuInfo : cachedGpuInfo) {
-                for (auto& adapter : res.adapters) {
-                    if (gpuInfo.adapterId == adapter.id) {
-                        gpuInfo.gpuSustainedPowerLimit = adapter.gpuSustainedPowerLimit;
-                        gpuInfo.gpuMemorySize = adapter.gpuMemorySize;
-                        gpuInfo.gpuMemoryMaxBandwidth = adapter.gpuMemoryMaxBandwidth;
-                        break;
-                    }
+    void ConcreteMiddleware::FetchStaticMetricSources(const StaticMetricSourceSet& sources)
+    {
+        const bool adapters = sources[size_t(StaticMetricSource::Adapters)];
+        const bool cpu = sources[size_t(StaticMetricSource::Cpu)];
+        // sources that fail are left unloaded and requested again by the next poll that needs them
+        try {
+            if (adapters && cpu) {
+                // both requests share one round trip, each one succeeds or fails on its own
+                auto [adapterResult, cpuResult] = pActionClient->DispatchMixedBatch(
+                    EnumerateAdapters::Params{}, GetStaticCpuMetrics::Params{});
+                if (adapterResult.Succeeded()) {
+                    OnAdaptersEnumerated(StoreAdapterMetrics(cachedGpuInfo, adapterResult.Get()));
+                }
+                if (cpuResult.Succeeded()) {
+                    auto& metrics = cpuResult.Get();
+                    StoreStaticCpuMetrics(std::move(metrics.cpuName), metrics.cpuPowerLimit);
                 }
             }
+            else if (adapters) {
+                OnAdaptersEnumerated(StoreAdapterMetrics(cachedGpuInfo, pActionClient->DispatchSync(EnumerateAdapters::Params{})));
+            }
+            else if (cpu) {
+                auto metrics = pActionClient->DispatchSync(GetStaticCpuMetrics::Params{});
+                StoreStaticCpuMetrics(std::move(metrics.cpuName), metrics.cpuPowerLimit);
+            }
         }
         catch (...) {
             const auto code = util::GeneratePmStatus();
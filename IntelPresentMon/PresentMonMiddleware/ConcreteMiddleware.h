@@ -1,11 +1,15 @@
 #pragma once
 #include "../CommonUtilities/win/WinAPI.h"
 #include "Middleware.h"
+#include "StaticMetricCache.h"
+#include "FrameFanoutCache.h"
+#include "FrameEventQuery.h"
 #include "../Interprocess/source/Interprocess.h"
 #include "../Streamer/StreamClient.h"
 #include <optional>
 #include <string>
 #include <queue>
+#include <unordered_set>
 #include "../CommonUtilities/Hash.h"
 
 namespace pmapi::intro
@@ -21,6 +25,47 @@ namespace pmon::mid
 		uint64_t metricOffset = 0;
 	};
 
+	// a frame copied out of shared memory along with the context computed for it, ready to be
+	// gathered by any frame query
+	struct DecodedFrame {
+		PmNsmFrameData frame;
+		std::optional<PM_FRAME_QUERY::Context> ctx;
+	};
+
+	// frames of one tracked process, decoded once no matter how many frame queries consume them
+	struct FrameDecodeState {
+		FrameDecodeState(size_t capacity, uint64_t qpcStart, long long qpcFrequency)
+			:
+			frames{ capacity },
+			ctx{ qpcStart, qpcFrequency, 0 }
+		{}
+		// computes the context of a frame from shared memory and copies both into the ring, or
+		// gathers it straight into the blob set up by GatherWhileDecoding
+		void Decode(const PmNsmFrameData* pCurrent, const PmNsmFrameData* pNextDisplayed,
+			const PmNsmFrameData* pLastPresented, const PmNsmFrameData* pLastDisplayed,
+			const PmNsmFrameData* pPreviousOfLastDisplayed);
+		// when the query is the only consumer and has read every frame in the ring, frames
+		// decoded until the next Gather go straight into its blob without being copied into the
+		// ring; frames that no longer fit are copied into the ring as usual
+		void GatherWhileDecoding(const PM_FRAME_QUERY& query, uint8_t* pBlob, uint32_t maxFrames);
+		// gathers up to maxFrames frames that the query has not read yet into the blob and
+		// advances its cursor past them, returns the number of frames gathered (including any
+		// gathered while decoding)
+		uint32_t Gather(const PM_FRAME_QUERY& query, uint8_t* pBlob, uint32_t maxFrames);
+		FrameFanoutCache<DecodedFrame> frames;
+		// carries state between consecutive frames while decoding
+		PM_FRAME_QUERY::Context ctx;
+	private:
+		struct DirectGather_ {
+			const PM_FRAME_QUERY* pQuery;
+			uint8_t* pBlob;
+			uint32_t maxFrames;
+			uint32_t gathered = 0;
+			bool full = false;
+		};
+		std::optional<DirectGather_> direct_;
+	};
+
     // Copied from: PresentMon/PresentMon.hpp
     // We store SwapChainData per process and per swapchain, where we maintain:
     // - information on previous presents needed for console output or to compute metrics for upcoming
@@ -105,6 +150,7 @@ namespace pmon::mid
 		void FreeDynamicQuery(const PM_DYNAMIC_QUERY* pQuery) override {}
 		void PollDynamicQuery(const PM_DYNAMIC_QUERY* pQuery, uint32_t processId, uint8_t* pBlob, uint32_t* numSwapChains) override;
 		void PollStaticQuery(const PM_QUERY_ELEMENT& element, uint32_t processId, uint8_t* pBlob) override;
+		void PollStaticQueryBatch(std::span<PM_QUERY_ELEMENT> elements, uint32_t processId, uint8_t* pBlob, uint32_t& blobSize) override;
 		PM_FRAME_QUERY* RegisterFrameEventQuery(std::span<PM_QUERY_ELEMENT> queryElements, uint32_t& blobSize) override;
 		void FreeFrameEventQuery(const PM_FRAME_QUERY* pQuery) override;
 		void ConsumeFrameEvents(const PM_FRAME_QUERY* pQuery, uint32_t processId, uint8_t* pBlob, uint32_t& numFrames) override;
@@ -113,7 +159,6 @@ namespace pmon::mid
 		uint64_t GetAdjustedQpc(uint64_t current_qpc, uint64_t frame_data_qpc, uint64_t queryMetricsOffset, LARGE_INTEGER frequency, uint64_t& queryFrameDataDelta);
 		bool DecrementIndex(NamedSharedMem* nsm_view, uint64_t& index);
 		PM_STATUS SetActiveGraphicsAdapter(uint32_t deviceId);
-		void GetStaticGpuMetrics();
 
 		void CalculateFpsMetric(fpsSwapChainData& swapChain, const PM_QUERY_ELEMENT& element, uint8_t* pBlob, LARGE_INTEGER qpcFrequency);
 		void CalculateGpuCpuMetric(std::unordered_map<PM_METRIC, MetricInfo>& metricInfo, const PM_QUERY_ELEMENT& element, uint8_t* pBlob);
@@ -121,7 +166,11 @@ namespace pmon::mid
 		double CalculatePercentile(std::vector<double>& inData, double percentile, bool invert) const;
 		bool GetGpuMetricData(size_t telemetry_item_bit, PresentMonPowerTelemetryInfo& power_telemetry_info, std::unordered_map<PM_METRIC, MetricInfo>& metricInfo);
 		bool GetCpuMetricData(size_t telemetryBit, CpuTelemetryInfo& cpuTelemetry, std::unordered_map<PM_METRIC, MetricInfo>& metricInfo);
-		void GetStaticCpuMetrics();
+		// request the given sources from the service in one round trip and store what was returned
+		void FetchStaticMetricSources(const StaticMetricSourceSet& sources);
+		void OnAdaptersEnumerated(bool allAdaptersFound);
+		void StoreStaticCpuMetrics(std::string cpuName, double cpuPowerLimit);
+		uint64_t GetStaticMetricSize(PM_METRIC metric);
 		std::string GetProcessName(uint32_t processId);
 		void CopyStaticMetricData(PM_METRIC metric, uint32_t deviceId, uint8_t* pBlob, uint64_t blobOffset, size_t sizeInBytes = 0);
 
@@ -131,14 +180,18 @@ namespace pmon::mid
 
 		std::optional<size_t> GetCachedGpuInfoIndex(uint32_t deviceId);
 
+		void DecodeNewFrames(StreamClient& client, FrameDecodeState& state);
+
 		const pmapi::intro::Root& GetIntrospectionRoot();
 
 		std::shared_ptr<class ActionClient> pActionClient;
 		uint32_t clientProcessId = 0;
 		// Stream clients mapping to process id
 		std::map<uint32_t, std::unique_ptr<StreamClient>> presentMonStreamClients;
-		// App sim start time for each process id
-		std::map<uint32_t, uint64_t> appSimStartTime;
+		// Decoded frames (and each frame query's cursor into them) for each process id
+		std::map<uint32_t, std::unique_ptr<FrameDecodeState>> frameDecodeStates;
+		// every frame query registered, each a consumer of every process's decoded frames
+		std::unordered_set<const PM_FRAME_QUERY*> frameQueries;
 		std::unique_ptr<ipc::MiddlewareComms> pComms;
 		// Dynamic query handle to frame data delta
 		std::unordered_map<std::pair<const PM_DYNAMIC_QUERY*, uint32_t>, uint64_t> queryFrameDataDeltas;
@@ -146,6 +199,9 @@ namespace pmon::mid
 		std::unordered_map<std::pair<const PM_DYNAMIC_QUERY*, uint32_t>, std::unique_ptr<uint8_t[]>> cachedMetricDatas;
 		std::vector<DeviceInfo> cachedGpuInfo;
 		std::vector<DeviceInfo> cachedCpuInfo;
+		// which of the above have been fetched from the service, and polled size of each static metric
+		StaticMetricCache staticMetricCache;
+		std::unordered_map<PM_METRIC, uint64_t> staticMetricSizes;
 		uint32_t currentGpuInfoIndex = UINT32_MAX;
 		std::optional<uint32_t> activeDevice;
 		std::unique_ptr<pmapi::intro::Root> pIntroRoot;
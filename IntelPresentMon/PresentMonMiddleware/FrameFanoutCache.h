@@ -0,0 +1,71 @@
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+namespace pmon::mid
+{
+	// fixed-capacity ring of records that are decoded once from a frame stream and then read
+	// by any number of consumers, each through its own cursor (the sequence number of the next
+	// record it will read)
+	// once the ring is full, pushing overwrites the oldest record; a consumer that falls that
+	// far behind resumes at the oldest record still held, just as it would lose frames that the
+	// service overwrote in shared memory
+	template<class T>
+	class FrameFanoutCache
+	{
+	public:
+		explicit FrameFanoutCache(size_t capacity)
+			:
+			records_(std::max<size_t>(capacity, 1))
+		{}
+		// slot to decode the next record into; it is readable by consumers as soon as this returns
+		T& Push()
+		{
+			return records_[end_++ % records_.size()];
+		}
+		// sequence number of the oldest record held
+		uint64_t GetBegin() const
+		{
+			return end_ > records_.size() ? end_ - records_.size() : 0;
+		}
+		// one past the sequence number of the newest record
+		uint64_t GetEnd() const
+		{
+			return end_;
+		}
+		const T& At(uint64_t sequence) const
+		{
+			return records_[sequence % records_.size()];
+		}
+		// registers a consumer that only reads records pushed from now on
+		void AddCursor(const void* pConsumer)
+		{
+			cursors_.try_emplace(pConsumer, GetEnd());
+		}
+		// next record for the consumer to read; a consumer that was never added starts at the
+		// oldest record held
+		uint64_t GetCursor(const void* pConsumer)
+		{
+			const auto i = cursors_.try_emplace(pConsumer, GetBegin()).first;
+			return std::max(i->second, GetBegin());
+		}
+		void SetCursor(const void* pConsumer, uint64_t sequence)
+		{
+			cursors_[pConsumer] = sequence;
+		}
+		void RemoveCursor(const void* pConsumer)
+		{
+			cursors_.erase(pConsumer);
+		}
+		size_t GetConsumerCount() const
+		{
+			return cursors_.size();
+		}
+	private:
+		std::vector<T> records_;
+		uint64_t end_ = 0;
+		std::unordered_map<const void*, uint64_t> cursors_;
+	};
+}
@@ -20,6 +20,7 @@ namespace pmon::mid
 		virtual void FreeDynamicQuery(const PM_DYNAMIC_QUERY* pQuery) = 0;
 		virtual void PollDynamicQuery(const PM_DYNAMIC_QUERY* pQuery, uint32_t processId, uint8_t* pBlob, uint32_t* numSwapChains) = 0;
 		virtual void PollStaticQuery(const PM_QUERY_ELEMENT& element, uint32_t processId, uint8_t* pBlob) = 0;
+		virtual void PollStaticQueryBatch(std::span<PM_QUERY_ELEMENT> elements, uint32_t processId, uint8_t* pBlob, uint32_t& blobSize) = 0;
 		virtual PM_FRAME_QUERY* RegisterFrameEventQuery(std::span<PM_QUERY_ELEMENT> queryElements, uint32_t& blobSize) { return nullptr; }
 		virtual void FreeFrameEventQuery(const PM_FRAME_QUERY* pQuery) {}
 		virtual void ConsumeFrameEvents(const PM_FRAME_QUERY* pQuery, uint32_t processId, uint8_t* pBlob, uint32_t& numFrames) {}
@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include <span>
+#include "../PresentMonAPI2/PresentMonAPI.h"
+
+namespace pmon::mid
+{
+	// service requests that static metric values are fetched with
+	// (gpu name/vendor come from introspection and need no request)
+	enum class StaticMetricSource
+	{
+		None,
+		Adapters,	// EnumerateAdapters
+		Cpu,		// GetStaticCpuMetrics
+		Count_,
+	};
+
+	inline StaticMetricSource GetStaticMetricSource(PM_METRIC metric)
+	{
+		switch (metric) {
+		case PM_METRIC_GPU_MEM_SIZE:
+		case PM_METRIC_GPU_MEM_MAX_BANDWIDTH:
+		case PM_METRIC_GPU_SUSTAINED_POWER_LIMIT:
+			return StaticMetricSource::Adapters;
+		case PM_METRIC_CPU_NAME:
+		case PM_METRIC_CPU_VENDOR:
+		case PM_METRIC_CPU_POWER_LIMIT:
+			return StaticMetricSource::Cpu;
+		default:
+			return StaticMetricSource::None;
+		}
+	}
+
+	// set of sources, indexed by StaticMetricSource
+	using StaticMetricSourceSet = std::array<bool, size_t(StaticMetricSource::Count_)>;
+
+	// tracks which service-side static data the middleware holds, so that polling any number
+	// of static metrics makes at most one service round trip until a source is invalidated
+	// (or until a request succeeds, if it failed)
+	class StaticMetricCache
+	{
+	public:
+		// calls fetch(missing) once if any source required by elements isn't loaded
+		// fetch requests all of the missing sources together and marks the ones it loaded
+		// adapterGeneration is the service's current adapter enumeration generation; adapter values
+		// loaded under a different generation may belong to devices that have since been replaced
+		template<class F>
+		void Require(std::span<const PM_QUERY_ELEMENT> elements, uint32_t adapterGeneration, F&& fetch)
+		{
+			SyncAdapterGeneration(adapterGeneration);
+			StaticMetricSourceSet missing{};
+			bool anyMissing = false;
+			for (auto& e : elements) {
+				const auto i = size_t(GetStaticMetricSource(e.metric));
+				if (i != size_t(StaticMetricSource::None) && !loaded_[i]) {
+					missing[i] = true;
+					anyMissing = true;
+				}
+			}
+			if (anyMissing) {
+				fetch(missing);
+			}
+		}
+		void MarkLoaded(StaticMetricSource source, bool loaded = true)
+		{
+			loaded_[size_t(source)] = loaded;
+		}
+		void Invalidate(StaticMetricSource source)
+		{
+			MarkLoaded(source, false);
+		}
+		// invalidates adapter values when the generation differs from the one they were loaded under
+		// (read the generation before fetching, so that a change during the fetch is caught by the next call)
+		void SyncAdapterGeneration(uint32_t adapterGeneration)
+		{
+			if (adapterGeneration != adapterGeneration_) {
+				Invalidate(StaticMetricSource::Adapters);
+				adapterGeneration_ = adapterGeneration;
+			}
+		}
+		bool IsLoaded(StaticMetricSource source) const
+		{
+			return loaded_[size_t(source)];
+		}
+	private:
+		StaticMetricSourceSet loaded_{};
+		uint32_t adapterGeneration_ = 0;
+	};
+
+	// assign each element's dataOffset/dataSize back to back (the same layout as dynamic
+	// queries) using getSize(metric), and return the total blob size
+	template<class F>
+	uint64_t LayoutQueryElements(std::span<PM_QUERY_ELEMENT> elements, F&& getSize)
+	{
+		uint64_t offset = 0;
+		for (auto& e : elements) {
+			e.dataOffset = offset;
+			e.dataSize = getSize(e.metric);
+			offset += e.dataSize;
+		}
+		return offset;
+	}
+}
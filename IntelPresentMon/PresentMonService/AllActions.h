@@ -1,5 +1,6 @@
 // GENERATED HEADER 
 #pragma once 
+#include "acts/Batch.h" 
 #include "acts/EnumerateAdapters.h" 
 #include "acts/GetIntrospectionShmName.h" 
 #include "acts/GetStaticCpuMetrics.h" 
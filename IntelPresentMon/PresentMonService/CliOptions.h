@@ -23,6 +23,22 @@ namespace clio
 		Option<long long> timedStop{ this, "--timed-stop", -1, "Signal stop event after specified number of milliseconds" };
 		Option<std::string> etlTestFile{ this, "--etl-test-file", "", "Etl test file including necessary path" };
 
+	private: Group gt_{ this, "Telemetry", "Record and replay of power telemetry" }; public:
+		Option<std::string> telemetryRecordDir{ this, "--telemetry-record-dir", "", "Record gpu and cpu telemetry samples to files in the specified directory" };
+		Option<std::string> telemetryReplayDir{ this, "--telemetry-replay-dir", "", "Replay telemetry recordings from the specified directory instead of sampling hardware" };
+		Option<double> telemetryReplaySpeed{ this, "--telemetry-replay-speed", 1., "Playback rate of replayed telemetry relative to the original recording", CLI::PositiveNumber };
+
+	private: Group gs_{ this, "Synthetic Load", "Stream generated presents instead of tracing ETW events, for stress testing" }; public:
+		Flag syntheticLoad{ this, "--synthetic-load", "Generate present events at the rates below instead of tracing ETW events or replaying an ETL file" };
+		Option<double> synthFps{ this, "--synth-fps", 1000., "Present rate of each synthetic swap chain" };
+		Option<double> synthJitter{ this, "--synth-jitter", 0.1, "Random variation of the synthetic present interval, as a fraction of it" };
+		Option<double> synthDropRatio{ this, "--synth-drop-ratio", 0.05, "Fraction of synthetic presents that are dropped" };
+		Option<uint32_t> synthSwapChains{ this, "--synth-swap-chains", 1, "Number of swap chains in each synthetic process" };
+		Option<uint32_t> synthProcesses{ this, "--synth-processes", 1, "Number of synthetic processes; the first one takes the id of the first tracked process" };
+		Option<double> synthProcessLifetime{ this, "--synth-process-lifetime", 0., "Seconds after which each synthetic process but the first exits and is replaced by a new one (0 for never)" };
+		Option<double> synthSpeed{ this, "--synth-speed", 1., "Rate of synthetic time relative to the wall clock (0 to generate as fast as possible)" };
+		Option<double> synthStatsPeriod{ this, "--synth-stats-period", 5., "Seconds between throughput and latency reports, which are logged at info level" };
+
 	private: Group gl_{ this, "Logging", "Control logging behavior" }; public:
 		Option<std::string> logDir{ this, "--log-dir", "", "Enable logging to a file in the specified directory" };
 		Option<std::string> logPipeName{ this, "--log-pipe-name", pmon::gid::defaultLogPipeBaseName, "Name of the pipe to connect to for log IPC" };
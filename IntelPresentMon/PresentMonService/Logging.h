@@ -2,6 +2,7 @@
 
 //#define PMLOG_BUILD_LEVEL Verbose
 //#define VVV_ETWQ
+//#define VVV_ETWINST
 #include "../CommonUtilities/log/Log.h"
 
 
@@ -12,4 +13,9 @@ namespace pmon::svc::v
 #else
 	inline constexpr bool etwq = true;
 #endif
+#ifndef VVV_ETWINST // PMTraceConsumer handler instrumentation (needs PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION)
+	inline constexpr bool etwinst = false;
+#else
+	inline constexpr bool etwinst = true;
+#endif
 }
\ No newline at end of file
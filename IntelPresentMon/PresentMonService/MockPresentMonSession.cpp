@@ -1,10 +1,14 @@
 // Copyright (C) 2022-2023 Intel Corporation
 // SPDX-License-Identifier: MIT
+#include "Logging.h"
 #include "MockPresentMonSession.h"
 #include "CliOptions.h"
 #include "..\CommonUtilities\str\String.h"
 
 static const std::wstring kMockEtwSessionName = L"MockETWSession";
+// Synthetic presents are generated in small batches so that their latency
+// statistics reflect the pipeline rather than the output loop's sleep.
+static const DWORD kSyntheticOutputPeriodMs = 2;
 
 MockPresentMonSession::MockPresentMonSession()
     : quit_output_thread_(false),
@@ -15,15 +19,18 @@ MockPresentMonSession::MockPresentMonSession()
 }
 
 bool MockPresentMonSession::IsTraceSessionActive() {
-    return (pm_consumer_ != nullptr);
+    return (pm_consumer_ != nullptr || synthetic_generator_ != nullptr);
 }
 
 PM_STATUS MockPresentMonSession::StartStreaming(uint32_t client_process_id,
     uint32_t target_process_id,
     std::string& nsmFileName) {
 
+    // Synthetic presents are streamed like realtime ones, overwriting the
+    // oldest frames instead of waiting for clients to consume them.
+    auto& opt = clio::Options::Get();
     PM_STATUS status = streamer_.StartStreaming(client_process_id,
-        target_process_id, nsmFileName, true);
+        target_process_id, nsmFileName, !opt.syntheticLoad);
     if (status != PM_STATUS::PM_STATUS_SUCCESS) {
         return status;
     }
@@ -48,7 +55,7 @@ void MockPresentMonSession::StopStreaming(uint32_t client_process_id,
 }
 
 bool MockPresentMonSession::CheckTraceSessions(bool forceTerminate) {
-    if (pm_consumer_ && (process_trace_finished_ == true || streamer_.IsTimedOut())) {
+    if (IsTraceSessionActive() && (process_trace_finished_ == true || streamer_.IsTimedOut())) {
         StopTraceSession();
         return true;
     }
@@ -67,6 +74,10 @@ HANDLE MockPresentMonSession::GetStreamingStartHandle() {
 PM_STATUS MockPresentMonSession::StartTraceSession(uint32_t processId) {
     auto& opt = clio::Options::Get();
 
+    if (opt.syntheticLoad) {
+        return StartSyntheticSession(processId);
+    }
+
     // In a mock PresentMon session we must have an ETL process
     // if we are starting a trace session
     if (opt.etlTestFile.AsOptional().has_value() == false) {
@@ -149,6 +160,42 @@ PM_STATUS MockPresentMonSession::StartTraceSession(uint32_t processId) {
     return PM_STATUS::PM_STATUS_SUCCESS;
 }
 
+PM_STATUS MockPresentMonSession::StartSyntheticSession(uint32_t processId) {
+    auto& opt = clio::Options::Get();
+
+    std::lock_guard<std::mutex> lock(session_mutex_);
+    process_trace_finished_ = false;
+
+    if (synthetic_generator_) {
+        return PM_STATUS::PM_STATUS_SERVICE_ERROR;
+    }
+
+    LARGE_INTEGER qpc, qpcFrequency;
+    QueryPerformanceCounter(&qpc);
+    QueryPerformanceFrequency(&qpcFrequency);
+
+    SyntheticPresentGenerator::Params params;
+    params.firstProcessId = processId;
+    params.processCount = *opt.synthProcesses;
+    params.swapChainCount = *opt.synthSwapChains;
+    params.fps = *opt.synthFps;
+    params.jitter = *opt.synthJitter;
+    params.dropRatio = *opt.synthDropRatio;
+    params.processLifetimeSeconds = *opt.synthProcessLifetime;
+    params.speed = *opt.synthSpeed;
+    synthetic_generator_ = std::make_unique<SyntheticPresentGenerator>(
+        params, qpc.QuadPart, qpcFrequency.QuadPart);
+    synthetic_stats_ = std::make_unique<SyntheticLoadStats>(
+        qpc.QuadPart, qpcFrequency.QuadPart, *opt.synthStatsPeriod);
+
+    pmlog_info(std::format("Started synthetic load: {} process(es) x {} swap chain(s) at {} fps, speed {}",
+        params.processCount, params.swapChainCount, params.fps, params.speed));
+
+    etlProcessId_ = processId;
+    StartOutputThread();
+    return PM_STATUS::PM_STATUS_SUCCESS;
+}
+
 void MockPresentMonSession::StopTraceSession() {
     std::lock_guard<std::mutex> lock(session_mutex_);
     // Stop the trace session.
@@ -165,6 +212,8 @@ void MockPresentMonSession::StopTraceSession() {
     if (pm_consumer_) {
         pm_consumer_.reset();
     }
+    synthetic_generator_.reset();
+    synthetic_stats_.reset();
 }
 
 void MockPresentMonSession::StartConsumerThread(TRACEHANDLE traceHandle) {
@@ -180,6 +229,12 @@ void MockPresentMonSession::WaitForConsumerThreadToExit() {
 void MockPresentMonSession::DequeueAnalyzedInfo(
     std::vector<ProcessEvent>* processEvents,
     std::vector<std::shared_ptr<PresentEvent>>* presentEvents) {
+    if (synthetic_generator_) {
+        LARGE_INTEGER qpc;
+        QueryPerformanceCounter(&qpc);
+        synthetic_generator_->Generate(qpc.QuadPart, processEvents, presentEvents);
+        return;
+    }
     pm_consumer_->DequeueProcessEvents(*processEvents);
     pm_consumer_->DequeuePresentEvents(*presentEvents);
 }
@@ -190,11 +245,13 @@ void MockPresentMonSession::AddPresents(
     uint64_t stopQpc, bool* hitStopQpc) {
     auto i = *presentEventIndex;
 
-    assert(trace_session_.mStartTimestamp.QuadPart != 0);
-    // If mStartTimestamp contains a value an etl file is being processed.
-    // Set this value in the streamer to have the correct start time.
-    streamer_.SetStartQpc(trace_session_.mStartTimestamp.QuadPart);
-    streamer_.SetStreamMode(StreamMode::kOfflineEtl);
+    if (!synthetic_generator_) {
+        assert(trace_session_.mStartTimestamp.QuadPart != 0);
+        // If mStartTimestamp contains a value an etl file is being processed.
+        // Set this value in the streamer to have the correct start time.
+        streamer_.SetStartQpc(trace_session_.mStartTimestamp.QuadPart);
+        streamer_.SetStreamMode(StreamMode::kOfflineEtl);
+    }
 
     for (auto n = presentEvents.size(); i < n; ++i) {
         auto presentEvent = presentEvents[i];
@@ -280,6 +337,12 @@ void MockPresentMonSession::AddPresents(
             processInfo->mModuleName, gpu_telemetry_cap_bits,
             cpu_telemetry_cap_bits);
 
+        if (synthetic_stats_) {
+            LARGE_INTEGER qpc;
+            QueryPerformanceCounter(&qpc);
+            synthetic_stats_->Add(
+                synthetic_generator_->GetDueQpc(presentEvent->PresentStartTime), qpc.QuadPart);
+        }
 
         chain->mLastPresentQPC = presentEvent->PresentStartTime;
         if (presentEvent->FinalState == PresentResult::Presented) {
@@ -328,9 +391,13 @@ void MockPresentMonSession::ProcessEvents(
         auto terminatedProcessId = pair.first;
         auto terminatedProcessQpc = pair.second;
 
+        // Synthetic processes exit and are replaced while presents keep
+        // arriving, so their terminations are applied at the stop QPC. ETL
+        // replay keeps its original behavior.
         auto hitTerminatedProcess = false;
-        AddPresents(*presentEvents, &presentEventIndex, true, false,
-            terminatedProcessQpc, &hitTerminatedProcess);
+        AddPresents(*presentEvents, &presentEventIndex, true,
+            synthetic_generator_ != nullptr, terminatedProcessQpc,
+            &hitTerminatedProcess);
         if (!hitTerminatedProcess) {
             eventProcessingDone = true;
             break;
@@ -414,8 +481,16 @@ void MockPresentMonSession::Output() {
             break;
         }
 
+        if (synthetic_stats_) {
+            LARGE_INTEGER qpc;
+            QueryPerformanceCounter(&qpc);
+            if (auto report = synthetic_stats_->Report(qpc.QuadPart)) {
+                pmlog_info(*report);
+            }
+        }
+
         // Sleep to reduce overhead.
-        Sleep(100);
+        Sleep(synthetic_generator_ ? kSyntheticOutputPeriodMs : 100);
     }
 
     processes_.clear();
@@ -439,15 +514,13 @@ ProcessInfo* MockPresentMonSession::GetProcessInfo(uint32_t processId) {
     auto newProcess = result.second;
 
     if (newProcess) {
-        InitProcessInfo(processInfo, processId, INVALID_HANDLE_VALUE, L"MockProcess.exe");
+        InitProcessInfo(processInfo, processId, L"MockProcess.exe");
     }
     return processInfo;
 }
 
 void MockPresentMonSession::InitProcessInfo(ProcessInfo* processInfo, uint32_t processId,
-    HANDLE handle, std::wstring const& processName) {
-
-    processInfo->mHandle = handle;
+    std::wstring const& processName) {
     processInfo->mModuleName = processName;
     processInfo->mTargetProcess = true;
 
@@ -465,7 +538,7 @@ void MockPresentMonSession::UpdateProcesses(
             auto processInfo = &result.first->second;
             auto newProcess = result.second;
             if (newProcess) {
-                InitProcessInfo(processInfo, processEvent.ProcessId, NULL,
+                InitProcessInfo(processInfo, processEvent.ProcessId,
                     processEvent.ImageFileName);
             }
         }
@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 #include "PresentMonSession.h"
+#include "SyntheticPresentGenerator.h"
 
 class MockPresentMonSession : public PresentMonSession
 {
@@ -21,6 +22,7 @@ public:
 private:
     // functions
     PM_STATUS StartTraceSession(uint32_t processId);
+    PM_STATUS StartSyntheticSession(uint32_t processId);
     void StopTraceSession();
 
     void DequeueAnalyzedInfo(
@@ -44,7 +46,7 @@ private:
 
     ProcessInfo* GetProcessInfo(uint32_t processId);
     void InitProcessInfo(ProcessInfo* processInfo, uint32_t processId,
-        HANDLE handle, std::wstring const& processName);
+        std::wstring const& processName);
     void UpdateProcesses(
         std::vector<ProcessEvent> const& processEvents,
         std::vector<std::pair<uint32_t, uint64_t>>* terminatedProcesses);
@@ -54,6 +56,9 @@ private:
     std::wstring pm_session_name_;
 
     std::unique_ptr<PMTraceConsumer> pm_consumer_;
+    // Replaces pm_consumer_ as the source of present events when running with --synthetic-load
+    std::unique_ptr<SyntheticPresentGenerator> synthetic_generator_;
+    std::unique_ptr<SyntheticLoadStats> synthetic_stats_;
     PMTraceSession trace_session_;
     std::thread consumer_thread_;
     std::thread output_thread_;
@@ -5,15 +5,14 @@
 #include "ActionServer.h"
 #include "PresentMon.h"
 #include "PowerTelemetryContainer.h"
-#include "..\ControlLib\WmiCpu.h"
+#include "..\ControlLib\CpuTelemetry.h"
 #include "..\PresentMonUtils\StringUtils.h"
 #include <filesystem>
 #include "../Interprocess/source/Interprocess.h"
 #include "CliOptions.h"
 #include "GlobalIdentifiers.h"
 #include <ranges>
-#include "../CommonUtilities/IntervalWaiter.h"
-#include "../CommonUtilities/PrecisionWaiter.h"
+#include "../CommonUtilities/mt/PeriodicScheduler.h"
 #include "../CommonUtilities/win/Event.h"
 
 #include "../CommonUtilities/log/GlogShim.h"
@@ -29,165 +28,220 @@ std::string GetIntrospectionShmName()
     return clio::Options::Get().introNsm.AsOptional().value_or(gid::defaultIntrospectionNsmName);
 }
 
-void EventFlushThreadEntry_(Service* const srv, PresentMon* const pm)
+// all periodic telemetry work (gpu sampling, cpu sampling, manual etw flushing) is multiplexed onto a single
+// scheduler thread; each device has its own task and period, and is only sampled while streams are active
+class TelemetryScheduling_
 {
-    if (srv == nullptr || pm == nullptr) {
-        pmlog_error();
-        return;
+public:
+    TelemetryScheduling_(Service* srv, PresentMon* pm, PowerTelemetryContainer* ptc, ipc::ServiceComms* pComms)
+        :
+        srv_{ srv },
+        pm_{ pm },
+        ptc_{ ptc },
+        pComms_{ pComms },
+        scheduler_{ "telemetry" }
+    {
+        flushTask_ = scheduler_.AddTask("etw-flush", disabledFlushInterval_, [this] {
+            // flush events manually to reduce latency
+            pmlog_verb(v::etwq)("Manual ETW flush");
+            pm_->FlushEvents();
+        });
+        controlTask_ = scheduler_.AddTask("telemetry-control", controlInterval_, [this] { Control_(); });
     }
-
-    // this is the interval to wait when manual flush is disabled
-    // we still want to run the inner loop to poll in case it gets enabled
-    const double disabledInterval = 0.25;
-    double currentInterval = pm->GetEtwFlushPeriod().value_or(disabledInterval);
-    IntervalWaiter waiter{ currentInterval };
-
-    // outer dormant loop waits for either start of process tracking or service exit
-    while (true) {
-        pmlog_verb(v::etwq)("Begin idle ETW flush wait");
-        // if event index 0 is signalled that means we are stopping
-        if (*win::WaitAnyEvent(srv->GetServiceStopHandle(), pm->GetStreamingStartHandle()) == 0) {
-            pmlog_dbg("exiting ETW flush thread due to stop handle");
-            return;
-        }
-        pmlog_verb(v::etwq)("Entering ETW flush inner active loop");
-        // otherwise we assume streaming has started and we begin the flushing loop, checking for stop signal
-        while (!win::WaitAnyEventFor(0s, srv->GetServiceStopHandle())) {
-            // use interval wait to time flushes as a fixed cadence
-            waiter.SetInterval(currentInterval);
-            waiter.Wait();
-            // go dormant if there are no active streams left
-            // TODO: GetActiveStreams is not technically thread-safe, reconsider fixing this stuff in Service
-            if (pm->GetActiveStreams() == 0) {
-                pmlog_dbg("ETW flush loop entering dormancy due to 0 active streams");
-                break;
-            }
-            // check to see if manual flush is enabled
-            if (auto flushPeriodMs = pm->GetEtwFlushPeriod()) {
-                // flush events manually to reduce latency
-                pmlog_verb(v::etwq)("Manual ETW flush").pmwatch(*flushPeriodMs);
-                pm->FlushEvents();
-                currentInterval = double(*flushPeriodMs) / 1000.;
+    void SetCpu(pwr::cpu::CpuTelemetry* cpu)
+    {
+        std::lock_guard lk{ mtx_ };
+        cpuTask_ = scheduler_.AddTask("cpu", GetDevicePeriod_(), [cpu] { cpu->Sample(); });
+    }
+    // called once the telemetry container has been populated
+    void SetGpuPopulated()
+    {
+        std::lock_guard lk{ mtx_ };
+        AddGpuTasks_();
+        gpuPopulated_ = true;
+    }
+    // enables the control task, which enables the sampling tasks; only call once a stream is active,
+    // otherwise the first control tick would put telemetry right back into dormancy
+    void Activate()
+    {
+        scheduler_.SetEnabled(controlTask_, true);
+    }
+    // signalled when all tasks have been disabled due to 0 active streams
+    HANDLE GetDormantHandle() const
+    {
+        return dormantEvent_;
+    }
+    void Stop()
+    {
+        scheduler_.Stop();
+    }
+private:
+    // runs on the scheduler thread, so it is serialized with sampling
+    void Control_()
+    {
+        std::lock_guard lk{ mtx_ };
+        // go dormant if there are no active streams left
+        // this is based on the stream count and not on the streaming start event, which can stay signalled
+        // TODO: GetActiveStreams is not technically thread-safe, reconsider fixing this stuff in Service
+        if (pm_->GetActiveStreams() == 0) {
+            pmlog_dbg("Telemetry entering dormancy due to 0 active streams");
+            for (auto id : gpuTasks_) {
+                scheduler_.SetEnabled(id, false);
             }
-            else {
-                pmlog_verb(v::etwq)("Detected disabled ETW flush, using idle poll period");
-                currentInterval = disabledInterval;
+            if (cpuTask_) {
+                scheduler_.SetEnabled(*cpuTask_, false);
             }
+            scheduler_.SetEnabled(flushTask_, false);
+            scheduler_.SetEnabled(controlTask_, false);
+            dormantEvent_.Set();
+            return;
+        }
+        // if device was reset (driver installed etc.) we need to repopulate telemetry
+        // only check after initial population so that the two cannot overlap
+        if (gpuPopulated_ && WaitForSingleObject(srv_->GetResetPowerTelemetryHandle(), 0) == WAIT_OBJECT_0) {
+            BeginRepopulate_();
+        }
+        // every adapter is sampled, clients can stream telemetry of any of them
+        const auto period = GetDevicePeriod_();
+        for (auto id : gpuTasks_) {
+            scheduler_.SetPeriod(id, period);
+            scheduler_.SetEnabled(id, true);
+        }
+        if (cpuTask_) {
+            scheduler_.SetPeriod(*cpuTask_, period);
+            scheduler_.SetEnabled(*cpuTask_, true);
+        }
+        // check to see if manual flush is enabled
+        if (auto flushPeriodMs = pm_->GetEtwFlushPeriod()) {
+            scheduler_.SetPeriod(flushTask_, double(*flushPeriodMs) / 1000.);
+            scheduler_.SetEnabled(flushTask_, true);
+        }
+        else {
+            scheduler_.SetEnabled(flushTask_, false);
         }
     }
-}
+    // repopulation can block for a long time in the vendor libraries, so it is done on its own thread
+    // instead of stalling the cpu and flush tasks; adapter tasks are removed until it completes
+    void BeginRepopulate_()
+    {
+        for (auto id : gpuTasks_) {
+            scheduler_.RemoveTask(id);
+        }
+        gpuTasks_.clear();
+        gpuPopulated_ = false;
+        // previous repopulation has finished (gpuPopulated_ was set), so this join does not block
+        repopulateThread_ = std::jthread{ [this] {
+            pmlog_info("Repopulating GPU telemetry after device reset");
+            // TODO: log error here or inside of repopulate
+            ptc_->Repopulate();
+            // adapter ids are reassigned by the enumeration, tell clients to drop their cached adapter values
+            pComms_->AdvanceAdapterGeneration();
+            std::lock_guard lk{ mtx_ };
+            AddGpuTasks_();
+            gpuPopulated_ = true;
+        } };
+    }
+    void AddGpuTasks_()
+    {
+        gpuTasks_.clear();
+        for (auto& pAdapter : ptc_->GetPowerTelemetryAdapters()) {
+            gpuTasks_.push_back(scheduler_.AddTask(std::format("gpu-{}", gpuTasks_.size()),
+                GetDevicePeriod_(), [pAdapter] { pAdapter->Sample(); }));
+        }
+    }
+    double GetDevicePeriod_() const
+    {
+        // Convert from the ms to seconds as GetTelemetryPeriod returns back
+        // ms and the scheduler expects seconds.
+        // the session exposes a single period for all devices, but each device task carries its own
+        return pm_->GetGpuTelemetryPeriod() / 1000.;
+    }
+    // this is the interval for checking streaming state and picking up period / adapter changes
+    static constexpr double controlInterval_ = 0.05;
+    // flush task period before the first manual flush period is known
+    static constexpr double disabledFlushInterval_ = 0.25;
+    Service* srv_;
+    PresentMon* pm_;
+    PowerTelemetryContainer* ptc_;
+    ipc::ServiceComms* pComms_;
+    // guards device task ids, which are added from the population thread
+    std::mutex mtx_;
+    std::vector<mt::PeriodicScheduler::TaskId> gpuTasks_;
+    std::optional<mt::PeriodicScheduler::TaskId> cpuTask_;
+    mt::PeriodicScheduler::TaskId flushTask_;
+    mt::PeriodicScheduler::TaskId controlTask_;
+    bool gpuPopulated_ = false;
+    win::Event dormantEvent_{ false };
+    mt::PeriodicScheduler scheduler_;
+    // declared after the scheduler so that it is joined before the scheduler is destroyed
+    std::jthread repopulateThread_;
+};
 
-void PowerTelemetryThreadEntry_(Service* const srv, PresentMon* const pm,
-	PowerTelemetryContainer* const ptc, ipc::ServiceComms* const pComms)
+void PowerTelemetryPopulateThreadEntry_(Service* const srv, PowerTelemetryContainer* const ptc,
+    ipc::ServiceComms* const pComms, TelemetryScheduling_* const pScheduling)
 {
-	if (srv == nullptr || pm == nullptr || ptc == nullptr) {
-		// TODO: log error here
-		return;
-	}
+    if (srv == nullptr || ptc == nullptr || pScheduling == nullptr) {
+        pmlog_error();
+        return;
+    }
 
     // we first wait for a client control connection before populating telemetry container
     // after populating, we sample each adapter to gather availability information
     // this is deferred until client connection in order to increase the probability that
     // telemetry metric availability is accurately assessed
-    {
-        const HANDLE events[]{
-              srv->GetClientSessionHandle(),
-              srv->GetServiceStopHandle(),
-        };
-        const auto waitResult = WaitForMultipleObjects((DWORD)std::size(events), events, FALSE, INFINITE);
-        // TODO: check for wait result error
-        // if events[1] was signalled, that means service is stopping so exit thread
-        if ((waitResult - WAIT_OBJECT_0) == 1) {
-            return;
-        }
-        pmon::util::QpcTimer timer;
-        ptc->Repopulate();
-        for (auto& adapter : ptc->GetPowerTelemetryAdapters()) {
-            // sample 2x here as workaround/kludge because Intel provider misreports 1st sample
-            adapter->Sample();
-            adapter->Sample();
-            pComms->RegisterGpuDevice(adapter->GetVendor(), adapter->GetName(), adapter->GetPowerTelemetryCapBits());
-        }
-        pComms->FinalizeGpuDevices();
-        pmlog_info(std::format("Finished populating GPU telemetry introspection, {} seconds elapsed", timer.Mark()));
+    // if event index 1 is signalled that means service is stopping
+    if (*win::WaitAnyEvent(srv->GetClientSessionHandle(), srv->GetServiceStopHandle()) == 1) {
+        return;
     }
-
-	// only start periodic polling when streaming starts
-    // exit polling loop and this thread when service is stopping
-    {
-        IntervalWaiter waiter{ 0.016 };
-        const HANDLE events[]{
-          pm->GetStreamingStartHandle(),
-          srv->GetServiceStopHandle(),
-        };
-        while (1) {
-            auto waitResult = WaitForMultipleObjects((DWORD)std::size(events), events, FALSE, INFINITE);
-            // TODO: check for wait result error
-            // if events[1] was signalled, that means service is stopping so exit thread
-            if ((waitResult - WAIT_OBJECT_0) == 1) {
-                return;
-            }
-            // otherwise we assume streaming has started and we begin the polling loop
-            while (WaitForSingleObject(srv->GetServiceStopHandle(), 0) != WAIT_OBJECT_0) {
-                // if device was reset (driver installed etc.) we need to repopulate telemetry
-                if (WaitForSingleObject(srv->GetResetPowerTelemetryHandle(), 0) == WAIT_OBJECT_0) {
-                    // TODO: log error here or inside of repopulate
-                    ptc->Repopulate();
-                }
-                for (auto& adapter : ptc->GetPowerTelemetryAdapters()) {
-                    adapter->Sample();
-                }
-                // Convert from the ms to seconds as GetTelemetryPeriod returns back
-                // ms and SetInterval expects seconds.
-                waiter.SetInterval(pm->GetGpuTelemetryPeriod()/1000.);
-                waiter.Wait();
-                // go dormant if there are no active streams left
-                // TODO: consider race condition here if client stops and starts streams rapidly
-                if (pm->GetActiveStreams() == 0) {
-                    break;
-                }
-            }
-        }
+    pmon::util::QpcTimer timer;
+    ptc->Repopulate();
+    for (auto& adapter : ptc->GetPowerTelemetryAdapters()) {
+        // sample 2x here as workaround/kludge because Intel provider misreports 1st sample
+        adapter->Sample();
+        adapter->Sample();
+        pComms->RegisterGpuDevice(adapter->GetVendor(), adapter->GetName(), adapter->GetPowerTelemetryCapBits());
     }
+    pComms->FinalizeGpuDevices();
+    pScheduling->SetGpuPopulated();
+    pmlog_info(std::format("Finished populating GPU telemetry introspection, {} seconds elapsed", timer.Mark()));
 }
 
-void CpuTelemetryThreadEntry_(Service* const srv, PresentMon* const pm,
-	pwr::cpu::CpuTelemetry* const cpu)
+void TelemetryControlThreadEntry_(Service* const srv, PresentMon* const pm, TelemetryScheduling_* const pScheduling)
 {
-    IntervalWaiter waiter{ 0.016 };
-	if (srv == nullptr || pm == nullptr) {
-		// TODO: log error on this condition
-		return;
-	}
-
-    const HANDLE events[] {
-        pm->GetStreamingStartHandle(),
-        srv->GetServiceStopHandle(),
-    };
+    constexpr auto staleStartPollInterval = 50ms;
+    if (srv == nullptr || pm == nullptr || pScheduling == nullptr) {
+        pmlog_error();
+        return;
+    }
 
-	while (1) {
-		auto waitResult = WaitForMultipleObjects((DWORD)std::size(events), events, FALSE, INFINITE);
-		auto i = waitResult - WAIT_OBJECT_0;
-		if (i == 1) {
-			return;
-		}
-		while (WaitForSingleObject(srv->GetServiceStopHandle(), 0) != WAIT_OBJECT_0) {
-			cpu->Sample();
-            // Convert from the ms to seconds as GetTelemetryPeriod returns back
-            // ms and SetInterval expects seconds.
-            waiter.SetInterval(pm->GetGpuTelemetryPeriod() / 1000.);
-            waiter.Wait();
-			// Get the number of currently active streams
-			auto num_active_streams = pm->GetActiveStreams();
-			if (num_active_streams == 0) {
-				break;
-			}
-		}
-	}
+    // outer dormant loop waits for either start of streaming or service exit
+    // only start periodic sampling when streaming starts, and exit this thread when service is stopping
+    while (true) {
+        // if event index 0 is signalled that means we are stopping
+        if (*win::WaitAnyEvent(srv->GetServiceStopHandle(), pm->GetStreamingStartHandle()) == 0) {
+            pmlog_dbg("exiting telemetry control thread due to stop handle");
+            return;
+        }
+        // the start event is manual reset and is not reset on every path that ends the last stream, so it
+        // can be signalled with no streams; poll the stream count at the control interval instead of spinning
+        if (pm->GetActiveStreams() == 0) {
+            if (win::WaitAnyEventFor(staleStartPollInterval, srv->GetServiceStopHandle())) {
+                pmlog_dbg("exiting telemetry control thread due to stop handle");
+                return;
+            }
+            continue;
+        }
+        pmlog_dbg("Streaming started, activating telemetry tasks");
+        pScheduling->Activate();
+        // wait for the control task to report that there are no active streams left
+        if (*win::WaitAnyEvent(srv->GetServiceStopHandle(), pScheduling->GetDormantHandle()) == 0) {
+            pmlog_dbg("exiting telemetry control thread due to stop handle");
+            return;
+        }
+    }
 }
 
 
-
 void PresentMonMainThread(Service* const pSvc)
 {
     namespace rn = std::ranges; namespace vi = rn::views;
@@ -197,8 +251,8 @@ void PresentMonMainThread(Service* const pSvc)
     // these thread containers need to be created outside of the try scope
     // so that if an exception happens, it won't block during unwinding,
     // trying to join threads that are waiting for a stop signal
-    std::jthread gpuTelemetryThread;
-    std::jthread cpuTelemetryThread;
+    std::jthread gpuPopulateThread;
+    std::jthread telemetryControlThread;
 
     try {
         // alias for options
@@ -236,6 +290,14 @@ void PresentMonMainThread(Service* const pSvc)
         PresentMon pm;
         PowerTelemetryContainer ptc;
 
+        // telemetry can be recorded to or replayed from files for deterministic benchmarking
+        pwr::PowerTelemetryProviderFactory::Options telemetryOptions{
+            .recordDirectory = opt.telemetryRecordDir.AsOptional(),
+            .replayDirectory = opt.telemetryReplayDir.AsOptional(),
+            .replaySpeed = *opt.telemetryReplaySpeed,
+        };
+        ptc.SetProviderOptions(telemetryOptions);
+
         // create service-side comms object for transmitting introspection data to clients
         std::unique_ptr<ipc::ServiceComms> pComms;
         try {
@@ -255,8 +317,11 @@ void PresentMonMainThread(Service* const pSvc)
         // Start named pipe action RPC server (active threaded)
         auto pActionServer = std::make_unique<ActionServer>(pSvc, &pm, opt.controlPipe.AsOptional());
 
+        // scheduler for all periodic telemetry sampling and etw flushing
+        TelemetryScheduling_ telemetry{ pSvc, &pm, &ptc, pComms.get() };
+
         try {
-            gpuTelemetryThread = std::jthread{ PowerTelemetryThreadEntry_, pSvc, &pm, &ptc, pComms.get() };
+            gpuPopulateThread = std::jthread{ PowerTelemetryPopulateThreadEntry_, pSvc, &ptc, pComms.get(), &telemetry };
         }
         catch (...) {
             LOG(ERROR) << "failed creating gpu(power) telemetry thread" << std::endl;
@@ -265,8 +330,8 @@ void PresentMonMainThread(Service* const pSvc)
         // Create CPU telemetry
         std::shared_ptr<pwr::cpu::CpuTelemetry> cpu;
         try {
-            // Try to use WMI for metrics sampling
-            cpu = std::make_shared<pwr::cpu::wmi::WmiCpu>();
+            // Try to use WMI for metrics sampling (or a recording of it)
+            cpu = pwr::PowerTelemetryProviderFactory::MakeCpu(telemetryOptions);
         }
         catch (const std::runtime_error& e) {
             LOG(ERROR) << "failed creating wmi cpu telemetry thread; Status: " << e.what() << std::endl;
@@ -276,10 +341,10 @@ void PresentMonMainThread(Service* const pSvc)
         }
 
         if (cpu) {
-            cpuTelemetryThread = std::jthread{ CpuTelemetryThreadEntry_, pSvc, &pm, cpu.get() };
             pm.SetCpu(cpu);
             // sample once to populate the cap bits
             cpu->Sample();
+            telemetry.SetCpu(cpu.get());
             // determine vendor based on device name
             const auto vendor = [&] {
                 const auto lowerNameRn = cpu->GetCpuName() | vi::transform(tolower);
@@ -303,14 +368,23 @@ void PresentMonMainThread(Service* const pSvc)
             pComms->RegisterCpuDevice(PM_DEVICE_VENDOR_UNKNOWN, "UNKNOWN_CPU", cpuTelemetryCapBits_);
         }
 
-        // start thread for manual ETW event buffer flushing
-        std::jthread flushThread{ EventFlushThreadEntry_, pSvc, &pm };
+        // start thread that activates telemetry tasks when streaming starts
+        telemetryControlThread = std::jthread{ TelemetryControlThreadEntry_, pSvc, &pm, &telemetry };
 
         while (WaitForSingleObjectEx(pSvc->GetServiceStopHandle(), 0, FALSE) != WAIT_OBJECT_0) {
             pm.CheckTraceSessions();
             SleepEx(1000, (bool)opt.timedStop);
         }
 
+        // stop signal is set so these exit promptly; join them before the telemetry scheduler goes out of scope
+        if (telemetryControlThread.joinable()) {
+            telemetryControlThread.join();
+        }
+        if (gpuPopulateThread.joinable()) {
+            gpuPopulateThread.join();
+        }
+        telemetry.Stop();
+
         // Stop the PresentMon sessions
         pm.StopTraceSessions();
     }
@@ -15,7 +15,7 @@ bool PowerTelemetryContainer::Repopulate() {
 		for (int iVendor = 0; iVendor < int(PM_DEVICE_VENDOR_UNKNOWN); iVendor++) {
 			try {
 				if (auto pProvider = pwr::PowerTelemetryProviderFactory::Make(
-					PM_DEVICE_VENDOR(iVendor))) {
+					PM_DEVICE_VENDOR(iVendor), provider_options_)) {
 					telemetry_providers_.push_back(std::move(pProvider));
 				}
 			}
@@ -10,7 +10,12 @@ class PowerTelemetryContainer {
     return telemetry_adapters_;
   }
   bool Repopulate();
+  // applies to providers created by subsequent calls to Repopulate
+  void SetProviderOptions(pwr::PowerTelemetryProviderFactory::Options options) {
+    provider_options_ = std::move(options);
+  }
  private:
+  pwr::PowerTelemetryProviderFactory::Options provider_options_;
   std::vector<std::unique_ptr<pwr::PowerTelemetryProvider>> telemetry_providers_;
   std::vector<std::shared_ptr<pwr::PowerTelemetryAdapter>> telemetry_adapters_;
 };
\ No newline at end of file
@@ -8,6 +8,12 @@
 #include <shlwapi.h>
 #include <span>
 
+// ETL replay and synthetic load both run through the mock session
+static bool UseMockSession() {
+    auto& opt = clio::Options::Get();
+    return opt.etlTestFile.AsOptional().has_value() || opt.syntheticLoad;
+}
+
 PresentMon::~PresentMon() {
   real_time_session_.CheckTraceSessions(true);
   mock_session_.CheckTraceSessions(true);
@@ -16,9 +22,7 @@ PresentMon::~PresentMon() {
 PM_STATUS PresentMon::StartStreaming(uint32_t client_process_id,
     uint32_t target_process_id,
     std::string& nsm_file_name) {
-    auto& opt = clio::Options::Get();
-
-    if (opt.etlTestFile.AsOptional().has_value()) {
+    if (UseMockSession()) {
         return mock_session_.StartStreaming(client_process_id, target_process_id,
             nsm_file_name);
     }
@@ -32,8 +36,7 @@ PM_STATUS PresentMon::StartStreaming(uint32_t client_process_id,
 
 void PresentMon::StopStreaming(uint32_t client_process_id,
                                uint32_t target_process_id) {
-    auto& opt = clio::Options::Get();
-    if (opt.etlTestFile.AsOptional().has_value()) {
+    if (UseMockSession()) {
         return mock_session_.StopStreaming(client_process_id, target_process_id);
     }
     else
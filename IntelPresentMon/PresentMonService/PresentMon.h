@@ -29,7 +29,12 @@ class PresentMon {
   double GetCpuPowerLimit() { return real_time_session_.GetCpuPowerLimit(); }
 
   PM_STATUS SelectAdapter(uint32_t adapter_id);
-  
+
+  uint32_t GetSelectedAdapter() {
+    // Only the real time trace uses the control libary interface
+    return real_time_session_.GetSelectedAdapter();
+  }
+
   PM_STATUS SetGpuTelemetryPeriod(uint32_t period_ms) {
     // Only the real time trace sets GPU telemetry period
     return real_time_session_.SetGpuTelemetryPeriod(period_ms);
@@ -43,6 +43,10 @@ PM_STATUS PresentMonSession::SelectAdapter(uint32_t adapter_id) {
     return PM_STATUS::PM_STATUS_SUCCESS;
 }
 
+uint32_t PresentMonSession::GetSelectedAdapter() {
+    return current_telemetry_adapter_id_;
+}
+
 // TODO: copied from legacy api header
 // find a better home for these defines, and how to communicate them to app devs
 #define MIN_PM_TELEMETRY_PERIOD 1
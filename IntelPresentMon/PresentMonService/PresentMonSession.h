@@ -25,7 +25,6 @@ struct SwapChainData {
 struct ProcessInfo {
     std::wstring mModuleName;
     std::unordered_map<uint64_t, SwapChainData> mSwapChain;
-    HANDLE mHandle = INVALID_HANDLE_VALUE;
     bool mTargetProcess = false;
 };
 
@@ -49,6 +48,7 @@ public:
     double GetCpuPowerLimit();
 
     PM_STATUS SelectAdapter(uint32_t adapter_id);
+    uint32_t GetSelectedAdapter();
     PM_STATUS SetGpuTelemetryPeriod(uint32_t period_ms);
     PM_STATUS SetEtwFlushPeriod(std::optional<uint32_t> periodMs);
     std::optional<uint32_t> GetEtwFlushPeriod();
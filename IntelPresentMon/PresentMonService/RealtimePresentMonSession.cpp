@@ -17,7 +17,8 @@ static const std::wstring kRealTimeSessionName = L"PMService";
 
 RealtimePresentMonSession::RealtimePresentMonSession()
     : target_process_count_(0),
-    quit_output_thread_(false) {
+    quit_output_thread_(false),
+    process_cache_(&process_query_, uint64_t(1. / util::GetTimestampPeriodSeconds() + 0.5)) {
     pm_session_name_.clear();
     processes_.clear();
     HANDLE temp_handle = CreateEvent(NULL, TRUE, FALSE, NULL);
@@ -48,7 +49,7 @@ PM_STATUS RealtimePresentMonSession::StartStreaming(uint32_t client_process_id,
     }
     else {
         // Add the client process id to be monitored
-        GetProcessInfo(client_process_id);
+        GetProcessInfo(client_process_id, util::GetCurrentTimestamp());
         auto status = StartTraceSession();
         if (status == PM_STATUS_FAILURE) {
             // Unable to start a trace session. Destroy the NSM and
@@ -63,7 +64,7 @@ PM_STATUS RealtimePresentMonSession::StartStreaming(uint32_t client_process_id,
             SetEvent(streaming_started_.get());
         }
         // Also monitor the target process id
-        GetProcessInfo(target_process_id);
+        GetProcessInfo(target_process_id, util::GetCurrentTimestamp());
 
         return PM_STATUS::PM_STATUS_SUCCESS;
     }
@@ -261,7 +262,7 @@ void RealtimePresentMonSession::AddPresents(
         }
 
         // Look up the swapchain this present belongs to.
-        auto processInfo = GetProcessInfo(presentEvent->ProcessId);
+        auto processInfo = GetProcessInfo(presentEvent->ProcessId, presentEvent->PresentStartTime);
         if (!processInfo->mTargetProcess) {
             continue;
         }
@@ -489,6 +490,13 @@ void RealtimePresentMonSession::Output() {
                 // Timer has elapsed so we should do periodic polling operations
                 // Update tracking information.
                 CheckForTerminatedRealtimeProcesses(&terminatedProcesses);
+                // Periodically log consumer handler costs (only available if compiled in)
+                if constexpr (v::etwinst) {
+                    if (timer.Peek() >= 5.) {
+                        timer.Mark();
+                        LogConsumerInstrumentation();
+                    }
+                }
                 // check for quit signal
                 if (quit_output_thread_.load()) {
                     pmlog_dbg("Detected quit signal");
@@ -499,12 +507,7 @@ void RealtimePresentMonSession::Output() {
 
         // Process handles
         std::lock_guard<std::mutex> lock(process_mutex_);
-        for (auto& pair : processes_) {
-            auto processInfo = &pair.second;
-            if (processInfo->mHandle != NULL) {
-                CloseHandle(processInfo->mHandle);
-            }
-        }
+        process_cache_.Clear();
         processes_.clear();
     }
     catch (...) {
@@ -512,6 +515,37 @@ void RealtimePresentMonSession::Output() {
     }
 }
 
+void RealtimePresentMonSession::LogConsumerInstrumentation() {
+    ConsumerInstrumentationSnapshot snapshot;
+    if (!pm_consumer_ || !pm_consumer_->GetInstrumentationSnapshot(&snapshot)) {
+        return;
+    }
+
+    std::string handlers;
+    for (uint32_t i = 0; i < (uint32_t)InstrumentedHandler::Count; ++i) {
+        auto const& h = snapshot.mHandlers[i];
+        if (h.mEventCount > 0) {
+            handlers += std::format(" {}={}/{}/{}", GetInstrumentedHandlerName((InstrumentedHandler)i),
+                h.mEventCount, h.mTotalCycles / h.mEventCount, h.mMaxCycles);
+        }
+    }
+    std::string lost;
+    for (uint32_t i = 0; i < (uint32_t)PresentLostReason::Count; ++i) {
+        lost += std::format(" {}={}", GetPresentLostReasonName((PresentLostReason)i), snapshot.mPresentsLost[i]);
+    }
+    std::string containers;
+    for (uint32_t i = 0; i < (uint32_t)InstrumentedContainer::Count; ++i) {
+        if (snapshot.mContainerSizes[i] > 0) {
+            containers += std::format(" {}={}", GetInstrumentedContainerName((InstrumentedContainer)i), snapshot.mContainerSizes[i]);
+        }
+    }
+
+    pmlog_perf(v::etwinst)(std::format("Consumer handlers (events/avg cycles/max cycles):{}", handlers));
+    pmlog_perf(v::etwinst)(std::format("Consumer presents: created={} completed={} dropped={} lost:{}",
+        snapshot.mPresentsCreated, snapshot.mPresentsCompleted, snapshot.mPresentsDroppedOnOverflow, lost));
+    pmlog_perf(v::etwinst)(std::format("Consumer containers:{}", containers));
+}
+
 void RealtimePresentMonSession::StartOutputThread() {
     quit_output_thread_ = false;
     output_thread_ = std::thread(&RealtimePresentMonSession::Output, this);
@@ -524,37 +558,27 @@ void RealtimePresentMonSession::StopOutputThread() {
     }
 }
 
-ProcessInfo* RealtimePresentMonSession::GetProcessInfo(uint32_t processId) {
+ProcessInfo* RealtimePresentMonSession::GetProcessInfo(uint32_t processId, uint64_t timestamp) {
     std::lock_guard<std::mutex> lock(process_mutex_);
     auto result = processes_.emplace(processId, ProcessInfo());
     auto processInfo = &result.first->second;
     auto newProcess = result.second;
 
     if (newProcess) {
-        // Try to open a limited handle into the process in order to query its
-        // name and also periodically check if it has terminated.  This will
-        // fail (with GetLastError() == ERROR_ACCESS_DENIED) if the process was
-        // run on another account, unless we're running with SeDebugPrivilege.
-        auto pProcessName = L"<error>";
-        wchar_t path[MAX_PATH];
-        const auto handle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
-        if (handle) {
-            auto numChars = (DWORD)std::size(path);
-            if (QueryFullProcessImageNameW(handle, 0, path, &numChars)) {
-                pProcessName = PathFindFileNameW(path);
-            }
-        }
-
-        InitProcessInfo(processInfo, processId, handle, pProcessName);
+        // The cache opens a limited handle into processes it has not seen
+        // start, in order to query the name and also periodically check if it
+        // has terminated.  This will fail (with GetLastError() ==
+        // ERROR_ACCESS_DENIED) if the process was run on another account,
+        // unless we're running with SeDebugPrivilege.
+        auto pProcessName = process_cache_.Lookup(processId, timestamp);
+        InitProcessInfo(processInfo, processId, pProcessName ? *pProcessName : L"<error>");
     }
 
     return processInfo;
 }
 
 void RealtimePresentMonSession::InitProcessInfo(ProcessInfo* processInfo, uint32_t processId,
-    HANDLE handle,
     std::wstring const& processName) {
-    processInfo->mHandle = handle;
     processInfo->mModuleName = processName;
     processInfo->mTargetProcess = true;
 
@@ -569,15 +593,21 @@ void RealtimePresentMonSession::UpdateProcesses(
             // This event is a new process starting, the pid should not already be
             // in processes_.
             std::lock_guard<std::mutex> lock(process_mutex_);
+            process_cache_.OnProcessStart(processEvent.ProcessId, processEvent.QpcTime,
+                processEvent.ImageFileName);
             auto result = processes_.emplace(processEvent.ProcessId, ProcessInfo());
             auto processInfo = &result.first->second;
             auto newProcess = result.second;
             if (newProcess) {
-                InitProcessInfo(processInfo, processEvent.ProcessId, NULL,
+                InitProcessInfo(processInfo, processEvent.ProcessId,
                     processEvent.ImageFileName);
             }
         }
         else {
+            {
+                std::lock_guard<std::mutex> lock(process_mutex_);
+                process_cache_.OnProcessStop(processEvent.ProcessId, processEvent.QpcTime);
+            }
             // Note any process termination in terminatedProcess, to be handled
             // once the present event stream catches up to the termination time.
             terminatedProcesses->emplace_back(processEvent.ProcessId,
@@ -614,27 +644,23 @@ void RealtimePresentMonSession::HandleTerminatedProcess(uint32_t processId) {
 void RealtimePresentMonSession::CheckForTerminatedRealtimeProcesses(
     std::vector<std::pair<uint32_t, uint64_t>>* terminatedProcesses) {
     std::lock_guard<std::mutex> lock(process_mutex_);
-    for (auto& pair : processes_) {
-        auto processId = pair.first;
-        auto processInfo = &pair.second;
-
-        DWORD exitCode = 0;
-        if (processInfo->mHandle != NULL &&
-            GetExitCodeProcess(processInfo->mHandle, &exitCode) &&
-            exitCode != STILL_ACTIVE) {
-            uint64_t qpc = 0;
-            QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&qpc));
-            terminatedProcesses->emplace_back(processId, qpc);
-            CloseHandle(processInfo->mHandle);
-            processInfo->mHandle = NULL;
-            // The tracked process has terminated. As multiple clients could be
-            // tracking this process call stop streaming until the streamer
-            // returns false and no longer holds an NSM for the process.
-            streamer_.StopStreaming(processId);
-            if ((streamer_.NumActiveStreams() == 0) &&
-                (streaming_started_.get() != INVALID_HANDLE_VALUE)) {
-                ResetEvent(streaming_started_.get());
-            }
+    if (process_cache_.GetOpenCount() == 0) {
+        return;
+    }
+
+    uint64_t qpc = 0;
+    QueryPerformanceCounter(reinterpret_cast<LARGE_INTEGER*>(&qpc));
+    std::vector<uint32_t> exitedProcessIds;
+    process_cache_.CollectExited(qpc, &exitedProcessIds);
+    for (auto processId : exitedProcessIds) {
+        terminatedProcesses->emplace_back(processId, qpc);
+        // The tracked process has terminated. As multiple clients could be
+        // tracking this process call stop streaming until the streamer
+        // returns false and no longer holds an NSM for the process.
+        streamer_.StopStreaming(processId);
+        if ((streamer_.NumActiveStreams() == 0) &&
+            (streaming_started_.get() != INVALID_HANDLE_VALUE)) {
+            ResetEvent(streaming_started_.get());
         }
     }
 }
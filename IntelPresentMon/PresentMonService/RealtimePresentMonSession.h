@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MIT
 #pragma once
 #include "PresentMonSession.h"
+#include "../../PresentData/ProcessInfoCache.hpp"
 
 class RealtimePresentMonSession : public PresentMonSession
 {
@@ -43,9 +44,9 @@ private:
     void Consume(TRACEHANDLE traceHandle);
     void Output();
 
-    ProcessInfo* GetProcessInfo(uint32_t processId);
+    ProcessInfo* GetProcessInfo(uint32_t processId, uint64_t timestamp);
     void InitProcessInfo(ProcessInfo* processInfo, uint32_t processId,
-        HANDLE handle, std::wstring const& processName);
+        std::wstring const& processName);
     void UpdateProcesses(
         std::vector<ProcessEvent> const& processEvents,
         std::vector<std::pair<uint32_t, uint64_t>>* terminatedProcesses);
@@ -53,6 +54,7 @@ private:
 
     void CheckForTerminatedRealtimeProcesses(
         std::vector<std::pair<uint32_t, uint64_t>>* terminatedProcesses);
+    void LogConsumerInstrumentation();
 
     // data
     std::wstring pm_session_name_;
@@ -66,6 +68,9 @@ private:
 
     std::unordered_map<uint32_t, ProcessInfo> processes_;
     uint32_t target_process_count_;
+    // Names and lifetimes of processes, guarded by process_mutex_ like processes_
+    WindowsProcessQuery process_query_;
+    ProcessInfoCache process_cache_;
 
     // Event for when streaming has started
     std::unique_ptr<std::remove_pointer_t<HANDLE>, HandleDeleter>
@@ -0,0 +1,205 @@
+// Copyright (C) 2022-2023 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include "SyntheticPresentGenerator.h"
+#include <algorithm>
+#include <format>
+
+static const std::wstring kSyntheticProcessName = L"SyntheticProcess.exe";
+
+SyntheticPresentGenerator::SyntheticPresentGenerator(Params const& params, uint64_t startQpc, uint64_t qpcFrequency)
+    : params_(params),
+    start_qpc_(startQpc),
+    period_qpc_(std::max<uint64_t>(uint64_t(qpcFrequency / std::max(params.fps, 1.)), 10)),
+    lifetime_qpc_(uint64_t(params.processLifetimeSeconds * qpcFrequency)),
+    last_generate_qpc_(startQpc),
+    next_process_id_(params.firstProcessId + std::max(params.processCount, 1u)),
+    started_(false),
+    rng_(params.seed),
+    jitter_distribution_(-std::clamp(params.jitter, 0., 0.9), std::clamp(params.jitter, 0., 0.9)),
+    drop_distribution_(std::clamp(params.dropRatio, 0., 1.)) {
+    params_.processCount = std::max(params_.processCount, 1u);
+    params_.swapChainCount = std::max(params_.swapChainCount, 1u);
+
+    // Stagger process exits so that they don't all churn at once.
+    processes_.reserve(params_.processCount);
+    for (uint32_t i = 0; i < params_.processCount; ++i) {
+        auto exitQpc = UINT64_MAX;
+        if (i > 0 && lifetime_qpc_ > 0) {
+            exitQpc = start_qpc_ + lifetime_qpc_ + lifetime_qpc_ * i / params_.processCount;
+        }
+        processes_.push_back({ params_.firstProcessId + i, exitQpc });
+    }
+
+    // Stagger the first present of each swap chain across one period. The
+    // pointers in schedule_ stay valid since swap_chains_ is never resized.
+    swap_chains_.reserve(size_t(params_.processCount) * params_.swapChainCount);
+    for (uint32_t p = 0; p < params_.processCount; ++p) {
+        for (uint32_t s = 0; s < params_.swapChainCount; ++s) {
+            auto index = uint64_t(swap_chains_.size());
+            swap_chains_.push_back({
+                start_qpc_ + period_qpc_ * index / (uint64_t(params_.processCount) * params_.swapChainCount),
+                0,
+                0x10000 * (index + 1),
+                p,
+            });
+        }
+    }
+    for (auto& chain : swap_chains_) {
+        schedule_.push(&chain);
+    }
+}
+
+void SyntheticPresentGenerator::Generate(uint64_t nowQpc,
+    std::vector<ProcessEvent>* processEvents,
+    std::vector<std::shared_ptr<PresentEvent>>* presentEvents) {
+    auto untilQpc = UINT64_MAX;
+    auto maxPresents = kMaxBatchSize;
+    if (params_.speed > 0.) {
+        untilQpc = start_qpc_ + uint64_t(double(nowQpc - start_qpc_) * params_.speed);
+        maxPresents = SIZE_MAX;
+    }
+    last_generate_qpc_ = nowQpc;
+
+    // The first process is the tracked one, which already exists.
+    if (!started_) {
+        for (size_t i = 1; i < processes_.size(); ++i) {
+            StartProcess(processes_[i], start_qpc_, processEvents);
+        }
+        started_ = true;
+    }
+
+    for (size_t n = 0; n < maxPresents && schedule_.top()->nextPresentQpc <= untilQpc; ++n) {
+        auto chain = schedule_.top();
+        schedule_.pop();
+
+        auto process = &processes_[chain->processSlot];
+        if (chain->nextPresentQpc >= process->exitQpc) {
+            ReplaceProcess(process, processEvents);
+        }
+        presentEvents->push_back(MakePresent(chain));
+
+        schedule_.push(chain);
+    }
+}
+
+uint64_t SyntheticPresentGenerator::GetDueQpc(uint64_t presentStartQpc) const {
+    if (params_.speed > 0.) {
+        return start_qpc_ + uint64_t(double(presentStartQpc - start_qpc_) / params_.speed);
+    }
+    return last_generate_qpc_;
+}
+
+std::shared_ptr<PresentEvent> SyntheticPresentGenerator::MakePresent(SwapChain* chain) {
+    auto t = chain->nextPresentQpc;
+
+    auto present = std::make_shared<PresentEvent>();
+    present->PresentStartTime = t;
+    present->ProcessId = processes_[chain->processSlot].processId;
+    present->SwapChainAddress = chain->address;
+    present->Runtime = Runtime::DXGI;
+    present->PresentMode = PresentMode::Hardware_Independent_Flip;
+    present->SyncInterval = 0;
+    present->TimeInPresent = period_qpc_ / 10;
+    present->GPUStartTime = t + period_qpc_ / 10;
+    present->GPUDuration = period_qpc_ / 2;
+    present->ReadyTime = t + period_qpc_ * 6 / 10;
+    present->IsCompleted = true;
+
+    if (drop_distribution_(rng_)) {
+        present->FinalState = PresentResult::Discarded;
+    } else {
+        // Screen times must increase even when jitter makes presents bunch up.
+        auto screenQpc = std::max(t + period_qpc_, chain->lastScreenQpc + 1);
+        present->FinalState = PresentResult::Presented;
+        present->Displayed.emplace_back(FrameType::Application, screenQpc);
+        chain->lastScreenQpc = screenQpc;
+    }
+
+    auto interval = double(period_qpc_) * (1. + jitter_distribution_(rng_));
+    chain->nextPresentQpc = t + std::max<uint64_t>(uint64_t(interval), 1);
+    return present;
+}
+
+void SyntheticPresentGenerator::StartProcess(Process const& process, uint64_t qpc,
+    std::vector<ProcessEvent>* processEvents) {
+    ProcessEvent startEvent = {};
+    startEvent.ImageFileName = kSyntheticProcessName;
+    startEvent.QpcTime = qpc;
+    startEvent.ProcessId = process.processId;
+    startEvent.IsStartEvent = true;
+    processEvents->push_back(std::move(startEvent));
+}
+
+void SyntheticPresentGenerator::ReplaceProcess(Process* process,
+    std::vector<ProcessEvent>* processEvents) {
+    ProcessEvent stopEvent = {};
+    stopEvent.QpcTime = process->exitQpc;
+    stopEvent.ProcessId = process->processId;
+    stopEvent.IsStartEvent = false;
+    processEvents->push_back(std::move(stopEvent));
+
+    process->processId = next_process_id_++;
+    StartProcess(*process, process->exitQpc, processEvents);
+    process->exitQpc += lifetime_qpc_;
+}
+
+SyntheticLoadStats::SyntheticLoadStats(uint64_t startQpc, uint64_t qpcFrequency, double periodSeconds)
+    : period_start_qpc_(startQpc),
+    period_qpc_(uint64_t(periodSeconds * qpcFrequency)),
+    ms_per_qpc_(1000. / qpcFrequency),
+    buckets_(kBucketCount, 0),
+    count_(0),
+    sum_ms_(0.),
+    max_ms_(0.) {
+}
+
+void SyntheticLoadStats::Add(uint64_t dueQpc, uint64_t writtenQpc) {
+    auto latencyMs = writtenQpc > dueQpc ? double(writtenQpc - dueQpc) * ms_per_qpc_ : 0.;
+    buckets_[std::min(size_t(latencyMs / kBucketMs), kBucketCount - 1)] += 1;
+    count_ += 1;
+    sum_ms_ += latencyMs;
+    max_ms_ = std::max(max_ms_, latencyMs);
+}
+
+std::optional<SyntheticLoadStats::Summary> SyntheticLoadStats::Summarize(uint64_t nowQpc) {
+    if (nowQpc - period_start_qpc_ < period_qpc_) {
+        return std::nullopt;
+    }
+
+    Summary summary = {};
+    summary.count = count_;
+    summary.seconds = double(nowQpc - period_start_qpc_) * ms_per_qpc_ / 1000.;
+    if (count_ > 0) {
+        summary.avgMs = sum_ms_ / count_;
+        summary.maxMs = max_ms_;
+
+        // The latency that count * 99 / 100 latencies are below.
+        auto rank = count_ * 99 / 100 + 1;
+        uint64_t below = 0;
+        size_t bucket = 0;
+        for (; bucket < kBucketCount - 1; ++bucket) {
+            below += buckets_[bucket];
+            if (below >= rank) {
+                break;
+            }
+        }
+        summary.p99Ms = bucket == kBucketCount - 1 ? max_ms_ : std::min(double(bucket + 1) * kBucketMs, max_ms_);
+    }
+
+    std::fill(buckets_.begin(), buckets_.end(), 0);
+    count_ = 0;
+    sum_ms_ = 0.;
+    max_ms_ = 0.;
+    period_start_qpc_ = nowQpc;
+    return summary;
+}
+
+std::optional<std::string> SyntheticLoadStats::Report(uint64_t nowQpc) {
+    auto summary = Summarize(nowQpc);
+    if (!summary) {
+        return std::nullopt;
+    }
+    return std::format("Synthetic load: {} presents in {:.2f}s ({:.0f}/s), latency to streamer "
+        "avg {:.3f}ms, p99 {:.3f}ms, max {:.3f}ms", summary->count, summary->seconds,
+        summary->count / summary->seconds, summary->avgMs, summary->p99Ms, summary->maxMs);
+}
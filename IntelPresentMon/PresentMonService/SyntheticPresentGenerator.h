@@ -0,0 +1,127 @@
+// Copyright (C) 2022-2023 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+#include "../../PresentData/PresentMonTraceConsumer.hpp"
+
+// Generates present and process events in place of an ETW trace so that the
+// streamer, middleware and clients can be stress tested at production frame
+// rates without a graphics workload.
+//
+// Each synthetic process presents on one or more swap chains at the configured
+// rate. Presents are timestamped in synthetic time, which advances with the
+// wall clock at the configured speed (or, at speed 0, as fast as presents can be
+// generated). Processes other than the first one get a start event before their
+// first present, exit after the configured lifetime and are replaced by a new
+// process with a new id; the first one keeps the tracked process id and never
+// exits so that its stream stays open.
+class SyntheticPresentGenerator
+{
+public:
+    struct Params {
+        uint32_t firstProcessId = 0;
+        uint32_t processCount = 1;
+        uint32_t swapChainCount = 1;        // per process
+        double fps = 1000.;                 // per swap chain
+        double jitter = 0.;                 // random variation of the present interval, as a fraction of it (at most 0.9)
+        double dropRatio = 0.;              // fraction of presents that are discarded instead of displayed
+        double processLifetimeSeconds = 0.; // 0: processes never exit
+        double speed = 1.;                  // synthetic seconds per wall clock second; 0: as fast as possible
+        uint32_t seed = 0;
+    };
+
+    SyntheticPresentGenerator(Params const& params, uint64_t startQpc, uint64_t qpcFrequency);
+
+    // Appends every event that is due by the wall clock time nowQpc, in time order.
+    // At speed 0, appends the next kMaxBatchSize presents instead.
+    void Generate(uint64_t nowQpc,
+        std::vector<ProcessEvent>* processEvents,
+        std::vector<std::shared_ptr<PresentEvent>>* presentEvents);
+
+    // Wall clock time at which the present that started at the synthetic time
+    // presentStartQpc became due. At speed 0, this is when it was generated.
+    uint64_t GetDueQpc(uint64_t presentStartQpc) const;
+    uint64_t GetStartQpc() const { return start_qpc_; }
+
+    static constexpr size_t kMaxBatchSize = 10'000;
+
+private:
+    struct SwapChain {
+        uint64_t nextPresentQpc;
+        uint64_t lastScreenQpc;
+        uint64_t address;
+        uint32_t processSlot;
+    };
+    struct Process {
+        uint32_t processId;
+        uint64_t exitQpc; // UINT64_MAX if the process never exits
+    };
+    struct LaterPresent {
+        bool operator()(SwapChain const* a, SwapChain const* b) const {
+            return a->nextPresentQpc > b->nextPresentQpc;
+        }
+    };
+
+    std::shared_ptr<PresentEvent> MakePresent(SwapChain* chain);
+    void StartProcess(Process const& process, uint64_t qpc, std::vector<ProcessEvent>* processEvents);
+    void ReplaceProcess(Process* process, std::vector<ProcessEvent>* processEvents);
+
+    Params params_;
+    uint64_t start_qpc_;
+    uint64_t period_qpc_;
+    uint64_t lifetime_qpc_;
+    uint64_t last_generate_qpc_; // wall clock time of the last Generate() call
+    uint32_t next_process_id_;
+    bool started_;               // whether the start events of the initial processes were generated
+    std::vector<Process> processes_;
+    std::vector<SwapChain> swap_chains_;
+    std::priority_queue<SwapChain*, std::vector<SwapChain*>, LaterPresent> schedule_;
+    std::mt19937 rng_;
+    std::uniform_real_distribution<double> jitter_distribution_;
+    std::bernoulli_distribution drop_distribution_;
+};
+
+// Accumulates how long generated presents took to reach the streamer after they
+// became due, and summarizes throughput and latency once per reporting period.
+//
+// Latencies are counted in a fixed histogram so that memory use doesn't depend
+// on the present rate; the p99 is the upper edge of the bucket it falls in, and
+// latencies past the last bucket are only accounted for by the max.
+class SyntheticLoadStats
+{
+public:
+    struct Summary {
+        uint64_t count;
+        double seconds;
+        double avgMs;
+        double p99Ms;
+        double maxMs;
+    };
+
+    SyntheticLoadStats(uint64_t startQpc, uint64_t qpcFrequency, double periodSeconds);
+
+    void Add(uint64_t dueQpc, uint64_t writtenQpc);
+    // Returns a summary of the current period and starts a new one, once the
+    // current period has elapsed.
+    std::optional<Summary> Summarize(uint64_t nowQpc);
+    // Summarize(), formatted for the log.
+    std::optional<std::string> Report(uint64_t nowQpc);
+
+    static constexpr double kBucketMs = 0.01;
+    static constexpr size_t kBucketCount = 10'000;
+
+private:
+    uint64_t period_start_qpc_;
+    uint64_t period_qpc_;
+    double ms_per_qpc_;
+    std::vector<uint64_t> buckets_; // kBucketCount buckets of kBucketMs, the last one also holds everything above
+    uint64_t count_;
+    double sum_ms_;
+    double max_ms_;
+};
@@ -0,0 +1,40 @@
+#pragma once
+#include "../../Interprocess/source/act/ActionHelper.h"
+#include "../../Interprocess/source/act/AsyncActionCollection.h"
+#include <format>
+
+#define ACT_NAME Batch
+#define ACT_EXEC_CTX ActionExecutionContext
+#define ACT_NS ::pmon::svc::acts
+#define ACT_TYPE AsyncActionBase_
+
+namespace pmon::svc::acts
+{
+	using namespace ipc::act;
+
+	class ACT_NAME : public ACT_TYPE<ACT_NAME, ACT_EXEC_CTX>
+	{
+	public:
+		static constexpr const char* Identifier = BatchEnvelope::Identifier;
+		using Params = BatchEnvelope::Params;
+		using Response = BatchEnvelope::Response;
+	private:
+		friend class ACT_TYPE<ACT_NAME, ACT_EXEC_CTX>;
+		static Response Execute_(ACT_EXEC_CTX& ctx, SessionContext& stx, Params&& in)
+		{
+			pmlog_dbg(std::format("Batch action from [{}] with {} requests", stx.remotePid, in.requests.size()));
+			return ExecuteBatch(ctx, stx, in);
+		}
+	};
+
+#ifdef PM_ASYNC_ACTION_REGISTRATION_
+	ACTION_REG();
+#endif
+}
+
+ACTION_TRAITS_DEF();
+
+#undef ACT_NAME
+#undef ACT_EXEC_CTX
+#undef ACT_NS
+#undef ACT_TYPE
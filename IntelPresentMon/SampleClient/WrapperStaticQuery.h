@@ -41,22 +41,31 @@ int WrapperStaticQuerySample(std::unique_ptr<pmapi::Session>&& pSession)
 
             std::cout << "Polling data iteration [" << i << "]...\n";
 
+            // several static metrics can be polled with a single call, results are in element order
+            PM_QUERY_ELEMENT elements[]{
+                { .metric = PM_METRIC_APPLICATION, .stat = PM_STAT_NONE, .deviceId = 0 },
+                { .metric = PM_METRIC_GPU_MEM_SIZE, .stat = PM_STAT_NONE, .deviceId = 1 },
+                { .metric = PM_METRIC_GPU_VENDOR, .stat = PM_STAT_NONE, .deviceId = 1 },
+                { .metric = PM_METRIC_GPU_NAME, .stat = PM_STAT_NONE, .deviceId = 1 },
+            };
+            const auto results = pmapi::PollStatic(*pSession, processTracker, elements);
+
             // poll result can be directly assigned to compatible datatypes and will be intelligently
             // converted based on the static type of the left-hand side and introspection of metric
             const StaticInfo info{
                 // string data is assignable to either std::string or wstring
-                .appName = pmapi::PollStatic(*pSession, processTracker, PM_METRIC_APPLICATION),
+                .appName = results[0],
                 // MEM_SIZE is natively uint64_t, assignment to original type always supported
-                .maxMemoryUint64 = pmapi::PollStatic(*pSession, processTracker, PM_METRIC_GPU_MEM_SIZE, 1),
+                .maxMemoryUint64 = results[1],
                 // numeric data is assignable to any numeric type,
                 // blob will be interpreted with correct type then converted to destination type
-                .maxMemoryDouble = pmapi::PollStatic(*pSession, processTracker, PM_METRIC_GPU_MEM_SIZE, 1),
+                .maxMemoryDouble = results[1],
                 // enumerations can be assigned to strings to perform auto-lookup of string metadata
-                .gpuVendorString = pmapi::PollStatic(*pSession, processTracker, PM_METRIC_GPU_VENDOR, 1),
+                .gpuVendorString = results[2],
                 // or assigned to their actual enum type
-                .gpuVendorEnum = pmapi::PollStatic(*pSession, processTracker, PM_METRIC_GPU_VENDOR, 1),
+                .gpuVendorEnum = results[2],
                 // or to an int to get the backing value
-                .gpuVendorInt = pmapi::PollStatic(*pSession, processTracker, PM_METRIC_GPU_VENDOR, 1),
+                .gpuVendorInt = results[2],
             };
 
             std::cout << "\nApp Name: " << info.appName
@@ -66,7 +75,7 @@ int WrapperStaticQuerySample(std::unique_ptr<pmapi::Session>&& pSession)
                 << "\nGPU Vendor as PM_DEVICE_VENDOR: " << (int)info.gpuVendorEnum
                 << "\nGPU Vendor as int: " << info.gpuVendorInt
                 // when the left-hand side conversion is ambiguous, you can explicitly force it with As<T>()
-                << "\nGPU Name: " << pmapi::PollStatic(*pSession, processTracker, PM_METRIC_GPU_NAME, 1).As<std::string>();
+                << "\nGPU Name: " << results[3].As<std::string>();
 
             std::cout << "\n\nSleeping for 1 second...\n==============================" << std::endl;
             std::this_thread::sleep_for(1s);
@@ -0,0 +1,152 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <stdint.h>
+
+// Finds the frames that precede a consumed frame in the shared memory ring: the
+// last presented frame (the one immediately before it), the last displayed frame
+// (the closest earlier frame whose FinalState is Presented), and the frame
+// before the last displayed one.
+//
+// Walk() searches backward from the consumed frame until it finds them, which
+// is O(n) in the length of a run of dropped frames.  Advance() returns the same
+// result in constant time when frames are consumed in order, by remembering the
+// last displayed frame it has consumed and only walking again when the cursor
+// was invalidated, the consumed frame does not follow the previous one, or the
+// ring has filled up or stopped being full.
+//
+// Both follow the same ring semantics: the walk wraps from index 0 to the last
+// written index, and stops (without reading) at head_idx for realtime streams
+// or tail_idx for streams from an ETL file.  A remembered frame is only
+// reported while the walk could still reach it, so frames that the service has
+// overwritten since they were consumed are never returned.  Advance() also
+// reads each frame it reports, and like the walk stops at the first one that
+// cannot be read.
+//
+// This header has no Windows dependencies so that it can be tested standalone.
+class PreviousFramesCursor {
+ public:
+  static constexpr uint64_t kInvalidIdx = UINT64_MAX;
+
+  struct Ring {
+    uint64_t head_idx;
+    uint64_t tail_idx;
+    uint64_t max_entries;
+    bool is_full;
+    bool from_etl_file;
+  };
+
+  struct Result {
+    uint64_t last_presented_idx = kInvalidIdx;
+    uint64_t last_displayed_idx = kInvalidIdx;
+    uint64_t previous_of_last_displayed_idx = kInvalidIdx;
+  };
+
+  void Invalidate() { valid_ = false; }
+
+  // read_frame(idx, &presented) returns false if the frame at idx cannot be
+  // read, otherwise sets presented to whether its FinalState is Presented.
+  template <typename ReadFrame>
+  static Result Walk(Ring const& ring, uint64_t frame_idx, ReadFrame&& read_frame) {
+    Result result;
+    auto stop_idx = StopIdx(ring);
+    auto idx = frame_idx;
+    if (idx == stop_idx) {
+      return result;
+    }
+    for (uint64_t distance = 1;; ++distance) {
+      idx = PrevIdx(ring, idx);
+      if (idx == stop_idx) {
+        return result;
+      }
+      bool presented = false;
+      if (!read_frame(idx, &presented)) {
+        return result;
+      }
+      if (distance == 1) {
+        result.last_presented_idx = idx;
+      }
+      if (result.last_displayed_idx == kInvalidIdx) {
+        if (presented) {
+          result.last_displayed_idx = idx;
+        }
+      } else {
+        result.previous_of_last_displayed_idx = idx;
+        return result;
+      }
+    }
+  }
+
+  // Returns the previous frames of frame_idx, which is being consumed, and
+  // advances the cursor past it.
+  template <typename ReadFrame>
+  Result Advance(Ring const& ring, uint64_t frame_idx, ReadFrame&& read_frame) {
+    Result result;
+    bool presented = false;
+    if (valid_ && (current_idx_ + 1) % ring.max_entries == frame_idx &&
+        ring.is_full == was_full_) {
+      auto stop_distance = Distance(ring, frame_idx, StopIdx(ring));
+      // Once the remembered frame falls out of reach (or its slot comes around
+      // again after a long run of dropped frames) it has been overwritten, and
+      // no earlier frame can be reached either.
+      auto displayed_distance = uint64_t(0);
+      if (last_displayed_idx_ != kInvalidIdx) {
+        displayed_distance = last_displayed_idx_ <= LastIdx(ring)
+                                 ? Distance(ring, frame_idx, last_displayed_idx_)
+                                 : 0;
+        if (displayed_distance == 0 || displayed_distance >= stop_distance) {
+          last_displayed_idx_ = kInvalidIdx;
+          displayed_distance = 0;
+        }
+      }
+      if (stop_distance > 1 && read_frame(PrevIdx(ring, frame_idx), &presented)) {
+        result.last_presented_idx = PrevIdx(ring, frame_idx);
+        if (displayed_distance > 0 && read_frame(last_displayed_idx_, &presented)) {
+          result.last_displayed_idx = last_displayed_idx_;
+          if (displayed_distance + 1 < stop_distance &&
+              read_frame(PrevIdx(ring, last_displayed_idx_), &presented)) {
+            result.previous_of_last_displayed_idx = PrevIdx(ring, last_displayed_idx_);
+          }
+        }
+      }
+    } else {
+      result = Walk(ring, frame_idx, read_frame);
+      last_displayed_idx_ = result.last_displayed_idx;
+      // While the ring isn't full, the walk wraps from index 0 straight to
+      // tail_idx, and frames above tail_idx can't be read.  Once it fills
+      // (an ETL stream's consumer pops frames, so this can happen repeatedly)
+      // the walk can reach frames that were out of reach before, which is why
+      // a change in fullness walks again.  If the consumed frame is itself
+      // above tail_idx, the walk is cut short right away, so don't seed from it.
+      valid_ = ring.is_full || frame_idx <= ring.tail_idx;
+    }
+    was_full_ = ring.is_full;
+
+    if (read_frame(frame_idx, &presented) && presented) {
+      last_displayed_idx_ = frame_idx;
+    }
+    current_idx_ = frame_idx;
+    return result;
+  }
+
+ private:
+  static uint64_t StopIdx(Ring const& ring) {
+    return ring.from_etl_file ? ring.tail_idx : ring.head_idx;
+  }
+  static uint64_t LastIdx(Ring const& ring) {
+    return ring.is_full ? ring.max_entries - 1 : ring.tail_idx;
+  }
+  static uint64_t PrevIdx(Ring const& ring, uint64_t idx) {
+    return idx == 0 ? LastIdx(ring) : idx - 1;
+  }
+  // Number of PrevIdx() steps from from_idx back to to_idx.
+  static uint64_t Distance(Ring const& ring, uint64_t from_idx, uint64_t to_idx) {
+    auto count = LastIdx(ring) + 1;
+    return (from_idx + count - to_idx) % count;
+  }
+
+  bool valid_ = false;
+  bool was_full_ = false;
+  uint64_t current_idx_ = 0;
+  uint64_t last_displayed_idx_ = kInvalidIdx;
+};
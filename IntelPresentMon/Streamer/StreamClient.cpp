@@ -145,59 +145,34 @@ void StreamClient::PeekPreviousFrames(const PmNsmFrameData** pFrameDataOfLastPre
             return;
         }
 
-        uint64_t current_max_entries =
-            (nsm_view->IsFull()) ? nsm_hdr->max_entries - 1 : nsm_hdr->tail_idx;
+        // Nothing is reported unless the frame at next_dequeue_idx_ can be read.  The cursor
+        // doesn't see the consumed frame then, so it must walk again for the next one.
+        if (ReadFrameByIdx(next_dequeue_idx_) == nullptr) {
+            previous_frames_cursor_.Invalidate();
+            return;
+        }
 
-        uint64_t peekIndex{ next_dequeue_idx_ };
-        auto pTempFrameData = ReadFrameByIdx(peekIndex);
-        uint32_t numFramesTraversed = 0;
-        while (pTempFrameData)
-        {
-            if (nsm_hdr->from_etl_file) {
-                peekIndex = (peekIndex == 0) ? current_max_entries : peekIndex - 1;
-                if (peekIndex == nsm_hdr->tail_idx) {
-                    return;
-                }
-            }
-            else {
-                peekIndex = (peekIndex == 0) ? current_max_entries : peekIndex - 1;
-                if (peekIndex == nsm_hdr->head_idx) {
-                    return;
-                }
-            }
-            numFramesTraversed++;
-            auto pTempFrameData = ReadFrameByIdx(peekIndex);
-            // We need to traverse back two frames from the next_dequeue_idx to
-            // get to the start of the previous frames
-            if (numFramesTraversed > 1) {
-                if (pTempFrameData) {
-                    if (numFramesTraversed == 2) {
-                        // If we made it here we were able to go back two frames
-                        // from the current next_deque_index. This is the frame
-                        // data of the last presented frame before the current frame.
-                        *pFrameDataOfLastPresented = pTempFrameData;
-                    }
-                    if (*pFrameDataOfLastDisplayed == nullptr) {
-                        // If we haven't found the last displayed frame check to see if
-                        // the current one is presented. This could point to the same frame
-                        // as the last presented one above.
-                        if (pTempFrameData->present_event.FinalState == PresentResult::Presented) {
-                            *pFrameDataOfLastDisplayed = pTempFrameData;
-                        }
-                    }
-                    else {
-                        // If we have set the last displayed from then we grab the previous frame
-                        // before it to be able to calculate the CPU Start QPC for it.
-                        *pPreviousFrameDataOfLastDisplayed = pTempFrameData;
-                        return;
-                    }
-                }
-                else {
-                    // The read frame data is null.
-                    // TODO log this as the index is supposed to be valid!
-                    return;
-                }
+        PreviousFramesCursor::Ring ring{ nsm_hdr->head_idx, nsm_hdr->tail_idx, nsm_hdr->max_entries,
+                                         nsm_view->IsFull(), nsm_hdr->from_etl_file };
+        // next_dequeue_idx_ has already been advanced past the frame being consumed.
+        uint64_t frameIdx = (next_dequeue_idx_ == 0) ? nsm_hdr->max_entries - 1 : next_dequeue_idx_ - 1;
+        auto result = previous_frames_cursor_.Advance(ring, frameIdx, [this](uint64_t idx, bool* presented) {
+            auto pFrameData = ReadFrameByIdx(idx);
+            if (pFrameData == nullptr) {
+                return false;
             }
+            *presented = pFrameData->present_event.FinalState == PresentResult::Presented;
+            return true;
+        });
+
+        if (result.last_presented_idx != PreviousFramesCursor::kInvalidIdx) {
+            *pFrameDataOfLastPresented = ReadFrameByIdx(result.last_presented_idx);
+        }
+        if (result.last_displayed_idx != PreviousFramesCursor::kInvalidIdx) {
+            *pFrameDataOfLastDisplayed = ReadFrameByIdx(result.last_displayed_idx);
+        }
+        if (result.previous_of_last_displayed_idx != PreviousFramesCursor::kInvalidIdx) {
+            *pPreviousFrameDataOfLastDisplayed = ReadFrameByIdx(result.previous_of_last_displayed_idx);
         }
     }
     return;
@@ -236,6 +211,7 @@ PM_STATUS StreamClient::ConsumePtrToNextNsmFrameData(const PmNsmFrameData** pNsm
         // dequeue frame number. This will be used to track data overruns if
         // the client does not read data fast enough.
         recording_frame_data_ = true;
+        previous_frames_cursor_.Invalidate();
         if (nsm_hdr->from_etl_file) {
             current_dequeue_frame_num_ = nsm_hdr->head_idx;
             next_dequeue_idx_ = nsm_hdr->head_idx;
@@ -8,6 +8,7 @@
 #include "../PresentMonUtils/StreamFormat.h"
 #include "../PresentMonUtils/LegacyAPIDefines.h"
 #include "NamedSharedMemory.h"
+#include "PreviousFramesCursor.h"
 
 class StreamClient {
  public:
@@ -62,4 +63,7 @@ class StreamClient {
   bool recording_frame_data_;
   uint64_t current_dequeue_frame_num_;
   bool is_etl_stream_client_;
+  // Tracks the last presented/displayed frames behind next_dequeue_idx_ so
+  // PeekPreviousFrames() doesn't need to walk back through dropped frames.
+  PreviousFramesCursor previous_frames_cursor_;
 };
\ No newline at end of file
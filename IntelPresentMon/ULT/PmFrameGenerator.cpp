@@ -519,13 +519,15 @@ void PmFrameGenerator::GeneratePresentData() {
       pmft_frames_[i].dropped = false;
       pmft_frames_[i].ms_until_displayed = GetAlteredTimingValue(
           until_displayed_ms_, until_displayed_variation_ms_);
-      frames_[i].present_event.ScreenTime = SecondsDeltaToQpc(
+      frames_[i].present_event.Displayed_ScreenTime[0] = SecondsDeltaToQpc(
           pmft_frames_[i].ms_until_displayed / 1000., qpc_frequency_);
-      frames_[i].present_event.ScreenTime +=
+      frames_[i].present_event.Displayed_ScreenTime[0] +=
           frames_[i].present_event.PresentStartTime;
+      frames_[i].present_event.Displayed_FrameType[0] = FrameType::Application;
+      frames_[i].present_event.DisplayedCount = 1;
       if (last_displayed_screen_time != 0) {
         pmft_frames_[i].ms_between_display_change = QpcDeltaToMs(
-            frames_[i].present_event.ScreenTime - last_displayed_screen_time,
+            frames_[i].present_event.Displayed_ScreenTime[0] - last_displayed_screen_time,
             qpc_frequency_);
         frames_[i].present_event.last_displayed_qpc =
             last_displayed_screen_time;
@@ -534,12 +536,12 @@ void PmFrameGenerator::GeneratePresentData() {
         pmft_frames_[i].ms_between_display_change = 0.;
         frames_[i].present_event.last_displayed_qpc = 0;
       }
-      last_displayed_screen_time = frames_[i].present_event.ScreenTime;
+      last_displayed_screen_time = frames_[i].present_event.Displayed_ScreenTime[0];
     } else {
       pmft_frames_[i].ms_until_displayed = 0;
       pmft_frames_[i].ms_between_display_change = 0.;
       pmft_frames_[i].dropped = true;
-      frames_[i].present_event.ScreenTime = 0;
+      frames_[i].present_event.DisplayedCount = 0;
     }
 
     // Internal frame data fields; Remove for public build
@@ -644,600 +646,3 @@ void PmFrameGenerator::GenerateCPUData() {
         cpu_frequency_mhz_, cpu_frequency_variation_mhz_);
   }
 }
-
-void PmFrameGenerator::CalcMetricStats(std::vector<double>& data,
-                                       PM_METRIC_DOUBLE_DATA& metric,
-                                       bool valid) {
-  if (data.size() > 1) {
-    // Before sorting, grab the raw data.
-    size_t middle_index = data.size() / 2;
-    metric.raw = data[middle_index];
-    std::sort(data.begin(), data.end());
-    metric.low = data[0];
-    metric.high = data[data.size() - 1];
-
-    int window_size = (int)data.size();
-    auto sum = std::accumulate(data.begin(), data.end(), 0.);
-    if (sum != 0) {
-      metric.avg = sum / window_size;
-    }
-
-    metric.percentile_90 = GetPercentile(data, 0.1);
-    metric.percentile_95 = GetPercentile(data, 0.05);
-    metric.percentile_99 = GetPercentile(data, 0.01);
-  } else if (data.size() == 1) {
-    metric.low = data[0];
-    metric.high = data[0];
-    metric.avg = data[0];
-    metric.percentile_90 = data[0];
-    metric.percentile_95 = data[0];
-    metric.percentile_99 = data[0];
-  } else {
-    metric.low = 0.;
-    metric.high = 0.;
-    metric.avg = 0.;
-    metric.percentile_90 = 0.;
-    metric.percentile_95 = 0.;
-    metric.percentile_99 = 0.;
-  }
-  metric.valid = valid;
-  return;
-}
-
-// Calculate percentile using linear interpolation between the closet ranks
-// method
-double PmFrameGenerator::GetPercentile(std::vector<double>& data,
-                                       double percentile) {
-  double integral_part_as_double;
-  double fractpart =
-      modf(((percentile * (static_cast<double>(data.size() - 1))) + 1),
-           &integral_part_as_double);
-
-  // Subtract off one from the integral_part as we are zero based and the
-  // calculation above is based one based
-  uint32_t integral_part = static_cast<uint32_t>(integral_part_as_double) - 1;
-  uint32_t next_idx = integral_part + 1;
-  // Before we access the vector data ensure that our calculated index values
-  // are not out of range
-  if (integral_part < data.size() || next_idx < data.size()) {
-    return data[integral_part] +
-           (fractpart * (data[next_idx] - data[integral_part]));
-  } else {
-    return 0.0f;
-  }
-}
-
-bool PmFrameGenerator::CalculateFpsMetrics(
-    uint32_t start_frame, double window_size_in_ms,
-    std::vector<PM_FPS_DATA>& fps_metrics) {
-  std::unordered_map<uint64_t, fps_swap_chain_data> swap_chain_data;
-  if (start_frame > pmft_frames_.size()) {
-    return false;
-  }
-
-  // Get the qpc for the start frame
-  uint64_t start_frame_qpc = pmft_frames_[start_frame].qpc_time;
-
-  // Calculate number of ticks based on the passed in window size
-  uint64_t window_size_in_ticks =
-      SecondsDeltaToQpc(window_size_in_ms / 1000., qpc_frequency_);
-  uint64_t calculated_end_frame_qpc = start_frame_qpc - window_size_in_ticks;
-
-  for (uint32_t current_frame_number = start_frame; current_frame_number > 0;
-       current_frame_number--) {
-    auto result = swap_chain_data.emplace(
-        pmft_frames_[current_frame_number].swap_chain, fps_swap_chain_data());
-    auto swap_chain = &result.first->second;
-    if (result.second) {
-      swap_chain->num_presents = 1;
-      // TODO Need to define sync interval in pmft structure
-      // swap_chain->sync_interval
-      swap_chain->present_mode =
-          pmft_frames_[current_frame_number].present_mode;
-      swap_chain->gpu_sum_ms.push_back(
-          pmft_frames_[current_frame_number].ms_gpu_active);
-      swap_chain->time_in_s = 0.;
-      swap_chain->cpu_n_time =
-          pmft_frames_[current_frame_number].time_in_seconds;
-      swap_chain->cpu_0_time = swap_chain->cpu_n_time;
-      if (pmft_frames_[current_frame_number].dropped == false) {
-        swap_chain->mLastDisplayedScreenTime =
-            pmft_frames_[current_frame_number].time_in_seconds +
-            (pmft_frames_[current_frame_number].ms_until_displayed / 1000.);
-        swap_chain->display_0_screen_time = swap_chain->mLastDisplayedScreenTime;
-        swap_chain->dropped.push_back(0);
-      } else {
-        swap_chain->dropped.push_back(1);
-      }
-    } else {
-      if (pmft_frames_[current_frame_number].qpc_time >
-          calculated_end_frame_qpc) {
-        swap_chain->num_presents++;
-        swap_chain->present_mode =
-            pmft_frames_[current_frame_number].present_mode;
-        swap_chain->gpu_sum_ms.push_back(
-            pmft_frames_[current_frame_number].ms_gpu_active);
-        swap_chain->time_in_s =
-            swap_chain->cpu_0_time -
-            pmft_frames_[current_frame_number].time_in_seconds;
-        swap_chain->cpu_0_time =
-            pmft_frames_[current_frame_number].time_in_seconds;
-        if (swap_chain->time_in_s != 0.) {
-          // Convert to ms and store frametime
-          swap_chain->frame_times_ms.push_back(swap_chain->time_in_s * 1000.);
-          swap_chain->presented_fps.push_back(1. / swap_chain->time_in_s);
-        }
-        if (pmft_frames_[current_frame_number].dropped == false) {
-          auto current_display_screen_time_s =
-              pmft_frames_[current_frame_number].time_in_seconds +
-              (pmft_frames_[current_frame_number].ms_until_displayed / 1000.);
-          if (swap_chain->display_0_screen_time != 0.) {
-            swap_chain->display_fps.push_back(
-                1. / (swap_chain->display_0_screen_time -
-                      current_display_screen_time_s));
-          } else {
-            swap_chain->mLastDisplayedScreenTime = current_display_screen_time_s;
-          }
-          swap_chain->display_0_screen_time = current_display_screen_time_s;
-          swap_chain->dropped.push_back(0);
-        } else {
-          swap_chain->dropped.push_back(1);
-        }
-      } else {
-        break;
-      }
-    }
-  }
-
-  fps_metrics.clear();
-  PM_FPS_DATA temp_fps_data{};
-  for (auto pair : swap_chain_data) {
-    temp_fps_data.swap_chain = pair.first;
-    auto swap_chain = pair.second;
-    CalcMetricStats(swap_chain.display_fps, temp_fps_data.displayed_fps);
-    CalcMetricStats(swap_chain.presented_fps, temp_fps_data.presented_fps);
-    CalcMetricStats(swap_chain.frame_times_ms, temp_fps_data.frame_time_ms);
-    CalcMetricStats(swap_chain.gpu_sum_ms, temp_fps_data.gpu_busy);
-    // Overwrite the average both the display and cpu average fps.
-    auto avg_fps =
-        swap_chain.mLastDisplayedScreenTime - swap_chain.display_0_screen_time;
-    avg_fps /= swap_chain.display_fps.size();
-    avg_fps = 1. / avg_fps;
-    temp_fps_data.displayed_fps.avg = avg_fps;
-    avg_fps = swap_chain.cpu_n_time - swap_chain.cpu_0_time;
-    avg_fps /= swap_chain.presented_fps.size();
-    avg_fps = 1. / avg_fps;
-    temp_fps_data.presented_fps.avg = avg_fps;
-    temp_fps_data.present_mode = swap_chain.present_mode;
-    temp_fps_data.num_presents = swap_chain.num_presents;
-    temp_fps_data.sync_interval = swap_chain.sync_interval;
-    CalcMetricStats(swap_chain.dropped, temp_fps_data.percent_dropped_frames);
-    temp_fps_data.percent_dropped_frames.avg *= 100.;
-
-    fps_metrics.emplace_back(temp_fps_data);
-    temp_fps_data = {};
-  }
-  return true;
-}
-
-void PmFrameGenerator::CalculateLatencyMetrics(
-    uint32_t start_frame, double window_size_in_ms,
-    std::vector<PM_GFX_LATENCY_DATA>& latency_metrics) {
-
-  std::unordered_map<uint64_t, latency_swap_chain_data> swap_chain_data;
-
-  if (start_frame > pmft_frames_.size()) {
-    return;
-  }
-
-  // Get the qpc for the start frame
-  uint64_t start_frame_qpc = pmft_frames_[start_frame].qpc_time;
-
-  // Calculate number of ticks based on the passed in window size
-  uint64_t window_size_in_ticks =
-      SecondsDeltaToQpc(window_size_in_ms / 1000., qpc_frequency_);
-  uint64_t calculated_end_frame_qpc = start_frame_qpc - window_size_in_ticks;
-
-  for (uint32_t current_frame_number = start_frame; current_frame_number > 0;
-       current_frame_number--) {
-    auto result =
-        swap_chain_data.emplace(pmft_frames_[current_frame_number].swap_chain,
-                                latency_swap_chain_data());
-    auto swap_chain = &result.first->second;
-    if (result.second) {
-      swap_chain->render_latency_ms.clear();
-      swap_chain->display_latency_ms.clear();
-    } else {
-      if (pmft_frames_[current_frame_number].qpc_time >
-          calculated_end_frame_qpc) {
-        if (pmft_frames_[current_frame_number].ms_between_display_change !=
-            0.) {
-          swap_chain->render_latency_ms.push_back(
-              pmft_frames_[current_frame_number].ms_until_displayed);
-          swap_chain->display_latency_ms.push_back(
-              pmft_frames_[current_frame_number].ms_until_displayed -
-              pmft_frames_[current_frame_number].ms_until_render_complete);
-        }
-      } else {
-        break;
-      }
-    }
-  }
-
-  latency_metrics.clear();
-  PM_GFX_LATENCY_DATA temp_latency_data{};
-  for (auto pair : swap_chain_data) {
-    temp_latency_data.swap_chain = pair.first;
-    auto swap_chain = pair.second;
-    CalcMetricStats(swap_chain.render_latency_ms,
-                    temp_latency_data.render_latency_ms);
-    CalcMetricStats(swap_chain.display_latency_ms,
-                    temp_latency_data.display_latency_ms);
-    latency_metrics.emplace_back(temp_latency_data);
-    temp_latency_data = {};
-  }
-  return;
-}
-
-void PmFrameGenerator::CalculateGpuMetrics(
-    uint32_t start_frame, double window_size_in_ms,
-    GpuTelemetryBitset gpu_telemetry_cap_bits, PM_GPU_DATA& gpu_metrics) {
-  if (start_frame > pmft_frames_.size()) {
-    return;
-  }
-
-  // Get the qpc for the start frame
-  uint64_t start_frame_qpc = pmft_frames_[start_frame].qpc_time;
-
-  bool gpu_mem_util_enabled = (gpu_telemetry_cap_bits[static_cast<size_t>(
-                                   GpuTelemetryCapBits::gpu_mem_size)] &&
-                               gpu_telemetry_cap_bits[static_cast<size_t>(
-                                   GpuTelemetryCapBits::gpu_mem_used)]);
-
-  // Calculate number of ticks based on the passed in window size
-  uint64_t window_size_in_ticks =
-      SecondsDeltaToQpc(window_size_in_ms / 1000., qpc_frequency_);
-  uint64_t calculated_end_frame_qpc = start_frame_qpc - window_size_in_ticks;
-  gpu_data calculated_gpu_metrics{};
-  for (uint32_t current_frame_number = start_frame; current_frame_number > 0;
-       current_frame_number--) {
-    if (pmft_frames_[current_frame_number].qpc_time >
-        calculated_end_frame_qpc) {
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(GpuTelemetryCapBits::gpu_power)]) {
-        calculated_gpu_metrics.gpu_power_w.push_back(
-            frames_[current_frame_number].power_telemetry.gpu_power_w);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_sustained_power_limit)]) {
-        calculated_gpu_metrics.gpu_sustained_power_limit_w.push_back(
-            frames_[current_frame_number]
-                .power_telemetry.gpu_sustained_power_limit_w);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_voltage)]) {
-        calculated_gpu_metrics.gpu_voltage_v.push_back(
-            frames_[current_frame_number].power_telemetry.gpu_voltage_v);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_frequency)]) {
-        calculated_gpu_metrics.gpu_frequency_mhz.push_back(
-            frames_[current_frame_number].power_telemetry.gpu_frequency_mhz);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_temperature)]) {
-        calculated_gpu_metrics.gpu_temp_c.push_back(
-            frames_[current_frame_number].power_telemetry.gpu_temperature_c);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_utilization)]) {
-        calculated_gpu_metrics.gpu_util_percent.push_back(
-            frames_[current_frame_number].power_telemetry.gpu_utilization);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_render_compute_utilization)]) {
-        calculated_gpu_metrics.gpu_render_compute_util_percent.push_back(
-            frames_[current_frame_number]
-                .power_telemetry.gpu_render_compute_utilization);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_media_utilization)]) {
-        calculated_gpu_metrics.gpu_media_util_percent.push_back(
-            frames_[current_frame_number]
-                .power_telemetry.gpu_media_utilization);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::vram_power)]) {
-        calculated_gpu_metrics.vram_power_w.push_back(
-            frames_[current_frame_number].power_telemetry.vram_power_w);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::vram_voltage)]) {
-        calculated_gpu_metrics.vram_voltage_v.push_back(
-            frames_[current_frame_number].power_telemetry.vram_voltage_v);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::vram_frequency)]) {
-        calculated_gpu_metrics.vram_frequency_mhz.push_back(
-            frames_[current_frame_number].power_telemetry.vram_frequency_mhz);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::vram_effective_frequency)]) {
-        calculated_gpu_metrics.vram_effective_frequency_gbps.push_back(
-            frames_[current_frame_number]
-                .power_telemetry.vram_effective_frequency_gbps);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::vram_temperature)]) {
-        calculated_gpu_metrics.vram_temp_c.push_back(
-            frames_[current_frame_number].power_telemetry.vram_temperature_c);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_mem_size)]) {
-        calculated_gpu_metrics.gpu_mem_total_size_b.push_back(
-            (double)frames_[current_frame_number]
-                .power_telemetry.gpu_mem_total_size_b);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_mem_used)]) {
-        calculated_gpu_metrics.gpu_mem_used_b.push_back(
-            (double)frames_[current_frame_number]
-                .power_telemetry.gpu_mem_used_b);
-      }
-      // gpu mem utilization is calculated from the total gpu memory
-      // and the used gpu memory
-      if (gpu_mem_util_enabled) {
-        if (frames_[current_frame_number]
-                .power_telemetry.gpu_mem_total_size_b != 0.) {
-          calculated_gpu_metrics.gpu_mem_util_percent.push_back(
-              100. *
-              double(frames_[current_frame_number]
-                         .power_telemetry.gpu_mem_used_b) /
-              frames_[current_frame_number]
-                  .power_telemetry.gpu_mem_total_size_b);
-        } else {
-          calculated_gpu_metrics.gpu_mem_util_percent.push_back(0.);
-        }
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_mem_max_bandwidth)]) {
-        calculated_gpu_metrics.gpu_mem_max_bw_gbps.push_back(
-            (double)frames_[current_frame_number]
-                .power_telemetry.gpu_mem_max_bandwidth_bps);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_mem_read_bandwidth)]) {
-        calculated_gpu_metrics.gpu_mem_read_bw_bps.push_back(
-            frames_[current_frame_number]
-                .power_telemetry.gpu_mem_read_bandwidth_bps);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_mem_write_bandwidth)]) {
-        calculated_gpu_metrics.gpu_mem_write_bw_bps.push_back(
-            frames_[current_frame_number]
-                .power_telemetry.gpu_mem_write_bandwidth_bps);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::fan_speed_0)]) {
-        calculated_gpu_metrics.gpu_fan_speed_rpm.push_back(
-            frames_[current_frame_number].power_telemetry.fan_speed_rpm[0]);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_power_limited)]) {
-        calculated_gpu_metrics.gpu_power_limited_percent.push_back(
-            frames_[current_frame_number].power_telemetry.gpu_power_limited);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_temperature_limited)]) {
-        calculated_gpu_metrics.gpu_temp_limited_percent.push_back(
-            frames_[current_frame_number]
-                .power_telemetry.gpu_temperature_limited);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_current_limited)]) {
-        calculated_gpu_metrics.gpu_current_limited_percent.push_back(
-            frames_[current_frame_number].power_telemetry.gpu_current_limited);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_voltage_limited)]) {
-        calculated_gpu_metrics.gpu_voltage_limited_percent.push_back(
-            frames_[current_frame_number].power_telemetry.gpu_voltage_limited);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::gpu_utilization_limited)]) {
-        calculated_gpu_metrics.gpu_util_limited_percent.push_back(
-            frames_[current_frame_number]
-                .power_telemetry.gpu_utilization_limited);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::vram_power_limited)]) {
-        calculated_gpu_metrics.vram_power_limited_percent.push_back(
-            frames_[current_frame_number].power_telemetry.vram_power_limited);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::vram_temperature_limited)]) {
-        calculated_gpu_metrics.vram_temp_limited_percent.push_back(
-            frames_[current_frame_number]
-                .power_telemetry.vram_temperature_limited);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::vram_current_limited)]) {
-        calculated_gpu_metrics.vram_current_limited_percent.push_back(
-            frames_[current_frame_number].power_telemetry.vram_current_limited);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::vram_voltage_limited)]) {
-        calculated_gpu_metrics.vram_voltage_limited_percent.push_back(
-            frames_[current_frame_number].power_telemetry.vram_voltage_limited);
-      }
-      if (gpu_telemetry_cap_bits[static_cast<size_t>(
-              GpuTelemetryCapBits::vram_utilization_limited)]) {
-        calculated_gpu_metrics.vram_util_limited_percent.push_back(
-            frames_[current_frame_number]
-                .power_telemetry.vram_utilization_limited);
-      }
-
-    } else {
-      break;
-    }
-  }
-
-  CalcMetricStats(calculated_gpu_metrics.gpu_power_w, gpu_metrics.gpu_power_w,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_power)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_sustained_power_limit_w,
-                  gpu_metrics.gpu_sustained_power_limit_w,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_sustained_power_limit)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_voltage_v,
-                  gpu_metrics.gpu_voltage_v,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_voltage)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_frequency_mhz,
-                  gpu_metrics.gpu_frequency_mhz,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_frequency)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_temp_c,
-                  gpu_metrics.gpu_temperature_c,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_temperature)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_fan_speed_rpm,
-                  gpu_metrics.gpu_fan_speed_rpm[0],
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::fan_speed_0)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_util_percent,
-                  gpu_metrics.gpu_utilization,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_utilization)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_render_compute_util_percent,
-                  gpu_metrics.gpu_render_compute_utilization,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_render_compute_utilization)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_media_util_percent,
-                  gpu_metrics.gpu_media_utilization,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_media_utilization)]);
-  CalcMetricStats(calculated_gpu_metrics.vram_power_w, gpu_metrics.vram_power_w,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::vram_power)]);
-  CalcMetricStats(calculated_gpu_metrics.vram_voltage_v,
-                  gpu_metrics.vram_voltage_v,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::vram_voltage)]);
-  CalcMetricStats(calculated_gpu_metrics.vram_frequency_mhz,
-                  gpu_metrics.vram_frequency_mhz,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::vram_frequency)]);
-  CalcMetricStats(calculated_gpu_metrics.vram_effective_frequency_gbps,
-                  gpu_metrics.vram_effective_frequency_gbps,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::vram_effective_frequency)]);
-  CalcMetricStats(calculated_gpu_metrics.vram_temp_c,
-                  gpu_metrics.vram_temperature_c,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::vram_temperature)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_mem_total_size_b,
-                  gpu_metrics.gpu_mem_total_size_b,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_mem_size)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_mem_used_b,
-                  gpu_metrics.gpu_mem_used_b,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_mem_used)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_mem_util_percent,
-                  gpu_metrics.gpu_mem_utilization, gpu_mem_util_enabled);
-  CalcMetricStats(calculated_gpu_metrics.gpu_mem_max_bw_gbps,
-                  gpu_metrics.gpu_mem_max_bandwidth_bps,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_mem_max_bandwidth)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_mem_read_bw_bps,
-                  gpu_metrics.gpu_mem_read_bandwidth_bps,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_mem_max_bandwidth)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_mem_write_bw_bps,
-                  gpu_metrics.gpu_mem_write_bandwidth_bps,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_mem_write_bandwidth)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_power_limited_percent,
-                  gpu_metrics.gpu_power_limited,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_power_limited)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_temp_limited_percent,
-                  gpu_metrics.gpu_temperature_limited,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_temperature_limited)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_current_limited_percent,
-                  gpu_metrics.gpu_current_limited,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_current_limited)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_voltage_limited_percent,
-                  gpu_metrics.gpu_voltage_limited,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_voltage_limited)]);
-  CalcMetricStats(calculated_gpu_metrics.gpu_util_limited_percent,
-                  gpu_metrics.gpu_utilization_limited,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::gpu_utilization_limited)]);
-  CalcMetricStats(calculated_gpu_metrics.vram_power_limited_percent,
-                  gpu_metrics.vram_power_limited,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::vram_power_limited)]);
-  CalcMetricStats(calculated_gpu_metrics.vram_temp_limited_percent,
-                  gpu_metrics.vram_temperature_limited,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::vram_temperature_limited)]);
-  CalcMetricStats(calculated_gpu_metrics.vram_current_limited_percent,
-                  gpu_metrics.vram_current_limited,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::vram_current_limited)]);
-  CalcMetricStats(calculated_gpu_metrics.vram_voltage_limited_percent,
-                  gpu_metrics.vram_voltage_limited,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::vram_voltage_limited)]);
-  CalcMetricStats(calculated_gpu_metrics.vram_util_limited_percent,
-                  gpu_metrics.vram_utilization_limited,
-                  gpu_telemetry_cap_bits[static_cast<size_t>(
-                      GpuTelemetryCapBits::vram_utilization_limited)]);
-}
-
-void PmFrameGenerator::CalculateCpuMetrics(
-    uint32_t start_frame, double window_size_in_ms,
-    CpuTelemetryBitset cpu_telemetry_cap_bits,
-    PM_CPU_DATA& cpu_metrics) {
-  if (start_frame > pmft_frames_.size()) {
-    return;
-  }
-
-  // Get the qpc for the start frame
-  uint64_t start_frame_qpc = pmft_frames_[start_frame].qpc_time;
-
-  // Calculate number of ticks based on the passed in window size
-  uint64_t window_size_in_ticks =
-      SecondsDeltaToQpc(window_size_in_ms / 1000., qpc_frequency_);
-  uint64_t calculated_end_frame_qpc = start_frame_qpc - window_size_in_ticks;
-  cpu_data calculated_cpu_metrics{};
-  for (uint32_t current_frame_number = start_frame; current_frame_number > 0;
-       current_frame_number--) {
-    if (pmft_frames_[current_frame_number].qpc_time >
-        calculated_end_frame_qpc) {
-      if (cpu_telemetry_cap_bits[static_cast<size_t>(
-              CpuTelemetryCapBits::cpu_utilization)]) {
-        calculated_cpu_metrics.cpu_util_percent.push_back(
-            frames_[current_frame_number].cpu_telemetry.cpu_utilization);
-      }
-      if (cpu_telemetry_cap_bits[static_cast<size_t>(
-              CpuTelemetryCapBits::cpu_frequency)]) {
-        calculated_cpu_metrics.cpu_frequency_mhz.push_back(
-            frames_[current_frame_number].cpu_telemetry.cpu_frequency);
-      }
-    }
-  }
-
-  CalcMetricStats(calculated_cpu_metrics.cpu_util_percent,
-                  cpu_metrics.cpu_utilization,
-                  cpu_telemetry_cap_bits[static_cast<size_t>(
-                      CpuTelemetryCapBits::cpu_utilization)]);
-  CalcMetricStats(calculated_cpu_metrics.cpu_frequency_mhz,
-                  cpu_metrics.cpu_frequency,
-                  cpu_telemetry_cap_bits[static_cast<size_t>(
-                      CpuTelemetryCapBits::cpu_frequency)]);
-}
\ No newline at end of file
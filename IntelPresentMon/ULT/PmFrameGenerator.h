@@ -1,11 +1,13 @@
 #pragma once
 
 #include <numeric>
+#include <optional>
 #include <random>
+#include <string>
+#include <vector>
 
-#include "../PresentMonUtils/MemBuffer.h"
+#include "../PresentMonUtils/StreamFormat.h"
 #include "../PresentMonUtils/PresentDataUtils.h"
-#include "../PresentMonUtils/PresentMonNamedPipe.h"
 #include "../PresentMonUtils/QPCUtils.h"
 
 struct PMFrameTimingInformation {
@@ -130,20 +132,6 @@ class PmFrameGenerator {
                                GpuTelemetryBitset gpu_telemetry_cap_bits,
                                CpuTelemetryBitset cpu_telemetry_cap_bits);
 
-  // Calculate the Fps metrics using the PresentMon frame data and not
-  // the raw qpc data.
-  bool CalculateFpsMetrics(uint32_t start_frame, double window_size_in_ms,
-                           std::vector<PM_FPS_DATA>& fps_metrics);
-  void CalculateLatencyMetrics(
-      uint32_t start_frame, double window_size_in_ms,
-      std::vector<PM_GFX_LATENCY_DATA>& latency_metrics);
-  void CalculateGpuMetrics(uint32_t start_frame, double window_size_in_ms,
-                           GpuTelemetryBitset gpu_telemetry_cap_bits,
-                           PM_GPU_DATA& gpu_metrics);
-  void CalculateCpuMetrics(uint32_t start_frame, double window_size_in_ms,
-                           CpuTelemetryBitset cpu_telemetry_cap_bits,
-                           PM_CPU_DATA& cpu_metrics);
-
 
   // Simple function to set the number of swap chains to be created
   // when generating  // frame data. If set AFTER frame data generation it
@@ -201,78 +189,10 @@ class PmFrameGenerator {
     }
   }
 
-  struct fps_swap_chain_data {
-    std::vector<double> presented_fps;
-    std::vector<double> display_fps;
-    std::vector<double> frame_times_ms;
-    std::vector<double> gpu_sum_ms;
-    std::vector<double> dropped;
-    double mLastDisplayedScreenTime = 0.;
-    double display_0_screen_time = 0.;
-    double cpu_n_time = 0.;
-    double cpu_0_time = 0.;
-    double time_in_s = 0.;
-    uint32_t num_presents = 0;
-    int32_t sync_interval = 0;
-    PM_PRESENT_MODE present_mode = PM_PRESENT_MODE_UNKNOWN;
-  };
-
-  struct latency_swap_chain_data {
-    std::vector<double> render_latency_ms;
-    std::vector<double> display_latency_ms;
-  };
-
-  struct gpu_data {
-    std::vector<double> gpu_power_w;
-    std::vector<double> gpu_sustained_power_limit_w;
-    std::vector<double> gpu_voltage_v;
-    std::vector<double> gpu_frequency_mhz;
-    std::vector<double> gpu_temp_c;
-    std::vector<double> gpu_util_percent;
-    std::vector<double> gpu_render_compute_util_percent;
-    std::vector<double> gpu_media_util_percent;
-    std::vector<double> vram_power_w;
-    std::vector<double> vram_voltage_v;
-    std::vector<double> vram_frequency_mhz;
-    std::vector<double> vram_effective_frequency_gbps;
-    std::vector<double> vram_read_bw_gbps;
-    std::vector<double> vram_write_bw_gbps;
-    std::vector<double> vram_temp_c;
-    std::vector<double> gpu_mem_total_size_b;
-    std::vector<double> gpu_mem_used_b;
-    std::vector<double> gpu_mem_util_percent;
-    std::vector<double> gpu_mem_max_bw_gbps;
-    std::vector<double> gpu_mem_read_bw_bps;
-    std::vector<double> gpu_mem_write_bw_bps;
-    std::vector<double> gpu_fan_speed_rpm;
-    std::vector<double> gpu_power_limited_percent;
-    std::vector<double> gpu_temp_limited_percent;
-    std::vector<double> gpu_current_limited_percent;
-    std::vector<double> gpu_voltage_limited_percent;
-    std::vector<double> gpu_util_limited_percent;
-    std::vector<double> vram_power_limited_percent;
-    std::vector<double> vram_temp_limited_percent;
-    std::vector<double> vram_current_limited_percent;
-    std::vector<double> vram_voltage_limited_percent;
-    std::vector<double> vram_util_limited_percent;
-  };
-
-  struct cpu_data {
-    std::vector<double> cpu_util_percent;
-    std::vector<double> cpu_frequency_mhz;
-  };
-
   void GeneratePresentData();
   void GenerateGPUData();
   void GenerateCPUData();
 
-  void CalcMetricStats(std::vector<double>& data,
-                       PM_METRIC_DOUBLE_DATA& metric,
-                       bool valid=true);
-
-  // Calculate percentile using linear interpolation between the closet ranks
-  // method
-  double GetPercentile(std::vector<double>& data, double percentile);
   bool IsLimited(const double& limited_percentage) {
     if (uniform_random_gen_.Generate(0., 100.) < limited_percentage) {
       return true;
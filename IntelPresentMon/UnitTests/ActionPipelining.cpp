@@ -0,0 +1,297 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Core/source/win/WinAPI.h>
+#define PM_ASYNC_ACTION_REGISTRATION_
+#include <Interprocess/source/act/ActionHelper.h>
+#include <Interprocess/source/act/SymmetricActionServer.h>
+#include <Interprocess/source/act/SymmetricActionClient.h>
+#include <CommonUtilities/Qpc.h>
+#include <set>
+#include <algorithm>
+#include <optional>
+#include <future>
+#include <format>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace InterprocessTests::loop
+{
+	using namespace pmon::util;
+	using namespace pmon::ipc::act;
+
+	struct LoopExecutionContext;
+
+	struct LoopSessionContext
+	{
+		std::unique_ptr<SymmetricActionConnector<LoopExecutionContext>> pConn;
+		uint32_t remotePid = 0;
+		uint32_t nextCommandToken = 0;
+		std::set<uint32_t> trackedPids;
+	};
+
+	struct LoopExecutionContext
+	{
+		using SessionContextType = LoopSessionContext;
+		std::optional<uint32_t> responseWriteTimeoutMs;
+	};
+
+	// minimal stand-ins for the service actions, both endpoints live in this module
+	class OpenSession : public AsyncActionBase_<OpenSession, LoopExecutionContext>
+	{
+	public:
+		static constexpr const char* Identifier = "OpenSession";
+		struct Params
+		{
+			uint32_t clientPid;
+			template<class A> void serialize(A& ar) { ar(clientPid); }
+		};
+		struct Response
+		{
+			uint32_t serverPid;
+			template<class A> void serialize(A& ar) { ar(serverPid); }
+		};
+	private:
+		friend class AsyncActionBase_<OpenSession, LoopExecutionContext>;
+		static Response Execute_(const LoopExecutionContext& ctx, SessionContext& stx, Params&& in)
+		{
+			stx.remotePid = in.clientPid;
+			return { GetCurrentProcessId() };
+		}
+	};
+
+	class StartTracking : public AsyncActionBase_<StartTracking, LoopExecutionContext>
+	{
+	public:
+		static constexpr const char* Identifier = "StartTracking";
+		struct Params
+		{
+			uint32_t targetPid;
+			template<class A> void serialize(A& ar) { ar(targetPid); }
+		};
+		struct Response
+		{
+			std::string nsmFileName;
+			template<class A> void serialize(A& ar) { ar(nsmFileName); }
+		};
+	private:
+		friend class AsyncActionBase_<StartTracking, LoopExecutionContext>;
+		static Response Execute_(const LoopExecutionContext& ctx, SessionContext& stx, Params&& in)
+		{
+			if (in.targetPid == 0 || !stx.trackedPids.insert(in.targetPid).second) {
+				throw Except<ActionExecutionError>(PM_STATUS_ALREADY_TRACKING_PROCESS);
+			}
+			return { std::format("pm_nsm_{}", in.targetPid) };
+		}
+	};
+
+	class StopTracking : public AsyncActionBase_<StopTracking, LoopExecutionContext>
+	{
+	public:
+		static constexpr const char* Identifier = "StopTracking";
+		struct Params
+		{
+			uint32_t targetPid;
+			template<class A> void serialize(A& ar) { ar(targetPid); }
+		};
+		struct Response {};
+	private:
+		friend class AsyncActionBase_<StopTracking, LoopExecutionContext>;
+		static Response Execute_(const LoopExecutionContext& ctx, SessionContext& stx, Params&& in)
+		{
+			stx.trackedPids.erase(in.targetPid);
+			return {};
+		}
+	};
+
+	class Batch : public AsyncActionBase_<Batch, LoopExecutionContext>
+	{
+	public:
+		static constexpr const char* Identifier = BatchEnvelope::Identifier;
+		using Params = BatchEnvelope::Params;
+		using Response = BatchEnvelope::Response;
+	private:
+		friend class AsyncActionBase_<Batch, LoopExecutionContext>;
+		static Response Execute_(LoopExecutionContext& ctx, SessionContext& stx, Params&& in)
+		{
+			return ExecuteBatch(ctx, stx, in);
+		}
+	};
+
+	AsyncActionRegistrator<OpenSession, LoopExecutionContext> regOpenSession_;
+	AsyncActionRegistrator<StartTracking, LoopExecutionContext> regStartTracking_;
+	AsyncActionRegistrator<StopTracking, LoopExecutionContext> regStopTracking_;
+	AsyncActionRegistrator<Batch, LoopExecutionContext> regBatch_;
+}
+
+namespace pmon::ipc::act
+{
+	template<> struct ActionParamsTraits<InterprocessTests::loop::OpenSession::Params> { using Action = InterprocessTests::loop::OpenSession; };
+	template<> struct ActionParamsTraits<InterprocessTests::loop::StartTracking::Params> { using Action = InterprocessTests::loop::StartTracking; };
+	template<> struct ActionParamsTraits<InterprocessTests::loop::StopTracking::Params> { using Action = InterprocessTests::loop::StopTracking; };
+}
+
+namespace InterprocessTests
+{
+	using namespace loop;
+	using namespace pmon::util;
+	using namespace pmon::ipc::act;
+	using namespace std::string_literals;
+
+	// server and connected client with an open session, talking over real named pipes
+	class Loopback
+	{
+	public:
+		Loopback()
+			:
+			pipeName_{ std::format(R"(\\.\pipe\pm-unit-act-loop-{})", GetCurrentProcessId()) },
+			server_{ LoopExecutionContext{}, pipeName_, 1, pipe::DuplexPipe::GetSecurityString(pipe::SecurityMode::None) }
+		{
+			Assert::IsTrue(pipe::DuplexPipe::WaitForAvailability(pipeName_ + "-in", 1000));
+			pClient_ = std::make_unique<SymmetricActionClient<LoopExecutionContext>>(pipeName_);
+			pClient_->DispatchSync(OpenSession::Params{ GetCurrentProcessId() });
+		}
+		SymmetricActionClient<LoopExecutionContext>& Client() { return *pClient_; }
+	private:
+		std::string pipeName_;
+		SymmetricActionServer<LoopExecutionContext> server_;
+		std::unique_ptr<SymmetricActionClient<LoopExecutionContext>> pClient_;
+	};
+
+	TEST_CLASS(TestActionPipelining)
+	{
+	public:
+		TEST_METHOD(PipelinedResponsesMatchRequests)
+		{
+			Loopback loop;
+			std::vector<std::future<StartTracking::Response>> futures;
+			for (uint32_t pid = 1; pid <= 64; pid++) {
+				futures.push_back(loop.Client().DispatchAsync(StartTracking::Params{ pid }));
+			}
+			for (uint32_t pid = 1; pid <= 64; pid++) {
+				Assert::AreEqual(std::format("pm_nsm_{}", pid), futures[pid - 1].get().nsmFileName);
+			}
+		}
+		TEST_METHOD(PipelinedFailureDoesNotAffectOthers)
+		{
+			Loopback loop;
+			auto f1 = loop.Client().DispatchAsync(StartTracking::Params{ 7 });
+			auto f2 = loop.Client().DispatchAsync(StartTracking::Params{ 7 });
+			auto f3 = loop.Client().DispatchAsync(StartTracking::Params{ 8 });
+			Assert::AreEqual("pm_nsm_7"s, f1.get().nsmFileName);
+			Assert::ExpectException<ActionExecutionError>([&] { f2.get(); });
+			Assert::AreEqual("pm_nsm_8"s, f3.get().nsmFileName);
+		}
+		TEST_METHOD(BatchRoundTrip)
+		{
+			Loopback loop;
+			std::vector<StartTracking::Params> starts;
+			for (uint32_t pid = 1; pid <= 32; pid++) {
+				starts.push_back({ pid });
+			}
+			const auto responses = loop.Client().DispatchBatch(starts);
+			Assert::AreEqual(32ull, responses.size());
+			for (uint32_t pid = 1; pid <= 32; pid++) {
+				Assert::IsTrue(responses[pid - 1].Succeeded());
+				Assert::AreEqual(std::format("pm_nsm_{}", pid), responses[pid - 1].Get().nsmFileName);
+			}
+			// a failing sub-request reports its own error, the others are still executed and returned
+			const auto mixed = loop.Client().DispatchBatch(std::vector<StartTracking::Params>{ { 100 }, { 1 }, { 101 } });
+			Assert::AreEqual(3ull, mixed.size());
+			Assert::IsTrue(mixed[0].Succeeded());
+			Assert::AreEqual("pm_nsm_100"s, mixed[0].Get().nsmFileName);
+			Assert::IsFalse(mixed[1].Succeeded());
+			Assert::ExpectException<ActionExecutionError>([&] { mixed[1].Get(); });
+			Assert::IsTrue(mixed[2].Succeeded());
+			Assert::AreEqual("pm_nsm_101"s, mixed[2].Get().nsmFileName);
+			Assert::ExpectException<ActionExecutionError>([&] {
+				loop.Client().DispatchSync(StartTracking::Params{ 101 });
+			});
+		}
+		TEST_METHOD(BatchChecksVersionPerSubRequest)
+		{
+			LoopExecutionContext ctx;
+			LoopSessionContext stx;
+			const auto table = AsyncActionCollection<LoopExecutionContext>::Get().GetIdentifierTable();
+			const auto startId = std::ranges::find(table, "StartTracking"s) - table.begin();
+			BatchEnvelope::Params batch;
+			batch.requests.push_back({ uint16_t(startId), StartTracking::Version, SerializeToBlob(StartTracking::Params{ 1 }) });
+			batch.requests.push_back({ uint16_t(startId), uint16_t(StartTracking::Version + 1), SerializeToBlob(StartTracking::Params{ 2 }) });
+			batch.requests.push_back({ uint16_t(startId), StartTracking::Version, SerializeToBlob(StartTracking::Params{ 3 }) });
+			const auto res = ExecuteBatch(ctx, stx, batch);
+			Assert::AreEqual(3ull, res.responses.size());
+			Assert::IsTrue(res.responses[0].transportStatus == TransportStatus::Success);
+			Assert::IsTrue(res.responses[1].transportStatus == TransportStatus::TransportFailure);
+			Assert::IsTrue(res.responses[2].transportStatus == TransportStatus::Success);
+			// the mismatched request must not have been executed
+			Assert::IsFalse(stx.trackedPids.contains(2));
+		}
+		TEST_METHOD(AbandonedRequestIsUnregistered)
+		{
+			std::optional<ResponseRouter> router{ std::in_place };
+			bool called = false;
+			{
+				const auto registration = router->Register(7, [&](auto, auto, auto) { called = true; });
+				Assert::AreEqual(1ull, router->GetInFlightCount());
+			}
+			Assert::AreEqual(0ull, router->GetInFlightCount());
+			// a registration may also be dropped after the router itself is gone
+			{
+				const auto registration = router->Register(8, [&](auto, auto, auto) { called = true; });
+				router.reset();
+			}
+			Assert::IsFalse(called);
+		}
+		TEST_METHOD(LoopbackBenchmark)
+		{
+			constexpr uint32_t callCount = 1000;
+			Loopback loop;
+			auto& client = loop.Client();
+			// each call waits a full round trip before the next can go
+			double sequentialSeconds = 0.;
+			{
+				QpcTimer timer;
+				for (uint32_t i = 0; i < callCount / 2; i++) {
+					client.DispatchSync(StartTracking::Params{ 1000 + i });
+					client.DispatchSync(StopTracking::Params{ 1000 + i });
+				}
+				sequentialSeconds = timer.Mark();
+			}
+			// all calls in flight at once
+			double pipelinedSeconds = 0.;
+			{
+				QpcTimer timer;
+				std::vector<std::future<StartTracking::Response>> starts;
+				std::vector<std::future<StopTracking::Response>> stops;
+				for (uint32_t i = 0; i < callCount / 2; i++) {
+					starts.push_back(client.DispatchAsync(StartTracking::Params{ 1000 + i }));
+					stops.push_back(client.DispatchAsync(StopTracking::Params{ 1000 + i }));
+				}
+				for (auto& f : starts) { f.get(); }
+				for (auto& f : stops) { f.get(); }
+				pipelinedSeconds = timer.Mark();
+			}
+			// one round trip per action type
+			double batchedSeconds = 0.;
+			{
+				std::vector<StartTracking::Params> starts;
+				std::vector<StopTracking::Params> stops;
+				for (uint32_t i = 0; i < callCount / 2; i++) {
+					starts.push_back({ 1000 + i });
+					stops.push_back({ 1000 + i });
+				}
+				QpcTimer timer;
+				client.DispatchBatch(std::move(starts));
+				client.DispatchBatch(std::move(stops));
+				batchedSeconds = timer.Mark();
+			}
+			Logger::WriteMessage(std::format("{} StartTracking/StopTracking calls: sequential {:.2f}ms, "
+				"pipelined {:.2f}ms ({:.2f}x), batched {:.2f}ms ({:.2f}x)\n", callCount,
+				sequentialSeconds * 1000., pipelinedSeconds * 1000., sequentialSeconds / pipelinedSeconds,
+				batchedSeconds * 1000., sequentialSeconds / batchedSeconds).c_str());
+			Assert::IsTrue(pipelinedSeconds < sequentialSeconds);
+			Assert::IsTrue(batchedSeconds < sequentialSeconds);
+		}
+	};
+}
@@ -0,0 +1,203 @@
+// Copyright (C) 2023 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include <CppUnitTest.h>
+
+#include <Core/source/kernel/DataFetchPack.h>
+#include <CommonUtilities/Qpc.h>
+#include <cstring>
+#include <format>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace KernelTests
+{
+	using namespace p2c::kern;
+	using p2c::pmon::met::BatchValueReader;
+	using p2c::pmon::met::MetricFetcher;
+	using p2c::pmon::met::NumericReadoutCache;
+	using p2c::gfx::lay::GraphData;
+	using ::pmon::util::QpcTimer;
+
+	// stands in for TypedDynamicPollingFetcher<double>, reading from a blob owned by the test
+	class BlobFetcher : public MetricFetcher
+	{
+	public:
+		BlobFetcher(const uint8_t* const* ppBlob, uint32_t offset, float scale)
+			:
+			ppBlob_{ ppBlob },
+			offset_{ offset },
+			scale_{ scale }
+		{}
+		std::optional<float> ReadValue() override
+		{
+			if (*ppBlob_) {
+				double val;
+				std::memcpy(&val, *ppBlob_ + offset_, sizeof(val));
+				return scale_ * (float)val;
+			}
+			return {};
+		}
+		std::optional<size_t> AddToBatch(BatchValueReader& reader) const override
+		{
+			return reader.Add(PM_DATA_TYPE_DOUBLE, offset_, scale_);
+		}
+	private:
+		const uint8_t* const* ppBlob_;
+		uint32_t offset_;
+		float scale_;
+	};
+
+	// stands in for an enum / string fetcher, which is always read individually
+	class UnbatchedFetcher : public MetricFetcher
+	{
+	public:
+		std::optional<float> ReadValue() override { return {}; }
+		std::wstring ReadStringValue() override { return std::format(L"read {}", ++reads_); }
+	private:
+		int reads_ = 0;
+	};
+
+	// overlay loadout: graphCount graph widgets and readoutCount readout widgets, each on its own metric
+	// one in four metrics changes every poll (like fps), the rest change once a second (like temperatures)
+	struct Loadout
+	{
+		Loadout(size_t graphCount, size_t readoutCount, double window)
+			:
+			blob((graphCount + readoutCount) * sizeof(double))
+		{
+			for (size_t i = 0; i < graphCount + readoutCount; i++) {
+				auto& pack = packs.emplace_back();
+				pack.pFetcher = std::make_shared<BlobFetcher>(&pBlob, uint32_t(i * sizeof(double)), i % 3 ? 1.f : 0.001f);
+				if (i < graphCount) {
+					pack.graphData = std::make_shared<GraphData>(window);
+				}
+				else {
+					pack.textData = std::make_shared<std::wstring>();
+				}
+			}
+		}
+		void Update(int tick)
+		{
+			for (size_t i = 0; i < blob.size() / sizeof(double); i++) {
+				double val = i % 4 ? double(tick / 60 % 7) * 1000. + double(i) : dist(rng);
+				std::memcpy(&blob[i * sizeof(double)], &val, sizeof(val));
+			}
+			// blob occasionally not populated
+			pBlob = tick % 97 == 13 ? nullptr : blob.data();
+		}
+		std::vector<uint8_t> blob;
+		const uint8_t* pBlob = nullptr;
+		std::vector<DataFetchPack> packs;
+		std::minstd_rand rng{ 0 };
+		std::uniform_real_distribution<double> dist{ 0., 500. };
+	};
+
+	TEST_CLASS(TestDataFetchBatch)
+	{
+	public:
+		TEST_METHOD(MatchesIndividualPopulate)
+		{
+			Loadout individual{ 10, 10, 1. };
+			Loadout batched{ 10, 10, 1. };
+			auto& extra = batched.packs.emplace_back();
+			extra.pFetcher = std::make_shared<UnbatchedFetcher>();
+			extra.textData = std::make_shared<std::wstring>();
+			DataFetchBatch batch;
+			batch.Rebuild(batched.packs);
+			for (int tick = 0; tick < 300; tick++) {
+				const auto t = tick / 60.;
+				individual.Update(tick);
+				batched.Update(tick);
+				for (auto& p : individual.packs) {
+					p.Populate(t);
+				}
+				batch.Populate(batched.pBlob, t);
+				for (size_t i = 0; i < individual.packs.size(); i++) {
+					auto& a = individual.packs[i];
+					auto& b = batched.packs[i];
+					if (a.graphData) {
+						Assert::AreEqual(a.graphData->Size(), b.graphData->Size());
+						Assert::IsTrue(a.graphData->Front().value == b.graphData->Front().value);
+					}
+					else {
+						Assert::AreEqual(*a.textData, *b.textData);
+					}
+				}
+				Assert::AreEqual(std::format(L"read {}", tick + 1), *extra.textData);
+			}
+		}
+		TEST_METHOD(NanGraphSampleIsEmpty)
+		{
+			Loadout loadout{ 1, 0, 10. };
+			DataFetchBatch batch;
+			batch.Rebuild(loadout.packs);
+			auto& graph = *loadout.packs.front().graphData;
+			const auto push = [&](double val, double t) {
+				std::memcpy(loadout.blob.data(), &val, sizeof(val));
+				batch.Populate(loadout.blob.data(), t);
+			};
+			// scale of the first metric is 0.001
+			push(1000., 0.);
+			push(std::numeric_limits<double>::quiet_NaN(), 0.1);
+			Assert::IsFalse(graph.Front().value.has_value());
+			push(3000., 0.2);
+			batch.Populate(nullptr, 0.3);
+			Assert::IsFalse(graph.Front().value.has_value());
+			Assert::AreEqual(size_t(4), graph.Size());
+			// NaN does not reach min / max
+			Assert::AreEqual(1.f, *graph.Min());
+			Assert::AreEqual(3.f, *graph.Max());
+			Assert::AreEqual(3.f, *graph[1].value);
+		}
+		TEST_METHOD(ReadoutReformatsOnlyOnChange)
+		{
+			NumericReadoutCache cache;
+			std::wstring text;
+			Assert::IsTrue(cache.Update(12.345, text));
+			Assert::AreEqual(std::wstring{ L"12.3" }, text);
+			Assert::IsFalse(cache.Update(12.345, text));
+			Assert::IsTrue(cache.Update(1234.5, text));
+			Assert::AreEqual(std::wstring{ L"1234" }, text);
+			Assert::IsTrue(cache.Update(std::numeric_limits<double>::quiet_NaN(), text));
+			Assert::AreEqual(std::wstring{ L"NA" }, text);
+			Assert::IsFalse(cache.Update(std::numeric_limits<double>::quiet_NaN(), text));
+			cache.Reset();
+			Assert::IsTrue(cache.Update(0.5, text));
+			Assert::AreEqual(std::wstring{ L"0.50" }, text);
+		}
+		TEST_METHOD(PollBenchmark)
+		{
+			// 50 widgets polled at 60Hz for 20 seconds with a 10 second graph window
+			constexpr int ticks = 60 * 20;
+			Loadout individual{ 30, 20, 10. };
+			Loadout batched{ 30, 20, 10. };
+			DataFetchBatch batch;
+			batch.Rebuild(batched.packs);
+			double individualSeconds = 0.;
+			double batchedSeconds = 0.;
+			for (int tick = 0; tick < ticks; tick++) {
+				const auto t = tick / 60.;
+				individual.Update(tick);
+				batched.Update(tick);
+				QpcTimer individualTimer;
+				for (auto& p : individual.packs) {
+					p.Populate(t);
+				}
+				individualSeconds += individualTimer.Mark();
+				QpcTimer batchedTimer;
+				batch.Populate(batched.pBlob, t);
+				batchedSeconds += batchedTimer.Mark();
+			}
+			Logger::WriteMessage(std::format("50 widgets @ 60Hz: per pack populate {:.2f}us/tick, "
+				"batched populate {:.2f}us/tick ({:.2f}x)\n",
+				individualSeconds / ticks * 1'000'000., batchedSeconds / ticks * 1'000'000.,
+				individualSeconds / batchedSeconds).c_str());
+			Assert::AreEqual(*individual.packs.back().textData, *batched.packs.back().textData);
+		}
+	};
+}
@@ -0,0 +1,372 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Core/source/win/WinAPI.h>
+#include <CommonUtilities/log/DiagnosticDriver.h>
+#include <CommonUtilities/Qpc.h>
+#include <PresentMonAPI2/Internal.h>
+#include <PresentMonAPI2Loader/Loader.h>
+#include <atomic>
+#include <crtdbg.h>
+#include <format>
+#include <string>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+// heap allocations are counted with a debug heap hook that is installed only for the lifetime of an
+// AllocationCounter and only counts the thread that created it, so that the diagnostic queue paths can
+// be checked for allocations per message without other tests or threads in the module being affected
+// (the debug heap is not present in release builds, where nothing is counted)
+namespace
+{
+	class AllocationCounter
+	{
+	public:
+		AllocationCounter()
+			:
+			threadId_{ GetCurrentThreadId() }
+		{
+			pActive_ = this;
+			pPreviousHook_ = _CrtSetAllocHook(&Hook_);
+		}
+		~AllocationCounter()
+		{
+			_CrtSetAllocHook(pPreviousHook_);
+			pActive_ = nullptr;
+		}
+		AllocationCounter(const AllocationCounter&) = delete;
+		AllocationCounter& operator=(const AllocationCounter&) = delete;
+		static constexpr bool IsAvailable()
+		{
+#ifdef _DEBUG
+			return true;
+#else
+			return false;
+#endif
+		}
+		// allocations made on this thread since the scope was entered
+		size_t GetCount() const { return count_; }
+	private:
+		static int __cdecl Hook_(int allocType, void*, size_t, int blockType, long, const unsigned char*, int)
+		{
+			// blocks allocated by the crt for its own use are not counted (and must not be hooked into)
+			if (blockType == _CRT_BLOCK || (allocType != _HOOK_ALLOC && allocType != _HOOK_REALLOC)) {
+				return TRUE;
+			}
+			if (auto pCounter = pActive_.load(); pCounter && pCounter->threadId_ == GetCurrentThreadId()) {
+				pCounter->count_++;
+			}
+			return TRUE;
+		}
+		static inline std::atomic<AllocationCounter*> pActive_ = nullptr;
+		DWORD threadId_;
+		size_t count_ = 0;
+		_CRT_ALLOC_HOOK pPreviousHook_ = nullptr;
+	};
+
+	// bytes allocated so far on the middleware dll's heap (the dll has its own crt), 0 in release builds
+	size_t GetMiddlewareHeapTotal()
+	{
+#ifdef _DEBUG
+		return pmCreateHeapCheckpoint_().lTotalCount;
+#else
+		return 0;
+#endif
+	}
+}
+
+namespace LoggingTests
+{
+	using namespace pmon::util;
+	using namespace pmon::util::log;
+
+	PM_DIAGNOSTIC_CONFIGURATION MakeQueueConfig()
+	{
+		return PM_DIAGNOSTIC_CONFIGURATION{
+			.filterLevel = PM_DIAGNOSTIC_LEVEL_VERBOSE,
+			.outputFlags = PM_DIAGNOSTIC_OUTPUT_FLAGS_QUEUE,
+			.pSubsystems = nullptr,
+			.nSubsystems = 0,
+			.enableTimestamp = false,
+			.enableTrace = false,
+			.enableLocation = true,
+			.disableDiagnosticFilter = true,
+		};
+	}
+
+	// the error a client gets when polling a target process that has exited
+	Entry MakeStormEntry()
+	{
+		Entry e;
+		e.level_ = Level::Error;
+		e.subsystem_ = Subsystem::Middleware;
+		e.note_ = "Failed to poll dynamic query: target process is no longer running";
+		e.sourceStrings_ = Entry::StaticSourceStrings{ __FILE__, __func__ };
+		e.sourceLine_ = __LINE__;
+		e.timestamp_ = std::chrono::system_clock::now();
+		e.pid_ = 4242;
+		e.tid_ = 2424;
+		e.diagnosticLayer_ = true;
+		return e;
+	}
+
+	TEST_CLASS(TestDiagnosticQueue)
+	{
+	public:
+		TEST_METHOD(OverwritesOldest)
+		{
+			const auto config = MakeQueueConfig();
+			DiagnosticDriver driver{ &config };
+			driver.SetMaxQueuedMessages(4);
+			auto e = MakeStormEntry();
+			for (int i = 0; i < 10; i++) {
+				e.note_ = std::to_string(i);
+				driver.Submit(e);
+			}
+			Assert::AreEqual(4u, driver.GetQueuedMessageCount());
+			Assert::AreEqual(6u, driver.GetDiscardedMessageCount());
+			for (int i = 6; i < 10; i++) {
+				auto pMessage = driver.DequeueMessage();
+				Assert::IsNotNull(pMessage);
+				Assert::AreEqual(std::to_string(i), std::string{ pMessage->pText });
+				Assert::AreEqual(4242u, pMessage->pid);
+				Assert::IsNotNull(pMessage->pLocation);
+				Assert::IsNull(pMessage->pTimestamp);
+				DiagnosticMessage::Free(pMessage);
+			}
+			Assert::IsNull(driver.DequeueMessage());
+		}
+		TEST_METHOD(ShrinkDiscardsOldest)
+		{
+			const auto config = MakeQueueConfig();
+			DiagnosticDriver driver{ &config };
+			auto e = MakeStormEntry();
+			for (int i = 0; i < 8; i++) {
+				e.note_ = std::to_string(i);
+				driver.Submit(e);
+			}
+			driver.SetMaxQueuedMessages(3);
+			Assert::AreEqual(3u, driver.GetQueuedMessageCount());
+			Assert::AreEqual(5u, driver.GetDiscardedMessageCount());
+			auto pMessage = driver.DequeueMessage();
+			Assert::AreEqual(std::string{ "5" }, std::string{ pMessage->pText });
+			DiagnosticMessage::Free(pMessage);
+		}
+		TEST_METHOD(TruncatesLongText)
+		{
+			const auto config = MakeQueueConfig();
+			DiagnosticDriver driver{ &config };
+			auto e = MakeStormEntry();
+			e.note_ = std::string(5000, 'x');
+			driver.Submit(e);
+			auto pMessage = driver.DequeueMessage();
+			const std::string text = pMessage->pText;
+			Assert::AreEqual(size_t(1023), text.size());
+			Assert::AreEqual(std::string(1020, 'x') + "...", text);
+			DiagnosticMessage::Free(pMessage);
+		}
+		TEST_METHOD(TraceMatchesToString)
+		{
+			auto config = MakeQueueConfig();
+			config.enableTrace = true;
+			DiagnosticDriver driver{ &config };
+			auto e = MakeStormEntry();
+			e.pTrace_ = StackTrace::Here();
+			e.pTrace_->Resolve();
+			driver.Submit(e);
+			auto pMessage = driver.DequeueMessage();
+			Assert::IsNotNull(pMessage->pTrace);
+			// the test host stack can be deeper than the inline buffer holds
+			auto expected = e.pTrace_->ToString();
+			if (expected.size() > 2047) {
+				expected = expected.substr(0, 2044) + "...";
+			}
+			Assert::AreEqual(expected, std::string{ pMessage->pTrace });
+			DiagnosticMessage::Free(pMessage);
+		}
+		TEST_METHOD(InjectedMessageCopied)
+		{
+			const auto config = MakeQueueConfig();
+			DiagnosticDriver driver{ &config };
+			std::string text = "injected";
+			const PM_DIAGNOSTIC_MESSAGE injected{
+				.level = PM_DIAGNOSTIC_LEVEL_WARNING,
+				.system = PM_DIAGNOSTIC_SUBSYSTEM_USER,
+				.pText = text.c_str(),
+				.pid = 7,
+			};
+			driver.EnqueueMessage(&injected);
+			text = "modified";
+			auto pMessage = driver.DequeueMessage();
+			Assert::AreEqual(std::string{ "injected" }, std::string{ pMessage->pText });
+			Assert::IsNull(pMessage->pLocation);
+			Assert::AreEqual(7u, pMessage->pid);
+			DiagnosticMessage::Free(pMessage);
+		}
+		TEST_METHOD(MessageOutlivesDriver)
+		{
+			const auto config = MakeQueueConfig();
+			auto pDriver = std::make_unique<DiagnosticDriver>(&config);
+			pDriver->Submit(MakeStormEntry());
+			auto pMessage = pDriver->DequeueMessage();
+			// the client may still hold messages when pmDiagnosticSetup replaces the driver
+			pDriver.reset();
+			Assert::AreEqual(MakeStormEntry().note_, std::string{ pMessage->pText });
+			DiagnosticMessage::Free(pMessage);
+		}
+		TEST_METHOD(ErrorStormBenchmark)
+		{
+			// error logged on every poll at 1 kHz, drained by the client in bursts of 64 polls
+			constexpr size_t messageCount = 200'000;
+			constexpr size_t drainPeriod = 64;
+			const auto entry = MakeStormEntry();
+			const auto config = MakeQueueConfig();
+			DiagnosticDriver driver{ &config };
+			// one drain period so that the pool has grown to the messages in flight
+			for (size_t i = 0; i < drainPeriod; i++) {
+				driver.Submit(entry);
+			}
+			while (auto pMessage = driver.DequeueMessage()) {
+				DiagnosticMessage::Free(pMessage);
+			}
+
+			size_t dequeued = 0;
+			double seconds = 0.;
+			size_t allocationCount = 0;
+			{
+				AllocationCounter allocations;
+				QpcTimer timer;
+				for (size_t i = 0; i < messageCount; i++) {
+					driver.Submit(entry);
+					if (i % drainPeriod == drainPeriod - 1) {
+						while (auto pMessage = driver.DequeueMessage()) {
+							dequeued++;
+							DiagnosticMessage::Free(pMessage);
+						}
+					}
+				}
+				seconds = timer.Mark();
+				allocationCount = allocations.GetCount();
+			}
+
+			Logger::WriteMessage(std::format("{} messages: {:.2f}ms ({:.1f}ns/message, {} allocations)\n",
+				messageCount, seconds * 1000., seconds * 1e9 / messageCount, allocationCount).c_str());
+			Assert::AreEqual(messageCount, dequeued);
+			if (AllocationCounter::IsAvailable()) {
+				Assert::AreEqual(size_t(0), allocationCount);
+			}
+		}
+		TEST_METHOD(OverflowStormBenchmark)
+		{
+			// client stops draining: every submit overwrites the oldest queued message
+			constexpr size_t messageCount = 200'000;
+			const auto entry = MakeStormEntry();
+			const auto config = MakeQueueConfig();
+			DiagnosticDriver driver{ &config };
+			// overflow once so that the pool has grown to the queue size plus the incoming message
+			const size_t warmup = driver.GetMaxQueuedMessages() + 1;
+			for (size_t i = 0; i < warmup; i++) {
+				driver.Submit(entry);
+			}
+
+			double seconds = 0.;
+			size_t allocationCount = 0;
+			{
+				AllocationCounter allocations;
+				QpcTimer timer;
+				for (size_t i = warmup; i < messageCount; i++) {
+					driver.Submit(entry);
+				}
+				seconds = timer.Mark();
+				allocationCount = allocations.GetCount();
+			}
+
+			Logger::WriteMessage(std::format("{} overflowing messages: {:.2f}ms ({:.1f}ns/message)\n",
+				messageCount, seconds * 1000., seconds * 1e9 / messageCount).c_str());
+			Assert::AreEqual(uint32_t(messageCount - driver.GetMaxQueuedMessages()), driver.GetDiscardedMessageCount());
+			if (AllocationCounter::IsAvailable()) {
+				Assert::AreEqual(size_t(0), allocationCount);
+			}
+		}
+	};
+
+	// the same storm as seen by a client of the api: messages are injected and drained through the
+	// loader and the middleware dll, the way an application polls pmDiagnosticDequeueMessage
+	TEST_CLASS(TestDiagnosticApi)
+	{
+	public:
+		TEST_METHOD_INITIALIZE(Init)
+		{
+			pmLoaderSetPathToMiddlewareDll_("./PresentMonAPI2.dll");
+			const auto config = MakeQueueConfig();
+			Assert::AreEqual((int)PM_STATUS_SUCCESS, (int)pmDiagnosticSetup(&config));
+		}
+		TEST_METHOD(DequeueMessage)
+		{
+			const PM_DIAGNOSTIC_MESSAGE injected{
+				.level = PM_DIAGNOSTIC_LEVEL_ERROR,
+				.system = PM_DIAGNOSTIC_SUBSYSTEM_USER,
+				.pText = "injected",
+				.pid = 7,
+			};
+			Assert::AreEqual((int)PM_STATUS_SUCCESS, (int)pmDiagnosticEnqueueMessage(&injected));
+			PM_DIAGNOSTIC_MESSAGE* pMessage = nullptr;
+			Assert::AreEqual((int)PM_STATUS_SUCCESS, (int)pmDiagnosticDequeueMessage(&pMessage));
+			Assert::IsNotNull(pMessage);
+			Assert::AreEqual(std::string{ "injected" }, std::string{ pMessage->pText });
+			Assert::AreEqual(7u, pMessage->pid);
+			Assert::AreEqual((int)PM_STATUS_SUCCESS, (int)pmDiagnosticFreeMessage(pMessage));
+			Assert::AreEqual((int)PM_STATUS_SUCCESS, (int)pmDiagnosticDequeueMessage(&pMessage));
+			Assert::IsNull(pMessage);
+		}
+		TEST_METHOD(DequeueBenchmark)
+		{
+			// error on every poll at 1 kHz, drained by the client in bursts of 64 polls; only the drains are timed
+			constexpr size_t messageCount = 200'000;
+			constexpr size_t drainPeriod = 64;
+			const auto note = MakeStormEntry().note_;
+			const PM_DIAGNOSTIC_MESSAGE message{
+				.level = PM_DIAGNOSTIC_LEVEL_ERROR,
+				.system = PM_DIAGNOSTIC_SUBSYSTEM_MIDDLEWARE,
+				.pText = note.c_str(),
+				.pid = 4242,
+				.tid = 2424,
+			};
+			const auto Drain = [] {
+				size_t count = 0;
+				PM_DIAGNOSTIC_MESSAGE* pMessage = nullptr;
+				while (pmDiagnosticDequeueMessage(&pMessage) == PM_STATUS_SUCCESS && pMessage) {
+					pmDiagnosticFreeMessage(pMessage);
+					count++;
+				}
+				return count;
+			};
+			// one drain period so that the pool has grown to the messages in flight
+			for (size_t i = 0; i < drainPeriod; i++) {
+				pmDiagnosticEnqueueMessage(&message);
+			}
+			Drain();
+
+			const auto heapBefore = GetMiddlewareHeapTotal();
+			size_t dequeued = 0;
+			double dequeueSeconds = 0.;
+			QpcTimer timer;
+			for (size_t i = 0; i < messageCount; i++) {
+				pmDiagnosticEnqueueMessage(&message);
+				if (i % drainPeriod == drainPeriod - 1) {
+					timer.Mark();
+					dequeued += Drain();
+					dequeueSeconds += timer.Mark();
+				}
+			}
+			const auto heapAllocated = GetMiddlewareHeapTotal() - heapBefore;
+
+			Logger::WriteMessage(std::format("{} messages dequeued through the api: {:.2f}ms ({:.1f}ns/message, {} bytes allocated)\n",
+				dequeued, dequeueSeconds * 1000., dequeueSeconds * 1e9 / dequeued, heapAllocated).c_str());
+			Assert::AreEqual(messageCount, dequeued);
+			Assert::AreEqual(0u, pmDiagnosticGetDiscardedMessageCount());
+			Assert::AreEqual(size_t(0), heapAllocated);
+		}
+	};
+}
@@ -0,0 +1,369 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Core/source/win/WinAPI.h>
+#include <PresentMonMiddleware/ConcreteMiddleware.h>
+#include <PresentMonMiddleware/FrameFanoutCache.h>
+#include <ULT/PmFrameGenerator.h>
+#include <CommonUtilities/Qpc.h>
+#include <array>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace MiddlewareTests
+{
+	using namespace pmon::mid;
+	using pmon::util::QpcTimer;
+
+	// roughly the size of a PmNsmFrameData, which is copied out of shared memory when decoded
+	struct FakeFrame
+	{
+		uint64_t sequence = 0;
+		std::array<uint64_t, 256> payload{};
+	};
+
+	// stands in for StreamClient + Context::UpdateSourceData: produces frame n on the nth call
+	class FakeDecoder
+	{
+	public:
+		void Decode(uint64_t sequence, FakeFrame& out)
+		{
+			decodeCount_++;
+			out.sequence = sequence;
+			for (size_t i = 0; i < out.payload.size(); i++) {
+				out.payload[i] = sequence * 31 + i;
+			}
+		}
+		uint64_t GetDecodeCount() const { return decodeCount_; }
+	private:
+		uint64_t decodeCount_ = 0;
+	};
+
+	// frames as the service writes them to shared memory
+	std::vector<PmNsmFrameData> GenerateFrames(int count, double percentDropped)
+	{
+		PmFrameGenerator generator{ PmFrameGenerator::FrameParams{ .percent_dropped = percentDropped } };
+		generator.GenerateFrames(count);
+		std::vector<PmNsmFrameData> frames;
+		for (int i = 0; i < count; i++) {
+			frames.push_back(generator.GetFrameData(i));
+		}
+		return frames;
+	}
+
+	bool IsDisplayed(const PmNsmFrameData& frame)
+	{
+		return frame.present_event.DisplayedCount > 0;
+	}
+
+	// decodes frames [first, last) the way the middleware does from shared memory, the first and
+	// last frames lacking neighbors are never decoded
+	void DecodeFrames(FrameDecodeState& state, const std::vector<PmNsmFrameData>& frames, size_t first, size_t last)
+	{
+		for (size_t i = std::max<size_t>(first, 1); i < std::min(last, frames.size() - 1); i++) {
+			auto iNext = i + 1;
+			while (iNext < frames.size() - 1 && !IsDisplayed(frames[iNext])) {
+				iNext++;
+			}
+			auto iLastDisplayed = i - 1;
+			while (iLastDisplayed > 0 && !IsDisplayed(frames[iLastDisplayed])) {
+				iLastDisplayed--;
+			}
+			state.Decode(&frames[i], &frames[iNext], &frames[i - 1], &frames[iLastDisplayed],
+				&frames[iLastDisplayed > 0 ? iLastDisplayed - 1 : 0]);
+		}
+	}
+
+	// number of frames a query gathers from the source frames [first, last)
+	uint32_t CountGathered(const std::vector<PmNsmFrameData>& frames, size_t first, size_t last)
+	{
+		uint32_t count = 0;
+		for (size_t i = std::max<size_t>(first, 1); i < std::min(last, frames.size() - 1); i++) {
+			count += IsDisplayed(frames[i]) ? frames[i].present_event.DisplayedCount : 1;
+		}
+		return count;
+	}
+
+	// a frame query of universal metrics, which don't need a graphics adapter
+	std::unique_ptr<PM_FRAME_QUERY> MakeBenchmarkQuery()
+	{
+		std::array elements{
+			PM_QUERY_ELEMENT{ PM_METRIC_PRESENT_MODE, PM_STAT_NONE },
+			PM_QUERY_ELEMENT{ PM_METRIC_CPU_START_QPC, PM_STAT_NONE },
+			PM_QUERY_ELEMENT{ PM_METRIC_CPU_FRAME_TIME, PM_STAT_NONE },
+			PM_QUERY_ELEMENT{ PM_METRIC_CPU_BUSY, PM_STAT_NONE },
+			PM_QUERY_ELEMENT{ PM_METRIC_GPU_TIME, PM_STAT_NONE },
+			PM_QUERY_ELEMENT{ PM_METRIC_DISPLAYED_TIME, PM_STAT_NONE },
+			PM_QUERY_ELEMENT{ PM_METRIC_DISPLAY_LATENCY, PM_STAT_NONE },
+			PM_QUERY_ELEMENT{ PM_METRIC_FRAME_TYPE, PM_STAT_NONE },
+			PM_QUERY_ELEMENT{ PM_METRIC_CLICK_TO_PHOTON_LATENCY, PM_STAT_NONE },
+			PM_QUERY_ELEMENT{ PM_METRIC_ALL_INPUT_TO_PHOTON_LATENCY, PM_STAT_NONE },
+		};
+		return std::make_unique<PM_FRAME_QUERY>(elements);
+	}
+
+	// reads up to maxFrames records for the consumer and checks that they come in order
+	uint64_t Consume(FrameFanoutCache<FakeFrame>& cache, const void* pConsumer, uint64_t maxFrames, uint64_t& expectedNext)
+	{
+		auto sequence = cache.GetCursor(pConsumer);
+		uint64_t checksum = 0;
+		const auto end = sequence + std::min(cache.GetEnd() - sequence, maxFrames);
+		for (; sequence < end; sequence++) {
+			auto& frame = cache.At(sequence);
+			Assert::AreEqual(expectedNext, frame.sequence);
+			checksum += std::accumulate(frame.payload.begin(), frame.payload.end(), uint64_t(0));
+			expectedNext++;
+		}
+		cache.SetCursor(pConsumer, sequence);
+		return checksum;
+	}
+
+	TEST_CLASS(TestFrameFanoutCache)
+	{
+	public:
+		TEST_METHOD(EachConsumerSeesEveryFrameOnce)
+		{
+			for (size_t consumerCount : { 1, 4, 16 }) {
+				FrameFanoutCache<FakeFrame> cache{ 512 };
+				FakeDecoder decoder;
+				std::vector<int> consumers(consumerCount);
+				std::vector<uint64_t> expectedNext(consumerCount, 0);
+				uint64_t produced = 0;
+				for (int poll = 0; poll < 200; poll++) {
+					// frames arrive in bursts and are decoded once
+					for (int n = 0; n < 1 + poll % 7; n++) {
+						decoder.Decode(produced++, cache.Push());
+					}
+					// consumers drain at different rates, but all keep up over time
+					for (size_t c = 0; c < consumerCount; c++) {
+						Consume(cache, &consumers[c], 4 + c, expectedNext[c]);
+					}
+				}
+				for (size_t c = 0; c < consumerCount; c++) {
+					Consume(cache, &consumers[c], UINT64_MAX, expectedNext[c]);
+					Assert::AreEqual(produced, expectedNext[c]);
+				}
+				Assert::AreEqual(produced, decoder.GetDecodeCount());
+				Assert::AreEqual(consumerCount, cache.GetConsumerCount());
+			}
+		}
+		TEST_METHOD(LaggingConsumerResumesAtOldest)
+		{
+			FrameFanoutCache<FakeFrame> cache{ 8 };
+			FakeDecoder decoder;
+			int fast = 0, slow = 0;
+			uint64_t fastNext = 0, slowNext = 0;
+			for (uint64_t i = 0; i < 4; i++) {
+				decoder.Decode(i, cache.Push());
+			}
+			Consume(cache, &fast, UINT64_MAX, fastNext);
+			Consume(cache, &slow, 2, slowNext);
+			for (uint64_t i = 4; i < 20; i++) {
+				decoder.Decode(i, cache.Push());
+			}
+			Assert::AreEqual(uint64_t(12), cache.GetBegin());
+			// frames 2 through 11 were overwritten before the slow consumer got to them
+			slowNext = 12;
+			Consume(cache, &slow, UINT64_MAX, slowNext);
+			fastNext = 12;
+			Consume(cache, &fast, UINT64_MAX, fastNext);
+			Assert::AreEqual(uint64_t(20), slowNext);
+			Assert::AreEqual(uint64_t(20), fastNext);
+		}
+		TEST_METHOD(NewConsumerStartsAtOldest)
+		{
+			FrameFanoutCache<FakeFrame> cache{ 8 };
+			FakeDecoder decoder;
+			for (uint64_t i = 0; i < 5; i++) {
+				decoder.Decode(i, cache.Push());
+			}
+			int first = 0;
+			Assert::AreEqual(uint64_t(0), cache.GetCursor(&first));
+			for (uint64_t i = 5; i < 10; i++) {
+				decoder.Decode(i, cache.Push());
+			}
+			int second = 0;
+			Assert::AreEqual(uint64_t(2), cache.GetCursor(&second));
+			cache.RemoveCursor(&first);
+			cache.RemoveCursor(&second);
+			Assert::AreEqual(size_t(0), cache.GetConsumerCount());
+		}
+		TEST_METHOD(AddedConsumerStartsAtEnd)
+		{
+			FrameFanoutCache<FakeFrame> cache{ 8 };
+			FakeDecoder decoder;
+			for (uint64_t i = 0; i < 5; i++) {
+				decoder.Decode(i, cache.Push());
+			}
+			// a consumer registered now must not see frames that predate it
+			int added = 0;
+			cache.AddCursor(&added);
+			Assert::AreEqual(uint64_t(5), cache.GetCursor(&added));
+			decoder.Decode(5, cache.Push());
+			uint64_t expectedNext = 5;
+			Consume(cache, &added, UINT64_MAX, expectedNext);
+			Assert::AreEqual(uint64_t(6), expectedNext);
+		}
+		TEST_METHOD(EmptyBlobConsumesNothing)
+		{
+			const auto frames = GenerateFrames(64, 10.);
+			const auto pQuery = MakeBenchmarkQuery();
+			FrameDecodeState state{ 256, 0, 10'000'000 };
+			DecodeFrames(state, frames, 0, 32);
+			std::vector<uint8_t> blob(pQuery->GetBlobSize() * 64);
+			Assert::AreEqual(0u, state.Gather(*pQuery, blob.data(), 0));
+			Assert::AreEqual(0u, state.Gather(*pQuery, blob.data(), 0));
+			// every frame is still there for a query that later offers room for them
+			Assert::AreEqual(CountGathered(frames, 0, 32), state.Gather(*pQuery, blob.data(), 64));
+		}
+		TEST_METHOD(OversizedFrameIsSkipped)
+		{
+			auto frames = GenerateFrames(64, 0.);
+			// frame 4 is displayed twice so it can never fit a single frame blob
+			auto& pe = frames[4].present_event;
+			pe.DisplayedCount = 2;
+			pe.Displayed_ScreenTime[1] = pe.Displayed_ScreenTime[0] + 10'000;
+			pe.Displayed_FrameType[1] = FrameType::Intel_XEFG;
+			const auto pQuery = MakeBenchmarkQuery();
+			std::vector<uint8_t> blob(pQuery->GetBlobSize());
+			// through the ring, where more than one query consumes the frames
+			{
+				FrameDecodeState state{ 256, 0, 10'000'000 };
+				int other = 0;
+				state.frames.AddCursor(pQuery.get());
+				state.frames.AddCursor(&other);
+				DecodeFrames(state, frames, 4, 5);
+				DecodeFrames(state, frames, 6, 7);
+				Assert::AreEqual(1u, state.Gather(*pQuery, blob.data(), 1));
+				Assert::AreEqual(0u, state.Gather(*pQuery, blob.data(), 1));
+			}
+			// gathered while decoding, where the query is the only consumer
+			{
+				FrameDecodeState state{ 256, 0, 10'000'000 };
+				state.GatherWhileDecoding(*pQuery, blob.data(), 1);
+				DecodeFrames(state, frames, 4, 5);
+				DecodeFrames(state, frames, 6, 7);
+				Assert::AreEqual(1u, state.Gather(*pQuery, blob.data(), 1));
+				Assert::AreEqual(0u, state.Gather(*pQuery, blob.data(), 1));
+			}
+		}
+		TEST_METHOD(DroppedInputGoesToNextDisplayedOnly)
+		{
+			auto frames = GenerateFrames(8, 0.);
+			for (auto& frame : frames) {
+				frame.present_event.MouseClickTime = 0;
+				frame.present_event.InputTime = 0;
+			}
+			// input arrives with frame 2, which is dropped, frames 3 and 4 are displayed
+			auto& dropped = frames[2].present_event;
+			dropped.FinalState = PresentResult::Discarded;
+			dropped.DisplayedCount = 0;
+			dropped.MouseClickTime = dropped.PresentStartTime;
+			dropped.InputTime = dropped.PresentStartTime;
+			std::array elements{
+				PM_QUERY_ELEMENT{ PM_METRIC_CLICK_TO_PHOTON_LATENCY, PM_STAT_NONE },
+				PM_QUERY_ELEMENT{ PM_METRIC_ALL_INPUT_TO_PHOTON_LATENCY, PM_STAT_NONE },
+			};
+			PM_FRAME_QUERY query{ elements };
+			std::vector<uint8_t> blob(query.GetBlobSize() * 3);
+			const auto checkLatencies = [&] {
+				const auto latency = [&](size_t frame, const PM_QUERY_ELEMENT& element) {
+					return reinterpret_cast<const double&>(blob[frame * query.GetBlobSize() + element.dataOffset]);
+				};
+				for (auto& element : elements) {
+					Assert::IsTrue(std::isnan(latency(0, element)));
+					Assert::IsTrue(latency(1, element) > 0.);
+					Assert::IsTrue(std::isnan(latency(2, element)));
+				}
+			};
+			// through the ring, where more than one query consumes the frames
+			{
+				FrameDecodeState state{ 256, 0, 10'000'000 };
+				int other = 0;
+				state.frames.AddCursor(&query);
+				state.frames.AddCursor(&other);
+				DecodeFrames(state, frames, 2, 5);
+				Assert::AreEqual(3u, state.Gather(query, blob.data(), 3));
+				checkLatencies();
+			}
+			// gathered while decoding, where the query is the only consumer
+			{
+				FrameDecodeState state{ 256, 0, 10'000'000 };
+				state.GatherWhileDecoding(query, blob.data(), 3);
+				DecodeFrames(state, frames, 2, 5);
+				Assert::AreEqual(uint64_t(0), state.frames.GetEnd());
+				Assert::AreEqual(3u, state.Gather(query, blob.data(), 3));
+				checkLatencies();
+			}
+		}
+		TEST_METHOD(SharedDecodeBenchmark)
+		{
+			constexpr size_t pollCount = 320;
+			constexpr size_t framesPerPoll = 64;
+			constexpr uint32_t maxFramesPerGather = 2 * framesPerPoll;
+			const auto frames = GenerateFrames(int(pollCount * framesPerPoll + 2), 10.);
+			for (size_t consumerCount : { 1, 4, 16 }) {
+				std::vector<std::unique_ptr<PM_FRAME_QUERY>> queries;
+				for (size_t c = 0; c < consumerCount; c++) {
+					queries.push_back(MakeBenchmarkQuery());
+				}
+				std::vector<uint8_t> blob(queries.front()->GetBlobSize() * maxFramesPerGather);
+				const auto gatherChecksum = [&](FrameDecodeState& state, const PM_FRAME_QUERY& query) {
+					const auto count = state.Gather(query, blob.data(), maxFramesPerGather);
+					return std::accumulate(blob.begin(), blob.begin() + count * query.GetBlobSize(), uint64_t(0));
+				};
+				// every query decodes each frame itself and, as the only consumer of its state,
+				// gathers it while decoding, as before decoded frames were shared
+				double separateSeconds = 0.;
+				uint64_t separateChecksum = 0;
+				{
+					std::vector<std::unique_ptr<FrameDecodeState>> states;
+					for (size_t c = 0; c < consumerCount; c++) {
+						states.push_back(std::make_unique<FrameDecodeState>(1024, 0, 10'000'000));
+					}
+					QpcTimer timer;
+					for (size_t p = 0; p < pollCount; p++) {
+						for (size_t c = 0; c < consumerCount; c++) {
+							states[c]->GatherWhileDecoding(*queries[c], blob.data(), maxFramesPerGather);
+							DecodeFrames(*states[c], frames, p * framesPerPoll, (p + 1) * framesPerPoll);
+							separateChecksum += gatherChecksum(*states[c], *queries[c]);
+						}
+					}
+					separateSeconds = timer.Mark();
+				}
+				// frames are decoded once and every query gathers them through its own cursor, as
+				// the middleware does when the first query of a poll decodes the new frames
+				double sharedSeconds = 0.;
+				uint64_t sharedChecksum = 0;
+				{
+					FrameDecodeState state{ 1024, 0, 10'000'000 };
+					for (auto& pQuery : queries) {
+						state.frames.AddCursor(pQuery.get());
+					}
+					QpcTimer timer;
+					for (size_t p = 0; p < pollCount; p++) {
+						for (size_t c = 0; c < consumerCount; c++) {
+							state.GatherWhileDecoding(*queries[c], blob.data(), maxFramesPerGather);
+							if (c == 0) {
+								DecodeFrames(state, frames, p * framesPerPoll, (p + 1) * framesPerPoll);
+							}
+							sharedChecksum += gatherChecksum(state, *queries[c]);
+						}
+					}
+					sharedSeconds = timer.Mark();
+				}
+				Logger::WriteMessage(std::format("{:>2} queries of {} frames: separate decode {:.2f}ms, "
+					"shared decode {:.2f}ms ({:.2f}x)\n", consumerCount, pollCount * framesPerPoll,
+					separateSeconds * 1000., sharedSeconds * 1000., separateSeconds / sharedSeconds).c_str());
+				Assert::AreNotEqual(uint64_t(0), sharedChecksum);
+				Assert::AreEqual(separateChecksum, sharedChecksum);
+			}
+		}
+	};
+}
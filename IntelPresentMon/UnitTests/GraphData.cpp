@@ -0,0 +1,257 @@
+// Copyright (C) 2023 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include <CppUnitTest.h>
+
+#include <Core/source/gfx/layout/GraphData.h>
+#include <CommonUtilities/Qpc.h>
+#include <format>
+#include <random>
+#include <cmath>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+
+namespace AlgorithmTests
+{
+	using namespace p2c::gfx::lay;
+
+	// fill a graph with a full window of noisy samples at the given poll rate, as DataFetchPack does
+	double FillGraph(GraphData& data, double pollRate, double seconds, uint32_t seed = 0)
+	{
+		std::minstd_rand rng{ seed };
+		std::uniform_real_distribution<float> dist{ 0.f, 100.f };
+		const auto dt = 1. / pollRate;
+		double t = 0.;
+		for (size_t i = 0; i < size_t(seconds * pollRate); i++) {
+			t += dt;
+			data.Push(DataPoint{ .value = dist(rng), .time = t });
+			data.Trim(t);
+		}
+		return t;
+	}
+
+	TEST_CLASS(TestGraphData)
+	{
+	public:
+		TEST_METHOD(RingOrderAcrossGrowth)
+		{
+			GraphData data{ 1000. };
+			for (int i = 0; i < 100; i++) {
+				data.Push(DataPoint{ .value = i % 10 ? std::optional{ float(i) } : std::nullopt, .time = double(i) });
+			}
+			Assert::AreEqual(100ull, data.Size());
+			Assert::AreEqual(99., data.Front().time);
+			Assert::AreEqual(0., data.Back().time);
+			for (size_t i = 0; i < data.Size(); i++) {
+				const auto d = data[i];
+				Assert::AreEqual(double(99 - i), d.time);
+				Assert::AreEqual((99 - i) % 10 != 0, d.value.has_value());
+			}
+			Assert::AreEqual(1.f, *data.Min());
+			Assert::AreEqual(99.f, *data.Max());
+		}
+		TEST_METHOD(TrimKeepsOneSampleBeyondWindow)
+		{
+			GraphData data{ 10. };
+			for (int i = 0; i < 100; i++) {
+				data.Push(DataPoint{ .value = float(i), .time = double(i) });
+				data.Trim(double(i));
+			}
+			// window is [89, 99], 88 is kept so the line reaches the left edge of the plot
+			Assert::AreEqual(12ull, data.Size());
+			Assert::AreEqual(88., data.Back().time);
+			Assert::AreEqual(88.f, *data.Min());
+		}
+		TEST_METHOD(DecimatedColumnsMatchSamples)
+		{
+			constexpr size_t columnCount = 300;
+			GraphData data{ 10. };
+			data.RequestColumns(columnCount);
+			FillGraph(data, 1000., 25.);
+			const auto columnWidth = data.GetWindowSize() / double(columnCount);
+			Assert::IsTrue(data.GetColumnCount() <= columnCount + 2);
+			// every column but the oldest (which may hold samples already trimmed) matches the raw samples
+			for (size_t c = 0; c + 1 < data.GetColumnCount(); c++) {
+				const auto& col = data.GetColumn(c);
+				float min = std::numeric_limits<float>::max();
+				float max = std::numeric_limits<float>::lowest();
+				for (size_t i = 0; i < data.Size(); i++) {
+					if (const auto d = data[i]; (int64_t)std::floor(d.time / columnWidth) == col.index) {
+						min = std::min(min, *d.value);
+						max = std::max(max, *d.value);
+					}
+				}
+				Assert::AreEqual(min, col.minValue);
+				Assert::AreEqual(max, col.maxValue);
+			}
+			std::vector<DataPoint> vertices;
+			data.MakeDecimatedLine(vertices);
+			Assert::IsTrue(vertices.size() <= data.GetColumnCount() * 2 + 1);
+			Assert::AreEqual(data.Front().time, vertices.front().time);
+		}
+		TEST_METHOD(DrawCostBenchmark)
+		{
+			// draw cost is walking the line vertices once per frame; compare walking every sample in the
+			// window (previous behavior) to walking the decimated view, for a 400px wide plot
+			constexpr size_t plotWidth = 400;
+			constexpr int frames = 200;
+			std::vector<DataPoint> vertices;
+			double smallestDecimated = 0.;
+			double largestDecimated = 0.;
+			double largestRaw = 0.;
+			for (auto window : { 2., 10., 30. }) {
+				for (auto rate : { 60., 1000., 4000. }) {
+					GraphData data{ window };
+					data.RequestColumns(plotWidth);
+					FillGraph(data, rate, window * 1.5);
+					double sum = 0.;
+					QpcTimer rawTimer;
+					for (int f = 0; f < frames; f++) {
+						for (size_t i = 0; i < data.Size(); i++) {
+							sum += data[i].value.value_or(0.f);
+						}
+					}
+					const auto raw = rawTimer.Mark() / frames;
+					QpcTimer decimatedTimer;
+					for (int f = 0; f < frames; f++) {
+						data.MakeDecimatedLine(vertices);
+						for (auto& v : vertices) {
+							sum += *v.value;
+						}
+					}
+					const auto decimated = decimatedTimer.Mark() / frames;
+					Assert::IsTrue(sum > 0.);
+					Assert::IsTrue(vertices.size() <= (plotWidth + 2) * 2 + 1);
+					Logger::WriteMessage(std::format("window {:>4.0f}s @ {:>5.0f}Hz: samples {:>6}, vertices {:>4}, "
+						"raw {:>8.2f}us, decimated {:>6.2f}us\n", window, rate, data.Size(), vertices.size(),
+						raw * 1'000'000., decimated * 1'000'000.).c_str());
+					if (window == 2. && rate == 60.) {
+						smallestDecimated = decimated;
+					}
+					largestDecimated = decimated;
+					largestRaw = raw;
+				}
+			}
+			Logger::WriteMessage(std::format("decimated draw cost growth from 120 to 120k samples: {:.2f}x\n",
+				largestDecimated / smallestDecimated).c_str());
+			Assert::IsTrue(largestDecimated < largestRaw);
+		}
+	};
+
+	// bins as previously recomputed on every draw, from every sample in the window
+	std::vector<int> RecomputeBins(const GraphData& data, float minValue, float maxValue, int binCount, double window, int& maxCount)
+	{
+		std::vector<int> bins(size_t(binCount), 0);
+		maxCount = 0;
+		const auto binSize = (maxValue - minValue) / float(binCount);
+		const auto cutoff = (data.Size() > 0 ? data.Front().time : 0.) - window;
+		for (size_t i = 0; i < data.Size(); i++) {
+			const auto d = data[i];
+			if (d.time <= cutoff) {
+				break;
+			}
+			if (!d.value) {
+				continue;
+			}
+			if (const auto pos = (*d.value - minValue) / binSize; pos >= 0.f && pos < float(binCount)) {
+				maxCount = std::max(maxCount, ++bins[size_t(pos)]);
+			}
+		}
+		return bins;
+	}
+
+	TEST_CLASS(TestHistogramBins)
+	{
+	public:
+		TEST_METHOD(IncrementalMatchesRecompute)
+		{
+			// data window longer and shorter than histogram window, to exercise both expiry and trim removal
+			for (auto dataWindow : { 2., 8. }) {
+				GraphData data{ dataWindow };
+				auto pBins = std::make_shared<HistogramBins>();
+				data.AttachHistogram(pBins);
+				float minValue = 0.f, maxValue = 100.f;
+				int binCount = 40;
+				double window = 5.;
+				pBins->Configure(data, minValue, maxValue, binCount, window);
+				std::minstd_rand rng{ 7 };
+				std::normal_distribution<float> dist{ 50.f, 25.f };
+				double t = 0.;
+				for (int i = 0; i < 20'000; i++) {
+					t += 0.001 + 0.002 * double(i % 3);
+					data.Push(DataPoint{ .value = i % 13 ? std::optional{ dist(rng) } : std::nullopt, .time = t });
+					data.Trim(t);
+					// reconfigure now and then, as autoscaling and style changes do
+					if (i % 4'000 == 3'999) {
+						minValue -= 10.f;
+						maxValue += 5.f;
+						binCount += 7;
+						window = window == 5. ? 1.5 : 5.;
+						pBins->Configure(data, minValue, maxValue, binCount, window);
+					}
+					if (i % 97 == 0) {
+						int expectedMax = 0;
+						const auto expected = RecomputeBins(data, minValue, maxValue, binCount, window, expectedMax);
+						Assert::IsTrue(expected == pBins->GetBins());
+						Assert::AreEqual(expectedMax, pBins->GetMaxCount());
+					}
+				}
+			}
+		}
+		TEST_METHOD(DetachesWhenDestroyed)
+		{
+			GraphData data{ 1. };
+			auto pBins = std::make_shared<HistogramBins>();
+			data.AttachHistogram(pBins);
+			pBins->Configure(data, 0.f, 10.f, 10, 1.);
+			data.Push(DataPoint{ .value = 5.f, .time = 0. });
+			Assert::AreEqual(1, pBins->GetMaxCount());
+			pBins.reset();
+			data.Push(DataPoint{ .value = 5.f, .time = 0.1 });
+			data.Trim(0.1);
+		}
+		TEST_METHOD(DrawCostBenchmark)
+		{
+			// per frame cost of producing the bins: full rebin of the window vs reading the incremental bins
+			constexpr int frames = 200;
+			constexpr int binCount = 40;
+			double smallestIncremental = 0.;
+			double largestIncremental = 0.;
+			double largestRecompute = 0.;
+			for (auto window : { 1., 10., 60. }) {
+				GraphData data{ window };
+				auto pBins = std::make_shared<HistogramBins>();
+				data.AttachHistogram(pBins);
+				pBins->Configure(data, 0.f, 100.f, binCount, window);
+				FillGraph(data, 1000., window * 1.5);
+				int sink = 0;
+				QpcTimer recomputeTimer;
+				for (int f = 0; f < frames; f++) {
+					int maxCount = 0;
+					sink += RecomputeBins(data, 0.f, 100.f, binCount, window, maxCount)[f % binCount] + maxCount;
+				}
+				const auto recompute = recomputeTimer.Mark() / frames;
+				QpcTimer incrementalTimer;
+				for (int f = 0; f < frames; f++) {
+					for (auto count : pBins->GetBins()) {
+						sink += count;
+					}
+					sink += pBins->GetMaxCount();
+				}
+				const auto incremental = incrementalTimer.Mark() / frames;
+				Assert::IsTrue(sink > 0);
+				Logger::WriteMessage(std::format("histogram window {:>3.0f}s @ 1000Hz: samples {:>6}, recompute {:>8.2f}us, "
+					"incremental {:>6.3f}us\n", window, data.Size(), recompute * 1'000'000., incremental * 1'000'000.).c_str());
+				if (window == 1.) {
+					smallestIncremental = incremental;
+				}
+				largestIncremental = incremental;
+				largestRecompute = recompute;
+			}
+			Logger::WriteMessage(std::format("incremental histogram draw cost growth from 1s to 60s window: {:.2f}x\n",
+				largestIncremental / smallestIncremental).c_str());
+			Assert::IsTrue(largestIncremental < largestRecompute);
+		}
+	};
+}
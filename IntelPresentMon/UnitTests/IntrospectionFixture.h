@@ -0,0 +1,72 @@
+#pragma once
+#include <Core/source/win/WinAPI.h>
+#include <Interprocess/source/IntrospectionTransfer.h>
+#include <Interprocess/source/IntrospectionPopulators.h>
+#include <Interprocess/source/IntrospectionCloneAllocators.h>
+#include <format>
+#include <string>
+
+namespace InterprocessTests
+{
+	using namespace pmon;
+	using namespace pmon::ipc;
+
+	// introspection tree populated in a private shared memory segment, as the service does
+	class IntrospectionFixture
+	{
+	public:
+		IntrospectionFixture()
+			:
+			name_{ std::format("pm-unit-intro-{}", GetCurrentProcessId()) },
+			shm_{ bip::create_only, name_.c_str(), 0x10'0000 },
+			pRoot_{ ShmMakeUnique<intro::IntrospectionRoot>(shm_.get_segment_manager(), shm_.get_segment_manager()) }
+		{
+			auto pSegmentManager = shm_.get_segment_manager();
+			intro::PopulateEnums(pSegmentManager, *pRoot_);
+			intro::PopulateMetrics(pSegmentManager, *pRoot_);
+			intro::PopulateUnits(pSegmentManager, *pRoot_);
+			pRoot_->AddDevice(ShmMakeUnique<intro::IntrospectionDevice>(pSegmentManager,
+				0, PM_DEVICE_TYPE_INDEPENDENT, PM_DEVICE_VENDOR_UNKNOWN,
+				ShmString{ "Device-independent", pSegmentManager->get_allocator<char>() }));
+			pRoot_->Sort();
+		}
+		const intro::IntrospectionRoot& GetRoot() const { return *pRoot_; }
+		const std::string& GetSegmentName() const { return name_; }
+		// same devices as intro::RegisterMockIntrospectionDevices registers through the service comms
+		void AddMockDevices()
+		{
+			auto pSegmentManager = shm_.get_segment_manager();
+			{
+				CpuTelemetryBitset caps;
+				caps.set(size_t(CpuTelemetryCapBits::cpu_utilization));
+				intro::PopulateCpu(pSegmentManager, *pRoot_, PM_DEVICE_VENDOR_INTEL, "Core i7 4770k", caps);
+			}
+			{
+				GpuTelemetryBitset caps;
+				caps.set(size_t(GpuTelemetryCapBits::gpu_power));
+				caps.set(size_t(GpuTelemetryCapBits::fan_speed_0));
+				intro::PopulateGpuDevice(pSegmentManager, *pRoot_, 1, PM_DEVICE_VENDOR_INTEL, "Arc 750", caps);
+			}
+			{
+				GpuTelemetryBitset caps;
+				caps.set(size_t(GpuTelemetryCapBits::gpu_power));
+				caps.set(size_t(GpuTelemetryCapBits::fan_speed_0));
+				caps.set(size_t(GpuTelemetryCapBits::fan_speed_1));
+				intro::PopulateGpuDevice(pSegmentManager, *pRoot_, 2, PM_DEVICE_VENDOR_NVIDIA, "GeForce RTX 2080 ti", caps);
+			}
+			pRoot_->Sort();
+		}
+		// the previous client path: walk the shared memory tree twice (probe + clone)
+		const PM_INTROSPECTION_ROOT* CloneTree() const
+		{
+			intro::ProbeAllocator<void> probeAllocator;
+			pRoot_->ApiClone(probeAllocator);
+			intro::BlockAllocator<void> blockAllocator{ probeAllocator.GetTotalSize() };
+			return pRoot_->ApiClone(blockAllocator);
+		}
+	private:
+		std::string name_;
+		ShmSegment shm_;
+		ShmUniquePtr<intro::IntrospectionRoot> pRoot_;
+	};
+}
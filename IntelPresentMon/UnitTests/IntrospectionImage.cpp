@@ -0,0 +1,224 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Core/source/win/WinAPI.h>
+#include <Interprocess/source/IntrospectionImage.h>
+#include <Interprocess/source/Interprocess.h>
+#include <PresentMonMiddleware/MockCommon.h>
+#include <PresentMonAPIWrapperCommon/Introspection.h>
+#include <PresentMonAPIWrapperCommon/Exception.h>
+#include "IntrospectionFixture.h"
+#include <CommonUtilities/Qpc.h>
+#include <format>
+#include <cstring>
+#include <ranges>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace InterprocessTests
+{
+	using namespace pmon;
+	using namespace pmon::util;
+	using namespace pmon::ipc;
+	using namespace std::string_literals;
+
+	std::string_view ApiString(const PM_INTROSPECTION_STRING* pString)
+	{
+		return pString->pData;
+	}
+
+	void FreeApiRoot(const PM_INTROSPECTION_ROOT* pRoot)
+	{
+		free(const_cast<PM_INTROSPECTION_ROOT*>(pRoot));
+	}
+
+	constexpr uint64_t versionStamp = 0x1234'5678'9ABCull;
+
+	TEST_CLASS(TestIntrospectionImage)
+	{
+	public:
+		TEST_METHOD(RelocatedCloneMatchesTree)
+		{
+			IntrospectionFixture fix;
+			const auto image = intro::BuildIntrospectionImage(fix.GetRoot(), versionStamp);
+			intro::IntrospectionImageView view{ image };
+			auto pExpected = fix.CloneTree();
+			auto pActual = view.CloneRelocated();
+			Assert::AreEqual(pExpected->pMetrics->size, pActual->pMetrics->size);
+			for (size_t i = 0; i < pExpected->pMetrics->size; i++) {
+				auto& em = *static_cast<const PM_INTROSPECTION_METRIC*>(pExpected->pMetrics->pData[i]);
+				auto& am = *static_cast<const PM_INTROSPECTION_METRIC*>(pActual->pMetrics->pData[i]);
+				Assert::AreEqual((int)em.id, (int)am.id);
+				Assert::AreEqual((int)em.pTypeInfo->polledType, (int)am.pTypeInfo->polledType);
+				Assert::AreEqual(em.pStatInfo->size, am.pStatInfo->size);
+			}
+			Assert::AreEqual(pExpected->pEnums->size, pActual->pEnums->size);
+			for (size_t i = 0; i < pExpected->pEnums->size; i++) {
+				auto& ee = *static_cast<const PM_INTROSPECTION_ENUM*>(pExpected->pEnums->pData[i]);
+				auto& ae = *static_cast<const PM_INTROSPECTION_ENUM*>(pActual->pEnums->pData[i]);
+				Assert::IsTrue(ApiString(ee.pSymbol) == ApiString(ae.pSymbol));
+				Assert::AreEqual(ee.pKeys->size, ae.pKeys->size);
+				for (size_t k = 0; k < ee.pKeys->size; k++) {
+					auto& ek = *static_cast<const PM_INTROSPECTION_ENUM_KEY*>(ee.pKeys->pData[k]);
+					auto& ak = *static_cast<const PM_INTROSPECTION_ENUM_KEY*>(ae.pKeys->pData[k]);
+					Assert::IsTrue(ApiString(ek.pName) == ApiString(ak.pName));
+				}
+			}
+			free(const_cast<PM_INTROSPECTION_ROOT*>(pExpected));
+			free(const_cast<PM_INTROSPECTION_ROOT*>(pActual));
+		}
+		TEST_METHOD(IndexedLookups)
+		{
+			IntrospectionFixture fix;
+			fix.AddMockDevices();
+			const auto image = intro::BuildIntrospectionImage(fix.GetRoot(), versionStamp);
+			intro::IntrospectionImageView view{ image };
+			Assert::AreEqual(versionStamp, view.GetVersionStamp());
+			// every structure in the relocated tree is found through the image indices at the same body offset
+			pmapi::intro::Root root{ view.CloneRelocated(), FreeApiRoot };
+			const auto base = reinterpret_cast<const std::byte*>(root.GetMetrics().begin()->GetBasePtr()) -
+				reinterpret_cast<const std::byte*>(view.FindMetric(root.GetMetrics().begin()->GetId()));
+			const auto sameOffset = [&](const void* pImage, const void* pTree) {
+				return pImage && reinterpret_cast<const std::byte*>(pImage) + base == pTree;
+			};
+			for (auto m : root.GetMetrics()) {
+				Assert::IsTrue(sameOffset(view.FindMetric(m.GetId()), m.GetBasePtr()));
+			}
+			for (auto e : root.GetEnums()) {
+				Assert::IsTrue(sameOffset(view.FindEnum(e.GetId()), e.GetBasePtr()));
+				for (auto k : e.GetKeys()) {
+					Assert::IsTrue(sameOffset(view.FindEnumKey(e.GetId(), k.GetId()), k.GetBasePtr()));
+				}
+			}
+			for (auto d : root.GetDevices()) {
+				Assert::IsTrue(sameOffset(view.FindDevice(d.GetId()), d.GetBasePtr()));
+			}
+			for (auto u : root.GetUnits()) {
+				Assert::IsTrue(sameOffset(view.FindUnit(u.GetId()), u.GetBasePtr()));
+			}
+			Assert::IsNull(view.FindMetric(PM_METRIC(-1)));
+			Assert::IsNull(view.FindEnumKey(PM_ENUM_STATUS, -1));
+			Assert::IsNull(view.FindDevice(99));
+			Assert::IsTrue(view.ResolveString(view.FindEnum(PM_ENUM_STATUS)->pSymbol) == "PM_STATUS");
+		}
+		TEST_METHOD(InPlaceRootMatchesRelocated)
+		{
+			IntrospectionFixture fix;
+			fix.AddMockDevices();
+			const auto image = intro::BuildIntrospectionImage(fix.GetRoot(), versionStamp);
+			intro::IntrospectionImageView view{ image };
+			pmapi::intro::Root expected{ view.CloneRelocated(), FreeApiRoot };
+			pmapi::intro::Root actual{ view };
+			Assert::AreEqual((size_t)std::ranges::distance(expected.GetMetrics()), (size_t)std::ranges::distance(actual.GetMetrics()));
+			for (auto em : expected.GetMetrics()) {
+				auto am = actual.FindMetric(em.GetId());
+				Assert::IsTrue(em.Introspect().GetSymbol() == am.Introspect().GetSymbol());
+				Assert::AreEqual((int)em.GetDataTypeInfo().GetPolledType(), (int)am.GetDataTypeInfo().GetPolledType());
+				Assert::AreEqual((size_t)std::ranges::distance(em.GetStatInfo()), (size_t)std::ranges::distance(am.GetStatInfo()));
+				const auto edi = em.GetDeviceMetricInfo();
+				const auto adi = am.GetDeviceMetricInfo();
+				Assert::AreEqual(std::ranges::distance(edi), std::ranges::distance(adi));
+				for (ptrdiff_t i = 0; i < std::ranges::distance(edi); i++) {
+					Assert::IsTrue(edi.begin()[i].GetDevice().GetName() == adi.begin()[i].GetDevice().GetName());
+					Assert::AreEqual(edi.begin()[i].GetArraySize(), adi.begin()[i].GetArraySize());
+				}
+			}
+			for (auto ee : expected.GetEnums()) {
+				auto ae = actual.FindEnum(ee.GetId());
+				Assert::IsTrue(ee.GetDescription() == ae.GetDescription());
+				const auto eks = ee.GetKeys();
+				const auto aks = ae.GetKeys();
+				Assert::AreEqual(std::ranges::distance(eks), std::ranges::distance(aks));
+				for (ptrdiff_t i = 0; i < std::ranges::distance(eks); i++) {
+					Assert::IsTrue(eks.begin()[i].GetName() == aks.begin()[i].GetName());
+					Assert::IsTrue(eks.begin()[i].GetShortName() == aks.begin()[i].GetShortName());
+				}
+			}
+			Assert::AreEqual(expected.FindUnit(PM_UNIT_SECONDS).MakeConversionFactor(PM_UNIT_MILLISECONDS),
+				actual.FindUnit(PM_UNIT_SECONDS).MakeConversionFactor(PM_UNIT_MILLISECONDS));
+			Assert::ExpectException<pmapi::LookupException>([&] { actual.FindDevice(99); });
+		}
+		TEST_METHOD(PublishedImageReplacesTree)
+		{
+			const auto name = std::format("pm-unit-intro-comms-{}", GetCurrentProcessId());
+			auto pService = MakeServiceComms(name);
+			intro::RegisterMockIntrospectionDevices(*pService);
+			// the tree is released once the image is published, introspection is only held once in shm
+			Assert::ExpectException<std::runtime_error>([&] { pService->GetIntrospectionRoot(); });
+			auto pMiddleware = MakeMiddlewareComms(name);
+			pmapi::intro::Root root{ pMiddleware->GetIntrospectionRoot(), FreeApiRoot };
+			// device-independent device plus the two mock adapters
+			Assert::AreEqual(3ull, (size_t)std::ranges::distance(root.GetDevices()));
+			Assert::AreEqual((int)PM_METRIC_CPU_UTILIZATION, (int)root.FindMetric(PM_METRIC_CPU_UTILIZATION).GetId());
+			// the middleware reads the mapped image in place
+			auto& image = pMiddleware->GetIntrospectionImage();
+			Assert::AreNotEqual(0ull, image.GetVersionStamp());
+			pmapi::intro::Root inPlace{ image };
+			Assert::IsTrue(inPlace.FindDevice(1).GetName() == root.FindDevice(1).GetName());
+		}
+		TEST_METHOD(RejectsCorruptImage)
+		{
+			IntrospectionFixture fix;
+			auto image = intro::BuildIntrospectionImage(fix.GetRoot(), versionStamp);
+			Assert::ExpectException<std::runtime_error>([&] {
+				intro::IntrospectionImageView{ std::span{ image }.first(16) };
+			});
+			auto header = *reinterpret_cast<const intro::IntrospectionImageHeader*>(image.data());
+			header.bodySize = image.size();
+			std::memcpy(image.data(), &header, sizeof(header));
+			Assert::ExpectException<std::runtime_error>([&] {
+				intro::IntrospectionImageView{ image };
+			});
+		}
+		// client side of pmOpenSession to first query: connect to the introspection segment, acquire the
+		// C API tree, wrap it in the lookup root the middleware uses and resolve the first query metric
+		TEST_METHOD(OpenToFirstQueryBenchmark)
+		{
+			constexpr int sessions = 500;
+			constexpr int warmup = 20;
+			// previous: the tree held in shm, cloned by walking it twice (probe + clone)
+			IntrospectionFixture fix;
+			fix.AddMockDevices();
+			const auto openTree = [&] {
+				ShmSegment shm{ bip::open_only, fix.GetSegmentName().c_str() };
+				pmapi::intro::Root root{ fix.CloneTree(), FreeApiRoot };
+				Assert::IsTrue(root.FindMetric(PM_METRIC_CPU_UTILIZATION).GetId() == PM_METRIC_CPU_UTILIZATION);
+			};
+			// the published image, copied and relocated in one pass by the real middleware comms (C API clients)
+			const auto name = std::format("pm-unit-intro-bench-{}", GetCurrentProcessId());
+			auto pService = MakeServiceComms(name);
+			intro::RegisterMockIntrospectionDevices(*pService);
+			const auto openImage = [&] {
+				auto pComms = MakeMiddlewareComms(name);
+				pmapi::intro::Root root{ pComms->GetIntrospectionRoot(), FreeApiRoot };
+				Assert::IsTrue(root.FindMetric(PM_METRIC_CPU_UTILIZATION).GetId() == PM_METRIC_CPU_UTILIZATION);
+			};
+			// the published image read in place through its indices (the middleware's own root)
+			const auto openInPlace = [&] {
+				auto pComms = MakeMiddlewareComms(name);
+				pmapi::intro::Root root{ pComms->GetIntrospectionImage() };
+				Assert::IsTrue(root.FindMetric(PM_METRIC_CPU_UTILIZATION).GetId() == PM_METRIC_CPU_UTILIZATION);
+			};
+			const auto time = [&](auto& open) {
+				for (int i = 0; i < warmup; i++) {
+					open();
+				}
+				QpcTimer timer;
+				for (int i = 0; i < sessions; i++) {
+					open();
+				}
+				return timer.Mark();
+			};
+			const auto treeSeconds = time(openTree);
+			const auto imageSeconds = time(openImage);
+			const auto inPlaceSeconds = time(openInPlace);
+			Logger::WriteMessage(std::format("Introspection open-to-first-query tree: {:.1f}us, image: {:.1f}us ({:.2f}x), "
+				"in place: {:.1f}us ({:.2f}x)\n",
+				treeSeconds * 1'000'000. / sessions, imageSeconds * 1'000'000. / sessions, treeSeconds / imageSeconds,
+				inPlaceSeconds * 1'000'000. / sessions, treeSeconds / inPlaceSeconds).c_str());
+			Assert::IsTrue(imageSeconds < treeSeconds);
+			Assert::IsTrue(inPlaceSeconds < treeSeconds);
+		}
+	};
+}
@@ -0,0 +1,167 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include "IntrospectionFixture.h"
+#include <PresentMonAPIWrapperCommon/Introspection.h>
+#include <PresentMonAPIWrapperCommon/EnumMap.h>
+#include <PresentMonAPIWrapperCommon/Exception.h>
+#include <Core/source/pmon/metric/DynamicPollingFetcher.h>
+#include <CommonUtilities/Qpc.h>
+#include <unordered_map>
+#include <vector>
+#include <format>
+#include <cmath>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace InterprocessTests
+{
+	using namespace pmon::util;
+	using namespace std::string_literals;
+
+	// wrapper root over a C API clone of the fixture's introspection tree
+	std::unique_ptr<pmapi::intro::Root> MakeWrapperRoot(const IntrospectionFixture& fix)
+	{
+		return std::make_unique<pmapi::intro::Root>(fix.CloneTree(), [](const PM_INTROSPECTION_ROOT* p) {
+			free(const_cast<PM_INTROSPECTION_ROOT*>(p));
+		});
+	}
+
+	// every dynamic metric with every stat it supports, repeated as an overlay with many graphs/readouts would be
+	std::vector<PM_QUERY_ELEMENT> MakeLargeSpec(const pmapi::intro::Root& root, int repeats)
+	{
+		std::vector<PM_QUERY_ELEMENT> elements;
+		for (int r = 0; r < repeats; r++) {
+			for (auto m : root.GetMetrics()) {
+				if (!pmapi::intro::MetricTypeIsDynamic(m.GetType())) {
+					continue;
+				}
+				for (auto s : m.GetStatInfo()) {
+					elements.push_back(PM_QUERY_ELEMENT{ .metric = m.GetId(), .stat = s.GetStat(),
+						.dataOffset = elements.size() * 8 });
+				}
+			}
+		}
+		return elements;
+	}
+
+	TEST_CLASS(TestIntrospectionLookup)
+	{
+	public:
+		TEST_METHOD(IndexedLookupMatchesTree)
+		{
+			IntrospectionFixture fix;
+			auto pRoot = MakeWrapperRoot(fix);
+			for (auto m : pRoot->GetMetrics()) {
+				Assert::IsTrue(pRoot->FindMetric(m.GetId()).GetBasePtr() == m.GetBasePtr());
+			}
+			for (auto u : pRoot->GetUnits()) {
+				Assert::IsTrue(pRoot->FindUnit(u.GetId()).GetBasePtr() == u.GetBasePtr());
+			}
+			for (auto e : pRoot->GetEnums()) {
+				Assert::IsTrue(pRoot->FindEnum(e.GetId()).GetBasePtr() == e.GetBasePtr());
+				for (auto k : e.GetKeys()) {
+					Assert::IsTrue(pRoot->FindEnumKey(e.GetId(), k.GetId()).GetBasePtr() == k.GetBasePtr());
+				}
+			}
+			// sparse key values and gaps between them
+			Assert::AreEqual("PM_FRAME_TYPE_AMD_AFMF"s,
+				pRoot->FindEnumKey(PM_ENUM_FRAME_TYPE, PM_FRAME_TYPE_AMD_AFMF).GetSymbol());
+			Assert::ExpectException<pmapi::LookupException>([&] { pRoot->FindEnumKey(PM_ENUM_FRAME_TYPE, 7); });
+			Assert::ExpectException<pmapi::LookupException>([&] { pRoot->FindMetric(PM_METRIC(-1)); });
+			Assert::ExpectException<pmapi::LookupException>([&] { pRoot->FindUnit(PM_UNIT(10'000)); });
+		}
+		TEST_METHOD(ConversionMatrix)
+		{
+			IntrospectionFixture fix;
+			auto pRoot = MakeWrapperRoot(fix);
+			Assert::AreEqual(0.001, pRoot->FindUnit(PM_UNIT_MILLISECONDS).MakeConversionFactor(PM_UNIT_SECONDS), 1e-12);
+			Assert::AreEqual(1000., pRoot->FindUnit(PM_UNIT_SECONDS).MakeConversionFactor(PM_UNIT_MILLISECONDS), 1e-9);
+			Assert::AreEqual(1'024., pRoot->FindUnit(PM_UNIT_MEGABYTES).MakeConversionFactor(PM_UNIT_KILOBYTES), 1e-9);
+			Assert::AreEqual(1., pRoot->FindUnit(PM_UNIT_FPS).MakeConversionFactor(PM_UNIT_FPS));
+			// matrix must agree with the scales published in introspection for every compatible pair
+			for (auto src : pRoot->GetUnits()) {
+				for (auto dst : pRoot->GetUnits()) {
+					if (src.GetBaseUnit() == dst.GetBaseUnit()) {
+						Assert::AreEqual(src.GetScale() / dst.GetScale(), src.MakeConversionFactor(dst.GetId()));
+					}
+					else {
+						Assert::ExpectException<std::runtime_error>([&] { src.MakeConversionFactor(dst.GetId()); });
+					}
+				}
+			}
+			Assert::ExpectException<pmapi::LookupException>([&] {
+				pRoot->FindUnit(PM_UNIT_SECONDS).MakeConversionFactor(PM_UNIT(10'000));
+			});
+		}
+		TEST_METHOD(FetcherBuildBenchmark)
+		{
+			constexpr int specRepeats = 20;
+			constexpr int builds = 50;
+			IntrospectionFixture fix;
+			auto pRoot = MakeWrapperRoot(fix);
+			pmapi::EnumMap::Refresh(*pRoot);
+			const auto spec = MakeLargeSpec(*pRoot, specRepeats);
+			// building every fetcher for the spec, as the overlay does whenever a spec is pushed
+			double fetcherSeconds = 0.;
+			{
+				QpcTimer timer;
+				for (int i = 0; i < builds; i++) {
+					std::vector<std::shared_ptr<p2c::pmon::met::DynamicPollingFetcher>> fetchers;
+					fetchers.reserve(spec.size());
+					for (auto& qel : spec) {
+						fetchers.push_back(p2c::pmon::met::MakeDynamicPollingFetcher(qel, *pRoot, {}));
+					}
+					Assert::AreEqual(spec.size(), fetchers.size());
+				}
+				fetcherSeconds = timer.Mark();
+			}
+			// introspection work done per fetcher, resolved through the static index + conversion matrix
+			double indexedSeconds = 0.;
+			double indexedSum = 0.;
+			{
+				QpcTimer timer;
+				for (int i = 0; i < builds; i++) {
+					for (auto& qel : spec) {
+						const auto metric = pRoot->FindMetric(qel.metric);
+						indexedSum += pRoot->FindUnit(metric.GetUnit()).MakeConversionFactor(metric.GetPreferredUnitHint());
+					}
+				}
+				indexedSeconds = timer.Mark();
+			}
+			// the same work resolved through hash maps keyed by id, as lookup was done previously
+			double hashedSeconds = 0.;
+			double hashedSum = 0.;
+			{
+				std::unordered_map<PM_METRIC, const PM_INTROSPECTION_METRIC*> metricMap;
+				for (auto m : pRoot->GetMetrics()) {
+					metricMap[m.GetId()] = m.GetBasePtr();
+				}
+				std::unordered_map<PM_UNIT, const PM_INTROSPECTION_UNIT*> unitMap;
+				for (auto u : pRoot->GetUnits()) {
+					unitMap[u.GetId()] = u.GetBasePtr();
+				}
+				QpcTimer timer;
+				for (int i = 0; i < builds; i++) {
+					for (auto& qel : spec) {
+						const auto pMetric = metricMap.at(qel.metric);
+						const auto pUnit = unitMap.at(pMetric->unit);
+						const auto pDest = unitMap.at(pMetric->preferredUnitHint);
+						if (pUnit->baseUnitId != pDest->baseUnitId) {
+							throw std::runtime_error{ "cannot convert incompatible units" };
+						}
+						hashedSum += pUnit->scale / pDest->scale;
+					}
+				}
+				hashedSeconds = timer.Mark();
+			}
+			Assert::AreEqual(hashedSum, indexedSum, 1e-6 * std::abs(hashedSum));
+			Logger::WriteMessage(std::format("Fetcher build for {} query elements: {:.1f}us; lookup+conversion "
+				"indexed: {:.1f}us, hashed: {:.1f}us ({:.2f}x)\n", spec.size(),
+				fetcherSeconds * 1'000'000. / builds, indexedSeconds * 1'000'000. / builds,
+				hashedSeconds * 1'000'000. / builds, hashedSeconds / indexedSeconds).c_str());
+			Assert::IsTrue(indexedSeconds < hashedSeconds);
+		}
+	};
+}
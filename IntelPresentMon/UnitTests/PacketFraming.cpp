@@ -0,0 +1,353 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Core/source/win/WinAPI.h>
+#include <CommonUtilities/pipe/PacketFraming.h>
+#include <CommonUtilities/Qpc.h>
+#include <Interprocess/source/act/Packet.h>
+#include <Interprocess/source/act/ActionIdMap.h>
+#include <CommonUtilities/pipe/Pipe.h>
+#include <atomic>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+#include <sstream>
+#include <unordered_map>
+#include <format>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace InterprocessTests
+{
+	using namespace pmon::util;
+	using namespace pmon::util::pipe;
+	using namespace pmon::ipc::act;
+	namespace as = boost::asio;
+	using namespace std::string_literals;
+
+	// simple actions resembling the polling-style service actions
+	struct SetFlushPeriod
+	{
+		static constexpr const char* Identifier = "SetEtwFlushPeriod";
+		struct Params
+		{
+			uint32_t periodMs;
+			template<class A> void serialize(A& ar) { ar(periodMs); }
+		};
+		struct Response
+		{
+			uint32_t appliedMs;
+			template<class A> void serialize(A& ar) { ar(appliedMs); }
+		};
+		static Response Execute(Params&& in) { return { in.periodMs }; }
+	};
+	struct StartTrack
+	{
+		static constexpr const char* Identifier = "StartTracking";
+		struct Params
+		{
+			uint32_t targetPid;
+			template<class A> void serialize(A& ar) { ar(targetPid); }
+		};
+		struct Response
+		{
+			std::string nsmFileName;
+			template<class A> void serialize(A& ar) { ar(nsmFileName); }
+		};
+		static Response Execute(Params&& in) { return { std::format("pm_nsm_{}", in.targetPid) }; }
+	};
+
+	// connected pair of real duplex pipes, with coroutines run to completion on a private io_context
+	class PipePair
+	{
+	public:
+		PipePair()
+			:
+			name_{ std::format(R"(\\.\pipe\pm-unit-framing-{}-{})", GetCurrentProcessId(), nextIndex_++) },
+			pServer_{ DuplexPipe::MakeAsPtr(name_, ioctx_, DuplexPipe::GetSecurityString(SecurityMode::None)) }
+		{
+			pClient_ = DuplexPipe::ConnectAsPtr(name_, ioctx_);
+			Run(pServer_->Accept());
+		}
+		template<class T>
+		T Run(as::awaitable<T> coro)
+		{
+			auto future = as::co_spawn(ioctx_, std::move(coro), as::use_future);
+			ioctx_.restart();
+			ioctx_.run();
+			return future.get();
+		}
+		DuplexPipe& Client() { return *pClient_; }
+		DuplexPipe& Server() { return *pServer_; }
+	private:
+		static inline std::atomic<uint32_t> nextIndex_ = 0;
+		as::io_context ioctx_;
+		std::string name_;
+		std::unique_ptr<DuplexPipe> pServer_;
+		std::unique_ptr<DuplexPipe> pClient_;
+	};
+
+	// one request/response exchange through the pipes' own codecs, with the action id resolved
+	// through the remote table as SymmetricActionClient does
+	template<class A>
+	as::awaitable<typename A::Response> RoundTrip(PipePair& pipes, const ActionIdMap& remoteActions,
+		uint32_t commandToken, typename A::Params params)
+	{
+		const PacketHeader header{
+			.commandToken = commandToken,
+			.packetType = PacketType::ActionRequest,
+			.actionId = remoteActions.GetId<A>(),
+			.headerVersion = CurrentHeaderVersion,
+			.actionVersion = 1,
+		};
+		co_await pipes.Client().WritePacket(header, params);
+		const auto reqHeader = co_await pipes.Server().ReadPacketConsumeHeader<PacketHeader>();
+		Assert::AreEqual(header.actionId, reqHeader.actionId);
+		auto res = A::Execute(pipes.Server().ConsumePacketPayload<typename A::Params>());
+		co_await pipes.Server().WritePacket(MakeResponseHeader(reqHeader, TransportStatus::Success, 0), res);
+		const auto resHeader = co_await pipes.Client().ReadPacketConsumeHeader<PacketHeader>();
+		Assert::AreEqual(commandToken, resHeader.commandToken);
+		Assert::IsTrue(resHeader.transportStatus == TransportStatus::Success);
+		co_return pipes.Client().ConsumePacketPayload<typename A::Response>();
+	}
+
+	// payload whose serialization fails after part of it has been written into the encode buffer
+	struct ThrowingPayload
+	{
+		uint32_t value = 0;
+		template<class A> void serialize(A& ar)
+		{
+			ar(value);
+			throw std::runtime_error{ "serialization failure" };
+		}
+	};
+
+	// encode into the codec and copy prefix + payload onto an in-memory wire, as DuplexPipe::WritePacket does
+	template<FrameHeader H, class P>
+	void EncodeToWire(PacketCodec& codec, PacketBuffer& wire, const H& header, const P& payload)
+	{
+		const PacketCodec::EncodeScope encodeScope{ codec };
+		const auto prefix = codec.Encode(header, payload);
+		wire.Write(prefix.bytes.data(), prefix.bytes.size());
+		wire.Write(codec.GetEncodedPayload().data(), codec.GetEncodedSize());
+	}
+	// read prefix + payload from an in-memory wire and decode, as DuplexPipe::ReadPacketConsumeHeader does
+	template<FrameHeader H, class P>
+	H DecodeFromWire(PacketCodec& codec, PacketBuffer& wire, P& payload)
+	{
+		FramePrefix<H> prefix;
+		wire.Read(prefix.bytes.data(), prefix.bytes.size());
+		const auto region = codec.PrepareDecode(prefix.GetPayloadSize());
+		wire.Read(region.data(), region.size());
+		payload = codec.Decode<P>();
+		return prefix.GetHeader();
+	}
+
+	// previous framing: cereal header with string identifier, streambuf per pipe, string-keyed dispatch
+	struct LegacyHeader
+	{
+		std::string identifier;
+		uint32_t commandToken;
+		TransportStatus transportStatus;
+		int executionStatus;
+		PacketType packetType;
+		uint16_t headerVersion;
+		uint16_t actionVersion;
+		template<class A> void serialize(A& ar) {
+			ar(identifier, commandToken, transportStatus, executionStatus,
+				packetType, headerVersion, actionVersion);
+		}
+	};
+
+	TEST_CLASS(TestPacketFraming)
+	{
+	public:
+		TEST_METHOD(BufferRetainsCapacity)
+		{
+			PacketBuffer buf{ 16 };
+			std::vector<char> bytes(100, 'x');
+			buf.Write(bytes.data(), bytes.size());
+			const auto capacity = buf.Capacity();
+			Assert::IsTrue(capacity >= 100);
+			buf.Consume(100);
+			Assert::AreEqual(0ull, buf.Size());
+			for (int i = 0; i < 10; i++) {
+				buf.Write(bytes.data(), bytes.size());
+				buf.Consume(bytes.size());
+			}
+			Assert::AreEqual(capacity, buf.Capacity());
+		}
+		TEST_METHOD(BufferPartialConsume)
+		{
+			PacketBuffer buf{ 8 };
+			const char in[] = "abcdefghijkl";
+			buf.Write(in, 12);
+			char out[4];
+			Assert::AreEqual(4ull, buf.Read(out, 4));
+			Assert::AreEqual("abcd", std::string(out, 4).c_str());
+			Assert::AreEqual(8ull, buf.Size());
+			// write after partial consume compacts instead of growing
+			buf.Write(in, 4);
+			Assert::AreEqual(12ull, buf.Size());
+			Assert::AreEqual(0, std::memcmp(buf.Data().data(), "efghijklabcd", 12));
+		}
+		TEST_METHOD(PrefixRoundTrip)
+		{
+			const PacketHeader header{
+				.commandToken = 42,
+				.transportStatus = TransportStatus::ExecutionFailure,
+				.executionStatus = -7,
+				.packetType = PacketType::ActionResponse,
+				.actionId = 3,
+				.headerVersion = CurrentHeaderVersion,
+				.actionVersion = 9,
+			};
+			const FramePrefix<PacketHeader> prefix{ header, 1234 };
+			Assert::AreEqual(sizeof(uint32_t) + sizeof(PacketHeader), prefix.bytes.size());
+			Assert::AreEqual(1234u, prefix.GetPayloadSize());
+			const auto decoded = prefix.GetHeader();
+			Assert::AreEqual(0, std::memcmp(&header, &decoded, sizeof(header)));
+		}
+		TEST_METHOD(HeaderBytesAreInitialized)
+		{
+			static_assert(std::has_unique_object_representations_v<PacketHeader>);
+			const PacketHeader header{ .packetType = PacketType::ActionTable, .headerVersion = CurrentHeaderVersion };
+			const FramePrefix<PacketHeader> prefix{ header, 0 };
+			// only packetType (offset 12) and headerVersion (offset 18) were set, every other byte is zero
+			const auto pHeaderBytes = prefix.bytes.data() + sizeof(uint32_t);
+			for (size_t i = 0; i < sizeof(PacketHeader); i++) {
+				if (i != 12 && i != 18) {
+					Assert::AreEqual(0, int(pHeaderBytes[i]));
+				}
+			}
+		}
+		TEST_METHOD(EmptyHeaderHasNoBytes)
+		{
+			struct EmptyHeader {};
+			Assert::AreEqual(sizeof(uint32_t), FramePrefix<EmptyHeader>::Size);
+		}
+		TEST_METHOD(RoundTripOverPipe)
+		{
+			PipePair pipes;
+			const ActionIdMap remoteActions{ { "StartTracking", "SetEtwFlushPeriod" } };
+			Assert::AreEqual(16u, pipes.Run(RoundTrip<SetFlushPeriod>(pipes, remoteActions, 0, { .periodMs = 16 })).appliedMs);
+			Assert::AreEqual("pm_nsm_1234"s, pipes.Run(RoundTrip<StartTrack>(pipes, remoteActions, 1, { .targetPid = 1234 })).nsmFileName);
+			Assert::AreEqual(1000u, pipes.Run(RoundTrip<SetFlushPeriod>(pipes, remoteActions, 2, { .periodMs = 1000 })).appliedMs);
+			Assert::AreEqual(0ull, pipes.Client().GetWriteBufferPending());
+			Assert::AreEqual(0ull, pipes.Server().GetWriteBufferPending());
+		}
+		TEST_METHOD(FailedEncodeLeavesNoStaleBytes)
+		{
+			PipePair pipes;
+			const ActionIdMap remoteActions{ { "StartTracking", "SetEtwFlushPeriod" } };
+			const PacketHeader header{ .packetType = PacketType::ActionRequest, .headerVersion = CurrentHeaderVersion };
+			Assert::ExpectException<std::runtime_error>([&] {
+				pipes.Run(pipes.Client().WritePacket(header, ThrowingPayload{ 42 }));
+			});
+			Assert::AreEqual(0ull, pipes.Client().GetWriteBufferPending());
+			// the next packet on the same pipe goes out without the partially encoded payload in front
+			Assert::AreEqual(16u, pipes.Run(RoundTrip<SetFlushPeriod>(pipes, remoteActions, 0, { .periodMs = 16 })).appliedMs);
+		}
+		TEST_METHOD(TimedOutWriteLeavesNoStaleBytes)
+		{
+			PipePair pipes;
+			// nobody reads the server end, so a payload much larger than the pipe buffer cannot complete
+			const std::vector<char> payload(1 << 20, 'x');
+			const PacketHeader header{ .packetType = PacketType::ActionRequest, .headerVersion = CurrentHeaderVersion };
+			Assert::ExpectException<PipeError>([&] {
+				pipes.Run(pipes.Client().WritePacket(header, payload, 20));
+			});
+			Assert::AreEqual(0ull, pipes.Client().GetWriteBufferPending());
+		}
+		TEST_METHOD(TimedOutReadLeavesNoStaleBytes)
+		{
+			PipePair pipes;
+			// a header 8 bytes shorter than PacketHeader: the server takes the first 8 payload bytes as header,
+			// so the payload size it reads runs 8 bytes past the end of what was sent
+			struct ShortHeader { uint64_t a; uint64_t b; };
+			static_assert(sizeof(ShortHeader) + 8 == sizeof(PacketHeader));
+			const std::vector<char> payload(100, 'x');
+			pipes.Run(pipes.Client().WritePacket(ShortHeader{}, payload));
+			Assert::ExpectException<PipeError>([&] {
+				pipes.Run(pipes.Server().ReadPacketConsumeHeader<PacketHeader>(20));
+			});
+			Assert::AreEqual(0ull, pipes.Server().GetReadBufferPending());
+		}
+		TEST_METHOD(ActionIdMapUnknownAction)
+		{
+			struct Unknown { static constexpr const char* Identifier = "Unknown"; };
+			ActionIdMap map{ { "StartTracking", "SetEtwFlushPeriod" } };
+			Assert::AreEqual(uint16_t(1), map.GetId<SetFlushPeriod>());
+			Assert::AreEqual(uint16_t(0), map.GetId<StartTrack>());
+			Assert::ExpectException<Exception>([&] { map.GetId<Unknown>(); });
+		}
+		// round trips per second of a small polling action, legacy framing vs binary header framing
+		TEST_METHOD(RoundTripBenchmark)
+		{
+			constexpr int roundTrips = 200'000;
+			// legacy: streambuf + per-packet cereal header with string identifier + string-keyed lookup
+			double legacySeconds = 0.;
+			{
+				std::stringstream toServer, fromServer;
+				cereal::BinaryOutputArchive clientOut{ toServer }, serverOut{ fromServer };
+				cereal::BinaryInputArchive serverIn{ toServer }, clientIn{ fromServer };
+				std::unordered_map<std::string, int> actions{ { "StartTracking", 0 }, { "SetEtwFlushPeriod", 1 } };
+				QpcTimer timer;
+				for (int i = 0; i < roundTrips; i++) {
+					clientOut(LegacyHeader{ .identifier = SetFlushPeriod::Identifier, .commandToken = uint32_t(i),
+						.packetType = PacketType::ActionRequest, .headerVersion = 1, .actionVersion = 1 },
+						SetFlushPeriod::Params{ .periodMs = uint32_t(i) });
+					LegacyHeader reqHeader;
+					SetFlushPeriod::Params params;
+					serverIn(reqHeader, params);
+					Assert::AreEqual(1, actions.at(reqHeader.identifier));
+					serverOut(reqHeader, SetFlushPeriod::Execute(std::move(params)));
+					LegacyHeader resHeader;
+					SetFlushPeriod::Response res;
+					clientIn(resHeader, res);
+				}
+				legacySeconds = timer.Mark();
+			}
+			// current: raw binary header prefix + pooled codec buffers + numeric action id
+			double binarySeconds = 0.;
+			{
+				PacketCodec clientCodec, serverCodec;
+				PacketBuffer toServer, fromServer;
+				const ActionIdMap remoteActions{ { "StartTracking", "SetEtwFlushPeriod" } };
+				QpcTimer timer;
+				for (int i = 0; i < roundTrips; i++) {
+					EncodeToWire(clientCodec, toServer, PacketHeader{ .commandToken = uint32_t(i),
+						.packetType = PacketType::ActionRequest, .actionId = remoteActions.GetId<SetFlushPeriod>(),
+						.headerVersion = CurrentHeaderVersion, .actionVersion = 1 },
+						SetFlushPeriod::Params{ .periodMs = uint32_t(i) });
+					SetFlushPeriod::Params params;
+					const auto reqHeader = DecodeFromWire<PacketHeader>(serverCodec, toServer, params);
+					Assert::AreEqual(uint16_t(1), reqHeader.actionId);
+					EncodeToWire(serverCodec, fromServer, MakeResponseHeader(reqHeader, TransportStatus::Success, 0),
+						SetFlushPeriod::Execute(std::move(params)));
+					SetFlushPeriod::Response res;
+					DecodeFromWire<PacketHeader>(clientCodec, fromServer, res);
+				}
+				binarySeconds = timer.Mark();
+			}
+			// for scale: the same exchange over a real pipe pair, including the transport
+			double pipeSeconds = 0.;
+			{
+				constexpr int pipeRoundTrips = 20'000;
+				PipePair pipes;
+				const ActionIdMap remoteActions{ { "StartTracking", "SetEtwFlushPeriod" } };
+				QpcTimer timer;
+				pipes.Run([&]() -> as::awaitable<void> {
+					for (int i = 0; i < pipeRoundTrips; i++) {
+						co_await RoundTrip<SetFlushPeriod>(pipes, remoteActions, uint32_t(i), { .periodMs = uint32_t(i) });
+					}
+				}());
+				pipeSeconds = timer.Mark() * roundTrips / pipeRoundTrips;
+			}
+			Logger::WriteMessage(std::format("Round trips/s over real pipes: {:.0f}\n", roundTrips / pipeSeconds).c_str());
+			Logger::WriteMessage(std::format("Round trips/s legacy: {:.0f}, binary framing: {:.0f} ({:.2f}x)\n",
+				roundTrips / legacySeconds, roundTrips / binarySeconds, legacySeconds / binarySeconds).c_str());
+			Assert::IsTrue(binarySeconds < legacySeconds);
+		}
+	};
+}
@@ -0,0 +1,212 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Core/source/win/WinAPI.h>
+#include <CommonUtilities/mt/PeriodicScheduler.h>
+#include <CommonUtilities/IntervalWaiter.h>
+#include <CommonUtilities/Qpc.h>
+#include <format>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <cmath>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UtilityTests
+{
+	using namespace std::literals;
+	using namespace pmon::util;
+
+	// stands in for a telemetry adapter: records when it was sampled and burns a little cpu per sample
+	class FakeSampler
+	{
+	public:
+		FakeSampler(double period, const QpcTimer& timer) : period_{ period }, timer_{ timer } {}
+		void Sample()
+		{
+			sampleTimes_.push_back(timer_.Peek());
+			const auto until = sampleTimes_.back() + 0.00002;
+			timer_.SpinWaitUntil(until);
+		}
+		double GetPeriod() const { return period_; }
+		size_t GetSampleCount() const { return sampleTimes_.size(); }
+		// mean absolute deviation of sample intervals from the period
+		double GetJitter() const
+		{
+			if (sampleTimes_.size() < 2) {
+				return 0.;
+			}
+			double total = 0.;
+			for (size_t i = 1; i < sampleTimes_.size(); i++) {
+				total += std::abs(sampleTimes_[i] - sampleTimes_[i - 1] - period_);
+			}
+			return total / double(sampleTimes_.size() - 1);
+		}
+	private:
+		double period_;
+		const QpcTimer& timer_;
+		std::vector<double> sampleTimes_;
+	};
+
+	// user + kernel time consumed by this process so far
+	double GetProcessCpuSeconds()
+	{
+		FILETIME creation, exit, kernel, user;
+		GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user);
+		const auto toSeconds = [](const FILETIME& ft) {
+			return double((uint64_t(ft.dwHighDateTime) << 32) | ft.dwLowDateTime) / 10'000'000.;
+		};
+		return toSeconds(kernel) + toSeconds(user);
+	}
+
+	TEST_CLASS(TestPeriodicScheduler)
+	{
+	public:
+		TEST_METHOD(PerTaskPeriods)
+		{
+			QpcTimer timer;
+			std::vector<std::unique_ptr<FakeSampler>> samplers;
+			for (auto period : { 0.002, 0.005, 0.016, 0.1 }) {
+				samplers.push_back(std::make_unique<FakeSampler>(period, timer));
+			}
+			{
+				mt::PeriodicScheduler scheduler{ "test-sched" };
+				for (auto& s : samplers) {
+					scheduler.AddTask("fake", s->GetPeriod(), [p = s.get()] { p->Sample(); }, true);
+				}
+				std::this_thread::sleep_for(1s);
+			}
+			for (auto& s : samplers) {
+				const auto expected = 1. / s->GetPeriod();
+				Assert::IsTrue(std::abs(double(s->GetSampleCount()) - expected) <= expected * 0.1 + 2.,
+					std::format(L"period {}: {} samples", s->GetPeriod(), s->GetSampleCount()).c_str());
+			}
+		}
+		TEST_METHOD(EnableDisableRemove)
+		{
+			std::atomic<int> a = 0, b = 0;
+			mt::PeriodicScheduler scheduler{ "test-sched" };
+			const auto idA = scheduler.AddTask("a", 0.005, [&] { a++; });
+			const auto idB = scheduler.AddTask("b", 0.005, [&] { b++; }, true);
+			std::this_thread::sleep_for(50ms);
+			// disabled at registration, so never run
+			Assert::AreEqual(0, a.load());
+			Assert::IsTrue(b > 0);
+			// enabling runs immediately
+			scheduler.SetEnabled(idA, true);
+			scheduler.SetPeriod(idA, 10.);
+			std::this_thread::sleep_for(20ms);
+			Assert::AreEqual(1, a.load());
+			scheduler.SetEnabled(idB, false);
+			std::this_thread::sleep_for(20ms);
+			const int bStopped = b;
+			std::this_thread::sleep_for(50ms);
+			Assert::AreEqual(bStopped, b.load());
+			Assert::IsFalse(scheduler.IsEnabled(idB));
+			scheduler.RemoveTask(idA);
+			Assert::ExpectException<Exception>([&] { scheduler.SetEnabled(idA, true); });
+		}
+		TEST_METHOD(TasksControlOtherTasks)
+		{
+			// a control task gating sampling tasks from the scheduler thread, as the service does
+			std::atomic<int> samples = 0;
+			std::atomic<bool> streaming = true;
+			mt::PeriodicScheduler scheduler{ "test-sched" };
+			const auto sampleId = scheduler.AddTask("sample", 0.002, [&] { samples++; });
+			mt::PeriodicScheduler::TaskId controlId = 0;
+			controlId = scheduler.AddTask("control", 0.01, [&] {
+				scheduler.SetEnabled(sampleId, streaming.load());
+				if (!streaming) {
+					scheduler.SetEnabled(controlId, false);
+				}
+			});
+			scheduler.SetEnabled(controlId, true);
+			std::this_thread::sleep_for(100ms);
+			Assert::IsTrue(samples > 10);
+			streaming = false;
+			std::this_thread::sleep_for(50ms);
+			Assert::IsFalse(scheduler.IsEnabled(sampleId));
+			Assert::IsFalse(scheduler.IsEnabled(controlId));
+			const int stopped = samples;
+			std::this_thread::sleep_for(50ms);
+			Assert::AreEqual(stopped, samples.load());
+		}
+		TEST_METHOD(JitterAndCpuCostBenchmark)
+		{
+			// fake devices with differing periods, sampled by one scheduler thread vs one thread + interval waiter
+			// per device (previous service behavior); compares sample interval jitter and process cpu time
+			constexpr auto duration = 2s;
+			const double periods[] = { 0.001, 0.004, 0.008, 0.016, 0.016, 0.033, 0.1, 0.25 };
+			QpcTimer timer;
+			const auto makeSamplers = [&] {
+				std::vector<std::unique_ptr<FakeSampler>> samplers;
+				for (auto p : periods) {
+					samplers.push_back(std::make_unique<FakeSampler>(p, timer));
+				}
+				return samplers;
+			};
+			const auto summarize = [](const std::vector<std::unique_ptr<FakeSampler>>& samplers) {
+				double jitter = 0.;
+				for (auto& s : samplers) {
+					jitter = std::max(jitter, s->GetJitter());
+				}
+				return jitter;
+			};
+			// per device threads
+			auto threadSamplers = makeSamplers();
+			double threadCpu = 0.;
+			{
+				const auto cpuStart = GetProcessCpuSeconds();
+				std::atomic<bool> stop = false;
+				std::vector<std::jthread> threads;
+				for (auto& s : threadSamplers) {
+					threads.emplace_back([&stop, p = s.get()] {
+						IntervalWaiter waiter{ p->GetPeriod() };
+						while (!stop) {
+							p->Sample();
+							waiter.Wait();
+						}
+					});
+				}
+				std::this_thread::sleep_for(duration);
+				stop = true;
+				threads.clear();
+				threadCpu = GetProcessCpuSeconds() - cpuStart;
+			}
+			// single scheduler thread
+			auto schedSamplers = makeSamplers();
+			double schedCpu = 0.;
+			double schedMaxLateness = 0.;
+			{
+				const auto cpuStart = GetProcessCpuSeconds();
+				mt::PeriodicScheduler scheduler{ "test-sched" };
+				std::vector<mt::PeriodicScheduler::TaskId> ids;
+				for (auto& s : schedSamplers) {
+					ids.push_back(scheduler.AddTask("fake", s->GetPeriod(), [p = s.get()] { p->Sample(); }, true));
+				}
+				std::this_thread::sleep_for(duration);
+				scheduler.Stop();
+				schedCpu = GetProcessCpuSeconds() - cpuStart;
+				for (auto id : ids) {
+					schedMaxLateness = std::max(schedMaxLateness, scheduler.GetStats(id).maxLateness);
+				}
+			}
+			const auto threadJitter = summarize(threadSamplers);
+			const auto schedJitter = summarize(schedSamplers);
+			Logger::WriteMessage(std::format("{} fake devices for {}: thread-per-device jitter {:.1f}us cpu {:.1f}ms; "
+				"scheduler jitter {:.1f}us cpu {:.1f}ms max lateness {:.1f}us\n", std::size(periods), duration,
+				threadJitter * 1'000'000., threadCpu * 1'000., schedJitter * 1'000'000., schedCpu * 1'000.,
+				schedMaxLateness * 1'000'000.).c_str());
+			for (auto& s : schedSamplers) {
+				const auto expected = 2. / s->GetPeriod();
+				Assert::IsTrue(std::abs(double(s->GetSampleCount()) - expected) <= expected * 0.1 + 2.);
+			}
+			// worst mean deviation of any device must stay well under the shortest period
+			Assert::IsTrue(schedJitter < 0.0005);
+		}
+	};
+}
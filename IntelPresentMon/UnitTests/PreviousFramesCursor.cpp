@@ -0,0 +1,211 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Streamer/PreviousFramesCursor.h>
+#include <format>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace StreamerTests
+{
+	// stands in for NamedSharedMem: same head/tail/full semantics, but each frame is just its presented flag
+	class FakeRing
+	{
+	public:
+		FakeRing(uint64_t maxEntries, bool fromEtlFile)
+			:
+			presented_(maxEntries),
+			maxEntries_{ maxEntries },
+			fromEtlFile_{ fromEtlFile }
+		{}
+		void Write(bool presented)
+		{
+			presented_[tail_] = presented;
+			if (IsFull()) {
+				head_ = (head_ + 1) % maxEntries_;
+			}
+			tail_ = (tail_ + 1) % maxEntries_;
+			framesWritten_++;
+		}
+		void Pop()
+		{
+			if (head_ != tail_) {
+				head_ = (head_ + 1) % maxEntries_;
+			}
+		}
+		bool IsFull() const { return (tail_ + 1) % maxEntries_ == head_; }
+		uint64_t GetHead() const { return head_; }
+		uint64_t GetTail() const { return tail_; }
+		uint64_t GetFramesWritten() const { return framesWritten_; }
+		uint64_t GetMaxEntries() const { return maxEntries_; }
+		PreviousFramesCursor::Ring GetRing() const
+		{
+			return { head_, tail_, maxEntries_, IsFull(), fromEtlFile_ };
+		}
+		// an inactive ring fails every read, as ReadFrameByIdx() does once the service
+		// stops the stream
+		void SetActive(bool active) { active_ = active; }
+		// mirrors StreamClient::ReadFrameByIdx() validation
+		bool Read(uint64_t idx, bool* presented)
+		{
+			readCount_++;
+			if (!active_ || head_ == tail_ || idx > maxEntries_ - 1 || (idx > tail_ && !IsFull())) {
+				return false;
+			}
+			*presented = presented_[idx];
+			return true;
+		}
+		uint64_t GetReadCount() const { return readCount_; }
+	private:
+		std::vector<bool> presented_;
+		uint64_t maxEntries_;
+		bool fromEtlFile_;
+		uint64_t head_ = 0;
+		uint64_t tail_ = 0;
+		uint64_t framesWritten_ = 0;
+		uint64_t readCount_ = 0;
+		bool active_ = true;
+	};
+
+	// consumes frame idx with both the cursor and a full walk, and checks they agree
+	PreviousFramesCursor::Result ConsumeAndCompare(FakeRing& ring, PreviousFramesCursor& cursor, uint64_t idx)
+	{
+		auto read = [&ring](uint64_t i, bool* presented) { return ring.Read(i, presented); };
+		const auto expected = PreviousFramesCursor::Walk(ring.GetRing(), idx, read);
+		const auto actual = cursor.Advance(ring.GetRing(), idx, read);
+		const auto where = std::format(L"frame {} (head {}, tail {})", idx, ring.GetHead(), ring.GetTail());
+		Assert::AreEqual(expected.last_presented_idx, actual.last_presented_idx, where.c_str());
+		Assert::AreEqual(expected.last_displayed_idx, actual.last_displayed_idx, where.c_str());
+		Assert::AreEqual(expected.previous_of_last_displayed_idx, actual.previous_of_last_displayed_idx, where.c_str());
+		return actual;
+	}
+
+	TEST_CLASS(TestPreviousFramesCursor)
+	{
+	public:
+		TEST_METHOD(RealtimeWrapAround)
+		{
+			FakeRing ring{ 16, false };
+			PreviousFramesCursor cursor;
+			std::mt19937 rng{ 7 };
+			std::bernoulli_distribution presented{ 0.3 };
+			std::uniform_int_distribution<int> writes{ 0, 3 };
+
+			// consumer trails the writer by a varying amount, wrapping the ring many times
+			uint64_t framesConsumed = 0;
+			uint64_t nextIdx = 0;
+			for (int i = 0; i < 2000; i++) {
+				for (int n = writes(rng); n > 0; n--) {
+					ring.Write(presented(rng));
+				}
+				const auto pending = ring.GetFramesWritten() - framesConsumed;
+				if (pending > ring.GetMaxEntries() - 2) {
+					// overrun: StreamClient restarts from the latest frame
+					cursor.Invalidate();
+					nextIdx = ring.GetTail() == 0 ? ring.GetMaxEntries() - 1 : ring.GetTail() - 1;
+					framesConsumed = ring.GetFramesWritten() - 1;
+				}
+				if (ring.GetFramesWritten() > framesConsumed + 1) {
+					ConsumeAndCompare(ring, cursor, nextIdx);
+					nextIdx = (nextIdx + 1) % ring.GetMaxEntries();
+					framesConsumed++;
+				}
+			}
+		}
+		TEST_METHOD(EtlHeadTail)
+		{
+			FakeRing ring{ 16, true };
+			PreviousFramesCursor cursor;
+			std::mt19937 rng{ 11 };
+			std::bernoulli_distribution presented{ 0.5 };
+
+			// the writer blocks while the ring is full, and the consumer pops frames
+			// some time after reading them
+			uint64_t nextIdx = 0;
+			uint64_t framesConsumed = 0;
+			for (int i = 0; i < 2000; i++) {
+				if (!ring.IsFull()) {
+					ring.Write(presented(rng));
+				}
+				if (ring.GetFramesWritten() > framesConsumed + 1) {
+					ConsumeAndCompare(ring, cursor, nextIdx);
+					nextIdx = (nextIdx + 1) % ring.GetMaxEntries();
+					framesConsumed++;
+				}
+				if (i % 3 == 0 && ring.GetHead() != nextIdx) {
+					ring.Pop();
+				}
+			}
+		}
+		TEST_METHOD(NotFullRing)
+		{
+			for (bool fromEtl : { false, true }) {
+				FakeRing ring{ 64, fromEtl };
+				PreviousFramesCursor cursor;
+				for (int i = 0; i < 40; i++) {
+					ring.Write(i % 5 == 0);
+				}
+				for (uint64_t idx = 0; idx < 39; idx++) {
+					ConsumeAndCompare(ring, cursor, idx);
+				}
+			}
+		}
+		TEST_METHOD(LongDroppedRun)
+		{
+			constexpr uint64_t frameCount = 10'000;
+			constexpr uint64_t displayedIdx = 32;
+			FakeRing ring{ frameCount + 64, false };
+			PreviousFramesCursor cursor;
+			for (uint64_t i = 0; i < displayedIdx; i++) {
+				ring.Write(false);
+			}
+			ring.Write(true);
+			for (uint64_t i = 0; i < frameCount + 1; i++) {
+				ring.Write(false);
+			}
+
+			auto read = [&ring](uint64_t i, bool* presented) { return ring.Read(i, presented); };
+			const auto readsBefore = ring.GetReadCount();
+			for (uint64_t idx = displayedIdx + 1; idx < displayedIdx + frameCount; idx++) {
+				const auto result = cursor.Advance(ring.GetRing(), idx, read);
+				Assert::AreEqual(idx - 1, result.last_presented_idx);
+				Assert::AreEqual(displayedIdx, result.last_displayed_idx);
+				Assert::AreEqual(displayedIdx - 1, result.previous_of_last_displayed_idx);
+			}
+			// only the first frame needs a walk; the rest read a constant number of frames
+			// (the consumed frame and each reported one)
+			Assert::IsTrue(ring.GetReadCount() - readsBefore <= 5 * frameCount);
+
+			// spot check against the full walk at the end of the run
+			ConsumeAndCompare(ring, cursor, displayedIdx + frameCount);
+		}
+		TEST_METHOD(UnreadableFrames)
+		{
+			for (bool fromEtl : { false, true }) {
+				FakeRing ring{ 64, fromEtl };
+				PreviousFramesCursor cursor;
+				for (int i = 0; i < 40; i++) {
+					ring.Write(i % 7 == 0);
+				}
+				for (uint64_t idx = 0; idx < 10; idx++) {
+					ConsumeAndCompare(ring, cursor, idx);
+				}
+				// the walk reports nothing once frames can't be read, and neither may the cursor
+				ring.SetActive(false);
+				for (uint64_t idx = 10; idx < 12; idx++) {
+					const auto result = ConsumeAndCompare(ring, cursor, idx);
+					Assert::AreEqual(PreviousFramesCursor::kInvalidIdx, result.last_presented_idx);
+					Assert::AreEqual(PreviousFramesCursor::kInvalidIdx, result.last_displayed_idx);
+				}
+				ring.SetActive(true);
+				for (uint64_t idx = 12; idx < 39; idx++) {
+					ConsumeAndCompare(ring, cursor, idx);
+				}
+			}
+		}
+	};
+}
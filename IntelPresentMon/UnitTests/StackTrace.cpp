@@ -0,0 +1,310 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Core/source/win/WinAPI.h>
+#include <CommonUtilities/log/StackTrace.h>
+#include <CommonUtilities/log/StackTraceCache.h>
+#include <CommonUtilities/log/Channel.h>
+#include <CommonUtilities/log/IDriver.h>
+#include <CommonUtilities/log/Entry.h>
+#include <CommonUtilities/log/EntryBuilder.h>
+#include <CommonUtilities/log/LinePolicy.h>
+#include <CommonUtilities/log/LineTable.h>
+#include <CommonUtilities/log/TextFormatter.h>
+#include <CommonUtilities/Qpc.h>
+#include <format>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace LoggingTests
+{
+	using namespace pmon::util;
+	using namespace pmon::util::log;
+
+	__declspec(noinline) std::unique_ptr<StackTrace> CaptureSiteA()
+	{
+		return StackTrace::Here();
+	}
+	__declspec(noinline) std::unique_ptr<StackTrace> CaptureSiteB()
+	{
+		return StackTrace::Here();
+	}
+
+	// formats entries like a text driver but discards the output, optionally rejecting entries by note
+	class CountingDriver : public IDriver
+	{
+	public:
+		CountingDriver(std::string rejectNote = {}) : rejectNote_{ std::move(rejectNote) } {}
+		void Submit(const Entry& e) override
+		{
+			submitted++;
+			if (e.pTrace_ && e.pTrace_->IsRepeat()) {
+				repeats++;
+			}
+			formattedSize += formatter_.Format(e).size();
+			lastFile = e.GetSourceFileName();
+			lastLine = e.sourceLine_;
+		}
+		void Flush() override {}
+		bool Accepts(const Entry& e) const override
+		{
+			return rejectNote_.empty() || e.note_ != rejectNote_;
+		}
+		size_t submitted = 0;
+		size_t repeats = 0;
+		size_t formattedSize = 0;
+		std::string lastFile;
+		int lastLine = 0;
+	private:
+		std::string rejectNote_;
+		TextFormatter formatter_;
+	};
+
+	std::shared_ptr<Channel> MakeTestChannel(std::shared_ptr<IDriver> pDriver, bool linePolicy)
+	{
+		auto pChannel = std::make_shared<Channel>();
+		if (linePolicy) {
+			pChannel->AttachComponent(std::make_shared<LinePolicy>());
+		}
+		pChannel->AttachComponent(std::move(pDriver));
+		return pChannel;
+	}
+
+	// all entries logged from one source line, so that they share line table state and call stack
+	__declspec(noinline) void LogStormEntry(std::shared_ptr<IChannel> pChannel, int every, std::string note = "storm")
+	{
+		EntryBuilder{ Level::Error, __FILE__, __func__, __LINE__ }.to(pChannel).trace().every(every).note(std::move(note));
+	}
+	__declspec(noinline) void LogTracedEntry(std::shared_ptr<IChannel> pChannel, std::string note = "traced")
+	{
+		EntryBuilder{ Level::Error, __FILE__, __func__, __LINE__ }.to(pChannel).trace().note(std::move(note));
+	}
+	TEST_CLASS(TestStackTrace)
+	{
+	public:
+		TEST_METHOD_INITIALIZE(setup_)
+		{
+			StackTraceCache::Get().Clear();
+		}
+		TEST_METHOD(SameSiteSameHash)
+		{
+			std::unique_ptr<StackTrace> traces[2];
+			for (auto& t : traces) {
+				t = CaptureSiteA();
+			}
+			Assert::AreEqual(traces[0]->GetHash(), traces[1]->GetHash());
+		}
+		TEST_METHOD(DifferentSiteDifferentHash)
+		{
+			const auto pA = CaptureSiteA();
+			const auto pB = CaptureSiteB();
+			Assert::AreNotEqual(pA->GetHash(), pB->GetHash());
+		}
+		TEST_METHOD(ResolveOncePerUniqueTrace)
+		{
+			for (int i = 0; i < 100; i++) {
+				auto pA = CaptureSiteA();
+				pA->Resolve();
+				auto pB = CaptureSiteB();
+				pB->Resolve();
+				Assert::IsTrue(pA->Resolved());
+				Assert::IsFalse(pA->GetFrames().empty());
+			}
+			const auto stats = StackTraceCache::Get().GetStats();
+			Assert::AreEqual(2ull, stats.misses);
+			Assert::AreEqual(198ull, stats.hits);
+		}
+		TEST_METHOD(CachedFramesMatchDirectResolution)
+		{
+			auto pWarm = CaptureSiteA();
+			pWarm->Resolve();
+			auto pCached = CaptureSiteA();
+			pCached->Resolve();
+			const auto direct = StackTraceCache::Symbolize(std::stacktrace::current());
+			Assert::AreEqual(pWarm->ToString(), pCached->ToString());
+			Assert::IsTrue(pCached->GetFrames().size() > 1);
+			// outermost frames are shared between the direct capture and the cached trace
+			Assert::AreEqual(direct->back().description, pCached->GetFrames().back().description);
+		}
+		TEST_METHOD(CacheIsBounded)
+		{
+			StackTraceCache cache{ 1 };
+			auto pA = CaptureSiteA();
+			auto pB = CaptureSiteB();
+			cache.Resolve(pA->GetHash(), std::stacktrace::current());
+			cache.Resolve(pB->GetHash(), std::stacktrace::current());
+			cache.Resolve(pA->GetHash(), std::stacktrace::current());
+			Assert::AreEqual(1ull, cache.GetSize());
+			Assert::AreEqual(3ull, cache.GetStats().misses);
+			Assert::AreEqual(2ull, cache.GetStats().evictions);
+		}
+		TEST_METHOD(CollidingHashIsResolvedAgain)
+		{
+			StackTraceCache cache;
+			const auto traceA = std::stacktrace::current();
+			const auto traceB = std::stacktrace::current();
+			Assert::IsTrue(traceA != traceB);
+			// force both traces onto the same key
+			const auto pA = cache.Resolve(1, traceA);
+			const auto pB = cache.Resolve(1, traceB);
+			Assert::IsTrue(pA != pB);
+			Assert::AreEqual(2ull, cache.GetStats().misses);
+			Assert::AreEqual(1ull, cache.GetStats().collisions);
+			const auto direct = StackTraceCache::Symbolize(traceB);
+			Assert::AreEqual(direct->front().description, pB->front().description);
+			Assert::AreEqual(direct->front().line, pB->front().line);
+			// the colliding trace replaced the cached one
+			Assert::IsTrue(pB == cache.Resolve(1, traceB));
+			Assert::AreEqual(1ull, cache.GetStats().hits);
+			Assert::AreEqual(1ull, cache.GetSize());
+		}
+		TEST_METHOD(CopySharesResolvedFrames)
+		{
+			auto pA = CaptureSiteA();
+			pA->Resolve();
+			pA->SetRepeat(true);
+			const StackTrace copy{ *pA };
+			Assert::IsTrue(copy.Resolved());
+			Assert::IsTrue(copy.IsRepeat());
+			Assert::AreEqual(pA->GetHash(), copy.GetHash());
+			Assert::IsTrue(pA->GetFrames().data() == copy.GetFrames().data());
+		}
+		// error storm: the same error site logged with a trace many times in a row
+		// compares symbolizing every trace (cache disabled, previous behavior) against cached resolution
+		TEST_METHOD(ErrorStormBenchmark)
+		{
+			constexpr int stormSize = 500;
+			auto& cache = StackTraceCache::Get();
+			const auto runStorm = [&] {
+				QpcTimer timer;
+				for (int i = 0; i < stormSize; i++) {
+					auto pTrace = CaptureSiteA();
+					pTrace->Resolve();
+				}
+				return timer.Mark();
+			};
+			cache.SetCapacity(0);
+			const auto uncached = runStorm();
+			cache.SetCapacity(256);
+			const auto cached = runStorm();
+			Logger::WriteMessage(std::format("Error storm of {} traced entries: uncached {:.3f}ms, cached {:.3f}ms ({:.1f}x)\n",
+				stormSize, uncached * 1000., cached * 1000., uncached / cached).c_str());
+			Assert::IsTrue(cached < uncached);
+		}
+		TEST_METHOD(RateControlCountsOnlyListedEntries)
+		{
+			auto pDriver = std::make_shared<CountingDriver>();
+			auto pChannel = MakeTestChannel(pDriver, true);
+			// learn the line table key of the storm site
+			LogStormEntry(pChannel, 1);
+			pChannel->Flush();
+			auto& line = LineTable::Lookup(pDriver->lastFile, pDriver->lastLine);
+			const auto hitsBefore = line.PeekHit();
+			// whitelist mode without the storm line listed drops it before rate control counts it
+			LineTable::SetListMode(LineTable::ListMode::White);
+			for (int i = 0; i < 10; i++) {
+				LogStormEntry(pChannel, 2);
+			}
+			LineTable::SetListMode(LineTable::ListMode::None);
+			pChannel->Flush();
+			Assert::AreEqual(hitsBefore, line.PeekHit());
+			Assert::AreEqual(size_t(1), pDriver->submitted);
+			// once listing passes, every hit is counted and every other one is emitted
+			size_t expected = 1;
+			for (uint32_t i = 1; i <= 10; i++) {
+				LogStormEntry(pChannel, 2);
+				expected += (hitsBefore + i - 1) % 2 == 0;
+			}
+			pChannel->Flush();
+			Assert::AreEqual(hitsBefore + 10, line.PeekHit());
+			Assert::AreEqual(expected, pDriver->submitted);
+		}
+		TEST_METHOD(RateControlAppliesToCopiedEntries)
+		{
+			auto pDriver = std::make_shared<CountingDriver>();
+			auto pChannel = MakeTestChannel(pDriver, true);
+			// entry that already passed the line filter of another channel (e.g. copied from the middleware dll)
+			Entry e;
+			e.note_ = "copied";
+			e.sourceStrings_ = Entry::StaticSourceStrings{ __FILE__, __func__ };
+			e.sourceLine_ = __LINE__;
+			e.rateControl_ = { .type = Entry::RateControl::Type::First, .parameter = 0 };
+			e.hitCount_ = 1;
+			int otherChannel = 0;
+			e.pHitChannel_ = &otherChannel;
+			auto& line = LineTable::Lookup(e.GetSourceFileName(), e.sourceLine_);
+			const auto hitsBefore = line.PeekHit();
+			for (int i = 0; i < 5; i++) {
+				pChannel->Submit(e);
+			}
+			pChannel->Flush();
+			// this channel counts the hits itself, and rate control drops every one of them
+			Assert::AreEqual(hitsBefore + 5, line.PeekHit());
+			Assert::AreEqual(size_t(0), pDriver->submitted);
+		}
+		TEST_METHOD(RateControlNeedsLinePolicy)
+		{
+			auto pDriver = std::make_shared<CountingDriver>();
+			auto pChannel = MakeTestChannel(pDriver, false);
+			for (int i = 0; i < 5; i++) {
+				LogStormEntry(pChannel, 1000);
+			}
+			pChannel->Flush();
+			Assert::AreEqual(size_t(5), pDriver->submitted);
+		}
+		TEST_METHOD(RepeatTracesPerDriver)
+		{
+			auto pAll = std::make_shared<CountingDriver>();
+			auto pPicky = std::make_shared<CountingDriver>("first");
+			auto pChannel = MakeTestChannel(pAll, true);
+			pChannel->AttachComponent(pPicky, "drv:picky");
+			for (auto note : { "first", "second", "third" }) {
+				LogTracedEntry(pChannel, note);
+			}
+			pChannel->Flush();
+			Assert::AreEqual(size_t(3), pAll->submitted);
+			Assert::AreEqual(size_t(2), pAll->repeats);
+			// the picky driver never printed the first trace, so the second one is printed in full
+			Assert::AreEqual(size_t(2), pPicky->submitted);
+			Assert::AreEqual(size_t(1), pPicky->repeats);
+		}
+		// error storm through the full commit path: entry building, trace capture, channel queue,
+		// policies, trace resolution and text formatting, timed until the channel is flushed
+		TEST_METHOD(CommitStormBenchmark)
+		{
+			constexpr int stormSize = 500;
+			constexpr int every = 10;
+			auto& cache = StackTraceCache::Get();
+			const auto runStorm = [&](int rate, size_t& submitted) {
+				auto pDriver = std::make_shared<CountingDriver>();
+				auto pChannel = MakeTestChannel(pDriver, true);
+				QpcTimer timer;
+				for (int i = 0; i < stormSize; i++) {
+					if (rate > 1) {
+						LogStormEntry(pChannel, rate);
+					}
+					else {
+						LogTracedEntry(pChannel);
+					}
+				}
+				pChannel->Flush();
+				submitted = pDriver->submitted;
+				return timer.Mark();
+			};
+			size_t submitted = 0;
+			cache.SetCapacity(0);
+			const auto uncached = runStorm(1, submitted);
+			Assert::AreEqual(size_t(stormSize), submitted);
+			cache.SetCapacity(256);
+			const auto cached = runStorm(1, submitted);
+			Assert::AreEqual(size_t(stormSize), submitted);
+			const auto rateControlled = runStorm(every, submitted);
+			Assert::AreEqual(size_t(stormSize / every), submitted);
+			Logger::WriteMessage(std::format("Commit storm of {} traced entries: uncached {:.3f}ms, cached {:.3f}ms ({:.1f}x), "
+				"every {} {:.3f}ms ({:.1f}x)\n", stormSize, uncached * 1000., cached * 1000., uncached / cached,
+				every, rateControlled * 1000., uncached / rateControlled).c_str());
+			Assert::IsTrue(cached < uncached);
+		}
+	};
+}
@@ -0,0 +1,424 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Core/source/win/WinAPI.h>
+#include <PresentMonMiddleware/ConcreteMiddleware.h>
+#include <PresentMonMiddleware/ActionClient.h>
+#include <PresentMonMiddleware/MockCommon.h>
+#include <Interprocess/source/act/SymmetricActionServer.h>
+#include <Interprocess/source/PmStatusError.h>
+#include <Versioning/BuildId.h>
+#include <atomic>
+#include <format>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace MiddlewareTests::fake
+{
+	using namespace pmon;
+	using namespace pmon::ipc::act;
+	namespace acts = pmon::svc::acts;
+
+	// what the fake service was asked for, and how it should answer
+	struct FakeServiceState
+	{
+		std::string introspectionName;
+		std::atomic<int> adapterRequests = 0;
+		std::atomic<int> cpuRequests = 0;
+		std::atomic<int> batches = 0;
+		std::atomic<int> batchedRequests = 0;
+		std::atomic<bool> failAdapters = false;
+		std::atomic<bool> failCpu = false;
+		std::atomic<uint32_t> adapterCount = 2;
+		// scales the memory size reported for each adapter, changed to stand in for replaced devices
+		std::atomic<uint64_t> adapterMemoryScale = 1;
+		// round trips made for static data: each batch is one, as is each request outside of a batch
+		int GetStaticRoundTrips() const
+		{
+			return batches + adapterRequests + cpuRequests - batchedRequests;
+		}
+	};
+
+	struct FakeExecutionContext;
+
+	struct FakeSessionContext
+	{
+		std::unique_ptr<SymmetricActionConnector<FakeExecutionContext>> pConn;
+		uint32_t remotePid = 0;
+		uint32_t nextCommandToken = 0;
+	};
+
+	struct FakeExecutionContext
+	{
+		using SessionContextType = FakeSessionContext;
+		std::optional<uint32_t> responseWriteTimeoutMs;
+		FakeServiceState* pState = nullptr;
+	};
+
+	// stand-ins for the service actions the middleware uses at session open and for static metrics,
+	// with the same identifiers and wire types as the real ones
+	class OpenSession : public AsyncActionBase_<OpenSession, FakeExecutionContext>
+	{
+	public:
+		static constexpr const char* Identifier = "OpenSession";
+		using Params = acts::OpenSession::Params;
+		using Response = acts::OpenSession::Response;
+	private:
+		friend class AsyncActionBase_<OpenSession, FakeExecutionContext>;
+		static Response Execute_(const FakeExecutionContext& ctx, SessionContext& stx, Params&& in)
+		{
+			stx.remotePid = in.clientPid;
+			return { GetCurrentProcessId(), bid::BuildIdShortHash(), bid::BuildIdConfig() };
+		}
+	};
+
+	class GetIntrospectionShmName : public AsyncActionBase_<GetIntrospectionShmName, FakeExecutionContext>
+	{
+	public:
+		static constexpr const char* Identifier = "GetIntrospectionShmName";
+		using Params = acts::GetIntrospectionShmName::Params;
+		using Response = acts::GetIntrospectionShmName::Response;
+	private:
+		friend class AsyncActionBase_<GetIntrospectionShmName, FakeExecutionContext>;
+		static Response Execute_(const FakeExecutionContext& ctx, SessionContext& stx, Params&& in)
+		{
+			return { ctx.pState->introspectionName };
+		}
+	};
+
+	class EnumerateAdapters : public AsyncActionBase_<EnumerateAdapters, FakeExecutionContext>
+	{
+	public:
+		static constexpr const char* Identifier = "EnumerateAdapters";
+		using Params = acts::EnumerateAdapters::Params;
+		using Response = acts::EnumerateAdapters::Response;
+	private:
+		friend class AsyncActionBase_<EnumerateAdapters, FakeExecutionContext>;
+		static Response Execute_(const FakeExecutionContext& ctx, SessionContext& stx, Params&& in)
+		{
+			ctx.pState->adapterRequests++;
+			if (ctx.pState->failAdapters) {
+				throw util::Except<ActionExecutionError>(PM_STATUS_FAILURE);
+			}
+			Response out;
+			for (uint32_t i = 0; i < ctx.pState->adapterCount; i++) {
+				out.adapters.push_back({
+					.id = i,
+					.vendor = PM_DEVICE_VENDOR_INTEL,
+					.name = std::format("Adapter {}", i),
+					.gpuSustainedPowerLimit = 100. * (i + 1),
+					.gpuMemorySize = (i + 1) * ctx.pState->adapterMemoryScale * 1'000'000'000ull,
+					.gpuMemoryMaxBandwidth = (i + 1) * 500'000'000ull,
+				});
+			}
+			return out;
+		}
+	};
+
+	class GetStaticCpuMetrics : public AsyncActionBase_<GetStaticCpuMetrics, FakeExecutionContext>
+	{
+	public:
+		static constexpr const char* Identifier = "GetStaticCpuMetrics";
+		using Params = acts::GetStaticCpuMetrics::Params;
+		using Response = acts::GetStaticCpuMetrics::Response;
+	private:
+		friend class AsyncActionBase_<GetStaticCpuMetrics, FakeExecutionContext>;
+		static Response Execute_(const FakeExecutionContext& ctx, SessionContext& stx, Params&& in)
+		{
+			ctx.pState->cpuRequests++;
+			if (ctx.pState->failCpu) {
+				throw util::Except<ActionExecutionError>(PM_STATUS_FAILURE);
+			}
+			return { "Intel Fake CPU", 65. };
+		}
+	};
+
+	class Batch : public AsyncActionBase_<Batch, FakeExecutionContext>
+	{
+	public:
+		static constexpr const char* Identifier = BatchEnvelope::Identifier;
+		using Params = BatchEnvelope::Params;
+		using Response = BatchEnvelope::Response;
+	private:
+		friend class AsyncActionBase_<Batch, FakeExecutionContext>;
+		static Response Execute_(FakeExecutionContext& ctx, SessionContext& stx, Params&& in)
+		{
+			ctx.pState->batches++;
+			ctx.pState->batchedRequests += int(in.requests.size());
+			return ExecuteBatch(ctx, stx, in);
+		}
+	};
+
+	AsyncActionRegistrator<OpenSession, FakeExecutionContext> regOpenSession_;
+	AsyncActionRegistrator<GetIntrospectionShmName, FakeExecutionContext> regGetIntrospectionShmName_;
+	AsyncActionRegistrator<EnumerateAdapters, FakeExecutionContext> regEnumerateAdapters_;
+	AsyncActionRegistrator<GetStaticCpuMetrics, FakeExecutionContext> regGetStaticCpuMetrics_;
+	AsyncActionRegistrator<Batch, FakeExecutionContext> regBatch_;
+
+	// the fake service: action server plus the introspection published by the mock devices
+	// (an Intel gpu with device id 1 and an Nvidia gpu with device id 2)
+	class FakeService
+	{
+	public:
+		FakeService(bool failAdapters = false, bool failCpu = false, uint32_t adapterCount = 2)
+			:
+			pipeName_{ std::format(R"(\\.\pipe\pm-unit-static-svc-{})", GetCurrentProcessId()) },
+			state_{ MakeState_(failAdapters, failCpu, adapterCount) },
+			pComms_{ ipc::MakeServiceComms(state_->introspectionName) },
+			server_{ FakeExecutionContext{ .pState = state_.get() }, pipeName_, 1,
+				util::pipe::DuplexPipe::GetSecurityString(util::pipe::SecurityMode::None) }
+		{
+			ipc::intro::RegisterMockIntrospectionDevices(*pComms_);
+		}
+		const std::string& GetPipeName() const { return pipeName_; }
+		FakeServiceState& State() { return *state_; }
+		// what the service does after a device reset: enumerate adapters anew (same ids, different devices)
+		// and advance the adapter generation
+		void ReplaceAdapters(uint64_t memoryScale)
+		{
+			state_->adapterMemoryScale = memoryScale;
+			pComms_->AdvanceAdapterGeneration();
+		}
+	private:
+		static std::unique_ptr<FakeServiceState> MakeState_(bool failAdapters, bool failCpu, uint32_t adapterCount)
+		{
+			auto pState = std::make_unique<FakeServiceState>();
+			pState->introspectionName = std::format("pm-unit-static-intro-{}", GetCurrentProcessId());
+			pState->failAdapters = failAdapters;
+			pState->failCpu = failCpu;
+			pState->adapterCount = adapterCount;
+			return pState;
+		}
+		std::string pipeName_;
+		std::unique_ptr<FakeServiceState> state_;
+		std::unique_ptr<ipc::ServiceComms> pComms_;
+		SymmetricActionServer<FakeExecutionContext> server_;
+	};
+}
+
+namespace MiddlewareTests
+{
+	using namespace fake;
+	using namespace pmon::mid;
+	using namespace std::string_literals;
+
+	PM_QUERY_ELEMENT MakeElement(PM_METRIC metric, uint32_t deviceId = 0)
+	{
+		return { .metric = metric, .stat = PM_STAT_NONE, .deviceId = deviceId };
+	}
+
+	template<typename T>
+	T ReadBlob(const std::vector<uint8_t>& blob, const PM_QUERY_ELEMENT& element)
+	{
+		return *reinterpret_cast<const T*>(&blob[element.dataOffset]);
+	}
+
+	std::string ReadBlobString(const std::vector<uint8_t>& blob, const PM_QUERY_ELEMENT& element)
+	{
+		return reinterpret_cast<const char*>(&blob[element.dataOffset]);
+	}
+
+	// polls a batch into a blob with room to spare
+	std::vector<uint8_t> PollBatch(ConcreteMiddleware& middleware, std::vector<PM_QUERY_ELEMENT>& elements)
+	{
+		std::vector<uint8_t> blob(4096);
+		auto blobSize = uint32_t(blob.size());
+		middleware.PollStaticQueryBatch(elements, 0, blob.data(), blobSize);
+		blob.resize(blobSize);
+		return blob;
+	}
+
+	TEST_CLASS(TestStaticQueryBatch)
+	{
+	public:
+		TEST_METHOD(SessionOpenIsOneRoundTrip)
+		{
+			FakeService service;
+			ConcreteMiddleware middleware{ service.GetPipeName() };
+			Assert::AreEqual(1, service.State().batches.load());
+			Assert::AreEqual(1, service.State().adapterRequests.load());
+			Assert::AreEqual(1, service.State().cpuRequests.load());
+			Assert::AreEqual(1, service.State().GetStaticRoundTrips());
+		}
+		TEST_METHOD(PollsAfterSessionOpenMakeNoRequests)
+		{
+			FakeService service;
+			ConcreteMiddleware middleware{ service.GetPipeName() };
+			std::vector<PM_QUERY_ELEMENT> elements{
+				MakeElement(PM_METRIC_GPU_NAME, 1),
+				MakeElement(PM_METRIC_GPU_VENDOR, 2),
+				MakeElement(PM_METRIC_GPU_MEM_SIZE, 1),
+				MakeElement(PM_METRIC_GPU_MEM_MAX_BANDWIDTH, 2),
+				MakeElement(PM_METRIC_GPU_SUSTAINED_POWER_LIMIT, 2),
+				MakeElement(PM_METRIC_CPU_NAME),
+				MakeElement(PM_METRIC_CPU_VENDOR),
+				MakeElement(PM_METRIC_CPU_POWER_LIMIT),
+			};
+			std::vector<uint8_t> blob;
+			for (int i = 0; i < 100; i++) {
+				blob = PollBatch(middleware, elements);
+			}
+			Assert::AreEqual(1, service.State().GetStaticRoundTrips());
+
+			Assert::AreEqual("Arc 750"s, ReadBlobString(blob, elements[0]));
+			Assert::AreEqual((int)PM_DEVICE_VENDOR_NVIDIA, (int)ReadBlob<PM_DEVICE_VENDOR>(blob, elements[1]));
+			Assert::AreEqual(1'000'000'000., ReadBlob<double>(blob, elements[2]));
+			Assert::AreEqual(1'000'000'000., ReadBlob<double>(blob, elements[3]));
+			Assert::AreEqual(200., ReadBlob<double>(blob, elements[4]));
+			Assert::AreEqual("Intel Fake CPU"s, ReadBlobString(blob, elements[5]));
+			Assert::AreEqual((int)PM_DEVICE_VENDOR_INTEL, (int)ReadBlob<PM_DEVICE_VENDOR>(blob, elements[6]));
+			Assert::AreEqual(65., ReadBlob<double>(blob, elements[7]));
+		}
+		TEST_METHOD(FailedSourcesAreRetriedInOneRoundTrip)
+		{
+			FakeService service{ true, true };
+			ConcreteMiddleware middleware{ service.GetPipeName() };
+			Assert::AreEqual(1, service.State().GetStaticRoundTrips());
+
+			service.State().failAdapters = false;
+			service.State().failCpu = false;
+			std::vector<PM_QUERY_ELEMENT> elements{
+				MakeElement(PM_METRIC_GPU_MEM_SIZE, 2),
+				MakeElement(PM_METRIC_CPU_POWER_LIMIT),
+			};
+			auto blob = PollBatch(middleware, elements);
+			Assert::AreEqual(2, service.State().batches.load());
+			Assert::AreEqual(2, service.State().GetStaticRoundTrips());
+			Assert::AreEqual(2'000'000'000., ReadBlob<double>(blob, elements[0]));
+			Assert::AreEqual(65., ReadBlob<double>(blob, elements[1]));
+
+			PollBatch(middleware, elements);
+			Assert::AreEqual(2, service.State().GetStaticRoundTrips());
+		}
+		TEST_METHOD(OnlyFailedSourceIsRetried)
+		{
+			FakeService service{ false, true };
+			ConcreteMiddleware middleware{ service.GetPipeName() };
+
+			service.State().failCpu = false;
+			std::vector<PM_QUERY_ELEMENT> elements{
+				MakeElement(PM_METRIC_GPU_MEM_SIZE, 1),
+				MakeElement(PM_METRIC_CPU_NAME),
+			};
+			auto blob = PollBatch(middleware, elements);
+			Assert::AreEqual(1, service.State().batches.load());
+			Assert::AreEqual(1, service.State().adapterRequests.load());
+			Assert::AreEqual(2, service.State().cpuRequests.load());
+			Assert::AreEqual(2, service.State().GetStaticRoundTrips());
+			Assert::AreEqual("Intel Fake CPU"s, ReadBlobString(blob, elements[1]));
+		}
+		TEST_METHOD(MissingAdapterIsEnumeratedAgain)
+		{
+			// the service enumerates only the first of the two adapters in introspection
+			FakeService service{ false, false, 1 };
+			ConcreteMiddleware middleware{ service.GetPipeName() };
+			Assert::AreEqual(1, service.State().adapterRequests.load());
+
+			// cpu values are loaded, so polling them does not enumerate adapters
+			std::vector<PM_QUERY_ELEMENT> cpuElements{ MakeElement(PM_METRIC_CPU_POWER_LIMIT) };
+			PollBatch(middleware, cpuElements);
+			Assert::AreEqual(1, service.State().adapterRequests.load());
+
+			std::vector<PM_QUERY_ELEMENT> elements{
+				MakeElement(PM_METRIC_GPU_MEM_SIZE, 1),
+				MakeElement(PM_METRIC_GPU_MEM_SIZE, 2),
+			};
+			auto blob = PollBatch(middleware, elements);
+			Assert::AreEqual(2, service.State().adapterRequests.load());
+			Assert::AreEqual(1'000'000'000., ReadBlob<double>(blob, elements[0]));
+			Assert::AreEqual(0., ReadBlob<double>(blob, elements[1]));
+
+			service.State().adapterCount = 2;
+			blob = PollBatch(middleware, elements);
+			Assert::AreEqual(3, service.State().adapterRequests.load());
+			Assert::AreEqual(2'000'000'000., ReadBlob<double>(blob, elements[1]));
+
+			PollBatch(middleware, elements);
+			Assert::AreEqual(3, service.State().adapterRequests.load());
+			Assert::AreEqual(1, service.State().cpuRequests.load());
+		}
+		TEST_METHOD(ReplacedAdapterIsEnumeratedAgain)
+		{
+			FakeService service;
+			ConcreteMiddleware middleware{ service.GetPipeName() };
+			std::vector<PM_QUERY_ELEMENT> elements{
+				MakeElement(PM_METRIC_GPU_MEM_SIZE, 1),
+				MakeElement(PM_METRIC_GPU_MEM_SIZE, 2),
+			};
+			auto blob = PollBatch(middleware, elements);
+			Assert::AreEqual(1, service.State().adapterRequests.load());
+			Assert::AreEqual(2'000'000'000., ReadBlob<double>(blob, elements[1]));
+
+			// every adapter is still found under its id, so only the generation reveals the replacement
+			service.ReplaceAdapters(4);
+			blob = PollBatch(middleware, elements);
+			Assert::AreEqual(2, service.State().adapterRequests.load());
+			Assert::AreEqual(4'000'000'000., ReadBlob<double>(blob, elements[0]));
+			Assert::AreEqual(8'000'000'000., ReadBlob<double>(blob, elements[1]));
+
+			// single element polls share the cache
+			PollBatch(middleware, elements);
+			double memSize = 0.;
+			middleware.PollStaticQuery(elements[0], 0, reinterpret_cast<uint8_t*>(&memSize));
+			Assert::AreEqual(4'000'000'000., memSize);
+			Assert::AreEqual(2, service.State().adapterRequests.load());
+			Assert::AreEqual(1, service.State().cpuRequests.load());
+
+			service.ReplaceAdapters(1);
+			middleware.PollStaticQuery(elements[0], 0, reinterpret_cast<uint8_t*>(&memSize));
+			Assert::AreEqual(3, service.State().adapterRequests.load());
+			Assert::AreEqual(1'000'000'000., memSize);
+		}
+		TEST_METHOD(Layout)
+		{
+			FakeService service;
+			ConcreteMiddleware middleware{ service.GetPipeName() };
+			std::vector<PM_QUERY_ELEMENT> elements{
+				MakeElement(PM_METRIC_GPU_NAME, 1),
+				MakeElement(PM_METRIC_GPU_MEM_SIZE, 1),
+				MakeElement(PM_METRIC_CPU_NAME),
+			};
+			const auto blob = PollBatch(middleware, elements);
+			Assert::AreEqual(uint64_t(0), elements[0].dataOffset);
+			Assert::AreEqual(uint64_t(260), elements[0].dataSize);
+			Assert::AreEqual(uint64_t(260), elements[1].dataOffset);
+			Assert::AreEqual(uint64_t(8), elements[1].dataSize);
+			Assert::AreEqual(uint64_t(268), elements[2].dataOffset);
+			Assert::AreEqual(size_t(528), blob.size());
+		}
+		TEST_METHOD(SmallBlobReportsRequiredSize)
+		{
+			FakeService service{ true, true };
+			ConcreteMiddleware middleware{ service.GetPipeName() };
+			service.State().failAdapters = false;
+			service.State().failCpu = false;
+			std::vector<PM_QUERY_ELEMENT> elements{
+				MakeElement(PM_METRIC_GPU_NAME, 1),
+				MakeElement(PM_METRIC_CPU_POWER_LIMIT),
+			};
+			uint32_t blobSize = 0;
+			Assert::ExpectException<pmon::ipc::PmStatusError>([&] {
+				middleware.PollStaticQueryBatch(elements, 0, nullptr, blobSize);
+			});
+			Assert::AreEqual(268u, blobSize);
+			// nothing is fetched for a batch that is not polled
+			Assert::AreEqual(1, service.State().GetStaticRoundTrips());
+		}
+		TEST_METHOD(DynamicMetricFailsBatch)
+		{
+			FakeService service;
+			ConcreteMiddleware middleware{ service.GetPipeName() };
+			std::vector<PM_QUERY_ELEMENT> elements{
+				MakeElement(PM_METRIC_CPU_NAME),
+				MakeElement(PM_METRIC_CPU_UTILIZATION),
+			};
+			Assert::ExpectException<pmon::util::Exception>([&] {
+				PollBatch(middleware, elements);
+			});
+		}
+	};
+}
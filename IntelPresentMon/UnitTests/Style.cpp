@@ -13,6 +13,8 @@
 #include <Core/source/gfx/layout/FlexElement.h>
 
 #include <Core/source/gfx/layout/style/RawAttributeHelpers.h>
+#include <CommonUtilities/Qpc.h>
+#include <format>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -34,6 +36,259 @@ namespace LayoutTests
 {
 	using namespace std::string_literals;
 
+	// style processing as it was done before attribute tables: merged sheet per element, resolved
+	// by map lookup + raw conversion, walking the sheet stack for inherited values
+	class LegacyStyleProcessor
+	{
+	public:
+		class StackToken
+		{
+		public:
+			StackToken(LegacyStyleProcessor& processor_) : processor{ processor_ } {}
+			StackToken(const StackToken&) = delete;
+			StackToken& operator=(const StackToken&) = delete;
+			~StackToken()
+			{
+				processor.compiler.PopParent();
+				processor.resolver.PopAppliedSheet();
+			}
+		private:
+			LegacyStyleProcessor& processor;
+		};
+		LegacyStyleProcessor(std::vector<std::shared_ptr<p2c::gfx::lay::sty::Stylesheet>> rules,
+			std::shared_ptr<p2c::gfx::lay::sty::Stylesheet> pBase)
+			:
+			compiler{ std::move(rules) },
+			resolver{ std::move(pBase) }
+		{}
+		StackToken Push(const p2c::gfx::lay::Element* pElement)
+		{
+			resolver.PushAppliedSheet(compiler.Compile(pElement->GetClasses()));
+			compiler.PushParent(pElement->GetClasses());
+			return { *this };
+		}
+		template<class A>
+		auto Resolve() const
+		{
+			return resolver.Resolve<A>();
+		}
+	private:
+		p2c::gfx::lay::sty::StyleCompiler compiler;
+		p2c::gfx::lay::sty::StyleResolver resolver;
+	};
+
+	// sheets in the shape of those made by MakeOverlaySpec, plus some inheritance chains
+	std::vector<std::shared_ptr<p2c::gfx::lay::sty::Stylesheet>> MakeOverlaySheets()
+	{
+		using namespace p2c::gfx;
+		using namespace p2c::gfx::lay::sty;
+		using lay::FlexDirection;
+		using lay::FlexAlignment;
+		using lay::FlexJustification;
+		std::vector<std::shared_ptr<Stylesheet>> sheets{ Stylesheet::MakeDefaultInherit() };
+		const auto inherit = std::wstring(at::Special::Inherit::key);
+
+		sheets.push_back(Stylesheet::Make({ {}, {"doc"} }));
+		sheets.back()->InsertRaw<at::backgroundColor>(MakeColorRaw(20, 20, 40, 0.8f));
+		sheets.back()->InsertRaw<at::flexDirection>(at::make::Enum(FlexDirection::Column));
+		sheets.back()->InsertRaw<at::paddingLeft>(5.);
+		sheets.back()->InsertRaw<at::paddingTop>(5.);
+		sheets.back()->InsertRaw<at::borderLeft>(1.);
+		sheets.back()->InsertRaw<at::borderColorLeft>(MakeColorRaw(200, 200, 200, 1.f));
+		sheets.back()->InsertRaw<at::borderColorTop>(MakeColorRaw(200, 200, 200, 1.f));
+		sheets.back()->InsertRaw<at::textColor>(MakeColorRaw(255, 255, 255, 1.f));
+		sheets.back()->InsertRaw<at::textSize>(14.);
+
+		sheets.push_back(Stylesheet::Make({ {}, {"$graph"} }));
+		sheets.back()->InsertRaw<at::width>(1920.);
+		sheets.back()->InsertRaw<at::flexDirection>(at::make::Enum(FlexDirection::Column));
+		sheets.back()->InsertRaw<at::flexAlignment>(at::make::Enum(FlexAlignment::Stretch));
+		sheets.back()->InsertRaw<at::marginLeft>(2.);
+		sheets.back()->InsertRaw<at::textFont>(L"Arial"s);
+		sheets.back()->InsertRaw<at::graphLineColor>(MakeColorRaw(100, 255, 255, 0.8f));
+		sheets.back()->InsertRaw<at::graphTimeWindow>(10.);
+		sheets.back()->InsertRaw<at::backgroundColor>(inherit);
+
+		sheets.push_back(Stylesheet::Make({ {"$graph"}, {"$axis"} }));
+		sheets.back()->InsertRaw<at::textSize>(10.);
+
+		sheets.push_back(Stylesheet::Make({ {"$graph"}, {"$body"} }));
+		sheets.back()->InsertRaw<at::flexDirection>(at::make::Enum(FlexDirection::Row));
+		sheets.back()->InsertRaw<at::flexGrow>(1.);
+		sheets.back()->InsertRaw<at::textColor>(inherit);
+
+		sheets.push_back(Stylesheet::Make({ {"$graph"}, {"$vert-axis"} }));
+		sheets.back()->InsertRaw<at::width>(30.);
+		sheets.back()->InsertRaw<at::flexJustification>(at::make::Enum(FlexJustification::Between));
+
+		sheets.push_back(Stylesheet::Make({ {"$body-left"}, {"$y-axis"} }));
+		sheets.back()->InsertRaw<at::textJustification>(at::make::Enum(prim::Justification::Right));
+
+		sheets.push_back(Stylesheet::Make({ {"$body-right"}, {"$y-axis"} }));
+		sheets.back()->InsertRaw<at::textJustification>(at::make::Enum(prim::Justification::Left));
+
+		sheets.push_back(Stylesheet::Make({ {"$graph", "$hist"}, {"$body-right"} }));
+		sheets.back()->InsertRaw<at::display>(at::make::Enum(lay::Display::Invisible));
+
+		sheets.push_back(Stylesheet::Make({ {"$graph"}, {"$body-plot"} }));
+		sheets.back()->InsertRaw<at::borderLeft>(1.);
+		sheets.back()->InsertRaw<at::borderTop>(1.);
+		sheets.back()->InsertRaw<at::flexGrow>(1.);
+		sheets.back()->InsertRaw<at::borderColorLeft>(inherit);
+
+		sheets.push_back(Stylesheet::Make({ {"$graph"}, {"$footer"} }));
+		sheets.back()->InsertRaw<at::marginTop>(3.);
+		sheets.back()->InsertRaw<at::height>(std::wstring(at::Special::Auto::key));
+
+		sheets.push_back(Stylesheet::Make({ {"$graph"}, {"$footer-center"} }));
+		sheets.back()->InsertRaw<at::flexGrow>(1.);
+		sheets.back()->InsertRaw<at::textSize>(inherit);
+
+		sheets.push_back(Stylesheet::Make({ {}, {"readout-container"} }));
+		sheets.back()->InsertRaw<at::width>(1920.);
+		sheets.back()->InsertRaw<at::paddingLeft>(9.);
+		sheets.back()->InsertRaw<at::flexDirection>(at::make::Enum(FlexDirection::Column));
+		sheets.back()->InsertRaw<at::backgroundColor>(MakeColorRaw(0, 0, 0, 0.f));
+		sheets.back()->InsertRaw<at::textColor>(MakeColorRaw(205, 211, 233, 1.f));
+		sheets.back()->InsertRaw<at::textSize>(12.);
+
+		sheets.push_back(Stylesheet::Make({ {}, {"$readout"} }));
+		sheets.back()->InsertRaw<at::paddingLeft>(2.);
+		sheets.back()->InsertRaw<at::paddingRight>(2.);
+
+		sheets.push_back(Stylesheet::Make({ {"$readout"}, {"$label"} }));
+		sheets.back()->InsertRaw<at::paddingRight>(20.);
+
+		sheets.push_back(Stylesheet::Make({ {"$readout"}, {"$numeric-value"} }));
+		sheets.back()->InsertRaw<at::textJustification>(at::make::Enum(prim::Justification::Right));
+
+		sheets.push_back(Stylesheet::Make({ {"$readout"}, {"$text-large", "$numeric-value"} }));
+		sheets.back()->InsertRaw<at::textSize>(18.);
+		sheets.back()->InsertRaw<at::textWeight>(at::make::Enum(prim::Weight::Bold));
+
+		return sheets;
+	}
+
+	// element tree in the shape of an overlay document
+	std::shared_ptr<p2c::gfx::lay::Element> MakeOverlayDocument(int graphCount, int readoutCount)
+	{
+		using p2c::gfx::lay::FlexElement;
+		using p2c::gfx::lay::Element;
+		std::vector<std::shared_ptr<Element>> widgets;
+		for (int g = 0; g < graphCount; g++) {
+			auto makeAxis = [](std::string side) {
+				return FlexElement::Make({
+					FlexElement::Make({}, { "$axis", "$y-axis" }),
+					FlexElement::Make({}, { "$axis", "$y-axis" }),
+					FlexElement::Make({}, { "$axis", "$y-axis" }),
+				}, { "$vert-axis", "$body-" + side });
+			};
+			widgets.push_back(FlexElement::Make({
+				FlexElement::Make({ FlexElement::Make({}, { "$label-value" }) }, { "$header" }),
+				FlexElement::Make({
+					makeAxis("left"),
+					FlexElement::Make({}, { "$body-plot" }),
+					makeAxis("right"),
+				}, { "$body" }),
+				FlexElement::Make({
+					FlexElement::Make({}, { "$axis", "$footer-left" }),
+					FlexElement::Make({
+						FlexElement::Make({}, { "$axis", "$footer-center-left" }),
+						FlexElement::Make({}, { "$axis", "$footer-center-right" }),
+					}, { "$footer-center" }),
+					FlexElement::Make({}, { "$axis", "$footer-right" }),
+				}, { "$footer" }),
+			}, g % 3 ? std::vector<std::string>{ "$graph" } : std::vector<std::string>{ "$graph", "$hist" }));
+		}
+		std::vector<std::shared_ptr<Element>> readouts;
+		for (int r = 0; r < readoutCount; r++) {
+			readouts.push_back(FlexElement::Make({
+				FlexElement::Make({}, { "$text-large", "$label" }),
+				FlexElement::Make({}, { "$text-large", "$numeric-value" }),
+				FlexElement::Make({}, { "$numeric-units" }),
+			}, { "$readout" }));
+		}
+		widgets.push_back(FlexElement::Make(std::move(readouts), { "readout-container" }));
+		return FlexElement::Make(std::move(widgets), { "doc" });
+	}
+
+	// attributes resolved for every element in a layout pass
+	template<class P>
+	float ResolveLayoutAttributes(const P& processor)
+	{
+		using namespace p2c::gfx::lay::sty;
+		const auto margin = processor.template Resolve<at::margin>();
+		const auto border = processor.template Resolve<at::border>();
+		const auto padding = processor.template Resolve<at::padding>();
+		const auto size = processor.template Resolve<at::size>();
+		return margin.left + border.top + padding.right + size.width.value_or(0.f) +
+			processor.template Resolve<at::flexGrow>() +
+			float(processor.template Resolve<at::flexDirection>()) +
+			float(processor.template Resolve<at::display>());
+	}
+
+	// visits elements in the same nesting as QueryLayoutConstraints / SetDimension / SetPosition
+	// a dimension pass queries the constraints of all children before dimensioning each of them
+	template<class P>
+	float QueryPass(P& processor, const p2c::gfx::lay::Element& element)
+	{
+		const auto tok = processor.Push(&element);
+		auto sum = ResolveLayoutAttributes(processor);
+		for (auto& pChild : element.GetChildren()) {
+			sum += QueryPass(processor, *pChild);
+		}
+		return sum;
+	}
+	template<class P>
+	float DimensionPass(P& processor, const p2c::gfx::lay::Element& element)
+	{
+		const auto tok = processor.Push(&element);
+		auto sum = ResolveLayoutAttributes(processor);
+		for (auto& pChild : element.GetChildren()) {
+			sum += QueryPass(processor, *pChild);
+		}
+		for (auto& pChild : element.GetChildren()) {
+			sum += DimensionPass(processor, *pChild);
+		}
+		return sum;
+	}
+	template<class P>
+	float PositionPass(P& processor, const p2c::gfx::lay::Element& element)
+	{
+		using namespace p2c::gfx::lay::sty;
+		const auto tok = processor.Push(&element);
+		auto sum = processor.template Resolve<at::borderColorLeft>().r + processor.template Resolve<at::backgroundColor>().a +
+			processor.template Resolve<at::textSize>() + processor.template Resolve<at::textColor>().g +
+			float(processor.template Resolve<at::flexJustification>()) +
+			float(processor.template Resolve<at::textFont>().size());
+		for (auto& pChild : element.GetChildren()) {
+			sum += PositionPass(processor, *pChild);
+		}
+		return sum;
+	}
+	template<class P>
+	float LayoutPass(P& processor, const p2c::gfx::lay::Element& root)
+	{
+		return DimensionPass(processor, root) + DimensionPass(processor, root) + PositionPass(processor, root);
+	}
+
+	// checks that every attribute resolves the same way for the element and all of its descendants
+	void CompareResolution(LegacyStyleProcessor& legacy, p2c::gfx::lay::sty::StyleProcessor& compiled,
+		const p2c::gfx::lay::Element& element, int& count)
+	{
+		using namespace p2c::gfx::lay::sty;
+		const auto legacyTok = legacy.Push(&element);
+		const auto compiledTok = compiled.Push(&element);
+#define DEF_ATT(name, resolved, simp, aut, def) \
+		Assert::IsTrue(legacy.Resolve<at::name>() == compiled.Resolve<at::name>(), L"" #name); \
+		count++;
+		XAT_ATTRIBUTE_LIST(DEF_ATT)
+#undef DEF_ATT
+		for (auto& pChild : element.GetChildren()) {
+			CompareResolution(legacy, compiled, *pChild, count);
+		}
+	}
+
 	TEST_CLASS(TestStyle)
 	{
 	public:
@@ -221,6 +476,82 @@ namespace LayoutTests
 			Assert::AreEqual(15.4f, border.bottom);
 		}
 
+		TEST_METHOD(AttributeIds)
+		{
+			using namespace p2c::gfx::lay::sty;
+			Assert::IsTrue(at::FindAttributeId(at::width::key) == at::AttributeId::width);
+			Assert::IsTrue(at::FindAttributeId("marginBottom") == at::marginBottom::id);
+			Assert::IsFalse(bool(at::FindAttributeId("notAnAttribute")));
+			Assert::IsTrue(size_t(at::graphAntiAlias::id) < at::attributeCount);
+		}
+		TEST_METHOD(InternSheet)
+		{
+			using namespace p2c::gfx::lay::sty;
+			auto pSheet = Stylesheet::Make();
+			pSheet->InsertRaw(at::height::key, std::wstring(at::Special::Auto::key));
+			pSheet->InsertRaw(at::width::key, 420.69);
+			pSheet->InsertRaw(at::textSize::key, std::wstring(at::Special::Inherit::key));
+			pSheet->InsertRaw("notAnAttribute", 1.);
+			const auto table = pSheet->Intern();
+			Assert::IsTrue(std::holds_alternative<at::Special::Auto>(table.Get<at::height>()));
+			Assert::IsTrue(std::get<float>(table.Get<at::width>()) == 420.69f);
+			Assert::IsTrue(std::holds_alternative<at::Special::Inherit>(table.Get<at::textSize>()));
+			Assert::IsTrue(std::holds_alternative<std::monostate>(table.Get<at::textFont>()));
+		}
+		TEST_METHOD(CompiledMatchesResolver)
+		{
+			using namespace p2c::gfx::lay::sty;
+			const auto pDoc = MakeOverlayDocument(3, 4);
+			int count = 0;
+			// overlay sheets, and each of the sheets used in the tests above
+			{
+				LegacyStyleProcessor legacy{ MakeOverlaySheets(), Stylesheet::MakeBase() };
+				StyleProcessor compiled{ MakeOverlaySheets(), Stylesheet::MakeBase() };
+				CompareResolution(legacy, compiled, *pDoc, count);
+			}
+			{
+				auto pActiveSheet = Stylesheet::Make({ {}, {"$readout"} });
+				pActiveSheet->InsertRaw(at::backgroundColor::key, std::wstring(at::Special::Inherit::key));
+				pActiveSheet->InsertRaw(at::borderColorLeft::key, std::wstring(at::Special::Inherit::key));
+				auto pNearSheet = Stylesheet::Make({ {}, {"readout-container"} });
+				pNearSheet->InsertRaw(at::backgroundColor::key, std::wstring(at::Special::Inherit::key));
+				auto pFarSheet = Stylesheet::Make({ {}, {"doc"} });
+				pFarSheet->InsertRaw(at::backgroundColor::key, MakeColorRaw(11, 0, 0, 1.f));
+				pFarSheet->InsertRaw(at::borderColorLeft::key, MakeColorRaw(22, 0, 0, 1.f));
+				auto pInactiveSheet = Stylesheet::Make({ {"$graph"}, {"$readout"} });
+				pInactiveSheet->InsertRaw(at::backgroundColor::key, MakeColorRaw(4, 20, 0, 1.f));
+				auto sheets = std::vector{ pInactiveSheet, pActiveSheet, pNearSheet, pFarSheet, Stylesheet::MakeDefaultInherit() };
+				LegacyStyleProcessor legacy{ sheets, Stylesheet::MakeBase() };
+				StyleProcessor compiled{ sheets, Stylesheet::MakeBase() };
+				CompareResolution(legacy, compiled, *pDoc, count);
+			}
+			Assert::IsTrue(count > 1000);
+		}
+		TEST_METHOD(LayoutBenchmark)
+		{
+			// style resolution cost of laying out an overlay document (one FinalizeAsRoot)
+			using namespace p2c::gfx::lay::sty;
+			constexpr int repeats = 20;
+			const auto pDoc = MakeOverlayDocument(8, 20);
+			const auto sheets = MakeOverlaySheets();
+			float legacySum = 0.f;
+			float compiledSum = 0.f;
+			pmon::util::QpcTimer legacyTimer;
+			for (int i = 0; i < repeats; i++) {
+				LegacyStyleProcessor legacy{ sheets, Stylesheet::MakeBase() };
+				legacySum += LayoutPass(legacy, *pDoc);
+			}
+			const auto legacyTime = legacyTimer.Mark() / repeats;
+			pmon::util::QpcTimer compiledTimer;
+			for (int i = 0; i < repeats; i++) {
+				StyleProcessor compiled{ sheets, Stylesheet::MakeBase() };
+				compiledSum += LayoutPass(compiled, *pDoc);
+			}
+			const auto compiledTime = compiledTimer.Mark() / repeats;
+			Logger::WriteMessage(std::format("Layout style resolution (8 graphs, 20 readouts): merged sheets {:.3f}ms, "
+				"compiled tables {:.3f}ms ({:.1f}x)\n", legacyTime * 1000., compiledTime * 1000., legacyTime / compiledTime).c_str());
+			Assert::AreEqual(legacySum, compiledSum);
+		}
 
 		// test precedence of target element matching sheets
 		// test enum resolution
@@ -0,0 +1,207 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Core/source/win/WinAPI.h>
+#include <PresentMonService/SyntheticPresentGenerator.h>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace ServiceTests
+{
+	constexpr uint64_t qpcFrequency = 10'000'000;
+	constexpr uint64_t startQpc = 1'000'000;
+
+	// collects what a generator produces over a number of Generate() calls at speed 0
+	struct GeneratedEvents
+	{
+		std::vector<ProcessEvent> processEvents;
+		std::vector<std::shared_ptr<PresentEvent>> presentEvents;
+
+		GeneratedEvents(SyntheticPresentGenerator& generator, int batchCount)
+		{
+			for (int b = 0; b < batchCount; b++) {
+				generator.Generate(startQpc + b, &processEvents, &presentEvents);
+			}
+		}
+	};
+
+	SyntheticPresentGenerator::Params MakeParams()
+	{
+		SyntheticPresentGenerator::Params params;
+		params.firstProcessId = 100;
+		params.speed = 0.;
+		params.seed = 1;
+		return params;
+	}
+
+	TEST_CLASS(TestSyntheticPresentGenerator)
+	{
+	public:
+		TEST_METHOD(DropRatio)
+		{
+			auto params = MakeParams();
+			params.swapChainCount = 2;
+			params.dropRatio = 0.25;
+			SyntheticPresentGenerator generator{ params, startQpc, qpcFrequency };
+			GeneratedEvents events{ generator, 10 };
+			Assert::AreEqual(10 * SyntheticPresentGenerator::kMaxBatchSize, events.presentEvents.size());
+
+			size_t dropped = 0;
+			for (auto& pPresent : events.presentEvents) {
+				if (pPresent->FinalState == PresentResult::Discarded) {
+					Assert::IsTrue(pPresent->Displayed.empty());
+					dropped++;
+				}
+				else {
+					Assert::IsTrue(pPresent->FinalState == PresentResult::Presented);
+					Assert::AreEqual(size_t(1), pPresent->Displayed.size());
+				}
+			}
+			const auto ratio = double(dropped) / double(events.presentEvents.size());
+			Assert::IsTrue(ratio > 0.24 && ratio < 0.26);
+		}
+		TEST_METHOD(InitialProcessesStart)
+		{
+			auto params = MakeParams();
+			params.processCount = 4;
+			SyntheticPresentGenerator generator{ params, startQpc, qpcFrequency };
+			GeneratedEvents events{ generator, 2 };
+
+			// the tracked process already exists, the others start with the trace
+			Assert::AreEqual(size_t(3), events.processEvents.size());
+			for (uint32_t i = 0; i < 3; i++) {
+				auto& e = events.processEvents[i];
+				Assert::IsTrue(e.IsStartEvent);
+				Assert::AreEqual(101u + i, e.ProcessId);
+				Assert::AreEqual(startQpc, e.QpcTime);
+				Assert::IsFalse(e.ImageFileName.empty());
+			}
+			std::set<uint32_t> presenting;
+			for (auto& pPresent : events.presentEvents) {
+				presenting.insert(pPresent->ProcessId);
+			}
+			Assert::IsTrue(presenting == std::set<uint32_t>{ 100, 101, 102, 103 });
+		}
+		TEST_METHOD(ChurnStartStop)
+		{
+			auto params = MakeParams();
+			params.processCount = 4;
+			params.processLifetimeSeconds = 0.05;
+			SyntheticPresentGenerator generator{ params, startQpc, qpcFrequency };
+			GeneratedEvents events{ generator, 20 };
+
+			// lifetime of every process that ever presented: [start, stop)
+			struct Lifetime { uint64_t start; uint64_t stop = UINT64_MAX; };
+			std::map<uint32_t, Lifetime> lifetimes{ { params.firstProcessId, { 0 } } };
+			size_t stopCount = 0;
+			for (auto& e : events.processEvents) {
+				if (e.IsStartEvent) {
+					Assert::IsTrue(lifetimes.emplace(e.ProcessId, Lifetime{ e.QpcTime }).second);
+				}
+				else {
+					auto i = lifetimes.find(e.ProcessId);
+					Assert::IsTrue(i != lifetimes.end());
+					Assert::AreEqual(UINT64_MAX, i->second.stop);
+					Assert::IsTrue(i->second.start < e.QpcTime);
+					i->second.stop = e.QpcTime;
+					stopCount++;
+				}
+			}
+			Assert::AreEqual(UINT64_MAX, lifetimes[params.firstProcessId].stop);
+			// each exit is replaced by a new process
+			Assert::AreEqual(stopCount + 3, events.processEvents.size() - stopCount);
+			// 200k presents from 4 processes at 1000 fps is 50s, processes live 50ms
+			Assert::IsTrue(stopCount > 2000);
+
+			for (auto& pPresent : events.presentEvents) {
+				auto i = lifetimes.find(pPresent->ProcessId);
+				Assert::IsTrue(i != lifetimes.end());
+				Assert::IsTrue(i->second.start <= pPresent->PresentStartTime);
+				Assert::IsTrue(pPresent->PresentStartTime < i->second.stop);
+			}
+		}
+		TEST_METHOD(TimestampOrder)
+		{
+			auto params = MakeParams();
+			params.processCount = 3;
+			params.swapChainCount = 3;
+			params.jitter = 0.5;
+			params.dropRatio = 0.1;
+			params.processLifetimeSeconds = 0.1;
+			SyntheticPresentGenerator generator{ params, startQpc, qpcFrequency };
+			GeneratedEvents events{ generator, 10 };
+
+			for (size_t i = 1; i < events.presentEvents.size(); i++) {
+				Assert::IsTrue(events.presentEvents[i - 1]->PresentStartTime <= events.presentEvents[i]->PresentStartTime);
+			}
+			for (size_t i = 1; i < events.processEvents.size(); i++) {
+				Assert::IsTrue(events.processEvents[i - 1].QpcTime <= events.processEvents[i].QpcTime);
+			}
+			// screen times of each swap chain increase even though jitter lets presents bunch up
+			std::map<uint64_t, uint64_t> lastScreenQpc;
+			for (auto& pPresent : events.presentEvents) {
+				if (pPresent->Displayed.empty()) {
+					continue;
+				}
+				auto& last = lastScreenQpc[pPresent->SwapChainAddress];
+				Assert::IsTrue(last < pPresent->Displayed[0].second);
+				Assert::IsTrue(pPresent->PresentStartTime < pPresent->Displayed[0].second);
+				last = pPresent->Displayed[0].second;
+			}
+			Assert::AreEqual(size_t(9), lastScreenQpc.size());
+		}
+	};
+
+	TEST_CLASS(TestSyntheticLoadStats)
+	{
+	public:
+		TEST_METHOD(P99)
+		{
+			SyntheticLoadStats stats{ 0, qpcFrequency, 1. };
+			// 0 through 9.999ms in 1us steps
+			for (uint64_t i = 0; i < 10'000; i++) {
+				stats.Add(0, i * qpcFrequency / 1'000'000);
+			}
+			Assert::IsFalse(stats.Summarize(qpcFrequency / 2).has_value());
+			auto summary = stats.Summarize(qpcFrequency);
+			Assert::IsTrue(summary.has_value());
+			Assert::AreEqual(uint64_t(10'000), summary->count);
+			Assert::AreEqual(1., summary->seconds, 1e-9);
+			Assert::AreEqual(4.9995, summary->avgMs, 1e-6);
+			Assert::AreEqual(9.999, summary->maxMs, 1e-6);
+			// the 9901st latency is 9.9ms, reported as the top of its bucket
+			Assert::IsTrue(summary->p99Ms > 9.9 - 1e-6 && summary->p99Ms < 9.9 + SyntheticLoadStats::kBucketMs + 1e-6);
+		}
+		TEST_METHOD(P99BeyondLastBucket)
+		{
+			SyntheticLoadStats stats{ 0, qpcFrequency, 1. };
+			const auto lastBucketMs = SyntheticLoadStats::kBucketMs * SyntheticLoadStats::kBucketCount;
+			// the top 2% of the latencies are past the histogram, so the p99 is the max
+			for (uint64_t i = 0; i < 98; i++) {
+				stats.Add(0, qpcFrequency / 1000);
+			}
+			stats.Add(0, uint64_t(lastBucketMs * 2 * qpcFrequency / 1000));
+			stats.Add(0, uint64_t(lastBucketMs * 3 * qpcFrequency / 1000));
+			auto summary = stats.Summarize(qpcFrequency);
+			Assert::IsTrue(summary.has_value());
+			Assert::AreEqual(lastBucketMs * 3, summary->maxMs, 1e-6);
+			Assert::AreEqual(summary->maxMs, summary->p99Ms);
+		}
+		TEST_METHOD(PeriodsAreIndependent)
+		{
+			SyntheticLoadStats stats{ 0, qpcFrequency, 1. };
+			stats.Add(0, qpcFrequency);
+			Assert::AreEqual(1000., stats.Summarize(qpcFrequency)->maxMs, 1e-6);
+			stats.Add(0, qpcFrequency / 1000);
+			auto summary = stats.Summarize(2 * qpcFrequency);
+			Assert::AreEqual(uint64_t(1), summary->count);
+			Assert::AreEqual(1., summary->maxMs, 1e-6);
+			Assert::AreEqual(1., summary->avgMs, 1e-6);
+			Assert::IsTrue(stats.Summarize(3 * qpcFrequency)->count == 0);
+		}
+	};
+}
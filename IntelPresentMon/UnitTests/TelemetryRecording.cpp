@@ -0,0 +1,167 @@
+// Copyright (C) 2022 Intel Corporation
+// SPDX-License-Identifier: MIT
+#include <Core/source/win/WinAPI.h>
+#include <ControlLib/TelemetryRecording.h>
+#include <ControlLib/PresentMonPowerTelemetry.h>
+#include <ControlLib/CpuTelemetryInfo.h>
+#include <filesystem>
+#include <cstring>
+#include <vector>
+
+#include <CppUnitTest.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace UtilityTests
+{
+	using namespace pwr;
+	using namespace pwr::rec;
+
+	TEST_CLASS(TestTelemetryRecording)
+	{
+	public:
+		TEST_METHOD_INITIALIZE(Setup)
+		{
+			dir_ = std::filesystem::temp_directory_path() / "pm-telemetry-recording-test";
+			std::filesystem::remove_all(dir_);
+			std::filesystem::create_directories(dir_);
+		}
+		TEST_METHOD_CLEANUP(Cleanup)
+		{
+			std::filesystem::remove_all(dir_);
+		}
+		TEST_METHOD(RoundTrip)
+		{
+			const auto path = dir_ / MakeRecordingFileName(DeviceKind::Gpu, PM_DEVICE_VENDOR_INTEL, 0);
+			std::vector<PresentMonPowerTelemetryInfo> written;
+			{
+				RecordWriter writer{ path, DeviceInfo{ .vendor = PM_DEVICE_VENDOR_INTEL, .name = "Test GPU",
+					.dedicatedVideoMemory = 8ull << 30, .sustainedPowerLimit = 225. }, sizeof(PresentMonPowerTelemetryInfo) };
+				std::bitset<size_t(GpuTelemetryCapBits::gpu_telemetry_count)> caps;
+				caps.set(size_t(GpuTelemetryCapBits::gpu_power));
+				writer.WriteCaps(BitsetToWords(caps));
+				for (int i = 0; i < 1000; i++) {
+					PresentMonPowerTelemetryInfo info{};
+					info.qpc = 1'000'000ull + i * 10'000ull;
+					info.gpu_power_w = 100. + (i % 7);
+					info.gpu_temperature_c = 60.;
+					written.push_back(info);
+					writer.WriteSample(std::as_bytes(std::span{ &info, 1 }));
+				}
+			}
+			// mostly unchanging samples should encode far smaller than the raw structs
+			Assert::IsTrue(std::filesystem::file_size(path) < written.size() * sizeof(PresentMonPowerTelemetryInfo) / 10);
+			const auto rec = LoadRecording<PresentMonPowerTelemetryInfo>(path);
+			Assert::AreEqual(std::string{ "Test GPU" }, rec.info.name);
+			Assert::AreEqual(8ull << 30, rec.info.dedicatedVideoMemory);
+			Assert::AreEqual(225., rec.info.sustainedPowerLimit);
+			Assert::IsTrue(WordsToBitset<size_t(GpuTelemetryCapBits::gpu_telemetry_count)>(rec.capWords)
+				.test(size_t(GpuTelemetryCapBits::gpu_power)));
+			Assert::AreEqual(written.size(), rec.samples.size());
+			for (size_t i = 0; i < written.size(); i++) {
+				Assert::AreEqual(0, std::memcmp(&written[i], &rec.samples[i], sizeof(PresentMonPowerTelemetryInfo)));
+			}
+			// found when searching for this vendor only
+			Assert::AreEqual(size_t(1), FindRecordings(dir_, DeviceKind::Gpu, PM_DEVICE_VENDOR_INTEL).size());
+			Assert::AreEqual(size_t(0), FindRecordings(dir_, DeviceKind::Gpu, PM_DEVICE_VENDOR_NVIDIA).size());
+		}
+		TEST_METHOD(TruncatedRecording)
+		{
+			const auto path = dir_ / "truncated.pmtr";
+			{
+				RecordWriter writer{ path, DeviceInfo{ .kind = DeviceKind::Cpu, .name = "Test CPU" }, sizeof(CpuTelemetryInfo) };
+				for (int i = 0; i < 10; i++) {
+					CpuTelemetryInfo info{};
+					info.qpc = 1000ull + i;
+					info.cpu_utilization = double(i);
+					writer.WriteSample(std::as_bytes(std::span{ &info, 1 }));
+				}
+			}
+			// chop off part of the last record, as when the service is killed mid-write
+			std::filesystem::resize_file(path, std::filesystem::file_size(path) - 2);
+			const auto rec = LoadRecording<CpuTelemetryInfo>(path);
+			Assert::AreEqual(size_t(9), rec.samples.size());
+			Assert::AreEqual(8., rec.samples.back().cpu_utilization);
+			// sample layout mismatch is rejected
+			Assert::ExpectException<TelementryException>([&] { LoadRecording<PresentMonPowerTelemetryInfo>(path); });
+		}
+		TEST_METHOD(ReopenAppendsToRecording)
+		{
+			const auto path = dir_ / MakeRecordingFileName(DeviceKind::Cpu, PM_DEVICE_VENDOR_UNKNOWN, 0);
+			const DeviceInfo info{ .kind = DeviceKind::Cpu, .name = "Test CPU" };
+			const auto write = [&](int first, int count) {
+				// a new writer per call, as when telemetry is repopulated after a device reset
+				RecordWriter writer{ path, info, sizeof(CpuTelemetryInfo) };
+				for (int i = first; i < first + count; i++) {
+					CpuTelemetryInfo sample{};
+					sample.qpc = 1000ull + i;
+					sample.cpu_utilization = double(i % 3);
+					writer.WriteSample(std::as_bytes(std::span{ &sample, 1 }));
+				}
+			};
+			write(0, 10);
+			write(10, 5);
+			// a partial record from a killed service is dropped before appending
+			std::filesystem::resize_file(path, std::filesystem::file_size(path) - 2);
+			write(15, 5);
+			const auto rec = LoadRecording<CpuTelemetryInfo>(path);
+			Assert::AreEqual(size_t(19), rec.samples.size());
+			for (size_t i = 0; i < rec.samples.size(); i++) {
+				// sample 14 was the one cut short
+				const auto expected = i < 14 ? i : i + 1;
+				Assert::AreEqual(1000ull + expected, rec.samples[i].qpc);
+				Assert::AreEqual(double(expected % 3), rec.samples[i].cpu_utilization);
+			}
+		}
+		TEST_METHOD(ReopenForOtherDeviceRotates)
+		{
+			const auto path = dir_ / MakeRecordingFileName(DeviceKind::Cpu, PM_DEVICE_VENDOR_UNKNOWN, 0);
+			CpuTelemetryInfo sample{};
+			{
+				RecordWriter writer{ path, DeviceInfo{ .kind = DeviceKind::Cpu, .name = "Old CPU" }, sizeof(CpuTelemetryInfo) };
+				writer.WriteSample(std::as_bytes(std::span{ &sample, 1 }));
+			}
+			{
+				RecordWriter writer{ path, DeviceInfo{ .kind = DeviceKind::Cpu, .name = "New CPU" }, sizeof(CpuTelemetryInfo) };
+				writer.WriteSample(std::as_bytes(std::span{ &sample, 1 }));
+				writer.WriteSample(std::as_bytes(std::span{ &sample, 1 }));
+			}
+			auto rotated = path;
+			rotated += ".1";
+			Assert::AreEqual(std::string{ "Old CPU" }, LoadRecording<CpuTelemetryInfo>(rotated).info.name);
+			const auto rec = LoadRecording<CpuTelemetryInfo>(path);
+			Assert::AreEqual(std::string{ "New CPU" }, rec.info.name);
+			Assert::AreEqual(size_t(2), rec.samples.size());
+			// the rotated file is kept but not picked up for replay
+			Assert::AreEqual(size_t(1), FindRecordings(dir_, DeviceKind::Cpu).size());
+		}
+		TEST_METHOD(ReplayLoopsAndAccelerates)
+		{
+			// 4 samples at 10 tick spacing on a 1000Hz recording clock => 40ms loop
+			std::vector<CpuTelemetryInfo> samples(4);
+			for (size_t i = 0; i < samples.size(); i++) {
+				samples[i].qpc = 500 + i * 10;
+				samples[i].cpu_utilization = double(i);
+			}
+			// local clock at 1000Hz replayed at 2x
+			ReplayCursor<CpuTelemetryInfo> cursor{ samples, 1000, 1000, 2. };
+			std::vector<CpuTelemetryInfo> out;
+			const auto push = [&](const CpuTelemetryInfo& s) { out.push_back(s); };
+			Assert::AreEqual(size_t(1), cursor.Advance(10'000, push));
+			Assert::AreEqual(uint64_t(10'000), out.back().qpc);
+			// 16ms local = 32ms recorded
+			Assert::AreEqual(size_t(3), cursor.Advance(10'016, push));
+			Assert::AreEqual(3., out.back().cpu_utilization);
+			// restamped at 30ms recorded = 15ms local (allowing for rounding)
+			Assert::IsTrue(out.back().qpc >= 10'014 && out.back().qpc <= 10'015);
+			// wraps into the second loop at 40ms recorded
+			Assert::AreEqual(size_t(1), cursor.Advance(10'021, push));
+			Assert::AreEqual(0., out.back().cpu_utilization);
+			Assert::IsTrue(out.back().qpc >= 10'019 && out.back().qpc <= 10'020);
+			// falling many loops behind skips ahead rather than flooding
+			Assert::IsTrue(cursor.Advance(20'000, push) <= samples.size());
+		}
+	private:
+		std::filesystem::path dir_;
+	};
+}
@@ -8,7 +8,7 @@ namespace pmon::bid
 	{
 		PM_VERSION ver{
 			.major = 3,
-			.minor = 0,
+			.minor = 1,
 			.patch = 0,
 			.tag = "",
 		};
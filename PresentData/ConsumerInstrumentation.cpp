@@ -0,0 +1,98 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "ConsumerInstrumentation.hpp"
+
+char const* GetInstrumentedHandlerName(InstrumentedHandler handler)
+{
+    switch (handler) {
+    case InstrumentedHandler::ProcessEvent:              return "ProcessEvent";
+    case InstrumentedHandler::DXGIEvent:                 return "DXGIEvent";
+    case InstrumentedHandler::D3D9Event:                 return "D3D9Event";
+    case InstrumentedHandler::DXGKEvent:                 return "DXGKEvent";
+    case InstrumentedHandler::Win32kEvent:               return "Win32kEvent";
+    case InstrumentedHandler::DWMEvent:                  return "DWMEvent";
+    case InstrumentedHandler::MetadataEvent:             return "MetadataEvent";
+    case InstrumentedHandler::IntelPresentMonEvent:      return "IntelPresentMonEvent";
+    case InstrumentedHandler::Win7DxgkBlt:               return "Win7DxgkBlt";
+    case InstrumentedHandler::Win7DxgkFlip:              return "Win7DxgkFlip";
+    case InstrumentedHandler::Win7DxgkPresentHistory:    return "Win7DxgkPresentHistory";
+    case InstrumentedHandler::Win7DxgkQueuePacket:       return "Win7DxgkQueuePacket";
+    case InstrumentedHandler::Win7DxgkVSyncDPC:          return "Win7DxgkVSyncDPC";
+    case InstrumentedHandler::Win7DxgkMMIOFlip:          return "Win7DxgkMMIOFlip";
+    case InstrumentedHandler::GpuRegisterDevice:         return "Gpu.RegisterDevice";
+    case InstrumentedHandler::GpuUnregisterDevice:       return "Gpu.UnregisterDevice";
+    case InstrumentedHandler::GpuRegisterContext:        return "Gpu.RegisterContext";
+    case InstrumentedHandler::GpuRegisterHwQueueContext: return "Gpu.RegisterHwQueueContext";
+    case InstrumentedHandler::GpuUnregisterContext:      return "Gpu.UnregisterContext";
+    case InstrumentedHandler::GpuSetEngineType:          return "Gpu.SetEngineType";
+    case InstrumentedHandler::GpuEnqueueQueuePacket:     return "Gpu.EnqueueQueuePacket";
+    case InstrumentedHandler::GpuCompleteQueuePacket:    return "Gpu.CompleteQueuePacket";
+    case InstrumentedHandler::GpuEnqueueDmaPacket:       return "Gpu.EnqueueDmaPacket";
+    case InstrumentedHandler::GpuCompleteDmaPacket:      return "Gpu.CompleteDmaPacket";
+    case InstrumentedHandler::GpuCompleteFrame:          return "Gpu.CompleteFrame";
+    case InstrumentedHandler::Count:                     break;
+    }
+    return "Unknown";
+}
+
+char const* GetInstrumentedContainerName(InstrumentedContainer container)
+{
+    switch (container) {
+    case InstrumentedContainer::TrackedPresents:                      return "TrackedPresents";
+    case InstrumentedContainer::PresentByThreadId:                    return "PresentByThreadId";
+    case InstrumentedContainer::OrderedPresentsByProcessId:           return "OrderedPresentsByProcessId";
+    case InstrumentedContainer::OrderedPresentsBySwapChain:           return "OrderedPresentsBySwapChain";
+    case InstrumentedContainer::PresentBySubmitSequence:              return "PresentBySubmitSequence";
+    case InstrumentedContainer::PresentByWin32KPresentHistoryToken:   return "PresentByWin32KPresentHistoryToken";
+    case InstrumentedContainer::PresentByDxgkPresentHistoryToken:     return "PresentByDxgkPresentHistoryToken";
+    case InstrumentedContainer::PresentByDxgkPresentHistoryTokenData: return "PresentByDxgkPresentHistoryTokenData";
+    case InstrumentedContainer::PresentByDxgkContext:                 return "PresentByDxgkContext";
+    case InstrumentedContainer::PresentByVidPnLayerId:                return "PresentByVidPnLayerId";
+    case InstrumentedContainer::LastPresentByWindow:                  return "LastPresentByWindow";
+    case InstrumentedContainer::PresentsWaitingForDWM:                return "PresentsWaitingForDWM";
+    case InstrumentedContainer::GpuDevices:                           return "Gpu.Devices";
+    case InstrumentedContainer::GpuContexts:                          return "Gpu.Contexts";
+    case InstrumentedContainer::GpuProcessFrameInfo:                  return "Gpu.ProcessFrameInfo";
+    case InstrumentedContainer::GpuPagingSequenceIds:                 return "Gpu.PagingSequenceIds";
+    case InstrumentedContainer::Count:                                break;
+    }
+    return "Unknown";
+}
+
+char const* GetPresentLostReasonName(PresentLostReason reason)
+{
+    switch (reason) {
+    case PresentLostReason::Superseded:      return "Superseded";
+    case PresentLostReason::TokenReused:     return "TokenReused";
+    case PresentLostReason::Unsupported:     return "Unsupported";
+    case PresentLostReason::StartupDiscard:  return "StartupDiscard";
+    case PresentLostReason::RingOverflow:    return "RingOverflow";
+    case PresentLostReason::DependentLost:   return "DependentLost";
+    case PresentLostReason::DeferralTimeout: return "DeferralTimeout";
+    case PresentLostReason::Count:           break;
+    }
+    return "Unknown";
+}
+
+#if PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION
+
+void ConsumerInstrumentation::GetSnapshot(ConsumerInstrumentationSnapshot* snapshot) const
+{
+    for (size_t i = 0; i < (size_t) InstrumentedHandler::Count; ++i) {
+        snapshot->mHandlers[i].mEventCount  = mHandlers[i].mEventCount.load(std::memory_order_relaxed);
+        snapshot->mHandlers[i].mTotalCycles = mHandlers[i].mTotalCycles.load(std::memory_order_relaxed);
+        snapshot->mHandlers[i].mMaxCycles   = mHandlers[i].mMaxCycles.load(std::memory_order_relaxed);
+    }
+    for (size_t i = 0; i < (size_t) InstrumentedContainer::Count; ++i) {
+        snapshot->mContainerSizes[i] = mContainerSizes[i].load(std::memory_order_relaxed);
+    }
+    snapshot->mPresentsCreated = mPresentsCreated.load(std::memory_order_relaxed);
+    snapshot->mPresentsCompleted = mPresentsCompleted.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < (size_t) PresentLostReason::Count; ++i) {
+        snapshot->mPresentsLost[i] = mPresentsLost[i].load(std::memory_order_relaxed);
+    }
+    snapshot->mPresentsDroppedOnOverflow = mPresentsDroppedOnOverflow.load(std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,212 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+// Optional hot-path instrumentation of PMTraceConsumer and GpuTrace, used to find out which
+// provider or handler is costly when a capture falls behind.
+//
+// When PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION is 0 (the default) the Instrument...() macros
+// below expand to nothing and PMTraceConsumer has no instrumentation members, so there is no
+// overhead.  When it is 1, PMTraceConsumer records per-handler event counts and cumulative/max
+// cost, sampled container sizes, and present lifecycle counters.  Costs are measured in CPU
+// timestamp-counter cycles (QPC ticks on ARM) and are inclusive, so the cost of the GpuTrace
+// calls made from HandleDXGKEvent() is also included in the DXGKEvent handler.
+//
+// Counters are only written by the consumer thread; use
+// PMTraceConsumer::GetInstrumentationSnapshot() to read them from any thread.
+
+#ifndef PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION
+#define PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION 0
+#endif
+
+enum class InstrumentedHandler : uint32_t {
+    // PMTraceConsumer event handlers
+    ProcessEvent,
+    DXGIEvent,
+    D3D9Event,
+    DXGKEvent,
+    Win32kEvent,
+    DWMEvent,
+    MetadataEvent,
+    IntelPresentMonEvent,
+    Win7DxgkBlt,
+    Win7DxgkFlip,
+    Win7DxgkPresentHistory,
+    Win7DxgkQueuePacket,
+    Win7DxgkVSyncDPC,
+    Win7DxgkMMIOFlip,
+
+    // GpuTrace entry points
+    GpuRegisterDevice,
+    GpuUnregisterDevice,
+    GpuRegisterContext,
+    GpuRegisterHwQueueContext,
+    GpuUnregisterContext,
+    GpuSetEngineType,
+    GpuEnqueueQueuePacket,
+    GpuCompleteQueuePacket,
+    GpuEnqueueDmaPacket,
+    GpuCompleteDmaPacket,
+    GpuCompleteFrame,
+
+    Count
+};
+
+enum class InstrumentedContainer : uint32_t {
+    TrackedPresents,                    // In-progress presents (non-null entries of mTrackedPresents)
+    PresentByThreadId,
+    OrderedPresentsByProcessId,
+    OrderedPresentsBySwapChain,
+    PresentBySubmitSequence,
+    PresentByWin32KPresentHistoryToken,
+    PresentByDxgkPresentHistoryToken,
+    PresentByDxgkPresentHistoryTokenData,
+    PresentByDxgkContext,
+    PresentByVidPnLayerId,
+    LastPresentByWindow,
+    PresentsWaitingForDWM,
+    GpuDevices,
+    GpuContexts,
+    GpuProcessFrameInfo,
+    GpuPagingSequenceIds,
+
+    Count
+};
+
+// Why a present was considered lost.
+enum class PresentLostReason : uint32_t {
+    Superseded,             // Its thread moved on to a new present (e.g., a stage was seen a second time)
+    TokenReused,            // Its present history token was reused by another present
+    Unsupported,            // Present mode that is intentionally not tracked (e.g., composition atlas)
+    StartupDiscard,         // Created before the first completed present, when providers may not all be running
+    RingOverflow,           // Still in progress when mTrackedPresents wrapped around
+    DependentLost,          // A present it was dependent on (e.g., the DWM present) was lost
+    DeferralTimeout,        // Deferred waiting for PresentStop longer than mDeferralTimeLimit
+
+    Count
+};
+
+struct ConsumerInstrumentationSnapshot {
+    struct Handler {
+        uint64_t mEventCount;
+        uint64_t mTotalCycles;
+        uint64_t mMaxCycles;
+    };
+
+    Handler mHandlers[(size_t) InstrumentedHandler::Count];
+    uint64_t mContainerSizes[(size_t) InstrumentedContainer::Count];    // Sampled periodically by the consumer thread
+    uint64_t mPresentsCreated;
+    uint64_t mPresentsCompleted;                                        // Completed and not lost
+    uint64_t mPresentsLost[(size_t) PresentLostReason::Count];
+    uint64_t mPresentsDroppedOnOverflow;                                // Discarded because mCompletedPresents was full
+};
+
+char const* GetInstrumentedHandlerName(InstrumentedHandler handler);
+char const* GetInstrumentedContainerName(InstrumentedContainer container);
+char const* GetPresentLostReasonName(PresentLostReason reason);
+
+#if PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION
+
+#include <atomic>
+#include <type_traits>
+#include <windows.h>
+#include <intrin.h>
+
+inline uint64_t ReadInstrumentationCycles()
+{
+#if defined(_M_IX86) || defined(_M_X64)
+    return __rdtsc();
+#else
+    LARGE_INTEGER t;
+    QueryPerformanceCounter(&t);
+    return (uint64_t) t.QuadPart;
+#endif
+}
+
+struct ConsumerInstrumentation {
+    struct Handler {
+        std::atomic<uint64_t> mEventCount;
+        std::atomic<uint64_t> mTotalCycles;
+        std::atomic<uint64_t> mMaxCycles;
+    };
+
+    Handler mHandlers[(size_t) InstrumentedHandler::Count] = {};
+    std::atomic<uint64_t> mContainerSizes[(size_t) InstrumentedContainer::Count] = {};
+    std::atomic<uint64_t> mPresentsCreated = 0;
+    std::atomic<uint64_t> mPresentsCompleted = 0;
+    std::atomic<uint64_t> mPresentsLost[(size_t) PresentLostReason::Count] = {};
+    std::atomic<uint64_t> mPresentsDroppedOnOverflow = 0;
+
+    // There is a single writer (the consumer thread), so counters are updated with relaxed
+    // load/store pairs rather than locked read-modify-write operations.
+    static void Add(std::atomic<uint64_t>* counter, uint64_t value)
+    {
+        counter->store(counter->load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+    static void Set(std::atomic<uint64_t>* counter, uint64_t value)
+    {
+        counter->store(value, std::memory_order_relaxed);
+    }
+
+    // Returns true every kContainerSampleInterval events, when the container sizes should be sampled.
+    bool AddHandlerSample(InstrumentedHandler handler, uint64_t cycles)
+    {
+        auto h = &mHandlers[(size_t) handler];
+        auto eventCount = h->mEventCount.load(std::memory_order_relaxed) + 1;
+        Set(&h->mEventCount, eventCount);
+        Add(&h->mTotalCycles, cycles);
+        if (cycles > h->mMaxCycles.load(std::memory_order_relaxed)) {
+            Set(&h->mMaxCycles, cycles);
+        }
+        return (eventCount & (kContainerSampleInterval - 1)) == 0;
+    }
+
+    void GetSnapshot(ConsumerInstrumentationSnapshot* snapshot) const;
+
+    static constexpr uint64_t kContainerSampleInterval = 256;
+};
+
+// Times the enclosing scope and attributes it to a handler.  TConsumer is always PMTraceConsumer;
+// it is a template parameter only so this can be declared before PMTraceConsumer is defined.
+template<typename TConsumer>
+class InstrumentedScope {
+    TConsumer* mConsumer;
+    InstrumentedHandler mHandler;
+    uint64_t mStart;
+
+public:
+    InstrumentedScope(TConsumer* consumer, InstrumentedHandler handler)
+        : mConsumer(consumer)
+        , mHandler(handler)
+        , mStart(ReadInstrumentationCycles())
+    {
+    }
+    ~InstrumentedScope()
+    {
+        if (mConsumer->mInstrumentation.AddHandlerSample(mHandler, ReadInstrumentationCycles() - mStart)) {
+            mConsumer->SampleInstrumentedContainerSizes();
+        }
+    }
+    InstrumentedScope(InstrumentedScope const&) = delete;
+    InstrumentedScope& operator=(InstrumentedScope const&) = delete;
+};
+
+#define InstrumentHandler(consumer, handler) InstrumentedScope<std::remove_pointer_t<decltype(consumer)>> instrumentedScope_(consumer, InstrumentedHandler::handler)
+#define InstrumentPresentCreated(consumer) ConsumerInstrumentation::Add(&(consumer)->mInstrumentation.mPresentsCreated, 1)
+#define InstrumentPresentCompleted(consumer, present) ConsumerInstrumentation::Add(&(consumer)->mInstrumentation.mPresentsCompleted, (present)->IsLost ? 0 : 1)
+#define InstrumentPresentLost(consumer, reason) ConsumerInstrumentation::Add(&(consumer)->mInstrumentation.mPresentsLost[(size_t) PresentLostReason::reason], 1)
+#define InstrumentPresentDroppedOnOverflow(consumer) ConsumerInstrumentation::Add(&(consumer)->mInstrumentation.mPresentsDroppedOnOverflow, 1)
+
+#else
+
+// When PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION==0, all of the instrumentation should compile
+// away.
+#define InstrumentHandler(consumer, handler)
+#define InstrumentPresentCreated(consumer)
+#define InstrumentPresentCompleted(consumer, present)
+#define InstrumentPresentLost(consumer, reason)
+#define InstrumentPresentDroppedOnOverflow(consumer)
+
+#endif
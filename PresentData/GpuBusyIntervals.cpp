@@ -0,0 +1,49 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "GpuBusyIntervals.hpp"
+
+GpuBusyIntervalRing::GpuBusyIntervalRing(uint32_t capacity)
+    : mHead(0)
+    , mTail(0)
+    , mDroppedCount(0)
+{
+    uint64_t size = 1;
+    while (size < capacity) {
+        size *= 2;
+    }
+    mRing.resize(size);
+    mMask = size - 1;
+}
+
+uint32_t GpuBusyIntervalRing::RegisterEngine(uint64_t adapter, uint32_t nodeOrdinal)
+{
+    std::lock_guard<std::mutex> lock(mEngineMutex);
+    auto engineId = (uint32_t) mEngines.size();
+    mEngines.push_back({ adapter, nodeOrdinal, kUnknownEngineType });
+    return engineId;
+}
+
+void GpuBusyIntervalRing::SetEngineType(uint32_t engineId, uint32_t engineType)
+{
+    std::lock_guard<std::mutex> lock(mEngineMutex);
+    if (engineId < mEngines.size()) {
+        mEngines[engineId].mEngineType = engineType;
+    }
+}
+
+void GpuBusyIntervalRing::Dequeue(std::vector<GpuBusyInterval>* intervals)
+{
+    auto head = mHead.load(std::memory_order_relaxed);
+    auto tail = mTail.load(std::memory_order_acquire);
+    for (; head != tail; ++head) {
+        intervals->push_back(mRing[head & mMask]);
+    }
+    mHead.store(head, std::memory_order_release);
+}
+
+void GpuBusyIntervalRing::GetEngines(std::vector<GpuEngineInfo>* engines) const
+{
+    std::lock_guard<std::mutex> lock(mEngineMutex);
+    *engines = mEngines;
+}
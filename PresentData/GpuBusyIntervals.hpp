@@ -0,0 +1,77 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
+#include <vector>
+
+// GpuTrace reconstructs when each GPU node is busy, and with whose work, in order to compute each
+// frame's GPUBusy/VideoBusy.  If PMTraceConsumer::mGpuBusyIntervals is set, each interval during
+// which an engine runs at least one packet from a process is also written into a
+// GpuBusyIntervalRing so that per-engine utilization can be reported.  Packets that overlap on the
+// same engine (e.g., from several hardware queues) are merged, so the intervals reported for one
+// engine and process never overlap.
+//
+// The ring is preallocated, has a single producer (the consumer thread) and a single consumer
+// (e.g., an output thread), and drops new intervals when full.
+//
+// This header has no dependencies on the rest of PresentData so that it can be tested standalone.
+
+struct GpuBusyInterval {
+    uint64_t mStartTime;    // QPC when the engine started running the process' packets
+    uint64_t mEndTime;      // QPC when the last of those packets completed
+    uint32_t mProcessId;    // Process that submitted the packets
+    uint32_t mEngineId;     // Index into the engines returned by GpuBusyIntervalRing::GetEngines()
+};
+
+struct GpuEngineInfo {
+    uint64_t mAdapter;      // pDxgAdapter
+    uint32_t mNodeOrdinal;
+    uint32_t mEngineType;   // Microsoft_Windows_DxgKrnl::DXGK_ENGINE, or UINT32_MAX if unknown
+};
+
+class GpuBusyIntervalRing {
+public:
+    static constexpr uint32_t kUnknownEngineType = UINT32_MAX;
+
+    // capacity is rounded up to a power of two.
+    explicit GpuBusyIntervalRing(uint32_t capacity);
+
+    GpuBusyIntervalRing(GpuBusyIntervalRing const&) = delete;
+    GpuBusyIntervalRing& operator=(GpuBusyIntervalRing const&) = delete;
+
+    // Producer interface
+    uint32_t RegisterEngine(uint64_t adapter, uint32_t nodeOrdinal);
+    void SetEngineType(uint32_t engineId, uint32_t engineType);
+    void Push(uint64_t startTime, uint64_t endTime, uint32_t processId, uint32_t engineId)
+    {
+        auto tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHead.load(std::memory_order_acquire) == mRing.size()) {
+            mDroppedCount.store(mDroppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+
+        auto interval = &mRing[tail & mMask];
+        interval->mStartTime = startTime;
+        interval->mEndTime = endTime;
+        interval->mProcessId = processId;
+        interval->mEngineId = engineId;
+        mTail.store(tail + 1, std::memory_order_release);
+    }
+
+    // Consumer interface.  Dequeue() appends all available intervals to intervals.
+    void Dequeue(std::vector<GpuBusyInterval>* intervals);
+    void GetEngines(std::vector<GpuEngineInfo>* engines) const;
+    uint64_t GetDroppedCount() const { return mDroppedCount.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<GpuBusyInterval> mRing;
+    uint64_t mMask;
+    std::atomic<uint64_t> mHead;        // Written by the consumer
+    std::atomic<uint64_t> mTail;        // Written by the producer
+    std::atomic<uint64_t> mDroppedCount;
+
+    mutable std::mutex mEngineMutex;
+    std::vector<GpuEngineInfo> mEngines;
+};
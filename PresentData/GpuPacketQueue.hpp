@@ -0,0 +1,140 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+// GpuPacketQueue is the queue of packets enqueued to a GPU node, in submission order, used by
+// GpuTrace.
+//
+// The storage is a power-of-two ring so that indexing is a mask instead of a modulo.  It doubles
+// when full and is otherwise never reallocated while packets are flowing; the only shrink is back
+// to kMinCapacity once a queue that grew past kIdleShrinkCapacity drains completely (e.g., after
+// the burst of submissions seen when an application closes).
+//
+// While the sequence ids in the queue are strictly increasing, FindSequenceId() first checks the
+// slot where the id would be if they are also consecutive, which is the common case, so it is
+// O(1), and otherwise binary searches.  If the ids were ever not increasing for the packets
+// currently in the queue, an id may appear more than once, so it falls back to a linear search
+// for the first match.
+//
+// This header has no dependencies on the rest of PresentData so that it can be tested standalone.
+template<typename TPacketTrace>
+class GpuPacketQueue {
+public:
+    struct EnqueuedPacket {
+        TPacketTrace* mPacketTrace;     // Frame trace for this packet (nullptr for wait packets)
+        uint32_t mSequenceId;           // Sequence ID for this packet
+        bool mCompleted;                // Flag to signal that the packet completed out-of-order
+    };
+
+    static constexpr uint32_t kMinCapacity = 16;
+    static constexpr uint32_t kIdleShrinkCapacity = 1024;
+    static constexpr uint32_t kNotFound = UINT32_MAX;
+
+    uint32_t GetCount() const    { return mCount; }
+    uint32_t GetCapacity() const { return (uint32_t) mRing.size(); }
+    bool IsEmpty() const         { return mCount == 0; }
+
+    // i is the position from the front of the queue (the currently-running packet).
+    EnqueuedPacket& At(uint32_t i)             { return mRing[(mHead + i) & mMask]; }
+    EnqueuedPacket const& At(uint32_t i) const { return mRing[(mHead + i) & mMask]; }
+    EnqueuedPacket& Front()                    { return At(0); }
+    EnqueuedPacket const& Front() const        { return At(0); }
+
+    void PushBack(TPacketTrace* packetTrace, uint32_t sequenceId)
+    {
+        if (mCount == (uint32_t) mRing.size()) {
+            Grow();
+        }
+        if (mCount > 0 && sequenceId <= At(mCount - 1).mSequenceId) {
+            mOrdered = false;
+        }
+
+        auto entry = &At(mCount);
+        entry->mPacketTrace = packetTrace;
+        entry->mSequenceId = sequenceId;
+        entry->mCompleted = false;
+        mCount += 1;
+    }
+
+    void PopFront()
+    {
+        DropFront(1);
+    }
+
+    // Remove the first count packets.
+    void DropFront(uint32_t count)
+    {
+        mHead = (mHead + count) & mMask;
+        mCount -= count;
+        if (mCount == 0) {
+            mHead = 0;
+            mOrdered = true;
+            if (mRing.size() > kIdleShrinkCapacity) {
+                std::vector<EnqueuedPacket>(kMinCapacity).swap(mRing);
+                mMask = kMinCapacity - 1;
+            }
+        }
+    }
+
+    // Returns the position of the packet with sequenceId, searching all but the front packet, or
+    // kNotFound.
+    uint32_t FindSequenceId(uint32_t sequenceId) const
+    {
+        if (mCount < 2) {
+            return kNotFound;
+        }
+
+        if (mOrdered) {
+            uint32_t guess = sequenceId - Front().mSequenceId;
+            if (guess > 0 && guess < mCount && At(guess).mSequenceId == sequenceId) {
+                return guess;
+            }
+
+            uint32_t lo = 1;
+            uint32_t hi = mCount;
+            while (lo < hi) {
+                uint32_t mid = lo + (hi - lo) / 2;
+                auto midSequenceId = At(mid).mSequenceId;
+                if (midSequenceId == sequenceId) {
+                    return mid;
+                }
+                if (midSequenceId < sequenceId) {
+                    lo = mid + 1;
+                } else {
+                    hi = mid;
+                }
+            }
+            return kNotFound;
+        }
+
+        for (uint32_t i = 1; i < mCount; ++i) {
+            if (At(i).mSequenceId == sequenceId) {
+                return i;
+            }
+        }
+        return kNotFound;
+    }
+
+private:
+    void Grow()
+    {
+        uint32_t oldCapacity = (uint32_t) mRing.size();
+        uint32_t newCapacity = oldCapacity == 0 ? kMinCapacity : oldCapacity * 2;
+
+        std::vector<EnqueuedPacket> ring(newCapacity);
+        for (uint32_t i = 0; i < mCount; ++i) {
+            ring[i] = At(i);
+        }
+        mRing.swap(ring);
+        mHead = 0;
+        mMask = newCapacity - 1;
+    }
+
+    std::vector<EnqueuedPacket> mRing;
+    uint32_t mHead = 0;     // Index into mRing of the front packet
+    uint32_t mCount = 0;    // Number of enqueued packets
+    uint32_t mMask = 0;     // mRing.size() - 1
+    bool mOrdered = true;   // Whether the enqueued sequence ids are strictly increasing
+};
@@ -42,12 +42,11 @@ void GpuTrace::PrintRunningContexts() const
         auto const& context = pr.second;
         auto const& node = *context.mNode;
 
-        if (node.mQueueCount > 0) {
+        if (!node.mQueue.IsEmpty()) {
             wprintf(L"                             hContext=0x%llx [", hContext);
 
-            for (uint32_t i = 0; i < node.mQueueCount; ++i) {
-                auto queueIdx = (node.mQueueIndex + i) % (uint32_t) node.mQueue.size();
-                auto const& entry = node.mQueue[queueIdx];
+            for (uint32_t i = 0; i < node.mQueue.GetCount(); ++i) {
+                auto const& entry = node.mQueue.At(i);
 
                 if (i > 0) {
                     wprintf(L"\n                                                          ");
@@ -77,6 +76,8 @@ GpuTrace::GpuTrace(PMTraceConsumer* pmConsumer)
 
 void GpuTrace::RegisterDevice(uint64_t hDevice, uint64_t pDxgAdapter)
 {
+    InstrumentHandler(mPMConsumer, GpuRegisterDevice);
+
     // Sometimes there are duplicate start events
     DebugAssert(mDevices.find(hDevice) == mDevices.end() || mDevices.find(hDevice)->second == pDxgAdapter);
 
@@ -85,18 +86,21 @@ void GpuTrace::RegisterDevice(uint64_t hDevice, uint64_t pDxgAdapter)
 
 void GpuTrace::UnregisterDevice(uint64_t hDevice)
 {
+    InstrumentHandler(mPMConsumer, GpuUnregisterDevice);
+
     // Sometimes there are duplicate stop events so it's ok if it's already removed
     mDevices.erase(hDevice);
 }
 
 void GpuTrace::RegisterContext(uint64_t hContext, uint64_t hDevice, uint32_t nodeOrdinal, uint32_t processId)
 {
+    InstrumentHandler(mPMConsumer, GpuRegisterContext);
+
     auto deviceIter = mDevices.find(hDevice);
     if (deviceIter == mDevices.end()) {
         return;
     }
-    auto pDxgAdapter = deviceIter->second;
-    auto node = &mNodes[pDxgAdapter].emplace(nodeOrdinal, Node{}).first->second;
+    auto node = LookupOrCreateNode(deviceIter->second, nodeOrdinal);
 
     // Sometimes there are duplicate start events, make sure that they say the same thing
     DebugAssert(mContexts.find(hContext) == mContexts.end() || mContexts.find(hContext)->second.mNode == node);
@@ -130,6 +134,8 @@ void GpuTrace::RegisterContext(uint64_t hContext, uint64_t hDevice, uint32_t nod
 //     Context_Stop hContext=C
 void GpuTrace::RegisterHwQueueContext(uint64_t hContext, uint64_t parentDxgHwQueue)
 {
+    InstrumentHandler(mPMConsumer, GpuRegisterHwQueueContext);
+
     DebugAssert(mContexts.find(hContext)         != mContexts.end());
     DebugAssert(mContexts.find(parentDxgHwQueue) == mContexts.end());
 
@@ -152,11 +158,11 @@ void GpuTrace::RegisterHwQueueContext(uint64_t hContext, uint64_t parentDxgHwQue
     // If there are two HwQueues that map to the same engine, it's not clear
     // whether or not queue packets running at the same time are really running
     // simultaneous, but since we're counting any duration where at least one
-    // node is running it doesn't matter.
+    // node is running it doesn't matter.  For the same reason, the HwQueue's
+    // node reports busy intervals for the parent's engine (see EngineBusy).
 
     Node* node = new Node();
-    node->mQueueIndex = 0;
-    node->mQueueCount = 0;
+    node->mEngineId = parentContext->mNode->mEngineId;
     node->mIsVideo = parentContext->mNode->mIsVideo;
 
     auto hwQueueContext = &mContexts.emplace(parentDxgHwQueue, Context()).first->second;
@@ -169,6 +175,8 @@ void GpuTrace::RegisterHwQueueContext(uint64_t hContext, uint64_t parentDxgHwQue
 
 void GpuTrace::UnregisterContext(uint64_t hContext)
 {
+    InstrumentHandler(mPMConsumer, GpuUnregisterContext);
+
     // Sometimes there are duplicate stop events so it's ok if it's already
     // removed
     auto ii = mContexts.find(hContext);
@@ -182,6 +190,15 @@ void GpuTrace::UnregisterContext(uint64_t hContext)
                 auto const& context = ii->second;
                 if (context.mParentContext == hContext) {
                     DebugAssert(context.mIsHwQueue);
+
+                    // A packet still running on the HwQueue will never complete, so stop
+                    // counting it towards its engine's busy interval.
+                    if (mPMConsumer->mGpuBusyIntervals != nullptr &&
+                        !context.mNode->mQueue.IsEmpty() &&
+                        context.mNode->mQueue.Front().mPacketTrace != nullptr) {
+                        CompleteEngineBusy(context.mNode, context.mNode->mQueue.Front().mPacketTrace, 0);
+                    }
+
                     delete context.mNode;
                     ii = mContexts.erase(ii);
                 } else {
@@ -194,9 +211,15 @@ void GpuTrace::UnregisterContext(uint64_t hContext)
 
 void GpuTrace::SetEngineType(uint64_t pDxgAdapter, uint32_t nodeOrdinal, Microsoft_Windows_DxgKrnl::DXGK_ENGINE engineType)
 {
+    InstrumentHandler(mPMConsumer, GpuSetEngineType);
+
     // Node should already be created (DxgKrnl::Context_Start comes
     // first) but just to be sure...
-    auto node = &mNodes[pDxgAdapter].emplace(nodeOrdinal, Node{}).first->second;
+    auto node = LookupOrCreateNode(pDxgAdapter, nodeOrdinal);
+
+    if (mPMConsumer->mGpuBusyIntervals != nullptr) {
+        mPMConsumer->mGpuBusyIntervals->SetEngineType(node->mEngineId, (uint32_t) engineType);
+    }
 
     if (engineType == Microsoft_Windows_DxgKrnl::DXGK_ENGINE::VIDEO_DECODE ||
         engineType == Microsoft_Windows_DxgKrnl::DXGK_ENGINE::VIDEO_ENCODE ||
@@ -205,9 +228,24 @@ void GpuTrace::SetEngineType(uint64_t pDxgAdapter, uint32_t nodeOrdinal, Microso
     }
 }
 
+GpuTrace::Node* GpuTrace::LookupOrCreateNode(uint64_t pDxgAdapter, uint32_t nodeOrdinal)
+{
+    auto p = mNodes[pDxgAdapter].emplace(nodeOrdinal, Node{});
+    auto node = &p.first->second;
+    if (p.second) {
+        node->mEngineId = mPMConsumer->mGpuBusyIntervals == nullptr ? 0 : mPMConsumer->mGpuBusyIntervals->RegisterEngine(pDxgAdapter, nodeOrdinal);
+        node->mIsVideo = false;
+    }
+    return node;
+}
+
 void GpuTrace::SetContextProcessId(Context* context, uint32_t processId)
 {
     auto p = mProcessFrameInfo.emplace(processId, ProcessFrameInfo{});
+    if (p.second) {
+        p.first->second.mVideoEngines.mProcessId = processId;
+        p.first->second.mOtherEngines.mProcessId = processId;
+    }
 
     if (mPMConsumer->mTrackGPUVideo && context->mNode->mIsVideo) {
         context->mPacketTrace = &p.first->second.mVideoEngines;
@@ -247,6 +285,29 @@ void GpuTrace::CompletePacket(PacketTrace* packetTrace, uint64_t timestamp) cons
     packetTrace->mRunningPacketStartTime = 0;
 }
 
+void GpuTrace::StartEngineBusy(Node const* node, PacketTrace const* packetTrace, uint64_t timestamp)
+{
+    auto engineBusy = &mEngineBusy[((uint64_t) node->mEngineId << 32) | packetTrace->mProcessId];
+    engineBusy->mRunningPacketCount += 1;
+    if (engineBusy->mRunningPacketCount == 1) {
+        engineBusy->mStartTime = timestamp;
+    }
+}
+
+// A timestamp of 0 stops counting the packet without reporting the interval.
+void GpuTrace::CompleteEngineBusy(Node const* node, PacketTrace const* packetTrace, uint64_t timestamp)
+{
+    auto ii = mEngineBusy.find(((uint64_t) node->mEngineId << 32) | packetTrace->mProcessId);
+    if (ii == mEngineBusy.end() || ii->second.mRunningPacketCount == 0) {
+        return;
+    }
+
+    ii->second.mRunningPacketCount -= 1;
+    if (ii->second.mRunningPacketCount == 0 && timestamp > ii->second.mStartTime) {
+        mPMConsumer->mGpuBusyIntervals->Push(ii->second.mStartTime, timestamp, packetTrace->mProcessId, node->mEngineId);
+    }
+}
+
 void GpuTrace::EnqueueWork(Context* context, uint32_t sequenceId, uint64_t timestamp, bool isWaitPacket)
 {
     auto packetTrace = context->mPacketTrace;
@@ -262,19 +323,9 @@ void GpuTrace::EnqueueWork(Context* context, uint32_t sequenceId, uint64_t times
         return;
     }
 
-    // If the queue is too small, enlarge it by 16 entries at a time.  Typically, this will only be
-    // needed for the first packet observed on this node, which will result in sizing the queue from
-    // 0 to 16.  However, there are other cases where the queue entries can grow beyond that.  e.g.,
-    // this seems to always happen when an application closes.
-    uint32_t queueSize = (uint32_t) node->mQueue.size();
-    if (node->mQueueCount == queueSize) {
-        Node::EnqueuedPacket empty{};
-        node->mQueue.insert(node->mQueue.begin() + node->mQueueIndex, 16, empty);
-        queueSize += 16;
-        node->mQueueIndex = (node->mQueueIndex + 16) % queueSize;
-    }
-
-    // Enqueue the packet.
+    // Enqueue the packet.  The queue grows as needed; typically this will only be for the first
+    // packet observed on this node, but there are other cases where the queue can grow larger.
+    // e.g., this seems to always happen when an application closes.
     //
     // Wait packets aren't counted as GPU work, but we still need to enqueue
     // them so they block future work.  We encode wait packets by setting their
@@ -284,18 +335,16 @@ void GpuTrace::EnqueueWork(Context* context, uint32_t sequenceId, uint64_t times
         packetTrace = nullptr;
     }
 
-    auto queueIndex = (node->mQueueIndex + node->mQueueCount) % queueSize;
-    auto entry = &node->mQueue[queueIndex];
-    entry->mPacketTrace = packetTrace;
-    entry->mSequenceId = sequenceId;
-    entry->mCompleted = false;
-    node->mQueueCount += 1;
+    node->mQueue.PushBack(packetTrace, sequenceId);
 
     // If the queue was empty, the packet starts running right away, otherwise
     // it is just enqueued and will start running after all previous packets
     // complete.
-    if (packetTrace != nullptr && node->mQueueCount == 1) {
+    if (packetTrace != nullptr && node->mQueue.GetCount() == 1) {
         StartPacket(packetTrace, timestamp);
+        if (mPMConsumer->mGpuBusyIntervals != nullptr) {
+            StartEngineBusy(node, packetTrace, timestamp);
+        }
     }
 
     if (IsVerboseTraceEnabled()) {
@@ -322,11 +371,11 @@ bool GpuTrace::CompleteWork(Context* context, uint32_t sequenceId, uint64_t time
     // actual:   [-----]  [-----]  [-----]     [-----]-----]-------]
     //           ^     ^  x     ^  ^     ^        x  ^   ^
     //           s1    i1 s2    i2 s3    i3       s2 i1  s3
-    if (context->mPacketTrace == nullptr || node->mQueueCount == 0) {
+    if (context->mPacketTrace == nullptr || node->mQueue.IsEmpty()) {
         return false;
     }
 
-    auto runningSequenceId = node->mQueue[node->mQueueIndex].mSequenceId;
+    auto runningSequenceId = node->mQueue.Front().mSequenceId;
     if (sequenceId < runningSequenceId) {
         return false;
     }
@@ -353,56 +402,55 @@ bool GpuTrace::CompleteWork(Context* context, uint32_t sequenceId, uint64_t time
     //           ^     ^  ^     x  ^     ^        ^  ^     x
     //           s1    i1 s2    i2 s3    i3       s2 i1    i2
     if (sequenceId > runningSequenceId) {
-        for (uint32_t missingCount = 1; ; ++missingCount) {
-            if (missingCount == node->mQueueCount) {
-                return false;
-            }
-
-            uint32_t queueIndex = (node->mQueueIndex + missingCount) % (uint32_t) node->mQueue.size();
-            auto entry = &node->mQueue[queueIndex];
-            if (entry->mSequenceId == sequenceId) {
-
-                // On some 3000-series NVIDIA cards using hardware scheduling, we sometimes get
-                // QueuePacket_Stop events for monitored fence packets out of order (too early).
-                // This is NOT due to missed events, and any previous render packets should still be
-                // considered running/enqueued.  So, we flag these packets as completed so that it
-                // is immediately completed once it reaches the front of the queue.
-                if (entry->mPacketTrace == nullptr) {
-                    entry->mCompleted = true;
-                    return true;
-                }
+        auto missingCount = node->mQueue.FindSequenceId(sequenceId);
+        if (missingCount == GpuPacketQueue<PacketTrace>::kNotFound) {
+            return false;
+        }
 
-                // Otherwise, move current packet into this slot
-                *entry = node->mQueue[node->mQueueIndex];
-                node->mQueueIndex = queueIndex;
-                node->mQueueCount -= missingCount;
-                break;
-            }
+        // On some 3000-series NVIDIA cards using hardware scheduling, we sometimes get
+        // QueuePacket_Stop events for monitored fence packets out of order (too early).
+        // This is NOT due to missed events, and any previous render packets should still be
+        // considered running/enqueued.  So, we flag these packets as completed so that it
+        // is immediately completed once it reaches the front of the queue.
+        auto entry = &node->mQueue.At(missingCount);
+        if (entry->mPacketTrace == nullptr) {
+            entry->mCompleted = true;
+            return true;
         }
+
+        // Otherwise, move current packet into this slot
+        *entry = node->mQueue.Front();
+        node->mQueue.DropFront(missingCount);
     }
 
     // If this was the process' last executing packet, accumulate the execution
     // duration into the process' count.
-    auto entry = &node->mQueue[node->mQueueIndex];
+    auto entry = &node->mQueue.Front();
     if (entry->mPacketTrace != nullptr) {
         entry->mPacketTrace->mRunningPacketCount -= 1;
         if (entry->mPacketTrace->mRunningPacketCount == 0) {
             CompletePacket(entry->mPacketTrace, timestamp);
         }
+
+        // Report the engine's busy interval, if requested.
+        if (mPMConsumer->mGpuBusyIntervals != nullptr) {
+            CompleteEngineBusy(node, entry->mPacketTrace, timestamp);
+        }
     }
 
     // Pop the completed packet from the queue, and start the next one.
-    uint32_t queueSize = (uint32_t) node->mQueue.size();
     for (;;) {
-        node->mQueueIndex = (node->mQueueIndex + 1) % queueSize;
-        node->mQueueCount -= 1;
-        if (node->mQueueCount == 0) {
+        node->mQueue.PopFront();
+        if (node->mQueue.IsEmpty()) {
             break;
         }
 
-        entry = &node->mQueue[node->mQueueIndex];
+        entry = &node->mQueue.Front();
         if (entry->mPacketTrace != nullptr) {
             StartPacket(entry->mPacketTrace, timestamp);
+            if (mPMConsumer->mGpuBusyIntervals != nullptr) {
+                StartEngineBusy(node, entry->mPacketTrace, timestamp);
+            }
             break;
         }
 
@@ -411,26 +459,13 @@ bool GpuTrace::CompleteWork(Context* context, uint32_t sequenceId, uint64_t time
         }
     }
 
-    // Decrease queue storage in multiples of 16.
-    uint32_t N = (queueSize - node->mQueueCount) / 16;
-    if (N >= 2) {
-        N = (N - 1) * 16;
-        if (node->mQueueIndex >= N) {
-            node->mQueue.erase(node->mQueue.begin() + node->mQueueIndex - N, node->mQueue.begin() + node->mQueueIndex);
-            node->mQueueIndex -= N;
-        } else {
-            node->mQueue.erase(node->mQueue.begin() + queueSize - (N - node->mQueueIndex), node->mQueue.end());
-            node->mQueue.erase(node->mQueue.begin(), node->mQueue.begin() + node->mQueueIndex);
-            node->mQueueIndex = 0;
-        }
-        node->mQueue.shrink_to_fit();
-    }
-
     return true;
 }
 
 void GpuTrace::EnqueueQueuePacket(uint64_t hContext, uint32_t sequenceId, uint32_t processId, uint64_t timestamp, bool isWaitPacket)
 {
+    InstrumentHandler(mPMConsumer, GpuEnqueueQueuePacket);
+
     auto contextIter = mContexts.find(hContext);
     if (contextIter != mContexts.end()) {
         auto context = &contextIter->second;
@@ -452,6 +487,8 @@ void GpuTrace::EnqueueQueuePacket(uint64_t hContext, uint32_t sequenceId, uint32
 
 void GpuTrace::CompleteQueuePacket(uint64_t hContext, uint32_t sequenceId, uint64_t timestamp)
 {
+    InstrumentHandler(mPMConsumer, GpuCompleteQueuePacket);
+
     auto contextIter = mContexts.find(hContext);
     if (contextIter != mContexts.end()) {
         auto context = &contextIter->second;
@@ -471,6 +508,8 @@ void GpuTrace::CompleteQueuePacket(uint64_t hContext, uint32_t sequenceId, uint6
 
 void GpuTrace::EnqueueDmaPacket(uint64_t hContext, uint32_t sequenceId, uint64_t timestamp)
 {
+    InstrumentHandler(mPMConsumer, GpuEnqueueDmaPacket);
+
     // Lookup the context.  This can fail sometimes e.g. if parsing the
     // beginning of an ETL file where we can get packet events before the
     // context mapping.
@@ -490,6 +529,8 @@ void GpuTrace::EnqueueDmaPacket(uint64_t hContext, uint32_t sequenceId, uint64_t
 
 void GpuTrace::CompleteDmaPacket(uint64_t hContext, uint32_t sequenceId, uint64_t timestamp)
 {
+    InstrumentHandler(mPMConsumer, GpuCompleteDmaPacket);
+
     // Lookup the context.  This can fail sometimes e.g. if parsing the
     // beginning of an ETL file where we can get packet events before the
     // context mapping.
@@ -508,6 +549,8 @@ void GpuTrace::CompleteDmaPacket(uint64_t hContext, uint32_t sequenceId, uint64_
 
 void GpuTrace::CompleteFrame(PresentEvent* pEvent, uint64_t timestamp)
 {
+    InstrumentHandler(mPMConsumer, GpuCompleteFrame);
+
     // There are a few different events that can be used to complete the GPU
     // trace for each frame, e.g. QueuePacket_Stop for a present packet, or
     // MMIOFlipMultiPlaneOverlay_Info, and they can occur in any order so we
@@ -583,3 +626,13 @@ void GpuTrace::CompleteFrame(PresentEvent* pEvent, uint64_t timestamp)
         pEvent->ReadyTime = timestamp;
     }
 }
+
+#if PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION
+void GpuTrace::SampleInstrumentedContainerSizes(ConsumerInstrumentation* instrumentation) const
+{
+    ConsumerInstrumentation::Set(&instrumentation->mContainerSizes[(size_t) InstrumentedContainer::GpuDevices],           mDevices.size());
+    ConsumerInstrumentation::Set(&instrumentation->mContainerSizes[(size_t) InstrumentedContainer::GpuContexts],          mContexts.size());
+    ConsumerInstrumentation::Set(&instrumentation->mContainerSizes[(size_t) InstrumentedContainer::GpuProcessFrameInfo],  mProcessFrameInfo.size());
+    ConsumerInstrumentation::Set(&instrumentation->mContainerSizes[(size_t) InstrumentedContainer::GpuPagingSequenceIds], mPagingSequenceIds.size());
+}
+#endif
@@ -5,6 +5,8 @@
 #include <stdint.h>
 #include <unordered_map>
 
+#include "ConsumerInstrumentation.hpp"
+#include "GpuPacketQueue.hpp"
 #include "etw/Microsoft_Windows_DxgKrnl.h"
 
 struct PresentEvent;
@@ -18,6 +20,7 @@ class GpuTrace {
         uint64_t mAccumulatedPacketTime;   // QPC duration while at least one packet was running during the current frame
         uint64_t mRunningPacketStartTime;  // QPC when the oldest, currently-running packet started on any node
         uint32_t mRunningPacketCount;      // Number of currently-running packets on any node
+        uint32_t mProcessId;
     };
 
     // Node is information about a particular GPU parallel node, including any
@@ -25,17 +28,20 @@ class GpuTrace {
     // hardware scheduling enabled, there is one node per HWQueue many of which
     // may map to the same device engine.
     struct Node {
-        struct EnqueuedPacket {
-            PacketTrace* mPacketTrace;      // Frame trace for this packet
-            uint32_t mSequenceId;           // Sequence ID for this packet
-            bool mCompleted;                // Flag to signal that the packet completed out-of-order
-        };
-        std::vector<EnqueuedPacket> mQueue; // Ring buffer of current enqueued packets
-        uint32_t mQueueIndex;               // Index into mQueue for currently-running packet
-        uint32_t mQueueCount;               // Number of enqueued packets
+        GpuPacketQueue<PacketTrace> mQueue; // Currently enqueued packets; the front one is running
+        uint32_t mEngineId;                 // Engine id in PMTraceConsumer::mGpuBusyIntervals
         bool mIsVideo;
     };
 
+    // EngineBusy tracks when an engine is running any packet from a particular process, for
+    // PMTraceConsumer::mGpuBusyIntervals.  With hardware scheduling, several HwQueue nodes map to
+    // the same engine and their packets can overlap, so the interval is only reported once none of
+    // them is running a packet from the process.
+    struct EngineBusy {
+        uint64_t mStartTime;                // QPC when the first of the currently-running packets started
+        uint32_t mRunningPacketCount;       // Number of currently-running packets
+    };
+
     // Context is a process' gpu context, mapping a PacketTrace to a
     // particular Node.
     struct Context {
@@ -58,15 +64,20 @@ class GpuTrace {
     std::unordered_map<uint64_t, Context> mContexts;                            // hContext -> Context
     std::unordered_map<uint32_t, ProcessFrameInfo> mProcessFrameInfo;           // ProcessID -> ProcessFrameInfo
     std::unordered_map<uint64_t, uint32_t> mPagingSequenceIds;                  // SequenceID -> ProcessID
+    std::unordered_map<uint64_t, EngineBusy> mEngineBusy;                       // (EngineId, ProcessID) -> EngineBusy
 
     // The parent trace consumer
     PMTraceConsumer* mPMConsumer;
 
+    Node* LookupOrCreateNode(uint64_t pDxgAdapter, uint32_t nodeOrdinal);
     void SetContextProcessId(Context* context, uint32_t processId);
 
     void StartPacket(PacketTrace* packetTrace, uint64_t timestamp) const;
     void CompletePacket(PacketTrace* packetTrace, uint64_t timestamp) const;
 
+    void StartEngineBusy(Node const* node, PacketTrace const* packetTrace, uint64_t timestamp);
+    void CompleteEngineBusy(Node const* node, PacketTrace const* packetTrace, uint64_t timestamp);
+
     void EnqueueWork(Context* context, uint32_t sequenceId, uint64_t timestamp, bool isWaitPacket);
     bool CompleteWork(Context* context, uint32_t sequenceId, uint64_t timestamp);
 
@@ -92,4 +103,8 @@ public:
     void CompleteDmaPacket(uint64_t hContext, uint32_t sequenceId, uint64_t timestamp);
 
     void CompleteFrame(PresentEvent* pEvent, uint64_t timestamp);
+
+    #if PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION
+    void SampleInstrumentedContainerSizes(ConsumerInstrumentation* instrumentation) const;
+    #endif
 };
@@ -130,6 +130,8 @@ PresentEvent::PresentEvent()
     , QueueSubmitSequence(0)
     , RingIndex(UINT32_MAX)
 
+    , PrevPresentWaitingForDWM(nullptr)
+
     , DestWidth(0)
     , DestHeight(0)
     , DriverThreadId(0)
@@ -186,6 +188,8 @@ PresentEvent::PresentEvent(uint32_t fid)
     , QueueSubmitSequence(0)
     , RingIndex(UINT32_MAX)
 
+    , PrevPresentWaitingForDWM(nullptr)
+
     , DestWidth(0)
     , DestHeight(0)
     , DriverThreadId(0)
@@ -214,6 +218,60 @@ PresentEvent::PresentEvent(uint32_t fid)
 {
 }
 
+DwmWaitingList::~DwmWaitingList()
+{
+    while (mHead != nullptr) {
+        Remove(mHead.get());
+    }
+}
+
+void DwmWaitingList::PushBack(std::shared_ptr<PresentEvent> const& present)
+{
+    if (present->PresentInDwmWaitingStruct) {
+        return;
+    }
+
+    present->PresentInDwmWaitingStruct = true;
+    present->PrevPresentWaitingForDWM = mTail;
+    if (mTail == nullptr) {
+        mHead = present;
+    } else {
+        mTail->NextPresentWaitingForDWM = present;
+    }
+    mTail = present.get();
+    mSize += 1;
+}
+
+void DwmWaitingList::Remove(PresentEvent* present)
+{
+    DebugAssert(present->PresentInDwmWaitingStruct);
+
+    // Keep the next present alive while the link to it is moved.
+    auto next = std::move(present->NextPresentWaitingForDWM);
+    auto prev = present->PrevPresentWaitingForDWM;
+    if (next != nullptr) {
+        next->PrevPresentWaitingForDWM = prev;
+    } else {
+        mTail = prev;
+    }
+    present->PrevPresentWaitingForDWM = nullptr;
+    present->PresentInDwmWaitingStruct = false;
+    mSize -= 1;
+    if (prev != nullptr) {
+        prev->NextPresentWaitingForDWM = std::move(next); // May release present
+    } else {
+        mHead = std::move(next); // May release present
+    }
+}
+
+void DwmWaitingList::MoveTo(std::deque<std::shared_ptr<PresentEvent>>* presents)
+{
+    while (mHead != nullptr) {
+        presents->emplace_back(mHead);
+        Remove(mHead.get());
+    }
+}
+
 PMTraceConsumer::PMTraceConsumer()
     : mTrackedPresents(PRESENTEVENT_CIRCULAR_BUFFER_SIZE)
     , mCompletedPresents(PRESENTEVENT_CIRCULAR_BUFFER_SIZE)
@@ -231,6 +289,8 @@ PMTraceConsumer::~PMTraceConsumer()
 
 void PMTraceConsumer::HandleD3D9Event(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, D3D9Event);
+
     auto const& hdr = pEventRecord->EventHeader;
     switch (hdr.EventDescriptor.Id) {
     case Microsoft_Windows_D3D9::Present_Start::Id:
@@ -269,6 +329,8 @@ void PMTraceConsumer::HandleD3D9Event(EVENT_RECORD* pEventRecord)
 
 void PMTraceConsumer::HandleDXGIEvent(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, DXGIEvent);
+
     auto const& hdr = pEventRecord->EventHeader;
     switch (hdr.EventDescriptor.Id) {
     case Microsoft_Windows_DXGI::Present_Start::Id:
@@ -336,6 +398,7 @@ void PMTraceConsumer::HandleDxgkBlt(EVENT_HEADER const& hdr, uint64_t hwnd, bool
             break;
         }
 
+        InstrumentPresentLost(this, Superseded);
         RemoveLostPresent(presentEvent);
     }
 
@@ -380,6 +443,7 @@ std::shared_ptr<PresentEvent> PMTraceConsumer::HandleDxgkFlip(EVENT_HEADER const
 
             // If the in-progress present has seen DxgkPresent, it has lost tracking.
             if (presentEvent->SeenDxgkPresent) {
+                InstrumentPresentLost(this, Superseded);
                 RemoveLostPresent(presentEvent);
                 continue;
             }
@@ -388,6 +452,7 @@ std::shared_ptr<PresentEvent> PMTraceConsumer::HandleDxgkFlip(EVENT_HEADER const
             if (presentEvent->QueueSubmitSequence != 0 &&
                 presentEvent->TimeInPresent != 0 &&
                 presentEvent->Runtime != Runtime::Other) {
+                InstrumentPresentLost(this, Superseded);
                 RemoveLostPresent(presentEvent);
                 continue;
             }
@@ -432,10 +497,7 @@ std::shared_ptr<PresentEvent> PMTraceConsumer::HandleDxgkFlip(EVENT_HEADER const
     if (hdr.ThreadId == DwmPresentThreadId) {
         DebugAssert(presentEvent->DependentPresents.empty());
 
-        for (auto& p : mPresentsWaitingForDWM) {
-            p->PresentInDwmWaitingStruct = false;
-        }
-        std::swap(presentEvent->DependentPresents, mPresentsWaitingForDWM);
+        mPresentsWaitingForDWM.MoveTo(&presentEvent->DependentPresents);
     }
 
     return presentEvent;
@@ -664,6 +726,7 @@ void PMTraceConsumer::HandleDxgkPresentHistory(
             break;
         }
 
+        InstrumentPresentLost(this, Superseded);
         RemoveLostPresent(presentEvent);
     }
 
@@ -680,6 +743,7 @@ void PMTraceConsumer::HandleDxgkPresentHistory(
 
     auto iter = mPresentByDxgkPresentHistoryToken.find(token);
     if (iter != mPresentByDxgkPresentHistoryToken.end()) {
+        InstrumentPresentLost(this, TokenReused);
         RemoveLostPresent(iter->second);
     }
     DebugAssert(mPresentByDxgkPresentHistoryToken.find(token) == mPresentByDxgkPresentHistoryToken.end());
@@ -700,6 +764,7 @@ void PMTraceConsumer::HandleDxgkPresentHistory(
              * could not be diagnosed, so we removed support for this present mode for now...
             presentEvent->PresentMode = PresentMode::Composed_Composition_Atlas;
             */
+            InstrumentPresentLost(this, Unsupported);
             RemoveLostPresent(presentEvent);
             return;
             /* END WORKAROUND */
@@ -715,8 +780,7 @@ void PMTraceConsumer::HandleDxgkPresentHistory(
     case PresentMode::Composed_Copy_CPU_GDI:
         if (tokenData == 0) {
             // This is the best we can do, we won't be able to tell how many frames are actually displayed.
-            mPresentsWaitingForDWM.emplace_back(presentEvent);
-            presentEvent->PresentInDwmWaitingStruct = true;
+            mPresentsWaitingForDWM.PushBack(presentEvent);
         } else {
             DebugAssert(mPresentByDxgkPresentHistoryTokenData.find(tokenData) == mPresentByDxgkPresentHistoryTokenData.end());
             mPresentByDxgkPresentHistoryTokenData[tokenData] = presentEvent;
@@ -752,8 +816,7 @@ void PMTraceConsumer::HandleDxgkPresentHistoryInfo(EVENT_HEADER const& hdr, uint
     // Composed presents are currently ignored.
     if (//eventIter->second->PresentMode == PresentMode::Composed_Composition_Atlas ||
         (eventIter->second->PresentMode == PresentMode::Composed_Flip && !eventIter->second->SeenWin32KEvents)) {
-        mPresentsWaitingForDWM.emplace_back(eventIter->second);
-        eventIter->second->PresentInDwmWaitingStruct = true;
+        mPresentsWaitingForDWM.PushBack(eventIter->second);
     }
 
     if (eventIter->second->PresentMode == PresentMode::Composed_Copy_GPU_GDI) {
@@ -768,6 +831,8 @@ void PMTraceConsumer::HandleDxgkPresentHistoryInfo(EVENT_HEADER const& hdr, uint
 
 void PMTraceConsumer::HandleDXGKEvent(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, DXGKEvent);
+
     auto const& hdr = pEventRecord->EventHeader;
 
     if (hdr.EventDescriptor.Id == Microsoft_Windows_DxgKrnl::PresentHistory_Start::Id ||
@@ -850,7 +915,7 @@ void PMTraceConsumer::HandleDXGKEvent(EVENT_RECORD* pEventRecord)
                 p->WaitForMPOFlipEvent = true;
 
                 if (p->SwapChainAddress == 0) {
-                    p->SwapChainAddress = GenerateVidPnLayerId(VidPnSourceId, LayerIndex);
+                    SetSwapChainAddress(p, GenerateVidPnLayerId(VidPnSourceId, LayerIndex));
                 }
             }
             return;
@@ -1355,6 +1420,8 @@ void PMTraceConsumer::HandleDXGKEvent(EVENT_RECORD* pEventRecord)
 
 void PMTraceConsumer::HandleWin7DxgkBlt(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, Win7DxgkBlt);
+
     using namespace Microsoft_Windows_DxgKrnl::Win7;
 
     auto pBltEvent = reinterpret_cast<DXGKETW_BLTEVENT*>(pEventRecord->UserData);
@@ -1366,6 +1433,8 @@ void PMTraceConsumer::HandleWin7DxgkBlt(EVENT_RECORD* pEventRecord)
 
 void PMTraceConsumer::HandleWin7DxgkFlip(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, Win7DxgkFlip);
+
     using namespace Microsoft_Windows_DxgKrnl::Win7;
 
     auto pFlipEvent = reinterpret_cast<DXGKETW_FLIPEVENT*>(pEventRecord->UserData);
@@ -1383,6 +1452,8 @@ void PMTraceConsumer::HandleWin7DxgkFlip(EVENT_RECORD* pEventRecord)
 
 void PMTraceConsumer::HandleWin7DxgkPresentHistory(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, Win7DxgkPresentHistory);
+
     using namespace Microsoft_Windows_DxgKrnl::Win7;
 
     auto pPresentHistoryEvent = reinterpret_cast<DXGKETW_PRESENTHISTORYEVENT*>(pEventRecord->UserData);
@@ -1399,6 +1470,8 @@ void PMTraceConsumer::HandleWin7DxgkPresentHistory(EVENT_RECORD* pEventRecord)
 
 void PMTraceConsumer::HandleWin7DxgkQueuePacket(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, Win7DxgkQueuePacket);
+
     using namespace Microsoft_Windows_DxgKrnl::Win7;
 
     if (pEventRecord->EventHeader.EventDescriptor.Opcode == EVENT_TRACE_TYPE_START) {
@@ -1421,6 +1494,8 @@ void PMTraceConsumer::HandleWin7DxgkQueuePacket(EVENT_RECORD* pEventRecord)
 
 void PMTraceConsumer::HandleWin7DxgkVSyncDPC(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, Win7DxgkVSyncDPC);
+
     using namespace Microsoft_Windows_DxgKrnl::Win7;
 
     auto pVSyncDPCEvent = reinterpret_cast<DXGKETW_SCHEDULER_VSYNC_DPC*>(pEventRecord->UserData);
@@ -1431,6 +1506,8 @@ void PMTraceConsumer::HandleWin7DxgkVSyncDPC(EVENT_RECORD* pEventRecord)
 
 void PMTraceConsumer::HandleWin7DxgkMMIOFlip(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, Win7DxgkMMIOFlip);
+
     using namespace Microsoft_Windows_DxgKrnl::Win7;
 
     if (pEventRecord->EventHeader.Flags & EVENT_HEADER_FLAG_32_BIT_HEADER) {
@@ -1461,6 +1538,8 @@ std::size_t PMTraceConsumer::Win32KPresentHistoryTokenHash::operator()(PMTraceCo
 
 void PMTraceConsumer::HandleWin32kEvent(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, Win32kEvent);
+
     auto const& hdr = pEventRecord->EventHeader;
 
     if (mTrackDisplay) {
@@ -1493,6 +1572,7 @@ void PMTraceConsumer::HandleWin32kEvent(EVENT_RECORD* pEventRecord)
                     break;
                 }
 
+                InstrumentPresentLost(this, Superseded);
                 RemoveLostPresent(present);
             }
 
@@ -1714,6 +1794,8 @@ void PMTraceConsumer::HandleWin32kEvent(EVENT_RECORD* pEventRecord)
 
 void PMTraceConsumer::HandleDWMEvent(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, DWMEvent);
+
     auto const& hdr = pEventRecord->EventHeader;
     switch (hdr.EventDescriptor.Id) {
     case Microsoft_Windows_Dwm_Core::MILEVENT_MEDIA_UCE_PROCESSPRESENTHISTORY_GetPresentHistory_Info::Id:
@@ -1725,8 +1807,7 @@ void PMTraceConsumer::HandleDWMEvent(EVENT_RECORD* pEventRecord)
             if (present->PresentMode == PresentMode::Composed_Copy_GPU_GDI ||
                 present->PresentMode == PresentMode::Composed_Copy_CPU_GDI) {
                 VerboseTraceBeforeModifyingPresent(present.get());
-                mPresentsWaitingForDWM.emplace_back(present);
-                present->PresentInDwmWaitingStruct = true;
+                mPresentsWaitingForDWM.PushBack(present);
             }
         }
         mLastPresentByWindow.clear();
@@ -1807,8 +1888,7 @@ void PMTraceConsumer::HandleDWMEvent(EVENT_RECORD* pEventRecord)
         auto eventIter = mPresentByWin32KPresentHistoryToken.find(key);
         if (eventIter != mPresentByWin32KPresentHistoryToken.end() && eventIter->second->SeenInFrameEvent) {
             VerboseTraceBeforeModifyingPresent(eventIter->second.get());
-            mPresentsWaitingForDWM.emplace_back(eventIter->second);
-            eventIter->second->PresentInDwmWaitingStruct = true;
+            mPresentsWaitingForDWM.PushBack(eventIter->second);
         }
         break;
     }
@@ -1885,6 +1965,20 @@ void PMTraceConsumer::StopTrackingPresent(std::shared_ptr<PresentEvent> const& p
     // mOrderedPresentsByProcessId
     mOrderedPresentsByProcessId[p->ProcessId].erase(p->PresentStartTime);
 
+    // mOrderedPresentsBySwapChain
+    {
+        auto ii = mOrderedPresentsBySwapChain.find(std::make_pair(p->ProcessId, p->SwapChainAddress));
+        if (ii != mOrderedPresentsBySwapChain.end()) {
+            auto jj = ii->second.find(p->PresentStartTime);
+            if (jj != ii->second.end() && jj->second == p) {
+                ii->second.erase(jj);
+                if (ii->second.empty()) {
+                    mOrderedPresentsBySwapChain.erase(ii);
+                }
+            }
+        }
+    }
+
     // mPresentBySubmitSequence
     RemovePresentFromSubmitSequenceIdTracking(p);
 
@@ -1955,13 +2049,7 @@ void PMTraceConsumer::StopTrackingPresent(std::shared_ptr<PresentEvent> const& p
 
     // mPresentsWaitingForDWM
     if (p->PresentInDwmWaitingStruct) {
-        for (auto presentIter = mPresentsWaitingForDWM.begin(); presentIter != mPresentsWaitingForDWM.end(); presentIter++) {
-            if (p == *presentIter) {
-                mPresentsWaitingForDWM.erase(presentIter);
-                break;
-            }
-        }
-        p->PresentInDwmWaitingStruct = false;
+        mPresentsWaitingForDWM.Remove(p.get());
     }
 
     if (p->AppFrameId != 0) {
@@ -1974,6 +2062,26 @@ void PMTraceConsumer::StopTrackingPresent(std::shared_ptr<PresentEvent> const& p
     
 }
 
+// The swapchain of a present created by a flip may only be known once the flip's layer is, so it
+// has to be re-indexed in mOrderedPresentsBySwapChain.
+void PMTraceConsumer::SetSwapChainAddress(std::shared_ptr<PresentEvent> const& present, uint64_t swapChainAddress)
+{
+    auto ii = mOrderedPresentsBySwapChain.find(std::make_pair(present->ProcessId, present->SwapChainAddress));
+    if (ii != mOrderedPresentsBySwapChain.end()) {
+        auto jj = ii->second.find(present->PresentStartTime);
+        if (jj != ii->second.end() && jj->second == present) {
+            ii->second.erase(jj);
+            if (ii->second.empty()) {
+                mOrderedPresentsBySwapChain.erase(ii);
+            }
+            mOrderedPresentsBySwapChain[std::make_pair(present->ProcessId, swapChainAddress)].emplace(present->PresentStartTime, present);
+        }
+    }
+
+    VerboseTraceBeforeModifyingPresent(present.get());
+    present->SwapChainAddress = swapChainAddress;
+}
+
 void PMTraceConsumer::RemoveLostPresent(std::shared_ptr<PresentEvent> p)
 {
     VerboseTraceBeforeModifyingPresent(p.get());
@@ -1998,6 +2106,7 @@ void PMTraceConsumer::CompletePresent(std::shared_ptr<PresentEvent> const& p)
     if (!mHasCompletedAPresent && !p->IsLost) {
         for (auto const& pr : mOrderedPresentsByProcessId) {
             for (auto orderedPresents = &pr.second; !orderedPresents->empty(); ) {
+                InstrumentPresentLost(this, StartupDiscard);
                 RemoveLostPresent(orderedPresents->begin()->second);
             }
         }
@@ -2049,18 +2158,19 @@ void PMTraceConsumer::CompletePresent(std::shared_ptr<PresentEvent> const& p)
             for (auto p2 : p->DependentPresents) {
                 VerboseTraceBeforeModifyingPresent(p2.get());
                 p2->IsLost = true;
+                InstrumentPresentLost(this, DependentLost);
             }
         } else {
             // If there are multiple dependent presents from the same HWND, then discard all but the
             // last one.
-            std::unordered_set<uint64_t> completedComposedFlipHwnds;
+            mCompletedComposedFlipHwnds.clear();
             for (auto ii = p->DependentPresents.rbegin(), ie = p->DependentPresents.rend(); ii != ie; ++ii) {
                 auto p2 = *ii;
                 if (!p2->IsCompleted) {
                     if ((p2->PresentMode == PresentMode::Composed_Flip ||
                          p2->PresentMode == PresentMode::Composed_Copy_GPU_GDI ||
                          p2->PresentMode == PresentMode::Composed_Copy_CPU_GDI) &&
-                        !completedComposedFlipHwnds.emplace(p2->Hwnd).second) {
+                        !mCompletedComposedFlipHwnds.emplace(p2->Hwnd).second) {
                         VerboseTraceBeforeModifyingPresent(p2.get());
                         p2->FinalState = PresentResult::Discarded;
                         p2->Displayed.clear();
@@ -2089,24 +2199,28 @@ void PMTraceConsumer::CompletePresent(std::shared_ptr<PresentEvent> const& p)
 
     // If presented, remove any earlier presents made on the same swap chain.
     if (p->FinalState == PresentResult::Presented) {
-        auto presentsByThisProcess = &mOrderedPresentsByProcessId[p->ProcessId];
-        for (auto ii = presentsByThisProcess->begin(), ie = presentsByThisProcess->end(); ii != ie; ) {
-            auto p2 = ii->second;
-            if (p2->PresentStartTime >= p->PresentStartTime) break;
-            ++ii; // Increment the iterator first since below calls may remove it from
-                  // presentsByThisProcess.
-
-            if (p2->SwapChainAddress == p->SwapChainAddress) {
-                if (p->IsLost) {
-                    VerboseTraceBeforeModifyingPresent(p2.get());
-                    p2->IsLost = true;
-                }
-
-                CompletePresent(p2);
+        // Completing a present removes it (and possibly other presents) from
+        // mOrderedPresentsBySwapChain, so the swap chain is looked up again each time.
+        std::shared_ptr<PresentEvent> previous;
+        for (;;) {
+            auto ii = mOrderedPresentsBySwapChain.find(std::make_pair(p->ProcessId, p->SwapChainAddress));
+            if (ii == mOrderedPresentsBySwapChain.end()) break;
+            auto p2 = ii->second.begin()->second;
+            if (p2 == previous || p2->PresentStartTime >= p->PresentStartTime) break;
+
+            if (p->IsLost) {
+                VerboseTraceBeforeModifyingPresent(p2.get());
+                p2->IsLost = true;
+                InstrumentPresentLost(this, DependentLost);
             }
+
+            CompletePresent(p2);
+            previous = p2;
         }
     }
 
+    InstrumentPresentCompleted(this, p);
+
     // Remove the present from tracking structures.
     StopTrackingPresent(p);
 
@@ -2118,22 +2232,21 @@ void PMTraceConsumer::CompletePresent(std::shared_ptr<PresentEvent> const& p)
     auto present = p;
     auto presentStartTime = p->PresentStartTime;
     if (present->WaitingForFrameId) {
-        for (uint32_t i = mReadyCount; i < mCompletedCount; ++i) {
-            auto const& p2 = mCompletedPresents[GetRingIndex(mCompletedIndex + i)];
-            if (p2->WaitingForFrameId && p2->ProcessId == present->ProcessId) {
-                VerboseTraceBeforeModifyingPresent(p2.get());
-                if (p2->FrameId == present->FrameId) {
-                    p2->Displayed.insert(p2->Displayed.end(), present->Displayed.begin(), present->Displayed.end());
-                    if (p2->InputTime < present->InputTime || p2->MouseClickTime < present->MouseClickTime) {
-                        p2->InputTime = present->InputTime;
-                        p2->MouseClickTime = present->MouseClickTime;
-                        p2->InputType = present->InputType;
-                    }
-                    present = nullptr;
-                    break;
+        auto ii = mCompletedPresentWaitingForFrameIdByProcessId.find(present->ProcessId);
+        if (ii != mCompletedPresentWaitingForFrameIdByProcessId.end()) {
+            auto const& p2 = ii->second;
+            VerboseTraceBeforeModifyingPresent(p2.get());
+            if (p2->FrameId == present->FrameId) {
+                p2->Displayed.insert(p2->Displayed.end(), present->Displayed.begin(), present->Displayed.end());
+                if (p2->InputTime < present->InputTime || p2->MouseClickTime < present->MouseClickTime) {
+                    p2->InputTime = present->InputTime;
+                    p2->MouseClickTime = present->MouseClickTime;
+                    p2->InputType = present->InputType;
                 }
-
+                present = nullptr;
+            } else {
                 p2->WaitingForFrameId = false;
+                mCompletedPresentWaitingForFrameIdByProcessId.erase(ii);
             }
         }
     }
@@ -2155,6 +2268,7 @@ void PMTraceConsumer::CompletePresent(std::shared_ptr<PresentEvent> const& p)
             // present, if it IsLost; or the oldest completed present.
             else {
                 if (!mCompletedPresents[mCompletedIndex]->IsLost && present->IsLost) {
+                    InstrumentPresentDroppedOnOverflow(this);
                     return;
                 }
 
@@ -2163,6 +2277,11 @@ void PMTraceConsumer::CompletePresent(std::shared_ptr<PresentEvent> const& p)
                 if (mReadyCount > 0) {
                     mReadyCount--;
                 }
+
+                auto ii = mCompletedPresentWaitingForFrameIdByProcessId.find(mCompletedPresents[index]->ProcessId);
+                if (ii != mCompletedPresentWaitingForFrameIdByProcessId.end() && ii->second == mCompletedPresents[index]) {
+                    mCompletedPresentWaitingForFrameIdByProcessId.erase(ii);
+                }
             }
             // otherwise, completed buffer still has available space
         }
@@ -2172,6 +2291,9 @@ void PMTraceConsumer::CompletePresent(std::shared_ptr<PresentEvent> const& p)
         }
         // place the present in the completed presents ring buffer
         mCompletedPresents[index] = present;
+        if (present->WaitingForFrameId) {
+            mCompletedPresentWaitingForFrameIdByProcessId[present->ProcessId] = present;
+        }
     }
 
     // Update the ready count (do not lock mutex in this function, already locked)
@@ -2191,6 +2313,7 @@ void PMTraceConsumer::CompletePresent(std::shared_ptr<PresentEvent> const& p)
             if (deferredPresent->WaitingForPresentStop) {
                 deferredPresent->WaitingForPresentStop = false;
                 deferredPresent->IsLost = true;
+                InstrumentPresentLost(this, DeferralTimeout);
             }
             deferredPresent->WaitingForFlipFrameType = false;
             StopTrackingPresent(deferredPresent);
@@ -2231,6 +2354,7 @@ void PMTraceConsumer::SetThreadPresent(uint32_t threadId, std::shared_ptr<Presen
     // has gone wrong with it's tracking so consider it lost.
     auto ii = mPresentByThreadId.find(threadId);
     if (ii != mPresentByThreadId.end()) {
+        InstrumentPresentLost(this, Superseded);
         RemoveLostPresent(ii->second);
     }
 
@@ -2309,16 +2433,19 @@ void PMTraceConsumer::TrackPresent(
     // If there is an existing present that hasn't completed by the time the
     // circular buffer has come around, consider it lost.
     if (mTrackedPresents[mNextFreeRingIndex] != nullptr) {
+        InstrumentPresentLost(this, RingOverflow);
         RemoveLostPresent(mTrackedPresents[mNextFreeRingIndex]);
     }
 
     // Add the present into the initial tracking data structures
+    InstrumentPresentCreated(this);
     VerboseTraceBeforeModifyingPresent(present.get());
     present->RingIndex = mNextFreeRingIndex;
     mTrackedPresents[mNextFreeRingIndex] = present;
     mNextFreeRingIndex = GetRingIndex(mNextFreeRingIndex + 1);
 
     presentsByThisProcess->emplace(present->PresentStartTime, present);
+    mOrderedPresentsBySwapChain[std::make_pair(present->ProcessId, present->SwapChainAddress)].emplace(present->PresentStartTime, present);
 
     SetThreadPresent(present->ThreadId, present);
 
@@ -2497,6 +2624,8 @@ void PMTraceConsumer::RuntimePresentStop(Runtime runtime, EVENT_HEADER const& hd
 
 void PMTraceConsumer::HandleProcessEvent(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, ProcessEvent);
+
     auto const& hdr = pEventRecord->EventHeader;
 
     ProcessEvent event;
@@ -2891,6 +3020,8 @@ void PMTraceConsumer::UpdatePendingAppTimingData(const EVENT_RECORD* pEventRecor
 
 void PMTraceConsumer::HandleIntelPresentMonEvent(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, IntelPresentMonEvent);
+
     if (mTrackFrameType) {
         switch (pEventRecord->EventHeader.EventDescriptor.Id) {
         case Intel_PresentMon::PresentFrameType_Info::Id: {
@@ -3030,6 +3161,8 @@ void PMTraceConsumer::SignalEventsReady()
 
 void PMTraceConsumer::HandleMetadataEvent(EVENT_RECORD* pEventRecord)
 {
+    InstrumentHandler(this, MetadataEvent);
+
     mMetadata.AddMetadata(pEventRecord);
 }
 
@@ -3088,3 +3221,42 @@ void PMTraceConsumer::DequeuePresentEvents(std::vector<std::shared_ptr<PresentEv
         mCompletedRingCondition.notify_one();
     }
 }
+
+bool PMTraceConsumer::GetInstrumentationSnapshot(ConsumerInstrumentationSnapshot* snapshot) const
+{
+    #if PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION
+    mInstrumentation.GetSnapshot(snapshot);
+    return true;
+    #else
+    (void) snapshot;
+    return false;
+    #endif
+}
+
+#if PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION
+void PMTraceConsumer::SampleInstrumentedContainerSizes()
+{
+    auto const Set = [this](InstrumentedContainer container, size_t size) {
+        ConsumerInstrumentation::Set(&mInstrumentation.mContainerSizes[(size_t) container], size);
+    };
+
+    size_t trackedPresentCount = 0;
+    for (auto const& present : mTrackedPresents) {
+        trackedPresentCount += present != nullptr ? 1 : 0;
+    }
+
+    Set(InstrumentedContainer::TrackedPresents,                      trackedPresentCount);
+    Set(InstrumentedContainer::PresentByThreadId,                    mPresentByThreadId.size());
+    Set(InstrumentedContainer::OrderedPresentsByProcessId,           mOrderedPresentsByProcessId.size());
+    Set(InstrumentedContainer::OrderedPresentsBySwapChain,           mOrderedPresentsBySwapChain.size());
+    Set(InstrumentedContainer::PresentBySubmitSequence,              mPresentBySubmitSequence.size());
+    Set(InstrumentedContainer::PresentByWin32KPresentHistoryToken,   mPresentByWin32KPresentHistoryToken.size());
+    Set(InstrumentedContainer::PresentByDxgkPresentHistoryToken,     mPresentByDxgkPresentHistoryToken.size());
+    Set(InstrumentedContainer::PresentByDxgkPresentHistoryTokenData, mPresentByDxgkPresentHistoryTokenData.size());
+    Set(InstrumentedContainer::PresentByDxgkContext,                 mPresentByDxgkContext.size());
+    Set(InstrumentedContainer::PresentByVidPnLayerId,                mPresentByVidPnLayerId.size());
+    Set(InstrumentedContainer::LastPresentByWindow,                  mLastPresentByWindow.size());
+    Set(InstrumentedContainer::PresentsWaitingForDWM,                mPresentsWaitingForDWM.size());
+    mGpuTrace.SampleInstrumentedContainerSizes(&mInstrumentation);
+}
+#endif
@@ -21,7 +21,9 @@
 #include <windows.h>
 #include <evntcons.h> // must include after windows.h
 
+#include "ConsumerInstrumentation.hpp"
 #include "Debug.hpp"
+#include "GpuBusyIntervals.hpp"
 #include "GpuTrace.hpp"
 #include "TraceConsumer.hpp"
 #include "../IntelPresentMon/CommonUtilities/Hash.h"
@@ -221,11 +223,14 @@ struct PresentEvent {
     std::unordered_map<uint64_t, uint64_t> PresentIds; // mPresentByVidPnLayerId
     // Note: the following index tracking structures as well but are defined elsewhere:
     //       ProcessId                 -> mOrderedPresentsByProcessId
+    //       ProcessId, SwapChainAddress -> mOrderedPresentsBySwapChain
     //       ThreadId, DriverThreadId  -> mPresentByThreadId
     //       PresentInDwmWaitingStruct -> mPresentsWaitingForDWM
 
     // Additional transient tracking state
     std::deque<std::shared_ptr<PresentEvent>> DependentPresents;
+    std::shared_ptr<PresentEvent> NextPresentWaitingForDWM; // Links of the intrusive
+    PresentEvent* PrevPresentWaitingForDWM;                 // PMTraceConsumer::mPresentsWaitingForDWM
 
     // Properties deduced by watching events through present pipeline
     uint32_t DestWidth;
@@ -278,6 +283,33 @@ private:
     PresentEvent(PresentEvent const& copy); // dne
 };
 
+// DwmWaitingList is a list of presents that is linked through the presents themselves
+// (PresentEvent::NextPresentWaitingForDWM/PrevPresentWaitingForDWM), so that presents are added and
+// removed in O(1) without allocating.  PresentInDwmWaitingStruct is set while a present is in it.
+class DwmWaitingList {
+public:
+    DwmWaitingList() = default;
+    ~DwmWaitingList();
+
+    DwmWaitingList(DwmWaitingList const&) = delete;
+    DwmWaitingList& operator=(DwmWaitingList const&) = delete;
+
+    // Adds the present to the back of the list, unless it is already in the list.
+    void PushBack(std::shared_ptr<PresentEvent> const& present);
+    void Remove(PresentEvent* present);
+    // Moves all presents in the list, in order, to the back of *presents.
+    void MoveTo(std::deque<std::shared_ptr<PresentEvent>>* presents);
+
+    PresentEvent* front() const { return mHead.get(); }
+    size_t size() const { return mSize; }
+    bool empty() const { return mSize == 0; }
+
+private:
+    std::shared_ptr<PresentEvent> mHead;
+    PresentEvent* mTail = nullptr;
+    size_t mSize = 0;
+};
+
 struct PMTraceConsumer
 {
     // -------------------------------------------------------------------------------------------
@@ -306,6 +338,11 @@ struct PMTraceConsumer
     bool mIsRealtimeSession = true; // allow consumer to have different behavior for realtime vs. offline analysis
     bool mDisableOfflineBackpressure = false;
 
+    // If set (and mTrackGPU is true), every interval during which a GPU node runs a packet is
+    // written into this ring.  It must be set before the trace session is started, and the
+    // application is responsible for dequeuing from it and for its lifetime.
+    GpuBusyIntervalRing* mGpuBusyIntervals = nullptr;
+
     // -------------------------------------------------------------------------------------------
     // These functions can be used to filter PresentEvents by process from within the consumer.
 
@@ -327,6 +364,14 @@ struct PMTraceConsumer
     void DequeuePresentEvents(std::vector<std::shared_ptr<PresentEvent>>& outPresentEvents);
 
 
+    // -------------------------------------------------------------------------------------------
+    // When built with PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION=1, copies the consumer's current
+    // instrumentation counters into *snapshot and returns true (see ConsumerInstrumentation.hpp).
+    // Otherwise, returns false.  Can be called from any thread.
+
+    bool GetInstrumentationSnapshot(ConsumerInstrumentationSnapshot* snapshot) const;
+
+
     // -------------------------------------------------------------------------------------------
     // The rest of this structure are internal data and functions for analysing the collected ETW
     // data.
@@ -340,6 +385,11 @@ struct PMTraceConsumer
     uint32_t mCompletedCount = 0;       // The total number of presents in mCompletedPresents.
     uint32_t mReadyCount = 0;           // The number of presents in mCompletedPresents, starting at mCompletedIndex, that are ready to be dequeued.
 
+    // The present in mCompletedPresents that is WaitingForFrameId, for each process.  There is at
+    // most one per process, as completing the process' next present either merges into it or ends
+    // its wait.
+    std::unordered_map<uint32_t, std::shared_ptr<PresentEvent>> mCompletedPresentWaitingForFrameIdByProcessId;
+
     // Mutexs to protect consumer/dequeue access from different threads:
     std::mutex mProcessEventMutex;
     std::mutex mPresentEventMutex;
@@ -365,7 +415,7 @@ struct PMTraceConsumer
     //
     // mPresentsWaitingForDWM stores all in-progress presents that have been handed off to DWM.
     // Once the next DWM present is detected, they are added as its' DependentPresents.
-    std::deque<std::shared_ptr<PresentEvent>> mPresentsWaitingForDWM;
+    DwmWaitingList mPresentsWaitingForDWM;
     uint32_t DwmProcessId = 0;
     uint32_t DwmPresentThreadId = 0;
 
@@ -393,6 +443,9 @@ struct PMTraceConsumer
     // of the process (e.g., DXGI, DXGK, driver threads).  It's also used to detect discarded
     // presents when newer presents are displayed from the same swapchain.
     //
+    // mOrderedPresentsBySwapChain stores the same presents split by swapchain, so that discarding
+    // the presents that precede a displayed present doesn't walk the process' other swapchains.
+    //
     // mPresentBySubmitSequence stores presents who have had a present packet submitted on to a
     // queue until they are completed or discarded.  It's used to associate those presents to
     // various DXGK events (such as MMIOFlip, IndependentFlip and *SyncDPC) which reference the
@@ -437,6 +490,9 @@ struct PMTraceConsumer
 
     std::unordered_map<uint32_t, std::shared_ptr<PresentEvent>> mPresentByThreadId;                     // ThreadId -> PresentEvent
     std::unordered_map<uint32_t, OrderedPresents>               mOrderedPresentsByProcessId;            // ProcessId -> ordered PresentStartTime -> PresentEvent
+    std::unordered_map<std::pair<uint32_t, uint64_t>,
+                       OrderedPresents,
+                       PairHash<uint32_t, uint64_t>>            mOrderedPresentsBySwapChain;            // ProcessId and SwapChainAddress -> ordered PresentStartTime -> PresentEvent
     std::unordered_map<uint32_t, std::unordered_map<uint64_t, std::shared_ptr<PresentEvent>>>
                                                                 mPresentBySubmitSequence;               // SubmitSequenceId -> hContext -> PresentEvent
     std::unordered_map<Win32KPresentHistoryToken, std::shared_ptr<PresentEvent>,
@@ -461,6 +517,15 @@ struct PMTraceConsumer
     // mGpuTrace tracks work executed on the GPU.
     GpuTrace mGpuTrace;
 
+    // Scratch storage reused by CompletePresent() to avoid allocating for every DWM present.
+    std::unordered_set<uint64_t> mCompletedComposedFlipHwnds;
+
+    // Hot-path instrumentation counters, updated by the Instrument...() macros.
+    #if PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION
+    ConsumerInstrumentation mInstrumentation;
+    void SampleInstrumentedContainerSizes();
+    #endif
+
     // PresentFrameTypeEvents are stored into mPendingPresentFrameTypeEvents and then looked-up and
     // attached to the PresentEvent in Present_Start.
     //
@@ -538,6 +603,7 @@ struct PMTraceConsumer
     void RuntimePresentStop(Runtime runtime, EVENT_HEADER const& hdr, uint32_t result);
     void CompletePresent(std::shared_ptr<PresentEvent> const& present);
     void RemoveLostPresent(std::shared_ptr<PresentEvent> present);
+    void SetSwapChainAddress(std::shared_ptr<PresentEvent> const& present, uint64_t swapChainAddress);
 
     void UpdateReadyCount(bool useLock);
 
@@ -0,0 +1,38 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "ProcessInfoCache.hpp"
+
+#include <windows.h>
+
+void* WindowsProcessQuery::Open(uint32_t processId)
+{
+    return OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
+}
+
+bool WindowsProcessQuery::QueryImageName(void* handle, std::wstring* imageName)
+{
+    wchar_t path[MAX_PATH];
+    DWORD numChars = _countof(path);
+    if (!QueryFullProcessImageNameW((HANDLE) handle, 0, path, &numChars)) {
+        return false;
+    }
+
+    for (;; --numChars) {
+        if (numChars == 0 || path[numChars - 1] == L'\\' || path[numChars - 1] == L'/') {
+            imageName->assign(&path[numChars]);
+            return true;
+        }
+    }
+}
+
+bool WindowsProcessQuery::HasExited(void* handle)
+{
+    DWORD exitCode = 0;
+    return GetExitCodeProcess((HANDLE) handle, &exitCode) && exitCode != STILL_ACTIVE;
+}
+
+void WindowsProcessQuery::Close(void* handle)
+{
+    CloseHandle((HANDLE) handle);
+}
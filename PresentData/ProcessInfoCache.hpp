@@ -0,0 +1,264 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// ProcessQuery is the OS interface used by ProcessInfoCache to inspect processes that were not
+// announced by a process start event.  Handles are opaque to the cache (a HANDLE on Windows).
+class ProcessQuery {
+public:
+    virtual ~ProcessQuery() {}
+
+    // Returns nullptr if the process could not be opened, e.g. because it already exited or
+    // because it belongs to another account and we lack SeDebugPrivilege.
+    virtual void* Open(uint32_t processId) = 0;
+    // Sets *imageName to the image file name of the process, without its directory.
+    virtual bool QueryImageName(void* handle, std::wstring* imageName) = 0;
+    virtual bool HasExited(void* handle) = 0;
+    virtual void Close(void* handle) = 0;
+};
+
+// ProcessQuery implemented with OpenProcess(), QueryFullProcessImageNameW() and
+// GetExitCodeProcess().
+class WindowsProcessQuery : public ProcessQuery {
+public:
+    void* Open(uint32_t processId) override;
+    bool QueryImageName(void* handle, std::wstring* imageName) override;
+    bool HasExited(void* handle) override;
+    void Close(void* handle) override;
+};
+
+// ProcessInfoCache remembers the image name of each process, keyed by process id and start time,
+// so that each process is queried from the OS at most once in its lifetime, and usually not at all:
+//
+// - OnProcessStart() records processes announced by a process start event (from ETW or an ETL)
+//   without querying the OS.
+// - Lookup() of a process id that has no entry opens the process.  The handle is held until the
+//   process exits, which also keeps the id from being reused in the meantime, and
+//   CollectExited() reports when that happens.
+// - Processes that cannot be opened are cached as unknown, and are only retried after
+//   kUnknownSeconds.
+// - OnProcessStop() ends the lifetime of an entry.  Stopped entries are kept for kStoppedSeconds
+//   so that presents which started before the stop still resolve to that process; a later lookup
+//   of the same id means the id was reused without a start event, and queries the OS again.
+//
+// Timestamps are in the units of the trace session.  The cache is not thread safe.
+class ProcessInfoCache {
+public:
+    static constexpr double kUnknownSeconds = 1.0;
+    static constexpr double kStoppedSeconds = 5.0;
+
+    struct Stats {
+        uint64_t mLookupCount;
+        uint64_t mQueryCount;   // Lookups that had to open the process
+    };
+
+    // query can be nullptr (e.g., when reading an ETL), in which case processes that were not
+    // announced by a start event are unknown.
+    ProcessInfoCache(ProcessQuery* query, uint64_t timestampFrequency)
+        : mQuery(query)
+        , mUnknownTicks(uint64_t(kUnknownSeconds * timestampFrequency))
+        , mStoppedTicks(uint64_t(kStoppedSeconds * timestampFrequency))
+    {
+    }
+
+    ~ProcessInfoCache()
+    {
+        Clear();
+    }
+
+    ProcessInfoCache(ProcessInfoCache const&) = delete;
+    ProcessInfoCache& operator=(ProcessInfoCache const&) = delete;
+
+    void OnProcessStart(uint32_t processId, uint64_t timestamp, std::wstring const& imageName)
+    {
+        // A start event for an id that is still in use means we missed the previous process'
+        // stop event.
+        auto ii = Find(processId, timestamp);
+        if (ii != mEntries.end() && ii->second.mStopTime == UINT64_MAX) {
+            Stop(ii, timestamp);
+        }
+
+        auto entry = &mEntries[Key{ processId, timestamp }];
+        entry->mImageName  = imageName;
+        entry->mStopTime   = UINT64_MAX;
+        entry->mExpireTime = UINT64_MAX;
+        entry->mHandle     = nullptr;
+        entry->mKnown      = true;
+
+        Prune(timestamp);
+    }
+
+    void OnProcessStop(uint32_t processId, uint64_t timestamp)
+    {
+        auto ii = Find(processId, timestamp);
+        if (ii != mEntries.end() && ii->second.mStopTime == UINT64_MAX) {
+            Stop(ii, timestamp);
+        }
+
+        Prune(timestamp);
+    }
+
+    // Returns the image name of the process that had processId at timestamp, or nullptr if it is
+    // unknown.  The pointer is valid until the next call into the cache.
+    std::wstring const* Lookup(uint32_t processId, uint64_t timestamp)
+    {
+        mStats.mLookupCount += 1;
+
+        Prune(timestamp);
+
+        auto ii = Find(processId, timestamp);
+        uint64_t startTime = 0;
+        if (ii != mEntries.end()) {
+            auto entry = &ii->second;
+            if (timestamp <= entry->mStopTime && (entry->mKnown || timestamp < entry->mExpireTime)) {
+                return entry->mKnown ? &entry->mImageName : nullptr;
+            }
+            if (timestamp <= entry->mStopTime) {
+                // Retry an unknown process.
+                startTime = ii->first.mStartTime;
+                mEntries.erase(ii);
+            } else {
+                startTime = entry->mStopTime + 1;
+            }
+        }
+        if (HasLaterEntry(processId, timestamp)) {
+            // The process that had this id at timestamp has exited since, so there is nothing to
+            // query.
+            return nullptr;
+        }
+
+        auto entry = &mEntries[Key{ processId, startTime }];
+        entry->mStopTime   = UINT64_MAX;
+        entry->mExpireTime = UINT64_MAX;
+        entry->mHandle     = nullptr;
+        entry->mKnown      = false;
+        if (mQuery != nullptr) {
+            mStats.mQueryCount += 1;
+            entry->mHandle = mQuery->Open(processId);
+        }
+        if (entry->mHandle == nullptr) {
+            entry->mExpireTime = timestamp + mUnknownTicks;
+            return nullptr;
+        }
+
+        entry->mKnown = mQuery->QueryImageName(entry->mHandle, &entry->mImageName);
+        mOpen.push_back(mEntries.find(Key{ processId, startTime }));
+        return entry->mKnown ? &entry->mImageName : nullptr;
+    }
+
+    // Appends the ids of processes opened by Lookup() that exited since the last call, and ends
+    // their lifetime at timestamp.
+    void CollectExited(uint64_t timestamp, std::vector<uint32_t>* processIds)
+    {
+        for (size_t i = 0; i < mOpen.size(); ) {
+            auto ii = mOpen[i];
+            if (mQuery->HasExited(ii->second.mHandle)) {
+                processIds->push_back(ii->first.mProcessId);
+                Stop(ii, timestamp); // Removes mOpen[i]
+            } else {
+                ++i;
+            }
+        }
+    }
+
+    // Closes all process handles and forgets all processes.
+    void Clear()
+    {
+        for (auto ii : mOpen) {
+            mQuery->Close(ii->second.mHandle);
+        }
+        mOpen.clear();
+        mEntries.clear();
+        mNextPruneTime = 0;
+    }
+
+    size_t GetEntryCount() const { return mEntries.size(); }
+    size_t GetOpenCount() const  { return mOpen.size(); }
+    Stats const& GetStats() const { return mStats; }
+
+private:
+    struct Key {
+        uint32_t mProcessId;
+        uint64_t mStartTime;
+
+        bool operator<(Key const& other) const
+        {
+            return mProcessId != other.mProcessId ? mProcessId < other.mProcessId : mStartTime < other.mStartTime;
+        }
+    };
+
+    struct Entry {
+        std::wstring mImageName;
+        uint64_t mStopTime;     // UINT64_MAX while the process is running
+        uint64_t mExpireTime;   // When the entry is dropped, or UINT64_MAX
+        void* mHandle;          // Set while a process opened by Lookup() is running
+        bool mKnown;            // Whether mImageName is valid
+    };
+
+    using EntryMap = std::map<Key, Entry>;
+
+    // The latest entry for processId that started at or before timestamp.
+    EntryMap::iterator Find(uint32_t processId, uint64_t timestamp)
+    {
+        auto ii = mEntries.upper_bound(Key{ processId, timestamp });
+        if (ii == mEntries.begin()) {
+            return mEntries.end();
+        }
+        --ii;
+        return ii->first.mProcessId == processId ? ii : mEntries.end();
+    }
+
+    bool HasLaterEntry(uint32_t processId, uint64_t timestamp) const
+    {
+        auto ii = mEntries.upper_bound(Key{ processId, timestamp });
+        return ii != mEntries.end() && ii->first.mProcessId == processId;
+    }
+
+    void Stop(EntryMap::iterator ii, uint64_t timestamp)
+    {
+        auto entry = &ii->second;
+        entry->mStopTime   = timestamp;
+        entry->mExpireTime = timestamp + mStoppedTicks;
+        if (entry->mHandle != nullptr) {
+            mQuery->Close(entry->mHandle);
+            entry->mHandle = nullptr;
+            for (auto& jj : mOpen) {
+                if (jj == ii) {
+                    jj = mOpen.back();
+                    mOpen.pop_back();
+                    break;
+                }
+            }
+        }
+    }
+
+    // Drops expired entries, at most once per kStoppedSeconds so that the cost is amortized over
+    // the events seen in that time.
+    void Prune(uint64_t timestamp)
+    {
+        if (timestamp < mNextPruneTime) {
+            return;
+        }
+        mNextPruneTime = timestamp + mStoppedTicks;
+
+        for (auto ii = mEntries.begin(); ii != mEntries.end(); ) {
+            if (ii->second.mExpireTime <= timestamp) {
+                ii = mEntries.erase(ii);
+            } else {
+                ++ii;
+            }
+        }
+    }
+
+    ProcessQuery* mQuery;
+    uint64_t mUnknownTicks;
+    uint64_t mStoppedTicks;
+    uint64_t mNextPruneTime = 0;
+    EntryMap mEntries;
+    std::vector<EntryMap::iterator> mOpen;  // Entries with an open handle
+    Stats mStats = {};
+};
@@ -0,0 +1,665 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "ColumnarFile.hpp"
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+namespace {
+
+char const kMagic[4] = { 'P', 'M', 'C', 'F' };
+uint32_t const kVersion = 1;
+
+// Upper bound on rows per chunk accepted by the reader, to reject corrupt
+// files before allocating.
+uint32_t const kMaxChunkRows = 1u << 20;
+
+// PMTraceSession::TIMESTAMP_TYPE_SYSTEM_TIME
+uint32_t const kTimestampTypeSystemTime = 2;
+
+void PushBytes(std::vector<uint8_t>* out, void const* data, size_t size)
+{
+    auto p = (uint8_t const*) data;
+    out->insert(out->end(), p, p + size);
+}
+
+void PushVarint(std::vector<uint8_t>* out, uint64_t value)
+{
+    while (value >= 0x80) {
+        out->push_back((uint8_t) (value | 0x80));
+        value >>= 7;
+    }
+    out->push_back((uint8_t) value);
+}
+
+uint64_t ZigZag(int64_t value)
+{
+    return ((uint64_t) value << 1) ^ (uint64_t) (value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value)
+{
+    return (int64_t) (value >> 1) ^ -(int64_t) (value & 1);
+}
+
+// Bounds-checked cursor over a decoded block.
+struct BlockCursor {
+    uint8_t const* mData;
+    size_t mSize;
+    bool mOk;
+
+    bool Read(void* dst, size_t size)
+    {
+        if (!mOk || size > mSize) {
+            mOk = false;
+            return false;
+        }
+        memcpy(dst, mData, size);
+        mData += size;
+        mSize -= size;
+        return true;
+    }
+
+    uint64_t ReadVarint()
+    {
+        uint64_t value = 0;
+        for (uint32_t shift = 0; shift < 64 && mOk && mSize > 0; shift += 7) {
+            auto b = *mData++;
+            mSize -= 1;
+            value |= (uint64_t) (b & 0x7F) << shift;
+            if ((b & 0x80) == 0) {
+                return value;
+            }
+        }
+        mOk = false;
+        return 0;
+    }
+};
+
+bool ReadFile(FILE* fp, void* dst, size_t size)
+{
+    return fread(dst, 1, size, fp) == size;
+}
+
+}
+
+// ----------------------------------------------------------------------------
+// ColumnarWriter
+
+ColumnarWriter::~ColumnarWriter()
+{
+    Close();
+}
+
+bool ColumnarWriter::Open(wchar_t const* path, ColumnarTiming const& timing, std::vector<ColumnDesc> columns)
+{
+    assert(mFile == nullptr);
+
+    if (_wfopen_s(&mFile, path, L"wb")) {
+        mFile = nullptr;
+        return false;
+    }
+
+    mColumns.resize(columns.size());
+    for (size_t i = 0, n = columns.size(); i < n; ++i) {
+        auto column = &mColumns[i];
+        column->mDesc = std::move(columns[i]);
+        column->mValues.reserve(kChunkRows);
+        column->mValidity.resize((kChunkRows + 7) / 8);
+        column->mHasNA = false;
+    }
+
+    auto columnCount = (uint32_t) mColumns.size();
+    mEncoded.clear();
+    PushBytes(&mEncoded, kMagic, sizeof(kMagic));
+    PushBytes(&mEncoded, &kVersion, sizeof(kVersion));
+    PushBytes(&mEncoded, &timing.mStartTimestamp, sizeof(timing.mStartTimestamp));
+    PushBytes(&mEncoded, &timing.mTimestampFrequency, sizeof(timing.mTimestampFrequency));
+    PushBytes(&mEncoded, &timing.mStartFileTime, sizeof(timing.mStartFileTime));
+    PushBytes(&mEncoded, &timing.mTimestampType, sizeof(timing.mTimestampType));
+    PushBytes(&mEncoded, &columnCount, sizeof(columnCount));
+    for (auto const& column : mColumns) {
+        auto const& desc = column.mDesc;
+        auto nameLength = (uint16_t) desc.mName.size();
+        PushBytes(&mEncoded, &nameLength, sizeof(nameLength));
+        PushBytes(&mEncoded, desc.mName.data(), nameLength);
+        mEncoded.push_back((uint8_t) desc.mType);
+        mEncoded.push_back((uint8_t) desc.mTimeRender);
+        mEncoded.push_back(desc.mPrecision);
+        mEncoded.push_back(desc.mHexWidth);
+        mEncoded.push_back(desc.mNullable ? 1 : 0);
+    }
+    Write(mEncoded.data(), mEncoded.size());
+
+    return true;
+}
+
+void ColumnarWriter::Close()
+{
+    if (mFile != nullptr) {
+        FlushChunk();
+        fclose(mFile);
+        mFile = nullptr;
+    }
+}
+
+ColumnarWriter::Column* ColumnarWriter::NextColumn()
+{
+    assert(mNextColumn < mColumns.size());
+    return &mColumns[mNextColumn++];
+}
+
+void ColumnarWriter::Append(uint64_t bits)
+{
+    auto column = NextColumn();
+    column->mValues.push_back(bits);
+    column->mValidity[mChunkRowCount >> 3] |= (uint8_t) (1u << (mChunkRowCount & 7));
+}
+
+void ColumnarWriter::AppendInt(int64_t value)
+{
+    Append((uint64_t) value);
+}
+
+void ColumnarWriter::AppendUInt(uint64_t value)
+{
+    Append(value);
+}
+
+void ColumnarWriter::AppendDouble(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    Append(bits);
+}
+
+void ColumnarWriter::AppendTimestamp(uint64_t value)
+{
+    Append(value);
+}
+
+void ColumnarWriter::AppendDictionary(std::string const& key)
+{
+    auto column = &mColumns[mNextColumn];
+    auto ii = column->mDictionary.find(key);
+    if (ii == column->mDictionary.end()) {
+        auto index = (uint32_t) column->mEntries.size();
+        ii = column->mDictionary.emplace(key, index).first;
+        column->mEntries.push_back(&ii->first);
+        column->mNewEntries.push_back(index);
+    }
+    Append(ii->second);
+}
+
+void ColumnarWriter::AppendString(char const* value)
+{
+    mKey.assign(value);
+    AppendDictionary(mKey);
+}
+
+void ColumnarWriter::AppendString(std::wstring const& value)
+{
+    // Convert into the reused key buffer to avoid allocating per row.
+    auto size = WideCharToMultiByte(CP_UTF8, 0, value.c_str(), (int) value.size(), nullptr, 0, nullptr, nullptr);
+    mKey.resize(size);
+    WideCharToMultiByte(CP_UTF8, 0, value.c_str(), (int) value.size(), &mKey[0], size, nullptr, nullptr);
+    AppendDictionary(mKey);
+}
+
+void ColumnarWriter::AppendNA()
+{
+    auto column = NextColumn();
+    assert(column->mDesc.mNullable);
+    column->mHasNA = true;
+}
+
+void ColumnarWriter::EndRow()
+{
+    assert(mNextColumn == mColumns.size());
+    mNextColumn = 0;
+    mChunkRowCount += 1;
+    mRowCount += 1;
+    if (mChunkRowCount == kChunkRows) {
+        FlushChunk();
+    }
+}
+
+void ColumnarWriter::EncodeColumn(Column* column, std::vector<uint8_t>* out)
+{
+    auto const& values = column->mValues;
+    auto type = column->mDesc.mType;
+
+    // Validity
+    out->push_back(column->mHasNA ? 1 : 0);
+    if (column->mHasNA) {
+        PushBytes(out, column->mValidity.data(), (mChunkRowCount + 7) / 8);
+    }
+
+    // Statistics
+    auto validCount = (uint32_t) values.size();
+    PushBytes(out, &validCount, sizeof(validCount));
+    if (validCount > 0 && type != ColumnType::String) {
+        uint64_t minBits = values[0];
+        uint64_t maxBits = values[0];
+        for (auto bits : values) {
+            switch (type) {
+            case ColumnType::Int:
+                if ((int64_t) bits < (int64_t) minBits) minBits = bits;
+                if ((int64_t) bits > (int64_t) maxBits) maxBits = bits;
+                break;
+            case ColumnType::Double: {
+                double v, lo, hi;
+                memcpy(&v, &bits, sizeof(v));
+                memcpy(&lo, &minBits, sizeof(lo));
+                memcpy(&hi, &maxBits, sizeof(hi));
+                if (v < lo) minBits = bits;
+                if (v > hi) maxBits = bits;
+            }   break;
+            default:
+                minBits = std::min(minBits, bits);
+                maxBits = std::max(maxBits, bits);
+                break;
+            }
+        }
+        PushBytes(out, &minBits, sizeof(minBits));
+        PushBytes(out, &maxBits, sizeof(maxBits));
+    }
+
+    // Values
+    switch (type) {
+    case ColumnType::Int:
+        for (auto bits : values) {
+            PushVarint(out, ZigZag((int64_t) bits));
+        }
+        break;
+    case ColumnType::UInt:
+    case ColumnType::Hex:
+        for (auto bits : values) {
+            PushVarint(out, bits);
+        }
+        break;
+    case ColumnType::Double:
+        PushBytes(out, values.data(), values.size() * sizeof(uint64_t));
+        break;
+    case ColumnType::Timestamp: {
+        uint64_t prev = 0;
+        for (auto bits : values) {
+            PushVarint(out, ZigZag((int64_t) (bits - prev)));
+            prev = bits;
+        }
+    }   break;
+    case ColumnType::String:
+        PushVarint(out, column->mNewEntries.size());
+        for (auto index : column->mNewEntries) {
+            auto const& entry = *column->mEntries[index];
+            PushVarint(out, entry.size());
+            PushBytes(out, entry.data(), entry.size());
+        }
+        for (auto bits : values) {
+            PushVarint(out, bits);
+        }
+        break;
+    }
+}
+
+void ColumnarWriter::FlushChunk()
+{
+    if (mChunkRowCount == 0 || mFile == nullptr) {
+        return;
+    }
+
+    Write(&mChunkRowCount, sizeof(mChunkRowCount));
+    for (auto& column : mColumns) {
+        mEncoded.clear();
+        EncodeColumn(&column, &mEncoded);
+
+        auto size = (uint32_t) mEncoded.size();
+        Write(&size, sizeof(size));
+        Write(mEncoded.data(), mEncoded.size());
+
+        column.mValues.clear();
+        std::fill(column.mValidity.begin(), column.mValidity.end(), (uint8_t) 0);
+        column.mHasNA = false;
+        column.mNewEntries.clear();
+    }
+
+    mChunkRowCount = 0;
+}
+
+void ColumnarWriter::Write(void const* data, size_t size)
+{
+    fwrite(data, 1, size, mFile);
+    mBytesWritten += size;
+}
+
+// ----------------------------------------------------------------------------
+// ColumnarReader
+
+ColumnarReader::~ColumnarReader()
+{
+    Close();
+}
+
+bool ColumnarReader::Open(wchar_t const* path)
+{
+    assert(mFile == nullptr);
+
+    mCorrupt = false;
+    if (_wfopen_s(&mFile, path, L"rb")) {
+        mFile = nullptr;
+        return false;
+    }
+
+    char magic[4] = {};
+    uint32_t version = 0;
+    uint32_t columnCount = 0;
+    if (!ReadFile(mFile, magic, sizeof(magic)) ||
+        memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !ReadFile(mFile, &version, sizeof(version)) ||
+        version != kVersion ||
+        !ReadFile(mFile, &mTiming.mStartTimestamp, sizeof(mTiming.mStartTimestamp)) ||
+        !ReadFile(mFile, &mTiming.mTimestampFrequency, sizeof(mTiming.mTimestampFrequency)) ||
+        !ReadFile(mFile, &mTiming.mStartFileTime, sizeof(mTiming.mStartFileTime)) ||
+        !ReadFile(mFile, &mTiming.mTimestampType, sizeof(mTiming.mTimestampType)) ||
+        !ReadFile(mFile, &columnCount, sizeof(columnCount)) ||
+        columnCount > UINT16_MAX) {
+        Close();
+        return false;
+    }
+
+    mColumnDescs.resize(columnCount);
+    for (auto& desc : mColumnDescs) {
+        uint16_t nameLength = 0;
+        uint8_t attributes[5] = {};
+        if (!ReadFile(mFile, &nameLength, sizeof(nameLength))) {
+            Close();
+            return false;
+        }
+        desc.mName.resize(nameLength);
+        if (!ReadFile(mFile, &desc.mName[0], nameLength) ||
+            !ReadFile(mFile, attributes, sizeof(attributes)) ||
+            attributes[0] > (uint8_t) ColumnType::String ||
+            attributes[1] > (uint8_t) TimeRender::DateTime) {
+            Close();
+            return false;
+        }
+        desc.mType       = (ColumnType) attributes[0];
+        desc.mTimeRender = (TimeRender) attributes[1];
+        desc.mPrecision  = attributes[2];
+        desc.mHexWidth   = attributes[3];
+        desc.mNullable   = attributes[4] != 0;
+    }
+
+    mColumns.resize(columnCount);
+    return true;
+}
+
+void ColumnarReader::Close()
+{
+    if (mFile != nullptr) {
+        fclose(mFile);
+        mFile = nullptr;
+    }
+    mColumnDescs.clear();
+    mColumns.clear();
+    mChunkRowCount = 0;
+}
+
+bool ColumnarReader::ReadChunk()
+{
+    mChunkRowCount = 0;
+    if (mFile == nullptr) {
+        return false;
+    }
+
+    uint32_t rowCount = 0;
+    if (!ReadFile(mFile, &rowCount, sizeof(rowCount))) {
+        return false; // end of file
+    }
+    if (rowCount == 0 || rowCount > kMaxChunkRows) {
+        mCorrupt = true;
+        return false;
+    }
+
+    mChunkRowCount = rowCount;
+    for (size_t i = 0, n = mColumns.size(); i < n; ++i) {
+        uint32_t size = 0;
+        if (!ReadFile(mFile, &size, sizeof(size))) {
+            mCorrupt = true;
+            break;
+        }
+        mBlock.resize(size);
+        if (!ReadFile(mFile, mBlock.data(), size) ||
+            !DecodeColumn(i, mBlock.data(), size)) {
+            mCorrupt = true;
+            break;
+        }
+    }
+
+    if (mCorrupt) {
+        mChunkRowCount = 0;
+        return false;
+    }
+    return true;
+}
+
+bool ColumnarReader::DecodeColumn(size_t columnIndex, uint8_t const* data, size_t size)
+{
+    auto const& desc = mColumnDescs[columnIndex];
+    auto column = &mColumns[columnIndex];
+    auto rowCount = mChunkRowCount;
+    BlockCursor cursor{ data, size, true };
+
+    // Validity
+    uint8_t hasNA = 0;
+    cursor.Read(&hasNA, sizeof(hasNA));
+    if (hasNA) {
+        column->mValidity.resize((rowCount + 7) / 8);
+        cursor.Read(column->mValidity.data(), column->mValidity.size());
+    } else {
+        column->mValidity.clear();
+    }
+
+    // Statistics
+    uint32_t validCount = 0;
+    cursor.Read(&validCount, sizeof(validCount));
+    column->mStats.mValidCount = validCount;
+    column->mStats.mMinUInt = 0;
+    column->mStats.mMaxUInt = 0;
+    if (validCount > 0 && desc.mType != ColumnType::String) {
+        cursor.Read(&column->mStats.mMinUInt, sizeof(uint64_t));
+        cursor.Read(&column->mStats.mMaxUInt, sizeof(uint64_t));
+    }
+    if (!cursor.mOk || validCount > rowCount) {
+        return false;
+    }
+
+    uint32_t expectedValidCount = rowCount;
+    if (hasNA) {
+        expectedValidCount = 0;
+        for (uint32_t row = 0; row < rowCount; ++row) {
+            expectedValidCount += IsValid(columnIndex, row) ? 1 : 0;
+        }
+    }
+    if (validCount != expectedValidCount) {
+        return false;
+    }
+
+    // Dictionary additions
+    if (desc.mType == ColumnType::String) {
+        auto newEntryCount = cursor.ReadVarint();
+        for (uint64_t i = 0; i < newEntryCount && cursor.mOk; ++i) {
+            auto length = cursor.ReadVarint();
+            if (!cursor.mOk || length > cursor.mSize) {
+                return false;
+            }
+            column->mDictionary.emplace_back((char const*) cursor.mData, (size_t) length);
+            cursor.mData += length;
+            cursor.mSize -= (size_t) length;
+        }
+    }
+
+    // Values
+    column->mValues.assign(rowCount, 0);
+    uint64_t prev = 0;
+    for (uint32_t row = 0; row < rowCount && cursor.mOk; ++row) {
+        if (!IsValid(columnIndex, row)) {
+            continue;
+        }
+
+        uint64_t value = 0;
+        switch (desc.mType) {
+        case ColumnType::Int:       value = (uint64_t) UnZigZag(cursor.ReadVarint()); break;
+        case ColumnType::UInt:
+        case ColumnType::Hex:       value = cursor.ReadVarint(); break;
+        case ColumnType::Double:    cursor.Read(&value, sizeof(value)); break;
+        case ColumnType::Timestamp: value = prev + (uint64_t) UnZigZag(cursor.ReadVarint()); prev = value; break;
+        case ColumnType::String:
+            value = cursor.ReadVarint();
+            if (value >= column->mDictionary.size()) {
+                return false;
+            }
+            break;
+        }
+        column->mValues[row] = value;
+    }
+
+    return cursor.mOk;
+}
+
+bool ColumnarReader::IsValid(size_t column, uint32_t row) const
+{
+    auto const& validity = mColumns[column].mValidity;
+    return validity.empty() || (validity[row >> 3] & (1u << (row & 7))) != 0;
+}
+
+double ColumnarReader::GetDouble(size_t column, uint32_t row) const
+{
+    double value;
+    memcpy(&value, &mColumns[column].mValues[row], sizeof(value));
+    return value;
+}
+
+std::string const& ColumnarReader::GetString(size_t column, uint32_t row) const
+{
+    auto const& c = mColumns[column];
+    return c.mDictionary[c.mValues[row]];
+}
+
+// ----------------------------------------------------------------------------
+// CSV conversion
+
+namespace {
+
+// These mirror the PMTraceSession conversions so that the rendered values
+// are bit-identical to those PresentMon writes directly to CSV.
+double TimestampDeltaToMilliSeconds(ColumnarTiming const& timing, uint64_t timestampDelta)
+{
+    return 1000.0 * timestampDelta / (int64_t) timing.mTimestampFrequency;
+}
+
+void WriteTimestamp(FILE* fp, ColumnarTiming const& timing, ColumnDesc const& desc, uint64_t timestamp)
+{
+    switch (desc.mTimeRender) {
+    case TimeRender::MilliSeconds:
+        fwprintf(fp, L"%.*lf", desc.mPrecision, TimestampDeltaToMilliSeconds(timing, timestamp - timing.mStartTimestamp));
+        break;
+    case TimeRender::Seconds:
+        fwprintf(fp, L"%.*lf", desc.mPrecision, 0.001 * TimestampDeltaToMilliSeconds(timing, timestamp - timing.mStartTimestamp));
+        break;
+    case TimeRender::QpcMilliSeconds:
+        fwprintf(fp, L"%.*lf", desc.mPrecision, TimestampDeltaToMilliSeconds(timing, timestamp));
+        break;
+    case TimeRender::QpcSeconds:
+        fwprintf(fp, L"%.*lf", desc.mPrecision, 0.001 * TimestampDeltaToMilliSeconds(timing, timestamp));
+        break;
+    case TimeRender::DateTime: {
+        if (timing.mTimestampType != kTimestampTypeSystemTime) {
+            auto delta100ns = (timestamp - timing.mStartTimestamp) * 10000000ull / timing.mTimestampFrequency;
+            timestamp = timing.mStartFileTime + delta100ns;
+        }
+        FILETIME lft{};
+        SYSTEMTIME st{};
+        FileTimeToLocalFileTime((FILETIME*) &timestamp, &lft);
+        FileTimeToSystemTime(&lft, &st);
+        fwprintf(fp, L"%u-%u-%u %u:%02u:%02u.%09llu", st.wYear,
+                                                       st.wMonth,
+                                                       st.wDay,
+                                                       st.wHour,
+                                                       st.wMinute,
+                                                       st.wSecond,
+                                                       (timestamp % 10000000) * 100);
+    }   break;
+    default:
+        fwprintf(fp, L"%llu", timestamp);
+        break;
+    }
+}
+
+std::wstring Utf8ToWide(std::string const& s)
+{
+    std::wstring w(MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int) s.size(), nullptr, 0), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, s.c_str(), (int) s.size(), &w[0], (int) w.size());
+    return w;
+}
+
+}
+
+int64_t WriteColumnarAsCsv(ColumnarReader* reader, FILE* fp)
+{
+    auto const& columns = reader->GetColumns();
+    auto const& timing = reader->GetTiming();
+    auto columnCount = columns.size();
+
+    for (size_t i = 0; i < columnCount; ++i) {
+        fwprintf(fp, i == 0 ? L"%hs" : L",%hs", columns[i].mName.c_str());
+    }
+    fwprintf(fp, L"\n");
+
+    // Wide copies of each column's dictionary, extended as chunks add entries.
+    std::vector<std::vector<std::wstring>> wideStrings(columnCount);
+
+    int64_t rowCount = 0;
+    while (reader->ReadChunk()) {
+        for (size_t i = 0; i < columnCount; ++i) {
+            if (columns[i].mType == ColumnType::String) {
+                auto const& dictionary = reader->GetDictionary(i);
+                for (size_t j = wideStrings[i].size(); j < dictionary.size(); ++j) {
+                    wideStrings[i].emplace_back(Utf8ToWide(dictionary[j]));
+                }
+            }
+        }
+
+        for (uint32_t row = 0, n = reader->GetChunkRowCount(); row < n; ++row) {
+            for (size_t i = 0; i < columnCount; ++i) {
+                auto const& desc = columns[i];
+                if (i > 0) {
+                    fwprintf(fp, L",");
+                }
+                if (!reader->IsValid(i, row)) {
+                    fwprintf(fp, L"NA");
+                    continue;
+                }
+                switch (desc.mType) {
+                case ColumnType::Int:       fwprintf(fp, L"%lld", reader->GetInt(i, row)); break;
+                case ColumnType::UInt:      fwprintf(fp, L"%llu", reader->GetUInt(i, row)); break;
+                case ColumnType::Hex:       fwprintf(fp, L"0x%0*llX", desc.mHexWidth, reader->GetUInt(i, row)); break;
+                case ColumnType::Double:    fwprintf(fp, L"%.*lf", desc.mPrecision, reader->GetDouble(i, row)); break;
+                case ColumnType::Timestamp: WriteTimestamp(fp, timing, desc, reader->GetUInt(i, row)); break;
+                case ColumnType::String:    fwprintf(fp, L"%s", wideStrings[i][reader->GetUInt(i, row)].c_str()); break;
+                }
+            }
+            fwprintf(fp, L"\n");
+        }
+        rowCount += reader->GetChunkRowCount();
+    }
+
+    return reader->IsCorrupt() ? -1 : rowCount;
+}
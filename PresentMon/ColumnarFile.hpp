@@ -0,0 +1,188 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+/*
+Columnar capture format (.pmcol)
+
+An alternative to CSV output for long, high frame rate captures.  Frames are
+buffered into chunks of rows and each chunk is written column by column:
+
+    File header:  magic, version, session timing, column descriptors
+    Chunk:        row count, then for each column:
+                      byte size of the column block (so readers can skip it)
+                      validity bitmap (nullable columns only)
+                      valid count and min/max statistics (numeric columns only)
+                      encoded values
+
+Values are typed rather than text: integers are varint encoded, timestamps are
+delta+varint encoded, doubles are stored raw, and strings (e.g., Application,
+PresentMode, Runtime) are dictionary encoded with new dictionary entries
+carried in the chunk where they first appear.
+
+Timestamps are stored as raw QPC values together with the session timing, so
+a reader can render them in any of the CSV time units.  WriteColumnarAsCsv()
+reproduces the CSV that PresentMon would have written for the same capture.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class ColumnType : uint8_t {
+    Int,        // signed integer
+    UInt,       // unsigned integer
+    Hex,        // unsigned integer, rendered as hex
+    Double,     // floating point, rendered with ColumnDesc::mPrecision decimals
+    Timestamp,  // QPC timestamp, rendered according to ColumnDesc::mTimeRender
+    String,     // dictionary encoded UTF-8 string
+};
+
+// How a Timestamp column is rendered into CSV:
+enum class TimeRender : uint8_t {
+    None,
+    MilliSeconds,       // Milliseconds since the session started
+    Seconds,            // Seconds since the session started
+    Qpc,                // Raw QPC value
+    QpcMilliSeconds,    // QPC value converted into milliseconds
+    QpcSeconds,         // QPC value converted into seconds
+    DateTime,           // Local date and time with nanosecond precision
+};
+
+struct ColumnDesc {
+    std::string mName;
+    ColumnType mType;
+    TimeRender mTimeRender;
+    uint8_t mPrecision;     // Double/Timestamp: number of decimals
+    uint8_t mHexWidth;      // Hex: zero-padded digit count (0 for no padding)
+    bool mNullable;         // Column may contain NA values
+};
+
+// Session timing, enough to convert QPC timestamps the same way PMTraceSession does.
+struct ColumnarTiming {
+    uint64_t mStartTimestamp;
+    uint64_t mTimestampFrequency;
+    uint64_t mStartFileTime;
+    uint32_t mTimestampType;    // PMTraceSession::TimestampType
+};
+
+// Min/max of the valid values in one column of a chunk.  Integer and
+// Timestamp columns use the integer members, Double columns use the double
+// members.
+struct ColumnStats {
+    uint32_t mValidCount;
+    union { int64_t mMinInt; uint64_t mMinUInt; double mMinDouble; };
+    union { int64_t mMaxInt; uint64_t mMaxUInt; double mMaxDouble; };
+};
+
+class ColumnarWriter {
+public:
+    static constexpr uint32_t kChunkRows = 4096;
+
+    ColumnarWriter() = default;
+    ColumnarWriter(ColumnarWriter const&) = delete;
+    ColumnarWriter& operator=(ColumnarWriter const&) = delete;
+    ~ColumnarWriter();
+
+    bool Open(wchar_t const* path, ColumnarTiming const& timing, std::vector<ColumnDesc> columns);
+    void Close();
+
+    // Values are appended left to right, one call per column, followed by EndRow().
+    void AppendInt(int64_t value);
+    void AppendUInt(uint64_t value);
+    void AppendDouble(double value);
+    void AppendTimestamp(uint64_t value);
+    void AppendString(char const* value);
+    void AppendString(std::wstring const& value);
+    void AppendNA();
+    void EndRow();
+
+    uint64_t GetRowCount() const { return mRowCount; }
+    uint64_t GetBytesWritten() const { return mBytesWritten; }
+
+private:
+    struct Column {
+        ColumnDesc mDesc;
+        std::vector<uint64_t> mValues;      // Raw value bits (or dictionary index) per valid row
+        std::vector<uint8_t> mValidity;     // Bit per row
+        bool mHasNA;
+        std::unordered_map<std::string, uint32_t> mDictionary;
+        std::vector<uint32_t> mNewEntries;  // Dictionary indices first seen in this chunk
+        std::vector<std::string const*> mEntries;
+    };
+
+    Column* NextColumn();
+    void Append(uint64_t bits);
+    void AppendDictionary(std::string const& key);
+    void FlushChunk();
+    void EncodeColumn(Column* column, std::vector<uint8_t>* out);
+    void Write(void const* data, size_t size);
+
+    FILE* mFile = nullptr;
+    std::vector<Column> mColumns;
+    std::vector<uint8_t> mEncoded;
+    std::string mKey;
+    uint32_t mNextColumn = 0;
+    uint32_t mChunkRowCount = 0;
+    uint64_t mRowCount = 0;
+    uint64_t mBytesWritten = 0;
+};
+
+class ColumnarReader {
+public:
+    ColumnarReader() = default;
+    ColumnarReader(ColumnarReader const&) = delete;
+    ColumnarReader& operator=(ColumnarReader const&) = delete;
+    ~ColumnarReader();
+
+    bool Open(wchar_t const* path);
+    void Close();
+
+    std::vector<ColumnDesc> const& GetColumns() const { return mColumnDescs; }
+    ColumnarTiming const& GetTiming() const { return mTiming; }
+
+    // Decode the next chunk.  Returns false at the end of the file, or if the
+    // file is corrupt (in which case IsCorrupt() returns true).
+    bool ReadChunk();
+    bool IsCorrupt() const { return mCorrupt; }
+
+    uint32_t GetChunkRowCount() const { return mChunkRowCount; }
+    ColumnStats const& GetChunkStats(size_t column) const { return mColumns[column].mStats; }
+
+    bool IsValid(size_t column, uint32_t row) const;
+    int64_t GetInt(size_t column, uint32_t row) const { return (int64_t) mColumns[column].mValues[row]; }
+    uint64_t GetUInt(size_t column, uint32_t row) const { return mColumns[column].mValues[row]; }
+    double GetDouble(size_t column, uint32_t row) const;
+    std::string const& GetString(size_t column, uint32_t row) const;
+
+    // All dictionary entries of a String column seen so far (GetUInt() returns
+    // a row's index into this).
+    std::vector<std::string> const& GetDictionary(size_t column) const { return mColumns[column].mDictionary; }
+
+private:
+    struct Column {
+        std::vector<uint64_t> mValues;      // Indexed by row (NA rows are 0)
+        std::vector<uint8_t> mValidity;     // Empty if there are no NA rows in the chunk
+        std::vector<std::string> mDictionary;
+        ColumnStats mStats;
+    };
+
+    bool DecodeColumn(size_t column, uint8_t const* data, size_t size);
+
+    FILE* mFile = nullptr;
+    ColumnarTiming mTiming = {};
+    std::vector<ColumnDesc> mColumnDescs;
+    std::vector<Column> mColumns;
+    std::vector<uint8_t> mBlock;
+    uint32_t mChunkRowCount = 0;
+    bool mCorrupt = false;
+};
+
+// Write the remaining chunks of reader as CSV, in the same format PresentMon
+// writes CSV output.  fp should be opened the same way PresentMon opens CSV
+// files (i.e., "w,ccs=UTF-8").  Returns the number of rows written, or -1 if
+// the file is corrupt.
+int64_t WriteColumnarAsCsv(ColumnarReader* reader, FILE* fp);
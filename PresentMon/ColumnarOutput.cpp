@@ -0,0 +1,358 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "PresentMon.hpp"
+#include "ColumnarFile.hpp"
+
+static ColumnarWriter* gGlobalOutputColumnar = nullptr;
+
+/* The columns, and how each is rendered back into CSV, mirror WriteCsvHeader()
+   and WriteCsvRow() in CsvOutput.cpp; modify both if there are changes.
+*/
+static ColumnDesc StringColumn(char const* name)
+{
+    return ColumnDesc{ name, ColumnType::String, TimeRender::None, 0, 0, false };
+}
+
+static ColumnDesc IntColumn(char const* name)
+{
+    return ColumnDesc{ name, ColumnType::Int, TimeRender::None, 0, 0, false };
+}
+
+static ColumnDesc UIntColumn(char const* name)
+{
+    return ColumnDesc{ name, ColumnType::UInt, TimeRender::None, 0, 0, false };
+}
+
+static ColumnDesc HexColumn(char const* name, uint8_t width)
+{
+    return ColumnDesc{ name, ColumnType::Hex, TimeRender::None, 0, width, false };
+}
+
+static ColumnDesc DoubleColumn(char const* name, uint8_t precision, bool nullable = false)
+{
+    return ColumnDesc{ name, ColumnType::Double, TimeRender::None, precision, 0, nullable };
+}
+
+static ColumnDesc TimestampColumn(char const* name, TimeRender render, uint8_t precision, bool nullable = false)
+{
+    return ColumnDesc{ name, ColumnType::Timestamp, render, precision, 0, nullable };
+}
+
+template<typename FrameMetricsT>
+std::vector<ColumnDesc> GetColumnarColumns();
+
+template<typename FrameMetricsT>
+void WriteColumnarRow(ColumnarWriter* writer, ProcessInfo const& processInfo, PresentEvent const& p, FrameMetricsT const& metrics);
+
+template<>
+std::vector<ColumnDesc> GetColumnarColumns<FrameMetrics1>()
+{
+    auto const& args = GetCommandLineArgs();
+
+    std::vector<ColumnDesc> columns;
+    columns.push_back(StringColumn("Application"));
+    columns.push_back(IntColumn("ProcessID"));
+    columns.push_back(HexColumn("SwapChainAddress", 16));
+    columns.push_back(StringColumn("Runtime"));
+    columns.push_back(IntColumn("SyncInterval"));
+    columns.push_back(IntColumn("PresentFlags"));
+    columns.push_back(StringColumn("Dropped"));
+    columns.push_back(args.mTimeUnit == TimeUnit::DateTime
+        ? TimestampColumn("TimeInSeconds", TimeRender::DateTime, 0)
+        : TimestampColumn("TimeInSeconds", TimeRender::Seconds, DBL_DIG - 1));
+    columns.push_back(DoubleColumn("msInPresentAPI", DBL_DIG - 1));
+    columns.push_back(DoubleColumn("msBetweenPresents", DBL_DIG - 1));
+    if (args.mTrackDisplay) {
+        columns.push_back(IntColumn("AllowsTearing"));
+        columns.push_back(StringColumn("PresentMode"));
+        columns.push_back(DoubleColumn("msUntilRenderComplete", DBL_DIG - 1));
+        columns.push_back(DoubleColumn("msUntilDisplayed", DBL_DIG - 1));
+        columns.push_back(DoubleColumn("msBetweenDisplayChange", DBL_DIG - 1));
+    }
+    if (args.mTrackGPU) {
+        columns.push_back(DoubleColumn("msUntilRenderStart", DBL_DIG - 1));
+        columns.push_back(DoubleColumn("msGPUActive", DBL_DIG - 1));
+    }
+    if (args.mTrackGPUVideo) {
+        columns.push_back(DoubleColumn("msGPUVideoActive", DBL_DIG - 1));
+    }
+    if (args.mTrackInput) {
+        columns.push_back(DoubleColumn("msSinceInput", DBL_DIG - 1));
+    }
+    switch (args.mTimeUnit) {
+    case TimeUnit::QPC:             columns.push_back(TimestampColumn("QPCTime", TimeRender::Qpc, 0)); break;
+    case TimeUnit::QPCMilliSeconds: columns.push_back(TimestampColumn("QPCTime", TimeRender::QpcSeconds, DBL_DIG - 1)); break;
+    }
+    if (args.mWriteDisplayTime) {
+        columns.push_back(TimestampColumn("msDisplayTime", TimeRender::Seconds, DBL_DIG - 1, true));
+    }
+    if (args.mWriteFrameId) {
+        columns.push_back(UIntColumn("FrameId"));
+    }
+    return columns;
+}
+
+template<>
+void WriteColumnarRow<FrameMetrics1>(
+    ColumnarWriter* writer,
+    ProcessInfo const& processInfo,
+    PresentEvent const& p,
+    FrameMetrics1 const& metrics)
+{
+    auto const& args = GetCommandLineArgs();
+
+    writer->AppendString(processInfo.mModuleName);
+    writer->AppendInt((int32_t) p.ProcessId);
+    writer->AppendUInt(p.SwapChainAddress);
+    writer->AppendString(RuntimeToString(p.Runtime));
+    writer->AppendInt(p.SyncInterval);
+    writer->AppendInt((int32_t) p.PresentFlags);
+    writer->AppendString(FinalStateToDroppedString(p.FinalState));
+    writer->AppendTimestamp(p.PresentStartTime);
+    writer->AppendDouble(metrics.msInPresentApi);
+    writer->AppendDouble(metrics.msBetweenPresents);
+    if (args.mTrackDisplay) {
+        writer->AppendInt(p.SupportsTearing);
+        writer->AppendString(PresentModeToString(p.PresentMode));
+        writer->AppendDouble(metrics.msUntilRenderComplete);
+        writer->AppendDouble(metrics.msUntilDisplayed);
+        writer->AppendDouble(metrics.msBetweenDisplayChange);
+    }
+    if (args.mTrackGPU) {
+        writer->AppendDouble(metrics.msUntilRenderStart);
+        writer->AppendDouble(metrics.msGPUDuration);
+    }
+    if (args.mTrackGPUVideo) {
+        writer->AppendDouble(metrics.msVideoDuration);
+    }
+    if (args.mTrackInput) {
+        writer->AppendDouble(metrics.msSinceInput);
+    }
+    if (args.mTimeUnit == TimeUnit::QPC || args.mTimeUnit == TimeUnit::QPCMilliSeconds) {
+        writer->AppendTimestamp(p.PresentStartTime);
+    }
+    if (args.mWriteDisplayTime) {
+        if (metrics.qpcScreenTime == 0) {
+            writer->AppendNA();
+        } else {
+            writer->AppendTimestamp(metrics.qpcScreenTime);
+        }
+    }
+    if (args.mWriteFrameId) {
+        writer->AppendUInt(p.FrameId);
+    }
+    writer->EndRow();
+}
+
+template<>
+std::vector<ColumnDesc> GetColumnarColumns<FrameMetrics>()
+{
+    auto const& args = GetCommandLineArgs();
+
+    std::vector<ColumnDesc> columns;
+    columns.push_back(StringColumn("Application"));
+    columns.push_back(IntColumn("ProcessID"));
+    columns.push_back(HexColumn("SwapChainAddress", 0));
+    columns.push_back(StringColumn("PresentRuntime"));
+    columns.push_back(IntColumn("SyncInterval"));
+    columns.push_back(IntColumn("PresentFlags"));
+    if (args.mTrackDisplay) {
+        columns.push_back(IntColumn("AllowsTearing"));
+        columns.push_back(StringColumn("PresentMode"));
+    }
+    if (args.mTrackFrameType) {
+        columns.push_back(StringColumn("FrameType"));
+    }
+    if (args.mTrackHybridPresent) {
+        columns.push_back(IntColumn("HybridPresent"));
+    }
+    switch (args.mTimeUnit) {
+    case TimeUnit::MilliSeconds:    columns.push_back(TimestampColumn("CPUStartTime", TimeRender::MilliSeconds, 4)); break;
+    case TimeUnit::QPC:             columns.push_back(TimestampColumn("CPUStartQPC", TimeRender::Qpc, 0)); break;
+    case TimeUnit::QPCMilliSeconds: columns.push_back(TimestampColumn("CPUStartQPCTime", TimeRender::QpcMilliSeconds, 4)); break;
+    case TimeUnit::DateTime:        columns.push_back(TimestampColumn("CPUStartDateTime", TimeRender::DateTime, 0)); break;
+    }
+    columns.push_back(DoubleColumn("FrameTime", 4));
+    columns.push_back(DoubleColumn("CPUBusy", 4));
+    columns.push_back(DoubleColumn("CPUWait", 4));
+    if (args.mTrackGPU) {
+        columns.push_back(DoubleColumn("GPULatency", 4));
+        columns.push_back(DoubleColumn("GPUTime", 4));
+        columns.push_back(DoubleColumn("GPUBusy", 4));
+        columns.push_back(DoubleColumn("GPUWait", 4));
+    }
+    if (args.mTrackGPUVideo) {
+        columns.push_back(DoubleColumn("VideoBusy", 4));
+    }
+    if (args.mTrackDisplay) {
+        columns.push_back(DoubleColumn("DisplayLatency", 4, true));
+        columns.push_back(DoubleColumn("DisplayedTime", 4, true));
+        columns.push_back(DoubleColumn("AnimationError", 4, true));
+        columns.push_back(DoubleColumn("AnimationTime", 4, true));
+    }
+    if (args.mTrackInput) {
+        columns.push_back(DoubleColumn("AllInputToPhotonLatency", 4, true));
+        columns.push_back(DoubleColumn("ClickToPhotonLatency", 4, true));
+    }
+    if (args.mTrackAppTiming) {
+        columns.push_back(DoubleColumn("InstrumentedLatency", 4, true));
+    }
+    if (args.mWriteDisplayTime) {
+        columns.push_back(TimestampColumn("DisplayTimeAbs", TimeRender::MilliSeconds, 4, true));
+    }
+    if (args.mWriteFrameId) {
+        columns.push_back(UIntColumn("FrameId"));
+        if (args.mTrackAppTiming) {
+            columns.push_back(UIntColumn("AppFrameId"));
+        }
+    }
+    return columns;
+}
+
+static void AppendDoubleOrNA(ColumnarWriter* writer, double value)
+{
+    if (value == 0.0) {
+        writer->AppendNA();
+    } else {
+        writer->AppendDouble(value);
+    }
+}
+
+template<>
+void WriteColumnarRow<FrameMetrics>(
+    ColumnarWriter* writer,
+    ProcessInfo const& processInfo,
+    PresentEvent const& p,
+    FrameMetrics const& metrics)
+{
+    auto const& args = GetCommandLineArgs();
+
+    writer->AppendString(processInfo.mModuleName);
+    writer->AppendInt((int32_t) p.ProcessId);
+    writer->AppendUInt(p.SwapChainAddress);
+    writer->AppendString(RuntimeToString(p.Runtime));
+    writer->AppendInt(p.SyncInterval);
+    writer->AppendInt((int32_t) p.PresentFlags);
+    if (args.mTrackDisplay) {
+        writer->AppendInt(p.SupportsTearing);
+        writer->AppendString(PresentModeToString(p.PresentMode));
+    }
+    if (args.mTrackFrameType) {
+        writer->AppendString(FrameTypeToString(metrics.mFrameType));
+    }
+    if (args.mTrackHybridPresent) {
+        writer->AppendInt(p.IsHybridPresent);
+    }
+    writer->AppendTimestamp(metrics.mCPUStart);
+    writer->AppendDouble(metrics.mCPUBusy + metrics.mCPUWait);
+    writer->AppendDouble(metrics.mCPUBusy);
+    writer->AppendDouble(metrics.mCPUWait);
+    if (args.mTrackGPU) {
+        writer->AppendDouble(metrics.mGPULatency);
+        writer->AppendDouble(metrics.mGPUBusy + metrics.mGPUWait);
+        writer->AppendDouble(metrics.mGPUBusy);
+        writer->AppendDouble(metrics.mGPUWait);
+    }
+    if (args.mTrackGPUVideo) {
+        writer->AppendDouble(metrics.mVideoBusy);
+    }
+    if (args.mTrackDisplay) {
+        if (metrics.mDisplayedTime == 0.0) {
+            writer->AppendNA();
+            writer->AppendNA();
+            writer->AppendNA();
+            writer->AppendNA();
+        } else {
+            writer->AppendDouble(metrics.mDisplayLatency);
+            writer->AppendDouble(metrics.mDisplayedTime);
+            writer->AppendDouble(metrics.mAnimationError);
+            writer->AppendDouble(metrics.mAnimationTime);
+        }
+    }
+    if (args.mTrackInput) {
+        AppendDoubleOrNA(writer, metrics.mAllInputPhotonLatency);
+        AppendDoubleOrNA(writer, metrics.mClickToPhotonLatency);
+    }
+    if (args.mTrackAppTiming) {
+        AppendDoubleOrNA(writer, metrics.mInstrumentedLatency);
+    }
+    if (args.mWriteDisplayTime) {
+        if (metrics.mScreenTime == 0) {
+            writer->AppendNA();
+        } else {
+            writer->AppendTimestamp(metrics.mScreenTime);
+        }
+    }
+    if (args.mWriteFrameId) {
+        writer->AppendUInt(p.FrameId);
+        if (args.mTrackAppTiming) {
+            writer->AppendUInt(p.AppFrameId);
+        }
+    }
+    writer->EndRow();
+}
+
+template<typename FrameMetricsT>
+void UpdateColumnarT(
+    PMTraceSession const& pmSession,
+    ProcessInfo* processInfo,
+    PresentEvent const& p,
+    FrameMetricsT const& metrics)
+{
+    auto const& args = GetCommandLineArgs();
+
+    // Get/create file
+    ColumnarWriter** writer = args.mMultiCsv
+        ? &processInfo->mOutputColumnar
+        : &gGlobalOutputColumnar;
+
+    if (*writer == nullptr) {
+        ColumnarTiming timing = {};
+        timing.mStartTimestamp     = pmSession.mStartTimestamp.QuadPart;
+        timing.mTimestampFrequency = pmSession.mTimestampFrequency.QuadPart;
+        timing.mStartFileTime      = pmSession.mStartFileTime;
+        timing.mTimestampType      = pmSession.mTimestampType;
+
+        wchar_t path[MAX_PATH];
+        GenerateFilename(path, processInfo->mModuleName, p.ProcessId, L".pmcol");
+
+        *writer = new ColumnarWriter;
+        if (!(*writer)->Open(path, timing, GetColumnarColumns<FrameMetricsT>())) {
+            delete *writer;
+            *writer = nullptr;
+            return;
+        }
+    }
+
+    WriteColumnarRow(*writer, *processInfo, p, metrics);
+}
+
+void UpdateColumnar(PMTraceSession const& pmSession, ProcessInfo* processInfo, PresentEvent const& p, FrameMetrics1 const& metrics)
+{
+    UpdateColumnarT(pmSession, processInfo, p, metrics);
+}
+
+void UpdateColumnar(PMTraceSession const& pmSession, ProcessInfo* processInfo, PresentEvent const& p, FrameMetrics const& metrics)
+{
+    UpdateColumnarT(pmSession, processInfo, p, metrics);
+}
+
+static void CloseColumnar(ColumnarWriter** writer)
+{
+    if (*writer != nullptr) {
+        (*writer)->Close();
+        delete *writer;
+        *writer = nullptr;
+    }
+}
+
+void CloseMultiColumnar(ProcessInfo* processInfo)
+{
+    CloseColumnar(&processInfo->mOutputColumnar);
+}
+
+void CloseGlobalColumnar()
+{
+    CloseColumnar(&gGlobalOutputColumnar);
+}
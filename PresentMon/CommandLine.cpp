@@ -264,16 +264,17 @@ void PrintUsage()
         LR"(--etl_file path)",     LR"(Analyze an ETW trace log file instead of the actively running processes.)",
 
         LR"(--Output Options)", nullptr,
-        LR"(--output_file path)", LR"(Write CSV output to the specified path.)",
-        LR"(--output_stdout)",    LR"(Write CSV output to STDOUT.)",
-        LR"(--multi_csv)",        LR"(Create a separate CSV file for each captured process.)",
-        LR"(--no_csv)",           LR"(Do not create any output CSV file.)",
-        LR"(--no_console_stats)", LR"(Do not display active swap chains and frame statistics in the console.)",
-        LR"(--qpc_time)",         LR"(Output the CPU start time as a performance counter value.)",
-        LR"(--qpc_time_ms)",      LR"(Output the CPU start time as a performance counter value converted to milliseconds.)",
-        LR"(--date_time)",        LR"(Output the CPU start time as a date and time with nanosecond precision.)",
-        LR"(--exclude_dropped)",  LR"(Exclude frames that were not displayed to the screen from the CSV output.)",
-        LR"(--v1_metrics)",       LR"(Output a CSV using PresentMon 1.x metrics.)",
+        LR"(--output_file path)",  LR"(Write CSV output to the specified path.)",
+        LR"(--output_stdout)",     LR"(Write CSV output to STDOUT.)",
+        LR"(--output_format fmt)", LR"(Write output files in the specified format: 'csv' (default) or 'columnar'. Columnar files are smaller and cheaper to write for long captures, and can be converted to CSV with Tools\pm_columnar_to_csv.)",
+        LR"(--multi_csv)",         LR"(Create a separate CSV file for each captured process.)",
+        LR"(--no_csv)",            LR"(Do not create any output CSV file.)",
+        LR"(--no_console_stats)",  LR"(Do not display active swap chains and frame statistics in the console.)",
+        LR"(--qpc_time)",          LR"(Output the CPU start time as a performance counter value.)",
+        LR"(--qpc_time_ms)",       LR"(Output the CPU start time as a performance counter value converted to milliseconds.)",
+        LR"(--date_time)",         LR"(Output the CPU start time as a date and time with nanosecond precision.)",
+        LR"(--exclude_dropped)",   LR"(Exclude frames that were not displayed to the screen from the CSV output.)",
+        LR"(--v1_metrics)",        LR"(Output a CSV using PresentMon 1.x metrics.)",
 
         LR"(--Recording Options)", nullptr,
         LR"(--hotkey key)",       LR"(Use the specified key press to start and stop recording. 'key' is of the form MODIFIER+KEY, e.g., "ALT+SHIFT+F11".)",
@@ -298,6 +299,8 @@ void PrintUsage()
         LR"(--track_hw_measurements)", LR"(Tracks HW-measured latency and/or power data coming from a LMT and/or PCAT device.)",
         LR"(--track_app_timing)", LR"(Track app times for each displayed frame; requires application and/or driver instrumentation using Intel-PresentMon provider.)",
         LR"(--track_hybrid_present)", LR"(Tracks if the present is a hybrid present and is performing a cross adapter copy.)",
+        LR"(--gpu_engine_timeline path)", LR"(Write the time each GPU engine spent running each process' work to the specified CSV file, for the whole capture.)",
+        LR"(--gpu_engine_timeline_ms ms)", LR"(The duration of each --gpu_engine_timeline row, in milliseconds (default: 10).)",
     };
 
     // Layout
@@ -378,11 +381,14 @@ bool ParseCommandLine(int argc, wchar_t** argv)
     args->mOutputCsvFileName = nullptr;
     args->mEtlFileName = nullptr;
     args->mSessionName = L"PresentMon";
+    args->mGpuEngineTimelineFileName = nullptr;
     args->mTargetPid = 0;
     args->mDelay = 0;
     args->mTimer = 0;
     args->mHotkeyModifiers = MOD_NOREPEAT;
     args->mHotkeyVirtualKeyCode = 0;
+    args->mGpuEngineTimelineResolution = 10;
+    args->mOutputFormat = OutputFormat::CSV;
     args->mConsoleOutput = ConsoleOutput::Statistics;
     args->mTrackDisplay = true;
     args->mTrackInput = true;
@@ -413,6 +419,7 @@ bool ParseCommandLine(int argc, wchar_t** argv)
     bool qpcTime         = false;
     bool qpcmsTime       = false;
     bool dtTime          = false;
+    wchar_t const* outputFormat = nullptr;
 
     #if PRESENTMON_ENABLE_DEBUG_TRACE
     bool verboseTrace = false;
@@ -431,6 +438,7 @@ bool ParseCommandLine(int argc, wchar_t** argv)
         // Output options:
         else if (ParseArg(argv[i], L"output_file"))      { if (ParseValue(argv, argc, &i, &args->mOutputCsvFileName)) continue; }
         else if (ParseArg(argv[i], L"output_stdout"))    { csvOutputStdout       = true;                              continue; }
+        else if (ParseArg(argv[i], L"output_format"))    { if (ParseValue(argv, argc, &i, &outputFormat))             continue; }
         else if (ParseArg(argv[i], L"multi_csv"))        { args->mMultiCsv       = true;                              continue; }
         else if (ParseArg(argv[i], L"no_csv"))           { csvOutputNone         = true;                              continue; }
         else if (ParseArg(argv[i], L"no_console_stats")) { args->mConsoleOutput  = ConsoleOutput::Simple;             continue; }
@@ -463,6 +471,8 @@ bool ParseCommandLine(int argc, wchar_t** argv)
         else if (ParseArg(argv[i], L"track_hw_measurements")) { args->mTrackPMMeasurements = true; continue; }
         else if (ParseArg(argv[i], L"track_app_timing"))      { args->mTrackAppTiming      = true; continue; }
         else if (ParseArg(argv[i], L"track_hybrid_present"))  { args->mTrackHybridPresent  = true; continue; }
+        else if (ParseArg(argv[i], L"gpu_engine_timeline"))    { if (ParseValue(argv, argc, &i, &args->mGpuEngineTimelineFileName))   continue; }
+        else if (ParseArg(argv[i], L"gpu_engine_timeline_ms")) { if (ParseValue(argv, argc, &i, &args->mGpuEngineTimelineResolution)) continue; }
 
         // Hidden options:
         #if PRESENTMON_ENABLE_DEBUG_TRACE
@@ -492,6 +502,18 @@ bool ParseCommandLine(int argc, wchar_t** argv)
         return false;
     }
 
+    // Validate --output_format.
+    if (outputFormat != nullptr) {
+        if (_wcsicmp(outputFormat, L"columnar") == 0) {
+            args->mOutputFormat = OutputFormat::Columnar;
+        } else if (_wcsicmp(outputFormat, L"csv") != 0) {
+            PrintError(L"error: invalid --output_format: %s\n", outputFormat);
+            PrintError(L"       valid options: csv columnar\n");
+            PrintUsage();
+            return false;
+        }
+    }
+
     // Disallow --hotkey that are known to be already in use:
     // - CTRL+C, CTRL+PAUSE, and CTRL+SCROLLLOCK already used to exit PresentMon
     // - F12 is reserved for debugger use at all times
@@ -534,6 +556,11 @@ bool ParseCommandLine(int argc, wchar_t** argv)
     if (csvOutputStdout) {
         args->mConsoleOutput = ConsoleOutput::None;
 
+        if (args->mOutputFormat == OutputFormat::Columnar) {
+            PrintWarning(L"warning: ignoring --output_format columnar due to --output_stdout.\n");
+            args->mOutputFormat = OutputFormat::CSV;
+        }
+
         if (args->mMultiCsv) {
             PrintWarning(L"warning: ignoring --multi_csv due to --output_stdout.\n");
             args->mMultiCsv = false;
@@ -546,6 +573,16 @@ bool ParseCommandLine(int argc, wchar_t** argv)
         args->mTrackGPUVideo = false;
     }
 
+    // Ignore --gpu_engine_timeline if --no_track_gpu used
+    if (args->mGpuEngineTimelineFileName != nullptr && !args->mTrackGPU) {
+        PrintWarning(L"warning: ignoring --gpu_engine_timeline due to --no_track_gpu.\n");
+        args->mGpuEngineTimelineFileName = nullptr;
+    }
+    if (args->mGpuEngineTimelineResolution == 0) {
+        PrintWarning(L"warning: --gpu_engine_timeline_ms must be at least 1; using 1.\n");
+        args->mGpuEngineTimelineResolution = 1;
+    }
+
     // Ignore --no_track_display if required for other requested tracking
     if (!args->mTrackDisplay && args->mTrackGPU) {
         PrintWarning(L"warning: ignoring --no_track_display because display tracking is required when GPU tracking is enabled.\n");
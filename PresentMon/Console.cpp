@@ -306,6 +306,45 @@ void UpdateConsole(uint32_t processId, ProcessInfo const& processInfo)
     }
 }
 
+void UpdateConsoleInstrumentation(PMTraceConsumer const* pmConsumer)
+{
+    // Only available if PresentData was built with PRESENTMON_ENABLE_CONSUMER_INSTRUMENTATION=1
+    ConsumerInstrumentationSnapshot snapshot;
+    if (!pmConsumer->GetInstrumentationSnapshot(&snapshot)) {
+        return;
+    }
+
+    ConsolePrintLn(L"Consumer handlers:          events     avg cycles     max cycles");
+    for (uint32_t i = 0; i < (uint32_t) InstrumentedHandler::Count; ++i) {
+        auto const& h = snapshot.mHandlers[i];
+        if (h.mEventCount > 0) {
+            ConsolePrintLn(L"    %-26hs %10llu %14llu %14llu",
+                GetInstrumentedHandlerName((InstrumentedHandler) i),
+                h.mEventCount,
+                h.mTotalCycles / h.mEventCount,
+                h.mMaxCycles);
+        }
+    }
+
+    ConsolePrint(L"Presents: created=%llu completed=%llu dropped=%llu lost:",
+        snapshot.mPresentsCreated,
+        snapshot.mPresentsCompleted,
+        snapshot.mPresentsDroppedOnOverflow);
+    for (uint32_t i = 0; i < (uint32_t) PresentLostReason::Count; ++i) {
+        ConsolePrint(L" %hs=%llu", GetPresentLostReasonName((PresentLostReason) i), snapshot.mPresentsLost[i]);
+    }
+    ConsolePrintLn(L"");
+
+    ConsolePrint(L"Containers:");
+    for (uint32_t i = 0; i < (uint32_t) InstrumentedContainer::Count; ++i) {
+        if (snapshot.mContainerSizes[i] > 0) {
+            ConsolePrint(L" %hs=%llu", GetInstrumentedContainerName((InstrumentedContainer) i), snapshot.mContainerSizes[i]);
+        }
+    }
+    ConsolePrintLn(L"");
+    ConsolePrintLn(L"");
+}
+
 static int PrintColor(WORD color, wchar_t const* format, va_list val)
 {
     #ifndef NDEBUG
@@ -59,7 +59,7 @@ const char* FrameTypeToString(FrameType ft)
 }
 
 // v1.x only:
-static const char* FinalStateToDroppedString(PresentResult res)
+const char* FinalStateToDroppedString(PresentResult res)
 {
     switch (res) {
     case PresentResult::Presented: return "0";
@@ -82,7 +82,7 @@ with `-INDEX` appended to the file name.
 If `-include_mixed_reality` is used, a second CSV file will be generated with
 `_WMR` appended to the filename containing the WMR data.
 */
-static void GenerateFilename(wchar_t* path, std::wstring const& processName, uint32_t processId)
+void GenerateFilename(wchar_t* path, std::wstring const& processName, uint32_t processId, wchar_t const* defaultExt)
 {
     auto const& args = GetCommandLineArgs();
 
@@ -108,7 +108,7 @@ static void GenerateFilename(wchar_t* path, std::wstring const& processName, uin
         time_t time_now = time(NULL);
         localtime_s(&tm, &time_now);
         ADD_TO_PATH(L"PresentMon-%4d-%02d-%02dT%02d%02d%02d", tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
-        wcscpy_s(ext, L".csv");
+        wcscpy_s(ext, defaultExt);
     }
 
     // Append -PROCESSNAME if applicable.
@@ -469,6 +469,12 @@ void UpdateCsvT(
         return;
     }
 
+    // Columnar output is written instead of CSV (if requested).
+    if (args.mOutputFormat == OutputFormat::Columnar) {
+        UpdateColumnar(pmSession, processInfo, p, metrics);
+        return;
+    }
+
     // Get/create file
     FILE** fp = args.mMultiCsv
         ? &processInfo->mOutputCsv
@@ -477,7 +483,7 @@ void UpdateCsvT(
     if (*fp == nullptr) {
         if (args.mCSVOutput == CSVOutput::File) {
             wchar_t path[MAX_PATH];
-            GenerateFilename(path, processInfo->mModuleName, p.ProcessId);
+            GenerateFilename(path, processInfo->mModuleName, p.ProcessId, L".csv");
             if (_wfopen_s(fp, path, L"w,ccs=UTF-8")) {
                 return;
             }
@@ -515,10 +521,12 @@ static void CloseCsv(FILE** fp)
 void CloseMultiCsv(ProcessInfo* processInfo)
 {
     CloseCsv(&processInfo->mOutputCsv);
+    CloseMultiColumnar(processInfo);
 }
 
 void CloseGlobalCsv()
 {
     CloseCsv(&gGlobalOutputCsv);
+    CloseGlobalColumnar();
 }
 
@@ -0,0 +1,67 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "GpuEngineTimeline.hpp"
+
+#include <algorithm>
+
+GpuEngineTimeline::GpuEngineTimeline(uint64_t startTime, uint64_t binDuration, uint64_t flushDelay)
+    : mStartTime(startTime)
+    , mBinDuration(binDuration == 0 ? 1 : binDuration)
+    , mFlushDelay(flushDelay)
+    , mLatestEndTime(0)
+    , mFlushedBinCount(0)
+{
+}
+
+void GpuEngineTimeline::Add(GpuBusyInterval const& interval)
+{
+    if (interval.mEndTime <= interval.mStartTime || interval.mEndTime <= mStartTime) {
+        return;
+    }
+
+    // Work relative to mStartTime.
+    auto endTime = interval.mEndTime - mStartTime;
+    auto startTime = interval.mStartTime > mStartTime ? interval.mStartTime - mStartTime : 0;
+    startTime = std::max(startTime, mFlushedBinCount * mBinDuration);
+
+    mLatestEndTime = std::max(mLatestEndTime, endTime);
+
+    for (auto binIndex = startTime / mBinDuration; binIndex * mBinDuration < endTime; ++binIndex) {
+        auto binStart = binIndex * mBinDuration;
+        auto busyTime = std::min(endTime, binStart + mBinDuration) - std::max(startTime, binStart);
+
+        auto entries = &mBins[binIndex];
+        auto ii = std::find_if(entries->begin(), entries->end(), [&](Entry const& e) {
+            return e.mEngineId == interval.mEngineId && e.mProcessId == interval.mProcessId;
+        });
+        if (ii == entries->end()) {
+            entries->push_back({ interval.mEngineId, interval.mProcessId, busyTime });
+        } else {
+            ii->mBusyTime += busyTime;
+        }
+    }
+}
+
+void GpuEngineTimeline::Flush(bool flushAll, std::vector<Row>* rows)
+{
+    auto flushBinCount = mLatestEndTime > mFlushDelay ? (mLatestEndTime - mFlushDelay) / mBinDuration : 0;
+
+    auto ie = flushAll ? mBins.end() : mBins.lower_bound(flushBinCount);
+    for (auto ii = mBins.begin(); ii != ie; ++ii) {
+        auto entries = &ii->second;
+        std::sort(entries->begin(), entries->end(), [](Entry const& a, Entry const& b) {
+            return a.mEngineId != b.mEngineId ? a.mEngineId < b.mEngineId : a.mProcessId < b.mProcessId;
+        });
+        for (auto const& e : *entries) {
+            rows->push_back({ mStartTime + ii->first * mBinDuration, e.mEngineId, e.mProcessId, e.mBusyTime });
+        }
+    }
+
+    if (ie != mBins.begin()) {
+        auto lastFlushedBin = std::prev(ie)->first;
+        mFlushedBinCount = std::max(mFlushedBinCount, lastFlushedBin + 1);
+    }
+    mFlushedBinCount = std::max(mFlushedBinCount, flushBinCount);
+    mBins.erase(mBins.begin(), ie);
+}
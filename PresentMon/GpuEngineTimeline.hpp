@@ -0,0 +1,49 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+#pragma once
+#include <map>
+#include <stdint.h>
+#include <vector>
+
+#include "../PresentData/GpuBusyIntervals.hpp"
+
+// GpuEngineTimeline accumulates GPU busy intervals into fixed-duration time bins, per engine and
+// per process, for --gpu_engine_timeline output.
+//
+// Bins start at multiples of the bin duration after startTime, and any part of an interval before
+// startTime is ignored.  Since intervals are reported when their packet completes, a bin is only
+// flushed once the latest reported interval ends at least flushDelay after the bin ends.  Any part
+// of a later-reported interval that falls in an already-flushed bin is dropped.
+//
+// This class has no dependencies on Windows so that it can be tested standalone.
+class GpuEngineTimeline {
+public:
+    struct Row {
+        uint64_t mBinStart;     // QPC
+        uint32_t mEngineId;
+        uint32_t mProcessId;
+        uint64_t mBusyTime;     // QPC duration within the bin
+    };
+
+    GpuEngineTimeline(uint64_t startTime, uint64_t binDuration, uint64_t flushDelay);
+
+    void Add(GpuBusyInterval const& interval);
+
+    // Appends the rows of all bins that are ready to be flushed (or of all bins, if flushAll is
+    // true) to rows, ordered by bin, then engine, then process.
+    void Flush(bool flushAll, std::vector<Row>* rows);
+
+private:
+    struct Entry {
+        uint32_t mEngineId;
+        uint32_t mProcessId;
+        uint64_t mBusyTime;
+    };
+
+    uint64_t mStartTime;
+    uint64_t mBinDuration;
+    uint64_t mFlushDelay;
+    uint64_t mLatestEndTime;
+    uint64_t mFlushedBinCount;  // Bins with index less than this have been flushed
+    std::map<uint64_t, std::vector<Entry>> mBins;   // Bin index -> Entries
+};
@@ -0,0 +1,125 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "PresentMon.hpp"
+#include "GpuEngineTimeline.hpp"
+
+#include <memory>
+
+namespace {
+
+// Enough for several hundred milliseconds of busy GPU nodes between output thread updates.
+constexpr uint32_t kIntervalRingCapacity = 64 * 1024;
+
+// Bins are written once the latest interval is this many seconds past their end, so packets that
+// run longer than this are only partially reported.
+constexpr uint64_t kFlushDelaySeconds = 2;
+
+FILE* gTimelineFile = nullptr;
+std::unique_ptr<GpuBusyIntervalRing> gIntervalRing;
+std::unique_ptr<GpuEngineTimeline> gTimeline;
+std::vector<GpuBusyInterval> gIntervals;
+std::vector<GpuEngineTimeline::Row> gRows;
+std::vector<GpuEngineInfo> gEngines;
+
+char const* EngineTypeToString(uint32_t engineType)
+{
+    using namespace Microsoft_Windows_DxgKrnl;
+    switch ((DXGK_ENGINE) engineType) {
+    case DXGK_ENGINE::OTHER:            return "Other";
+    case DXGK_ENGINE::_3D:              return "3D";
+    case DXGK_ENGINE::VIDEO_DECODE:     return "VideoDecode";
+    case DXGK_ENGINE::VIDEO_ENCODE:     return "VideoEncode";
+    case DXGK_ENGINE::VIDEO_PROCESSING: return "VideoProcessing";
+    case DXGK_ENGINE::SCENE_ASSEMBLY:   return "SceneAssembly";
+    case DXGK_ENGINE::COPY:             return "Copy";
+    case DXGK_ENGINE::OVERLAY:          return "Overlay";
+    case DXGK_ENGINE::CRYPTO:           return "Crypto";
+    }
+    return "Unknown";
+}
+
+}
+
+bool OpenGpuEngineTimeline(PMTraceConsumer* pmConsumer)
+{
+    auto const& args = GetCommandLineArgs();
+
+    if (_wfopen_s(&gTimelineFile, args.mGpuEngineTimelineFileName, L"w")) {
+        gTimelineFile = nullptr;
+        return false;
+    }
+
+    fprintf(gTimelineFile, "TimeInSeconds,Adapter,NodeOrdinal,EngineType,ProcessID,BusyMs,Utilization\n");
+
+    gIntervalRing.reset(new GpuBusyIntervalRing(kIntervalRingCapacity));
+    pmConsumer->mGpuBusyIntervals = gIntervalRing.get();
+    return true;
+}
+
+void UpdateGpuEngineTimeline(PMTraceSession const& pmSession, bool flushAll)
+{
+    if (gTimelineFile == nullptr) {
+        return;
+    }
+
+    // The timestamp frequency is only known once the session has started.
+    auto const& args = GetCommandLineArgs();
+    auto frequency = (uint64_t) pmSession.mTimestampFrequency.QuadPart;
+    if (gTimeline == nullptr) {
+        gTimeline.reset(new GpuEngineTimeline((uint64_t) pmSession.mStartTimestamp.QuadPart,
+                                              frequency * args.mGpuEngineTimelineResolution / 1000,
+                                              frequency * kFlushDelaySeconds));
+    }
+
+    gIntervalRing->Dequeue(&gIntervals);
+    for (auto const& interval : gIntervals) {
+        gTimeline->Add(interval);
+    }
+    gIntervals.clear();
+
+    gTimeline->Flush(flushAll, &gRows);
+    if (gRows.empty()) {
+        return;
+    }
+
+    // Engines are registered by the consumer thread as they are first seen, so refresh the list if
+    // this output refers to a new one.
+    for (auto const& row : gRows) {
+        if (row.mEngineId >= gEngines.size()) {
+            gIntervalRing->GetEngines(&gEngines);
+            break;
+        }
+    }
+
+    auto binMs = (double) args.mGpuEngineTimelineResolution;
+    for (auto const& row : gRows) {
+        auto busyMs = pmSession.TimestampDeltaToMilliSeconds(row.mBusyTime);
+        fprintf(gTimelineFile, "%.4lf", 0.001 * pmSession.TimestampToMilliSeconds(row.mBinStart));
+        if (row.mEngineId < gEngines.size()) {
+            auto const& engine = gEngines[row.mEngineId];
+            fprintf(gTimelineFile, ",0x%llX,%u,%s", engine.mAdapter, engine.mNodeOrdinal, EngineTypeToString(engine.mEngineType));
+        } else {
+            fprintf(gTimelineFile, ",,,Unknown");
+        }
+        fprintf(gTimelineFile, ",%u,%.4lf,%.2lf\n", row.mProcessId, busyMs, 100.0 * busyMs / binMs);
+    }
+    gRows.clear();
+}
+
+void CloseGpuEngineTimeline()
+{
+    if (gTimelineFile == nullptr) {
+        return;
+    }
+
+    if (gIntervalRing->GetDroppedCount() > 0) {
+        PrintWarning(L"warning: %llu GPU busy intervals were dropped from --gpu_engine_timeline output.\n",
+            gIntervalRing->GetDroppedCount());
+    }
+
+    fclose(gTimelineFile);
+    gTimelineFile = nullptr;
+    gTimeline.reset();
+    gIntervalRing.reset();
+}
@@ -267,6 +267,9 @@ int wmain(int argc, wchar_t** argv)
         pmConsumer.mFilteredProcessIds = true;
         pmConsumer.AddTrackedProcessForFiltering(args.mTargetPid);
     }
+    if (args.mGpuEngineTimelineFileName != nullptr && !OpenGpuEngineTimeline(&pmConsumer)) {
+        PrintWarning(L"warning: failed to open --gpu_engine_timeline file: %s\n", args.mGpuEngineTimelineFileName);
+    }
 
     // Start the ETW trace session.
     PMTraceSession pmSession;
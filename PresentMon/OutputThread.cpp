@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: MIT
 
 #include "PresentMon.hpp"
+#include "../PresentData/ProcessInfoCache.hpp"
 
 #include <algorithm>
 #include <shlwapi.h>
@@ -73,11 +74,13 @@ static bool CopyRecordingToggleHistory(std::vector<uint64_t>* recordingToggleHis
 // get similar ProcessStart/ProcessStop events, but only if PresentMon is
 // running when the process started/stopped.  If we don't have elevated
 // privilege or we missed a process start/stop we update the active processes
-// whenever we notice an event with a new process id.  If it's a target
-// process, we obtain a handle to the process, and periodically check it to see
-// if it has exited.
+// whenever we notice an event with a new process id.  gProcessCache then
+// obtains a handle to the process, and we periodically check it to see if it
+// has exited.  gProcessCache also remembers process names after they exit, so
+// that late presents and short-lived processes don't reopen them.
 
 static std::unordered_map<uint32_t, ProcessInfo> gProcesses;
+static ProcessInfoCache* gProcessCache = nullptr;
 static uint32_t gTargetProcessCount = 0;
 
 // Removes any directory and extension, and converts the remaining name to
@@ -154,6 +157,8 @@ static void ProcessProcessEvent(
     ProcessEvent const& processEvent)
 {
     if (processEvent.IsStartEvent) {
+        gProcessCache->OnProcessStart(processEvent.ProcessId, processEvent.QpcTime, processEvent.ImageFileName);
+
         auto pr = gProcesses.emplace(processEvent.ProcessId, ProcessInfo{});
         auto info = &pr.first->second;
 
@@ -161,15 +166,17 @@ static void ProcessProcessEvent(
             HandleTerminatedProcess(info);
         }
 
-        info->mHandle          = NULL;
         info->mModuleName      = processEvent.ImageFileName;
         info->mOutputCsv       = nullptr;
+        info->mOutputColumnar  = nullptr;
         info->mIsTargetProcess = IsTargetProcess(processEvent.ProcessId, processEvent.ImageFileName);
 
         if (info->mIsTargetProcess) {
             gTargetProcessCount += 1;
         }
     } else {
+        gProcessCache->OnProcessStop(processEvent.ProcessId, processEvent.QpcTime);
+
         auto ii = gProcesses.find(processEvent.ProcessId);
         if (ii != gProcesses.end()) {
             HandleTerminatedProcess(&ii->second);
@@ -198,24 +205,22 @@ static void UpdateProcessEvents(
     // We assume that the process terminated now, which is wrong but conservative and functionally
     // ok because no other process should start with the same PID as long as we're still holding a
     // handle to it.
-    for (auto& pair : gProcesses) {
-        auto processId = pair.first;
-        auto processInfo = &pair.second;
-
-        DWORD exitCode = 0;
-        if (processInfo->mHandle != NULL && GetExitCodeProcess(processInfo->mHandle, &exitCode) && exitCode != STILL_ACTIVE) {
-            uint64_t qpc = 0;
-            QueryPerformanceCounter((LARGE_INTEGER*) &qpc);
+    if (gProcessCache->GetOpenCount() > 0) {
+        uint64_t qpc = 0;
+        QueryPerformanceCounter((LARGE_INTEGER*) &qpc);
 
+        std::vector<uint32_t> exitedProcessIds;
+        gProcessCache->CollectExited(qpc, &exitedProcessIds);
+        for (auto processId : exitedProcessIds) {
             ProcessEvent e;
-            e.ImageFileName = processInfo->mModuleName;
+            auto ii = gProcesses.find(processId);
+            if (ii != gProcesses.end()) {
+                e.ImageFileName = ii->second.mModuleName;
+            }
             e.QpcTime       = qpc;
             e.ProcessId     = processId;
             e.IsStartEvent  = false;
             processEvents->push_back(e);
-
-            CloseHandle(processInfo->mHandle);
-            processInfo->mHandle = NULL;
         }
     }
 }
@@ -608,31 +613,10 @@ static void PruneOldSwapChainData(
     }
 }
 
-static void QueryProcessName(uint32_t processId, ProcessInfo* info)
+static void QueryProcessName(uint32_t processId, uint64_t timestamp, ProcessInfo* info)
 {
-    auto const& args = GetCommandLineArgs();
-
-    wchar_t path[MAX_PATH];
-    wchar_t* processName = L"<unknown>";
-    HANDLE handle = NULL;
-
-    if (args.mEtlFileName == nullptr) {
-        handle = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, processId);
-        if (handle != NULL) {
-            DWORD numChars = _countof(path);
-            if (QueryFullProcessImageNameW(handle, 0, path, &numChars)) {
-                for (;; --numChars) {
-                    if (numChars == 0 || path[numChars - 1] == L'\\' || path[numChars - 1] == L'/') {
-                        processName = &path[numChars];
-                        break;
-                    }
-                }
-            }
-        }
-    }
-
-    info->mModuleName = processName;
-    info->mHandle     = handle;
+    auto processName = gProcessCache->Lookup(processId, timestamp);
+    info->mModuleName = processName != nullptr ? *processName : L"<unknown>";
 }
 
 static bool GetPresentProcessInfo(
@@ -655,8 +639,9 @@ static bool GetPresentProcessInfo(
         }
 
         ProcessInfo info;
-        QueryProcessName(presentEvent->ProcessId, &info);
+        QueryProcessName(presentEvent->ProcessId, presentEvent->PresentStartTime, &info);
         info.mOutputCsv       = nullptr;
+        info.mOutputColumnar  = nullptr;
         info.mIsTargetProcess = IsTargetProcess(presentEvent->ProcessId, info.mModuleName);
         if (info.mIsTargetProcess) {
             gTargetProcessCount += 1;
@@ -812,6 +797,12 @@ void Output(PMTraceSession const* pmSession)
     processEvents.reserve(128);
     presentEvents.reserve(1024);
 
+    // Processes are only opened when collecting realtime events.
+    WindowsProcessQuery processQuery;
+    ProcessInfoCache processCache(args.mEtlFileName == nullptr ? &processQuery : nullptr,
+                                  pmSession->mTimestampFrequency.QuadPart);
+    gProcessCache = &processCache;
+
     for (;;) {
         // Read gQuit here, but then check it after processing queued events.
         // This ensures that we call Dequeue*() at least once after
@@ -832,6 +823,9 @@ void Output(PMTraceSession const* pmSession)
             presentEvents.clear();
         }
 
+        // Write any completed --gpu_engine_timeline rows (all of them if quitting).
+        UpdateGpuEngineTimeline(*pmSession, quit);
+
         // Display information to console if requested.  If debug build and
         // simple console, print a heartbeat if recording.
         //
@@ -852,6 +846,8 @@ void Output(PMTraceSession const* pmSession)
                     UpdateConsole(pair.first, pair.second);
                 }
 
+                UpdateConsoleInstrumentation(pmSession->mPMConsumer);
+
                 if (currentRecordingState && args.mCSVOutput != CSVOutput::None) {
                     ConsolePrintLn(L"** RECORDING **");
                 }
@@ -873,13 +869,12 @@ void Output(PMTraceSession const* pmSession)
 
     // Close all CSV and process handles
     for (auto& pair : gProcesses) {
-        auto processInfo = &pair.second;
-        if (processInfo->mHandle != NULL) {
-            CloseHandle(processInfo->mHandle);
-        }
-        CloseMultiCsv(processInfo);
+        CloseMultiCsv(&pair.second);
     }
+    processCache.Clear();
+    gProcessCache = nullptr;
     CloseGlobalCsv();
+    CloseGpuEngineTimeline();
 
     gProcesses.clear();
 
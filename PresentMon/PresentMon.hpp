@@ -32,6 +32,8 @@ which is controlled from MainThread based on user input or timer.
 #include <unordered_map>
 #include <queue>
 
+class ColumnarWriter;
+
 // Verbosity of console output for normal operation:
 enum class ConsoleOutput {
     None,      // no output
@@ -54,19 +56,28 @@ enum class CSVOutput {
     Stdout  // To STDOUT in CSV format
 };
 
+// Format of per-frame metrics output files
+enum class OutputFormat {
+    CSV,        // Comma separated text
+    Columnar,   // Chunked binary columns (see ColumnarFile.hpp)
+};
+
 struct CommandLineArgs {
     std::vector<std::wstring> mTargetProcessNames;
     std::vector<std::wstring> mExcludeProcessNames;
     const wchar_t *mOutputCsvFileName;
     const wchar_t *mEtlFileName;
     const wchar_t *mSessionName;
+    const wchar_t *mGpuEngineTimelineFileName;
     UINT mTargetPid;
     UINT mDelay;
     UINT mTimer;
     UINT mHotkeyModifiers;
     UINT mHotkeyVirtualKeyCode;
+    UINT mGpuEngineTimelineResolution;
     TimeUnit mTimeUnit;
     CSVOutput mCSVOutput;
+    OutputFormat mOutputFormat;
     ConsoleOutput mConsoleOutput;
     bool mTrackDisplay;
     bool mTrackInput;
@@ -167,8 +178,8 @@ struct SwapChainData {
 struct ProcessInfo {
     std::wstring mModuleName;
     std::unordered_map<uint64_t, SwapChainData> mSwapChain;
-    HANDLE mHandle;
     FILE* mOutputCsv;
+    ColumnarWriter* mOutputColumnar;
     bool mIsTargetProcess;
 };
 
@@ -177,6 +188,12 @@ bool ParseCommandLine(int argc, wchar_t** argv);
 CommandLineArgs const& GetCommandLineArgs();
 void PrintHotkeyError();
 
+// ColumnarOutput.cpp:
+void CloseMultiColumnar(ProcessInfo* processInfo);
+void CloseGlobalColumnar();
+void UpdateColumnar(PMTraceSession const& pmSession, ProcessInfo* processInfo, PresentEvent const& p, FrameMetrics const& metrics);
+void UpdateColumnar(PMTraceSession const& pmSession, ProcessInfo* processInfo, PresentEvent const& p, FrameMetrics1 const& metrics);
+
 // Console.cpp:
 void InitializeConsole();
 void FinalizeConsole();
@@ -186,6 +203,7 @@ void EndConsoleUpdate();
 void ConsolePrint(wchar_t const* format, ...);
 void ConsolePrintLn(wchar_t const* format, ...);
 void UpdateConsole(uint32_t processId, ProcessInfo const& processInfo);
+void UpdateConsoleInstrumentation(PMTraceConsumer const* pmConsumer);
 int PrintWarning(wchar_t const* format, ...);
 int PrintError(wchar_t const* format, ...);
 
@@ -199,12 +217,20 @@ void CloseMultiCsv(ProcessInfo* processInfo);
 void CloseGlobalCsv();
 const char* PresentModeToString(PresentMode mode);
 const char* RuntimeToString(Runtime rt);
+const char* FrameTypeToString(FrameType ft);
+const char* FinalStateToDroppedString(PresentResult res);
+void GenerateFilename(wchar_t* path, std::wstring const& processName, uint32_t processId, wchar_t const* defaultExt);
 void UpdateCsv(PMTraceSession const& pmSession, ProcessInfo* processInfo, PresentEvent const& p, FrameMetrics const& metrics);
 void UpdateCsv(PMTraceSession const& pmSession, ProcessInfo* processInfo, PresentEvent const& p, FrameMetrics1 const& metrics);
 
 // MainThread.cpp:
 void ExitMainThread();
 
+// GpuEngineTimelineOutput.cpp:
+bool OpenGpuEngineTimeline(PMTraceConsumer* pmConsumer);
+void UpdateGpuEngineTimeline(PMTraceSession const& pmSession, bool flushAll);
+void CloseGpuEngineTimeline();
+
 // OutputThread.cpp:
 void StartOutputThread(PMTraceSession const& pmSession);
 void StopOutputThread();
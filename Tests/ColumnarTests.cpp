@@ -0,0 +1,234 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include "PresentMonTests.h"
+#include "../PresentMon/ColumnarFile.hpp"
+
+namespace {
+
+bool ReadFileContents(std::wstring const& path, std::string* contents)
+{
+    FILE* fp = nullptr;
+    if (_wfopen_s(&fp, path.c_str(), L"rb")) {
+        return false;
+    }
+    char buffer[64 * 1024];
+    for (size_t n; (n = fread(buffer, 1, sizeof(buffer), fp)) > 0; ) {
+        contents->append(buffer, n);
+    }
+    fclose(fp);
+    return true;
+}
+
+double GetSeconds(LARGE_INTEGER const& start)
+{
+    LARGE_INTEGER now = {};
+    LARGE_INTEGER freq = {};
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (double) (now.QuadPart - start.QuadPart) / freq.QuadPart;
+}
+
+// Both formats are timed the same way: one untimed warm-up run (so that input
+// files are in the file cache and code/allocations are warm), then the best of
+// kTimedRuns runs.
+constexpr int kTimedRuns = 2;
+
+template<typename F>
+double TimeBestRun(F&& run)
+{
+    run();
+    double best = 0.0;
+    for (int i = 0; i < kTimedRuns; ++i) {
+        LARGE_INTEGER start = {};
+        QueryPerformanceCounter(&start);
+        run();
+        auto seconds = GetSeconds(start);
+        best = i == 0 ? seconds : std::min(best, seconds);
+    }
+    return best;
+}
+
+// Decodes every row of a columnar file and writes it as CSV, the same output
+// path as pm_columnar_to_csv.  Returns the row count, or -1 on error.
+int64_t WriteCsv(std::wstring const& columnarPath, std::wstring const& csvPath)
+{
+    ColumnarReader reader;
+    if (!reader.Open(columnarPath.c_str())) {
+        return -1;
+    }
+    FILE* fp = nullptr;
+    if (_wfopen_s(&fp, csvPath.c_str(), L"w,ccs=UTF-8")) {
+        return -1;
+    }
+    auto rowCount = WriteColumnarAsCsv(&reader, fp);
+    fclose(fp);
+    reader.Close();
+    return rowCount;
+}
+
+// Decodes every row of a columnar file and re-encodes it as a new columnar
+// file.
+bool WriteColumnar(std::wstring const& columnarPath, std::wstring const& rewritePath)
+{
+    ColumnarReader reader;
+    if (!reader.Open(columnarPath.c_str())) {
+        return false;
+    }
+    auto const& columns = reader.GetColumns();
+    ColumnarWriter writer;
+    if (!writer.Open(rewritePath.c_str(), reader.GetTiming(), columns)) {
+        return false;
+    }
+    while (reader.ReadChunk()) {
+        for (uint32_t row = 0, n = reader.GetChunkRowCount(); row < n; ++row) {
+            for (size_t i = 0; i < columns.size(); ++i) {
+                if (!reader.IsValid(i, row)) {
+                    writer.AppendNA();
+                    continue;
+                }
+                switch (columns[i].mType) {
+                case ColumnType::Int:       writer.AppendInt(reader.GetInt(i, row)); break;
+                case ColumnType::Double:    writer.AppendDouble(reader.GetDouble(i, row)); break;
+                case ColumnType::Timestamp: writer.AppendTimestamp(reader.GetUInt(i, row)); break;
+                case ColumnType::String:    writer.AppendString(reader.GetString(i, row).c_str()); break;
+                default:                    writer.AppendUInt(reader.GetUInt(i, row)); break;
+                }
+            }
+            writer.EndRow();
+        }
+    }
+    writer.Close();
+    reader.Close();
+    return true;
+}
+
+struct TestArgs {
+    std::wstring etl_;
+    std::wstring goldCsv_;
+    std::wstring testPath_; // Output path without extension
+};
+
+// Runs PresentMon on a gold ETL twice, once writing CSV and once writing
+// columnar output, and checks that converting the columnar file back to CSV
+// reproduces the CSV output exactly.  The size and write cost of each format
+// are reported.
+class Tests : public ::testing::Test, TestArgs {
+public:
+    explicit Tests(TestArgs const& args)
+    {
+        TestArgs::operator=(args);
+    }
+
+    void RunPresentMon(std::vector<wchar_t const*> const& params, std::wstring const& outPath, bool columnar)
+    {
+        PresentMon pm;
+        pm.Add(L"--stop_existing_session");
+        pm.AddEtlPath(etl_);
+        pm.AddCsvPath(outPath);
+        if (columnar) {
+            pm.Add(L"--output_format columnar");
+        }
+        for (auto param : params) {
+            pm.Add(param);
+        }
+        pm.PMSTART();
+        pm.PMEXITED();
+    }
+
+    void TestBody() override
+    {
+        // Use the same options as the gold CSV.
+        PresentMonCsv goldCsv;
+        if (!goldCsv.CSVOPEN(goldCsv_)) {
+            return;
+        }
+        goldCsv.Close();
+
+        for (auto i = testPath_.find_last_of(L"/\\"); i == std::wstring::npos || !EnsureDirectoryCreated(testPath_.substr(0, i)); ) {
+            AddTestFailure(__FILE__, __LINE__, "Output directory does not exist!");
+            return;
+        }
+
+        auto csvPath       = testPath_ + L".csv";
+        auto columnarPath  = testPath_ + L".pmcol";
+        auto convertedPath = testPath_ + L"-converted.csv";
+
+        // Each format is run with the same warm-up and timer; the first run also
+        // brings the ETL into the file cache for the timed runs of both.
+        auto csvRunSeconds      = TimeBestRun([&] { RunPresentMon(goldCsv.params_, csvPath, false); });
+        auto columnarRunSeconds = TimeBestRun([&] { RunPresentMon(goldCsv.params_, columnarPath, true); });
+
+        // Convert the columnar file back into CSV.
+        auto rowCount = WriteCsv(columnarPath, convertedPath);
+        if (rowCount < 0) {
+            AddTestFailure(__FILE__, __LINE__, "Columnar output is corrupt: %ls", columnarPath.c_str());
+            return;
+        }
+
+        // The converted CSV must match PresentMon's own CSV byte for byte.
+        std::string csv;
+        std::string converted;
+        std::string columnar;
+        if (!ReadFileContents(csvPath, &csv) ||
+            !ReadFileContents(convertedPath, &converted) ||
+            !ReadFileContents(columnarPath, &columnar)) {
+            AddTestFailure(__FILE__, __LINE__, "Failed to read test output");
+            return;
+        }
+        if (csv != converted) {
+            auto mismatch = std::mismatch(csv.begin(), csv.end(), converted.begin(), converted.end());
+            auto line = 1 + std::count(csv.begin(), mismatch.first, '\n');
+            AddTestFailure(__FILE__, __LINE__, "Converted columnar output differs from CSV on line %zu", (size_t) line);
+            printf("CSV       = %ls\n", csvPath.c_str());
+            printf("CONVERTED = %ls\n", convertedPath.c_str());
+            return;
+        }
+
+        // Re-encoding the decoded rows must reproduce the original file.
+        auto rewritePath = testPath_ + L"-rewrite.pmcol";
+        std::string rewrite;
+        if (!WriteColumnar(columnarPath, rewritePath) ||
+            !ReadFileContents(rewritePath, &rewrite) || rewrite != columnar) {
+            AddTestFailure(__FILE__, __LINE__, "Re-encoded columnar output differs: %ls", rewritePath.c_str());
+            return;
+        }
+
+        // Measure the cost of writing the same rows in each format.  Both
+        // decode the same columnar file and include opening, writing and
+        // closing the output file, so they differ only in the output format.
+        auto csvWriteSeconds      = TimeBestRun([&] { WriteCsv(columnarPath, convertedPath); });
+        auto columnarWriteSeconds = TimeBestRun([&] { WriteColumnar(columnarPath, rewritePath); });
+
+        if (rowCount > 0) {
+            printf("    %lld frames: CSV %.1f bytes/frame, columnar %.1f bytes/frame (%.1fx smaller)\n",
+                rowCount,
+                (double) csv.size() / rowCount,
+                (double) columnar.size() / rowCount,
+                (double) csv.size() / std::max<size_t>(columnar.size(), 1));
+            printf("    write: CSV %.2f Mframes/s, columnar %.2f Mframes/s; PresentMon run: CSV %.3fs, columnar %.3fs\n",
+                csvWriteSeconds      > 0.0 ? 1e-6 * rowCount / csvWriteSeconds      : 0.0,
+                columnarWriteSeconds > 0.0 ? 1e-6 * rowCount / columnarWriteSeconds : 0.0,
+                csvRunSeconds,
+                columnarRunSeconds);
+        }
+    }
+};
+
+}
+
+void AddColumnarTest(
+    std::wstring const& etl,
+    std::wstring const& goldCsv,
+    std::string const& name)
+{
+    TestArgs args;
+    args.etl_      = etl;
+    args.goldCsv_  = goldCsv;
+    args.testPath_ = outDir_ + L"Columnar\\" + Convert(name);
+
+    ::testing::RegisterTest(
+        "ColumnarTests", name.c_str(), nullptr, nullptr, __FILE__, __LINE__,
+        [=]() -> ::testing::Test* { return new Tests(std::move(args)); });
+}
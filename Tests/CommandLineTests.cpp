@@ -6,11 +6,11 @@
 #include "PresentMonTests.h"
 
 template<typename T, typename U> T Convert(U, LARGE_INTEGER const& freq);
-template<> uint64_t Convert(char const* u, LARGE_INTEGER const&)      { return strtoull(u, nullptr, 10); }
-template<> double   Convert(char const* u, LARGE_INTEGER const&)      { return strtod(u, nullptr); }
-template<> uint64_t Convert(uint64_t    u, LARGE_INTEGER const&)      { return u; }
-template<> double   Convert(uint64_t    u, LARGE_INTEGER const& freq) { return (double) u / freq.QuadPart; }
-template<> double   Convert(double      u, LARGE_INTEGER const&)      { return u; }
+template<> uint64_t Convert(std::string_view u, LARGE_INTEGER const&)      { uint64_t r = 0; ParseCsvNumber(u, &r); return r; }
+template<> double   Convert(std::string_view u, LARGE_INTEGER const&)      { double r = 0.0; ParseCsvNumber(u, &r); return r; }
+template<> uint64_t Convert(uint64_t         u, LARGE_INTEGER const&)      { return u; }
+template<> double   Convert(uint64_t         u, LARGE_INTEGER const& freq) { return (double) u / freq.QuadPart; }
+template<> double   Convert(double           u, LARGE_INTEGER const&)      { return u; }
 
 namespace {
 
@@ -101,7 +101,8 @@ void QpcTimeTest(bool qpc)
     std::unordered_map<uint32_t, std::pair<double, T>> firstMeasurement;
 
     while (!::testing::Test::HasFailure() && csv.ReadRow()) {
-        auto pid = strtoul(csv.cols_[idxProcessID], nullptr, 10);
+        uint32_t pid = 0;
+        ParseCsvNumber(csv.cols_[idxProcessID], &pid);
         auto t = Convert<double>(csv.cols_[idxTimeInSeconds], freq);
         auto q = Convert<T>     (csv.cols_[idxQPCTime],       freq);
 
@@ -205,7 +206,8 @@ void InputTest(uint32_t v)
 
     uint32_t nonZeroInputRowCount = 0;
     while (!::testing::Test::HasFailure() && csv.ReadRow()) {
-        auto inputValue = strtod(csv.cols_[idxInputHeader], nullptr);
+        double inputValue = 0.0;
+        ParseCsvNumber(csv.cols_[idxInputHeader], &inputValue);
         if (inputValue != 0) {
             nonZeroInputRowCount += 1;
         }
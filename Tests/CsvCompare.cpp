@@ -0,0 +1,368 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "CsvCompare.h"
+#include "CsvReader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <math.h>
+#include <thread>
+
+namespace {
+
+struct Column {
+    size_t mTestIndex;
+    size_t mGoldIndex;
+    double mTolerance;  // Negative if it couldn't be determined up front
+};
+
+struct ColumnResult {
+    size_t mDiffCount;
+    double mMaxAbsError;
+    size_t mMaxAbsErrorLine;
+    std::vector<CsvCellDiff> mDiffs;
+};
+
+struct ChunkResult {
+    std::vector<ColumnResult> mColumns;
+    size_t mDiffRowCount;
+    size_t mFirstDiffLine;
+    CsvInvalidRow mTestInvalidRow;
+    CsvInvalidRow mGoldInvalidRow;
+};
+
+struct File {
+    CsvReader mReader;
+    std::vector<std::string_view> mHeader;
+    std::vector<size_t> mChunkOffsets;  // Offset of the first row of each chunk
+    size_t mRowCount;
+};
+
+constexpr double kDecimalTolerance[] = {
+    1e-0, 1e-1, 1e-2, 1e-3, 1e-4, 1e-5, 1e-6, 1e-7, 1e-8,
+    1e-9, 1e-10, 1e-11, 1e-12, 1e-13, 1e-14, 1e-15, 1e-16,
+};
+
+double GetTolerance(std::string_view a, std::string_view b)
+{
+    auto ai = a.find('.');
+    auto bi = b.find('.');
+    size_t aDecimals = ai == std::string_view::npos ? 0 : a.size() - ai - 1;
+    size_t bDecimals = bi == std::string_view::npos ? 0 : b.size() - bi - 1;
+    auto decimals = std::min(aDecimals, bDecimals);
+    return decimals < _countof(kDecimalTolerance) ? kDecimalTolerance[decimals] : pow(0.1, (double) decimals);
+}
+
+bool OpenFile(wchar_t const* path, size_t chunkRows, File* file)
+{
+    if (!file->mReader.Open(path)) {
+        return false;
+    }
+
+    file->mReader.ReadRow(&file->mHeader);
+
+    // Find the start of each chunk.  Only newlines are searched for here;
+    // rows are split later by the thread comparing the chunk.
+    file->mRowCount = 0;
+    for (auto offset = file->mReader.GetOffset(); ; ) {
+        if (file->mRowCount % chunkRows == 0) {
+            file->mChunkOffsets.push_back(offset);
+        }
+        if (!file->mReader.SkipRowAt(&offset)) {
+            break;
+        }
+        file->mRowCount += 1;
+    }
+
+    return true;
+}
+
+// Determine each column's tolerance from the first row (within the first
+// chunk) where both cells are numbers.
+void ComputeTolerances(File const& test, File const& gold, size_t chunkRows, std::vector<Column>* columns)
+{
+    std::vector<std::string_view> testRow;
+    std::vector<std::string_view> goldRow;
+    auto testOffset = test.mChunkOffsets[0];
+    auto goldOffset = gold.mChunkOffsets[0];
+    auto remaining = columns->size();
+    for (size_t i = 0; remaining > 0 && i < chunkRows; ++i) {
+        if (!test.mReader.ReadRowAt(&testOffset, &testRow) ||
+            !gold.mReader.ReadRowAt(&goldOffset, &goldRow)) {
+            break;
+        }
+        for (auto& column : *columns) {
+            if (column.mTolerance < 0.0 &&
+                column.mTestIndex < testRow.size() &&
+                column.mGoldIndex < goldRow.size()) {
+                auto a = testRow[column.mTestIndex];
+                auto b = goldRow[column.mGoldIndex];
+                double x = 0.0;
+                double y = 0.0;
+                if (ParseCsvNumber(a, &x) && ParseCsvNumber(b, &y)) {
+                    column.mTolerance = GetTolerance(a, b);
+                    remaining -= 1;
+                }
+            }
+        }
+    }
+}
+
+void Validate(std::function<bool(std::vector<std::string_view> const&, std::string*)> const& validate,
+              std::vector<std::string_view> const& row, size_t line, CsvInvalidRow* invalidRow)
+{
+    if (validate && invalidRow->mLine == 0 && !validate(row, &invalidRow->mError)) {
+        invalidRow->mLine = line;
+    }
+}
+
+void CompareChunk(File const& test, File const& gold, std::vector<Column> const& columns, CsvCompareOptions const& options,
+                  size_t chunk, ChunkResult* result)
+{
+    result->mColumns.resize(columns.size());
+    for (auto& c : result->mColumns) {
+        c.mDiffCount = 0;
+        c.mMaxAbsError = 0.0;
+        c.mMaxAbsErrorLine = 0;
+    }
+    result->mDiffRowCount = 0;
+    result->mFirstDiffLine = 0;
+    result->mTestInvalidRow.mLine = 0;
+    result->mGoldInvalidRow.mLine = 0;
+
+    auto firstRow = chunk * options.mChunkRows;
+    auto testOffset = chunk < test.mChunkOffsets.size() ? test.mChunkOffsets[chunk] : SIZE_MAX;
+    auto goldOffset = chunk < gold.mChunkOffsets.size() ? gold.mChunkOffsets[chunk] : SIZE_MAX;
+
+    std::vector<std::string_view> testRow;
+    std::vector<std::string_view> goldRow;
+    for (size_t i = 0; i < options.mChunkRows; ++i) {
+        auto line = firstRow + i + 2;
+        auto hasTest = testOffset != SIZE_MAX && test.mReader.ReadRowAt(&testOffset, &testRow);
+        auto hasGold = goldOffset != SIZE_MAX && gold.mReader.ReadRowAt(&goldOffset, &goldRow);
+        if (hasTest) Validate(options.mValidateTestRow, testRow, line, &result->mTestInvalidRow);
+        if (hasGold) Validate(options.mValidateGoldRow, goldRow, line, &result->mGoldInvalidRow);
+        if (!hasTest || !hasGold) {
+            if (!hasTest && !hasGold) {
+                break;
+            }
+            // Rows only in one of the files are reported through the row
+            // counts.
+            continue;
+        }
+
+        auto rowOk = true;
+        for (size_t c = 0, n = columns.size(); c < n; ++c) {
+            auto const& column = columns[c];
+
+            // Need to protect against missing columns on each line as the
+            // file may be corrupted.
+            std::string_view a = column.mTestIndex < testRow.size() ? testRow[column.mTestIndex] : "<missing>";
+            std::string_view b = column.mGoldIndex < goldRow.size() ? goldRow[column.mGoldIndex] : "<missing>";
+            if (CsvCellEqualNoCase(a, b)) {
+                continue;
+            }
+
+            auto r = &result->mColumns[c];
+            double x = 0.0;
+            double y = 0.0;
+            if (ParseCsvNumber(a, &x) && ParseCsvNumber(b, &y)) {
+                auto error = fabs(x - y);
+                if (error > r->mMaxAbsError || r->mMaxAbsErrorLine == 0) {
+                    r->mMaxAbsError = error;
+                    r->mMaxAbsErrorLine = line;
+                }
+                auto tolerance = column.mTolerance >= 0.0 ? column.mTolerance : GetTolerance(a, b);
+                if (error < tolerance) {
+                    continue;
+                }
+            }
+
+            r->mDiffCount += 1;
+            if (r->mDiffs.size() < options.mMaxDiffsPerColumn) {
+                r->mDiffs.push_back({ line, std::string(a), std::string(b) });
+            }
+            rowOk = false;
+        }
+
+        if (!rowOk) {
+            result->mDiffRowCount += 1;
+            if (result->mFirstDiffLine == 0) {
+                result->mFirstDiffLine = line;
+            }
+        }
+    }
+}
+
+double GetSeconds(LARGE_INTEGER const& start)
+{
+    LARGE_INTEGER now = {};
+    LARGE_INTEGER freq = {};
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (double) (now.QuadPart - start.QuadPart) / freq.QuadPart;
+}
+
+}
+
+bool CompareCsvFiles(
+    wchar_t const* testPath,
+    wchar_t const* goldPath,
+    CsvCompareOptions const& options,
+    CsvCompareReport* report)
+{
+    LARGE_INTEGER start = {};
+    QueryPerformanceCounter(&start);
+
+    auto opts = options;
+    opts.mChunkRows = std::max<size_t>(opts.mChunkRows, 1);
+
+    File test;
+    File gold;
+    if (!OpenFile(testPath, opts.mChunkRows, &test) ||
+        !OpenFile(goldPath, opts.mChunkRows, &gold)) {
+        return false;
+    }
+
+    report->mTestRowCount = test.mRowCount;
+    report->mGoldRowCount = gold.mRowCount;
+    report->mTestOnlyColumns.clear();
+    report->mGoldOnlyColumns.clear();
+    report->mColumns.clear();
+    report->mDiffRowCount = 0;
+    report->mFirstDiffLine = 0;
+    report->mTestInvalidRow.mLine = 0;
+    report->mTestInvalidRow.mError.clear();
+    report->mGoldInvalidRow.mLine = 0;
+    report->mGoldInvalidRow.mError.clear();
+
+    // Match columns by name
+    std::vector<Column> columns;
+    for (size_t i = 0, n = test.mHeader.size(); i < n; ++i) {
+        auto g = std::find(gold.mHeader.begin(), gold.mHeader.end(), test.mHeader[i]);
+        if (g == gold.mHeader.end()) {
+            report->mTestOnlyColumns.emplace_back(test.mHeader[i]);
+        } else {
+            columns.push_back({ i, (size_t) (g - gold.mHeader.begin()), -1.0 });
+            report->mColumns.push_back({ std::string(test.mHeader[i]), 0, 0.0, 0, {} });
+        }
+    }
+    for (auto const& name : gold.mHeader) {
+        if (std::find(test.mHeader.begin(), test.mHeader.end(), name) == test.mHeader.end()) {
+            report->mGoldOnlyColumns.emplace_back(name);
+        }
+    }
+
+    ComputeTolerances(test, gold, opts.mChunkRows, &columns);
+
+    // Compare the chunks in parallel
+    auto chunkCount = std::max(test.mChunkOffsets.size(), gold.mChunkOffsets.size());
+    std::vector<ChunkResult> chunkResults(chunkCount);
+
+    auto threadCount = opts.mThreadCount != 0 ? opts.mThreadCount : std::max(std::thread::hardware_concurrency(), 1u);
+    threadCount = (uint32_t) std::min<size_t>(threadCount, chunkCount);
+
+    std::atomic<size_t> nextChunk(0);
+    auto worker = [&]() {
+        for (size_t chunk; (chunk = nextChunk.fetch_add(1)) < chunkCount; ) {
+            CompareChunk(test, gold, columns, opts, chunk, &chunkResults[chunk]);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Merge the chunk results in file order
+    for (auto& chunkResult : chunkResults) {
+        for (size_t c = 0, n = columns.size(); c < n; ++c) {
+            auto const& src = chunkResult.mColumns[c];
+            auto dst = &report->mColumns[c];
+            dst->mDiffCount += src.mDiffCount;
+            if (src.mMaxAbsErrorLine != 0 && (dst->mMaxAbsErrorLine == 0 || src.mMaxAbsError > dst->mMaxAbsError)) {
+                dst->mMaxAbsError = src.mMaxAbsError;
+                dst->mMaxAbsErrorLine = src.mMaxAbsErrorLine;
+            }
+            for (auto const& diff : src.mDiffs) {
+                if (dst->mDiffs.size() == opts.mMaxDiffsPerColumn) {
+                    break;
+                }
+                dst->mDiffs.push_back(diff);
+            }
+        }
+
+        report->mDiffRowCount += chunkResult.mDiffRowCount;
+        if (report->mFirstDiffLine == 0) {
+            report->mFirstDiffLine = chunkResult.mFirstDiffLine;
+        }
+        if (report->mTestInvalidRow.mLine == 0) {
+            report->mTestInvalidRow = chunkResult.mTestInvalidRow;
+        }
+        if (report->mGoldInvalidRow.mLine == 0) {
+            report->mGoldInvalidRow = chunkResult.mGoldInvalidRow;
+        }
+    }
+
+    report->mSeconds = GetSeconds(start);
+    return true;
+}
+
+void PrintCsvCompareReport(
+    FILE* fp,
+    CsvCompareReport const& report)
+{
+    if (report.mTestRowCount != report.mGoldRowCount) {
+        fprintf(fp, "    TEST has %zu rows, GOLD has %zu rows\n", report.mTestRowCount, report.mGoldRowCount);
+    }
+    if (report.mTestInvalidRow.mLine != 0) {
+        fprintf(fp, "    TEST line %zu is invalid: %s\n", report.mTestInvalidRow.mLine, report.mTestInvalidRow.mError.c_str());
+    }
+    if (report.mGoldInvalidRow.mLine != 0) {
+        fprintf(fp, "    GOLD line %zu is invalid: %s\n", report.mGoldInvalidRow.mLine, report.mGoldInvalidRow.mError.c_str());
+    }
+    for (auto const& name : report.mTestOnlyColumns) {
+        fprintf(fp, "    Column only in TEST: %s\n", name.c_str());
+    }
+    for (auto const& name : report.mGoldOnlyColumns) {
+        fprintf(fp, "    Column only in GOLD: %s\n", name.c_str());
+    }
+
+    if (report.mDiffRowCount == 0) {
+        return;
+    }
+
+    fprintf(fp, "    %zu rows differ, starting on line %zu\n", report.mDiffRowCount, report.mFirstDiffLine);
+    fprintf(fp, "    COLUMN                    DIFFS   MAX ABS ERROR\n");
+    for (auto const& column : report.mColumns) {
+        if (column.mDiffCount == 0) {
+            continue;
+        }
+
+        auto r = fprintf(fp, "    %s", column.mName.c_str());
+        fprintf(fp, "%*s", r < 29 ? 29 - r : 0, "");
+        r = fprintf(fp, " %zu", column.mDiffCount);
+        fprintf(fp, "%*s", r < 8 ? 8 - r : 0, "");
+        if (column.mMaxAbsErrorLine != 0) {
+            fprintf(fp, " %lf (line %zu)\n", column.mMaxAbsError, column.mMaxAbsErrorLine);
+        } else {
+            fprintf(fp, " -\n");
+        }
+
+        for (auto const& diff : column.mDiffs) {
+            r = fprintf(fp, "        line %zu", diff.mLine);
+            fprintf(fp, "%*s", r < 29 ? 29 - r : 0, "");
+            r = fprintf(fp, " TEST=%s", diff.mTest.c_str());
+            fprintf(fp, "%*s", r < 38 ? 38 - r : 0, "");
+            fprintf(fp, " GOLD=%s\n", diff.mGold.c_str());
+        }
+        if (column.mDiffs.size() < column.mDiffCount) {
+            fprintf(fp, "        ... %zu more\n", column.mDiffCount - column.mDiffs.size());
+        }
+    }
+}
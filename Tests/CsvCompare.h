@@ -0,0 +1,83 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+/*
+CompareCsvFiles() compares a TEST CSV against a GOLD CSV and produces a
+per-column report of the differences.
+
+Columns are matched by header name; columns found in only one of the files are
+listed in the report but not compared.  Two cells match if they are equal
+(ignoring case), or if they are both numbers that differ by less than one unit
+in the last printed decimal place (different PresentMon versions may print
+different precision, and printf() may round differently on different
+platforms).  That tolerance is computed once per column, from the first row
+where both cells are numeric.
+
+Both files are first divided into row-aligned chunks by a quick newline scan,
+and the chunks are then compared in parallel.  The report is identical
+regardless of the thread count.
+*/
+
+#include <functional>
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct CsvCompareOptions {
+    uint32_t mThreadCount = 0;          // 0 uses one thread per hardware thread
+    size_t mChunkRows = 8192;
+    size_t mMaxDiffsPerColumn = 5;      // Number of differing cells recorded per column
+
+    // Optional checks run on every data row of each file, possibly from
+    // several threads at once.  Return false and set *error to report the
+    // row as invalid.
+    std::function<bool(std::vector<std::string_view> const& row, std::string* error)> mValidateTestRow;
+    std::function<bool(std::vector<std::string_view> const& row, std::string* error)> mValidateGoldRow;
+};
+
+struct CsvCellDiff {
+    size_t mLine;                       // Line number in the files (the header is line 1)
+    std::string mTest;
+    std::string mGold;
+};
+
+struct CsvColumnReport {
+    std::string mName;
+    size_t mDiffCount;
+    double mMaxAbsError;                // Largest |TEST - GOLD| of numeric cells that are not identical
+    size_t mMaxAbsErrorLine;            // 0 if no numeric cells differed
+    std::vector<CsvCellDiff> mDiffs;    // The first mMaxDiffsPerColumn differences
+};
+
+struct CsvInvalidRow {
+    size_t mLine;                       // 0 if all rows were valid
+    std::string mError;
+};
+
+struct CsvCompareReport {
+    size_t mTestRowCount;               // Data rows, not including the header
+    size_t mGoldRowCount;
+    std::vector<std::string> mTestOnlyColumns;
+    std::vector<std::string> mGoldOnlyColumns;
+    std::vector<CsvColumnReport> mColumns;
+    size_t mDiffRowCount;               // Rows with at least one differing cell
+    size_t mFirstDiffLine;              // 0 if there were no differences
+    CsvInvalidRow mTestInvalidRow;      // First row that failed mValidateTestRow
+    CsvInvalidRow mGoldInvalidRow;      // First row that failed mValidateGoldRow
+    double mSeconds;
+
+    bool HasDifferences() const
+    {
+        return mTestRowCount != mGoldRowCount || mDiffRowCount != 0 ||
+               mTestInvalidRow.mLine != 0 || mGoldInvalidRow.mLine != 0;
+    }
+};
+
+// Returns false if either file could not be opened.
+bool CompareCsvFiles(wchar_t const* testPath, wchar_t const* goldPath, CsvCompareOptions const& options, CsvCompareReport* report);
+
+void PrintCsvCompareReport(FILE* fp, CsvCompareReport const& report);
@@ -0,0 +1,256 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+/*
+CsvReader is a read-only, memory-mapped CSV reader shared by the PresentMon
+tests and tools.  Rows are split in place: each cell is returned as a
+std::string_view into the mapped file, with surrounding spaces/tabs (and any
+'\r' line ending) trimmed.  Quoted cells are not supported since PresentMon
+does not write them.
+
+Delimiters and line endings are located 16 bytes at a time with SSE2 where it
+is available (x86/x64), falling back to a scalar scan elsewhere.
+
+Use ParseCsvNumber() to convert a cell into a number without copying it.
+
+ReadRow() reads sequentially from an internal cursor.  ReadRowAt() and
+SkipRowAt() instead take the caller's byte offset, so several threads can read
+different parts of the same file concurrently.
+*/
+
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+
+#include <windows.h>
+#include <charconv>
+#include <stdint.h>
+#include <string.h>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(_M_IX86) || defined(_M_X64)
+#include <emmintrin.h>
+#include <intrin.h>
+#define CSV_READER_USE_SSE2 1
+#else
+#define CSV_READER_USE_SSE2 0
+#endif
+
+class CsvReader {
+public:
+    CsvReader() = default;
+    CsvReader(CsvReader const&) = delete;
+    CsvReader& operator=(CsvReader const&) = delete;
+    ~CsvReader() { Close(); }
+
+    bool Open(wchar_t const* path)
+    {
+        Close();
+
+        file_ = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER size = {};
+        if (GetFileSizeEx(file_, &size) == 0) {
+            Close();
+            return false;
+        }
+
+        // Empty files cannot be mapped, but are valid (they have no rows).
+        if (size.QuadPart > 0) {
+            mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping_ == NULL) {
+                Close();
+                return false;
+            }
+            data_ = (char const*) MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+            if (data_ == nullptr) {
+                Close();
+                return false;
+            }
+            size_ = (size_t) size.QuadPart;
+        }
+
+        // Skip UTF-8 marker if there is one.
+        begin_ = size_ >= 3 && data_[0] == '\xef' && data_[1] == '\xbb' && data_[2] == '\xbf' ? 3 : 0;
+        Rewind();
+        return true;
+    }
+
+    void Close()
+    {
+        if (data_ != nullptr) {
+            UnmapViewOfFile(data_);
+            data_ = nullptr;
+        }
+        if (mapping_ != NULL) {
+            CloseHandle(mapping_);
+            mapping_ = NULL;
+        }
+        if (file_ != INVALID_HANDLE_VALUE) {
+            CloseHandle(file_);
+            file_ = INVALID_HANDLE_VALUE;
+        }
+        size_ = 0;
+        begin_ = 0;
+        pos_ = 0;
+        line_ = 0;
+    }
+
+    // Go back to the first row (i.e., the header).
+    void Rewind()
+    {
+        pos_ = begin_;
+        line_ = 0;
+    }
+
+    // Split the next row into cells.  Returns false once there are no more
+    // rows.  The cells remain valid until the reader is closed.
+    bool ReadRow(std::vector<std::string_view>* cells)
+    {
+        if (!ReadRowAt(&pos_, cells)) {
+            return false;
+        }
+        line_ += 1;
+        return true;
+    }
+
+    // Split the row starting at *offset into cells, and advance *offset to
+    // the start of the next row.
+    bool ReadRowAt(size_t* offset, std::vector<std::string_view>* cells) const
+    {
+        cells->clear();
+        if (*offset >= size_) {
+            return false;
+        }
+
+        auto end = data_ + size_;
+        auto cellStart = data_ + *offset;
+        for (auto block = cellStart; ; block += 16) {
+            // Bit i of mask is set if block[i] is a ',' or '\n'.
+            uint32_t mask = 0;
+            if (end - block >= 16) {
+                #if CSV_READER_USE_SSE2
+                auto v = _mm_loadu_si128((__m128i const*) block);
+                mask = (uint32_t) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(',')),
+                                                                 _mm_cmpeq_epi8(v, _mm_set1_epi8('\n'))));
+                #else
+                mask = ScanBlock(block, 16);
+                #endif
+            } else if (block < end) {
+                mask = ScanBlock(block, (size_t) (end - block));
+            } else {
+                // Last row without a trailing line ending.
+                AddCell(cells, cellStart, end);
+                *offset = size_;
+                return true;
+            }
+
+            for (; mask != 0; mask &= mask - 1) {
+                auto delimiter = block + CountTrailingZeros(mask);
+                AddCell(cells, cellStart, delimiter);
+                cellStart = delimiter + 1;
+                if (*delimiter == '\n') {
+                    *offset = (size_t) (cellStart - data_);
+                    return true;
+                }
+            }
+        }
+    }
+
+    // Advance *offset to the start of the next row without splitting it.
+    bool SkipRowAt(size_t* offset) const
+    {
+        if (*offset >= size_) {
+            return false;
+        }
+        auto lineEnd = (char const*) memchr(data_ + *offset, '\n', size_ - *offset);
+        *offset = lineEnd == nullptr ? size_ : (size_t) (lineEnd + 1 - data_);
+        return true;
+    }
+
+    // Offset of the next row ReadRow() will read.
+    size_t GetOffset() const { return pos_; }
+    size_t GetLine() const { return line_; }
+    size_t GetFileSize() const { return size_; }
+
+private:
+    static uint32_t ScanBlock(char const* block, size_t count)
+    {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (block[i] == ',' || block[i] == '\n') {
+                mask |= 1u << i;
+            }
+        }
+        return mask;
+    }
+
+    static uint32_t CountTrailingZeros(uint32_t mask)
+    {
+        unsigned long index = 0;
+        _BitScanForward(&index, mask);
+        return (uint32_t) index;
+    }
+
+    static void AddCell(std::vector<std::string_view>* cells, char const* first, char const* last)
+    {
+        while (first < last && (*first == ' ' || *first == '\t')) ++first;
+        while (last > first && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r')) --last;
+        cells->emplace_back(first, (size_t) (last - first));
+    }
+
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = NULL;
+    char const* data_ = nullptr;
+    size_t size_ = 0;
+    size_t begin_ = 0;
+    size_t pos_ = 0;
+    size_t line_ = 0;
+};
+
+// Convert a whole cell into a number.  Unsigned integers may be written in
+// hex with a "0x" prefix.  Returns false (leaving *value unmodified) if the
+// cell is not a number, e.g. "NA".
+template<typename T>
+bool ParseCsvNumber(std::string_view cell, T* value)
+{
+    auto first = cell.data();
+    auto last = cell.data() + cell.size();
+    std::from_chars_result r;
+    if constexpr (std::is_floating_point<T>::value) {
+        r = std::from_chars(first, last, *value);
+    } else if constexpr (std::is_unsigned<T>::value) {
+        if (cell.size() > 2 && first[0] == '0' && (first[1] == 'x' || first[1] == 'X')) {
+            r = std::from_chars(first + 2, last, *value, 16);
+        } else {
+            r = std::from_chars(first, last, *value);
+        }
+    } else {
+        r = std::from_chars(first, last, *value);
+    }
+    return r.ec == std::errc() && r.ptr == last;
+}
+
+inline bool CsvCellEqualNoCase(std::string_view a, std::string_view b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0, n = a.size(); i < n; ++i) {
+        auto ca = a[i];
+        auto cb = b[i];
+        if (ca >= 'A' && ca <= 'Z') ca += 'a' - 'A';
+        if (cb >= 'A' && cb <= 'Z') cb += 'a' - 'A';
+        if (ca != cb) {
+            return false;
+        }
+    }
+    return true;
+}
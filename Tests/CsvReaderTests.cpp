@@ -0,0 +1,117 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "PresentMonTests.h"
+
+namespace {
+
+// Each file is parsed repeatedly until at least this many bytes have been
+// processed, so that small gold CSVs still produce a stable measurement.
+constexpr uint64_t kMinBenchmarkBytes = 256ull * 1024 * 1024;
+
+double GetSeconds(LARGE_INTEGER const& start)
+{
+    LARGE_INTEGER now = {};
+    LARGE_INTEGER freq = {};
+    QueryPerformanceCounter(&now);
+    QueryPerformanceFrequency(&freq);
+    return (double) (now.QuadPart - start.QuadPart) / freq.QuadPart;
+}
+
+struct TestArgs {
+    std::wstring goldCsv_;
+};
+
+// Checks that every row of a gold CSV splits into the same number of cells
+// as its header, and reports the reader's throughput both splitting rows and
+// splitting + converting every numeric cell.
+class Tests : public ::testing::Test, TestArgs {
+public:
+    explicit Tests(TestArgs const& args)
+    {
+        TestArgs::operator=(args);
+    }
+
+    // Returns the number of rows read, or SIZE_MAX if a row was malformed.
+    size_t ReadAll(CsvReader* reader, bool convert, double* checksum)
+    {
+        std::vector<std::string_view> cells;
+        reader->Rewind();
+        if (!reader->ReadRow(&cells)) {
+            return 0;
+        }
+
+        auto columnCount = cells.size();
+        size_t rowCount = 0;
+        while (reader->ReadRow(&cells)) {
+            if (cells.size() != columnCount) {
+                AddTestFailure(__FILE__, __LINE__, "Line %zu has %zu columns, expected %zu", reader->GetLine(), cells.size(), columnCount);
+                return SIZE_MAX;
+            }
+            if (convert) {
+                for (auto cell : cells) {
+                    double value = 0.0;
+                    if (ParseCsvNumber(cell, &value)) {
+                        *checksum += value;
+                    }
+                }
+            }
+            rowCount += 1;
+        }
+        return rowCount;
+    }
+
+    void TestBody() override
+    {
+        CsvReader reader;
+        if (!reader.Open(goldCsv_.c_str())) {
+            AddTestFailure(__FILE__, __LINE__, "Failed to open file: %ls", goldCsv_.c_str());
+            return;
+        }
+
+        auto fileSize = reader.GetFileSize();
+        if (fileSize == 0) {
+            return;
+        }
+
+        auto passCount = (kMinBenchmarkBytes + fileSize - 1) / fileSize;
+        double checksum = 0.0;
+        double seconds[2] = {};
+        size_t rowCount = 0;
+        for (uint32_t convert = 0; convert < 2; ++convert) {
+            LARGE_INTEGER start = {};
+            QueryPerformanceCounter(&start);
+            for (uint64_t pass = 0; pass < passCount; ++pass) {
+                rowCount = ReadAll(&reader, convert == 1, &checksum);
+                if (rowCount == SIZE_MAX) {
+                    return;
+                }
+            }
+            seconds[convert] = GetSeconds(start);
+        }
+
+        reader.Close();
+
+        auto gigabytes = 1e-9 * fileSize * passCount;
+        printf("    %zu rows, %.1f MB: split %.2f GB/s, split+convert %.2f GB/s (checksum %g)\n",
+            rowCount,
+            1e-6 * fileSize,
+            seconds[0] > 0.0 ? gigabytes / seconds[0] : 0.0,
+            seconds[1] > 0.0 ? gigabytes / seconds[1] : 0.0,
+            checksum);
+    }
+};
+
+}
+
+void AddCsvReaderTest(
+    std::wstring const& goldCsv,
+    std::string const& name)
+{
+    TestArgs args;
+    args.goldCsv_ = goldCsv;
+
+    ::testing::RegisterTest(
+        "CsvReaderTests", name.c_str(), nullptr, nullptr, __FILE__, __LINE__,
+        [=]() -> ::testing::Test* { return new Tests(std::move(args)); });
+}
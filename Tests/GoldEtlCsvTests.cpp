@@ -52,77 +52,41 @@ public:
             return;
         }
 
+        goldCsv.Close();
+        testCsv.Close();
+
         // Compare gold/test CSV data rows
-        for (;;) {
-            auto goldDone = !goldCsv.ReadRow();
-            auto testDone = !testCsv.ReadRow();
-            if (goldDone || testDone) {
-                if (!goldDone || !testDone) {
-                    AddTestFailure(__FILE__, __LINE__, "GOLD and TEST CSV had different number of rows");
-                    printf("GOLD = %ls\n", goldCsv_.c_str());
-                    printf("TEST = %ls\n", testCsv_.c_str());
-                }
-                break;
-            }
+        CsvCompareOptions options;
+        if (reportAllCsvDiffs_) {
+            options.mMaxDiffsPerColumn = SIZE_MAX;
+        }
+        options.mValidateTestRow = [&](std::vector<std::string_view> const& row, std::string* error) { return testCsv.ValidateRow(row, error); };
+        options.mValidateGoldRow = [&](std::vector<std::string_view> const& row, std::string* error) { return goldCsv.ValidateRow(row, error); };
 
-            auto rowOk = true;
-            for (size_t h = 0; h < PresentMonCsv::KnownHeaderCount; ++h) {
-                if (testCsv.headerColumnIndex_[h] != SIZE_MAX && goldCsv.headerColumnIndex_[h] != SIZE_MAX) {
-                    // Need to protect against missing columns on each line as
-                    // the file may be corrupted.
-                    auto testColIdx = testCsv.headerColumnIndex_[h];
-                    auto goldColIdx = goldCsv.headerColumnIndex_[h];
-                    char const* a = testColIdx < testCsv.cols_.size() ? testCsv.cols_[testColIdx] : "<missing>";
-                    char const* b = goldColIdx < goldCsv.cols_.size() ? goldCsv.cols_[goldColIdx] : "<missing>";
-                    if (_stricmp(a, b) == 0) {
-                        continue;
-                    }
-
-                    // Different versions of PresentMon may output different decimal precision.  Also, 
-                    // floating point may be inconsistently rounded by printf() on different platforms.
-                    // Therefore, we do a rounding check by ensuring the difference between the two
-                    // numbers is less than 1 in the final printed digit.
-
-                    double testNumber = 0.0;
-                    double goldNumber = 0.0;
-                    int testSucceededCount = sscanf_s(a, "%lf", &testNumber);
-                    int goldSucceededCount = sscanf_s(b, "%lf", &goldNumber);
-                    if (testSucceededCount == 1 && goldSucceededCount == 1) {
-                        const char* testDecimalAddr = strchr(a, '.');
-                        const char* goldDecimalAddr = strchr(b, '.');
-                        size_t testDecimalNumbersCount = testDecimalAddr == nullptr ? 0 : ((a + strlen(a)) - testDecimalAddr - 1);
-                        size_t goldDecimalNumbersCount = goldDecimalAddr == nullptr ? 0 : ((b + strlen(b)) - goldDecimalAddr - 1);
-                        double threshold = pow(0.1, std::min(testDecimalNumbersCount, goldDecimalNumbersCount));
-                        double difference = testNumber - goldNumber;
-
-                        if (difference > -threshold && difference < threshold) {
-                            continue;
-                        }
-                    }
-
-                    if (rowOk) {
-                        rowOk = false;
-                        printf("GOLD = %ls\n", goldCsv_.c_str());
-                        printf("TEST = %ls\n", testCsv_.c_str());
-                        AddTestFailure(__FILE__, __LINE__, "Difference on line: %zu", testCsv.line_);
-                        printf("    COLUMN                    TEST VALUE                            GOLD VALUE\n");
-                    }
-
-                    auto r = printf("    %s", testCsv.GetHeaderString((PresentMonCsv::Header) h));
-                    printf("%*s", r < 29 ? 29 - r : 0, "");
-                    r = printf(" %s", a);
-                    printf("%*s", r < 38 ? 38 - r : 0, "");
-                    printf(" %s\n", b);
-                }
+        CsvCompareReport report;
+        if (!CompareCsvFiles(testCsv_.c_str(), goldCsv_.c_str(), options, &report)) {
+            AddTestFailure(__FILE__, __LINE__, "Failed to open CSV files for comparison");
+            return;
+        }
+
+        if (report.HasDifferences()) {
+            printf("GOLD = %ls\n", goldCsv_.c_str());
+            printf("TEST = %ls\n", testCsv_.c_str());
+            if (report.mTestRowCount != report.mGoldRowCount) {
+                AddTestFailure(__FILE__, __LINE__, "GOLD and TEST CSV had different number of rows");
+            }
+            if (report.mTestInvalidRow.mLine != 0) {
+                AddTestFailure(Convert(testCsv_).c_str(), (int) report.mTestInvalidRow.mLine, "%s", report.mTestInvalidRow.mError.c_str());
+            }
+            if (report.mGoldInvalidRow.mLine != 0) {
+                AddTestFailure(Convert(goldCsv_).c_str(), (int) report.mGoldInvalidRow.mLine, "%s", report.mGoldInvalidRow.mError.c_str());
             }
-            if (!reportAllCsvDiffs_ && !rowOk) {
-                break;
+            if (report.mDiffRowCount != 0) {
+                AddTestFailure(__FILE__, __LINE__, "Difference on line: %zu", report.mFirstDiffLine);
             }
+            PrintCsvCompareReport(stdout, report);
         }
 
-        goldCsv.Close();
-        testCsv.Close();
-
         if (::testing::Test::HasFailure() && !diffPath_.empty()) {
             std::wstring cmd;
             cmd += diffPath_;
@@ -198,6 +162,9 @@ void AddGoldEtlCsvTests(
                                 "GoldEtlCsvTests", name.c_str(), nullptr, nullptr, __FILE__, __LINE__,
                                 [=]() -> ::testing::Test* { return new Tests(std::move(args)); });
 
+                            AddColumnarTest(etl, args.goldCsv_, name);
+                            AddCsvReaderTest(args.goldCsv_, name);
+
                             csvCount += 1;
                         }
                     } while (FindNextFile(csvh, &csvff) != 0);
@@ -0,0 +1,112 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "PresentMonTests.h"
+#include "../PresentMon/GpuEngineTimeline.hpp"
+
+namespace {
+
+using Row = GpuEngineTimeline::Row;
+
+void ExpectRows(std::vector<Row> const& expected, std::vector<Row> const& actual)
+{
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i].mBinStart,  actual[i].mBinStart)  << "row " << i;
+        EXPECT_EQ(expected[i].mEngineId,  actual[i].mEngineId)  << "row " << i;
+        EXPECT_EQ(expected[i].mProcessId, actual[i].mProcessId) << "row " << i;
+        EXPECT_EQ(expected[i].mBusyTime,  actual[i].mBusyTime)  << "row " << i;
+    }
+}
+
+}
+
+TEST(GpuEngineTimelineTests, Binning)
+{
+    // Start at 1000, 100-tick bins, and flush bins 200 ticks after they end.
+    GpuEngineTimeline timeline(1000, 100, 200);
+    std::vector<Row> rows;
+
+    // { start, end, pid, engineId }
+    timeline.Add({ 1010, 1050, 1, 0 });
+    timeline.Add({ 1020, 1030, 2, 0 });
+    timeline.Add({ 1040, 1060, 1, 1 });
+    timeline.Add({ 1090, 1230, 1, 0 });     // Spans bins 0-2
+    timeline.Add({  900, 1005, 3, 0 });     // Clipped to the start time
+    timeline.Add({  800,  900, 3, 0 });     // Before the start time
+    timeline.Add({ 1100, 1100, 3, 0 });     // Empty
+
+    // Nothing has ended 200 ticks after the end of bin 0 yet.
+    timeline.Flush(false, &rows);
+    EXPECT_TRUE(rows.empty());
+
+    timeline.Add({ 1400, 1410, 1, 0 });
+    timeline.Flush(false, &rows);
+    ExpectRows({
+        { 1000, 0, 1,  50 },
+        { 1000, 0, 2,  10 },
+        { 1000, 0, 3,   5 },
+        { 1000, 1, 1,  20 },
+        { 1100, 0, 1, 100 },
+    }, rows);
+    rows.clear();
+
+    // The part of this interval in bin 1 has already been flushed, so it is dropped.
+    timeline.Add({ 1150, 1320, 4, 0 });
+    timeline.Flush(true, &rows);
+    ExpectRows({
+        { 1200, 0, 1,  30 },
+        { 1200, 0, 4, 100 },
+        { 1300, 0, 4,  20 },
+        { 1400, 0, 1,  10 },
+    }, rows);
+    rows.clear();
+
+    timeline.Flush(true, &rows);
+    EXPECT_TRUE(rows.empty());
+}
+
+TEST(GpuEngineTimelineTests, IntervalRing)
+{
+    // Capacity is rounded up to 4.
+    GpuBusyIntervalRing ring(3);
+    std::vector<GpuBusyInterval> intervals;
+
+    EXPECT_EQ(0u, ring.RegisterEngine(0x1000, 0));
+    EXPECT_EQ(1u, ring.RegisterEngine(0x1000, 2));
+    ring.SetEngineType(1, 3);
+
+    std::vector<GpuEngineInfo> engines;
+    ring.GetEngines(&engines);
+    ASSERT_EQ(2u, engines.size());
+    EXPECT_EQ(0x1000u, engines[0].mAdapter);
+    EXPECT_EQ(0u, engines[0].mNodeOrdinal);
+    EXPECT_EQ(GpuBusyIntervalRing::kUnknownEngineType, engines[0].mEngineType);
+    EXPECT_EQ(2u, engines[1].mNodeOrdinal);
+    EXPECT_EQ(3u, engines[1].mEngineType);
+
+    for (uint32_t i = 0; i < 5; ++i) {
+        ring.Push(i, i + 1, 100 + i, i % 2);
+    }
+    EXPECT_EQ(1u, ring.GetDroppedCount());
+
+    ring.Dequeue(&intervals);
+    ASSERT_EQ(4u, intervals.size());
+    for (uint32_t i = 0; i < 4; ++i) {
+        EXPECT_EQ(i,         intervals[i].mStartTime);
+        EXPECT_EQ(i + 1,     intervals[i].mEndTime);
+        EXPECT_EQ(100 + i,   intervals[i].mProcessId);
+        EXPECT_EQ(i % 2,     intervals[i].mEngineId);
+    }
+    intervals.clear();
+
+    // Wrap around the end of the ring.
+    for (uint32_t i = 10; i < 13; ++i) {
+        ring.Push(i, i + 1, 100 + i, 0);
+    }
+    ring.Dequeue(&intervals);
+    ASSERT_EQ(3u, intervals.size());
+    EXPECT_EQ(10u, intervals[0].mStartTime);
+    EXPECT_EQ(12u, intervals[2].mStartTime);
+    EXPECT_EQ(1u, ring.GetDroppedCount());
+}
@@ -0,0 +1,236 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include <chrono>
+#include <deque>
+#include <random>
+#include "PresentMonTests.h"
+#include "../PresentData/GpuPacketQueue.hpp"
+
+namespace {
+
+struct FakePacketTrace {
+    uint32_t mCompletedCount;
+};
+
+using Queue = GpuPacketQueue<FakePacketTrace>;
+
+// Reference implementation: the same interface backed by a std::deque and linear search.
+struct ReferenceQueue {
+    std::deque<Queue::EnqueuedPacket> mPackets;
+
+    uint32_t GetCount() const                 { return (uint32_t) mPackets.size(); }
+    bool IsEmpty() const                      { return mPackets.empty(); }
+    Queue::EnqueuedPacket& At(uint32_t i)     { return mPackets[i]; }
+    Queue::EnqueuedPacket& Front()            { return mPackets.front(); }
+    void PushBack(FakePacketTrace* packetTrace, uint32_t sequenceId) { mPackets.push_back({ packetTrace, sequenceId, false }); }
+    void PopFront()                           { mPackets.pop_front(); }
+    void DropFront(uint32_t count)            { mPackets.erase(mPackets.begin(), mPackets.begin() + count); }
+    uint32_t FindSequenceId(uint32_t sequenceId) const
+    {
+        for (uint32_t i = 1; i < GetCount(); ++i) {
+            if (mPackets[i].mSequenceId == sequenceId) {
+                return i;
+            }
+        }
+        return Queue::kNotFound;
+    }
+};
+
+// Mirrors the queue handling in GpuTrace::CompleteWork().
+template<typename Q>
+bool CompleteWork(Q* queue, uint32_t sequenceId)
+{
+    if (queue->IsEmpty()) {
+        return false;
+    }
+
+    auto runningSequenceId = queue->Front().mSequenceId;
+    if (sequenceId < runningSequenceId) {
+        return false;
+    }
+
+    if (sequenceId > runningSequenceId) {
+        auto missingCount = queue->FindSequenceId(sequenceId);
+        if (missingCount == Queue::kNotFound) {
+            return false;
+        }
+
+        auto entry = &queue->At(missingCount);
+        if (entry->mPacketTrace == nullptr) {
+            entry->mCompleted = true;
+            return true;
+        }
+
+        *entry = queue->Front();
+        queue->DropFront(missingCount);
+    }
+
+    if (queue->Front().mPacketTrace != nullptr) {
+        queue->Front().mPacketTrace->mCompletedCount += 1;
+    }
+
+    for (;;) {
+        queue->PopFront();
+        if (queue->IsEmpty() ||
+            queue->Front().mPacketTrace != nullptr ||
+            !queue->Front().mCompleted) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+// Synthetic submission stream for one node: mostly consecutive sequence ids with occasional gaps
+// (packets from untracked processes) and rare restarts (ids that are not increasing).
+struct NodeStream {
+    uint32_t mNextSequenceId = 1;
+
+    uint32_t Next(std::mt19937* rng, bool allowRestart)
+    {
+        auto r = (*rng)() % 1000;
+        if (r == 0 && allowRestart) {
+            mNextSequenceId = 1 + (*rng)() % 64;
+        } else if (r < 100) {
+            mNextSequenceId += 1 + (*rng)() % 4;
+        }
+        return mNextSequenceId++;
+    }
+};
+
+constexpr uint32_t kNodeCount = 8;
+
+}
+
+TEST(GpuPacketQueueTests, MatchesReference)
+{
+    std::mt19937 rng(1234);
+    FakePacketTrace traces[4] = {};
+    Queue queues[kNodeCount];
+    ReferenceQueue references[kNodeCount];
+    NodeStream streams[kNodeCount];
+
+    for (uint32_t op = 0; op < 2000000; ++op) {
+        auto nodeIndex = rng() % kNodeCount;
+        auto queue = &queues[nodeIndex];
+        auto reference = &references[nodeIndex];
+
+        // Vary the target depth over time so that queues grow well past the idle-shrink threshold
+        // and then drain.
+        auto deepPhase = (op / 100000) % 4 == 3;
+        auto targetDepth = deepPhase ? 2048u : 32u;
+        auto r = rng() % 100;
+        if (queue->GetCount() < targetDepth && r < (deepPhase ? 90u : 55u)) {
+            auto packetTrace = rng() % 5 == 0 ? nullptr : &traces[rng() % 4];
+            auto sequenceId = streams[nodeIndex].Next(&rng, true);
+            queue->PushBack(packetTrace, sequenceId);
+            reference->PushBack(packetTrace, sequenceId);
+        } else if (!reference->IsEmpty()) {
+            // Normally complete the running packet, but sometimes complete a later one (dropped
+            // completions, or an early wait-packet completion), an already-completed one, or one
+            // that was never enqueued.
+            uint32_t sequenceId = reference->Front().mSequenceId;
+            r = rng() % 100;
+            if (r < 15) {
+                sequenceId = reference->At(rng() % reference->GetCount()).mSequenceId;
+            } else if (r < 18) {
+                sequenceId -= 1;
+            } else if (r < 20) {
+                sequenceId += 100000;
+            }
+
+            auto result = CompleteWork(queue, sequenceId);
+            auto expected = CompleteWork(reference, sequenceId);
+            ASSERT_EQ(result, expected) << "op=" << op << " sequenceId=" << sequenceId;
+        }
+
+        ASSERT_EQ(queue->GetCount(), reference->GetCount()) << "op=" << op;
+        if (!reference->IsEmpty()) {
+            ASSERT_EQ(queue->Front().mSequenceId, reference->Front().mSequenceId) << "op=" << op;
+            ASSERT_EQ(queue->Front().mPacketTrace, reference->Front().mPacketTrace) << "op=" << op;
+        }
+        ASSERT_EQ(queue->GetCapacity() & (queue->GetCapacity() - 1), 0u) << "op=" << op;
+    }
+
+    for (uint32_t i = 0; i < kNodeCount; ++i) {
+        ASSERT_EQ(queues[i].GetCount(), references[i].GetCount());
+        for (uint32_t j = 0; j < references[i].GetCount(); ++j) {
+            EXPECT_EQ(queues[i].At(j).mSequenceId, references[i].At(j).mSequenceId);
+            EXPECT_EQ(queues[i].At(j).mPacketTrace, references[i].At(j).mPacketTrace);
+            EXPECT_EQ(queues[i].At(j).mCompleted, references[i].At(j).mCompleted);
+        }
+    }
+}
+
+// Once the ids are not increasing an id can be enqueued twice, and the first match must be found
+// even when the later one is at the slot the id would have if the ids were consecutive.
+TEST(GpuPacketQueueTests, UnorderedFindsFirstMatch)
+{
+    FakePacketTrace trace = {};
+    Queue queue;
+    for (auto sequenceId : { 10u, 13u, 12u, 13u }) {
+        queue.PushBack(&trace, sequenceId);
+    }
+    EXPECT_EQ(queue.FindSequenceId(13), 1u);
+    EXPECT_EQ(queue.FindSequenceId(12), 2u);
+    EXPECT_EQ(queue.FindSequenceId(11), Queue::kNotFound);
+
+    // Draining the queue makes it ordered again.
+    queue.DropFront(queue.GetCount());
+    for (auto sequenceId : { 20u, 21u, 23u }) {
+        queue.PushBack(&trace, sequenceId);
+    }
+    EXPECT_EQ(queue.FindSequenceId(21), 1u);
+    EXPECT_EQ(queue.FindSequenceId(23), 2u);
+    EXPECT_EQ(queue.FindSequenceId(22), Queue::kNotFound);
+}
+
+TEST(GpuPacketQueueTests, Benchmark)
+{
+    constexpr uint32_t kPairCount = 8000000;
+
+    std::mt19937 rng(5678);
+    FakePacketTrace traces[4] = {};
+    Queue queues[kNodeCount];
+    NodeStream streams[kNodeCount];
+
+    // Fill each node with a few packets, then pre-generate the operations so that only the queue
+    // work is timed.
+    for (uint32_t i = 0; i < kNodeCount; ++i) {
+        for (uint32_t j = 0; j < 8; ++j) {
+            queues[i].PushBack(&traces[0], streams[i].Next(&rng, false));
+        }
+    }
+
+    // Each pair enqueues one packet and completes one, keeping each node's depth around its
+    // initial fill.  1 in 8 completions skip ahead over missing completions, and 1 in 8 packets
+    // are wait packets (which complete early when skipped to).
+    struct Op {
+        uint32_t mNodeIndex;
+        uint32_t mCompleteOffset;
+        FakePacketTrace* mPacketTrace;
+        uint32_t mSequenceId;
+    };
+    std::vector<Op> ops(kPairCount);
+    for (auto& op : ops) {
+        op.mNodeIndex = rng() % kNodeCount;
+        op.mCompleteOffset = rng() % 8 == 0 ? 1 + rng() % 3 : 0;
+        op.mPacketTrace = rng() % 8 == 0 ? nullptr : &traces[rng() % 4];
+        op.mSequenceId = streams[op.mNodeIndex].Next(&rng, false);
+    }
+
+    uint64_t completedCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (auto const& op : ops) {
+        auto queue = &queues[op.mNodeIndex];
+        queue->PushBack(op.mPacketTrace, op.mSequenceId);
+        auto offset = op.mCompleteOffset < queue->GetCount() ? op.mCompleteOffset : 0;
+        completedCount += CompleteWork(queue, queue->At(offset).mSequenceId) ? 1 : 0;
+    }
+    auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    EXPECT_GT(completedCount, 0u);
+    printf("    %u enqueue/complete pairs across %u nodes in %.3fs (%.1f ns/pair)\n",
+        kPairCount, kNodeCount, seconds, 1e9 * seconds / kPairCount);
+}
@@ -0,0 +1,132 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include <vector>
+#include "PresentMonTests.h"
+#include "../PresentData/PresentMonTraceConsumer.hpp"
+
+namespace {
+
+constexpr uint64_t kAdapter = 0xA000;
+constexpr uint64_t kDevice = 0xD000;
+
+struct ExpectedInterval {
+    uint64_t mStartTime;
+    uint64_t mEndTime;
+    uint32_t mProcessId;
+    uint32_t mEngineId;
+};
+
+void ExpectIntervals(GpuBusyIntervalRing* ring, std::vector<ExpectedInterval> const& expected)
+{
+    std::vector<GpuBusyInterval> intervals;
+    ring->Dequeue(&intervals);
+    ASSERT_EQ(intervals.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(intervals[i].mStartTime, expected[i].mStartTime) << "interval " << i;
+        EXPECT_EQ(intervals[i].mEndTime,   expected[i].mEndTime)   << "interval " << i;
+        EXPECT_EQ(intervals[i].mProcessId, expected[i].mProcessId) << "interval " << i;
+        EXPECT_EQ(intervals[i].mEngineId,  expected[i].mEngineId)  << "interval " << i;
+    }
+    EXPECT_EQ(ring->GetDroppedCount(), 0u);
+}
+
+}
+
+// A synthetic packet stream through GpuTrace, covering a node without hardware scheduling (DMA
+// packets) and one with two hardware queues for one process and one for another.
+TEST(GpuTraceTests, BusyIntervals)
+{
+    using namespace Microsoft_Windows_DxgKrnl;
+
+    GpuBusyIntervalRing ring(64);
+    PMTraceConsumer consumer;
+    consumer.mTrackGPU = true;
+    consumer.mGpuBusyIntervals = &ring;
+    auto gpuTrace = &consumer.mGpuTrace;
+
+    gpuTrace->RegisterDevice(kDevice, kAdapter);
+
+    // Engine 0: node 0, process 10.
+    gpuTrace->RegisterContext(0x100, kDevice, 0, 10);
+    gpuTrace->SetEngineType(kAdapter, 0, DXGK_ENGINE::_3D);
+
+    // Engine 1: node 1, with HwQueues 0x201 and 0x202 from process 10 and 0x301 from process 20.
+    gpuTrace->RegisterContext(0x200, kDevice, 1, 10);
+    gpuTrace->RegisterHwQueueContext(0x200, 0x201);
+    gpuTrace->RegisterHwQueueContext(0x200, 0x202);
+    gpuTrace->RegisterContext(0x300, kDevice, 1, 20);
+    gpuTrace->RegisterHwQueueContext(0x300, 0x301);
+    gpuTrace->SetEngineType(kAdapter, 1, DXGK_ENGINE::COPY);
+
+    // Back-to-back packets on one node.
+    gpuTrace->EnqueueDmaPacket(0x100, 1, 100);
+    gpuTrace->EnqueueDmaPacket(0x100, 2, 110);
+    gpuTrace->CompleteDmaPacket(0x100, 1, 150);
+    gpuTrace->CompleteDmaPacket(0x100, 2, 180);
+
+    // Overlapping packets from one process on two hardware queues of the same engine are
+    // reported as one interval, while another process' packet is reported on its own.
+    gpuTrace->EnqueueQueuePacket(0x201, 1, 10, 200, false);
+    gpuTrace->EnqueueQueuePacket(0x202, 1, 10, 220, false);
+    gpuTrace->EnqueueQueuePacket(0x301, 1, 20, 240, false);
+    gpuTrace->CompleteQueuePacket(0x201, 1, 260);
+    gpuTrace->CompleteQueuePacket(0x301, 1, 280);
+    gpuTrace->CompleteQueuePacket(0x202, 1, 300);
+
+    // A packet queued behind a wait packet starts when the wait completes.
+    gpuTrace->EnqueueQueuePacket(0x201, 2, 10, 400, true);
+    gpuTrace->EnqueueQueuePacket(0x201, 3, 10, 410, false);
+    gpuTrace->CompleteQueuePacket(0x201, 2, 450);
+    gpuTrace->CompleteQueuePacket(0x201, 3, 500);
+
+    // A missed completion: packet 2 is treated as running until packet 3 completes.
+    gpuTrace->EnqueueDmaPacket(0x100, 2, 600);
+    gpuTrace->EnqueueDmaPacket(0x100, 3, 610);
+    gpuTrace->CompleteDmaPacket(0x100, 3, 700);
+
+    ExpectIntervals(&ring, {
+        { 100, 150, 10, 0 },
+        { 150, 180, 10, 0 },
+        { 240, 280, 20, 1 },
+        { 200, 300, 10, 1 },
+        { 450, 500, 10, 1 },
+        { 600, 700, 10, 0 },
+    });
+
+    std::vector<GpuEngineInfo> engines;
+    ring.GetEngines(&engines);
+    ASSERT_EQ(engines.size(), 2u);
+    EXPECT_EQ(engines[0].mAdapter, kAdapter);
+    EXPECT_EQ(engines[0].mNodeOrdinal, 0u);
+    EXPECT_EQ(engines[0].mEngineType, (uint32_t) DXGK_ENGINE::_3D);
+    EXPECT_EQ(engines[1].mAdapter, kAdapter);
+    EXPECT_EQ(engines[1].mNodeOrdinal, 1u);
+    EXPECT_EQ(engines[1].mEngineType, (uint32_t) DXGK_ENGINE::COPY);
+}
+
+// A packet that is still running when its hardware queue is destroyed is not reported, and does
+// not keep the engine busy for later packets.
+TEST(GpuTraceTests, BusyIntervalsAfterHwQueueDestroyed)
+{
+    GpuBusyIntervalRing ring(64);
+    PMTraceConsumer consumer;
+    consumer.mTrackGPU = true;
+    consumer.mGpuBusyIntervals = &ring;
+    auto gpuTrace = &consumer.mGpuTrace;
+
+    gpuTrace->RegisterDevice(kDevice, kAdapter);
+    gpuTrace->RegisterContext(0x200, kDevice, 1, 10);
+    gpuTrace->RegisterHwQueueContext(0x200, 0x201);
+    gpuTrace->EnqueueQueuePacket(0x201, 1, 10, 100, false);
+    gpuTrace->UnregisterContext(0x200);
+
+    gpuTrace->RegisterContext(0x300, kDevice, 1, 10);
+    gpuTrace->RegisterHwQueueContext(0x300, 0x301);
+    gpuTrace->EnqueueQueuePacket(0x301, 1, 10, 200, false);
+    gpuTrace->CompleteQueuePacket(0x301, 1, 250);
+
+    ExpectIntervals(&ring, {
+        { 200, 250, 10, 0 },
+    });
+}
@@ -60,17 +60,37 @@ bool CheckAllIfAny(size_t const* columnIndex, bool* ok, std::initializer_list<Pr
     return false;
 }
 
-PresentMonCsv::Header FindHeader(char const* header)
+PresentMonCsv::Header FindHeader(std::string_view header)
 {
     for (uint32_t i = 0; i < PresentMonCsv::KnownHeaderCount; ++i) {
         auto h = (PresentMonCsv::Header) i;
-        if (strcmp(header, PresentMonCsv::GetHeaderString(h)) == 0) {
+        if (header == PresentMonCsv::GetHeaderString(h)) {
             return h;
         }
     }
     return PresentMonCsv::UnknownHeader;
 }
 
+void SetError(std::string* error, char const* fmt, ...)
+{
+    char buffer[512];
+
+    va_list val;
+    va_start(val, fmt);
+    vsnprintf(buffer, _countof(buffer), fmt, val);
+    va_end(val);
+
+    *error = buffer;
+}
+
+// Non-numeric cells (e.g., "NA") are treated as 0.
+double CellToDouble(std::string_view cell)
+{
+    double value = 0.0;
+    ParseCsvNumber(cell, &value);
+    return value;
+}
+
 }
 
 bool PresentMonCsv::Open(char const* file, int line, std::wstring const& path)
@@ -83,19 +103,11 @@ bool PresentMonCsv::Open(char const* file, int line, std::wstring const& path)
     path_ = path;
     line_ = 0;
 
-    if (_wfopen_s(&fp_, path.c_str(), L"r")) {
+    if (!reader_.Open(path.c_str())) {
         AddTestFailure(file, line, "Failed to open file: %ls", path.c_str());
         return false;
     }
 
-    // Remove UTF-8 marker if there is one.
-    if (fread(row_, 3, 1, fp_) != 1 ||
-        row_[0] != -17 || // 0xef
-        row_[1] != -69 || // 0xbb
-        row_[2] != -65) { // 0xbf
-        fseek(fp_, 0, SEEK_SET);
-    }
-
     // Read the header and ensure required columns are present
     ReadRow();
 
@@ -104,11 +116,11 @@ bool PresentMonCsv::Open(char const* file, int line, std::wstring const& path)
         switch (h) {
         case KnownHeaderCount:
         case UnknownHeader:
-            AddTestFailure(Convert(path_).c_str(), (int) line_, "Unrecognised column: %s", cols_[i]);
+            AddTestFailure(Convert(path_).c_str(), (int) line_, "Unrecognised column: %.*s", (int) cols_[i].size(), cols_[i].data());
             break;
         default:
             if (headerColumnIndex_[(size_t) h] != SIZE_MAX) {
-                AddTestFailure(Convert(path_).c_str(), (int) line_, "Duplicate column: %s", cols_[i]);
+                AddTestFailure(Convert(path_).c_str(), (int) line_, "Duplicate column: %.*s", (int) cols_[i].size(), cols_[i].data());
             } else {
                 headerColumnIndex_[(size_t) h] = i;
             }
@@ -199,74 +211,67 @@ bool PresentMonCsv::Open(char const* file, int line, std::wstring const& path)
 
 void PresentMonCsv::Close()
 {
-    fclose(fp_);
-    fp_ = nullptr;
+    reader_.Close();
+    cols_.clear();
 }
 
 bool PresentMonCsv::ReadRow()
 {
-    row_[0] = '\0';
-    cols_.clear();
-
-    // Read a line
-    if (fgets(row_, _countof(row_), fp_) == nullptr) {
-        if (ferror(fp_) != 0) {
-            AddTestFailure(Convert(path_).c_str(), (int) line_, "File read error");
-        }
+    // Read a line, split into columns with leading/trailing whitespace
+    // removed
+    if (!reader_.ReadRow(&cols_)) {
         return false;
     }
 
-    line_ += 1;
-
-    // Split line into columns, skipping leading/trailing whitespace
-    auto p0 = row_;
-    for (; *p0 == ' ' || *p0 == '\t'; ++p0) *p0 = '\0';
-    for (auto p = p0; ; ++p) {
-        auto ch = *p;
-        if (ch == ',' || ch == '\0') {
-            *p = '\0';
-            cols_.push_back(p0);
-            for (p0 = p + 1; *p0 == ' ' || *p0 == '\t'; ++p0) *p0 = '\0';
-            for (auto q = p - 1; *q == ' ' || *q == '\t' || *q == '\n' || *q == '\r'; --q) *q = '\0';
-            if (ch == '\0') break;
-        }
-    }
+    line_ = reader_.GetLine();
 
     // Hard-code some per-row validation
+    std::string error;
+    if (!ValidateRow(cols_, &error)) {
+        AddTestFailure(Convert(path_).c_str(), (int) line_, "%s", error.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool PresentMonCsv::ValidateRow(std::vector<std::string_view> const& cols, std::string* error) const
+{
+    auto Cell = [&](size_t idx) -> std::string_view { return idx < cols.size() ? cols[idx] : "<missing>"; };
 
     auto idxFrameTime = headerColumnIndex_[Header_FrameTime];
     auto idxCPUBusy   = headerColumnIndex_[Header_CPUBusy];
     auto idxCPUWait   = headerColumnIndex_[Header_CPUWait];
     if (idxFrameTime != SIZE_MAX && idxCPUBusy != SIZE_MAX && idxCPUWait != SIZE_MAX) {
-        auto delta = strtod(cols_[idxFrameTime], nullptr) -
-                     strtod(cols_[idxCPUBusy], nullptr) -
-                     strtod(cols_[idxCPUWait], nullptr);
+        auto FrameTime = Cell(idxFrameTime);
+        auto CPUBusy   = Cell(idxCPUBusy);
+        auto CPUWait   = Cell(idxCPUWait);
+        auto delta = CellToDouble(FrameTime) - CellToDouble(CPUBusy) - CellToDouble(CPUWait);
         if (delta <= -0.0001 || delta >= 0.0001) {
-            AddTestFailure(__FILE__, __LINE__, "Invalid FrameTime: %s != %s + %s (%lf)", cols_[idxFrameTime],
-                                                                                         cols_[idxCPUBusy],
-                                                                                         cols_[idxCPUWait],
-                                                                                         delta);
+            SetError(error, "Invalid FrameTime: %.*s != %.*s + %.*s (%lf)", (int) FrameTime.size(), FrameTime.data(),
+                                                                           (int) CPUBusy.size(),   CPUBusy.data(),
+                                                                           (int) CPUWait.size(),   CPUWait.data(),
+                                                                           delta);
             return false;
         }
     }
 
-    auto idxGPUTime = headerColumnIndex_[Header_GPUTime];
-    auto idxGPUBusy = headerColumnIndex_[Header_GPUBusy];
-    auto idxGPUWait = headerColumnIndex_[Header_GPUWait];
+    auto idxGPUTime   = headerColumnIndex_[Header_GPUTime];
+    auto idxGPUBusy   = headerColumnIndex_[Header_GPUBusy];
+    auto idxGPUWait   = headerColumnIndex_[Header_GPUWait];
+    auto idxVideoBusy = headerColumnIndex_[Header_VideoBusy];
     if (idxGPUTime != SIZE_MAX && idxGPUBusy != SIZE_MAX && idxGPUWait != SIZE_MAX) {
-        auto delta = strtod(cols_[idxGPUTime], nullptr) -
-                     strtod(cols_[idxGPUBusy], nullptr) -
-                     strtod(cols_[idxGPUWait], nullptr);
-        auto idxVideoBusy = headerColumnIndex_[Header_VideoBusy];
-        if (idxVideoBusy != SIZE_MAX) {
-            delta -= strtod(cols_[idxVideoBusy], nullptr);
-        }
+        auto GPUTime   = Cell(idxGPUTime);
+        auto GPUBusy   = Cell(idxGPUBusy);
+        auto GPUWait   = Cell(idxGPUWait);
+        auto VideoBusy = idxVideoBusy == SIZE_MAX ? std::string_view("0") : Cell(idxVideoBusy);
+        auto delta = CellToDouble(GPUTime) - CellToDouble(GPUBusy) - CellToDouble(GPUWait) - CellToDouble(VideoBusy);
         if (delta <= -0.0001 || delta >= 0.0001) {
-            AddTestFailure(__FILE__, __LINE__, "Invalid GPUTime: %s != %s + %s + %s (%lf)", cols_[idxGPUTime],
-                                                                                            cols_[idxGPUBusy],
-                                                                                            cols_[idxGPUWait],
-                                                                                            idxVideoBusy == SIZE_MAX ? "0" : cols_[idxVideoBusy],
-                                                                                            delta);
+            SetError(error, "Invalid GPUTime: %.*s != %.*s + %.*s + %.*s (%lf)", (int) GPUTime.size(),   GPUTime.data(),
+                                                                                (int) GPUBusy.size(),   GPUBusy.data(),
+                                                                                (int) GPUWait.size(),   GPUWait.data(),
+                                                                                (int) VideoBusy.size(), VideoBusy.data(),
+                                                                                delta);
             return false;
         }
     }
@@ -275,16 +280,18 @@ bool PresentMonCsv::ReadRow()
     auto idxDisplayLatency       = headerColumnIndex_[Header_DisplayLatency];
     auto idxClickToPhotonLatency = headerColumnIndex_[Header_ClickToPhotonLatency];
     if (idxDisplayedTime != SIZE_MAX && idxDisplayLatency != SIZE_MAX) {
-        auto DisplayedTime  = cols_[idxDisplayedTime];
-        auto DisplayLatency = cols_[idxDisplayLatency];
-        if (strcmp(DisplayedTime, "NA") == 0 || strcmp(DisplayLatency, "NA") == 0) {
-            if (strcmp(DisplayedTime, "NA") != 0 || strcmp(DisplayLatency, "NA") != 0) {
-                AddTestFailure(__FILE__, __LINE__, "    Invalid display metrics: %s, %s", DisplayedTime, DisplayLatency);
+        auto DisplayedTime  = Cell(idxDisplayedTime);
+        auto DisplayLatency = Cell(idxDisplayLatency);
+        if (DisplayedTime == "NA" || DisplayLatency == "NA") {
+            if (DisplayedTime != "NA" || DisplayLatency != "NA") {
+                SetError(error, "Invalid display metrics: %.*s, %.*s", (int) DisplayedTime.size(),  DisplayedTime.data(),
+                                                                       (int) DisplayLatency.size(), DisplayLatency.data());
                 return false;
             }
 
-            if (idxClickToPhotonLatency != SIZE_MAX && strcmp(cols_[idxClickToPhotonLatency], "NA") != 0) {
-                AddTestFailure(__FILE__, __LINE__, "    Invalid ClickToPhotonLatency when not displayed: %s", cols_[idxClickToPhotonLatency]);
+            if (idxClickToPhotonLatency != SIZE_MAX && Cell(idxClickToPhotonLatency) != "NA") {
+                auto ClickToPhotonLatency = Cell(idxClickToPhotonLatency);
+                SetError(error, "Invalid ClickToPhotonLatency when not displayed: %.*s", (int) ClickToPhotonLatency.size(), ClickToPhotonLatency.data());
                 return false;
             }
         }
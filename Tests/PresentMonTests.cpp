@@ -201,7 +201,7 @@ int wmain(
                 "    --outdir=path        Path to directory for test outputs (default=%%temp%%/PresentMonTestOutput).\n"
                 "    --nodelete           Keep the output directory after tests.\n"
                 "    --nowarnmissing      Don't warn if a found ETL is missing a gold CSV.\n"
-                "    --allcsvdiffs        Report all CSV differences, not just the first.\n"
+                "    --allcsvdiffs        Report all CSV differences, not just the first few per column.\n"
                 "    --diff=path          Start an extra process to compare each differing CSV.\n"
                 "\n",
                 PresentMon::exePath_.c_str(),
@@ -7,9 +7,13 @@
 
 #include <gtest/gtest.h>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <windows.h>
 
+#include "CsvCompare.h"
+#include "CsvReader.h"
+
 struct PresentMonCsv
 {
     enum Header {
@@ -122,20 +126,23 @@ struct PresentMonCsv
 
     std::wstring path_;
     size_t line_ = 0;
-    FILE* fp_ = nullptr;
+    CsvReader reader_;
 
     // headerColumnIndex_[h] is the file column index where h was found, or SIZE_MAX if
     // h wasn't found in the file.
     size_t headerColumnIndex_[KnownHeaderCount];
 
-    char row_[1024];
-    std::vector<char const*> cols_;
+    std::vector<std::string_view> cols_;
     std::vector<wchar_t const*> params_;
 
     bool Open(char const* file, int line, std::wstring const& path);
     void Close();
     bool ReadRow();
 
+    // Check the consistency of a row's metrics (e.g., FrameTime == CPUBusy +
+    // CPUWait).  Safe to call concurrently.
+    bool ValidateRow(std::vector<std::string_view> const& cols, std::string* error) const;
+
     size_t GetColumnIndex(char const* header) const;
 };
 
@@ -180,3 +187,9 @@ void AddTestFailure(char const* file, int line, char const* fmt, ...);
 
 // GoldEtlCsvTests.cpp
 void AddGoldEtlCsvTests(std::wstring const& dir, size_t relIdx);
+
+// ColumnarTests.cpp
+void AddColumnarTest(std::wstring const& etl, std::wstring const& goldCsv, std::string const& name);
+
+// CsvReaderTests.cpp
+void AddCsvReaderTest(std::wstring const& goldCsv, std::string const& name);
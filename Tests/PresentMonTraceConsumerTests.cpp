@@ -0,0 +1,261 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "PresentMonTests.h"
+#include "../PresentData/PresentMonTraceConsumer.hpp"
+
+namespace {
+
+constexpr uint32_t kDwmProcessId = 4;
+constexpr uint32_t kDwmThreadId = 8;
+
+EVENT_HEADER MakeHeader(uint32_t processId, uint32_t threadId, uint64_t timestamp)
+{
+    EVENT_HEADER hdr = {};
+    hdr.ProcessId = processId;
+    hdr.ThreadId = threadId;
+    hdr.TimeStamp.QuadPart = (LONGLONG) timestamp;
+    return hdr;
+}
+
+// Drives the consumer through the events of windowed flip presents that are handed off to DWM
+// (Present_Start, PresentHistory, PresentHistory_Info), one present per process, and returns the
+// presents now in mPresentsWaitingForDWM.
+std::vector<std::shared_ptr<PresentEvent>> StartPresentsWaitingForDwm(PMTraceConsumer* consumer, uint32_t count)
+{
+    // Skip the startup discard, which would throw these presents away at the first completion.
+    consumer->mHasCompletedAPresent = true;
+    consumer->DwmProcessId = kDwmProcessId;
+    consumer->DwmPresentThreadId = kDwmThreadId;
+
+    std::vector<std::shared_ptr<PresentEvent>> presents;
+    for (uint32_t i = 0; i < count; ++i) {
+        auto hdr = MakeHeader(100 + 4 * i, 1000 + 4 * i, 1000 + i);
+        auto token = 1 + i;
+        consumer->RuntimePresentStart(Runtime::DXGI, hdr, 0x10000 + i, 0, 0);
+        consumer->HandleDxgkPresentHistory(hdr, token, 0, Microsoft_Windows_DxgKrnl::PresentModel::D3DKMT_PM_REDIRECTED_FLIP);
+        consumer->HandleDxgkPresentHistoryInfo(hdr, token);
+
+        auto present = consumer->FindPresentByThreadId(hdr.ThreadId);
+        if (present == nullptr || !present->PresentInDwmWaitingStruct) {
+            break;
+        }
+        presents.emplace_back(present);
+    }
+    return presents;
+}
+
+// Returns the presents in mPresentsWaitingForDWM, in order, checking the list's links on the way.
+std::vector<PresentEvent*> WaitingForDwm(PMTraceConsumer const& consumer)
+{
+    std::vector<PresentEvent*> presents;
+    PresentEvent* prev = nullptr;
+    for (auto p = consumer.mPresentsWaitingForDWM.front(); p != nullptr; p = p->NextPresentWaitingForDWM.get()) {
+        EXPECT_TRUE(p->PresentInDwmWaitingStruct);
+        EXPECT_EQ(p->PrevPresentWaitingForDWM, prev);
+        presents.emplace_back(p);
+        prev = p;
+    }
+    EXPECT_EQ(presents.size(), consumer.mPresentsWaitingForDWM.size());
+    return presents;
+}
+
+std::shared_ptr<PresentEvent> MakeFrameIdPresent(uint32_t processId, uint32_t frameId, uint64_t timestamp)
+{
+    auto present = std::make_shared<PresentEvent>();
+    present->ProcessId = processId;
+    present->PresentStartTime = timestamp;
+    present->FrameId = frameId;
+    present->FinalState = PresentResult::Presented;
+    present->Displayed.emplace_back(FrameType::Application, timestamp + 10);
+    present->WaitingForFrameId = true;
+    return present;
+}
+
+}
+
+// Presents lost while waiting for DWM are unlinked right away, and must not be handed to the next
+// DWM present.
+TEST(PresentMonTraceConsumerTests, LostPresentsAreNotDwmDependents)
+{
+    PMTraceConsumer consumer;
+    auto presents = StartPresentsWaitingForDwm(&consumer, 8);
+    ASSERT_EQ(presents.size(), 8u);
+    ASSERT_EQ(consumer.mPresentsWaitingForDWM.size(), 8u);
+
+    for (size_t i : { 1, 3, 5 }) {
+        consumer.RemoveLostPresent(presents[i]);
+        EXPECT_TRUE(presents[i]->IsLost);
+        EXPECT_FALSE(presents[i]->PresentInDwmWaitingStruct);
+        EXPECT_EQ(presents[i]->NextPresentWaitingForDWM, nullptr);
+        EXPECT_EQ(presents[i]->PrevPresentWaitingForDWM, nullptr);
+    }
+
+    std::vector<std::shared_ptr<PresentEvent>> expected{ presents[0], presents[2], presents[4], presents[6], presents[7] };
+    auto waiting = WaitingForDwm(consumer);
+    ASSERT_EQ(waiting.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(waiting[i], expected[i].get());
+    }
+
+    auto dwmPresent = consumer.HandleDxgkFlip(MakeHeader(kDwmProcessId, kDwmThreadId, 2000));
+    ASSERT_NE(dwmPresent, nullptr);
+
+    ASSERT_EQ(dwmPresent->DependentPresents.size(), expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(dwmPresent->DependentPresents[i], expected[i]);
+        EXPECT_FALSE(expected[i]->PresentInDwmWaitingStruct);
+        EXPECT_EQ(expected[i]->NextPresentWaitingForDWM, nullptr);
+    }
+    EXPECT_TRUE(consumer.mPresentsWaitingForDWM.empty());
+    EXPECT_EQ(consumer.mPresentsWaitingForDWM.front(), nullptr);
+}
+
+// Removing the first, last, or a middle present keeps the rest of the list linked in order.
+TEST(PresentMonTraceConsumerTests, DwmWaitingListRemoval)
+{
+    PMTraceConsumer consumer;
+    auto presents = StartPresentsWaitingForDwm(&consumer, 6);
+    ASSERT_EQ(presents.size(), 6u);
+
+    for (size_t i : { 0, 5, 2 }) {
+        consumer.RemoveLostPresent(presents[i]);
+    }
+    std::vector<PresentEvent*> expected{ presents[1].get(), presents[3].get(), presents[4].get() };
+    EXPECT_EQ(WaitingForDwm(consumer), expected);
+
+    // Adding a present that is already waiting doesn't link it twice.
+    consumer.mPresentsWaitingForDWM.PushBack(presents[3]);
+    EXPECT_EQ(WaitingForDwm(consumer), expected);
+
+    for (size_t i : { 4, 1, 3 }) {
+        consumer.RemoveLostPresent(presents[i]);
+    }
+    EXPECT_TRUE(WaitingForDwm(consumer).empty());
+}
+
+// A displayed present only completes the earlier presents of its own swapchain, looked up through
+// mOrderedPresentsBySwapChain, which follows a swapchain address assigned after the present was
+// created.
+TEST(PresentMonTraceConsumerTests, DisplayedPresentCompletesItsSwapChainOnly)
+{
+    PMTraceConsumer consumer;
+    consumer.mHasCompletedAPresent = true;
+
+    constexpr uint32_t kProcessId = 100;
+    constexpr uint64_t kSwapChainA = 0x10000;
+    constexpr uint64_t kSwapChainB = 0x20000;
+    consumer.RuntimePresentStart(Runtime::DXGI, MakeHeader(kProcessId, 1000, 1000), kSwapChainA, 0, 0);
+    consumer.RuntimePresentStart(Runtime::DXGI, MakeHeader(kProcessId, 1004, 1001), kSwapChainB, 0, 0);
+    auto a1 = consumer.FindPresentByThreadId(1000);
+    auto b1 = consumer.FindPresentByThreadId(1004);
+    ASSERT_NE(a1, nullptr);
+    ASSERT_NE(b1, nullptr);
+
+    // A flip without a runtime present creates a present with no swapchain yet.
+    auto a2 = consumer.HandleDxgkFlip(MakeHeader(kProcessId, 1008, 1002));
+    ASSERT_NE(a2, nullptr);
+    EXPECT_EQ(consumer.mOrderedPresentsBySwapChain.count(std::make_pair(kProcessId, 0ull)), 1u);
+    consumer.SetSwapChainAddress(a2, kSwapChainA);
+    EXPECT_EQ(consumer.mOrderedPresentsBySwapChain.count(std::make_pair(kProcessId, 0ull)), 0u);
+    EXPECT_EQ(consumer.mOrderedPresentsBySwapChain[std::make_pair(kProcessId, kSwapChainA)].size(), 2u);
+
+    a2->FinalState = PresentResult::Presented;
+    consumer.CompletePresent(a2);
+
+    EXPECT_TRUE(a1->IsCompleted);
+    EXPECT_FALSE(b1->IsCompleted);
+    EXPECT_EQ(consumer.mOrderedPresentsBySwapChain.count(std::make_pair(kProcessId, kSwapChainA)), 0u);
+    ASSERT_EQ(consumer.mOrderedPresentsBySwapChain.count(std::make_pair(kProcessId, kSwapChainB)), 1u);
+    EXPECT_EQ(consumer.mOrderedPresentsBySwapChain[std::make_pair(kProcessId, kSwapChainB)].begin()->second, b1);
+}
+
+// A completed present waiting for its FrameId is found by process, either to merge a present with
+// the same FrameId into it, or to end its wait once the process moves on to another FrameId.
+TEST(PresentMonTraceConsumerTests, FrameIdMergeByProcess)
+{
+    PMTraceConsumer consumer;
+    consumer.mHasCompletedAPresent = true;
+
+    auto a1 = MakeFrameIdPresent(100, 1, 1000);
+    auto b7 = MakeFrameIdPresent(104, 7, 1001);
+    consumer.CompletePresent(a1);
+    consumer.CompletePresent(b7);
+    EXPECT_EQ(consumer.mCompletedCount, 2u);
+    EXPECT_EQ(consumer.mCompletedPresentWaitingForFrameIdByProcessId.size(), 2u);
+
+    // Same process and FrameId: merged into the completed present.
+    consumer.CompletePresent(MakeFrameIdPresent(100, 1, 1002));
+    EXPECT_EQ(consumer.mCompletedCount, 2u);
+    EXPECT_EQ(a1->Displayed.size(), 2u);
+    EXPECT_TRUE(a1->WaitingForFrameId);
+
+    // Next FrameId of the process: a1 is done waiting and a2 waits instead.
+    auto a2 = MakeFrameIdPresent(100, 2, 1003);
+    consumer.CompletePresent(a2);
+    EXPECT_EQ(consumer.mCompletedCount, 3u);
+    EXPECT_FALSE(a1->WaitingForFrameId);
+    EXPECT_TRUE(b7->WaitingForFrameId);
+    EXPECT_EQ(consumer.mCompletedPresentWaitingForFrameIdByProcessId[100], a2);
+    EXPECT_EQ(consumer.mCompletedPresentWaitingForFrameIdByProcessId[104], b7);
+    EXPECT_EQ(consumer.mReadyCount, 1u);
+}
+
+// Drives windowed flip presents from 1, 10 and 50 processes through DWM composition and reports
+// the cost per present, which should not grow with the number of presenting processes.
+TEST(PresentMonTraceConsumerTests, DwmCompositionBenchmark)
+{
+    constexpr uint32_t kPresentCount = 500000;
+    constexpr uint32_t kSwapChainsPerProcess = 2;
+
+    for (uint32_t processCount : { 1, 10, 50 }) {
+        PMTraceConsumer consumer;
+        consumer.mHasCompletedAPresent = true;
+        consumer.DwmProcessId = kDwmProcessId;
+        consumer.DwmPresentThreadId = kDwmThreadId;
+
+        std::vector<std::shared_ptr<PresentEvent>> dequeued;
+        uint64_t dequeuedCount = 0;
+        uint64_t timestamp = 1000;
+        uint64_t token = 1;
+        uint32_t submitSequence = 1;
+        auto frameCount = kPresentCount / (processCount * kSwapChainsPerProcess);
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            for (uint32_t i = 0; i < processCount; ++i) {
+                for (uint32_t j = 0; j < kSwapChainsPerProcess; ++j) {
+                    auto hdr = MakeHeader(100 + 4 * i, 1000 + 4 * (i * kSwapChainsPerProcess + j), ++timestamp);
+                    consumer.RuntimePresentStart(Runtime::DXGI, hdr, 0x10000 * (j + 1) + i, 0, 0);
+                    consumer.HandleDxgkPresentHistory(hdr, token, 0, Microsoft_Windows_DxgKrnl::PresentModel::D3DKMT_PM_REDIRECTED_FLIP);
+                    consumer.HandleDxgkPresentHistoryInfo(hdr, token);
+                    consumer.RuntimePresentStop(Runtime::DXGI, hdr, 0);
+                    ++token;
+                }
+            }
+
+            // DWM composes everything waiting for it and flips it to the screen.
+            auto hdr = MakeHeader(kDwmProcessId, kDwmThreadId, ++timestamp);
+            consumer.HandleDxgkFlip(hdr);
+            consumer.HandleDxgkQueueSubmit(hdr, 1, submitSequence,
+                (uint32_t) Microsoft_Windows_DxgKrnl::QueuePacketType::DXGKETW_MMIOFLIP_COMMAND_BUFFER, true, false);
+            consumer.HandleDxgkSyncDPC(++timestamp, submitSequence);
+            ++submitSequence;
+
+            consumer.DequeuePresentEvents(dequeued);
+            dequeuedCount += dequeued.size();
+        }
+        auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        auto presentCount = frameCount * processCount * kSwapChainsPerProcess;
+        EXPECT_EQ(dequeuedCount, presentCount + frameCount);
+        EXPECT_TRUE(consumer.mPresentsWaitingForDWM.empty());
+        EXPECT_TRUE(consumer.mOrderedPresentsBySwapChain.empty());
+        printf("    %2u processes: %u presents in %.3fs (%.1f ns/present)\n",
+            processCount, presentCount, seconds, 1e9 * seconds / presentCount);
+    }
+}
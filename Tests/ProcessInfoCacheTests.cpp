@@ -0,0 +1,308 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <random>
+#include <set>
+#include "PresentMonTests.h"
+#include "../PresentData/ProcessInfoCache.hpp"
+
+namespace {
+
+constexpr uint64_t kFrequency = 10000000;
+
+// Simulates the OS side of ProcessQuery: process ids are reused once a process has exited and all
+// handles to it are closed, and some processes cannot be opened.
+struct FakeProcessQuery : ProcessQuery {
+    struct Process {
+        uint32_t mProcessId;
+        std::wstring mImageName;
+        uint32_t mHandleCount;
+        bool mExited;
+        bool mAccessDenied;
+    };
+
+    std::map<uint32_t, std::unique_ptr<Process>> mProcesses;   // Ids currently in use
+    std::set<uint32_t> mFreeIds;
+    uint32_t mNextId = 4;
+    uint64_t mOpenCount = 0;
+    uint64_t mQueryCount = 0;
+
+    uint32_t Start(std::wstring const& imageName, bool accessDenied = false)
+    {
+        uint32_t processId;
+        if (mFreeIds.empty()) {
+            processId = mNextId;
+            mNextId += 4;
+        } else {
+            processId = *mFreeIds.begin();
+            mFreeIds.erase(mFreeIds.begin());
+        }
+        mProcesses[processId].reset(new Process{ processId, imageName, 0, false, accessDenied });
+        return processId;
+    }
+
+    void Exit(uint32_t processId)
+    {
+        auto process = mProcesses[processId].get();
+        process->mExited = true;
+        Release(process);
+    }
+
+    void Release(Process* process)
+    {
+        if (process->mExited && process->mHandleCount == 0) {
+            mFreeIds.insert(process->mProcessId);
+            mProcesses.erase(process->mProcessId);
+        }
+    }
+
+    std::wstring const* GetImageName(uint32_t processId) const
+    {
+        auto ii = mProcesses.find(processId);
+        return ii == mProcesses.end() || ii->second->mExited ? nullptr : &ii->second->mImageName;
+    }
+
+    void* Open(uint32_t processId) override
+    {
+        mOpenCount += 1;
+        auto ii = mProcesses.find(processId);
+        if (ii == mProcesses.end() || ii->second->mExited || ii->second->mAccessDenied) {
+            return nullptr;
+        }
+        ii->second->mHandleCount += 1;
+        return ii->second.get();
+    }
+
+    bool QueryImageName(void* handle, std::wstring* imageName) override
+    {
+        mQueryCount += 1;
+        *imageName = ((Process*) handle)->mImageName;
+        return true;
+    }
+
+    bool HasExited(void* handle) override
+    {
+        return ((Process*) handle)->mExited;
+    }
+
+    void Close(void* handle) override
+    {
+        auto process = (Process*) handle;
+        process->mHandleCount -= 1;
+        Release(process);
+    }
+};
+
+uint64_t Seconds(double seconds)
+{
+    return uint64_t(seconds * kFrequency);
+}
+
+}
+
+TEST(ProcessInfoCacheTests, StartEventsNeedNoQuery)
+{
+    FakeProcessQuery os;
+    ProcessInfoCache cache(&os, kFrequency);
+
+    auto processId = os.Start(L"game.exe");
+    cache.OnProcessStart(processId, Seconds(1), L"game.exe");
+    for (uint32_t i = 0; i < 100; ++i) {
+        auto imageName = cache.Lookup(processId, Seconds(1) + i);
+        ASSERT_NE(imageName, nullptr);
+        EXPECT_EQ(*imageName, L"game.exe");
+    }
+    EXPECT_EQ(os.mOpenCount, 0u);
+    EXPECT_EQ(cache.GetOpenCount(), 0u);
+}
+
+TEST(ProcessInfoCacheTests, QueriesOnce)
+{
+    FakeProcessQuery os;
+    ProcessInfoCache cache(&os, kFrequency);
+
+    auto processId = os.Start(L"game.exe");
+    for (uint32_t i = 0; i < 100; ++i) {
+        auto imageName = cache.Lookup(processId, Seconds(1) + i);
+        ASSERT_NE(imageName, nullptr);
+        EXPECT_EQ(*imageName, L"game.exe");
+    }
+    EXPECT_EQ(os.mOpenCount, 1u);
+    EXPECT_EQ(cache.GetOpenCount(), 1u);
+
+    cache.Clear();
+    EXPECT_EQ(os.mProcesses[processId]->mHandleCount, 0u);
+}
+
+TEST(ProcessInfoCacheTests, UnknownRetriedAfterExpiry)
+{
+    FakeProcessQuery os;
+    ProcessInfoCache cache(&os, kFrequency);
+
+    auto processId = os.Start(L"service.exe", true);
+    EXPECT_EQ(cache.Lookup(processId, Seconds(1)), nullptr);
+    EXPECT_EQ(cache.Lookup(processId, Seconds(1.5)), nullptr);
+    EXPECT_EQ(os.mOpenCount, 1u);
+
+    // Access is granted later, e.g. the process dropped its integrity level.
+    os.mProcesses[processId]->mAccessDenied = false;
+    auto imageName = cache.Lookup(processId, Seconds(2.5));
+    ASSERT_NE(imageName, nullptr);
+    EXPECT_EQ(*imageName, L"service.exe");
+    EXPECT_EQ(os.mOpenCount, 2u);
+}
+
+TEST(ProcessInfoCacheTests, ReusedIdAfterStopEvent)
+{
+    FakeProcessQuery os;
+    ProcessInfoCache cache(&os, kFrequency);
+
+    auto first = os.Start(L"first.exe");
+    cache.OnProcessStart(first, Seconds(1), L"first.exe");
+    os.Exit(first);
+    cache.OnProcessStop(first, Seconds(2));
+
+    auto second = os.Start(L"second.exe");
+    ASSERT_EQ(first, second);
+    cache.OnProcessStart(second, Seconds(3), L"second.exe");
+
+    // A present that started before the stop is processed after the id was reused.
+    auto imageName = cache.Lookup(first, Seconds(1.5));
+    ASSERT_NE(imageName, nullptr);
+    EXPECT_EQ(*imageName, L"first.exe");
+
+    imageName = cache.Lookup(second, Seconds(3.5));
+    ASSERT_NE(imageName, nullptr);
+    EXPECT_EQ(*imageName, L"second.exe");
+
+    // Between the two processes.
+    EXPECT_EQ(cache.Lookup(first, Seconds(2.5)), nullptr);
+    EXPECT_EQ(os.mOpenCount, 0u);
+}
+
+TEST(ProcessInfoCacheTests, ExitWithoutStopEvent)
+{
+    FakeProcessQuery os;
+    ProcessInfoCache cache(&os, kFrequency);
+
+    auto first = os.Start(L"first.exe");
+    ASSERT_NE(cache.Lookup(first, Seconds(1)), nullptr);
+
+    // The handle held by the cache keeps the id from being reused.
+    os.Exit(first);
+    EXPECT_NE(os.Start(L"other.exe"), first);
+
+    std::vector<uint32_t> exited;
+    cache.CollectExited(Seconds(2), &exited);
+    ASSERT_EQ(exited.size(), 1u);
+    EXPECT_EQ(exited[0], first);
+    EXPECT_EQ(cache.GetOpenCount(), 0u);
+
+    auto second = os.Start(L"second.exe");
+    ASSERT_EQ(first, second);
+    auto imageName = cache.Lookup(second, Seconds(3));
+    ASSERT_NE(imageName, nullptr);
+    EXPECT_EQ(*imageName, L"second.exe");
+
+    imageName = cache.Lookup(first, Seconds(1.5));
+    ASSERT_NE(imageName, nullptr);
+    EXPECT_EQ(*imageName, L"first.exe");
+}
+
+TEST(ProcessInfoCacheTests, NoQueryWithoutProcessQuery)
+{
+    ProcessInfoCache cache(nullptr, kFrequency);
+    cache.OnProcessStart(8, Seconds(1), L"game.exe");
+    ASSERT_NE(cache.Lookup(8, Seconds(2)), nullptr);
+    EXPECT_EQ(cache.Lookup(12, Seconds(2)), nullptr);
+
+    std::vector<uint32_t> exited;
+    cache.CollectExited(Seconds(3), &exited);
+    EXPECT_TRUE(exited.empty());
+}
+
+// Short-lived processes started at 10k/s, each presenting a few times, with the start and stop
+// events of some of them missing (as if they started before the trace session).
+TEST(ProcessInfoCacheTests, ProcessChurn)
+{
+    constexpr uint32_t kProcessCount = 200000;
+    constexpr uint32_t kPresentCount = 8;
+    const uint64_t kStartPeriod = Seconds(1. / 10000);
+    const uint64_t kLifetime = Seconds(0.05);
+
+    FakeProcessQuery os;
+    ProcessInfoCache cache(&os, kFrequency);
+    std::mt19937 rng(1);
+
+    struct Running {
+        uint32_t mProcessId;
+        uint64_t mStopTime;
+        bool mStopEvent;
+        std::wstring mImageName;
+    };
+    std::deque<Running> running;
+    std::vector<uint32_t> exited;
+
+    uint64_t lookupCount = 0;
+    uint64_t unknownCount = 0;
+    size_t maxEntryCount = 0;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < kProcessCount; ++i) {
+        auto timestamp = Seconds(1) + i * kStartPeriod;
+
+        while (!running.empty() && running.front().mStopTime < timestamp) {
+            auto const& process = running.front();
+            os.Exit(process.mProcessId);
+            if (process.mStopEvent) {
+                cache.OnProcessStop(process.mProcessId, process.mStopTime);
+            }
+            running.pop_front();
+        }
+        if (i % 1000 == 0) {
+            // The exits found now happened before the processes that start now.
+            exited.clear();
+            cache.CollectExited(timestamp - 1, &exited);
+        }
+
+        auto imageName = L"process" + std::to_wstring(i) + L".exe";
+        auto startEvent = rng() % 4 != 0;
+        auto processId = os.Start(imageName, rng() % 16 == 0);
+        if (startEvent) {
+            cache.OnProcessStart(processId, timestamp, imageName);
+        }
+        running.push_back({ processId, timestamp + kLifetime, startEvent, imageName });
+
+        // Present from a random running process.
+        for (uint32_t j = 0; j < kPresentCount; ++j) {
+            auto const& process = running[rng() % running.size()];
+            auto expected = os.GetImageName(process.mProcessId);
+            ASSERT_NE(expected, nullptr);
+            auto actual = cache.Lookup(process.mProcessId, timestamp);
+            lookupCount += 1;
+            if (actual == nullptr) {
+                unknownCount += 1;
+            } else {
+                ASSERT_EQ(*actual, *expected);
+            }
+        }
+        maxEntryCount = std::max(maxEntryCount, cache.GetEntryCount());
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    double seconds = std::chrono::duration<double>(t1 - t0).count();
+
+    // Each process is opened at most once while it is known, plus the retries of the ones that
+    // deny access.
+    EXPECT_LT(os.mOpenCount, kProcessCount / 2);
+    EXPECT_LE(os.mQueryCount, os.mOpenCount);
+    EXPECT_LT(unknownCount, lookupCount / 8);
+    // Stopped entries are only kept for kStoppedSeconds plus the pruning period.
+    EXPECT_LT(maxEntryCount, size_t(10000 * 2 * ProcessInfoCache::kStoppedSeconds + 1000));
+
+    printf("    %u processes, %llu lookups (%llu unknown), %llu opens, %zu max entries in %.3fs (%.1f ns/lookup)\n",
+        kProcessCount, (unsigned long long) lookupCount, (unsigned long long) unknownCount,
+        (unsigned long long) os.mOpenCount, maxEntryCount, seconds, seconds * 1e9 / lookupCount);
+}
@@ -0,0 +1,54 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "../../PresentMon/ColumnarFile.hpp"
+
+#include <stdio.h>
+
+namespace {
+
+void usage()
+{
+    fprintf(stderr,
+        "Convert a PresentMon columnar capture (--output_format columnar) into a CSV file.\n"
+        "usage: pm_columnar_to_csv.exe path_to_input.pmcol [path_to_output.csv]\n"
+        "       If no output path is provided, the CSV is written to STDOUT.\n");
+}
+
+}
+
+int wmain(
+    int argc,
+    wchar_t** argv)
+{
+    if (argc != 2 && argc != 3) {
+        usage();
+        return 1;
+    }
+
+    ColumnarReader reader;
+    if (!reader.Open(argv[1])) {
+        fprintf(stderr, "error: failed to open input file: %ls\n", argv[1]);
+        usage();
+        return 2;
+    }
+
+    FILE* fp = stdout;
+    if (argc == 3 && _wfopen_s(&fp, argv[2], L"w,ccs=UTF-8")) {
+        fprintf(stderr, "error: failed to open output file: %ls\n", argv[2]);
+        return 2;
+    }
+
+    auto rowCount = WriteColumnarAsCsv(&reader, fp);
+
+    if (fp != stdout) {
+        fclose(fp);
+    }
+
+    if (rowCount < 0) {
+        fprintf(stderr, "error: input file is corrupt or truncated: %ls\n", argv[1]);
+        return 3;
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Copyright (C) 2017-2024 Intel Corporation
+// SPDX-License-Identifier: MIT
+
+#include "../../Tests/CsvCompare.h"
+
+#include <stdio.h>
+#include <wchar.h>
+
+namespace {
+
+void usage()
+{
+    fprintf(stderr,
+        "Compare a PresentMon CSV file against an expected (gold) CSV file.\n"
+        "usage: pm_compare_csv.exe [options] path_to_test.csv path_to_gold.csv\n"
+        "options:\n"
+        "    --threads=N     Number of threads to compare with (default: one per hardware thread).\n"
+        "    --max_diffs=N   Number of differences to print per column (default: 5).\n"
+        "    --all_diffs     Print all differences.\n"
+        "Returns 0 if the files match, 1 if they differ, and 2 on error.\n");
+}
+
+bool ParseNumber(wchar_t const* arg, size_t prefixLength, size_t* value)
+{
+    wchar_t* end = nullptr;
+    *value = (size_t) wcstoull(arg + prefixLength, &end, 10);
+    return end != arg + prefixLength && *end == L'\0';
+}
+
+}
+
+int wmain(
+    int argc,
+    wchar_t** argv)
+{
+    CsvCompareOptions options;
+    wchar_t const* paths[2] = {};
+    uint32_t pathCount = 0;
+    for (int i = 1; i < argc; ++i) {
+        size_t value = 0;
+        if (_wcsnicmp(argv[i], L"--threads=", 10) == 0 && ParseNumber(argv[i], 10, &value)) {
+            options.mThreadCount = (uint32_t) value;
+        } else if (_wcsnicmp(argv[i], L"--max_diffs=", 12) == 0 && ParseNumber(argv[i], 12, &value)) {
+            options.mMaxDiffsPerColumn = value;
+        } else if (_wcsicmp(argv[i], L"--all_diffs") == 0) {
+            options.mMaxDiffsPerColumn = SIZE_MAX;
+        } else if (argv[i][0] != L'-' && pathCount < 2) {
+            paths[pathCount++] = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+
+    if (pathCount != 2) {
+        usage();
+        return 2;
+    }
+
+    CsvCompareReport report;
+    if (!CompareCsvFiles(paths[0], paths[1], options, &report)) {
+        fprintf(stderr, "error: failed to open input files: %ls, %ls\n", paths[0], paths[1]);
+        return 2;
+    }
+
+    printf("TEST = %ls\n", paths[0]);
+    printf("GOLD = %ls\n", paths[1]);
+    PrintCsvCompareReport(stdout, report);
+    printf("%s: %zu rows compared in %.3fs\n",
+        report.HasDifferences() ? "DIFFERENT" : "MATCH",
+        report.mTestRowCount < report.mGoldRowCount ? report.mTestRowCount : report.mGoldRowCount,
+        report.mSeconds);
+
+    return report.HasDifferences() ? 1 : 0;
+}
@@ -2,12 +2,13 @@
 // SPDX-License-Identifier: MIT
 
 #include <array>
-#include <fstream>
 #include <stdio.h>
 #include <string>
-#include <sstream>
+#include <string_view>
 #include <unordered_map>
 
+#include "../../Tests/CsvReader.h"
+
 namespace {
 
 enum Columns {
@@ -44,18 +45,20 @@ struct Options {
     bool mQpcTime;
 };
 
+// String members reference the mapped input file, so are only valid while the
+// CsvReader is open.
 struct PresentEvent {
-    std::wstring Application;
+    std::string_view Application;
     uint32_t     ProcessID;
     uint64_t     SwapChainAddress;
-    std::wstring Runtime;
-    uint32_t     SyncInterval;
+    std::string_view Runtime;
+    int32_t      SyncInterval;
     uint32_t     PresentFlags;
     bool         Dropped;
     double       TimeInSeconds;
     double       msInPresentAPI;
     bool         AllowsTearing;
-    std::wstring PresentMode;
+    std::string_view PresentMode;
     double       msUntilRenderComplete;
     double       msUntilDisplayed;
     double       msBetweenDisplayChange;
@@ -191,15 +194,15 @@ void ReportMetrics(Options const& opts, SwapChainData* chain, PresentEvent const
         metrics_mVideoBusy   = 0.0;
     }
 
-    printf("%ls,%d,0x%016llX,%ls,%d,%d", p.Application.c_str(),
-                                         p.ProcessID,
-                                         p.SwapChainAddress,
-                                         p.Runtime.c_str(),
-                                         p.SyncInterval,
-                                         p.PresentFlags);
+    printf("%.*s,%d,0x%016llX,%.*s,%d,%d", (int) p.Application.size(), p.Application.data(),
+                                           p.ProcessID,
+                                           p.SwapChainAddress,
+                                           (int) p.Runtime.size(), p.Runtime.data(),
+                                           p.SyncInterval,
+                                           p.PresentFlags);
     if (opts.mTrackDisplay) {
-        printf(",%d,%ls", p.AllowsTearing ? 1 : 0,
-                          p.PresentMode.c_str());
+        printf(",%d,%.*s", p.AllowsTearing ? 1 : 0,
+                           (int) p.PresentMode.size(), p.PresentMode.data());
     }
     if (chain->mNextCPUFrameTimeIsValid) {
         if (opts.mQpcTime) {
@@ -263,8 +266,8 @@ int wmain(
         return 1;
     }
 
-    std::wifstream file(argv[1]);
-    if (!file.is_open()) {
+    CsvReader file;
+    if (!file.Open(argv[1])) {
         fprintf(stderr, "error: failed to open input file: %ls\n", argv[1]);
         usage();
         return 2;
@@ -272,45 +275,39 @@ int wmain(
 
     SwapChains swapChains;
 
-    std::wstring line;
-    if (std::getline(file, line)) {
-        std::wstringstream ss(line);
-
-        if (line.size() >= 3 && line[0] == 0xef && line[1] == 0xbb && line[2] == 0xbf) {
-            ss.seekg(3);
-        }
-
+    std::vector<std::string_view> row;
+    if (file.ReadRow(&row)) {
         uint32_t columnIndex[NumColumns];
         for (uint32_t i = 0; i < NumColumns; ++i) {
             columnIndex[i] = UINT32_MAX;
         }
 
-        std::wstring word;
-        for (uint32_t i = 0; std::getline(ss, word, L','); ++i) {
-                 if (word == L"Application")           columnIndex[Application]            = i;
-            else if (word == L"ProcessID")             columnIndex[ProcessID]              = i;
-            else if (word == L"SwapChainAddress")      columnIndex[SwapChainAddress]       = i;
-            else if (word == L"Runtime")               columnIndex[Runtime]                = i;
-            else if (word == L"SyncInterval")          columnIndex[SyncInterval]           = i;
-            else if (word == L"PresentFlags")          columnIndex[PresentFlags]           = i;
-            else if (word == L"Dropped")               columnIndex[Dropped]                = i;
-            else if (word == L"TimeInSeconds")         columnIndex[TimeInSeconds]          = i;
-            else if (word == L"msInPresentAPI")        columnIndex[msInPresentAPI]         = i;
-            else if (word == L"msBetweenPresents")     columnIndex[msBetweenPresents]      = i;
-            else if (word == L"AllowsTearing")         columnIndex[AllowsTearing]          = i;
-            else if (word == L"PresentMode")           columnIndex[PresentMode]            = i;
-            else if (word == L"msUntilRenderComplete") columnIndex[msUntilRenderComplete]  = i;
-            else if (word == L"msUntilDisplayed")      columnIndex[msUntilDisplayed]       = i;
-            else if (word == L"msBetweenDisplayChange")columnIndex[msBetweenDisplayChange] = i;
-            else if (word == L"msUntilRenderStart")    columnIndex[msUntilRenderStart]     = i;
-            else if (word == L"msGPUActive")           columnIndex[msGPUActive]            = i;
-            else if (word == L"msGPUVideoActive")      columnIndex[msGPUVideoActive]       = i;
-            else if (word == L"msSinceInput")          columnIndex[msSinceInput]           = i;
-            else if (word == L"QPCTime")               columnIndex[QPCTime]                = i;
-            else if (word == L"WasBatched")            columnIndex[WasBatched]             = i;
-            else if (word == L"DwmNotified")           columnIndex[DwmNotified]            = i;
+        for (uint32_t i = 0, n = (uint32_t) row.size(); i < n; ++i) {
+            auto word = row[i];
+                 if (word == "Application")           columnIndex[Application]            = i;
+            else if (word == "ProcessID")             columnIndex[ProcessID]              = i;
+            else if (word == "SwapChainAddress")      columnIndex[SwapChainAddress]       = i;
+            else if (word == "Runtime")               columnIndex[Runtime]                = i;
+            else if (word == "SyncInterval")          columnIndex[SyncInterval]           = i;
+            else if (word == "PresentFlags")          columnIndex[PresentFlags]           = i;
+            else if (word == "Dropped")               columnIndex[Dropped]                = i;
+            else if (word == "TimeInSeconds")         columnIndex[TimeInSeconds]          = i;
+            else if (word == "msInPresentAPI")        columnIndex[msInPresentAPI]         = i;
+            else if (word == "msBetweenPresents")     columnIndex[msBetweenPresents]      = i;
+            else if (word == "AllowsTearing")         columnIndex[AllowsTearing]          = i;
+            else if (word == "PresentMode")           columnIndex[PresentMode]            = i;
+            else if (word == "msUntilRenderComplete") columnIndex[msUntilRenderComplete]  = i;
+            else if (word == "msUntilDisplayed")      columnIndex[msUntilDisplayed]       = i;
+            else if (word == "msBetweenDisplayChange")columnIndex[msBetweenDisplayChange] = i;
+            else if (word == "msUntilRenderStart")    columnIndex[msUntilRenderStart]     = i;
+            else if (word == "msGPUActive")           columnIndex[msGPUActive]            = i;
+            else if (word == "msGPUVideoActive")      columnIndex[msGPUVideoActive]       = i;
+            else if (word == "msSinceInput")          columnIndex[msSinceInput]           = i;
+            else if (word == "QPCTime")               columnIndex[QPCTime]                = i;
+            else if (word == "WasBatched")            columnIndex[WasBatched]             = i;
+            else if (word == "DwmNotified")           columnIndex[DwmNotified]            = i;
             else {
-                fprintf(stderr, "error: unrecognised column: %ls\n", word.c_str());
+                fprintf(stderr, "error: unrecognised column: %.*s\n", (int) word.size(), word.data());
                 return 3;
             }
         }
@@ -341,48 +338,51 @@ int wmain(
         opts.mTrackInput    = columnIndex[msSinceInput]           != UINT32_MAX;
         opts.mQpcTime       = columnIndex[QPCTime]                != UINT32_MAX;
 
-        std::wstring row[NumColumns];
+        auto headerColumnCount = row.size();
+
         bool firstRow = true;
-        while (std::getline(file, line)) {
-            ss.str(line);
-            ss.clear();
-            for (size_t i = 0; std::getline(ss, word, L','); ++i) {
-                row[i] = word;
+        while (file.ReadRow(&row)) {
+            if (row.size() < headerColumnCount) {
+                fprintf(stderr, "error: missing columns on line %zu.\n", file.GetLine());
+                return 5;
             }
 
             PresentEvent p;
-            p.Application                 =             row[columnIndex[Application]];
-            p.ProcessID                   = std::stoul (row[columnIndex[ProcessID]]);
-            p.SwapChainAddress            = std::stoull(row[columnIndex[SwapChainAddress]], nullptr, 16);
-            p.Runtime                     =             row[columnIndex[Runtime]];
-            p.SyncInterval                = std::stol  (row[columnIndex[SyncInterval]]);
-            p.PresentFlags                = std::stoul (row[columnIndex[PresentFlags]]);
-            p.Dropped                     =             row[columnIndex[Dropped]] == L"1";
-            p.TimeInSeconds               = std::stod  (row[columnIndex[TimeInSeconds]]);
-            p.msInPresentAPI              = std::stod  (row[columnIndex[msInPresentAPI]]);
+            bool ok = true;
+            p.Application                 =                   row[columnIndex[Application]];
+            ok &= ParseCsvNumber(row[columnIndex[ProcessID]],              &p.ProcessID);
+            ok &= ParseCsvNumber(row[columnIndex[SwapChainAddress]],       &p.SwapChainAddress);
+            p.Runtime                     =                   row[columnIndex[Runtime]];
+            ok &= ParseCsvNumber(row[columnIndex[SyncInterval]],           &p.SyncInterval);
+            ok &= ParseCsvNumber(row[columnIndex[PresentFlags]],           &p.PresentFlags);
+            p.Dropped                     =                   row[columnIndex[Dropped]] == "1";
+            ok &= ParseCsvNumber(row[columnIndex[TimeInSeconds]],          &p.TimeInSeconds);
+            ok &= ParseCsvNumber(row[columnIndex[msInPresentAPI]],         &p.msInPresentAPI);
             if (opts.mTrackDisplay) {
-                p.AllowsTearing           =             row[columnIndex[AllowsTearing]] == L"1";
-                p.PresentMode             =             row[columnIndex[PresentMode]];
-                p.msUntilRenderComplete   = std::stod  (row[columnIndex[msUntilRenderComplete]]);
-                p.msUntilDisplayed        = std::stod  (row[columnIndex[msUntilDisplayed]]);
-                p.msBetweenDisplayChange  = std::stod  (row[columnIndex[msBetweenDisplayChange]]);
+                p.AllowsTearing           =                   row[columnIndex[AllowsTearing]] == "1";
+                p.PresentMode             =                   row[columnIndex[PresentMode]];
+                ok &= ParseCsvNumber(row[columnIndex[msUntilRenderComplete]],  &p.msUntilRenderComplete);
+                ok &= ParseCsvNumber(row[columnIndex[msUntilDisplayed]],       &p.msUntilDisplayed);
+                ok &= ParseCsvNumber(row[columnIndex[msBetweenDisplayChange]], &p.msBetweenDisplayChange);
             }
             if (opts.mTrackGPU) {
-                p.msUntilRenderStart      = std::stod  (row[columnIndex[msUntilRenderStart]]);
-                p.msGPUActive             = std::stod  (row[columnIndex[msGPUActive]]);
+                ok &= ParseCsvNumber(row[columnIndex[msUntilRenderStart]],     &p.msUntilRenderStart);
+                ok &= ParseCsvNumber(row[columnIndex[msGPUActive]],            &p.msGPUActive);
             }
             if (opts.mTrackGPUVideo) {
-                p.msGPUVideoActive        = std::stod  (row[columnIndex[msGPUVideoActive]]);
+                ok &= ParseCsvNumber(row[columnIndex[msGPUVideoActive]],       &p.msGPUVideoActive);
             }
             if (opts.mTrackInput) {
-                p.msSinceInput            = std::stod  (row[columnIndex[msSinceInput]]);
+                ok &= ParseCsvNumber(row[columnIndex[msSinceInput]],           &p.msSinceInput);
+            }
+            if (!ok) {
+                fprintf(stderr, "error: invalid value on line %zu.\n", file.GetLine());
+                return 5;
             }
 
             if (opts.mQpcTime) {
-                auto const& qpcTime = row[columnIndex[QPCTime]];
-                if (qpcTime.find('.') == std::string::npos) {
-                    p.QPCTime = std::stoull(qpcTime);
-                } else {
+                auto qpcTime = row[columnIndex[QPCTime]];
+                if (qpcTime.find('.') != std::string_view::npos || !ParseCsvNumber(qpcTime, &p.QPCTime)) {
                     opts.mQpcTime = false;
                 }
             }
@@ -410,6 +410,6 @@ int wmain(
         }
     }
 
-    file.close();
+    file.Close();
     return 0;
 }